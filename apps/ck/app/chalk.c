@@ -57,6 +57,10 @@ Module Name:
     "  --debug-gc -- Stress the garbage collector.\n"                          \
     "  --debug-compiler -- Print the compiled bytecode.\n"                     \
     "  --help -- Show this help text and exit.\n"                              \
+    "  --profile=file -- Sample the call stack periodically and write the \n"  \
+    "      stacks to the given file in the folded flame graph format.\n"       \
+    "  --profile-counts=file -- Count calls to and time spent in each \n"      \
+    "      function, and write the counts to the given file.\n"                \
     "  --version -- Print the application version information and exit.\n"
 
 #define CHALK_OPTIONS_STRING "+c:chV"
@@ -65,6 +69,8 @@ Module Name:
 
 #define CHALK_OPTION_DEBUG_GC 257
 #define CHALK_OPTION_DEBUG_COMPILER 258
+#define CHALK_OPTION_PROFILE 259
+#define CHALK_OPTION_PROFILE_COUNTS 260
 
 //
 // ------------------------------------------------------ Data Type Definitions
@@ -131,6 +137,29 @@ ChalkReadLine (
     PCK_APP_CONTEXT Context
     );
 
+VOID
+ChalkWriteProfile (
+    PCK_VM Vm,
+    ULONG Flags,
+    PCSTR Path
+    );
+
+VOID
+ChalkProfileWrite (
+    PCK_VM Vm,
+    PCSTR String
+    );
+
+BOOL
+ChalkStartProfileTimer (
+    PCK_VM Vm
+    );
+
+VOID
+ChalkStopProfileTimer (
+    VOID
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -139,10 +168,18 @@ struct option ChalkLongOptions[] = {
     {"debug-gc", no_argument, 0, CHALK_OPTION_DEBUG_GC},
     {"debug-compiler", no_argument, 0, CHALK_OPTION_DEBUG_COMPILER},
     {"help", no_argument, 0, 'h'},
+    {"profile", required_argument, 0, CHALK_OPTION_PROFILE},
+    {"profile-counts", required_argument, 0, CHALK_OPTION_PROFILE_COUNTS},
     {"verbose", no_argument, 0, 'v'},
     {NULL, 0, 0, 0},
 };
 
+//
+// Store the file the profile is currently being written to.
+//
+
+FILE *ChalkProfileFile;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -183,6 +220,10 @@ Return Value:
     PSTR FileBuffer;
     UINTN FileSize;
     INT Option;
+    PCSTR ProfileCountsPath;
+    ULONG ProfileFlags;
+    PCSTR ProfilePath;
+    BOOL ProfileTimer;
     PSTR ScriptPath;
     int Status;
 
@@ -190,6 +231,10 @@ Return Value:
     AppIsBundle = FALSE;
     Expression = NULL;
     FileBuffer = NULL;
+    ProfileCountsPath = NULL;
+    ProfileFlags = 0;
+    ProfilePath = NULL;
+    ProfileTimer = FALSE;
     ScriptPath = NULL;
     Status = ChalkInitializeContext(&Context);
     if (Status != 0) {
@@ -260,6 +305,16 @@ Return Value:
                 Context.Configuration.Flags |= CK_CONFIGURATION_DEBUG_COMPILER;
                 break;
 
+            case CHALK_OPTION_PROFILE:
+                ProfilePath = optarg;
+                ProfileFlags |= CK_PROFILE_SAMPLE;
+                break;
+
+            case CHALK_OPTION_PROFILE_COUNTS:
+                ProfileCountsPath = optarg;
+                ProfileFlags |= CK_PROFILE_COUNT;
+                break;
+
             case 'V':
                 printf("Chalk version %d.%d.%d. Copyright 2017 Minoca Corp. "
                        "All Rights Reserved.\n",
@@ -305,6 +360,22 @@ Return Value:
         goto MainEnd;
     }
 
+    if (ProfileFlags != 0) {
+        if (!CkStartProfiler(Context.Vm, ProfileFlags)) {
+            fprintf(stderr, "Error: Failed to start the profiler.\n");
+            Status = 2;
+            goto MainEnd;
+        }
+
+        if ((ProfileFlags & CK_PROFILE_SAMPLE) != 0) {
+            ProfileTimer = ChalkStartProfileTimer(Context.Vm);
+            if (ProfileTimer == FALSE) {
+                fprintf(stderr,
+                        "Warning: Failed to start the profile timer.\n");
+            }
+        }
+    }
+
     //
     // Set up the module search path. Two stack slots are needed: one for the
     // module search list, and one for a new string being appended.
@@ -380,6 +451,22 @@ Return Value:
     }
 
 MainEnd:
+    if (ProfileTimer != FALSE) {
+        ChalkStopProfileTimer();
+    }
+
+    if ((Context.Vm != NULL) && (ProfileFlags != 0)) {
+        if (ProfilePath != NULL) {
+            ChalkWriteProfile(Context.Vm, CK_PROFILE_SAMPLE, ProfilePath);
+        }
+
+        if (ProfileCountsPath != NULL) {
+            ChalkWriteProfile(Context.Vm, CK_PROFILE_COUNT, ProfileCountsPath);
+        }
+
+        CkStopProfiler(Context.Vm);
+    }
+
     ChalkDestroyContext(&Context);
     if (FileBuffer != NULL) {
         free(FileBuffer);
@@ -523,6 +610,88 @@ Return Value:
     return;
 }
 
+VOID
+ChalkWriteProfile (
+    PCK_VM Vm,
+    ULONG Flags,
+    PCSTR Path
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes part of the collected profile out to a file.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Flags - Supplies the CK_PROFILE_* flag indicating which part of the
+        profile to write.
+
+    Path - Supplies the path of the file to write.
+
+Return Value:
+
+    None. Errors are printed to standard error.
+
+--*/
+
+{
+
+    ChalkProfileFile = fopen(Path, "w");
+    if (ChalkProfileFile == NULL) {
+        fprintf(stderr,
+                "Error: Failed to open profile %s: %s\n",
+                Path,
+                strerror(errno));
+
+        return;
+    }
+
+    CkWriteProfile(Vm, Flags, ChalkProfileWrite);
+    if (fclose(ChalkProfileFile) != 0) {
+        fprintf(stderr,
+                "Error: Failed to write profile %s: %s\n",
+                Path,
+                strerror(errno));
+    }
+
+    ChalkProfileFile = NULL;
+    return;
+}
+
+VOID
+ChalkProfileWrite (
+    PCK_VM Vm,
+    PCSTR String
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes a piece of the profile to the current profile file.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    String - Supplies the string to write.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    fputs(String, ChalkProfileFile);
+    return;
+}
+
 PSTR
 ChalkLoadFile (
     PSTR FileName,
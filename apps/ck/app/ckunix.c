@@ -31,9 +31,11 @@ Module Name:
 
 #include <assert.h>
 #include <libgen.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 #include <minoca/lib/types.h>
@@ -47,6 +49,12 @@ Module Name:
 #define CK_APP_PREFIX "/usr"
 #define CK_APP_LIBDIR CK_APP_PREFIX "/lib"
 
+//
+// Define the profiler sampling interval, in microseconds of CPU time.
+//
+
+#define CK_APP_PROFILE_INTERVAL 1000
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -62,10 +70,21 @@ ChalkAddSearchPath (
     PSTR ChalkDirectory
     );
 
+void
+ChalkProfileSignalHandler (
+    int Signal
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
+//
+// Store the VM being ticked by the profile timer.
+//
+
+PCK_VM ChalkProfiledVm;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -204,7 +223,127 @@ Return Value:
     return;
 }
 
+BOOL
+ChalkStartProfileTimer (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts the periodic timer that ticks the profiler. It uses
+    the process CPU time profiling timer, so time spent blocked is not
+    sampled.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine being profiled.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    struct sigaction Action;
+    struct itimerval Timer;
+
+    ChalkProfiledVm = Vm;
+    memset(&Action, 0, sizeof(Action));
+    Action.sa_handler = ChalkProfileSignalHandler;
+    Action.sa_flags = SA_RESTART;
+    sigemptyset(&(Action.sa_mask));
+    if (sigaction(SIGPROF, &Action, NULL) != 0) {
+        return FALSE;
+    }
+
+    Timer.it_interval.tv_sec = 0;
+    Timer.it_interval.tv_usec = CK_APP_PROFILE_INTERVAL;
+    Timer.it_value = Timer.it_interval;
+    if (setitimer(ITIMER_PROF, &Timer, NULL) != 0) {
+        signal(SIGPROF, SIG_DFL);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+VOID
+ChalkStopProfileTimer (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stops the profile timer.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    struct itimerval Timer;
+
+    memset(&Timer, 0, sizeof(Timer));
+    setitimer(ITIMER_PROF, &Timer, NULL);
+
+    //
+    // Ignore a signal that may already be on its way.
+    //
+
+    signal(SIGPROF, SIG_IGN);
+    ChalkProfiledVm = NULL;
+    return;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+void
+ChalkProfileSignalHandler (
+    int Signal
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when the profile timer fires.
+
+Arguments:
+
+    Signal - Supplies the signal number.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_VM Vm;
+
+    Vm = ChalkProfiledVm;
+    if (Vm != NULL) {
+        CkProfilerTick(Vm);
+    }
+
+    return;
+}
+
@@ -39,10 +39,19 @@ Module Name:
 #include <libgen.h>
 #include <stdio.h>
 
+#include <minoca/lib/types.h>
+#include <minoca/lib/chalk.h>
+
 //
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the profiler sampling interval, in milliseconds.
+//
+
+#define CK_APP_PROFILE_INTERVAL 1
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -58,12 +67,25 @@ ChalkAddSearchPath (
     PSTR ChalkDirectory
     );
 
+VOID
+CALLBACK
+ChalkProfileTimerRoutine (
+    PVOID Parameter,
+    BOOLEAN TimerFired
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
 extern PSTR CkAppExecName;
 
+//
+// Store the handle of the timer ticking the profiler.
+//
+
+HANDLE ChalkProfileTimer;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -225,7 +247,114 @@ Return Value:
     return;
 }
 
+BOOL
+ChalkStartProfileTimer (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts the periodic timer that ticks the profiler. Windows
+    has no CPU time profiling timer, so this ticks on wall clock time from a
+    thread pool timer.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine being profiled.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    BOOL Result;
+
+    Result = CreateTimerQueueTimer(&ChalkProfileTimer,
+                                   NULL,
+                                   ChalkProfileTimerRoutine,
+                                   Vm,
+                                   CK_APP_PROFILE_INTERVAL,
+                                   CK_APP_PROFILE_INTERVAL,
+                                   WT_EXECUTEINTIMERTHREAD);
+
+    if (Result == FALSE) {
+        ChalkProfileTimer = NULL;
+    }
+
+    return Result;
+}
+
+VOID
+ChalkStopProfileTimer (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stops the profile timer, waiting for any callback in
+    progress to finish.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (ChalkProfileTimer != NULL) {
+        DeleteTimerQueueTimer(NULL, ChalkProfileTimer, INVALID_HANDLE_VALUE);
+        ChalkProfileTimer = NULL;
+    }
+
+    return;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+VOID
+CALLBACK
+ChalkProfileTimerRoutine (
+    PVOID Parameter,
+    BOOLEAN TimerFired
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when the profile timer fires.
+
+Arguments:
+
+    Parameter - Supplies the virtual machine being profiled.
+
+    TimerFired - Supplies a boolean that is always TRUE for timers.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    CkProfilerTick(Parameter);
+    return;
+}
+
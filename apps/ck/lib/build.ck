@@ -71,6 +71,7 @@ function build() {
         "lex.c",
         "list.c",
         "module.c",
+        "profile.c",
         "string.c",
         "utils.c",
         "value.c",
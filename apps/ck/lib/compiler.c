@@ -328,6 +328,7 @@ Return Value:
 
     CK_COMPILER Compiler;
     CK_ERROR_TYPE Error;
+    PCK_FUNCTION Function;
     CK_PARSER Parser;
     PCK_SYMBOL_UNION TranslationUnit;
     YY_STATUS YyStatus;
@@ -341,7 +342,7 @@ Return Value:
         Parser.PrintErrors = TRUE;
     }
 
-    CkpInitializeLexer(&(Parser.Lexer), Source, Length, Line);
+    CkpInitializeLexer(Vm, &(Parser.Lexer), Source, Length, Line);
     Parser.Parser.Grammar = &CkGrammar;
     Parser.Parser.Reallocate = CkpCompilerReallocate;
     Parser.Parser.Callback = CkpParserCallback;
@@ -389,7 +390,19 @@ Return Value:
     CkpEmitOp(&Compiler, CkOpReturn);
 
 CompileEnd:
-    return CkpFinalizeCompiler(&Compiler, "(module)", 8);
+    Function = CkpFinalizeCompiler(&Compiler, "(module)", 8);
+
+    //
+    // The syntax tree is only needed while compiling, so release it now
+    // rather than leaving it allocated for the life of the VM.
+    //
+
+    if (Parser.Nodes != NULL) {
+        CkFree(Vm, Parser.Nodes);
+        Parser.Nodes = NULL;
+    }
+
+    return Function;
 }
 
 VOID
@@ -165,3 +165,25 @@ Return Value:
 
 --*/
 
+VOID
+CkpDestroyLexerTable (
+    PCK_VM Vm
+    );
+
+/*++
+
+Routine Description:
+
+    This routine destroys the compiled lexer table of the given VM, if one
+    was created.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
@@ -1673,6 +1673,7 @@ Return Value:
 
 VOID
 CkpInitializeLexer (
+    PCK_VM Vm,
     PLEXER Lexer,
     PCSTR Source,
     UINTN Length,
@@ -1687,6 +1688,9 @@ Routine Description:
 
 Arguments:
 
+    Vm - Supplies a pointer to the virtual machine, which holds the compiled
+        lexer table.
+
     Lexer - Supplies a pointer to the lexer to initialize.
 
     Source - Supplies a pointer to the null terminated source string to lex.
@@ -31,6 +31,7 @@ Module Name:
 
 #include "chalkp.h"
 #include "debug.h"
+#include "profile.h"
 
 #include <stdio.h>
 
@@ -250,6 +251,10 @@ Return Value:
 
         if (Fiber->TryCount == 0) {
             Fiber->Error = Exception;
+            if (Vm->Profiler != NULL) {
+                CkpProfilerLeave(Vm, Fiber, 0);
+            }
+
             Fiber->FrameCount = 0;
             Fiber->StackTop = Fiber->Stack;
             Fiber = Fiber->Caller;
@@ -302,6 +307,10 @@ Return Value:
         // Reset execution to the exception handler.
         //
 
+        if (Vm->Profiler != NULL) {
+            CkpProfilerLeave(Vm, Fiber, TryBlock->FrameCount);
+        }
+
         Fiber->FrameCount = TryBlock->FrameCount;
         TryBlock->FrameCount = 0;
         Frame = &(Fiber->Frames[Fiber->FrameCount - 1]);
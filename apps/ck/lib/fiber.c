@@ -31,6 +31,7 @@ Module Name:
 //
 
 #include "chalkp.h"
+#include "profile.h"
 
 //
 // ---------------------------------------------------------------- Definitions
@@ -212,6 +213,7 @@ Return Value:
     CkpInitializeObject(Vm, &(Fiber->Header), CkObjectFiber, Vm->Class.Fiber);
     Fiber->Frames = CallFrames;
     Fiber->FrameCapacity = CK_INITIAL_CALL_FRAMES;
+    Fiber->FrameCount = 0;
     Fiber->Stack = Stack;
     Fiber->StackCapacity = StackCapacity;
     Fiber->TryStack = NULL;
@@ -337,6 +339,11 @@ Return Value:
     Frame->Closure = Closure;
     Frame->StackStart = Stack;
     Frame->TryCount = Fiber->TryCount;
+    Frame->ProfileRecord = 0;
+    if (Vm->Profiler != NULL) {
+        CkpProfilerEnter(Vm, Frame);
+    }
+
     return;
 }
 
@@ -541,6 +548,10 @@ Return Value:
     Fiber->OpenUpvalues = NULL;
     Fiber->Caller = NULL;
     Fiber->Error = CK_NULL_VALUE;
+    if (Vm->Profiler != NULL) {
+        CkpProfilerLeave(Vm, Fiber, 0);
+    }
+
     Fiber->FrameCount = 0;
     Fiber->TryCount = 0;
     if (Closure != NULL) {
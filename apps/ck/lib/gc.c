@@ -37,6 +37,7 @@ Module Name:
 #include <minoca/lib/yy.h>
 #include "lang.h"
 #include "compsup.h"
+#include "profile.h"
 
 //
 // ---------------------------------------------------------------- Definitions
@@ -56,6 +57,12 @@ CkpKissCompiler (
     PCK_COMPILER Compiler
     );
 
+VOID
+CkpKissProfiler (
+    PCK_VM Vm,
+    PCK_PROFILER Profiler
+    );
+
 VOID
 CkpKissValue (
     PCK_VM Vm,
@@ -229,6 +236,10 @@ Return Value:
         CkpKissCompiler(Vm, Vm->Compiler);
     }
 
+    if (Vm->Profiler != NULL) {
+        CkpKissProfiler(Vm, Vm->Profiler);
+    }
+
     CkpKissObject(Vm, &(Vm->UnhandledException->Header));
     CkpDeeplyKiss(Vm, &KissHead);
     CkpCollectUnkissedObjects(Vm);
@@ -473,6 +484,44 @@ Return Value:
     return;
 }
 
+VOID
+CkpKissProfiler (
+    PCK_VM Vm,
+    PCK_PROFILER Profiler
+    )
+
+/*++
+
+Routine Description:
+
+    This routine kisses the functions the profiler has counters for. This
+    keeps a new function from landing at the address of a collected one and
+    inheriting its counters, and keeps the names around for the report.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Profiler - Supplies a pointer to the profiler to kiss.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Index;
+
+    for (Index = 0; Index < Profiler->RecordCount; Index += 1) {
+        CkpKissObject(Vm, Profiler->Records[Index].Key);
+        CkpKissObject(Vm, &(Profiler->Records[Index].Closure->Header));
+    }
+
+    return;
+}
+
 VOID
 CkpKissValue (
     PCK_VM Vm,
@@ -60,6 +60,13 @@ Module Name:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+PVOID
+CkpLexerReallocate (
+    PVOID Context,
+    PVOID Allocation,
+    UINTN Size
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -243,6 +250,7 @@ PSTR CkLexerIgnoreExpressions[] = {
 
 VOID
 CkpInitializeLexer (
+    PCK_VM Vm,
     PLEXER Lexer,
     PCSTR Source,
     UINTN Length,
@@ -257,6 +265,9 @@ Routine Description:
 
 Arguments:
 
+    Vm - Supplies a pointer to the virtual machine, which holds the compiled
+        lexer table.
+
     Lexer - Supplies a pointer to the lexer to initialize.
 
     Source - Supplies a pointer to the null terminated source string to lex.
@@ -276,6 +287,7 @@ Return Value:
 {
 
     KSTATUS Status;
+    PYY_LEX_TABLE Table;
 
     CkZero(Lexer, sizeof(LEXER));
 
@@ -296,6 +308,20 @@ Return Value:
     Lexer->IgnoreExpressions = CkLexerIgnoreExpressions;
     Lexer->ExpressionNames = CkLexerTokenNames;
     Lexer->TokenBase = YY_TOKEN_OFFSET;
+
+    //
+    // Compile the expressions the first time through. If that fails, the
+    // lexer just interprets the expressions, which works but is slower.
+    //
+
+    if (Vm->LexerTable == NULL) {
+        Status = YyLexCompile(Lexer, CkpLexerReallocate, Vm, &Table);
+        if (KSUCCESS(Status)) {
+            Vm->LexerTable = Table;
+        }
+    }
+
+    Lexer->Table = Vm->LexerTable;
     Status = YyLexInitialize(Lexer);
 
     CK_ASSERT(KSUCCESS(Status));
@@ -373,7 +399,76 @@ Return Value:
     return YyStatusSuccess;
 }
 
+VOID
+CkpDestroyLexerTable (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys the compiled lexer table of the given VM, if one
+    was created.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (Vm->LexerTable != NULL) {
+        YyLexDestroyTable(Vm->LexerTable, CkpLexerReallocate, Vm);
+        Vm->LexerTable = NULL;
+    }
+
+    return;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+PVOID
+CkpLexerReallocate (
+    PVOID Context,
+    PVOID Allocation,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates, reallocates, or frees memory for the lexer table.
+    The table lives as long as the VM and is not garbage collected, so this
+    goes straight to the raw allocator.
+
+Arguments:
+
+    Context - Supplies a pointer to the virtual machine.
+
+    Allocation - Supplies an optional pointer to an existing allocation to
+        resize or free.
+
+    Size - Supplies the new size of the allocation, or 0 to free it.
+
+Return Value:
+
+    Returns a pointer to the allocated memory on success.
+
+    NULL on allocation failure or free.
+
+--*/
+
+{
+
+    return CkRawReallocate((PCK_VM)Context, Allocation, Size);
+}
+
@@ -755,6 +755,14 @@ Return Value:
         Module->Handle = NULL;
     }
 
+    //
+    // The string table dictionaries are objects that get collected on their
+    // own, but the arrays belong to the module.
+    //
+
+    CkpClearArray(Vm, &(Module->Variables));
+    CkpClearArray(Vm, &(Module->VariableNames.List));
+    CkpClearArray(Vm, &(Module->Strings.List));
     return;
 }
 
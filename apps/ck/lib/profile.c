@@ -0,0 +1,1176 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    profile.c
+
+Abstract:
+
+    This module implements the Chalk profiler. The profiler can sample the
+    Chalk call stack whenever it is ticked by the embedding application, and
+    can count the calls to and time spent in each function. When the profiler
+    is not running, the interpreter pays only a null pointer check at calls,
+    returns, and loop back edges.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    C
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "chalkp.h"
+#include "debug.h"
+#include "profile.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the initial number of slots in the profiler hash tables.
+//
+
+#define CK_PROFILE_INITIAL_HASH_SIZE 256
+
+//
+// Define the initial size of the stack string buffer.
+//
+
+#define CK_PROFILE_INITIAL_BUFFER_SIZE 1024
+
+//
+// Define the room needed in the buffer for a line number or count.
+//
+
+#define CK_PROFILE_NUMBER_SIZE 24
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+CkpProfilerSample (
+    PCK_VM Vm,
+    ULONG Ticks
+    );
+
+UINTN
+CkpProfilerFindRecord (
+    PCK_VM Vm,
+    PCK_CLOSURE Closure
+    );
+
+BOOL
+CkpProfilerAppendName (
+    PCK_VM Vm,
+    PCK_CLOSURE Closure
+    );
+
+BOOL
+CkpProfilerAppend (
+    PCK_VM Vm,
+    PCSTR String,
+    UINTN Length
+    );
+
+BOOL
+CkpProfilerGrowHash (
+    PCK_VM Vm,
+    PUINTN *Table,
+    PUINTN TableSize,
+    UINTN Count,
+    PULONG Hashes,
+    UINTN Stride
+    );
+
+VOID
+CkpProfilerHashInsert (
+    PUINTN Table,
+    UINTN TableSize,
+    ULONG Hash,
+    UINTN Index
+    );
+
+ULONG
+CkpProfilerHashString (
+    PCSTR String,
+    UINTN Length
+    );
+
+ULONGLONG
+CkpProfilerGetTime (
+    VOID
+    );
+
+int
+CkpProfilerCompareRecords (
+    const void *Left,
+    const void *Right
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+CK_API
+BOOL
+CkStartProfiler (
+    PCK_VM Vm,
+    ULONG Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts profiling the given VM. Stack samples are only taken
+    when the profiler is ticked, so the caller must also arrange for
+    CkProfilerTick to be called periodically.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Flags - Supplies a bitfield of flags governing what to collect. See
+        CK_PROFILE_* definitions.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on allocation failure or if the profiler is already running.
+
+--*/
+
+{
+
+    PCK_PROFILER Profiler;
+
+    if (Vm->Profiler != NULL) {
+        return FALSE;
+    }
+
+    Profiler = CkRawAllocate(Vm, sizeof(CK_PROFILER));
+    if (Profiler == NULL) {
+        return FALSE;
+    }
+
+    CkZero(Profiler, sizeof(CK_PROFILER));
+    Profiler->Flags = Flags;
+    Vm->Profiler = Profiler;
+    return TRUE;
+}
+
+CK_API
+VOID
+CkProfilerTick (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine requests a stack sample. The sample is taken the next time
+    the interpreter calls, returns, or loops. This routine only sets a
+    counter, so it is safe to call from a signal handler or timer thread, as
+    long as the profiler is not being stopped at the same time.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_PROFILER Profiler;
+
+    Profiler = Vm->Profiler;
+    if ((Profiler != NULL) && ((Profiler->Flags & CK_PROFILE_SAMPLE) != 0)) {
+        Profiler->PendingTicks += 1;
+    }
+
+    return;
+}
+
+CK_API
+VOID
+CkWriteProfile (
+    PCK_VM Vm,
+    ULONG Flags,
+    PCK_WRITE Write
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints the collected profile. Stack samples are printed in
+    the folded format used by flame graph tools: one line per unique stack,
+    with frames separated by semicolons, followed by the sample count.
+    Function counters are printed one per line as the call count, the
+    inclusive time in microseconds, and the function name, sorted by time.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Flags - Supplies the part of the profile to print. Supply exactly one of
+        the CK_PROFILE_* flags.
+
+    Write - Supplies a pointer to the routine called to print each line.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Index;
+    CHAR Number[CK_PROFILE_NUMBER_SIZE * 2];
+    UINTN NumberLength;
+    PCK_PROFILER Profiler;
+    PCK_PROFILE_RECORD Record;
+    PCK_PROFILE_RECORD *Sorted;
+    PCK_PROFILE_STACK Sample;
+
+    Profiler = Vm->Profiler;
+    if (Profiler == NULL) {
+        return;
+    }
+
+    if (Flags == CK_PROFILE_SAMPLE) {
+        for (Index = 0; Index < Profiler->SampleCount; Index += 1) {
+            Sample = &(Profiler->Samples[Index]);
+            snprintf(Number,
+                     sizeof(Number),
+                     " %llu\n",
+                     (unsigned long long)(Sample->Count));
+
+            Write(Vm, Sample->Stack);
+            Write(Vm, Number);
+        }
+
+    } else if ((Flags == CK_PROFILE_COUNT) && (Profiler->RecordCount != 0)) {
+        Sorted = CkRawAllocate(Vm,
+                               Profiler->RecordCount *
+                               sizeof(PCK_PROFILE_RECORD));
+
+        if (Sorted == NULL) {
+            return;
+        }
+
+        for (Index = 0; Index < Profiler->RecordCount; Index += 1) {
+            Sorted[Index] = &(Profiler->Records[Index]);
+        }
+
+        qsort(Sorted,
+              Profiler->RecordCount,
+              sizeof(PCK_PROFILE_RECORD),
+              CkpProfilerCompareRecords);
+
+        for (Index = 0; Index < Profiler->RecordCount; Index += 1) {
+            Record = Sorted[Index];
+            NumberLength = snprintf(Number,
+                                    sizeof(Number),
+                                    "%llu %llu ",
+                                    (unsigned long long)(Record->Calls),
+                                    (unsigned long long)(Record->Time));
+
+            Profiler->BufferLength = 0;
+            if ((CkpProfilerAppend(Vm, Number, NumberLength) != FALSE) &&
+                (CkpProfilerAppendName(Vm, Record->Closure) != FALSE) &&
+                (CkpProfilerAppend(Vm, "\n", 1) != FALSE)) {
+
+                Write(Vm, Profiler->Buffer);
+            }
+        }
+
+        CkRawFree(Vm, Sorted);
+    }
+
+    return;
+}
+
+CK_API
+VOID
+CkStopProfiler (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine stops profiling the given VM and discards the collected
+    profile. The caller must make sure nothing is still ticking the
+    profiler.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Index;
+    PCK_PROFILER Profiler;
+
+    Profiler = Vm->Profiler;
+    if (Profiler == NULL) {
+        return;
+    }
+
+    Vm->Profiler = NULL;
+    for (Index = 0; Index < Profiler->SampleCount; Index += 1) {
+        CkRawFree(Vm, Profiler->Samples[Index].Stack);
+    }
+
+    if (Profiler->Samples != NULL) {
+        CkRawFree(Vm, Profiler->Samples);
+    }
+
+    if (Profiler->SampleHash != NULL) {
+        CkRawFree(Vm, Profiler->SampleHash);
+    }
+
+    if (Profiler->Records != NULL) {
+        CkRawFree(Vm, Profiler->Records);
+    }
+
+    if (Profiler->RecordHash != NULL) {
+        CkRawFree(Vm, Profiler->RecordHash);
+    }
+
+    if (Profiler->Buffer != NULL) {
+        CkRawFree(Vm, Profiler->Buffer);
+    }
+
+    CkRawFree(Vm, Profiler);
+    return;
+}
+
+VOID
+CkpProfilerCheck (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes a stack sample if any profiler ticks have come in. The
+    current frame's instruction pointer must be up to date.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_PROFILER Profiler;
+    ULONG Ticks;
+
+    Profiler = Vm->Profiler;
+    Ticks = Profiler->PendingTicks;
+    if (Ticks != 0) {
+
+        //
+        // A tick that arrives between the read and the clear is lost, which
+        // is fine for a statistical profile.
+        //
+
+        Profiler->PendingTicks = 0;
+        CkpProfilerSample(Vm, Ticks);
+    }
+
+    return;
+}
+
+VOID
+CkpProfilerEnter (
+    PCK_VM Vm,
+    PCK_CALL_FRAME Frame
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when a new call frame has been pushed.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Frame - Supplies a pointer to the new frame.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Index;
+    PCK_PROFILER Profiler;
+    PCK_PROFILE_RECORD Record;
+
+    CkpProfilerCheck(Vm);
+    Profiler = Vm->Profiler;
+    if ((Profiler->Flags & CK_PROFILE_COUNT) == 0) {
+        return;
+    }
+
+    Index = CkpProfilerFindRecord(Vm, Frame->Closure);
+    if (Index == 0) {
+        return;
+    }
+
+    Record = &(Profiler->Records[Index - 1]);
+    Record->Calls += 1;
+    Record->Active += 1;
+    Frame->ProfileRecord = Index;
+    Frame->ProfileStart = CkpProfilerGetTime();
+    return;
+}
+
+VOID
+CkpProfilerLeave (
+    PCK_VM Vm,
+    PCK_FIBER Fiber,
+    UINTN FrameCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when one or more call frames are about to be
+    popped off of a fiber.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Fiber - Supplies a pointer to the fiber whose frames are being popped.
+
+    FrameCount - Supplies the frame count the fiber is about to be cut back
+        to. Every frame at or above this index is being popped.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_CALL_FRAME Frame;
+    UINTN Index;
+    ULONGLONG Now;
+    PCK_PROFILER Profiler;
+    PCK_PROFILE_RECORD Record;
+
+    Profiler = Vm->Profiler;
+    if ((Profiler->Flags & CK_PROFILE_COUNT) == 0) {
+        return;
+    }
+
+    Now = CkpProfilerGetTime();
+    for (Index = FrameCount; Index < Fiber->FrameCount; Index += 1) {
+        Frame = &(Fiber->Frames[Index]);
+        if (Frame->ProfileRecord == 0) {
+            continue;
+        }
+
+        Record = &(Profiler->Records[Frame->ProfileRecord - 1]);
+
+        CK_ASSERT(Record->Active != 0);
+
+        Record->Active -= 1;
+        if (Record->Active == 0) {
+            Record->Time += Now - Frame->ProfileStart;
+        }
+
+        Frame->ProfileRecord = 0;
+    }
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+CkpProfilerSample (
+    PCK_VM Vm,
+    ULONG Ticks
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records the current fiber's call stack.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Ticks - Supplies the number of ticks to charge to the stack.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_CLOSURE Closure;
+    PCK_FIBER Fiber;
+    PCK_CALL_FRAME Frame;
+    UINTN FrameIndex;
+    PCK_FUNCTION Function;
+    ULONG Hash;
+    UINTN Index;
+    UINTN Length;
+    LONG Line;
+    CHAR Number[CK_PROFILE_NUMBER_SIZE];
+    UINTN NumberLength;
+    PCK_PROFILER Profiler;
+    PCK_PROFILE_STACK Sample;
+    UINTN Slot;
+    PSTR Stack;
+
+    Profiler = Vm->Profiler;
+    Fiber = Vm->Fiber;
+    if ((Fiber == NULL) || (Fiber->FrameCount == 0)) {
+        return;
+    }
+
+    //
+    // Build the folded stack string, outermost frame first. Each frame is
+    // the module and function name, plus the current line for Chalk code.
+    //
+
+    Profiler->BufferLength = 0;
+    for (FrameIndex = 0; FrameIndex < Fiber->FrameCount; FrameIndex += 1) {
+        Frame = &(Fiber->Frames[FrameIndex]);
+        Closure = Frame->Closure;
+        if (FrameIndex != 0) {
+            if (CkpProfilerAppend(Vm, ";", 1) == FALSE) {
+                return;
+            }
+        }
+
+        if (CkpProfilerAppendName(Vm, Closure) == FALSE) {
+            return;
+        }
+
+        if (Closure->Type == CkClosureBlock) {
+            Function = Closure->U.Block.Function;
+            if (Frame->Ip > Function->Code.Data) {
+                Line = CkpGetLineForOffset(Function,
+                                           Frame->Ip - Function->Code.Data - 1);
+
+            } else {
+                Line = Function->Debug.FirstLine;
+            }
+
+            NumberLength = snprintf(Number, sizeof(Number), ":%d", (INT)Line);
+            if (CkpProfilerAppend(Vm, Number, NumberLength) == FALSE) {
+                return;
+            }
+        }
+    }
+
+    Length = Profiler->BufferLength;
+    Hash = CkpProfilerHashString(Profiler->Buffer, Length);
+    if (Profiler->SampleHash != NULL) {
+        Slot = Hash & (Profiler->SampleHashSize - 1);
+        while (Profiler->SampleHash[Slot] != 0) {
+            Sample = &(Profiler->Samples[Profiler->SampleHash[Slot] - 1]);
+            if ((Sample->Hash == Hash) && (Sample->Length == Length) &&
+                (CkCompareMemory(Sample->Stack, Profiler->Buffer, Length) ==
+                 0)) {
+
+                Sample->Count += Ticks;
+                goto ProfilerSampleEnd;
+            }
+
+            Slot = (Slot + 1) & (Profiler->SampleHashSize - 1);
+        }
+    }
+
+    //
+    // This is a new stack. Make room for it in the array and hash table.
+    //
+
+    if (Profiler->SampleCount >= Profiler->SampleCapacity) {
+        Index = Profiler->SampleCapacity * 2;
+        if (Index == 0) {
+            Index = CK_PROFILE_INITIAL_HASH_SIZE / 2;
+        }
+
+        Sample = CkRawReallocate(Vm,
+                                 Profiler->Samples,
+                                 Index * sizeof(CK_PROFILE_STACK));
+
+        if (Sample == NULL) {
+            goto ProfilerSampleEnd;
+        }
+
+        Profiler->Samples = Sample;
+        Profiler->SampleCapacity = Index;
+    }
+
+    if (CkpProfilerGrowHash(Vm,
+                            &(Profiler->SampleHash),
+                            &(Profiler->SampleHashSize),
+                            Profiler->SampleCount,
+                            &(Profiler->Samples[0].Hash),
+                            sizeof(CK_PROFILE_STACK)) == FALSE) {
+
+        goto ProfilerSampleEnd;
+    }
+
+    Stack = CkRawAllocate(Vm, Length + 1);
+    if (Stack == NULL) {
+        goto ProfilerSampleEnd;
+    }
+
+    CkCopy(Stack, Profiler->Buffer, Length + 1);
+    Sample = &(Profiler->Samples[Profiler->SampleCount]);
+    Sample->Stack = Stack;
+    Sample->Length = Length;
+    Sample->Hash = Hash;
+    Sample->Count = Ticks;
+    CkpProfilerHashInsert(Profiler->SampleHash,
+                          Profiler->SampleHashSize,
+                          Hash,
+                          Profiler->SampleCount);
+
+    Profiler->SampleCount += 1;
+
+ProfilerSampleEnd:
+    return;
+}
+
+UINTN
+CkpProfilerFindRecord (
+    PCK_VM Vm,
+    PCK_CLOSURE Closure
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds or creates the counter record for a function.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Closure - Supplies a pointer to the closure being called.
+
+Return Value:
+
+    Returns the index of the record plus one.
+
+    0 on allocation failure.
+
+--*/
+
+{
+
+    ULONG Hash;
+    UINTN Index;
+    PCK_OBJECT Key;
+    UINTN Mask;
+    PCK_PROFILER Profiler;
+    PCK_PROFILE_RECORD Record;
+    UINTN Slot;
+
+    Profiler = Vm->Profiler;
+
+    //
+    // Every closure over a Chalk function shares its counters.
+    //
+
+    if (Closure->Type == CkClosureBlock) {
+        Key = &(Closure->U.Block.Function->Header);
+
+    } else {
+        Key = &(Closure->Header);
+    }
+
+    Hash = CkpProfilerHashString((PCSTR)&Key, sizeof(Key));
+    if (Profiler->RecordHash != NULL) {
+        Mask = Profiler->RecordHashSize - 1;
+        Slot = Hash & Mask;
+        while (Profiler->RecordHash[Slot] != 0) {
+            Index = Profiler->RecordHash[Slot];
+            if (Profiler->Records[Index - 1].Key == Key) {
+                return Index;
+            }
+
+            Slot = (Slot + 1) & Mask;
+        }
+    }
+
+    if (Profiler->RecordCount >= Profiler->RecordCapacity) {
+        Index = Profiler->RecordCapacity * 2;
+        if (Index == 0) {
+            Index = CK_PROFILE_INITIAL_HASH_SIZE / 2;
+        }
+
+        Record = CkRawReallocate(Vm,
+                                 Profiler->Records,
+                                 Index * sizeof(CK_PROFILE_RECORD));
+
+        if (Record == NULL) {
+            return 0;
+        }
+
+        Profiler->Records = Record;
+        Profiler->RecordCapacity = Index;
+    }
+
+    if (CkpProfilerGrowHash(Vm,
+                            &(Profiler->RecordHash),
+                            &(Profiler->RecordHashSize),
+                            Profiler->RecordCount,
+                            &(Profiler->Records[0].Hash),
+                            sizeof(CK_PROFILE_RECORD)) == FALSE) {
+
+        return 0;
+    }
+
+    Record = &(Profiler->Records[Profiler->RecordCount]);
+    CkZero(Record, sizeof(CK_PROFILE_RECORD));
+    Record->Key = Key;
+    Record->Closure = Closure;
+    Record->Hash = Hash;
+    CkpProfilerHashInsert(Profiler->RecordHash,
+                          Profiler->RecordHashSize,
+                          Hash,
+                          Profiler->RecordCount);
+
+    Profiler->RecordCount += 1;
+    return Profiler->RecordCount;
+}
+
+BOOL
+CkpProfilerAppendName (
+    PCK_VM Vm,
+    PCK_CLOSURE Closure
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends the module and function name of the given closure
+    to the profiler's scratch buffer.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Closure - Supplies a pointer to the closure.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on allocation failure.
+
+--*/
+
+{
+
+    PCK_MODULE Module;
+    PCK_STRING Name;
+
+    switch (Closure->Type) {
+    case CkClosureBlock:
+        Module = Closure->U.Block.Function->Module;
+        break;
+
+    case CkClosureForeign:
+        Module = Closure->U.Foreign.Module;
+        break;
+
+    default:
+        Module = NULL;
+        break;
+    }
+
+    if ((Module != NULL) && (Module->Name != NULL)) {
+        Name = Module->Name;
+        if ((CkpProfilerAppend(Vm, Name->Value, Name->Length) == FALSE) ||
+            (CkpProfilerAppend(Vm, ".", 1) == FALSE)) {
+
+            return FALSE;
+        }
+    }
+
+    Name = CkpGetFunctionName(Closure);
+    return CkpProfilerAppend(Vm, Name->Value, Name->Length);
+}
+
+BOOL
+CkpProfilerAppend (
+    PCK_VM Vm,
+    PCSTR String,
+    UINTN Length
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends to the profiler's scratch buffer, keeping it null
+    terminated.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    String - Supplies a pointer to the string to append.
+
+    Length - Supplies the number of bytes to append.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on allocation failure.
+
+--*/
+
+{
+
+    PSTR NewBuffer;
+    UINTN NewCapacity;
+    PCK_PROFILER Profiler;
+
+    Profiler = Vm->Profiler;
+    if (Profiler->BufferLength + Length + 1 > Profiler->BufferCapacity) {
+        NewCapacity = Profiler->BufferCapacity * 2;
+        if (NewCapacity == 0) {
+            NewCapacity = CK_PROFILE_INITIAL_BUFFER_SIZE;
+        }
+
+        while (NewCapacity < Profiler->BufferLength + Length + 1) {
+            NewCapacity *= 2;
+        }
+
+        NewBuffer = CkRawReallocate(Vm, Profiler->Buffer, NewCapacity);
+        if (NewBuffer == NULL) {
+            return FALSE;
+        }
+
+        Profiler->Buffer = NewBuffer;
+        Profiler->BufferCapacity = NewCapacity;
+    }
+
+    CkCopy(Profiler->Buffer + Profiler->BufferLength, String, Length);
+    Profiler->BufferLength += Length;
+    Profiler->Buffer[Profiler->BufferLength] = '\0';
+    return TRUE;
+}
+
+BOOL
+CkpProfilerGrowHash (
+    PCK_VM Vm,
+    PUINTN *Table,
+    PUINTN TableSize,
+    UINTN Count,
+    PULONG Hashes,
+    UINTN Stride
+    )
+
+/*++
+
+Routine Description:
+
+    This routine makes sure a profiler hash table has room for one more entry,
+    keeping it no more than half full. If the table grows, the existing
+    entries are reinserted.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Table - Supplies a pointer to the hash table pointer, which may be
+        updated.
+
+    TableSize - Supplies a pointer to the hash table size, which may be
+        updated.
+
+    Count - Supplies the number of entries currently in the table.
+
+    Hashes - Supplies a pointer to the hash member of the first entry in the
+        array the table indexes.
+
+    Stride - Supplies the size of each entry in that array.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on allocation failure.
+
+--*/
+
+{
+
+    ULONG Hash;
+    UINTN Index;
+    PUINTN NewTable;
+    UINTN NewSize;
+
+    if ((*Table != NULL) && ((Count + 1) * 2 <= *TableSize)) {
+        return TRUE;
+    }
+
+    NewSize = *TableSize * 2;
+    if (NewSize == 0) {
+        NewSize = CK_PROFILE_INITIAL_HASH_SIZE;
+    }
+
+    NewTable = CkRawAllocate(Vm, NewSize * sizeof(UINTN));
+    if (NewTable == NULL) {
+        return FALSE;
+    }
+
+    CkZero(NewTable, NewSize * sizeof(UINTN));
+    for (Index = 0; Index < Count; Index += 1) {
+        Hash = *(PULONG)((PUCHAR)Hashes + (Index * Stride));
+        CkpProfilerHashInsert(NewTable, NewSize, Hash, Index);
+    }
+
+    if (*Table != NULL) {
+        CkRawFree(Vm, *Table);
+    }
+
+    *Table = NewTable;
+    *TableSize = NewSize;
+    return TRUE;
+}
+
+VOID
+CkpProfilerHashInsert (
+    PUINTN Table,
+    UINTN TableSize,
+    ULONG Hash,
+    UINTN Index
+    )
+
+/*++
+
+Routine Description:
+
+    This routine inserts an entry into a profiler hash table. The table must
+    have a free slot.
+
+Arguments:
+
+    Table - Supplies a pointer to the hash table.
+
+    TableSize - Supplies the number of slots in the table.
+
+    Hash - Supplies the hash of the entry.
+
+    Index - Supplies the array index of the entry.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Slot;
+
+    Slot = Hash & (TableSize - 1);
+    while (Table[Slot] != 0) {
+        Slot = (Slot + 1) & (TableSize - 1);
+    }
+
+    Table[Slot] = Index + 1;
+    return;
+}
+
+ULONG
+CkpProfilerHashString (
+    PCSTR String,
+    UINTN Length
+    )
+
+/*++
+
+Routine Description:
+
+    This routine computes the FNV-1a hash of a buffer.
+
+Arguments:
+
+    String - Supplies a pointer to the buffer.
+
+    Length - Supplies the length of the buffer in bytes.
+
+Return Value:
+
+    Returns the hash.
+
+--*/
+
+{
+
+    ULONG Hash;
+    UINTN Index;
+
+    Hash = 2166136261U;
+    for (Index = 0; Index < Length; Index += 1) {
+        Hash ^= (UCHAR)(String[Index]);
+        Hash *= 16777619;
+    }
+
+    return Hash;
+}
+
+ULONGLONG
+CkpProfilerGetTime (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the processor time used by the process, which is
+    what the function counters measure.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the processor time in microseconds.
+
+--*/
+
+{
+
+    return ((ULONGLONG)clock() * 1000000ULL) / CLOCKS_PER_SEC;
+}
+
+int
+CkpProfilerCompareRecords (
+    const void *Left,
+    const void *Right
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compares two function counter records for sorting, putting
+    the most expensive functions first.
+
+Arguments:
+
+    Left - Supplies a pointer to the left record pointer.
+
+    Right - Supplies a pointer to the right record pointer.
+
+Return Value:
+
+    Less than zero if the left record should come first.
+
+    Zero if the records are equally expensive.
+
+    Greater than zero if the right record should come first.
+
+--*/
+
+{
+
+    PCK_PROFILE_RECORD LeftRecord;
+    PCK_PROFILE_RECORD RightRecord;
+
+    LeftRecord = *(PCK_PROFILE_RECORD *)Left;
+    RightRecord = *(PCK_PROFILE_RECORD *)Right;
+    if (LeftRecord->Time != RightRecord->Time) {
+        if (LeftRecord->Time > RightRecord->Time) {
+            return -1;
+        }
+
+        return 1;
+    }
+
+    if (LeftRecord->Calls != RightRecord->Calls) {
+        if (LeftRecord->Calls > RightRecord->Calls) {
+            return -1;
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,246 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    profile.h
+
+Abstract:
+
+    This header contains definitions for the Chalk profiler.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores the counters for a single function.
+
+Members:
+
+    Key - Stores the object the counters are keyed on. This is the function
+        object for Chalk functions, and the closure for foreign functions.
+
+    Closure - Stores a closure for the function, used to get its name.
+
+    Hash - Stores the hash of the key.
+
+    Calls - Stores the number of times the function was called.
+
+    Time - Stores the inclusive time spent in the function, in microseconds.
+        Recursive calls are only timed at the outermost level.
+
+    Active - Stores the number of frames for this function currently on any
+        fiber's call stack.
+
+--*/
+
+typedef struct _CK_PROFILE_RECORD {
+    PCK_OBJECT Key;
+    PCK_CLOSURE Closure;
+    ULONG Hash;
+    ULONGLONG Calls;
+    ULONGLONG Time;
+    ULONG Active;
+} CK_PROFILE_RECORD, *PCK_PROFILE_RECORD;
+
+/*++
+
+Structure Description:
+
+    This structure stores a unique sampled call stack.
+
+Members:
+
+    Stack - Stores a pointer to the folded stack string, with frames
+        separated by semicolons. This is allocated separately.
+
+    Length - Stores the length of the stack string, not including the null
+        terminator.
+
+    Hash - Stores the hash of the stack string.
+
+    Count - Stores the number of ticks that landed on this stack.
+
+--*/
+
+typedef struct _CK_PROFILE_STACK {
+    PSTR Stack;
+    UINTN Length;
+    ULONG Hash;
+    ULONGLONG Count;
+} CK_PROFILE_STACK, *PCK_PROFILE_STACK;
+
+/*++
+
+Structure Description:
+
+    This structure stores the state of the Chalk profiler. All of its memory
+    is allocated outside the garbage collector so that taking a sample can
+    never kick off a collection.
+
+Members:
+
+    Flags - Stores the CK_PROFILE_* flags governing what is collected.
+
+    PendingTicks - Stores the number of ticks that have come in since the
+        last sample was taken.
+
+    Records - Stores the array of function counter records.
+
+    RecordCount - Stores the number of valid records.
+
+    RecordCapacity - Stores the number of records the array can hold.
+
+    RecordHash - Stores the hash table of records, keyed by object. Each
+        entry is a record index plus one, or zero if the slot is free.
+
+    RecordHashSize - Stores the number of slots in the record hash table,
+        which is always a power of two.
+
+    Samples - Stores the array of unique stacks sampled.
+
+    SampleCount - Stores the number of valid samples.
+
+    SampleCapacity - Stores the number of samples the array can hold.
+
+    SampleHash - Stores the hash table of samples. Each entry is a sample
+        index plus one, or zero if the slot is free.
+
+    SampleHashSize - Stores the number of slots in the sample hash table,
+        which is always a power of two.
+
+    Buffer - Stores the scratch buffer used to build stack strings and output
+        lines.
+
+    BufferLength - Stores the length of the string currently in the scratch
+        buffer, not including the null terminator.
+
+    BufferCapacity - Stores the size of the scratch buffer in bytes.
+
+--*/
+
+struct _CK_PROFILER {
+    ULONG Flags;
+    volatile ULONG PendingTicks;
+    PCK_PROFILE_RECORD Records;
+    UINTN RecordCount;
+    UINTN RecordCapacity;
+    PUINTN RecordHash;
+    UINTN RecordHashSize;
+    PCK_PROFILE_STACK Samples;
+    UINTN SampleCount;
+    UINTN SampleCapacity;
+    PUINTN SampleHash;
+    UINTN SampleHashSize;
+    PSTR Buffer;
+    UINTN BufferLength;
+    UINTN BufferCapacity;
+};
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+VOID
+CkpProfilerCheck (
+    PCK_VM Vm
+    );
+
+/*++
+
+Routine Description:
+
+    This routine takes a stack sample if any profiler ticks have come in. The
+    current frame's instruction pointer must be up to date.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+CkpProfilerEnter (
+    PCK_VM Vm,
+    PCK_CALL_FRAME Frame
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when a new call frame has been pushed.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Frame - Supplies a pointer to the new frame.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+CkpProfilerLeave (
+    PCK_VM Vm,
+    PCK_FIBER Fiber,
+    UINTN FrameCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called when one or more call frames are about to be
+    popped off of a fiber.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Fiber - Supplies a pointer to the fiber whose frames are being popped.
+
+    FrameCount - Supplies the frame count the fiber is about to be cut back
+        to. Every frame at or above this index is being popped.
+
+Return Value:
+
+    None.
+
+--*/
+
@@ -790,6 +790,11 @@ Structure Description:
     TryCount - Stores the try stack size upon invocation of this frame. This is
         used during function return to quickly pop all open try blocks off.
 
+    ProfileRecord - Stores the index plus one of the profiler counter record
+        charged for this frame, or 0 if the frame is not being counted.
+
+    ProfileStart - Stores the profiler timestamp when this frame was entered.
+
 --*/
 
 typedef struct _CK_CALL_FRAME {
@@ -797,6 +802,8 @@ typedef struct _CK_CALL_FRAME {
     PCK_CLOSURE Closure;
     PCK_VALUE StackStart;
     UINTN TryCount;
+    UINTN ProfileRecord;
+    ULONGLONG ProfileStart;
 } CK_CALL_FRAME, *PCK_CALL_FRAME;
 
 /*++
@@ -35,6 +35,7 @@ Module Name:
 #include "debug.h"
 #include "compiler.h"
 #include "vmsys.h"
+#include "profile.h"
 
 //
 // --------------------------------------------------------------------- Macros
@@ -458,6 +459,7 @@ Return Value:
 
     CK_ASSERT(Vm->Configuration.Reallocate != NULL);
 
+    CkStopProfiler(Vm);
     Object = Vm->FirstObject;
     while (Object != NULL) {
         Next = Object->Next;
@@ -466,6 +468,7 @@ Return Value:
     }
 
     Vm->FirstObject = NULL;
+    CkpDestroyLexerTable(Vm);
 
     //
     // Null out the reallocate function to catch double frees.
@@ -1173,6 +1176,18 @@ Return Value:
         CK_ASSERT(Ip - Offset >= Function->Code.Data);
 
         Ip -= Offset;
+
+        //
+        // Loop back edges are one of the places where pending profiler ticks
+        // are turned into samples, so that long loops without calls still
+        // show up.
+        //
+
+        if (Vm->Profiler != NULL) {
+            CKI_STORE_FRAME();
+            CkpProfilerCheck(Vm);
+        }
+
         CKI_DISPATCH();
 
     CKI_CASE(CkOpJumpIf):
@@ -1219,6 +1234,12 @@ Return Value:
         CK_ASSERT((Fiber->FrameCount != 0) &&
                   (Frame->TryCount <= Fiber->TryCount));
 
+        if (Vm->Profiler != NULL) {
+            CKI_STORE_FRAME();
+            CkpProfilerCheck(Vm);
+            CkpProfilerLeave(Vm, Fiber, Fiber->FrameCount - 1);
+        }
+
         Fiber->FrameCount -= 1;
         Fiber->TryCount = Frame->TryCount;
         CkpCloseUpvalues(Fiber, Stack);
@@ -1761,6 +1782,11 @@ Return Value:
 
         CK_ASSERT(Fiber->FrameCount != 0);
 
+        if (Vm->Profiler != NULL) {
+            CkpProfilerCheck(Vm);
+            CkpProfilerLeave(Vm, Fiber, Fiber->FrameCount - 1);
+        }
+
         Fiber->FrameCount -= 1;
         Fiber->StackTop = Fiber->Stack + ReturnStackIndex;
 
@@ -78,6 +78,7 @@ Module Name:
 //
 
 typedef struct _CK_COMPILER CK_COMPILER, *PCK_COMPILER;
+typedef struct _CK_PROFILER CK_PROFILER, *PCK_PROFILER;
 
 /*++
 
@@ -419,6 +420,13 @@ Structure Description:
     UnhandledException - Stores a pointer to a function used to catch any
         unhandled exceptions.
 
+    LexerTable - Stores a pointer to the compiled lexer table, which is built
+        the first time source is compiled and shared by every compile after.
+
+    Profiler - Stores an optional pointer to the profiler state. This is NULL
+        unless profiling was started, which keeps the interpreter's checks
+        down to a single compare.
+
     Context - Stores an opaque user context pointer that can be used by whoever
         is integrating the Chalk library.
 
@@ -442,6 +450,8 @@ struct _CK_VM {
     LONG ForeignCalls;
     INT MemoryException;
     PCK_CLOSURE UnhandledException;
+    PVOID LexerTable;
+    PCK_PROFILER Profiler;
     PVOID Context;
 };
 
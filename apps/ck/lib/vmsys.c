@@ -185,6 +185,16 @@ Return Value:
 
 {
 
+    //
+    // Handle frees directly, since realloc of a null pointer to zero bytes
+    // is allowed to hand back a real allocation.
+    //
+
+    if (NewSize == 0) {
+        free(Allocation);
+        return NULL;
+    }
+
     return realloc(Allocation, NewSize);
 }
 
@@ -0,0 +1,1059 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    bufferedio.c
+
+Abstract:
+
+    This module implements the IoBuffer class, which holds the read and write
+    buffers behind the Chalk BufferedIo class. Keeping the buffers in C means
+    reads, line splitting, and small writes are simple memory copies rather
+    than string slicing and list joins in the interpreter. The IoBuffer never
+    calls the raw stream itself: exceptions cannot be raised across foreign
+    function frames, so the BufferedIo class does all raw I/O and hands the
+    data to and from this buffer.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Chalk
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bufferedp.h"
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// This macro returns the number of unconsumed bytes in the read buffer.
+//
+
+#define CK_IO_READ_AVAILABLE(_Buffer) \
+    ((_Buffer)->ReadSize - (_Buffer)->ReadOffset)
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the default buffer size, which matches DEFAULT_BUFFER_SIZE in the
+// iobase module.
+//
+
+#define CK_IO_DEFAULT_BUFFER_SIZE 4096
+
+//
+// Define the field indices of the IoBuffer class.
+//
+
+#define CK_IO_FIELD_CONTEXT 0
+#define CK_IO_FIELD_COUNT 1
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores the context for an IoBuffer class instance.
+
+Members:
+
+    BufferSize - Stores the nominal size of each of the read and write
+        buffers.
+
+    ReadBuffer - Stores a pointer to the read buffer, allocated on first use.
+        This may grow beyond the buffer size to hold a long line or a large
+        peek.
+
+    ReadCapacity - Stores the allocated size of the read buffer.
+
+    ReadOffset - Stores the offset of the next unconsumed byte in the read
+        buffer.
+
+    ReadSize - Stores the number of valid bytes in the read buffer.
+
+    LineScan - Stores the number of unconsumed bytes already searched for a
+        newline without finding one, so that a line spanning several fills is
+        not rescanned from its beginning each time.
+
+    WriteBuffer - Stores a pointer to the write buffer, allocated on first
+        use.
+
+    WriteSize - Stores the number of dirty bytes in the write buffer.
+
+    Position - Stores the current position of the raw stream.
+
+--*/
+
+typedef struct _CK_IO_BUFFER {
+    UINTN BufferSize;
+    PUCHAR ReadBuffer;
+    UINTN ReadCapacity;
+    UINTN ReadOffset;
+    UINTN ReadSize;
+    UINTN LineScan;
+    PUCHAR WriteBuffer;
+    UINTN WriteSize;
+    CK_INTEGER Position;
+} CK_IO_BUFFER, *PCK_IO_BUFFER;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+CkpIoBufferInitialize (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferPeek (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferRead (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferReadLine (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferFill (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferWrite (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferPending (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferWritten (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferFlushRead (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferAdvance (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferTell (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoBufferSetPosition (
+    PCK_VM Vm
+    );
+
+PCK_IO_BUFFER
+CkpIoGetContext (
+    PCK_VM Vm
+    );
+
+VOID
+CkpIoDestroyContext (
+    PVOID Data
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+BOOL
+CkPreloadBufferedIoModule (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine preloads the _bufferedio module. It is called to make the
+    presence of the module known in cases where the module is statically
+    linked.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    return CkPreloadForeignModule(Vm,
+                                  "_bufferedio",
+                                  NULL,
+                                  NULL,
+                                  CkpBufferedIoModuleInit);
+}
+
+VOID
+CkpBufferedIoModuleInit (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine populates the _bufferedio module namespace.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    //
+    // Create the IoBuffer class.
+    //
+
+    CkPushString(Vm, "IoBuffer", 8);
+    CkGetVariable(Vm, 0, "Object");
+    CkPushClass(Vm, 0, CK_IO_FIELD_COUNT);
+    CkPushValue(Vm, -1);
+    CkSetVariable(Vm, 0, "IoBuffer");
+    CkPushFunction(Vm, CkpIoBufferInitialize, "__init", 1, 0);
+    CkPushString(Vm, "__init", 6);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferPeek, "peek", 1, 0);
+    CkPushString(Vm, "peek", 4);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferRead, "read", 1, 0);
+    CkPushString(Vm, "read", 4);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferReadLine, "readline", 1, 0);
+    CkPushString(Vm, "readline", 8);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferFill, "fill", 1, 0);
+    CkPushString(Vm, "fill", 4);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferWrite, "write", 1, 0);
+    CkPushString(Vm, "write", 5);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferPending, "pending", 0, 0);
+    CkPushString(Vm, "pending", 7);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferWritten, "written", 1, 0);
+    CkPushString(Vm, "written", 7);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferFlushRead, "flushRead", 0, 0);
+    CkPushString(Vm, "flushRead", 9);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferAdvance, "advance", 1, 0);
+    CkPushString(Vm, "advance", 7);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferTell, "tell", 0, 0);
+    CkPushString(Vm, "tell", 4);
+    CkBindMethod(Vm, 1);
+    CkPushFunction(Vm, CkpIoBufferSetPosition, "setPosition", 1, 0);
+    CkPushString(Vm, "setPosition", 11);
+    CkBindMethod(Vm, 1);
+    CkStackPop(Vm);
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+CkpIoBufferInitialize (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes a new IoBuffer instance. It takes the buffer size
+    to use. Supply a size less than or equal to zero to use the default buffer
+    size.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    CK_INTEGER BufferSize;
+    PCK_IO_BUFFER Context;
+
+    if (!CkCheckArgument(Vm, 1, CkTypeInteger)) {
+        return;
+    }
+
+    BufferSize = CkGetInteger(Vm, 1);
+    if (BufferSize <= 0) {
+        BufferSize = CK_IO_DEFAULT_BUFFER_SIZE;
+    }
+
+    //
+    // Reuse an old context in case this is not the first time __init is being
+    // called, or create a new context.
+    //
+
+    CkGetField(Vm, CK_IO_FIELD_CONTEXT);
+    Context = CkGetData(Vm, -1);
+    CkStackPop(Vm);
+    if (Context == NULL) {
+        Context = malloc(sizeof(CK_IO_BUFFER));
+        if (Context == NULL) {
+            CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+            return;
+        }
+
+        memset(Context, 0, sizeof(CK_IO_BUFFER));
+        if (CkPushData(Vm, Context, CkpIoDestroyContext) == FALSE) {
+            CkpIoDestroyContext(Context);
+            return;
+        }
+
+        CkSetField(Vm, CK_IO_FIELD_CONTEXT);
+
+    } else {
+        if (Context->ReadBuffer != NULL) {
+            free(Context->ReadBuffer);
+            Context->ReadBuffer = NULL;
+        }
+
+        if (Context->WriteBuffer != NULL) {
+            free(Context->WriteBuffer);
+            Context->WriteBuffer = NULL;
+        }
+    }
+
+    Context->BufferSize = BufferSize;
+    Context->ReadCapacity = 0;
+    Context->ReadOffset = 0;
+    Context->ReadSize = 0;
+    Context->LineScan = 0;
+    Context->WriteSize = 0;
+    Context->Position = 0;
+    return;
+}
+
+VOID
+CkpIoBufferPeek (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns up to the given number of buffered bytes without
+    consuming them. Supply a size less than or equal to zero to return
+    everything buffered.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Available;
+    PCK_IO_BUFFER Context;
+    CK_INTEGER Size;
+
+    if (!CkCheckArgument(Vm, 1, CkTypeInteger)) {
+        return;
+    }
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    Size = CkGetInteger(Vm, 1);
+    Available = CK_IO_READ_AVAILABLE(Context);
+    if ((Size <= 0) || (Size > Available)) {
+        Size = Available;
+    }
+
+    CkReturnString(Vm,
+                   (PCSTR)(Context->ReadBuffer + Context->ReadOffset),
+                   Size);
+
+    return;
+}
+
+VOID
+CkpIoBufferRead (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine consumes and returns up to the given number of buffered
+    bytes. Supply a negative size to consume everything buffered. A result
+    shorter than requested means the buffer is now empty.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Available;
+    PCK_IO_BUFFER Context;
+    CK_INTEGER Size;
+
+    if (!CkCheckArgument(Vm, 1, CkTypeInteger)) {
+        return;
+    }
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    Size = CkGetInteger(Vm, 1);
+    Available = CK_IO_READ_AVAILABLE(Context);
+    if ((Size < 0) || (Size > Available)) {
+        Size = Available;
+    }
+
+    CkReturnString(Vm,
+                   (PCSTR)(Context->ReadBuffer + Context->ReadOffset),
+                   Size);
+
+    Context->ReadOffset += Size;
+    Context->LineScan = 0;
+    return;
+}
+
+VOID
+CkpIoBufferReadLine (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine consumes and returns a complete line from the buffer,
+    including its trailing newline. It takes a limit on the number of bytes to
+    return, or -1 for no limit. If the buffer does not contain a complete
+    line or enough data to reach the limit, nothing is consumed and null is
+    returned.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Available;
+    PCK_IO_BUFFER Context;
+    PUCHAR Current;
+    CK_INTEGER Limit;
+    PUCHAR NewLine;
+    UINTN Scan;
+
+    if (!CkCheckArgument(Vm, 1, CkTypeInteger)) {
+        return;
+    }
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    Limit = CkGetInteger(Vm, 1);
+    Available = CK_IO_READ_AVAILABLE(Context);
+    Current = Context->ReadBuffer + Context->ReadOffset;
+    Scan = Available;
+    if ((Limit >= 0) && (Scan > Limit)) {
+        Scan = Limit;
+    }
+
+    //
+    // Skip the portion already known not to contain a newline.
+    //
+
+    NewLine = NULL;
+    if (Scan > Context->LineScan) {
+        NewLine = memchr(Current + Context->LineScan,
+                         '\n',
+                         Scan - Context->LineScan);
+    }
+
+    if (NewLine != NULL) {
+        Scan = NewLine + 1 - Current;
+
+    } else if ((Limit < 0) || (Scan < Limit)) {
+        Context->LineScan = Scan;
+        CkReturnNull(Vm);
+        return;
+    }
+
+    CkReturnString(Vm, (PCSTR)Current, Scan);
+    Context->ReadOffset += Scan;
+    Context->LineScan = 0;
+    return;
+}
+
+VOID
+CkpIoBufferFill (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends data read from the raw stream to the read buffer,
+    and advances the raw stream position by its length. Null is treated as an
+    empty string, as is returned by non-blocking streams. Returns the number
+    of bytes added.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Available;
+    PUCHAR Buffer;
+    UINTN Capacity;
+    PCK_IO_BUFFER Context;
+    PCSTR Data;
+    UINTN Length;
+
+    if (CkIsNull(Vm, 1)) {
+        CkReturnInteger(Vm, 0);
+        return;
+    }
+
+    if (!CkCheckArgument(Vm, 1, CkTypeString)) {
+        return;
+    }
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    Data = CkGetString(Vm, 1, &Length);
+    Available = CK_IO_READ_AVAILABLE(Context);
+
+    //
+    // Move any unconsumed data to the front of the buffer, and grow the
+    // buffer if the new data still doesn't fit.
+    //
+
+    if ((Available != 0) && (Context->ReadOffset != 0)) {
+        memmove(Context->ReadBuffer,
+                Context->ReadBuffer + Context->ReadOffset,
+                Available);
+    }
+
+    Context->ReadOffset = 0;
+    Context->ReadSize = Available;
+    if (Available + Length > Context->ReadCapacity) {
+        Capacity = Context->ReadCapacity * 2;
+        if (Capacity < Context->BufferSize) {
+            Capacity = Context->BufferSize;
+        }
+
+        if (Capacity < Available + Length) {
+            Capacity = Available + Length;
+        }
+
+        Buffer = realloc(Context->ReadBuffer, Capacity);
+        if (Buffer == NULL) {
+            CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+            return;
+        }
+
+        Context->ReadBuffer = Buffer;
+        Context->ReadCapacity = Capacity;
+    }
+
+    memcpy(Context->ReadBuffer + Available, Data, Length);
+    Context->ReadSize += Length;
+    Context->Position += Length;
+    CkReturnInteger(Vm, Length);
+    return;
+}
+
+VOID
+CkpIoBufferWrite (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends a string to the write buffer if it fits. Returns the
+    number of bytes buffered, or -1 if the data does not fit, in which case
+    the caller should write out the pending data and try again, or write the
+    data to the raw stream directly.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_IO_BUFFER Context;
+    PCSTR Data;
+    UINTN Length;
+
+    if (!CkCheckArgument(Vm, 1, CkTypeString)) {
+        return;
+    }
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    Data = CkGetString(Vm, 1, &Length);
+    if (Context->WriteSize + Length > Context->BufferSize) {
+        CkReturnInteger(Vm, -1);
+        return;
+    }
+
+    if (Context->WriteBuffer == NULL) {
+        Context->WriteBuffer = malloc(Context->BufferSize);
+        if (Context->WriteBuffer == NULL) {
+            CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+            return;
+        }
+    }
+
+    memcpy(Context->WriteBuffer + Context->WriteSize, Data, Length);
+    Context->WriteSize += Length;
+    CkReturnInteger(Vm, Length);
+    return;
+}
+
+VOID
+CkpIoBufferPending (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the dirty contents of the write buffer, without
+    removing them.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_IO_BUFFER Context;
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    CkReturnString(Vm, (PCSTR)(Context->WriteBuffer), Context->WriteSize);
+    return;
+}
+
+VOID
+CkpIoBufferWritten (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes the given number of bytes from the front of the write
+    buffer once they have been written to the raw stream, and advances the
+    raw stream position accordingly.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_IO_BUFFER Context;
+    CK_INTEGER Count;
+
+    if (!CkCheckArgument(Vm, 1, CkTypeInteger)) {
+        return;
+    }
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    Count = CkGetInteger(Vm, 1);
+    if ((Count < 0) || (Count > Context->WriteSize)) {
+        CkRaiseBasicException(Vm, "ValueError", "Invalid write count");
+        return;
+    }
+
+    Context->WriteSize -= Count;
+    if (Context->WriteSize != 0) {
+        memmove(Context->WriteBuffer,
+                Context->WriteBuffer + Count,
+                Context->WriteSize);
+    }
+
+    Context->Position += Count;
+    CkReturnNull(Vm);
+    return;
+}
+
+VOID
+CkpIoBufferFlushRead (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine discards the read buffer. It returns the number of bytes that
+    were read from the raw stream but not consumed, which the caller should
+    seek back over.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Available;
+    PCK_IO_BUFFER Context;
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    Available = CK_IO_READ_AVAILABLE(Context);
+    Context->ReadOffset = 0;
+    Context->ReadSize = 0;
+    Context->LineScan = 0;
+    Context->Position -= Available;
+    CkReturnInteger(Vm, Available);
+    return;
+}
+
+VOID
+CkpIoBufferAdvance (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine advances the raw stream position to account for data read
+    from or written to the raw stream without passing through the buffer.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_IO_BUFFER Context;
+
+    if (!CkCheckArgument(Vm, 1, CkTypeInteger)) {
+        return;
+    }
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    Context->Position += CkGetInteger(Vm, 1);
+    CkReturnNull(Vm);
+    return;
+}
+
+VOID
+CkpIoBufferTell (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the logical stream position, accounting for buffered
+    reads and writes.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_IO_BUFFER Context;
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    CkReturnInteger(Vm,
+                    Context->Position + Context->WriteSize -
+                    CK_IO_READ_AVAILABLE(Context));
+
+    return;
+}
+
+VOID
+CkpIoBufferSetPosition (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records the raw stream position after the caller has seeked
+    or truncated it directly. Both buffers should be flushed beforehand. It
+    returns the position passed in.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_IO_BUFFER Context;
+
+    if (!CkCheckArgument(Vm, 1, CkTypeInteger)) {
+        return;
+    }
+
+    Context = CkpIoGetContext(Vm);
+    if (Context == NULL) {
+        return;
+    }
+
+    assert((Context->WriteSize == 0) && (CK_IO_READ_AVAILABLE(Context) == 0));
+
+    Context->Position = CkGetInteger(Vm, 1);
+    Context->ReadOffset = 0;
+    Context->ReadSize = 0;
+    Context->LineScan = 0;
+    CkReturnInteger(Vm, Context->Position);
+    return;
+}
+
+PCK_IO_BUFFER
+CkpIoGetContext (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the IoBuffer context for the current receiver.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    Returns a pointer to the context on success.
+
+    NULL if the instance was never initialized. An exception will have been
+    raised.
+
+--*/
+
+{
+
+    PCK_IO_BUFFER Context;
+
+    CkGetField(Vm, CK_IO_FIELD_CONTEXT);
+    Context = CkGetData(Vm, -1);
+    CkStackPop(Vm);
+    if (Context == NULL) {
+        CkRaiseBasicException(Vm, "ValueError", "IoBuffer not initialized");
+    }
+
+    return Context;
+}
+
+VOID
+CkpIoDestroyContext (
+    PVOID Data
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called back when an IoBuffer instance is being destroyed.
+
+Arguments:
+
+    Data - Supplies a pointer to the class context to destroy.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_IO_BUFFER Context;
+
+    Context = Data;
+    if (Context->ReadBuffer != NULL) {
+        free(Context->ReadBuffer);
+    }
+
+    if (Context->WriteBuffer != NULL) {
+        free(Context->WriteBuffer);
+    }
+
+    free(Context);
+    return;
+}
+
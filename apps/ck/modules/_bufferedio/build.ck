@@ -0,0 +1,93 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    Buffered I/O Support Module
+
+Abstract:
+
+    This directory builds the native buffered I/O support module, which
+    implements the buffering behind the bufferedio module.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    C
+
+--*/
+
+from menv import compiledSources, group, staticLibrary;
+from apps.ck.modules.build import chalkSharedModule;
+
+function build() {
+    var commonSources;
+    var lib;
+    var entries;
+    var objs;
+
+    commonSources = [
+        "entry.c",
+        "bufferedio.c"
+    ];
+
+    //
+    // Create the static and dynamic versions of the module targeted at Minoca.
+    //
+
+    lib = {
+        "label": "_bufferedio_static",
+        "output": "_bufferedio",
+        "inputs": commonSources
+    };
+
+    objs = compiledSources(lib);
+    entries = staticLibrary(lib);
+    lib = {
+        "label": "_bufferedio_dynamic",
+        "output": "_bufferedio",
+        "inputs": objs[0]
+    };
+
+    entries += chalkSharedModule(lib);
+
+    //
+    // Create the static and dynamic versions of the module for the build
+    // machine.
+    //
+
+    lib = {
+        "label": "build__bufferedio_static",
+        "output": "_bufferedio",
+        "inputs": commonSources,
+        "build": true,
+        "prefix": "build"
+    };
+
+    objs = compiledSources(lib);
+    entries += staticLibrary(lib);
+    lib = {
+        "label": "build__bufferedio_dynamic",
+        "output": "_bufferedio",
+        "inputs": objs[0],
+        "build": true,
+        "prefix": "build"
+    };
+
+    entries += chalkSharedModule(lib);
+    entries += group("all", [":_bufferedio_static", ":_bufferedio_dynamic"]);
+    entries += group("build_all",
+                     [":build__bufferedio_static", ":build__bufferedio_dynamic"]);
+
+    return entries;
+}
+
@@ -0,0 +1,94 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    CPIO Support Module
+
+Abstract:
+
+    This directory builds the native CPIO support module, which accelerates
+    archive header parsing and moves member data in large blocks for the
+    cpio module.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    C
+
+--*/
+
+from menv import compiledSources, group, staticLibrary;
+from apps.ck.modules.build import chalkSharedModule;
+
+function build() {
+    var commonSources;
+    var lib;
+    var entries;
+    var objs;
+
+    commonSources = [
+        "entry.c",
+        "cpio.c"
+    ];
+
+    //
+    // Create the static and dynamic versions of the module targeted at Minoca.
+    //
+
+    lib = {
+        "label": "_cpio_static",
+        "output": "_cpio",
+        "inputs": commonSources
+    };
+
+    objs = compiledSources(lib);
+    entries = staticLibrary(lib);
+    lib = {
+        "label": "_cpio_dynamic",
+        "output": "_cpio",
+        "inputs": objs[0]
+    };
+
+    entries += chalkSharedModule(lib);
+
+    //
+    // Create the static and dynamic versions of the module for the build
+    // machine.
+    //
+
+    lib = {
+        "label": "build__cpio_static",
+        "output": "_cpio",
+        "inputs": commonSources,
+        "build": true,
+        "prefix": "build"
+    };
+
+    objs = compiledSources(lib);
+    entries += staticLibrary(lib);
+    lib = {
+        "label": "build__cpio_dynamic",
+        "output": "_cpio",
+        "inputs": objs[0],
+        "build": true,
+        "prefix": "build"
+    };
+
+    entries += chalkSharedModule(lib);
+    entries += group("all", [":_cpio_static", ":_cpio_dynamic"]);
+    entries += group("build_all",
+                     [":build__cpio_static", ":build__cpio_dynamic"]);
+
+    return entries;
+}
+
@@ -0,0 +1,642 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    cpio.c
+
+Abstract:
+
+    This module implements the native portions of the Chalk cpio module:
+    header decoding, checksumming, and bulk copies between descriptors.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Chalk
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+#include <io.h>
+
+#else
+
+#include <unistd.h>
+
+#endif
+
+#include "cpiop.h"
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// This macro reads a little endian 16-bit word out of a binary CPIO header.
+//
+
+#define CK_CPIO_READ16(_Header, _Index) \
+    ((_Header)[(_Index) * 2] | ((_Header)[((_Index) * 2) + 1] << 8))
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the size of the header that follows the magic field in each format.
+//
+
+#define CK_CPIO_BINARY_HEADER_SIZE 24
+#define CK_CPIO_ODC_HEADER_SIZE 70
+#define CK_CPIO_NEWC_HEADER_SIZE 104
+
+//
+// Define the number and width of the fields in a newc/crc header.
+//
+
+#define CK_CPIO_NEWC_FIELD_COUNT 13
+#define CK_CPIO_NEWC_FIELD_WIDTH 8
+
+//
+// Define the number of fields returned from a binary header.
+//
+
+#define CK_CPIO_BINARY_FIELD_COUNT 10
+
+//
+// Define the size of the buffer used to move data between descriptors.
+//
+
+#define CK_CPIO_COPY_SIZE (1024 * 256)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+CkpCpioParseAscii (
+    PCK_VM Vm
+    );
+
+VOID
+CkpCpioParseBinary (
+    PCK_VM Vm
+    );
+
+VOID
+CkpCpioSum (
+    PCK_VM Vm
+    );
+
+VOID
+CkpCpioCopy (
+    PCK_VM Vm
+    );
+
+BOOL
+CkpCpioParseNumber (
+    PCSTR String,
+    UINTN Length,
+    UINTN Base,
+    PCK_INTEGER Value
+    );
+
+VOID
+CkpCpioRaiseError (
+    PCK_VM Vm,
+    INT Error
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Define the field widths of the old portable ASCII (odc) header, in order:
+// dev, ino, mode, uid, gid, nlink, rdev, mtime, namesize, filesize.
+//
+
+const UCHAR CkCpioOdcFieldWidths[] = {6, 6, 6, 6, 6, 6, 6, 11, 6, 11};
+
+CK_VARIABLE_DESCRIPTION CkCpioModuleValues[] = {
+    {CkTypeFunction, "parseAscii", CkpCpioParseAscii, 2},
+    {CkTypeFunction, "parseBinary", CkpCpioParseBinary, 1},
+    {CkTypeFunction, "sum", CkpCpioSum, 1},
+    {CkTypeFunction, "copy", CkpCpioCopy, 3},
+    {CkTypeInvalid, NULL, NULL, 0}
+};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+BOOL
+CkPreloadCpioModule (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine preloads the _cpio module. It is called to make the presence
+    of the module known in cases where the module is statically linked.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    return CkPreloadForeignModule(Vm, "_cpio", NULL, NULL, CkpCpioModuleInit);
+}
+
+VOID
+CkpCpioModuleInit (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine populates the _cpio module namespace.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    CkDeclareVariables(Vm, 0, CkCpioModuleValues);
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+CkpCpioParseAscii (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine decodes the fields of an ASCII CPIO header. It takes the
+    header contents following the magic field and the format name. For the
+    "odc" format, it returns a list of the ten octal fields in header order.
+    For the "newc" and "crc" formats, it returns a list of the thirteen
+    hexadecimal fields in header order. If the header is the wrong size or
+    contains invalid digits, null is returned.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Base;
+    UINTN FieldCount;
+    PCSTR Format;
+    PCSTR Header;
+    UINTN HeaderSize;
+    UINTN Index;
+    UINTN Offset;
+    CK_INTEGER Value;
+    UINTN Width;
+
+    if (!CkCheckArguments(Vm, 2, CkTypeString, CkTypeString)) {
+        return;
+    }
+
+    Header = CkGetString(Vm, 1, &HeaderSize);
+    Format = CkGetString(Vm, 2, NULL);
+    if (strcmp(Format, "odc") == 0) {
+        if (HeaderSize != CK_CPIO_ODC_HEADER_SIZE) {
+            CkReturnNull(Vm);
+            return;
+        }
+
+        Base = 8;
+        FieldCount = sizeof(CkCpioOdcFieldWidths);
+
+    } else {
+        if (HeaderSize != CK_CPIO_NEWC_HEADER_SIZE) {
+            CkReturnNull(Vm);
+            return;
+        }
+
+        Base = 16;
+        FieldCount = CK_CPIO_NEWC_FIELD_COUNT;
+    }
+
+    CkPushList(Vm);
+    Offset = 0;
+    for (Index = 0; Index < FieldCount; Index += 1) {
+        if (Base == 8) {
+            Width = CkCpioOdcFieldWidths[Index];
+
+        } else {
+            Width = CK_CPIO_NEWC_FIELD_WIDTH;
+        }
+
+        if (CkpCpioParseNumber(Header + Offset, Width, Base, &Value) == FALSE) {
+            CkReturnNull(Vm);
+            return;
+        }
+
+        CkPushInteger(Vm, Value);
+        CkListSet(Vm, -2, Index);
+        Offset += Width;
+    }
+
+    CkStackReplace(Vm, 0);
+    return;
+}
+
+VOID
+CkpCpioParseBinary (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine decodes the fields of an old binary CPIO header. It takes the
+    24 header bytes following the magic field, and returns a list of the
+    values dev, ino, mode, uid, gid, nlink, rdev, mtime, namesize, and
+    filesize. Null is returned if the header is the wrong size.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    const UCHAR *Header;
+    UINTN HeaderSize;
+    UINTN Index;
+    CK_INTEGER Values[CK_CPIO_BINARY_FIELD_COUNT];
+
+    if (!CkCheckArguments(Vm, 1, CkTypeString)) {
+        return;
+    }
+
+    Header = (const UCHAR *)CkGetString(Vm, 1, &HeaderSize);
+    if (HeaderSize != CK_CPIO_BINARY_HEADER_SIZE) {
+        CkReturnNull(Vm);
+        return;
+    }
+
+    //
+    // The first seven fields are single 16-bit words. The modification time
+    // and file size are stored with the most significant word first.
+    //
+
+    for (Index = 0; Index < 7; Index += 1) {
+        Values[Index] = CK_CPIO_READ16(Header, Index);
+    }
+
+    Values[7] = ((CK_INTEGER)CK_CPIO_READ16(Header, 7) << 16) |
+                CK_CPIO_READ16(Header, 8);
+
+    Values[8] = CK_CPIO_READ16(Header, 9);
+    Values[9] = ((CK_INTEGER)CK_CPIO_READ16(Header, 10) << 16) |
+                CK_CPIO_READ16(Header, 11);
+
+    CkPushList(Vm);
+    for (Index = 0; Index < CK_CPIO_BINARY_FIELD_COUNT; Index += 1) {
+        CkPushInteger(Vm, Values[Index]);
+        CkListSet(Vm, -2, Index);
+    }
+
+    CkStackReplace(Vm, 0);
+    return;
+}
+
+VOID
+CkpCpioSum (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the sum of all the bytes in the given string, as used
+    by the "crc" format check field.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    const UCHAR *Data;
+    UINTN Index;
+    UINTN Length;
+    ULONGLONG Sum;
+
+    if (!CkCheckArguments(Vm, 1, CkTypeString)) {
+        return;
+    }
+
+    Data = (const UCHAR *)CkGetString(Vm, 1, &Length);
+    Sum = 0;
+    for (Index = 0; Index < Length; Index += 1) {
+        Sum += Data[Index];
+    }
+
+    CkReturnInteger(Vm, Sum);
+    return;
+}
+
+VOID
+CkpCpioCopy (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data from one OS file descriptor to another in large
+    blocks, without creating any intermediate strings. It takes the source
+    descriptor, the destination descriptor, and the number of bytes to copy.
+    The copy stops early if the source reaches end of file. Returns the
+    number of bytes copied.
+
+    Only descriptors are accepted: calling back into file objects from here
+    is not possible, since exceptions they raise cannot cross this foreign
+    function frame.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PSTR Buffer;
+    ssize_t BytesDone;
+    UINTN ChunkSize;
+    INT Destination;
+    UINTN Length;
+    CK_INTEGER Size;
+    INT Source;
+    CK_INTEGER Total;
+    UINTN Written;
+
+    if (!CkCheckArguments(Vm, 3, CkTypeInteger, CkTypeInteger, CkTypeInteger)) {
+        return;
+    }
+
+    Source = CkGetInteger(Vm, 1);
+    Destination = CkGetInteger(Vm, 2);
+    Size = CkGetInteger(Vm, 3);
+    Buffer = malloc(CK_CPIO_COPY_SIZE);
+    if (Buffer == NULL) {
+        CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+        return;
+    }
+
+    Total = 0;
+    while (Size > 0) {
+        ChunkSize = CK_CPIO_COPY_SIZE;
+        if (Size < ChunkSize) {
+            ChunkSize = Size;
+        }
+
+        do {
+            BytesDone = read(Source, Buffer, ChunkSize);
+
+        } while ((BytesDone < 0) && (errno == EINTR));
+
+        if (BytesDone < 0) {
+            CkpCpioRaiseError(Vm, errno);
+            goto CopyEnd;
+        }
+
+        if (BytesDone == 0) {
+            break;
+        }
+
+        Length = BytesDone;
+        Written = 0;
+        while (Written < Length) {
+            BytesDone = write(Destination, Buffer + Written, Length - Written);
+            if (BytesDone <= 0) {
+                if ((BytesDone < 0) && (errno == EINTR)) {
+                    continue;
+                }
+
+                if (BytesDone == 0) {
+                    errno = EIO;
+                }
+
+                CkpCpioRaiseError(Vm, errno);
+                goto CopyEnd;
+            }
+
+            Written += BytesDone;
+        }
+
+        Total += Length;
+        Size -= Length;
+    }
+
+    CkReturnInteger(Vm, Total);
+
+CopyEnd:
+    free(Buffer);
+    return;
+}
+
+BOOL
+CkpCpioParseNumber (
+    PCSTR String,
+    UINTN Length,
+    UINTN Base,
+    PCK_INTEGER Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts a fixed width field of octal or hexadecimal digits
+    into an integer.
+
+Arguments:
+
+    String - Supplies a pointer to the field.
+
+    Length - Supplies the width of the field in bytes.
+
+    Base - Supplies the base of the field, either 8 or 16.
+
+    Value - Supplies a pointer where the value will be returned on success.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the field contains an invalid digit.
+
+--*/
+
+{
+
+    CHAR Character;
+    UINTN Digit;
+    UINTN Index;
+    CK_INTEGER Result;
+
+    Result = 0;
+    for (Index = 0; Index < Length; Index += 1) {
+        Character = String[Index];
+        if ((Character >= '0') && (Character <= '9')) {
+            Digit = Character - '0';
+
+        } else if ((Character >= 'a') && (Character <= 'f')) {
+            Digit = Character - 'a' + 10;
+
+        } else if ((Character >= 'A') && (Character <= 'F')) {
+            Digit = Character - 'A' + 10;
+
+        } else {
+            return FALSE;
+        }
+
+        if (Digit >= Base) {
+            return FALSE;
+        }
+
+        Result = (Result * Base) + Digit;
+    }
+
+    *Value = Result;
+    return TRUE;
+}
+
+VOID
+CkpCpioRaiseError (
+    PCK_VM Vm,
+    INT Error
+    )
+
+/*++
+
+Routine Description:
+
+    This routine raises an OsError exception for the given error number.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Error - Supplies the errno value to raise.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCSTR ErrorString;
+
+    ErrorString = strerror(Error);
+
+    //
+    // Create an OsError exception.
+    //
+
+    CkPushModule(Vm, "os");
+    CkGetVariable(Vm, -1, "OsError");
+    CkPushString(Vm, ErrorString, strlen(ErrorString));
+    CkCall(Vm, 1);
+
+    //
+    // Execute instance.errno = Error.
+    //
+
+    CkPushValue(Vm, -1);
+    CkPushString(Vm, "errno", 5);
+    CkPushInteger(Vm, Error);
+    CkCallMethod(Vm, "__set", 2);
+    CkStackPop(Vm);
+
+    //
+    // Raise the exception.
+    //
+
+    CkRaiseException(Vm, -1);
+    return;
+}
+
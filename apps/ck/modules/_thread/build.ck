@@ -0,0 +1,113 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    Thread Support Module
+
+Abstract:
+
+    This directory builds the native thread support module, which runs Chalk
+    functions in separate VMs on their own OS threads.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    C
+
+--*/
+
+from menv import addConfig, compiledSources, group, mconfig, staticLibrary;
+from apps.ck.modules.build import chalkSharedModule;
+
+function build() {
+    var buildConfig;
+    var buildOs = mconfig.build_os;
+    var buildSources;
+    var commonSources;
+    var lib;
+    var entries;
+    var objs;
+    var posixSources;
+    var win32Sources;
+
+    commonSources = [
+        "entry.c",
+        "thread.c"
+    ];
+
+    posixSources = ["uos.c"];
+    win32Sources = ["win32.c"];
+
+    //
+    // Create the static and dynamic versions of the module targeted at Minoca.
+    //
+
+    lib = {
+        "label": "_thread_static",
+        "output": "_thread",
+        "inputs": commonSources + posixSources
+    };
+
+    objs = compiledSources(lib);
+    entries = staticLibrary(lib);
+    lib = {
+        "label": "_thread_dynamic",
+        "output": "_thread",
+        "inputs": objs[0]
+    };
+
+    entries += chalkSharedModule(lib);
+
+    //
+    // Create the static and dynamic versions of the module for the build
+    // machine. Pthreads live in the C library on Minoca, but may need to be
+    // linked in separately elsewhere.
+    //
+
+    buildConfig = {};
+    if (buildOs == "Windows") {
+        buildSources = commonSources + win32Sources;
+
+    } else {
+        buildSources = commonSources + posixSources;
+        if (buildOs != "Minoca") {
+            addConfig(buildConfig, "DYNLIBS", "-lpthread");
+        }
+    }
+
+    lib = {
+        "label": "build__thread_static",
+        "output": "_thread",
+        "inputs": buildSources,
+        "build": true,
+        "prefix": "build"
+    };
+
+    objs = compiledSources(lib);
+    entries += staticLibrary(lib);
+    lib = {
+        "label": "build__thread_dynamic",
+        "output": "_thread",
+        "inputs": objs[0],
+        "config": buildConfig,
+        "build": true,
+        "prefix": "build"
+    };
+
+    entries += chalkSharedModule(lib);
+    entries += group("all", [":_thread_static", ":_thread_dynamic"]);
+    entries += group("build_all",
+                     [":build__thread_static", ":build__thread_dynamic"]);
+
+    return entries;
+}
@@ -0,0 +1,1748 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    thread.c
+
+Abstract:
+
+    This module implements the native portion of Chalk thread support. Each
+    thread runs in its own Chalk VM, so no objects are ever shared. Values
+    passed between threads are copied into a flat message buffer by the
+    sender and rebuilt in the receiving VM.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    C
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threadp.h"
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the maximum nesting of lists and dicts that can be sent to another
+// thread. This also catches values that contain themselves.
+//
+
+#define CK_THREAD_MAX_DEPTH 64
+
+//
+// Define the initial size of a message buffer.
+//
+
+#define CK_MESSAGE_INITIAL_CAPACITY 64
+
+//
+// Define the type tags that precede each value in a message.
+//
+
+#define CK_MESSAGE_NULL 0
+#define CK_MESSAGE_INTEGER 1
+#define CK_MESSAGE_STRING 2
+#define CK_MESSAGE_LIST 3
+#define CK_MESSAGE_DICT 4
+
+//
+// Define the source run by each new thread VM, which finds the real entry
+// point and reports its result.
+//
+
+#define CK_THREAD_BOOTSTRAP "import thread;\n(thread._workerMain)();\n"
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores a copied value on its way between two VMs.
+
+Members:
+
+    Next - Stores a pointer to the next message in a channel queue.
+
+    Data - Stores a pointer to the flattened value.
+
+    Size - Stores the number of valid bytes in the data buffer.
+
+    Capacity - Stores the allocated size of the data buffer.
+
+--*/
+
+typedef struct _CK_MESSAGE CK_MESSAGE, *PCK_MESSAGE;
+struct _CK_MESSAGE {
+    PCK_MESSAGE Next;
+    PUCHAR Data;
+    UINTN Size;
+    UINTN Capacity;
+};
+
+/*++
+
+Structure Description:
+
+    This structure stores a channel, which is a queue of messages that can be
+    shared by several VMs. Each VM holding the channel owns a reference.
+
+Members:
+
+    Lock - Stores a pointer to the lock protecting the channel.
+
+    Condition - Stores a pointer to the condition variable signaled when a
+        message arrives or the channel is closed.
+
+    ReferenceCount - Stores the number of references on the channel. This is
+        protected by the lock.
+
+    Head - Stores a pointer to the oldest message in the queue.
+
+    Tail - Stores a pointer to the newest message in the queue.
+
+    Closed - Stores a boolean indicating whether the channel has been closed.
+        No new messages can be sent to a closed channel, but messages already
+        queued can still be received.
+
+--*/
+
+typedef struct _CK_CHANNEL {
+    PVOID Lock;
+    PVOID Condition;
+    ULONG ReferenceCount;
+    PCK_MESSAGE Head;
+    PCK_MESSAGE Tail;
+    BOOL Closed;
+} CK_CHANNEL, *PCK_CHANNEL;
+
+/*++
+
+Structure Description:
+
+    This structure stores the state of a thread running in a separate VM. It
+    is owned by the VM that started it, and is not freed until the thread has
+    been joined.
+
+Members:
+
+    Handle - Stores the OS thread handle.
+
+    Job - Stores the module name, function name, and arguments for the
+        thread, copied one after the other.
+
+    ModulePath - Stores a copy of the starting VM's module search path.
+
+    Channels - Stores an array of channels handed to the thread.
+
+    ChannelCount - Stores the number of elements in the channels array.
+
+    Result - Stores the copied return value of the thread function.
+
+    Error - Stores an optional string describing why the thread failed.
+
+    Joined - Stores a boolean indicating whether the thread has been joined.
+
+--*/
+
+typedef struct _CK_THREAD {
+    PVOID Handle;
+    PCK_MESSAGE Job;
+    PCK_MESSAGE ModulePath;
+    PCK_CHANNEL *Channels;
+    UINTN ChannelCount;
+    PCK_MESSAGE Result;
+    PSTR Error;
+    BOOL Joined;
+} CK_THREAD, *PCK_THREAD;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+CkpThreadCreateChannel (
+    PCK_VM Vm
+    );
+
+VOID
+CkpThreadSend (
+    PCK_VM Vm
+    );
+
+VOID
+CkpThreadReceive (
+    PCK_VM Vm
+    );
+
+VOID
+CkpThreadCloseChannel (
+    PCK_VM Vm
+    );
+
+VOID
+CkpThreadStart (
+    PCK_VM Vm
+    );
+
+VOID
+CkpThreadJoin (
+    PCK_VM Vm
+    );
+
+VOID
+CkpThreadGetJob (
+    PCK_VM Vm
+    );
+
+VOID
+CkpThreadFinish (
+    PCK_VM Vm
+    );
+
+VOID
+CkpThreadFail (
+    PCK_VM Vm
+    );
+
+VOID
+CkpThreadMain (
+    PVOID Context
+    );
+
+VOID
+CkpThreadDestroy (
+    PVOID Data
+    );
+
+PCK_CHANNEL
+CkpChannelCreate (
+    VOID
+    );
+
+VOID
+CkpChannelAddReference (
+    PCK_CHANNEL Channel
+    );
+
+VOID
+CkpChannelRelease (
+    PVOID Data
+    );
+
+PCK_CHANNEL
+CkpThreadGetChannel (
+    PCK_VM Vm,
+    INTN StackIndex
+    );
+
+PCK_MESSAGE
+CkpMessageCreate (
+    VOID
+    );
+
+VOID
+CkpMessageDestroy (
+    PCK_MESSAGE Message
+    );
+
+BOOL
+CkpMessageAppend (
+    PCK_MESSAGE Message,
+    PCVOID Data,
+    UINTN Size
+    );
+
+BOOL
+CkpMessageFreeze (
+    PCK_VM Vm,
+    INTN StackIndex,
+    PCK_MESSAGE Message,
+    ULONG Depth
+    );
+
+BOOL
+CkpMessageThaw (
+    PCK_VM Vm,
+    PCK_MESSAGE Message,
+    PUINTN Offset,
+    ULONG Depth
+    );
+
+BOOL
+CkpMessageRead (
+    PCK_MESSAGE Message,
+    PUINTN Offset,
+    PVOID Buffer,
+    UINTN Size
+    );
+
+VOID
+CkpThreadRaiseError (
+    PCK_VM Vm,
+    PCSTR ExceptionType,
+    PCSTR Message
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+CK_VARIABLE_DESCRIPTION CkThreadModuleValues[] = {
+    {CkTypeFunction, "channel", CkpThreadCreateChannel, 0},
+    {CkTypeFunction, "send", CkpThreadSend, 2},
+    {CkTypeFunction, "receive", CkpThreadReceive, 1},
+    {CkTypeFunction, "close", CkpThreadCloseChannel, 1},
+    {CkTypeFunction, "start", CkpThreadStart, 4},
+    {CkTypeFunction, "join", CkpThreadJoin, 1},
+    {CkTypeFunction, "job", CkpThreadGetJob, 0},
+    {CkTypeFunction, "finish", CkpThreadFinish, 1},
+    {CkTypeFunction, "fail", CkpThreadFail, 1},
+    {CkTypeInvalid, NULL, NULL, 0}
+};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+BOOL
+CkPreloadThreadModule (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine preloads the _thread module. It is called to make the
+    presence of the module known in cases where the module is statically
+    linked, and for the VMs of new threads.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    return CkPreloadForeignModule(Vm,
+                                  "_thread",
+                                  NULL,
+                                  NULL,
+                                  CkpThreadModuleInit);
+}
+
+VOID
+CkpThreadModuleInit (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine populates the _thread module namespace.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    CkPushString(Vm, "ThreadError", 11);
+    CkGetVariable(Vm, 0, "Exception");
+    CkPushClass(Vm, 0, 0);
+    CkSetVariable(Vm, 0, "ThreadError");
+    CkPushString(Vm, "ChannelClosed", 13);
+    CkGetVariable(Vm, 0, "Exception");
+    CkPushClass(Vm, 0, 0);
+    CkSetVariable(Vm, 0, "ChannelClosed");
+
+    //
+    // Register the functions and definitions.
+    //
+
+    CkDeclareVariables(Vm, 0, CkThreadModuleValues);
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+CkpThreadCreateChannel (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new channel. It takes no arguments, and returns
+    an opaque channel handle.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_CHANNEL Channel;
+
+    Channel = CkpChannelCreate();
+    if (Channel == NULL) {
+        CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+        return;
+    }
+
+    if (CkPushData(Vm, Channel, CkpChannelRelease) == FALSE) {
+        CkpChannelRelease(Channel);
+        return;
+    }
+
+    CkStackReplace(Vm, 0);
+    return;
+}
+
+VOID
+CkpThreadSend (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies a value into a channel. It takes a channel handle and
+    the value to send, and returns nothing. Sending never blocks.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_CHANNEL Channel;
+    PCK_MESSAGE Message;
+
+    Channel = CkpThreadGetChannel(Vm, 1);
+    if (Channel == NULL) {
+        return;
+    }
+
+    Message = CkpMessageCreate();
+    if (Message == NULL) {
+        CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+        return;
+    }
+
+    if (!CkpMessageFreeze(Vm, 2, Message, 0)) {
+        CkpMessageDestroy(Message);
+        return;
+    }
+
+    CkpOsAcquireLock(Channel->Lock);
+    if (Channel->Closed != FALSE) {
+        CkpOsReleaseLock(Channel->Lock);
+        CkpMessageDestroy(Message);
+        CkpThreadRaiseError(Vm, "ChannelClosed", "Channel is closed");
+        return;
+    }
+
+    if (Channel->Tail == NULL) {
+        Channel->Head = Message;
+
+    } else {
+        Channel->Tail->Next = Message;
+    }
+
+    Channel->Tail = Message;
+    CkpOsSignalCondition(Channel->Condition, FALSE);
+    CkpOsReleaseLock(Channel->Lock);
+    CkReturnNull(Vm);
+    return;
+}
+
+VOID
+CkpThreadReceive (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes the oldest value from a channel, blocking until one
+    is available. It takes a channel handle, and returns the received value.
+    If the channel is closed and empty, ChannelClosed is raised.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_CHANNEL Channel;
+    PCK_MESSAGE Message;
+    UINTN Offset;
+
+    Channel = CkpThreadGetChannel(Vm, 1);
+    if (Channel == NULL) {
+        return;
+    }
+
+    CkpOsAcquireLock(Channel->Lock);
+    while ((Channel->Head == NULL) && (Channel->Closed == FALSE)) {
+        CkpOsWaitCondition(Channel->Condition, Channel->Lock);
+    }
+
+    Message = Channel->Head;
+    if (Message != NULL) {
+        Channel->Head = Message->Next;
+        if (Channel->Head == NULL) {
+            Channel->Tail = NULL;
+        }
+    }
+
+    CkpOsReleaseLock(Channel->Lock);
+    if (Message == NULL) {
+        CkpThreadRaiseError(Vm, "ChannelClosed", "Channel is closed");
+        return;
+    }
+
+    Offset = 0;
+    if (!CkpMessageThaw(Vm, Message, &Offset, 0)) {
+        CkpMessageDestroy(Message);
+        CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+        return;
+    }
+
+    CkpMessageDestroy(Message);
+    CkStackReplace(Vm, 0);
+    return;
+}
+
+VOID
+CkpThreadCloseChannel (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine closes a channel, waking everyone waiting to receive from it.
+    It takes a channel handle, and returns nothing.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_CHANNEL Channel;
+
+    Channel = CkpThreadGetChannel(Vm, 1);
+    if (Channel == NULL) {
+        return;
+    }
+
+    CkpOsAcquireLock(Channel->Lock);
+    Channel->Closed = TRUE;
+    CkpOsSignalCondition(Channel->Condition, TRUE);
+    CkpOsReleaseLock(Channel->Lock);
+    CkReturnNull(Vm);
+    return;
+}
+
+VOID
+CkpThreadStart (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts a new thread running in its own VM. It takes the name
+    of the module to import, the name of the function in that module to call,
+    a list of arguments to copy to the function, and a list of channel handles
+    to share with the new thread. It returns an opaque thread handle.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_CHANNEL Channel;
+    UINTN Count;
+    UINTN Index;
+    INT Status;
+    PCK_THREAD Thread;
+
+    if (!CkCheckArguments(Vm,
+                          4,
+                          CkTypeString,
+                          CkTypeString,
+                          CkTypeList,
+                          CkTypeList)) {
+
+        return;
+    }
+
+    Thread = calloc(1, sizeof(CK_THREAD));
+    if (Thread == NULL) {
+        CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+        return;
+    }
+
+    //
+    // Wrap the thread right away so that the garbage collector cleans up if
+    // anything below fails.
+    //
+
+    if (CkPushData(Vm, Thread, CkpThreadDestroy) == FALSE) {
+        free(Thread);
+        return;
+    }
+
+    Thread->Job = CkpMessageCreate();
+    Thread->ModulePath = CkpMessageCreate();
+    Count = CkListSize(Vm, 4);
+    if (Count != 0) {
+        Thread->Channels = malloc(Count * sizeof(PCK_CHANNEL));
+    }
+
+    if ((Thread->Job == NULL) || (Thread->ModulePath == NULL) ||
+        ((Count != 0) && (Thread->Channels == NULL))) {
+
+        CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+        return;
+    }
+
+    for (Index = 1; Index <= 3; Index += 1) {
+        if (!CkpMessageFreeze(Vm, Index, Thread->Job, 0)) {
+            return;
+        }
+    }
+
+    //
+    // Copy the module path so the new VM can find the same modules.
+    //
+
+    CkPushModulePath(Vm);
+    if (!CkpMessageFreeze(Vm, -1, Thread->ModulePath, 0)) {
+        return;
+    }
+
+    CkStackPop(Vm);
+    for (Index = 0; Index < Count; Index += 1) {
+        CkListGet(Vm, 4, Index);
+        Channel = CkpThreadGetChannel(Vm, -1);
+        if (Channel == NULL) {
+            return;
+        }
+
+        CkStackPop(Vm);
+        CkpChannelAddReference(Channel);
+        Thread->Channels[Index] = Channel;
+        Thread->ChannelCount += 1;
+    }
+
+    Status = CkpOsCreateThread(CkpThreadMain, Thread, &(Thread->Handle));
+    if (Status != 0) {
+        Thread->Handle = NULL;
+        CkpThreadRaiseError(Vm, "ThreadError", strerror(Status));
+        return;
+    }
+
+    CkStackReplace(Vm, 0);
+    return;
+}
+
+VOID
+CkpThreadJoin (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for a thread to finish. It takes a thread handle, and
+    returns the value returned by the thread function. If the thread function
+    raised an exception, a ThreadError is raised here describing it.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Offset;
+    PCK_THREAD Thread;
+
+    Thread = CkGetData(Vm, 1);
+    if (Thread == NULL) {
+        CkRaiseBasicException(Vm, "TypeError", "Expected a thread handle");
+        return;
+    }
+
+    if (Thread->Joined == FALSE) {
+        CkpOsJoinThread(Thread->Handle);
+        Thread->Joined = TRUE;
+    }
+
+    if (Thread->Error != NULL) {
+        CkpThreadRaiseError(Vm, "ThreadError", Thread->Error);
+        return;
+    }
+
+    if (Thread->Result == NULL) {
+        CkReturnNull(Vm);
+        return;
+    }
+
+    Offset = 0;
+    if (!CkpMessageThaw(Vm, Thread->Result, &Offset, 0)) {
+        CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+        return;
+    }
+
+    CkStackReplace(Vm, 0);
+    return;
+}
+
+VOID
+CkpThreadGetJob (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the work assigned to the current thread. It takes no
+    arguments, and returns a list of the module name, function name, argument
+    list, and list of channel handles. It can only be called from the VM of a
+    thread started by this module.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_CHANNEL Channel;
+    UINTN Index;
+    UINTN Offset;
+    PCK_THREAD Thread;
+
+    Thread = CkGetContext(Vm);
+    if (Thread == NULL) {
+        CkpThreadRaiseError(Vm, "ThreadError", "Not a worker thread");
+        return;
+    }
+
+    if (!CkEnsureStack(Vm, 3)) {
+        return;
+    }
+
+    CkPushList(Vm);
+    Offset = 0;
+    for (Index = 0; Index < 3; Index += 1) {
+        if (!CkpMessageThaw(Vm, Thread->Job, &Offset, 0)) {
+            CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+            return;
+        }
+
+        CkListSet(Vm, -2, Index);
+    }
+
+    CkPushList(Vm);
+    for (Index = 0; Index < Thread->ChannelCount; Index += 1) {
+        Channel = Thread->Channels[Index];
+        if (CkPushData(Vm, Channel, CkpChannelRelease) == FALSE) {
+            return;
+        }
+
+        CkpChannelAddReference(Channel);
+        CkListSet(Vm, -2, Index);
+    }
+
+    CkListSet(Vm, -2, 3);
+    CkStackReplace(Vm, 0);
+    return;
+}
+
+VOID
+CkpThreadFinish (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets the result of the current thread. It takes the value to
+    copy back to whoever joins the thread, and returns nothing.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_MESSAGE Message;
+    PCK_THREAD Thread;
+
+    Thread = CkGetContext(Vm);
+    if (Thread == NULL) {
+        CkpThreadRaiseError(Vm, "ThreadError", "Not a worker thread");
+        return;
+    }
+
+    Message = CkpMessageCreate();
+    if (Message == NULL) {
+        CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+        return;
+    }
+
+    if (!CkpMessageFreeze(Vm, 1, Message, 0)) {
+        CkpMessageDestroy(Message);
+        return;
+    }
+
+    if (Thread->Result != NULL) {
+        CkpMessageDestroy(Thread->Result);
+    }
+
+    Thread->Result = Message;
+    CkReturnNull(Vm);
+    return;
+}
+
+VOID
+CkpThreadFail (
+    PCK_VM Vm
+    )
+
+/*++
+
+Routine Description:
+
+    This routine marks the current thread as failed. It takes a string
+    describing the failure, which is raised as a ThreadError in whoever joins
+    the thread. It returns nothing.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCSTR Error;
+    PCK_THREAD Thread;
+
+    if (!CkCheckArguments(Vm, 1, CkTypeString)) {
+        return;
+    }
+
+    Thread = CkGetContext(Vm);
+    if (Thread == NULL) {
+        CkpThreadRaiseError(Vm, "ThreadError", "Not a worker thread");
+        return;
+    }
+
+    Error = CkGetString(Vm, 1, NULL);
+    if (Thread->Error != NULL) {
+        free(Thread->Error);
+    }
+
+    Thread->Error = strdup(Error);
+    if (Thread->Error == NULL) {
+        CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+        return;
+    }
+
+    CkReturnNull(Vm);
+    return;
+}
+
+VOID
+CkpThreadMain (
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the entry point of a new thread. It creates a
+    fresh VM and runs the thread function inside it.
+
+Arguments:
+
+    Context - Supplies a pointer to the thread structure.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    CK_CONFIGURATION Configuration;
+    UINTN Count;
+    UINTN Index;
+    UINTN Offset;
+    CK_ERROR_TYPE Status;
+    PCK_THREAD Thread;
+    PCK_VM Vm;
+
+    Thread = Context;
+    CkInitializeConfiguration(&Configuration);
+    Vm = CkCreateVm(&Configuration);
+    if (Vm == NULL) {
+        Thread->Error = strdup("Failed to create VM");
+        return;
+    }
+
+    CkSetContext(Vm, Thread);
+    if ((!CkPreloadThreadModule(Vm)) || (!CkEnsureStack(Vm, 3))) {
+        Thread->Error = strdup("Failed to initialize VM");
+        goto ThreadMainEnd;
+    }
+
+    //
+    // Replace the default module path with the one from the parent.
+    //
+
+    CkPushModulePath(Vm);
+    Offset = 0;
+    if (!CkpMessageThaw(Vm, Thread->ModulePath, &Offset, 0)) {
+        Thread->Error = strdup("Failed to initialize VM");
+        goto ThreadMainEnd;
+    }
+
+    Count = CkListSize(Vm, -1);
+    for (Index = 0; Index < Count; Index += 1) {
+        CkListGet(Vm, -1, Index);
+        CkListSet(Vm, -3, Index);
+    }
+
+    CkStackPop(Vm);
+    CkStackPop(Vm);
+    Status = CkInterpret(Vm,
+                         NULL,
+                         CK_THREAD_BOOTSTRAP,
+                         sizeof(CK_THREAD_BOOTSTRAP) - 1,
+                         1,
+                         FALSE);
+
+    if ((Status != CkSuccess) && (Thread->Error == NULL)) {
+        Thread->Error = strdup("Thread failed to run");
+    }
+
+ThreadMainEnd:
+    CkDestroyVm(Vm);
+    return;
+}
+
+VOID
+CkpThreadDestroy (
+    PVOID Data
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when a thread handle is garbage collected. If the
+    thread was never joined, this waits for it, since the thread may be
+    running code from this module.
+
+Arguments:
+
+    Data - Supplies a pointer to the thread structure.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Index;
+    PCK_THREAD Thread;
+
+    Thread = Data;
+    if ((Thread->Handle != NULL) && (Thread->Joined == FALSE)) {
+        CkpOsJoinThread(Thread->Handle);
+    }
+
+    for (Index = 0; Index < Thread->ChannelCount; Index += 1) {
+        CkpChannelRelease(Thread->Channels[Index]);
+    }
+
+    if (Thread->Channels != NULL) {
+        free(Thread->Channels);
+    }
+
+    if (Thread->Job != NULL) {
+        CkpMessageDestroy(Thread->Job);
+    }
+
+    if (Thread->ModulePath != NULL) {
+        CkpMessageDestroy(Thread->ModulePath);
+    }
+
+    if (Thread->Result != NULL) {
+        CkpMessageDestroy(Thread->Result);
+    }
+
+    if (Thread->Error != NULL) {
+        free(Thread->Error);
+    }
+
+    free(Thread);
+    return;
+}
+
+PCK_CHANNEL
+CkpChannelCreate (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new empty channel with a single reference.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a pointer to the new channel on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    PCK_CHANNEL Channel;
+
+    Channel = calloc(1, sizeof(CK_CHANNEL));
+    if (Channel == NULL) {
+        return NULL;
+    }
+
+    Channel->ReferenceCount = 1;
+    Channel->Lock = CkpOsCreateLock();
+    Channel->Condition = CkpOsCreateCondition();
+    if ((Channel->Lock == NULL) || (Channel->Condition == NULL)) {
+        CkpChannelRelease(Channel);
+        return NULL;
+    }
+
+    return Channel;
+}
+
+VOID
+CkpChannelAddReference (
+    PCK_CHANNEL Channel
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a reference to a channel.
+
+Arguments:
+
+    Channel - Supplies a pointer to the channel.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    CkpOsAcquireLock(Channel->Lock);
+    Channel->ReferenceCount += 1;
+    CkpOsReleaseLock(Channel->Lock);
+    return;
+}
+
+VOID
+CkpChannelRelease (
+    PVOID Data
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases a reference on a channel, destroying it if that was
+    the last reference. This is also the destroy routine for channel handles.
+
+Arguments:
+
+    Data - Supplies a pointer to the channel.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PCK_CHANNEL Channel;
+    PCK_MESSAGE Message;
+    ULONG ReferenceCount;
+
+    Channel = Data;
+    if (Channel->Lock != NULL) {
+        CkpOsAcquireLock(Channel->Lock);
+        Channel->ReferenceCount -= 1;
+        ReferenceCount = Channel->ReferenceCount;
+        CkpOsReleaseLock(Channel->Lock);
+        if (ReferenceCount != 0) {
+            return;
+        }
+
+        CkpOsDestroyLock(Channel->Lock);
+    }
+
+    if (Channel->Condition != NULL) {
+        CkpOsDestroyCondition(Channel->Condition);
+    }
+
+    while (Channel->Head != NULL) {
+        Message = Channel->Head;
+        Channel->Head = Message->Next;
+        CkpMessageDestroy(Message);
+    }
+
+    free(Channel);
+    return;
+}
+
+PCK_CHANNEL
+CkpThreadGetChannel (
+    PCK_VM Vm,
+    INTN StackIndex
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gets the channel from a channel handle on the stack, raising
+    an exception if the value is not a channel handle.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    StackIndex - Supplies the stack index of the channel handle.
+
+Return Value:
+
+    Returns a pointer to the channel on success.
+
+    NULL if an exception was raised.
+
+--*/
+
+{
+
+    PCK_CHANNEL Channel;
+
+    Channel = CkGetData(Vm, StackIndex);
+    if (Channel == NULL) {
+        CkRaiseBasicException(Vm, "TypeError", "Expected a channel handle");
+    }
+
+    return Channel;
+}
+
+PCK_MESSAGE
+CkpMessageCreate (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new empty message.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a pointer to the message on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    PCK_MESSAGE Message;
+
+    Message = calloc(1, sizeof(CK_MESSAGE));
+    if (Message == NULL) {
+        return NULL;
+    }
+
+    Message->Data = malloc(CK_MESSAGE_INITIAL_CAPACITY);
+    if (Message->Data == NULL) {
+        free(Message);
+        return NULL;
+    }
+
+    Message->Capacity = CK_MESSAGE_INITIAL_CAPACITY;
+    return Message;
+}
+
+VOID
+CkpMessageDestroy (
+    PCK_MESSAGE Message
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys a message.
+
+Arguments:
+
+    Message - Supplies a pointer to the message.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    free(Message->Data);
+    free(Message);
+    return;
+}
+
+BOOL
+CkpMessageAppend (
+    PCK_MESSAGE Message,
+    PCVOID Data,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends bytes to a message, growing it if needed.
+
+Arguments:
+
+    Message - Supplies a pointer to the message.
+
+    Data - Supplies a pointer to the bytes to append.
+
+    Size - Supplies the number of bytes to append.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on allocation failure.
+
+--*/
+
+{
+
+    UINTN NewCapacity;
+    PUCHAR NewData;
+
+    if (Message->Size + Size > Message->Capacity) {
+        NewCapacity = Message->Capacity * 2;
+        while (NewCapacity < Message->Size + Size) {
+            NewCapacity *= 2;
+        }
+
+        NewData = realloc(Message->Data, NewCapacity);
+        if (NewData == NULL) {
+            return FALSE;
+        }
+
+        Message->Data = NewData;
+        Message->Capacity = NewCapacity;
+    }
+
+    memcpy(Message->Data + Message->Size, Data, Size);
+    Message->Size += Size;
+    return TRUE;
+}
+
+BOOL
+CkpMessageFreeze (
+    PCK_VM Vm,
+    INTN StackIndex,
+    PCK_MESSAGE Message,
+    ULONG Depth
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies a value into a message. Only null, integers, strings,
+    and lists and dicts of those can be copied. Everything else belongs to the
+    VM it was created in.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    StackIndex - Supplies the stack index of the value to copy.
+
+    Message - Supplies a pointer to the message to append to.
+
+    Depth - Supplies the current container nesting depth.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if an exception was raised.
+
+--*/
+
+{
+
+    UINTN Count;
+    UINTN Index;
+    CK_INTEGER Integer;
+    UINTN Length;
+    PCSTR String;
+    UCHAR Tag;
+
+    if (StackIndex < 0) {
+        StackIndex += CkGetStackSize(Vm);
+    }
+
+    switch (CkGetType(Vm, StackIndex)) {
+    case CkTypeNull:
+        Tag = CK_MESSAGE_NULL;
+        if (!CkpMessageAppend(Message, &Tag, sizeof(Tag))) {
+            goto MessageFreezeAllocationFailure;
+        }
+
+        break;
+
+    case CkTypeInteger:
+        Tag = CK_MESSAGE_INTEGER;
+        Integer = CkGetInteger(Vm, StackIndex);
+        if ((!CkpMessageAppend(Message, &Tag, sizeof(Tag))) ||
+            (!CkpMessageAppend(Message, &Integer, sizeof(Integer)))) {
+
+            goto MessageFreezeAllocationFailure;
+        }
+
+        break;
+
+    case CkTypeString:
+        Tag = CK_MESSAGE_STRING;
+        String = CkGetString(Vm, StackIndex, &Length);
+        if ((!CkpMessageAppend(Message, &Tag, sizeof(Tag))) ||
+            (!CkpMessageAppend(Message, &Length, sizeof(Length))) ||
+            (!CkpMessageAppend(Message, String, Length))) {
+
+            goto MessageFreezeAllocationFailure;
+        }
+
+        break;
+
+    case CkTypeList:
+    case CkTypeDict:
+        if (Depth >= CK_THREAD_MAX_DEPTH) {
+            CkRaiseBasicException(Vm,
+                                  "ValueError",
+                                  "Value is nested too deeply to send");
+
+            return FALSE;
+        }
+
+        if (!CkEnsureStack(Vm, 3)) {
+            return FALSE;
+        }
+
+        if (CkGetType(Vm, StackIndex) == CkTypeList) {
+            Tag = CK_MESSAGE_LIST;
+            Count = CkListSize(Vm, StackIndex);
+
+        } else {
+            Tag = CK_MESSAGE_DICT;
+            Count = CkDictSize(Vm, StackIndex);
+        }
+
+        if ((!CkpMessageAppend(Message, &Tag, sizeof(Tag))) ||
+            (!CkpMessageAppend(Message, &Count, sizeof(Count)))) {
+
+            goto MessageFreezeAllocationFailure;
+        }
+
+        if (Tag == CK_MESSAGE_LIST) {
+            for (Index = 0; Index < Count; Index += 1) {
+                CkListGet(Vm, StackIndex, Index);
+                if (!CkpMessageFreeze(Vm, -1, Message, Depth + 1)) {
+                    return FALSE;
+                }
+
+                CkStackPop(Vm);
+            }
+
+            break;
+        }
+
+        //
+        // Store each value before its key, which is the order the dict set
+        // function wants them in when the message is thawed.
+        //
+
+        CkPushNull(Vm);
+        while (CkDictIterate(Vm, StackIndex)) {
+            if ((!CkpMessageFreeze(Vm, -1, Message, Depth + 1)) ||
+                (!CkpMessageFreeze(Vm, -2, Message, Depth + 1))) {
+
+                return FALSE;
+            }
+
+            CkStackPop(Vm);
+            CkStackPop(Vm);
+        }
+
+        CkStackPop(Vm);
+        break;
+
+    default:
+        CkRaiseBasicException(Vm,
+                              "TypeError",
+                              "Only null, integers, strings, lists, and dicts "
+                              "can be sent between threads");
+
+        return FALSE;
+    }
+
+    return TRUE;
+
+MessageFreezeAllocationFailure:
+    CkRaiseBasicException(Vm, "MemoryError", "Allocation failure");
+    return FALSE;
+}
+
+BOOL
+CkpMessageThaw (
+    PCK_VM Vm,
+    PCK_MESSAGE Message,
+    PUINTN Offset,
+    ULONG Depth
+    )
+
+/*++
+
+Routine Description:
+
+    This routine rebuilds a value copied into a message, and pushes it onto
+    the stack.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Message - Supplies a pointer to the message.
+
+    Offset - Supplies a pointer that on input contains the offset of the
+        value within the message. On output, this is advanced past the value.
+
+    Depth - Supplies the current container nesting depth.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on failure.
+
+--*/
+
+{
+
+    UINTN Count;
+    UINTN Index;
+    CK_INTEGER Integer;
+    UINTN Length;
+    UCHAR Tag;
+
+    if (!CkpMessageRead(Message, Offset, &Tag, sizeof(Tag))) {
+        return FALSE;
+    }
+
+    switch (Tag) {
+    case CK_MESSAGE_NULL:
+        CkPushNull(Vm);
+        break;
+
+    case CK_MESSAGE_INTEGER:
+        if (!CkpMessageRead(Message, Offset, &Integer, sizeof(Integer))) {
+            return FALSE;
+        }
+
+        CkPushInteger(Vm, Integer);
+        break;
+
+    case CK_MESSAGE_STRING:
+        if ((!CkpMessageRead(Message, Offset, &Length, sizeof(Length))) ||
+            (Length > Message->Size - *Offset)) {
+
+            return FALSE;
+        }
+
+        CkPushString(Vm, (PCSTR)(Message->Data + *Offset), Length);
+        *Offset += Length;
+        break;
+
+    case CK_MESSAGE_LIST:
+    case CK_MESSAGE_DICT:
+        if ((Depth >= CK_THREAD_MAX_DEPTH) ||
+            (!CkpMessageRead(Message, Offset, &Count, sizeof(Count))) ||
+            (!CkEnsureStack(Vm, 3))) {
+
+            return FALSE;
+        }
+
+        if (Tag == CK_MESSAGE_LIST) {
+            CkPushList(Vm);
+            for (Index = 0; Index < Count; Index += 1) {
+                if (!CkpMessageThaw(Vm, Message, Offset, Depth + 1)) {
+                    return FALSE;
+                }
+
+                CkListSet(Vm, -2, Index);
+            }
+
+        } else {
+            CkPushDict(Vm);
+            for (Index = 0; Index < Count; Index += 1) {
+                if ((!CkpMessageThaw(Vm, Message, Offset, Depth + 1)) ||
+                    (!CkpMessageThaw(Vm, Message, Offset, Depth + 1))) {
+
+                    return FALSE;
+                }
+
+                CkDictSet(Vm, -3);
+            }
+        }
+
+        break;
+
+    default:
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOL
+CkpMessageRead (
+    PCK_MESSAGE Message,
+    PUINTN Offset,
+    PVOID Buffer,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads bytes out of a message.
+
+Arguments:
+
+    Message - Supplies a pointer to the message.
+
+    Offset - Supplies a pointer that on input contains the offset to read
+        from. On output, this is advanced past the bytes read.
+
+    Buffer - Supplies a pointer where the bytes will be returned.
+
+    Size - Supplies the number of bytes to read.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE if the message is too short.
+
+--*/
+
+{
+
+    if (Size > Message->Size - *Offset) {
+        return FALSE;
+    }
+
+    memcpy(Buffer, Message->Data + *Offset, Size);
+    *Offset += Size;
+    return TRUE;
+}
+
+VOID
+CkpThreadRaiseError (
+    PCK_VM Vm,
+    PCSTR ExceptionType,
+    PCSTR Message
+    )
+
+/*++
+
+Routine Description:
+
+    This routine raises an exception defined by this module.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    ExceptionType - Supplies the name of the exception class to raise.
+
+    Message - Supplies the message to raise with the exception.
+
+Return Value:
+
+    None. The foreign function should return as soon as possible and not
+    manipulate the Chalk stack any longer.
+
+--*/
+
+{
+
+    CkPushModule(Vm, "_thread");
+    CkGetVariable(Vm, -1, ExceptionType);
+    CkPushString(Vm, Message, strlen(Message));
+    CkCall(Vm, 1);
+    CkRaiseException(Vm, -1);
+    return;
+}
+
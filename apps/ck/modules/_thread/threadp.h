@@ -0,0 +1,333 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    threadp.h
+
+Abstract:
+
+    This header contains definitions for the Chalk thread support module.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/lib/types.h>
+#include <minoca/lib/chalk.h>
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef
+VOID
+(*PCK_THREAD_ROUTINE) (
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is the entry point for a new OS thread.
+
+Arguments:
+
+    Context - Supplies the context pointer passed when the thread was created.
+
+Return Value:
+
+    None.
+
+--*/
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+//
+// Generic thread module functions
+//
+
+VOID
+CkpThreadModuleInit (
+    PCK_VM Vm
+    );
+
+/*++
+
+Routine Description:
+
+    This routine populates the _thread module namespace.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+//
+// OS-specific functions
+//
+
+PVOID
+CkpOsCreateLock (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new mutual exclusion lock.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a pointer to the lock on success.
+
+    NULL on allocation failure.
+
+--*/
+
+VOID
+CkpOsDestroyLock (
+    PVOID Lock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine destroys a lock. The lock must not be held.
+
+Arguments:
+
+    Lock - Supplies a pointer to the lock.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+CkpOsAcquireLock (
+    PVOID Lock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine acquires a lock, blocking until it is available.
+
+Arguments:
+
+    Lock - Supplies a pointer to the lock.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+CkpOsReleaseLock (
+    PVOID Lock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine releases a lock held by the current thread.
+
+Arguments:
+
+    Lock - Supplies a pointer to the lock.
+
+Return Value:
+
+    None.
+
+--*/
+
+PVOID
+CkpOsCreateCondition (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new condition variable.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a pointer to the condition variable on success.
+
+    NULL on allocation failure.
+
+--*/
+
+VOID
+CkpOsDestroyCondition (
+    PVOID Condition
+    );
+
+/*++
+
+Routine Description:
+
+    This routine destroys a condition variable. There must be no waiters.
+
+Arguments:
+
+    Condition - Supplies a pointer to the condition variable.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+CkpOsWaitCondition (
+    PVOID Condition,
+    PVOID Lock
+    );
+
+/*++
+
+Routine Description:
+
+    This routine atomically releases the given lock and waits for the
+    condition to be signaled, then reacquires the lock. Spurious wakeups are
+    possible, so callers must recheck their predicate.
+
+Arguments:
+
+    Condition - Supplies a pointer to the condition variable.
+
+    Lock - Supplies a pointer to the lock, which must be held by the caller.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+CkpOsSignalCondition (
+    PVOID Condition,
+    BOOL Broadcast
+    );
+
+/*++
+
+Routine Description:
+
+    This routine wakes threads waiting on the given condition.
+
+Arguments:
+
+    Condition - Supplies a pointer to the condition variable.
+
+    Broadcast - Supplies a boolean indicating whether to wake all waiters
+        (TRUE) or just one (FALSE).
+
+Return Value:
+
+    None.
+
+--*/
+
+INT
+CkpOsCreateThread (
+    PCK_THREAD_ROUTINE Routine,
+    PVOID Context,
+    PVOID *Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new OS thread.
+
+Arguments:
+
+    Routine - Supplies a pointer to the routine to run on the new thread.
+
+    Context - Supplies the context pointer to pass to the routine.
+
+    Handle - Supplies a pointer where the thread handle will be returned on
+        success. This must eventually be passed to the join function.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+VOID
+CkpOsJoinThread (
+    PVOID Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine waits for a thread to exit and releases its handle.
+
+Arguments:
+
+    Handle - Supplies the thread handle returned when the thread was created.
+
+Return Value:
+
+    None.
+
+--*/
+
@@ -0,0 +1,471 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    uos.c
+
+Abstract:
+
+    This module implements POSIX support for the Chalk thread module.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    POSIX
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "threadp.h"
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores the information needed to start a POSIX thread. The
+    new thread frees it once it is running.
+
+Members:
+
+    Routine - Stores the routine to run on the new thread.
+
+    Context - Stores the context pointer to pass to the routine.
+
+--*/
+
+typedef struct _CK_POSIX_THREAD_START {
+    PCK_THREAD_ROUTINE Routine;
+    PVOID Context;
+} CK_POSIX_THREAD_START, *PCK_POSIX_THREAD_START;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+void *
+CkpOsThreadStart (
+    void *Parameter
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+PVOID
+CkpOsCreateLock (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new mutual exclusion lock.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a pointer to the lock on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    pthread_mutex_t *Lock;
+
+    Lock = malloc(sizeof(pthread_mutex_t));
+    if (Lock == NULL) {
+        return NULL;
+    }
+
+    if (pthread_mutex_init(Lock, NULL) != 0) {
+        free(Lock);
+        return NULL;
+    }
+
+    return Lock;
+}
+
+VOID
+CkpOsDestroyLock (
+    PVOID Lock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys a lock. The lock must not be held.
+
+Arguments:
+
+    Lock - Supplies a pointer to the lock.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    pthread_mutex_destroy(Lock);
+    free(Lock);
+    return;
+}
+
+VOID
+CkpOsAcquireLock (
+    PVOID Lock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine acquires a lock, blocking until it is available.
+
+Arguments:
+
+    Lock - Supplies a pointer to the lock.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    pthread_mutex_lock(Lock);
+    return;
+}
+
+VOID
+CkpOsReleaseLock (
+    PVOID Lock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases a lock held by the current thread.
+
+Arguments:
+
+    Lock - Supplies a pointer to the lock.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    pthread_mutex_unlock(Lock);
+    return;
+}
+
+PVOID
+CkpOsCreateCondition (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new condition variable.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a pointer to the condition variable on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    pthread_cond_t *Condition;
+
+    Condition = malloc(sizeof(pthread_cond_t));
+    if (Condition == NULL) {
+        return NULL;
+    }
+
+    if (pthread_cond_init(Condition, NULL) != 0) {
+        free(Condition);
+        return NULL;
+    }
+
+    return Condition;
+}
+
+VOID
+CkpOsDestroyCondition (
+    PVOID Condition
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys a condition variable. There must be no waiters.
+
+Arguments:
+
+    Condition - Supplies a pointer to the condition variable.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    pthread_cond_destroy(Condition);
+    free(Condition);
+    return;
+}
+
+VOID
+CkpOsWaitCondition (
+    PVOID Condition,
+    PVOID Lock
+    )
+
+/*++
+
+Routine Description:
+
+    This routine atomically releases the given lock and waits for the
+    condition to be signaled, then reacquires the lock. Spurious wakeups are
+    possible, so callers must recheck their predicate.
+
+Arguments:
+
+    Condition - Supplies a pointer to the condition variable.
+
+    Lock - Supplies a pointer to the lock, which must be held by the caller.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    pthread_cond_wait(Condition, Lock);
+    return;
+}
+
+VOID
+CkpOsSignalCondition (
+    PVOID Condition,
+    BOOL Broadcast
+    )
+
+/*++
+
+Routine Description:
+
+    This routine wakes threads waiting on the given condition.
+
+Arguments:
+
+    Condition - Supplies a pointer to the condition variable.
+
+    Broadcast - Supplies a boolean indicating whether to wake all waiters
+        (TRUE) or just one (FALSE).
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (Broadcast != FALSE) {
+        pthread_cond_broadcast(Condition);
+
+    } else {
+        pthread_cond_signal(Condition);
+    }
+
+    return;
+}
+
+INT
+CkpOsCreateThread (
+    PCK_THREAD_ROUTINE Routine,
+    PVOID Context,
+    PVOID *Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new OS thread.
+
+Arguments:
+
+    Routine - Supplies a pointer to the routine to run on the new thread.
+
+    Context - Supplies the context pointer to pass to the routine.
+
+    Handle - Supplies a pointer where the thread handle will be returned on
+        success. This must eventually be passed to the join function.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    PCK_POSIX_THREAD_START Start;
+    INT Status;
+    pthread_t *Thread;
+
+    Thread = malloc(sizeof(pthread_t));
+    Start = malloc(sizeof(CK_POSIX_THREAD_START));
+    if ((Thread == NULL) || (Start == NULL)) {
+        free(Thread);
+        free(Start);
+        return ENOMEM;
+    }
+
+    Start->Routine = Routine;
+    Start->Context = Context;
+    Status = pthread_create(Thread, NULL, CkpOsThreadStart, Start);
+    if (Status != 0) {
+        free(Thread);
+        free(Start);
+        return Status;
+    }
+
+    *Handle = Thread;
+    return 0;
+}
+
+VOID
+CkpOsJoinThread (
+    PVOID Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for a thread to exit and releases its handle.
+
+Arguments:
+
+    Handle - Supplies the thread handle returned when the thread was created.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    pthread_join(*((pthread_t *)Handle), NULL);
+    free(Handle);
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+void *
+CkpOsThreadStart (
+    void *Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the POSIX thread entry point. It calls out to the real
+    thread routine.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the thread start information, which is
+        freed by this routine.
+
+Return Value:
+
+    NULL always.
+
+--*/
+
+{
+
+    PVOID Context;
+    PCK_THREAD_ROUTINE Routine;
+    PCK_POSIX_THREAD_START Start;
+
+    Start = Parameter;
+    Routine = Start->Routine;
+    Context = Start->Context;
+    free(Start);
+    Routine(Context);
+    return NULL;
+}
+
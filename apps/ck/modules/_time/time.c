@@ -434,15 +434,24 @@ Return Value:
 {
 
     time_t Time;
-    struct tm *TimeFields;
+    struct tm TimeFields;
 
     if (!CkCheckArguments(Vm, 1, CkTypeInteger)) {
         return;
     }
 
+    //
+    // Use the reentrant version, as other threads may be running their own
+    // VMs.
+    //
+
     Time = CkGetInteger(Vm, 1);
-    TimeFields = gmtime(&Time);
-    CkpTmToDict(Vm, TimeFields);
+    if (gmtime_r(&Time, &TimeFields) == NULL) {
+        CkpTimeRaiseError(Vm);
+        return;
+    }
+
+    CkpTmToDict(Vm, &TimeFields);
     CkStackReplace(Vm, 0);
     return;
 }
@@ -473,15 +482,24 @@ Return Value:
 {
 
     time_t Time;
-    struct tm *TimeFields;
+    struct tm TimeFields;
 
     if (!CkCheckArguments(Vm, 1, CkTypeInteger)) {
         return;
     }
 
+    //
+    // Use the reentrant version, as other threads may be running their own
+    // VMs.
+    //
+
     Time = CkGetInteger(Vm, 1);
-    TimeFields = localtime(&Time);
-    CkpTmToDict(Vm, TimeFields);
+    if (localtime_r(&Time, &TimeFields) == NULL) {
+        CkpTimeRaiseError(Vm);
+        return;
+    }
+
+    CkpTmToDict(Vm, &TimeFields);
     CkStackReplace(Vm, 0);
     return;
 }
@@ -29,6 +29,17 @@ Module Name:
 // --------------------------------------------------------------------- Macros
 //
 
+//
+// Windows has the reentrant time conversion functions, but with the
+// arguments swapped and an error code returned.
+//
+
+#define gmtime_r(_Time, _Result) \
+    ((gmtime_s((_Result), (_Time)) == 0) ? (_Result) : NULL)
+
+#define localtime_r(_Time, _Result) \
+    ((localtime_s((_Result), (_Time)) == 0) ? (_Result) : NULL)
+
 //
 // ---------------------------------------------------------------- Definitions
 //
@@ -14,7 +14,8 @@ Module Name:
 Abstract:
 
     This module implements support for performing buffered file I/O. It's
-    inspired by Python's buffered I/O classes.
+    inspired by Python's buffered I/O classes. The buffers themselves live in
+    the native _bufferedio module.
 
 Author:
 
@@ -31,6 +32,7 @@ Module Name:
 //
 
 from iobase import BufferedIoBase, IoError, DEFAULT_BUFFER_SIZE, IO_SEEK_CUR;
+from _bufferedio import IoBuffer;
 
 //
 // ---------------------------------------------------------------- Definitions
@@ -57,12 +59,8 @@ class BufferedIo is BufferedIoBase {
     var _raw;
     var _readable;
     var _writable;
-    var _position;
     var _bufferSize;
-    var _readBuffer;
-    var _readOffset;
-    var _writeBuffers;
-    var _writeSize;
+    var _buffer;
 
     function
     __init (
@@ -103,11 +101,7 @@ class BufferedIo is BufferedIoBase {
         _bufferSize = bufferSize;
         _readable = _raw.isReadable();
         _writable = _raw.isWritable();
-        _position = 0;
-        _readBuffer = "";
-        _readOffset = 0;
-        _writeBuffers = [];
-        _writeSize = 0;
+        _buffer = IoBuffer(bufferSize);
         return this;
     }
 
@@ -172,9 +166,6 @@ class BufferedIo is BufferedIoBase {
 
     {
 
-        var data;
-        var existingLength;
-        var readData;
         var readSize;
         var result;
 
@@ -182,23 +173,20 @@ class BufferedIo is BufferedIoBase {
             this._flushWrite();
         }
 
-        existingLength = _readBuffer.length() - _readOffset;
-        if (size <= 0) {
-            if (existingLength > 0) {
-                size = existingLength;
-
-            } else {
-                size = _bufferSize;
-            }
-        }
-
         //
         // See if the request can be satisfied completely from the buffer.
         //
 
-        if (existingLength >= size) {
-            data = _readBuffer[_readOffset..(_readOffset + size)];
-            return data;
+        result = _buffer.peek(size);
+        if (size <= 0) {
+            if (result.length()) {
+                return result;
+            }
+
+            size = _bufferSize;
+
+        } else if (result.length() >= size) {
+            return result;
         }
 
         //
@@ -206,16 +194,13 @@ class BufferedIo is BufferedIoBase {
         // to try and read the whole buffer.
         //
 
-        readSize = size - existingLength;
+        readSize = size - result.length();
         if (readSize < _bufferSize) {
             readSize = _bufferSize;
         }
 
-        readData = _raw.read(readSize);
-        _position += readData.length();
-        _readBuffer = _readBuffer[_readOffset...-1] + readData;
-        _readOffset = 0;
-        return _readBuffer[0..size];
+        _buffer.fill(_raw.read(readSize));
+        return _buffer.peek(size);
     }
 
     function
@@ -243,11 +228,6 @@ class BufferedIo is BufferedIoBase {
 
     {
 
-        var data;
-        var existingLength;
-        var length = 0;
-        var result;
-
         if (size < -1) {
             Core.raise(ValueError("Size must be positive or -1"));
         }
@@ -256,6 +236,10 @@ class BufferedIo is BufferedIoBase {
             return this.readall();
         }
 
+        var data;
+        var length;
+        var result;
+
         if (_writable) {
             this._flushWrite();
         }
@@ -265,31 +249,20 @@ class BufferedIo is BufferedIoBase {
         // that's needed.
         //
 
-        existingLength = _readBuffer.length() - _readOffset;
-        if (existingLength > size) {
-            result = _readBuffer[_readOffset..(_readOffset + size)];
-            _readOffset += size;
-            return result;
+        data = _buffer.read(size);
+        length = data.length();
+        if (length == size) {
+            return data;
         }
 
-        //
-        // Wipe out the remaining buffer, and start a list of buffers that
-        // represents the result.
-        //
-
-        data = _readBuffer[_readOffset...-1];
-        length = data.length();
+        size -= length;
         if (length) {
-            size -= length;
             result = [data];
 
         } else {
             result = [];
         }
 
-        _readBuffer = "";
-        _readOffset = 0;
-
         //
         // Read directly into the result if huge amounts are requested.
         //
@@ -302,7 +275,7 @@ class BufferedIo is BufferedIoBase {
                 break;
             }
 
-            _position += length;
+            _buffer.advance(length);
             result.append(data);
             size -= length;
         }
@@ -313,22 +286,13 @@ class BufferedIo is BufferedIoBase {
 
         if (length != 0) {
             while (size != 0) {
-                _readBuffer = _raw.read(_bufferSize);
-                length = _readBuffer.length();
-                if (!length) {
+                if (!_buffer.fill(_raw.read(_bufferSize))) {
                     break;
                 }
 
-                _position += length;
-                if (size <= length) {
-                    result.append(_readBuffer[0..size]);
-                    _readOffset = size;
-                    break;
-
-                } else {
-                    result.append(_readBuffer);
-                    size -= length;
-                }
+                data = _buffer.read(size);
+                result.append(data);
+                size -= data.length();
             }
         }
 
@@ -360,15 +324,14 @@ class BufferedIo is BufferedIoBase {
 
     {
 
-        var data;
-        var existingLength;
-        var length = 0;
-        var result;
-
         if (size < 0) {
             Core.raise(ValueError("Size must be positive"));
         }
 
+        var data;
+        var length;
+        var result;
+
         if (_writable) {
             this._flushWrite();
         }
@@ -378,29 +341,13 @@ class BufferedIo is BufferedIoBase {
         // that's needed.
         //
 
-        existingLength = _readBuffer.length() - _readOffset;
-        if (existingLength > size) {
-            result = _readBuffer[_readOffset..(_readOffset + size)];
-            _readOffset += size;
-            return result;
-        }
-
-        //
-        // Wipe out the remaining buffer, and start a list of buffers that
-        // represents the result.
-        //
-
-        data = _readBuffer[_readOffset...-1];
-        if (length) {
-            size -= existingLength;
-            result = [data];
-
-        } else {
-            result = [];
+        data = _buffer.read(size);
+        length = data.length();
+        if (length == size) {
+            return data;
         }
 
-        _readBuffer = "";
-        _readOffset = 0;
+        size -= length;
 
         //
         // If the caller just wants a little, refill the buffer. Otherwise,
@@ -408,25 +355,13 @@ class BufferedIo is BufferedIoBase {
         //
 
         if (size < _bufferSize) {
-            _readBuffer = _raw.read(_bufferSize);
-            length = _readBuffer.length();
-            if (length) {
-                _position += length;
-                if (size > length) {
-                    size = length;
-                }
-
-                _readOffset = size;
-                result.append(_readBuffer[0..size]);
-            }
-
-        } else {
-            data = _raw.read(size);
-            result.append(data);
-            _position += data.length();
+            _buffer.fill(_raw.read(_bufferSize));
+            return data + _buffer.read(size);
         }
 
-        return "".joinList(result);
+        result = _raw.read(size);
+        _buffer.advance(result.length());
+        return data + result;
     }
 
     function
@@ -453,72 +388,29 @@ class BufferedIo is BufferedIoBase {
 
     {
 
-        var data;
-        var index;
-        var length;
-        var result;
+        var line;
 
         if (_writable) {
             this._flushWrite();
         }
 
         //
-        // Clip the buffer so that indexOf doesn't find something already found.
-        //
-
-        if (_readOffset) {
-            _readBuffer = _readBuffer[_readOffset...-1];
-            _readOffset = 0;
-        }
-
-        //
-        // See if the buffer already contains a complete line.
-        //
-
-        index = _readBuffer.indexOf("\n");
-        if (index != -1) {
-            result = _readBuffer[_readOffset...index];
-            _readOffset = index + 1;
-            return result;
-        }
-
-        //
-        // Pull the whole buffer into the result.
-        //
-
-        if (_readBuffer.length()) {
-            data = _readBuffer[_readOffset...-1];
-            result = [data];
-            _readBuffer = "";
-            _readOffset = 0;
-
-        } else {
-            result = [];
-        }
-
-        //
-        // Loop reading blocks until a newline or EOF is found.
+        // Keep adding blocks to the buffer until it contains a complete line,
+        // or the end of the file is found.
         //
 
         while (true) {
-            _readBuffer = _raw.read(_bufferSize);
-            length = _readBuffer.length();
-            if (!length) {
-                break;
+            line = _buffer.readline(limit);
+            if (line != null) {
+                return line;
             }
 
-            _position += length;
-            index = _readBuffer.indexOf("\n");
-            if (index != -1) {
-                result.append(_readBuffer[0...index]);
-                _readOffset = index + 1;
+            if (!_buffer.fill(_raw.read(_bufferSize))) {
                 break;
             }
-
-            result.append(_readBuffer);
         }
 
-        return "".join(result);
+        return _buffer.read(limit);
     }
 
     function
@@ -543,7 +435,7 @@ class BufferedIo is BufferedIoBase {
 
     {
 
-        return _position + _writeSize - (_readBuffer.length() - _readOffset);
+        return _buffer.tell();
     }
 
     function
@@ -575,8 +467,7 @@ class BufferedIo is BufferedIoBase {
     {
 
         this.flush();
-        _position = _raw.seek(offset, whence);
-        return _position;
+        return _buffer.setPosition(_raw.seek(offset, whence));
     }
 
     function
@@ -607,7 +498,7 @@ class BufferedIo is BufferedIoBase {
 
         this.flush();
         result = _raw.truncate(size);
-        _position = _raw.tell();
+        _buffer.setPosition(_raw.tell());
         return result;
     }
 
@@ -634,25 +525,20 @@ class BufferedIo is BufferedIoBase {
     {
 
         var data;
-        var existingLength;
         var result;
 
         if (_writable) {
             this._flushWrite();
         }
 
-        existingLength = _readBuffer.length() - _readOffset;
-        if (!existingLength) {
-            result = _raw.readall();
-            _position += result.length();
-            return result;
+        result = _buffer.read(-1);
+        data = _raw.readall();
+        _buffer.advance(data.length());
+        if (!result.length()) {
+            return data;
         }
 
-        result = [_readBuffer[_readOffset...-1]];
-        data = _raw.readall();
-        _position += data.length();
-        result.append(data);
-        return "".join(result);
+        return result + data;
     }
 
     function
@@ -679,9 +565,6 @@ class BufferedIo is BufferedIoBase {
 
     {
 
-        var length = data.length();
-        var result = 0;
-
         if (_raw.isClosed()) {
             Core.raise(ValueError("I/O operation on closed file"));
         }
@@ -690,28 +573,29 @@ class BufferedIo is BufferedIoBase {
             Core.raise(ValueError("File not open for writing"));
         }
 
+        if (!(data is String)) {
+            Core.raise(TypeError("Expected a string"));
+        }
+
+        var result;
+
         if (_readable) {
             this._flushRead();
         }
 
-        if (length > _bufferSize) {
-            this._flushWrite();
-            result = _raw.write(data);
-            _position += result;
+        result = _buffer.write(data);
+        if (result >= 0) {
             return result;
         }
 
-        if (!(data is String)) {
-            Core.raise(TypeError("Expected a string"));
-        }
-
-        _writeBuffers.append(data);
-        _writeSize += length;
-        if (_writeSize > _bufferSize) {
-            this._flushWrite();
+        this._flushWrite();
+        if (data.length() > _bufferSize) {
+            result = _raw.write(data);
+            _buffer.advance(result);
+            return result;
         }
 
-        return length;
+        return _buffer.write(data);
     }
 
     //
@@ -945,14 +829,12 @@ class BufferedIo is BufferedIoBase {
 
     {
 
-        var readLength;
+        var length;
 
         if (_readable) {
-            readLength = _readBuffer.length() - _readOffset;
-            if (readLength) {
-                _position = _raw.seek(-readLength, IO_SEEK_CUR);
-                _readBuffer = "";
-                _readOffset = 0;
+            length = _buffer.flushRead();
+            if (length) {
+                _buffer.setPosition(_raw.seek(-length, IO_SEEK_CUR));
             }
         }
 
@@ -981,21 +863,17 @@ class BufferedIo is BufferedIoBase {
 
     {
 
-        var data = "".join(_writeBuffers);
-        var length = data.length();
-        var written;
+        var data = _buffer.pending();
+        var length;
 
-        _writeBuffers = [];
-        _writeSize = 0;
-        while (length) {
-            written = _raw.write(data);
-            if (written <= 0) {
+        while (data.length()) {
+            length = _raw.write(data);
+            if (length <= 0) {
                 Core.raise(IoError("Unable to write"));
             }
 
-            _position += written;
-            data = data[written...-1];
-            length = data.length();
+            _buffer.written(length);
+            data = data[length...-1];
         }
 
         return;
@@ -70,10 +70,14 @@ function build() {
         "io.ck",
         "iobase.ck",
         "lzfile.ck",
+        "thread.ck",
         "time.ck"
     ];
 
     foreignModules = [
+        "_bufferedio",
+        "_cpio",
+        "_thread",
         "_time",
         "app",
         "bundle",
@@ -29,8 +29,11 @@ Module Name:
 // ------------------------------------------------------------------- Includes
 //
 
+import _cpio;
+from bufferedio import BufferedIo;
+from fileio import FileIo;
 from iobase import IoError;
-from io import IO_SEEK_SET, IO_SEEK_CUR, IO_SEEK_END, open;
+from io import IO_SEEK_SET, IO_SEEK_CUR, IO_SEEK_END, open, open2;
 import os;
 from time import Time;
 
@@ -59,6 +62,13 @@ var CPIO_MODE_PERMISSIONS = 00000777;
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+function
+_copyData (
+    source,
+    destination,
+    size
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -652,45 +662,35 @@ class CpioMember {
 
     {
 
-        var bytes = [];
         var data = file.read(24);
+        var fields;
         var nameSize;
         var totalSize;
 
-        if (data.length() != 24) {
-            Core.raise(CpioFormatError("Header truncated"));
-        }
-
         //
-        // Convert all the bytes to numbers.
+        // Convert the fields to numbers. For the modification time and size,
+        // the most significant 16 bits are stored first. Each 16-bit word is
+        // stored in native endian order.
         //
 
-        for (index in 0..24) {
-            bytes.append(data.byteAt(index));
+        fields = (_cpio.parseBinary)(data);
+        if (fields == null) {
+            Core.raise(CpioFormatError("Header truncated"));
         }
 
         this.format = format;
         this.devMajor = 0;
-        this.devMinor = bytes[0] + (bytes[1] << 8);
-        this.inode = bytes[2] + (bytes[3] << 8);
-        this.mode = bytes[4] + (bytes[5] << 8);
-        this.uid = bytes[6] + (bytes[7] << 8);
-        this.gid = bytes[8] + (bytes[9] << 8);
-        this.nlink = bytes[10] + (bytes[11] << 8);
+        this.devMinor = fields[0];
+        this.inode = fields[1];
+        this.mode = fields[2];
+        this.uid = fields[3];
+        this.gid = fields[4];
+        this.nlink = fields[5];
         this.rdevMajor = 0;
-        this.rdevMinor = bytes[12] + (bytes[13] << 8);
-
-        //
-        // For the modification time, the most significant 16 bits are stored
-        // first. Each 16-bit word is stored in native endian order.
-        //
-
-        this.mtime = ((bytes[14] + (bytes[15] << 8)) << 16) +
-                     bytes[16] + (bytes[17] << 8);
-
-        nameSize = bytes[18] + (bytes[19] << 8);
-        this.size = ((bytes[20] + (bytes[21] << 8)) << 16) +
-                    bytes[22] + (bytes[23] << 8);
+        this.rdevMinor = fields[6];
+        this.mtime = fields[7];
+        nameSize = fields[8];
+        this.size = fields[9];
 
         //
         // The name size includes a null terminating byte. If the name size is
@@ -742,44 +742,43 @@ class CpioMember {
 
     {
 
-        var check;
-        var devMajor = "0";
-        var devMinor;
-        var fileSize;
-        var gid;
+        var fields;
         var header;
         var headerSize;
-        var inode;
-        var mode;
-        var mtime;
         var nameSize;
-        var nlink;
-        var prefix;
-        var rdevMajor = "0";
-        var rdevMinor;
         var remainder;
         var totalSize;
-        var uid;
 
         if (format == "odc") {
-            prefix = "0";
             headerSize = 76;
             header = file.read(70);
             if (header.length() != 70) {
                 Core.raise(CpioFormatError("Header truncated"));
             }
 
-            devMinor = header[0..6];
-            inode = header[6..12];
-            mode = header[12..18];
-            uid = header[18..24];
-            gid = header[24..30];
-            nlink = header[30..36];
-            rdevMinor = header[36..42];
-            mtime = header[42..53];
-            nameSize = header[53..59];
-            fileSize = header[59..70];
-            nameSize = Int.fromString(prefix + nameSize);
+            //
+            // The odc fields are dev, ino, mode, uid, gid, nlink, rdev, mtime,
+            // namesize, and filesize, all in octal.
+            //
+
+            fields = (_cpio.parseAscii)(header, format);
+            if (fields == null) {
+                Core.raise(CpioFormatError("Invalid header"));
+            }
+
+            this.devMajor = 0;
+            this.devMinor = fields[0];
+            this.inode = fields[1];
+            this.mode = fields[2];
+            this.uid = fields[3];
+            this.gid = fields[4];
+            this.nlink = fields[5];
+            this.rdevMajor = 0;
+            this.rdevMinor = fields[6];
+            this.mtime = fields[7];
+            nameSize = fields[8];
+            this.size = fields[9];
+            this.check = -1;
             headerSize += nameSize;
 
             //
@@ -789,27 +788,42 @@ class CpioMember {
             remainder = 0;
 
         } else {
-            prefix = "0x";
             headerSize = 110;
             header = file.read(104);
             if (header.length() != 104) {
                 Core.raise(CpioFormatError("Header truncated"));
             }
 
-            inode = header[0..8];
-            mode = header[8..16];
-            uid = header[16..24];
-            gid = header[24..32];
-            nlink = header[32..40];
-            mtime = header[40..48];
-            fileSize = header[48..56];
-            devMajor = header[56..64];
-            devMinor = header[64..72];
-            rdevMajor = header[72..80];
-            rdevMinor = header[80..88];
-            nameSize = header[88..96];
-            check = header[96..104];
-            nameSize = Int.fromString(prefix + nameSize);
+            //
+            // The newc fields are ino, mode, uid, gid, nlink, mtime, filesize,
+            // devmajor, devminor, rdevmajor, rdevminor, namesize, and check,
+            // all in hex.
+            //
+
+            fields = (_cpio.parseAscii)(header, format);
+            if (fields == null) {
+                Core.raise(CpioFormatError("Invalid header"));
+            }
+
+            this.inode = fields[0];
+            this.mode = fields[1];
+            this.uid = fields[2];
+            this.gid = fields[3];
+            this.nlink = fields[4];
+            this.mtime = fields[5];
+            this.size = fields[6];
+            this.devMajor = fields[7];
+            this.devMinor = fields[8];
+            this.rdevMajor = fields[9];
+            this.rdevMinor = fields[10];
+            nameSize = fields[11];
+            if (format == "crc") {
+                this.check = fields[12];
+
+            } else {
+                this.check = -1;
+            }
+
             headerSize += nameSize;
 
             //
@@ -821,24 +835,6 @@ class CpioMember {
         }
 
         this.format = format;
-        this.inode = Int.fromString(prefix + inode);
-        this.mode = Int.fromString(prefix + mode);
-        this.uid = Int.fromString(prefix + uid);
-        this.gid = Int.fromString(prefix + gid);
-        this.nlink = Int.fromString(prefix + nlink);
-        this.mtime = Int.fromString(prefix + mtime);
-        this.size = Int.fromString(prefix + fileSize);
-        this.devMajor = Int.fromString(prefix + devMajor);
-        this.devMinor = Int.fromString(prefix + devMinor);
-        this.rdevMajor = Int.fromString(prefix + rdevMajor);
-        this.rdevMinor = Int.fromString(prefix + rdevMinor);
-        if ((check != null) && (format == "crc")) {
-            this.check = Int.fromString(prefix + check);
-
-        } else {
-            this.check = -1;
-        }
-
         this.name = file.read(nameSize)[0..-1];
         if (this.name.length() != nameSize - 1) {
             Core.raise(CpioFormatError("File name truncated"));
@@ -1247,19 +1243,8 @@ class CpioMember {
 
     {
 
-        var chunk;
-        var chunkSize;
-        var maxChunkSize = 131072;
-
-        while (size != 0) {
-            chunkSize = (size < maxChunkSize) ? size : maxChunkSize;
-            chunk = inFile.read(chunkSize);
-            if (chunk.length() != chunkSize) {
-                Core.raise(CpioEofError("Input file ended early"));
-            }
-
-            outFile.write(chunk);
-            size -= chunkSize;
+        if (_copyData(inFile, outFile, size) != size) {
+            Core.raise(CpioEofError("Input file ended early"));
         }
 
         return;
@@ -1305,7 +1290,7 @@ class CpioMember {
                 Core.raise(CpioEofError("Input file ended early"));
             }
 
-            sum += this._sumData(chunk);
+            sum += (_cpio.sum)(chunk);
             size -= chunkSize;
         }
 
@@ -1336,13 +1321,7 @@ class CpioMember {
 
     {
 
-        var sum = 0;
-
-        for (index in 0..data.length()) {
-            sum += data.byteAt(index);
-        }
-
-        return sum;
+        return (_cpio.sum)(data);
     }
 }
 
@@ -2541,8 +2520,13 @@ class CpioArchive {
                 }
             }
 
+            //
+            // Open the file unbuffered, as its contents are copied straight
+            // from the descriptor in large blocks.
+            //
+
             if ((os.isfile)(name)) {
-                file = open(name, "rb");
+                file = open2(name, "rb", 0664, 0, true);
             }
 
             this.addMember(member, file);
@@ -2874,8 +2858,6 @@ class CpioArchive {
 
     {
 
-        var chunk;
-        var chunkSize = 131072;
         var destination;
         var memberMode = member.mode;
         var mode;
@@ -2924,14 +2906,7 @@ class CpioArchive {
             source = this.extractFile(member);
             destination = open(path, "wb");
             try {
-                while (true) {
-                    chunk = source.read(chunkSize);
-                    if (chunk.length() == 0) {
-                        break;
-                    }
-
-                    destination.write(chunk);
-                }
+                _copyData(source, destination, member.size);
 
             } except Exception as e {
                 Core.raise(e);
@@ -3032,3 +3007,80 @@ class CpioArchive {
 // --------------------------------------------------------- Internal Functions
 //
 
+function
+_copyData (
+    source,
+    destination,
+    size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data between two file objects. When an unbuffered OS
+    file is being copied into a seekable buffered OS file, the data moves
+    between the descriptors directly in large blocks without passing through
+    Chalk strings.
+
+Arguments:
+
+    source - Supplies the file object to read from.
+
+    destination - Supplies the file object to write to.
+
+    size - Supplies the number of bytes to copy.
+
+Return Value:
+
+    Returns the number of bytes copied, which is less than the requested size
+    only if the source ended early.
+
+--*/
+
+{
+
+    var chunk;
+    var chunkSize;
+    var length;
+    var maxChunkSize = 131072;
+    var total = 0;
+    var written;
+
+    if ((source is FileIo) && (destination is BufferedIo) &&
+        (destination.raw is FileIo) && (destination.isSeekable())) {
+
+        //
+        // Flush the buffered destination, copy behind its back, and then
+        // seek to resynchronize its idea of the file position.
+        //
+
+        destination.flush();
+        total = (_cpio.copy)(source.fileno(), destination.fileno(), size);
+        destination.seek(0, IO_SEEK_CUR);
+        return total;
+    }
+
+    while (size != 0) {
+        chunkSize = (size < maxChunkSize) ? size : maxChunkSize;
+        chunk = source.read(chunkSize);
+        length = chunk.length();
+        if (length == 0) {
+            break;
+        }
+
+        total += length;
+        size -= length;
+        while (chunk.length()) {
+            written = destination.write(chunk);
+            if (written <= 0) {
+                Core.raise(IoError("Unable to write"));
+            }
+
+            chunk = chunk[written...-1];
+        }
+    }
+
+    return total;
+}
+
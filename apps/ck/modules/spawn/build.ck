@@ -26,11 +26,12 @@ Module Name:
 
 --*/
 
-from menv import compiledSources, group, mconfig, staticLibrary;
+from menv import addConfig, compiledSources, group, mconfig, staticLibrary;
 from apps.ck.modules.build import chalkSharedModule;
 
 function build() {
     var buildOs = mconfig.build_os;
+    var buildConfig;
     var buildSources;
     var commonSources;
     var lib;
@@ -69,14 +70,19 @@ function build() {
 
     //
     // Create the static and dynamic versions of the module for the build
-    // machine.
+    // machine. The child signal handling uses a pthread mutex, which may
+    // need to be linked in separately outside of Minoca.
     //
 
+    buildConfig = {};
     if (buildOs == "Windows") {
         buildSources = commonSources + win32Sources;
 
     } else {
         buildSources = commonSources + posixSources;
+        if (buildOs != "Minoca") {
+            addConfig(buildConfig, "DYNLIBS", "-lpthread");
+        }
     }
 
     lib = {
@@ -93,6 +99,7 @@ function build() {
         "label": "build_spawn_dynamic",
         "output": "spawn",
         "inputs": objs[0],
+        "config": buildConfig,
         "build": true,
         "prefix": "build"
     };
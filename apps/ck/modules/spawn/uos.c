@@ -33,6 +33,7 @@ Module Name:
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -52,13 +53,34 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the maximum number of threads that can wait on children at once.
+//
+
+#define CK_SIGCHLD_SLOTS 32
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure stores the child signal state for a single waiter.
+
+Members:
+
+    Slot - Stores the index of the notification slot owned by this waiter.
+
+    Pipe - Stores the read and write ends of the slot's notification pipe.
+        The signal handler writes a byte to it whenever any child changes
+        state.
+
+--*/
+
 typedef struct _CK_SIGCHLD_CONTEXT {
-    struct sigaction OriginalAction;
-    struct sigaction OriginalPipeAction;
+    INT Slot;
     int Pipe[2];
 } CK_SIGCHLD_CONTEXT, *PCK_SIGCHLD_CONTEXT;
 
@@ -92,12 +114,21 @@ CkpOsWaitPid (
 //
 
 //
-// Store a global pointer to the child signal context. This unfortunately makes
-// these functions single threaded only, but they probably were anyway due
-// to the fact that they fork.
+// Store the notification slots for threads waiting on children. Several VMs
+// on different threads may be waiting at once, and the signal handler pokes
+// all of them since it cannot know who the child belonged to. Slot pipes are
+// created once and never closed, so the handler never writes to a descriptor
+// that has since been reused for something else. The lock guards everything
+// except the pipes and created flags the handler reads.
 //
 
-PCK_SIGCHLD_CONTEXT CkSigchldContext;
+pthread_mutex_t CkSigchldLock = PTHREAD_MUTEX_INITIALIZER;
+int CkSigchldPipes[CK_SIGCHLD_SLOTS][2];
+volatile sig_atomic_t CkSigchldCreated[CK_SIGCHLD_SLOTS];
+BOOL CkSigchldInUse[CK_SIGCHLD_SLOTS];
+ULONG CkSigchldUsers;
+struct sigaction CkSigchldOriginalAction;
+struct sigaction CkSigchldOriginalPipeAction;
 
 //
 // ------------------------------------------------------------------ Functions
@@ -384,6 +415,8 @@ Return Value:
 
 {
 
+    CHAR Byte;
+    ssize_t BytesDone;
     struct pollfd Pollfd;
     CK_SIGCHLD_CONTEXT SigchldContext;
     INT Status;
@@ -434,16 +467,31 @@ Return Value:
         }
 
         //
-        // Check for a timeout or error.
+        // Check for a timeout or error. The signal from some other child
+        // exiting may interrupt the poll, which is not an error.
         //
 
         if (Status <= 0) {
+            if ((Status < 0) && (errno == EINTR)) {
+                continue;
+            }
+
             if (Status == 0) {
                 Status = 1;
             }
 
             goto OsWaitEnd;
         }
+
+        //
+        // A different child exited. Consume its notification so the next
+        // poll blocks again.
+        //
+
+        do {
+            BytesDone = read(SigchldContext.Pipe[0], &Byte, 1);
+
+        } while ((BytesDone < 0) && (errno == EINTR));
     }
 
 OsWaitEnd:
@@ -968,8 +1016,8 @@ CkpInstallChildSignalHandler (
 
 Routine Description:
 
-    This routine installs a child signal handler with a pipe in it. This
-    routine is single threaded only.
+    This routine claims a child signal notification slot, installing the
+    child signal handler if this is the first waiter.
 
 Arguments:
 
@@ -986,32 +1034,80 @@ Return Value:
 {
 
     struct sigaction Action;
+    CHAR Byte;
+    INT Index;
+    int *Pipe;
+    INT Status;
 
     memset(Context, 0, sizeof(CK_SIGCHLD_CONTEXT));
-    memset(&Action, 0, sizeof(Action));
-    Action.sa_handler = CkpChildSignalHandler;
-    if (sigaction(SIGCHLD, &Action, &(Context->OriginalAction)) != 0) {
-        return -1;
+    Context->Slot = -1;
+    Status = -1;
+    pthread_mutex_lock(&CkSigchldLock);
+    for (Index = 0; Index < CK_SIGCHLD_SLOTS; Index += 1) {
+        if (CkSigchldInUse[Index] == FALSE) {
+            break;
+        }
     }
 
-    if (pipe(Context->Pipe) != 0) {
-        sigaction(SIGCHLD, &(Context->OriginalAction), NULL);
-        return -1;
+    if (Index == CK_SIGCHLD_SLOTS) {
+        errno = EAGAIN;
+        goto InstallChildSignalHandlerEnd;
     }
 
     //
-    // Also block SIGPIPE since it's a convenient place to do it. This is
-    // really only needed by the communicate mechanism, not the child signal
-    // handler.
+    // Create the slot's pipe the first time it's used. Both ends are
+    // non-blocking so that the handler never stalls on a full pipe.
     //
 
-    Action.sa_handler = SIG_IGN;
-    sigaction(SIGPIPE, &Action, &(Context->OriginalPipeAction));
+    Pipe = CkSigchldPipes[Index];
+    if (CkSigchldCreated[Index] == 0) {
+        if (pipe(Pipe) != 0) {
+            goto InstallChildSignalHandlerEnd;
+        }
 
-    assert(CkSigchldContext == NULL);
+        fcntl(Pipe[0], F_SETFD, FD_CLOEXEC);
+        fcntl(Pipe[1], F_SETFD, FD_CLOEXEC);
+        fcntl(Pipe[0], F_SETFL, fcntl(Pipe[0], F_GETFL) | O_NONBLOCK);
+        fcntl(Pipe[1], F_SETFL, fcntl(Pipe[1], F_GETFL) | O_NONBLOCK);
+        CkSigchldCreated[Index] = 1;
 
-    CkSigchldContext = Context;
-    return 0;
+    //
+    // Drain any notifications left over from the last waiter.
+    //
+
+    } else {
+        while (read(Pipe[0], &Byte, 1) > 0) {
+            continue;
+        }
+    }
+
+    if (CkSigchldUsers == 0) {
+        memset(&Action, 0, sizeof(Action));
+        Action.sa_handler = CkpChildSignalHandler;
+        if (sigaction(SIGCHLD, &Action, &CkSigchldOriginalAction) != 0) {
+            goto InstallChildSignalHandlerEnd;
+        }
+
+        //
+        // Also block SIGPIPE since it's a convenient place to do it. This is
+        // really only needed by the communicate mechanism, not the child
+        // signal handler.
+        //
+
+        Action.sa_handler = SIG_IGN;
+        sigaction(SIGPIPE, &Action, &CkSigchldOriginalPipeAction);
+    }
+
+    CkSigchldUsers += 1;
+    CkSigchldInUse[Index] = TRUE;
+    Context->Slot = Index;
+    Context->Pipe[0] = Pipe[0];
+    Context->Pipe[1] = Pipe[1];
+    Status = 0;
+
+InstallChildSignalHandlerEnd:
+    pthread_mutex_unlock(&CkSigchldLock);
+    return Status;
 }
 
 VOID
@@ -1023,30 +1119,36 @@ CkpRemoveChildSignalHandler (
 
 Routine Description:
 
-    This routine uninstalls a child signal handler. This routine is single-
-    threaded only.
+    This routine releases a child signal notification slot, restoring the
+    original signal handlers if this was the last waiter.
 
 Arguments:
 
-    Context - Supplies a pointer where the filled out context will be returned.
+    Context - Supplies a pointer to the context filled out when the handler
+        was installed.
 
 Return Value:
 
-    0 on success.
-
-    Non-zero on failure.
+    None.
 
 --*/
 
 {
 
-    assert(CkSigchldContext == Context);
+    pthread_mutex_lock(&CkSigchldLock);
+
+    assert((Context->Slot >= 0) && (CkSigchldInUse[Context->Slot] != FALSE));
+    assert(CkSigchldUsers != 0);
 
-    sigaction(SIGCHLD, &(Context->OriginalAction), NULL);
-    sigaction(SIGPIPE, &(Context->OriginalPipeAction), NULL);
-    close(Context->Pipe[0]);
-    close(Context->Pipe[1]);
-    CkSigchldContext = NULL;
+    CkSigchldInUse[Context->Slot] = FALSE;
+    CkSigchldUsers -= 1;
+    if (CkSigchldUsers == 0) {
+        sigaction(SIGCHLD, &CkSigchldOriginalAction, NULL);
+        sigaction(SIGPIPE, &CkSigchldOriginalPipeAction, NULL);
+    }
+
+    pthread_mutex_unlock(&CkSigchldLock);
+    Context->Slot = -1;
     return;
 }
 
@@ -1060,7 +1162,8 @@ CkpChildSignalHandler (
 Routine Description:
 
     This routine implements the child signal handler, which simply writes to
-    the status pipe.
+    the notification pipe of every slot. Waiters that were not interested
+    just see a spurious wakeup.
 
 Arguments:
 
@@ -1074,17 +1177,27 @@ Return Value:
 
 {
 
+    int Error;
+    INT Index;
     ssize_t Status;
-    int Value;
+    CHAR Value;
 
-    assert((Signal == SIGCHLD) && (CkSigchldContext != NULL));
+    assert(Signal == SIGCHLD);
 
+    Error = errno;
     Value = 'y';
-    do {
-        Status = write(CkSigchldContext->Pipe[1], &Value, 1);
+    for (Index = 0; Index < CK_SIGCHLD_SLOTS; Index += 1) {
+        if (CkSigchldCreated[Index] == 0) {
+            continue;
+        }
 
-    } while ((Status < 0) && (errno == EINTR));
+        do {
+            Status = write(CkSigchldPipes[Index][1], &Value, 1);
+
+        } while ((Status < 0) && (errno == EINTR));
+    }
 
+    errno = Error;
     return;
 }
 
@@ -0,0 +1,452 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    archive.ck
+
+Abstract:
+
+    This module benchmarks packing and unpacking CPIO archives, both plain and
+    LZMA compressed, in each of the supported formats. It verifies that the
+    unpacked tree matches the source tree.
+
+    Usage: chalk archive.ck <source_dir> <scratch_dir> [iterations]
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Chalk
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+import _time;
+from app import argv;
+from bufferedio import BufferedIo;
+from cpio import CpioArchive;
+from io import open;
+from lzfile import LzFile;
+import os;
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+var formats = ["newc", "crc", "odc", "bin"];
+
+//
+// Define the format and next inode number the filter applies to each member
+// being added.
+//
+
+var memberFormat;
+var memberInode = 1;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+function
+benchmark (
+    source,
+    scratch,
+    format,
+    compressed,
+    iterations
+    );
+
+function
+setFormat (
+    path,
+    member
+    );
+
+function
+openArchive (
+    path,
+    mode,
+    compressed
+    );
+
+function
+compareTrees (
+    left,
+    right
+    );
+
+function
+removeTree (
+    path
+    );
+
+function
+now (
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+function
+main (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the entry point for the archive benchmark.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    0 on success.
+
+    1 on failure.
+
+--*/
+
+{
+
+    var iterations = 3;
+    var source;
+    var scratch;
+
+    if ((argv.length() < 3) || (argv.length() > 4)) {
+        Core.print("Usage: %s <source_dir> <scratch_dir> [iterations]" %
+                   argv[0]);
+
+        return 1;
+    }
+
+    source = argv[1];
+    scratch = argv[2];
+    if (argv.length() == 4) {
+        iterations = Int.fromString(argv[3]);
+    }
+
+    if (!(os.isdir)(scratch)) {
+        (os.mkdir)(scratch, 0777);
+    }
+
+    for (format in formats) {
+        benchmark(source, scratch, format, false, iterations);
+    }
+
+    benchmark(source, scratch, "newc", true, iterations);
+    return 0;
+}
+
+function
+benchmark (
+    source,
+    scratch,
+    format,
+    compressed,
+    iterations
+    )
+
+/*++
+
+Routine Description:
+
+    This routine packs the source directory into an archive, unpacks it, and
+    verifies the result, printing the best time of each step.
+
+Arguments:
+
+    source - Supplies the directory to archive.
+
+    scratch - Supplies a scratch directory for the archive and its contents.
+
+    format - Supplies the archive member format to use.
+
+    compressed - Supplies a boolean indicating whether to compress the archive
+        with LZMA.
+
+    iterations - Supplies the number of times to repeat each step.
+
+Return Value:
+
+    None. An exception is raised if the unpacked tree differs.
+
+--*/
+
+{
+
+    var archive;
+    var archivePath = scratch + "/bench.cpio";
+    var bestPack = -1;
+    var bestUnpack = -1;
+    var extractPath = scratch + "/extract";
+    var name = format;
+    var start;
+    var time;
+
+    if (compressed) {
+        archivePath += ".lz";
+        name += "+lz";
+    }
+
+    memberFormat = format;
+    for (iteration in 0..iterations) {
+        start = now();
+        archive = openArchive(archivePath, "w", compressed);
+        archive[1].add(source, "", true, setFormat);
+        archive[1].close();
+        archive[0].close();
+        time = now() - start;
+        if ((bestPack < 0) || (time < bestPack)) {
+            bestPack = time;
+        }
+
+        removeTree(extractPath);
+        (os.mkdir)(extractPath, 0777);
+        start = now();
+        archive = openArchive(archivePath, "r", compressed);
+        archive[1].extractAll(null, extractPath, -1, -1, false);
+        archive[1].close();
+        archive[0].close();
+        time = now() - start;
+        if ((bestUnpack < 0) || (time < bestUnpack)) {
+            bestUnpack = time;
+        }
+    }
+
+    compareTrees(source, extractPath);
+    Core.print("%-8s pack %6d ms  unpack %6d ms  size %d" %
+               [name,
+                bestPack / 1000000,
+                bestUnpack / 1000000,
+                (os.stat)(archivePath).st_size]);
+
+    removeTree(extractPath);
+    (os.unlink)(archivePath);
+    return;
+}
+
+function
+setFormat (
+    path,
+    member
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the archive filter that sets the benchmarked format on
+    each member as it is added.
+
+Arguments:
+
+    path - Supplies the path of the file being added.
+
+    member - Supplies the new archive member.
+
+Return Value:
+
+    Returns the member.
+
+--*/
+
+{
+
+    //
+    // Host device and inode numbers don't necessarily fit in the old formats.
+    //
+
+    member.format = memberFormat;
+    member.devMajor = 0;
+    member.devMinor = 0;
+    member.inode = memberInode;
+    memberInode += 1;
+    return member;
+}
+
+function
+openArchive (
+    path,
+    mode,
+    compressed
+    )
+
+/*++
+
+Routine Description:
+
+    This routine opens an archive the same way the package tools do.
+
+Arguments:
+
+    path - Supplies the path of the archive.
+
+    mode - Supplies the open mode, "r" or "w".
+
+    compressed - Supplies a boolean indicating whether the archive is LZMA
+        compressed.
+
+Return Value:
+
+    Returns a list of the underlying file and the open CpioArchive. The
+    archive does not close a file it was handed, so the caller must close
+    both.
+
+--*/
+
+{
+
+    var file;
+
+    if (compressed) {
+        file = BufferedIo(LzFile(path, mode, 9), 0);
+
+    } else {
+        file = open(path, mode + "b");
+    }
+
+    return [file, CpioArchive(file, mode)];
+}
+
+function
+compareTrees (
+    left,
+    right
+    )
+
+/*++
+
+Routine Description:
+
+    This routine verifies that two directory trees contain the same regular
+    files with the same contents.
+
+Arguments:
+
+    left - Supplies the first directory.
+
+    right - Supplies the second directory.
+
+Return Value:
+
+    None. An exception is raised on a mismatch.
+
+--*/
+
+{
+
+    var leftData;
+    var leftPath;
+    var rightData;
+    var rightPath;
+
+    for (element in (os.listdir)(left)) {
+        leftPath = left + "/" + element;
+        rightPath = right + "/" + element;
+        if ((os.islink)(leftPath)) {
+            continue;
+
+        } else if ((os.isdir)(leftPath)) {
+            compareTrees(leftPath, rightPath);
+
+        } else if ((os.isfile)(leftPath)) {
+            leftData = open(leftPath, "rb").readall();
+            rightData = open(rightPath, "rb").readall();
+            if (leftData != rightData) {
+                Core.raise(ValueError("Contents differ: %s" % rightPath));
+            }
+        }
+    }
+
+    return;
+}
+
+function
+removeTree (
+    path
+    )
+
+/*++
+
+Routine Description:
+
+    This routine recursively removes a directory tree, if it exists.
+
+Arguments:
+
+    path - Supplies the path to remove.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    var child;
+
+    if ((os.islink)(path) || (os.isfile)(path)) {
+        (os.unlink)(path);
+
+    } else if ((os.isdir)(path)) {
+        for (element in (os.listdir)(path)) {
+            child = path + "/" + element;
+            removeTree(child);
+        }
+
+        (os.rmdir)(path);
+    }
+
+    return;
+}
+
+function
+now (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the current monotonic time.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current time in nanoseconds.
+
+--*/
+
+{
+
+    var value = (_time.clock_gettime)(_time.CLOCK_MONOTONIC);
+
+    return (value[0] * 1000000000) + value[1];
+}
+
+main();
+
@@ -0,0 +1,671 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    thread.ck
+
+Abstract:
+
+    This module implements support for running Chalk code on multiple OS
+    threads. Each thread gets its own isolated VM, so threads never share
+    objects. Instead they exchange copies of plain data (null, integers,
+    strings, and lists and dicts of those) through channels.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Chalk
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+import _thread;
+from _thread import ChannelClosed, ThreadError;
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the maximum number of arguments that can be passed to a thread
+// function.
+//
+
+var _MAX_THREAD_ARGUMENTS = 6;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+function
+_callWithList (
+    work,
+    args
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Keep every started thread reachable until it is joined. A thread handle
+// that gets garbage collected waits for its thread to finish, which should
+// only happen when the VM is being torn down.
+//
+
+var _runningThreads = {};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+//
+// Define the channel class, which is a queue of copied values that can be
+// shared between threads. Channels can be passed to a thread as one of its
+// arguments, but cannot be sent through another channel.
+//
+
+class Channel {
+    function
+    __init (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine creates a new empty channel.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        Returns the initialized object.
+
+    --*/
+
+    {
+
+        this._handle = (_thread.channel)();
+        return this;
+    }
+
+    function
+    __init (
+        handle
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine wraps an existing channel handle. This is used internally
+        when a channel is handed to a new thread.
+
+    Arguments:
+
+        handle - Supplies the channel handle.
+
+    Return Value:
+
+        Returns the initialized object.
+
+    --*/
+
+    {
+
+        this._handle = handle;
+        return this;
+    }
+
+    function
+    send (
+        value
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine copies a value into the channel. This never blocks.
+
+    Arguments:
+
+        value - Supplies the value to send. This can be null, an integer, a
+            string, or a list or dict of those.
+
+    Return Value:
+
+        None. Raises ChannelClosed if the channel has been closed.
+
+    --*/
+
+    {
+
+        return (_thread.send)(this._handle, value);
+    }
+
+    function
+    receive (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine removes the oldest value from the channel, blocking until
+        one is available.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        Returns the received value. Raises ChannelClosed if the channel has
+        been closed and there is nothing left in it.
+
+    --*/
+
+    {
+
+        return (_thread.receive)(this._handle);
+    }
+
+    function
+    close (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine closes the channel. Values already sent can still be
+        received, after which receivers get ChannelClosed.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        None.
+
+    --*/
+
+    {
+
+        return (_thread.close)(this._handle);
+    }
+}
+
+//
+// Define the thread class, which runs a function from an importable module in
+// a new VM on its own OS thread. Functions from the main script cannot be used
+// since the new VM has no way to find them.
+//
+
+class Thread {
+    function
+    __init (
+        moduleName,
+        functionName,
+        args
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine creates a new thread object. The thread does not run
+        until it is started.
+
+    Arguments:
+
+        moduleName - Supplies the name of the module containing the function,
+            as it would be imported.
+
+        functionName - Supplies the name of the function to run.
+
+        args - Supplies the list of arguments to pass to the function. These
+            are copied into the new VM, so they must be plain data or
+            channels. At most six arguments can be passed.
+
+    Return Value:
+
+        Returns the initialized object.
+
+    --*/
+
+    {
+
+        this.moduleName = moduleName;
+        this.functionName = functionName;
+        this.args = args;
+        this._handle = null;
+        return this;
+    }
+
+    function
+    start (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine starts the thread.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        None.
+
+    --*/
+
+    {
+
+        var args = [];
+        var channels = [];
+        var indices = [];
+        var value;
+
+        if (this._handle != null) {
+            Core.raise(ThreadError("Thread already started"));
+        }
+
+        if (this.args.length() > _MAX_THREAD_ARGUMENTS) {
+            Core.raise(ValueError("Too many thread arguments"));
+        }
+
+        //
+        // Channels are shared rather than copied, so pull them out of the
+        // arguments and pass their handles separately.
+        //
+
+        for (index in 0..this.args.length()) {
+            value = this.args[index];
+            if (value is Channel) {
+                indices.append(index);
+                channels.append(value._handle);
+                value = null;
+            }
+
+            args.append(value);
+        }
+
+        this._handle = (_thread.start)(this.moduleName,
+                                       this.functionName,
+                                       [args, indices],
+                                       channels);
+
+        _runningThreads[this] = true;
+        return null;
+    }
+
+    function
+    join (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine waits for the thread to finish.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        Returns a copy of the value returned by the thread function. Raises a
+        ThreadError if the function raised an exception.
+
+    --*/
+
+    {
+
+        if (this._handle == null) {
+            Core.raise(ThreadError("Thread was never started"));
+        }
+
+        if (_runningThreads.containsKey(this)) {
+            _runningThreads.remove(this);
+        }
+
+        return (_thread.join)(this._handle);
+    }
+}
+
+//
+// Define the pool class, which keeps a set of worker threads calling the same
+// function on whatever work is handed to them.
+//
+
+class Pool {
+    function
+    __init (
+        moduleName,
+        functionName,
+        count
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine creates and starts a new pool of worker threads.
+
+    Arguments:
+
+        moduleName - Supplies the name of the module containing the worker
+            function, as it would be imported.
+
+        functionName - Supplies the name of the worker function. It is called
+            with a single argument, the work item.
+
+        count - Supplies the number of threads to start.
+
+    Return Value:
+
+        Returns the initialized object.
+
+    --*/
+
+    {
+
+        var thread;
+
+        if (count <= 0) {
+            Core.raise(ValueError("Pool needs at least one thread"));
+        }
+
+        this._jobs = Channel();
+        this._results = Channel();
+        this._threads = [];
+        for (index in 0..count) {
+            thread = Thread("thread",
+                            "_poolWorker",
+                            [moduleName, functionName, this._jobs,
+                             this._results]);
+
+            thread.start();
+            this._threads.append(thread);
+        }
+
+        return this;
+    }
+
+    function
+    map (
+        items
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine runs the worker function on each item, spreading the
+        items across the pool's threads.
+
+    Arguments:
+
+        items - Supplies the list of work items.
+
+    Return Value:
+
+        Returns a list of the worker function's results, in the same order as
+        the items. Raises a ThreadError if the worker function raised an
+        exception for any item, after all items have finished.
+
+    --*/
+
+    {
+
+        var count = items.length();
+        var error = null;
+        var reply;
+        var results = [];
+
+        for (index in 0..count) {
+            this._jobs.send([index, items[index]]);
+            results.append(null);
+        }
+
+        for (index in 0..count) {
+            reply = this._results.receive();
+            if (reply[1]) {
+                results[reply[0]] = reply[2];
+
+            } else if (error == null) {
+                error = reply[2];
+            }
+        }
+
+        if (error != null) {
+            Core.raise(ThreadError(error));
+        }
+
+        return results;
+    }
+
+    function
+    close (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine stops the pool, waiting for each worker to finish.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        None.
+
+    --*/
+
+    {
+
+        this._jobs.close();
+        for (thread in this._threads) {
+            thread.join();
+        }
+
+        this._threads = [];
+        return null;
+    }
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+function
+_workerMain (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is run in the VM of each new thread. It calls the thread
+    function and hands the result back to the starting thread.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    var args;
+    var handles;
+    var indices;
+    var job = (_thread.job)();
+    var module;
+
+    args = job[2][0];
+    indices = job[2][1];
+    handles = job[3];
+    for (index in 0..indices.length()) {
+        args[indices[index]] = Channel(handles[index]);
+    }
+
+    try {
+        module = Core.importModule(job[0]);
+        module.run();
+        (_thread.finish)(_callWithList(module.__get(job[1]), args));
+
+    } except Exception as e {
+        (_thread.fail)(e.__str());
+    }
+
+    return null;
+}
+
+function
+_poolWorker (
+    moduleName,
+    functionName,
+    jobs,
+    results
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the loop run by each pool thread. It calls the
+    worker function on each job until the job channel is closed.
+
+Arguments:
+
+    moduleName - Supplies the name of the module containing the worker
+        function.
+
+    functionName - Supplies the name of the worker function.
+
+    jobs - Supplies the channel to receive work from. Each job is a list of
+        the item index and the item.
+
+    results - Supplies the channel to send results to. Each result is a list
+        of the item index, a boolean indicating success, and either the
+        function's return value or a description of the exception it raised.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    var job;
+    var module = Core.importModule(moduleName);
+    var work;
+
+    module.run();
+    work = module.__get(functionName);
+    while (true) {
+        try {
+            job = jobs.receive();
+
+        } except ChannelClosed {
+            break;
+        }
+
+        try {
+            results.send([job[0], true, work(job[1])]);
+
+        } except Exception as e {
+            results.send([job[0], false, e.__str()]);
+        }
+    }
+
+    return null;
+}
+
+function
+_callWithList (
+    work,
+    args
+    )
+
+/*++
+
+Routine Description:
+
+    This routine calls a function with the elements of a list as its
+    arguments. This has to be done from Chalk rather than from the native
+    module, since exceptions cannot be raised across a foreign function.
+
+Arguments:
+
+    work - Supplies the function to call.
+
+    args - Supplies the list of arguments.
+
+Return Value:
+
+    Returns the value returned by the function.
+
+--*/
+
+{
+
+    var count = args.length();
+
+    if (count == 0) {
+        return work();
+
+    } else if (count == 1) {
+        return work(args[0]);
+
+    } else if (count == 2) {
+        return work(args[0], args[1]);
+
+    } else if (count == 3) {
+        return work(args[0], args[1], args[2]);
+
+    } else if (count == 4) {
+        return work(args[0], args[1], args[2], args[3]);
+
+    } else if (count == 5) {
+        return work(args[0], args[1], args[2], args[3], args[4]);
+
+    } else if (count == 6) {
+        return work(args[0], args[1], args[2], args[3], args[4], args[5]);
+    }
+
+    Core.raise(ValueError("Too many thread arguments"));
+}
+
@@ -25,9 +25,10 @@ Module Name:
 
 --*/
 
-from menv import staticLibrary;
+from menv import kernelLibrary, staticLibrary;
 
 function build() {
+    var bootLib;
     var buildLib;
     var entries;
     var lib;
@@ -54,8 +55,23 @@ function build() {
         "prefix": "build"
     };
 
+    //
+    // The boot environment only needs the decoder. It has no C library, so
+    // point the decoder's memory routines at the runtime library.
+    //
+
+    bootLib = {
+        "label": "lzmab",
+        "inputs": ["crc32.c", "lzmadec.c"],
+        "prefix": "boot",
+        "sources_config": {
+            "CPPFLAGS": ["-Dmemcpy=RtlCopyMemory", "-Dmemset=RtlSetMemory"]
+        }
+    };
+
     entries = staticLibrary(lib);
     entries += staticLibrary(buildLib);
+    entries += kernelLibrary(bootLib);
     return entries;
 }
 
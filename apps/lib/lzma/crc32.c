@@ -43,6 +43,13 @@ Module Name:
 
 #define LZMA_CRC_POLYNOMIAL 0xEDB88320
 
+//
+// Define the number of bits in the CRC, which is the dimension of the GF(2)
+// matrices used to combine CRCs.
+//
+
+#define LZMA_CRC_BITS 32
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -51,6 +58,18 @@ Module Name:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+ULONG
+LzpCrcMatrixMultiply (
+    PULONG Matrix,
+    ULONG Vector
+    );
+
+VOID
+LzpCrcMatrixSquare (
+    PULONG Square,
+    PULONG Matrix
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -160,7 +179,171 @@ Return Value:
     return Crc;
 }
 
+ULONG
+LzpCombineCrc32 (
+    ULONG Crc1,
+    ULONG Crc2,
+    ULONGLONG Size2
+    )
+
+/*++
+
+Routine Description:
+
+    This routine combines two CRC-32 values into the CRC-32 of the
+    concatenation of the two buffers they were computed over.
+
+Arguments:
+
+    Crc1 - Supplies the CRC-32 of the first buffer.
+
+    Crc2 - Supplies the CRC-32 of the second buffer.
+
+    Size2 - Supplies the size of the second buffer, in bytes.
+
+Return Value:
+
+    Returns the CRC-32 of the first buffer followed by the second.
+
+--*/
+
+{
+
+    ULONG Even[LZMA_CRC_BITS];
+    ULONG Index;
+    ULONG Odd[LZMA_CRC_BITS];
+    ULONG Row;
+
+    if (Size2 == 0) {
+        return Crc1;
+    }
+
+    //
+    // Appending zero bits to the first CRC is a linear operation, so build
+    // the operator for a single zero bit, then square it repeatedly to get
+    // operators for 2, 4, 8, ... zero bits. Apply the ones corresponding to
+    // the bits set in the length of the second buffer.
+    //
+
+    Odd[0] = LZMA_CRC_POLYNOMIAL;
+    Row = 1;
+    for (Index = 1; Index < LZMA_CRC_BITS; Index += 1) {
+        Odd[Index] = Row;
+        Row <<= 1;
+    }
+
+    //
+    // Square twice to get the operators for two and then four zero bits.
+    //
+
+    LzpCrcMatrixSquare(Even, Odd);
+    LzpCrcMatrixSquare(Odd, Even);
+
+    //
+    // Apply the operator for each set bit in the length, starting with one
+    // zero byte.
+    //
+
+    do {
+        LzpCrcMatrixSquare(Even, Odd);
+        if ((Size2 & 0x1) != 0) {
+            Crc1 = LzpCrcMatrixMultiply(Even, Crc1);
+        }
+
+        Size2 >>= 1;
+        if (Size2 == 0) {
+            break;
+        }
+
+        LzpCrcMatrixSquare(Odd, Even);
+        if ((Size2 & 0x1) != 0) {
+            Crc1 = LzpCrcMatrixMultiply(Odd, Crc1);
+        }
+
+        Size2 >>= 1;
+
+    } while (Size2 != 0);
+
+    return Crc1 ^ Crc2;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+ULONG
+LzpCrcMatrixMultiply (
+    PULONG Matrix,
+    ULONG Vector
+    )
+
+/*++
+
+Routine Description:
+
+    This routine multiplies a vector by a matrix over GF(2).
+
+Arguments:
+
+    Matrix - Supplies a pointer to the matrix, an array of 32 columns.
+
+    Vector - Supplies the vector to multiply.
+
+Return Value:
+
+    Returns the product.
+
+--*/
+
+{
+
+    ULONG Sum;
+
+    Sum = 0;
+    while (Vector != 0) {
+        if ((Vector & 0x1) != 0) {
+            Sum ^= *Matrix;
+        }
+
+        Vector >>= 1;
+        Matrix += 1;
+    }
+
+    return Sum;
+}
+
+VOID
+LzpCrcMatrixSquare (
+    PULONG Square,
+    PULONG Matrix
+    )
+
+/*++
+
+Routine Description:
+
+    This routine squares a matrix over GF(2).
+
+Arguments:
+
+    Square - Supplies a pointer where the squared matrix will be returned.
+
+    Matrix - Supplies a pointer to the matrix to square.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Index;
+
+    for (Index = 0; Index < LZMA_CRC_BITS; Index += 1) {
+        Square[Index] = LzpCrcMatrixMultiply(Matrix, Matrix[Index]);
+    }
+
+    return;
+}
+
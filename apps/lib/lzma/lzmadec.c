@@ -51,6 +51,14 @@ Module Name:
 // Define primitives used in the primary decoding function. These are defined
 // as macros rather than routines for performance.
 //
+// The range stays 32 bits wide and is refilled a byte at a time. Every bit
+// splits the range at (Range >> LZMA_BIT_MODEL_BIT_COUNT) * Probability, and
+// the encoder made each split with its range normalized to [2^24, 2^32). A
+// wider range would put the splits somewhere else and decode the wrong bits.
+// Pulling the code from a 64-bit window of input wouldn't help either: each
+// normalization still consumes exactly one byte, so it trades a byte load
+// for a shift and a refill check.
+//
 
 #define LZMA_NORMALIZE_RANGE(_Range, _Code, _Buffer)    \
     if ((_Range) < LZMA_RANGE_TOP_VALUE) {              \
@@ -87,6 +95,33 @@ Module Name:
         (_BitOut) = ((_BitOut) << 1) | 0x1;                                   \
     }
 
+//
+// Decode a bit without branching on its value, which the processor has little
+// hope of predicting. The mask is set to all ones if the bit is a one and zero
+// otherwise. This is used for the bit trees, where the decoded bit is only
+// used to steer to the next probability.
+//
+
+#define LZMA_RANGE_DECODE_BIT(_Prob,                                          \
+                              _ProbValue,                                     \
+                              _Bound,                                         \
+                              _Range,                                         \
+                              _Code,                                          \
+                              _Buffer,                                        \
+                              _Mask,                                          \
+                              _BitOut)                                        \
+                                                                              \
+    LZMA_RANGE_READ(_Prob, _ProbValue, _Bound, _Range, _Code, _Buffer);       \
+    (_Mask) = 0 - (ULONG)((_Code) >= (_Bound));                               \
+    (_Range) = (_Bound) + (((_Range) - (_Bound) - (_Bound)) & (_Mask));       \
+    (_Code) -= (_Bound) & (_Mask);                                            \
+    *(_Prob) = (LZ_PROB)((_ProbValue) +                                       \
+                         (((LZMA_BIT_MODEL_TOTAL - (_ProbValue)) >>           \
+                           LZMA_MOVE_BIT_COUNT) & ~(_Mask)) -                 \
+                         (((_ProbValue) >> LZMA_MOVE_BIT_COUNT) & (_Mask)));  \
+                                                                              \
+    (_BitOut) = ((_BitOut) << 1) | ((_Mask) & 0x1);
+
 //
 // Define all the same macros but that are only attempting to do it. This means
 // that 1) they don't update the probabilities and 2) they error out if they
@@ -295,6 +330,15 @@ Structure Description:
 
     FileWrapper - Stores a boolean indicating if the file footer is expected.
 
+    BlockStream - Stores a boolean indicating if the input is a block stream,
+        made up of a series of independently compressed blocks.
+
+    BlockCompressedEnd - Stores the total compressed size at which the current
+        block in a block stream should end.
+
+    BlockUncompressedEnd - Stores the total uncompressed size at which the
+        current block in a block stream should end.
+
     HasEndMark - Stores a boolean indicating if the stream has an end mark.
 
     InputFinished - Stores a boolean indicating whether this is the end of
@@ -333,6 +377,9 @@ typedef struct _LZMA_DECODER {
     ULONG InputSize;
     ULONG OutputPosition;
     BOOL FileWrapper;
+    BOOL BlockStream;
+    ULONGLONG BlockCompressedEnd;
+    ULONGLONG BlockUncompressedEnd;
     BOOL HasEndMark;
     BOOL InputFinished;
     LZ_STATUS Error;
@@ -383,6 +430,17 @@ LzpLzmaReadHeader (
     PLZ_CONTEXT Context
     );
 
+LZ_STATUS
+LzpLzmaReadBlockHeader (
+    PLZ_CONTEXT Context
+    );
+
+LZ_STATUS
+LzpLzmaDecodeData (
+    PLZ_CONTEXT Context,
+    LZ_FLUSH_OPTION Flush
+    );
+
 LZ_STATUS
 LzpLzmaDecodeToBuffer (
     PLZMA_DECODER Decoder,
@@ -563,22 +621,8 @@ Return Value:
 
 {
 
-    INTN BytesComplete;
     UCHAR CheckBuffer[LZMA_FOOTER_SIZE];
-    LZ_COMPLETION_STATUS CompletionStatus;
     PLZMA_DECODER Decoder;
-    BOOL EndMark;
-    PUCHAR InBuffer;
-    UINTN InBufferSize;
-    UINTN InPosition;
-    UINTN InProcessed;
-    UINTN InSize;
-    UINTN OriginalBufferSize;
-    PVOID OriginalDict;
-    PUCHAR OutBuffer;
-    UINTN OutBufferSize;
-    UINTN OutPosition;
-    UINTN OutProcessed;
     LZ_STATUS Status;
 
     Decoder = Context->InternalState;
@@ -615,243 +659,50 @@ Return Value:
     }
 
     //
-    // The meat is here, decoding data.
+    // The meat is here, decoding data. Block streams go around this loop once
+    // for each block.
     //
 
-    if (Decoder->Stage == LzmaStageData) {
-
-        //
-        // Figure out which buffers to use: previously allocated internal
-        // buffers or the buffers coming in direct from the user.
-        //
-
-        if (Context->Read != NULL) {
-            InBuffer = Decoder->AllocatedInput;
-            InBufferSize = LZMA_DECODE_DEFAULT_WORKING_SIZE;
-            InSize = Decoder->InputSize;
-            InPosition = Decoder->InputPosition;
-
-        } else {
-            InBuffer = (PUCHAR)(Context->Input);
-            InBufferSize = Context->InputSize;
-            InSize = Context->InputSize;
-            InPosition = 0;
-        }
-
-        if (Context->Write != NULL) {
-            OutBuffer = Decoder->AllocatedOutput;
-            OutPosition = Decoder->OutputPosition;
-            OutBufferSize = LZMA_DECODE_DEFAULT_WORKING_SIZE;
-
-        } else {
-            OutBuffer = Context->Output;
-            OutPosition = 0;
-            OutBufferSize = Context->OutputSize;
-        }
-
-        //
-        // If using the buffer, decode directly to the output buffer, since
-        // there's only one shot.
-        //
-
-        CompletionStatus = LzCompletionNotSpecified;
-        if ((Context->Write == NULL) && (Context->Read == NULL) &&
-            (Flush == LzFlushNow)) {
-
-            OriginalDict = Decoder->Dict;
-            OriginalBufferSize = Decoder->DictBufferSize;
-            Decoder->Dict = Context->Output;
-            Decoder->DictBufferSize = Context->OutputSize;
-            Status = LzpLzmaDecodeToDictionary(Decoder,
-                                               Decoder->DictBufferSize,
-                                               Context->Input,
-                                               &InSize,
-                                               Decoder->HasEndMark,
-                                               &CompletionStatus);
-
-            Decoder->Dict = OriginalDict;
-            Decoder->DictBufferSize = OriginalBufferSize;
-            Context->CompressedCrc32 = LzpComputeCrc32(Context->CompressedCrc32,
-                                                       Context->Input,
-                                                       InSize);
-
-            Context->CompressedSize += InSize;
-            Context->Input += InSize;
-            Context->InputSize -= InSize;
-            Context->UncompressedCrc32 =
-                                    LzpComputeCrc32(Context->UncompressedCrc32,
-                                                    Context->Output,
-                                                    Decoder->DictPosition);
-
-            Context->UncompressedSize += Decoder->DictPosition;
-            Context->Output += Decoder->DictPosition;
-            Context->OutputSize -= Decoder->DictPosition;
-            if ((Status == LzSuccess) &&
-                ((CompletionStatus == LzCompletionMoreInputRequired) ||
-                 (CompletionStatus == LzCompletionNotFinished))) {
-
-                Status = LzErrorInputEof;
-            }
-
+    while (TRUE) {
+        if (Decoder->Stage == LzmaStageBlockHeader) {
+            Status = LzpLzmaReadBlockHeader(Context);
             if (Status != LzSuccess) {
                 goto DecodeEnd;
             }
 
-        } else {
-
             //
-            // This is the normal loop for decoding the stream.
+            // Bail out if the header isn't all there yet, or if reading it used
+            // up all the input.
             //
 
-            while (TRUE) {
-                EndMark = FALSE;
-                if (InPosition >= InSize) {
-                    if (Context->Read == NULL) {
-                        if (Flush != LzNoFlush) {
-                            EndMark = Decoder->HasEndMark;
-
-                        } else {
-                            break;
-                        }
-
-                    } else if (Decoder->InputFinished == FALSE) {
-                        InSize = Context->Read(Context, InBuffer, InBufferSize);
-                        if (InSize == 0) {
-                            Decoder->InputFinished = TRUE;
-                            EndMark = Decoder->HasEndMark;
-
-                        } else if (InSize < 0) {
-                            Status = LzErrorRead;
-                            break;
-                        }
-
-                        InPosition = 0;
-
-                    } else {
-                        EndMark = Decoder->HasEndMark;
-                    }
-                }
-
-                InProcessed = InSize - InPosition;
-                OutProcessed = OutBufferSize - OutPosition;
-                if (OutProcessed == 0) {
-                    Status = LzSuccess;
-                    break;
-                }
-
-                Status = LzpLzmaDecodeToBuffer(Decoder,
-                                               OutBuffer + OutPosition,
-                                               &OutProcessed,
-                                               InBuffer + InPosition,
-                                               &InProcessed,
-                                               EndMark,
-                                               &CompletionStatus);
-
-                //
-                // Only add the portion of the buffer that's actually compressed
-                // data to the CRC.
-                //
-
-                Context->CompressedCrc32 =
-                                      LzpComputeCrc32(Context->CompressedCrc32,
-                                                      InBuffer + InPosition,
-                                                      InProcessed);
-
-                Context->CompressedSize += InProcessed;
-                InPosition += InProcessed;
-                OutPosition += OutProcessed;
-                if (Context->Write != NULL) {
-                    BytesComplete = Context->Write(Context,
-                                                   OutBuffer,
-                                                   OutPosition);
-
-                    if (BytesComplete != OutPosition) {
-                        Status = LzErrorWrite;
-                        break;
-                    }
-                }
-
-                Context->UncompressedCrc32 =
-                                    LzpComputeCrc32(Context->UncompressedCrc32,
-                                                    OutBuffer,
-                                                    OutPosition);
-
-                Context->UncompressedSize += OutPosition;
-                if (Context->Write != NULL) {
-                    OutPosition = 0;
-                }
-
-                if (Status != LzSuccess) {
-                    break;
-                }
-
-                if (CompletionStatus == LzCompletionFinishedWithMark) {
-                    break;
-                }
-
-                if ((InProcessed == 0) && (OutProcessed == 0)) {
-                    break;
-                }
-            }
-
-            if (Context->Read != NULL) {
-                Decoder->InputSize = InSize;
-                Decoder->InputPosition = InPosition;
+            if ((Decoder->Stage == LzmaStageBlockHeader) ||
+                ((Decoder->Stage == LzmaStageData) &&
+                 (Context->Read == NULL) && (Context->InputSize == 0))) {
 
-            } else {
-                Context->Input += InPosition;
-                Context->InputSize -= InPosition;
-                Context->Output += OutPosition;
-                Context->OutputSize -= OutPosition;
-            }
-
-            if (Status != LzSuccess) {
                 goto DecodeEnd;
             }
         }
 
-        //
-        // See if the stream is complete, and advance the stage if so.
-        //
+        if (Decoder->Stage != LzmaStageData) {
+            break;
+        }
 
-        if ((CompletionStatus == LzCompletionFinishedWithMark) ||
-            ((Decoder->HasEndMark == FALSE) &&
-             (Flush != LzNoFlush) &&
-             (CompletionStatus == LzCompletionMaybeFinishedWithoutMark))) {
+        Status = LzpLzmaDecodeData(Context, Flush);
+        if (Status != LzSuccess) {
 
-            if (Decoder->FileWrapper != FALSE) {
-                Decoder->Stage = LzmaStageFileFooter;
+            //
+            // Not making progress without a flush is not a permanent error.
+            //
 
-            } else {
-                Decoder->Stage = LzmaStageComplete;
+            if (Status == LzErrorProgress) {
+                return LzErrorInvalidParameter;
             }
-        }
 
-        //
-        // If the stream was supposed to finish but didn't, that's an error.
-        //
-
-        if ((Flush == LzFlushNow) && (Decoder->Stage == LzmaStageData)) {
-            Status = LzErrorInputEof;
             goto DecodeEnd;
         }
 
-        //
-        // If no progress was made, fail. If the caller wanted to flush, make
-        // the error permanent.
-        //
-
-        if ((InBuffer == Context->Input) && (OutBuffer == Context->Output)) {
-            Status = LzErrorInvalidParameter;
-            if (Flush == LzNoFlush) {
-                return Status;
-            }
-
-            if (CompletionStatus == LzCompletionMoreInputRequired) {
-                Status = LzErrorInputEof;
-            }
-
-            goto DecodeEnd;
+        if (Decoder->Stage != LzmaStageBlockHeader) {
+            break;
         }
     }
 
@@ -925,6 +776,320 @@ Return Value:
     return;
 }
 
+LZ_STATUS
+LzLzmaInitializeBlockDecoder (
+    PLZ_CONTEXT Context,
+    PCVOID Header
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes a given LZ context for validating a block stream
+    whose blocks are decompressed separately with LzLzmaDecompressBlock. The
+    caller reads the stream itself, handing each block header to
+    LzLzmaReadBlockHeader and the footer to LzLzmaFinishBlockDecoder.
+
+Arguments:
+
+    Context - Supplies a pointer to the context. Only the reallocate routine
+        is used.
+
+    Header - Supplies a pointer to the LZMA_HEADER_SIZE byte stream header.
+
+Return Value:
+
+    LzErrorMagic if the header is not the start of a block stream.
+
+    Other LZ Status codes.
+
+--*/
+
+{
+
+    ULONG Magic;
+
+    //
+    // Initialize the CRC table now, as the blocks may be decompressed on
+    // several threads at once.
+    //
+
+    LzpCrcInitialize();
+    memcpy(&Magic, Header, sizeof(Magic));
+    if (Magic != LZMA_BLOCK_HEADER_MAGIC) {
+        return LzErrorMagic;
+    }
+
+    if (((PCUCHAR)Header)[LZMA_HEADER_MAGIC_SIZE] >= (9 * 5 * 5)) {
+        return LzErrorUnsupported;
+    }
+
+    Context->CompressedCrc32 = LzpComputeCrc32(0, Header, LZMA_HEADER_SIZE);
+    Context->UncompressedCrc32 = 0;
+    Context->CompressedSize = LZMA_HEADER_SIZE;
+    Context->UncompressedSize = 0;
+    return LzSuccess;
+}
+
+LZ_STATUS
+LzLzmaReadBlockHeader (
+    PLZ_CONTEXT Context,
+    PCVOID BlockHeader,
+    PUINTN CompressedSize,
+    PUINTN UncompressedSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine validates the next block header in a block stream and adds
+    the block to the running stream sizes and CRCs.
+
+Arguments:
+
+    Context - Supplies a pointer to the context initialized with
+        LzLzmaInitializeBlockDecoder.
+
+    BlockHeader - Supplies a pointer to the LZMA_BLOCK_HEADER_SIZE byte block
+        header.
+
+    CompressedSize - Supplies a pointer where the size of the compressed data
+        following the block header will be returned. Zero is returned for the
+        header that terminates the stream.
+
+    UncompressedSize - Supplies a pointer where the size of the block once
+        decompressed will be returned.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+{
+
+    ULONG Fields[LZMA_BLOCK_HEADER_SIZE / sizeof(ULONG)];
+
+    memcpy(Fields, BlockHeader, LZMA_BLOCK_HEADER_SIZE);
+    if (Fields[0] == 0) {
+        if ((Fields[1] != 0) || (Fields[2] != 0) || (Fields[3] != 0)) {
+            return LzErrorCorruptData;
+        }
+
+    } else if ((Fields[0] > LZMA_BLOCK_BOUND(LZMA_MAX_BLOCK_SIZE)) ||
+               (Fields[1] > LZMA_MAX_BLOCK_SIZE)) {
+
+        return LzErrorCorruptData;
+    }
+
+    //
+    // The block's own CRCs are verified when it is decompressed, so they can
+    // be folded into the stream CRCs now without looking at the block data.
+    //
+
+    Context->CompressedCrc32 = LzpComputeCrc32(Context->CompressedCrc32,
+                                               Fields,
+                                               LZMA_BLOCK_HEADER_SIZE);
+
+    Context->CompressedCrc32 = LzpCombineCrc32(Context->CompressedCrc32,
+                                               Fields[2],
+                                               Fields[0]);
+
+    Context->UncompressedCrc32 = LzpCombineCrc32(Context->UncompressedCrc32,
+                                                 Fields[3],
+                                                 Fields[1]);
+
+    Context->CompressedSize += LZMA_BLOCK_HEADER_SIZE + Fields[0];
+    Context->UncompressedSize += Fields[1];
+    *CompressedSize = Fields[0];
+    *UncompressedSize = Fields[1];
+    return LzSuccess;
+}
+
+LZ_STATUS
+LzLzmaDecompressBlock (
+    PLZ_CONTEXT Context,
+    PCVOID Header
+    )
+
+/*++
+
+Routine Description:
+
+    This routine decompresses a single block of a block stream, verifying its
+    sizes and CRCs. The read and write functions are not used. Different
+    contexts can decompress blocks concurrently.
+
+Arguments:
+
+    Context - Supplies a pointer to the context. Only the reallocate routine
+        and the input and output buffers need to be set up. The input should
+        start with the block header, and the output buffer must be large
+        enough to hold the entire decompressed block. On success, the input
+        and output pointers and sizes are advanced.
+
+    Header - Supplies a pointer to the LZMA_HEADER_SIZE byte stream header,
+        which contains the properties the blocks were compressed with.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+{
+
+    LZ_CONTEXT Block;
+    ULONG DictSize;
+    ULONG Fields[LZMA_BLOCK_HEADER_SIZE / sizeof(ULONG)];
+    UCHAR Properties[LZMA_PROPERTIES_SIZE];
+    LZ_STATUS Status;
+
+    if (Context->Reallocate == NULL) {
+        return LzErrorInvalidParameter;
+    }
+
+    if (Context->InputSize < LZMA_BLOCK_HEADER_SIZE) {
+        return LzErrorInputEof;
+    }
+
+    memcpy(Fields, Context->Input, LZMA_BLOCK_HEADER_SIZE);
+    if ((Fields[0] == 0) || (Fields[1] > LZMA_MAX_BLOCK_SIZE)) {
+        return LzErrorCorruptData;
+    }
+
+    if (Fields[0] > Context->InputSize - LZMA_BLOCK_HEADER_SIZE) {
+        return LzErrorInputEof;
+    }
+
+    if (Fields[1] > Context->OutputSize) {
+        return LzErrorOutputEof;
+    }
+
+    //
+    // The block decodes straight into the output buffer, so the decoder's own
+    // dictionary goes unused. Since no match can reach back past the start of
+    // the block, shrink the dictionary to the block size rather than
+    // allocating the full size for every block in flight.
+    //
+
+    memcpy(Properties,
+           (PCUCHAR)Header + LZMA_HEADER_MAGIC_SIZE,
+           LZMA_PROPERTIES_SIZE);
+
+    DictSize = Properties[1] |
+               ((ULONG)(Properties[2]) << 8) |
+               ((ULONG)(Properties[3]) << 16) |
+               ((ULONG)(Properties[4]) << 24);
+
+    if (DictSize > Fields[1]) {
+        DictSize = Fields[1];
+        Properties[1] = (UCHAR)DictSize;
+        Properties[2] = (UCHAR)(DictSize >> 8);
+        Properties[3] = (UCHAR)(DictSize >> 16);
+        Properties[4] = (UCHAR)(DictSize >> 24);
+    }
+
+    memset(&Block, 0, sizeof(LZ_CONTEXT));
+    Block.Context = Context->Context;
+    Block.Reallocate = Context->Reallocate;
+    Status = LzLzmaInitializeDecoder(&Block, NULL, FALSE);
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    Status = LzpLzmaDecodeProperties(&Block,
+                                     Properties,
+                                     LZMA_PROPERTIES_SIZE);
+
+    if (Status != LzSuccess) {
+        goto DecompressBlockEnd;
+    }
+
+    Block.Input = (PCUCHAR)(Context->Input) + LZMA_BLOCK_HEADER_SIZE;
+    Block.InputSize = Fields[0];
+    Block.Output = Context->Output;
+    Block.OutputSize = Fields[1];
+    Status = LzLzmaDecode(&Block, LzFlushNow);
+    if (Status != LzStreamComplete) {
+        if (Status == LzSuccess) {
+            Status = LzErrorCorruptData;
+        }
+
+        goto DecompressBlockEnd;
+    }
+
+    if ((Block.CompressedSize != Fields[0]) ||
+        (Block.UncompressedSize != Fields[1])) {
+
+        Status = LzErrorCorruptData;
+        goto DecompressBlockEnd;
+    }
+
+    if ((Block.CompressedCrc32 != Fields[2]) ||
+        (Block.UncompressedCrc32 != Fields[3])) {
+
+        Status = LzErrorCrc;
+        goto DecompressBlockEnd;
+    }
+
+    Context->Input = (PCUCHAR)(Context->Input) + LZMA_BLOCK_HEADER_SIZE +
+                     Fields[0];
+
+    Context->InputSize -= LZMA_BLOCK_HEADER_SIZE + Fields[0];
+    Context->Output = (PUCHAR)(Context->Output) + Fields[1];
+    Context->OutputSize -= Fields[1];
+    Status = LzSuccess;
+
+DecompressBlockEnd:
+    LzLzmaFinishDecode(&Block);
+    return Status;
+}
+
+LZ_STATUS
+LzLzmaFinishBlockDecoder (
+    PLZ_CONTEXT Context,
+    PCVOID Footer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine validates the footer of a block stream against the running
+    sizes and CRCs.
+
+Arguments:
+
+    Context - Supplies a pointer to the context initialized with
+        LzLzmaInitializeBlockDecoder.
+
+    Footer - Supplies a pointer to the LZMA_FOOTER_SIZE byte footer.
+
+Return Value:
+
+    LzStreamComplete on success.
+
+    Other LZ Status codes on failure.
+
+--*/
+
+{
+
+    UCHAR CheckFields[LZMA_FOOTER_SIZE];
+    LZ_STATUS Status;
+
+    memcpy(CheckFields, Footer, LZMA_FOOTER_SIZE);
+    Status = LzpVerifyCheckFields(CheckFields, Context);
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    return LzStreamComplete;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
@@ -1199,153 +1364,535 @@ LzpLzmaDecoderReset (
 
 Routine Description:
 
-    This routine requests a reset of the decoder.
+    This routine requests a reset of the decoder.
+
+Arguments:
+
+    Decoder - Supplies a pointer to the decoder.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    Decoder->DictPosition = 0;
+    Decoder->InputFinished = FALSE;
+    LzpLzmaDecoderInitializeState(Decoder, TRUE, TRUE);
+    return;
+}
+
+VOID
+LzpLzmaDecoderInitializeState (
+    PLZMA_DECODER Decoder,
+    BOOL InitializeDictionary,
+    BOOL InitializeState
+    )
+
+/*++
+
+Routine Description:
+
+    This routine requests a reinitialization of the decoder dictionary and/or
+    state.
+
+Arguments:
+
+    Decoder - Supplies a pointer to the decoder.
+
+    InitializeDictionary - Supplies a boolean indicating whether or not to
+        initialize the dictionary.
+
+    InitializeState - Supplies a boolean indicating whether or not to
+        initialize the state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    Decoder->NeedFlush = TRUE;
+    Decoder->RemainingLength = 0;
+    Decoder->WorkingSize = 0;
+    if (InitializeDictionary != FALSE) {
+        Decoder->ProcessedPosition = 0;
+        Decoder->CheckDictSize = 0;
+        Decoder->NeedReset = 1;
+
+    } else if (InitializeState != FALSE) {
+        Decoder->NeedReset = 1;
+    }
+
+    return;
+}
+
+LZ_STATUS
+LzpLzmaReadHeader (
+    PLZ_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the file header out of a compressed LZMA stream, which
+    validates the magic value and reads the properties into the decoder.
+
+Arguments:
+
+    Context - Supplies a pointer to the context.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+{
+
+    PLZMA_DECODER Decoder;
+    UCHAR Header[LZMA_HEADER_SIZE];
+    ULONG Magic;
+    LZ_STATUS Status;
+
+    Decoder = Context->InternalState;
+
+    //
+    // Read both the magic and the properties.
+    //
+
+    Status = LzpLzmaDecoderRead(Context, Header, sizeof(Header));
+
+    //
+    // If progress is returned, that's a wink that nothing went wrong but the
+    // full size isn't there yet.
+    //
+
+    if (Status == LzErrorProgress) {
+        return LzSuccess;
+    }
+
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    memcpy(&Magic, Header, sizeof(Magic));
+
+    //
+    // Validate the magic value.
+    //
+
+    if (Magic == LZMA_BLOCK_HEADER_MAGIC) {
+        Decoder->BlockStream = TRUE;
+
+    } else if (Magic == LZMA_HEADER_MAGIC) {
+        Decoder->BlockStream = FALSE;
+
+    } else {
+        return LzErrorMagic;
+    }
+
+    Status = LzpLzmaDecodeProperties(Context,
+                                     &(Header[LZMA_HEADER_MAGIC_SIZE]),
+                                     LZMA_HEADER_SIZE - LZMA_HEADER_MAGIC_SIZE);
+
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    Context->CompressedCrc32 = LzpComputeCrc32(Context->CompressedCrc32,
+                                               Header,
+                                               LZMA_HEADER_SIZE);
+
+    Context->CompressedSize += LZMA_HEADER_SIZE;
+
+    //
+    // Advance to the data portion, or the first block header.
+    //
+
+    Decoder->Stage = LzmaStageData;
+    if (Decoder->BlockStream != FALSE) {
+        Decoder->Stage = LzmaStageBlockHeader;
+    }
+
+    return Status;
+}
+
+LZ_STATUS
+LzpLzmaReadBlockHeader (
+    PLZ_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads the header in front of the next block of a block
+    stream, and resets the decoder to start decoding it.
 
 Arguments:
 
-    Decoder - Supplies a pointer to the decoder.
+    Context - Supplies a pointer to the context.
 
 Return Value:
 
-    None.
+    LZ Status code. The stage is left alone if more input is needed.
 
 --*/
 
 {
 
-    Decoder->DictPosition = 0;
-    Decoder->InputFinished = FALSE;
-    LzpLzmaDecoderInitializeState(Decoder, TRUE, TRUE);
-    return;
-}
-
-VOID
-LzpLzmaDecoderInitializeState (
-    PLZMA_DECODER Decoder,
-    BOOL InitializeDictionary,
-    BOOL InitializeState
-    )
-
-/*++
-
-Routine Description:
-
-    This routine requests a reinitialization of the decoder dictionary and/or
-    state.
+    ULONG BlockHeader[LZMA_BLOCK_HEADER_SIZE / sizeof(ULONG)];
+    PLZMA_DECODER Decoder;
+    LZ_STATUS Status;
 
-Arguments:
+    Decoder = Context->InternalState;
+    Status = LzpLzmaDecoderRead(Context,
+                                (PUCHAR)BlockHeader,
+                                LZMA_BLOCK_HEADER_SIZE);
 
-    Decoder - Supplies a pointer to the decoder.
+    if (Status == LzErrorProgress) {
+        return LzSuccess;
+    }
 
-    InitializeDictionary - Supplies a boolean indicating whether or not to
-        initialize the dictionary.
+    if (Status != LzSuccess) {
+        return Status;
+    }
 
-    InitializeState - Supplies a boolean indicating whether or not to
-        initialize the state.
+    Context->CompressedCrc32 = LzpComputeCrc32(Context->CompressedCrc32,
+                                               BlockHeader,
+                                               LZMA_BLOCK_HEADER_SIZE);
 
-Return Value:
+    Context->CompressedSize += LZMA_BLOCK_HEADER_SIZE;
 
-    None.
+    //
+    // A block with no compressed data terminates the stream.
+    //
 
---*/
+    if (BlockHeader[0] == 0) {
+        if ((BlockHeader[1] != 0) ||
+            (BlockHeader[2] != 0) ||
+            (BlockHeader[3] != 0)) {
 
-{
+            return LzErrorCorruptData;
+        }
 
-    Decoder->NeedFlush = TRUE;
-    Decoder->RemainingLength = 0;
-    Decoder->WorkingSize = 0;
-    if (InitializeDictionary != FALSE) {
-        Decoder->ProcessedPosition = 0;
-        Decoder->CheckDictSize = 0;
-        Decoder->NeedReset = 1;
+        Decoder->Stage = LzmaStageFileFooter;
+        return LzSuccess;
+    }
 
-    } else if (InitializeState != FALSE) {
-        Decoder->NeedReset = 1;
+    if (BlockHeader[1] > LZMA_MAX_BLOCK_SIZE) {
+        return LzErrorCorruptData;
     }
 
-    return;
+    //
+    // Each block starts from a clean dictionary and state.
+    //
+
+    Decoder->BlockCompressedEnd = Context->CompressedSize + BlockHeader[0];
+    Decoder->BlockUncompressedEnd = Context->UncompressedSize + BlockHeader[1];
+    LzpLzmaDecoderReset(Decoder);
+    Decoder->Stage = LzmaStageData;
+    return LzSuccess;
 }
 
 LZ_STATUS
-LzpLzmaReadHeader (
-    PLZ_CONTEXT Context
+LzpLzmaDecodeData (
+    PLZ_CONTEXT Context,
+    LZ_FLUSH_OPTION Flush
     )
 
 /*++
 
 Routine Description:
 
-    This routine reads the file header out of a compressed LZMA stream, which
-    validates the magic value and reads the properties into the decoder.
+    This routine decodes compressed data in the data stage, advancing to the
+    next stage if the end of the compressed data is found.
 
 Arguments:
 
     Context - Supplies a pointer to the context.
 
+    Flush - Supplies the flush option, which indicates whether the decoder
+        should be flushed and terminated with this call or not.
+
 Return Value:
 
-    LZ Status code.
+    LZ Status code. LzErrorProgress is returned if no progress could be made
+    but more input may yet come.
 
 --*/
 
 {
 
+    INTN BytesComplete;
+    LZ_COMPLETION_STATUS CompletionStatus;
     PLZMA_DECODER Decoder;
-    UCHAR Header[LZMA_HEADER_SIZE];
-    ULONG Magic;
+    BOOL EndMark;
+    PUCHAR InBuffer;
+    UINTN InBufferSize;
+    UINTN InPosition;
+    UINTN InProcessed;
+    UINTN InSize;
+    UINTN OriginalBufferSize;
+    PVOID OriginalDict;
+    PUCHAR OutBuffer;
+    UINTN OutBufferSize;
+    UINTN OutPosition;
+    UINTN OutProcessed;
     LZ_STATUS Status;
 
     Decoder = Context->InternalState;
 
     //
-    // Read both the magic and the properties.
+    // Figure out which buffers to use: previously allocated internal
+    // buffers or the buffers coming in direct from the user.
     //
 
-    Status = LzpLzmaDecoderRead(Context, Header, sizeof(Header));
+    if (Context->Read != NULL) {
+        InBuffer = Decoder->AllocatedInput;
+        InBufferSize = LZMA_DECODE_DEFAULT_WORKING_SIZE;
+        InSize = Decoder->InputSize;
+        InPosition = Decoder->InputPosition;
+
+    } else {
+        InBuffer = (PUCHAR)(Context->Input);
+        InBufferSize = Context->InputSize;
+        InSize = Context->InputSize;
+        InPosition = 0;
+    }
+
+    if (Context->Write != NULL) {
+        OutBuffer = Decoder->AllocatedOutput;
+        OutPosition = Decoder->OutputPosition;
+        OutBufferSize = LZMA_DECODE_DEFAULT_WORKING_SIZE;
+
+    } else {
+        OutBuffer = Context->Output;
+        OutPosition = 0;
+        OutBufferSize = Context->OutputSize;
+    }
 
     //
-    // If progress is returned, that's a wink that nothing went wrong but the
-    // full size isn't there yet.
+    // If using the buffer, decode directly to the output buffer, since
+    // there's only one shot.
     //
 
-    if (Status == LzErrorProgress) {
-        return LzSuccess;
-    }
+    CompletionStatus = LzCompletionNotSpecified;
+    if ((Context->Write == NULL) && (Context->Read == NULL) &&
+        (Flush == LzFlushNow)) {
 
-    if (Status != LzSuccess) {
-        return Status;
-    }
+        OriginalDict = Decoder->Dict;
+        OriginalBufferSize = Decoder->DictBufferSize;
+        Decoder->Dict = Context->Output;
+        Decoder->DictBufferSize = Context->OutputSize;
+        Status = LzpLzmaDecodeToDictionary(Decoder,
+                                           Decoder->DictBufferSize,
+                                           Context->Input,
+                                           &InSize,
+                                           Decoder->HasEndMark,
+                                           &CompletionStatus);
+
+        Decoder->Dict = OriginalDict;
+        Decoder->DictBufferSize = OriginalBufferSize;
+        Context->CompressedCrc32 = LzpComputeCrc32(Context->CompressedCrc32,
+                                                   Context->Input,
+                                                   InSize);
+
+        Context->CompressedSize += InSize;
+        Context->Input += InSize;
+        Context->InputSize -= InSize;
+        Context->UncompressedCrc32 =
+                                LzpComputeCrc32(Context->UncompressedCrc32,
+                                                Context->Output,
+                                                Decoder->DictPosition);
+
+        Context->UncompressedSize += Decoder->DictPosition;
+        Context->Output += Decoder->DictPosition;
+        Context->OutputSize -= Decoder->DictPosition;
+        if ((Status == LzSuccess) &&
+            ((CompletionStatus == LzCompletionMoreInputRequired) ||
+             (CompletionStatus == LzCompletionNotFinished))) {
 
-    memcpy(&Magic, Header, sizeof(Magic));
+            Status = LzErrorInputEof;
+        }
+
+        if (Status != LzSuccess) {
+            return Status;
+        }
+
+    } else {
+
+        //
+        // This is the normal loop for decoding the stream.
+        //
+
+        while (TRUE) {
+            EndMark = FALSE;
+            if (InPosition >= InSize) {
+                if (Context->Read == NULL) {
+                    if (Flush != LzNoFlush) {
+                        EndMark = Decoder->HasEndMark;
+
+                    } else {
+                        break;
+                    }
+
+                } else if (Decoder->InputFinished == FALSE) {
+                    InSize = Context->Read(Context, InBuffer, InBufferSize);
+                    if (InSize == 0) {
+                        Decoder->InputFinished = TRUE;
+                        EndMark = Decoder->HasEndMark;
+
+                    } else if (InSize < 0) {
+                        Status = LzErrorRead;
+                        break;
+                    }
+
+                    InPosition = 0;
+
+                } else {
+                    EndMark = Decoder->HasEndMark;
+                }
+            }
+
+            InProcessed = InSize - InPosition;
+            OutProcessed = OutBufferSize - OutPosition;
+            if (OutProcessed == 0) {
+                Status = LzSuccess;
+                break;
+            }
+
+            Status = LzpLzmaDecodeToBuffer(Decoder,
+                                           OutBuffer + OutPosition,
+                                           &OutProcessed,
+                                           InBuffer + InPosition,
+                                           &InProcessed,
+                                           EndMark,
+                                           &CompletionStatus);
+
+            //
+            // Only add the portion of the buffer that's actually compressed
+            // data to the CRC.
+            //
+
+            Context->CompressedCrc32 =
+                                  LzpComputeCrc32(Context->CompressedCrc32,
+                                                  InBuffer + InPosition,
+                                                  InProcessed);
+
+            Context->CompressedSize += InProcessed;
+            InPosition += InProcessed;
+            OutPosition += OutProcessed;
+            if (Context->Write != NULL) {
+                BytesComplete = Context->Write(Context,
+                                               OutBuffer,
+                                               OutPosition);
+
+                if (BytesComplete != OutPosition) {
+                    Status = LzErrorWrite;
+                    break;
+                }
+            }
+
+            Context->UncompressedCrc32 =
+                                LzpComputeCrc32(Context->UncompressedCrc32,
+                                                OutBuffer,
+                                                OutPosition);
+
+            Context->UncompressedSize += OutPosition;
+            if (Context->Write != NULL) {
+                OutPosition = 0;
+            }
+
+            if (Status != LzSuccess) {
+                break;
+            }
+
+            if (CompletionStatus == LzCompletionFinishedWithMark) {
+                break;
+            }
+
+            if ((InProcessed == 0) && (OutProcessed == 0)) {
+                break;
+            }
+        }
+
+        if (Context->Read != NULL) {
+            Decoder->InputSize = InSize;
+            Decoder->InputPosition = InPosition;
+
+        } else {
+            Context->Input += InPosition;
+            Context->InputSize -= InPosition;
+            Context->Output += OutPosition;
+            Context->OutputSize -= OutPosition;
+        }
+
+        if (Status != LzSuccess) {
+            return Status;
+        }
+    }
 
     //
-    // Validate the magic value.
+    // See if the stream is complete, and advance the stage if so.
     //
 
-    if (Magic != LZMA_HEADER_MAGIC) {
-        return LzErrorMagic;
-    }
+    if ((CompletionStatus == LzCompletionFinishedWithMark) ||
+        ((Decoder->HasEndMark == FALSE) &&
+         (Flush != LzNoFlush) &&
+         (CompletionStatus == LzCompletionMaybeFinishedWithoutMark))) {
 
-    Status = LzpLzmaDecodeProperties(Context,
-                                     &(Header[LZMA_HEADER_MAGIC_SIZE]),
-                                     LZMA_HEADER_SIZE - LZMA_HEADER_MAGIC_SIZE);
+        if (Decoder->BlockStream != FALSE) {
+            if ((Context->CompressedSize != Decoder->BlockCompressedEnd) ||
+                (Context->UncompressedSize != Decoder->BlockUncompressedEnd)) {
 
-    if (Status != LzSuccess) {
-        return Status;
+                return LzErrorCorruptData;
+            }
+
+            Decoder->Stage = LzmaStageBlockHeader;
+
+        } else if (Decoder->FileWrapper != FALSE) {
+            Decoder->Stage = LzmaStageFileFooter;
+
+        } else {
+            Decoder->Stage = LzmaStageComplete;
+        }
     }
 
-    Context->CompressedCrc32 = LzpComputeCrc32(Context->CompressedCrc32,
-                                               Header,
-                                               LZMA_HEADER_SIZE);
+    //
+    // If the stream was supposed to finish but didn't, that's an error.
+    //
 
-    Context->CompressedSize += LZMA_HEADER_SIZE;
+    if ((Flush == LzFlushNow) && (Decoder->Stage == LzmaStageData)) {
+        Status = LzErrorInputEof;
+        return Status;
+    }
 
     //
-    // Advance to the data portion.
+    // If no progress was made, fail. If the caller wanted to flush, make
+    // the error permanent.
     //
 
-    Decoder->Stage = LzmaStageData;
-    return Status;
+    if ((InBuffer == Context->Input) && (OutBuffer == Context->Output)) {
+        if (Flush == LzNoFlush) {
+            return LzErrorProgress;
+        }
+
+        Status = LzErrorInvalidParameter;
+        if (CompletionStatus == LzCompletionMoreInputRequired) {
+            Status = LzErrorInputEof;
+        }
+
+        return Status;
+    }
+
+    return LzSuccess;
 }
 
 LZ_STATUS
@@ -1902,19 +2449,23 @@ Return Value:
 
                 Symbol = 0x1;
                 do {
-                    LZMA_RANGE_READ(Prob + Symbol,
-                                    ProbValue,
-                                    Bound,
-                                    Range,
-                                    Code,
-                                    Buffer);
-
-                    LZMA_RANGE_GET_BIT(Prob + Symbol,
-                                       ProbValue,
-                                       Bound,
-                                       Range,
-                                       Code,
-                                       Symbol);
+                    LZMA_RANGE_DECODE_BIT(Prob + Symbol,
+                                          ProbValue,
+                                          Bound,
+                                          Range,
+                                          Code,
+                                          Buffer,
+                                          Mask,
+                                          Symbol);
+
+                    LZMA_RANGE_DECODE_BIT(Prob + Symbol,
+                                          ProbValue,
+                                          Bound,
+                                          Range,
+                                          Code,
+                                          Buffer,
+                                          Mask,
+                                          Symbol);
 
                 } while (Symbol < 0x100);
 
@@ -1942,26 +2493,21 @@ Return Value:
                     MatchByte <<= 1;
                     Bit = MatchByte & Offset;
                     LiteralProb = Prob + Offset + Bit + Symbol;
-                    LZMA_RANGE_READ(LiteralProb,
-                                    ProbValue,
-                                    Bound,
-                                    Range,
-                                    Code,
-                                    Buffer);
-
-                    if (LZMA_RANGE_IS_BIT_0(Code, Bound)) {
-                        Offset &= ~Bit;
+                    LZMA_RANGE_DECODE_BIT(LiteralProb,
+                                          ProbValue,
+                                          Bound,
+                                          Range,
+                                          Code,
+                                          Buffer,
+                                          Mask,
+                                          Symbol);
 
-                    } else {
-                        Offset &= Bit;
-                    }
+                    //
+                    // Keep using the match byte only while the decoded bits
+                    // agree with it.
+                    //
 
-                    LZMA_RANGE_GET_BIT(LiteralProb,
-                                       ProbValue,
-                                       Bound,
-                                       Range,
-                                       Code,
-                                       Symbol);
+                    Offset &= Bit ^ ~Mask;
 
                 } while (Symbol < 0x100);
             }
@@ -2172,19 +2718,14 @@ Return Value:
 
         Length = 0x1;
         do {
-            LZMA_RANGE_READ(LengthProb + Length,
-                            ProbValue,
-                            Bound,
-                            Range,
-                            Code,
-                            Buffer);
-
-            LZMA_RANGE_GET_BIT(LengthProb + Length,
-                               ProbValue,
-                               Bound,
-                               Range,
-                               Code,
-                               Length);
+            LZMA_RANGE_DECODE_BIT(LengthProb + Length,
+                                  ProbValue,
+                                  Bound,
+                                  Range,
+                                  Code,
+                                  Buffer,
+                                  Mask,
+                                  Length);
 
         } while (Length < LengthLimit);
 
@@ -2208,19 +2749,14 @@ Return Value:
 
             Distance = 0x1;
             do {
-                LZMA_RANGE_READ(Prob + Distance,
-                                ProbValue,
-                                Bound,
-                                Range,
-                                Code,
-                                Buffer);
-
-                LZMA_RANGE_GET_BIT(Prob + Distance,
-                                   ProbValue,
-                                   Bound,
-                                   Range,
-                                   Code,
-                                   Distance);
+                LZMA_RANGE_DECODE_BIT(Prob + Distance,
+                                      ProbValue,
+                                      Bound,
+                                      Range,
+                                      Code,
+                                      Buffer,
+                                      Mask,
+                                      Distance);
 
             } while (Distance < LZMA_POSITION_SLOTS);
 
@@ -2360,11 +2896,24 @@ Return Value:
             Source = Position - DictPosition;
             CopyEnd = Destination + CurrentLength;
             DictPosition += CurrentLength;
-            do {
+
+            //
+            // If the source is at least a word back, then a word at a time
+            // can be copied without the source and destination overlapping.
+            // Closer sources repeat a short pattern and must go byte by byte.
+            //
+
+            if (Rep0 >= sizeof(UINTN)) {
+                while (CopyEnd - Destination >= sizeof(UINTN)) {
+                    memcpy(Destination, Destination + Source, sizeof(UINTN));
+                    Destination += sizeof(UINTN);
+                }
+            }
+
+            while (Destination != CopyEnd) {
                 *Destination = (UCHAR)*(Destination + Source);
                 Destination += 1;
-
-            } while (Destination != CopyEnd);
+            }
 
         } else {
             do {
@@ -340,6 +340,13 @@ LzpLzmaCopyOutput (
     PLZ_CONTEXT Context
     );
 
+LZ_STATUS
+LzpLzmaWriteBlockOutput (
+    PLZ_CONTEXT Context,
+    PCVOID Buffer,
+    UINTN Size
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -537,12 +544,27 @@ Return Value:
     // encode directly to memory if no read/write functions are supplied.
     //
 
-    if (Context->UncompressedSize == 0) {
+    if ((Context->UncompressedSize == 0) &&
+        (Encoder->MatchFinderData.DirectInput == FALSE)) {
+
         if ((Flush != LzNoFlush) && (Context->Read == NULL)) {
             Context->Reallocate(Encoder->MatchFinderData.BufferBase, 0);
             Encoder->MatchFinderData.BufferBase = (PUCHAR)(Context->Input);
             Encoder->MatchFinderData.DirectInputRemaining = Context->InputSize;
             Encoder->MatchFinderData.DirectInput = TRUE;
+
+            //
+            // The match finder doesn't account for direct input as it goes,
+            // so consume it all now.
+            //
+
+            Context->UncompressedSize = Context->InputSize;
+            Context->UncompressedCrc32 = LzpComputeCrc32(0,
+                                                         Context->Input,
+                                                         Context->InputSize);
+
+            Context->Input += Context->InputSize;
+            Context->InputSize = 0;
         }
     }
 
@@ -754,6 +776,324 @@ Return Value:
     return Status;
 }
 
+LZ_STATUS
+LzLzmaInitializeBlockEncoder (
+    PLZ_CONTEXT Context,
+    PLZMA_ENCODER_PROPERTIES Properties
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes a given LZ context for writing a block stream, and
+    writes out the stream header. Blocks are compressed separately with
+    LzLzmaCompressBlock and then added to the stream in order with
+    LzLzmaWriteBlock. This routine must be called before any blocks are
+    compressed.
+
+Arguments:
+
+    Context - Supplies a pointer to the context, which should already be
+        initialized by the user. If the write function is not supplied,
+        output goes to the output buffer.
+
+    Properties - Supplies a pointer to the properties that each block will be
+        compressed with.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+{
+
+    PLZMA_ENCODER Encoder;
+    UCHAR Header[LZMA_HEADER_SIZE];
+    ULONG Magic;
+    UINTN PropertiesSize;
+    LZ_STATUS Status;
+
+    if (Context->Reallocate == NULL) {
+        return LzErrorInvalidParameter;
+    }
+
+    //
+    // Initialize the CRC table now, since blocks may be compressed on several
+    // threads at once later.
+    //
+
+    LzpCrcInitialize();
+    Context->CompressedCrc32 = 0;
+    Context->UncompressedCrc32 = 0;
+    Context->CompressedSize = 0;
+    Context->UncompressedSize = 0;
+
+    //
+    // Run the properties through an encoder structure so that the header
+    // describes exactly what each block's encoder will use.
+    //
+
+    Encoder = Context->Reallocate(NULL, sizeof(LZMA_ENCODER));
+    if (Encoder == NULL) {
+        return LzErrorMemory;
+    }
+
+    memset(Encoder, 0, sizeof(LZMA_ENCODER));
+    Status = LzpLzmaEncoderSetProperties(Encoder, Properties);
+    if (Status == LzSuccess) {
+        Magic = LZMA_BLOCK_HEADER_MAGIC;
+        memcpy(Header, &Magic, LZMA_HEADER_MAGIC_SIZE);
+        PropertiesSize = LZMA_HEADER_SIZE - LZMA_HEADER_MAGIC_SIZE;
+        Status = LzpLzmaWriteProperties(Encoder,
+                                        &(Header[LZMA_HEADER_MAGIC_SIZE]),
+                                        &PropertiesSize);
+    }
+
+    Context->Reallocate(Encoder, 0);
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    Status = LzpLzmaWriteBlockOutput(Context, Header, LZMA_HEADER_SIZE);
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    Context->CompressedCrc32 = LzpComputeCrc32(0, Header, LZMA_HEADER_SIZE);
+    Context->CompressedSize = LZMA_HEADER_SIZE;
+    return LzSuccess;
+}
+
+LZ_STATUS
+LzLzmaCompressBlock (
+    PLZ_CONTEXT Context,
+    PLZMA_ENCODER_PROPERTIES Properties
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compresses the entire input buffer of the given context into
+    a single block, complete with its block header, in the output buffer. The
+    read and write functions are not used. Different contexts can compress
+    blocks concurrently.
+
+Arguments:
+
+    Context - Supplies a pointer to the context. Only the reallocate routine
+        and the input and output buffers need to be set up. The output buffer
+        should be at least LZMA_BLOCK_BOUND(InputSize) bytes. On success, the
+        input and output pointers and sizes are advanced.
+
+    Properties - Supplies a pointer to the properties to compress with. These
+        should be the same properties used to initialize the block encoder.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+{
+
+    LZ_CONTEXT Block;
+    ULONG BlockHeader[LZMA_BLOCK_HEADER_SIZE / sizeof(ULONG)];
+    LZMA_ENCODER_PROPERTIES BlockProperties;
+    LZ_STATUS FinishStatus;
+    LZ_STATUS Status;
+
+    if ((Context->Reallocate == NULL) ||
+        (Context->InputSize == 0) ||
+        (Context->InputSize > LZMA_MAX_BLOCK_SIZE)) {
+
+        return LzErrorInvalidParameter;
+    }
+
+    if (Context->OutputSize <= LZMA_BLOCK_HEADER_SIZE) {
+        return LzErrorOutputEof;
+    }
+
+    //
+    // Compress into a private context in one shot, which encodes directly
+    // from the input buffer and into the output buffer. Blocks always end
+    // with a marker so that they can be decoded without knowing their size.
+    //
+
+    memset(&Block, 0, sizeof(LZ_CONTEXT));
+    Block.Context = Context->Context;
+    Block.Reallocate = Context->Reallocate;
+    Block.Input = Context->Input;
+    Block.InputSize = Context->InputSize;
+    Block.Output = Context->Output + LZMA_BLOCK_HEADER_SIZE;
+    Block.OutputSize = Context->OutputSize - LZMA_BLOCK_HEADER_SIZE;
+    memcpy(&BlockProperties, Properties, sizeof(LZMA_ENCODER_PROPERTIES));
+    BlockProperties.EndMark = TRUE;
+    Status = LzLzmaInitializeEncoder(&Block, &BlockProperties, FALSE);
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    Status = LzLzmaEncode(&Block, LzFlushNow);
+    FinishStatus = LzLzmaFinishEncode(&Block);
+    if (Status == LzStreamComplete) {
+        Status = FinishStatus;
+    }
+
+    if (Status != LzStreamComplete) {
+        if (Status == LzSuccess) {
+            Status = LzErrorOutputEof;
+        }
+
+        return Status;
+    }
+
+    BlockHeader[0] = (ULONG)(Block.CompressedSize);
+    BlockHeader[1] = (ULONG)(Block.UncompressedSize);
+    BlockHeader[2] = Block.CompressedCrc32;
+    BlockHeader[3] = Block.UncompressedCrc32;
+    memcpy(Context->Output, BlockHeader, LZMA_BLOCK_HEADER_SIZE);
+    Context->Input += Context->InputSize;
+    Context->InputSize = 0;
+    Context->Output += LZMA_BLOCK_HEADER_SIZE + Block.CompressedSize;
+    Context->OutputSize -= LZMA_BLOCK_HEADER_SIZE + Block.CompressedSize;
+    return LzSuccess;
+}
+
+LZ_STATUS
+LzLzmaWriteBlock (
+    PLZ_CONTEXT Context,
+    PCVOID Block,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends a block created by LzLzmaCompressBlock to a block
+    stream.
+
+Arguments:
+
+    Context - Supplies a pointer to the context initialized with
+        LzLzmaInitializeBlockEncoder.
+
+    Block - Supplies a pointer to the compressed block, starting with its block
+        header.
+
+    Size - Supplies the size of the compressed block in bytes, including the
+        block header.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+{
+
+    ULONG BlockHeader[LZMA_BLOCK_HEADER_SIZE / sizeof(ULONG)];
+    LZ_STATUS Status;
+
+    if (Size <= LZMA_BLOCK_HEADER_SIZE) {
+        return LzErrorInvalidParameter;
+    }
+
+    memcpy(BlockHeader, Block, LZMA_BLOCK_HEADER_SIZE);
+    if ((BlockHeader[0] == 0) ||
+        (BlockHeader[0] != Size - LZMA_BLOCK_HEADER_SIZE)) {
+
+        return LzErrorInvalidParameter;
+    }
+
+    Status = LzpLzmaWriteBlockOutput(Context, Block, Size);
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    //
+    // Fold in the CRCs the block already carries rather than running over
+    // all the data again.
+    //
+
+    Context->CompressedCrc32 = LzpComputeCrc32(Context->CompressedCrc32,
+                                               Block,
+                                               LZMA_BLOCK_HEADER_SIZE);
+
+    Context->CompressedCrc32 = LzpCombineCrc32(Context->CompressedCrc32,
+                                               BlockHeader[2],
+                                               BlockHeader[0]);
+
+    Context->UncompressedCrc32 = LzpCombineCrc32(Context->UncompressedCrc32,
+                                                 BlockHeader[3],
+                                                 BlockHeader[1]);
+
+    Context->CompressedSize += Size;
+    Context->UncompressedSize += BlockHeader[1];
+    return LzSuccess;
+}
+
+LZ_STATUS
+LzLzmaFinishBlockEncoder (
+    PLZ_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine terminates a block stream, writing the final block header
+    and the file footer.
+
+Arguments:
+
+    Context - Supplies a pointer to the context initialized with
+        LzLzmaInitializeBlockEncoder.
+
+Return Value:
+
+    LzStreamComplete on success.
+
+    Other LZ Status codes on failure.
+
+--*/
+
+{
+
+    UCHAR Footer[LZMA_FOOTER_SIZE];
+    LZ_STATUS Status;
+    UCHAR Terminator[LZMA_BLOCK_HEADER_SIZE];
+
+    memset(Terminator, 0, LZMA_BLOCK_HEADER_SIZE);
+    Status = LzpLzmaWriteBlockOutput(Context,
+                                     Terminator,
+                                     LZMA_BLOCK_HEADER_SIZE);
+
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    Context->CompressedCrc32 = LzpComputeCrc32(Context->CompressedCrc32,
+                                               Terminator,
+                                               LZMA_BLOCK_HEADER_SIZE);
+
+    Context->CompressedSize += LZMA_BLOCK_HEADER_SIZE;
+
+    memcpy(&(Footer[0]), &(Context->UncompressedSize), sizeof(ULONGLONG));
+    memcpy(&(Footer[8]), &(Context->CompressedCrc32), sizeof(ULONG));
+    memcpy(&(Footer[12]), &(Context->UncompressedCrc32), sizeof(ULONG));
+
+    Status = LzpLzmaWriteBlockOutput(Context, Footer, LZMA_FOOTER_SIZE);
+    if (Status != LzSuccess) {
+        return Status;
+    }
+
+    return LzStreamComplete;
+}
+
 //
 // Functions internal to the encoder that are referenced by other encoder files.
 //
@@ -3347,3 +3687,51 @@ Return Value:
     return Finished;
 }
 
+LZ_STATUS
+LzpLzmaWriteBlockOutput (
+    PLZ_CONTEXT Context,
+    PCVOID Buffer,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes out a portion of a block stream, either with the write
+    function or into the output buffer. The caller is responsible for
+    accounting for the data in the compressed size and CRC.
+
+Arguments:
+
+    Context - Supplies a pointer to the context.
+
+    Buffer - Supplies a pointer to the data to write.
+
+    Size - Supplies the number of bytes to write.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+{
+
+    if (Context->Write != NULL) {
+        if (Context->Write(Context, (PVOID)Buffer, Size) != Size) {
+            return LzErrorWrite;
+        }
+
+    } else {
+        if (Context->OutputSize < Size) {
+            return LzErrorOutputEof;
+        }
+
+        memcpy(Context->Output, Buffer, Size);
+        Context->Output += Size;
+        Context->OutputSize -= Size;
+    }
+
+    return LzSuccess;
+}
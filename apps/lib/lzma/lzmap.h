@@ -73,12 +73,8 @@ Module Name:
 
 #define LZMA_MIN_MATCH_LENGTH 2
 
-#define LZMA_PROPERTIES_SIZE 5
-
 #define LZMA_RANGE_TOP_VALUE (1 << 24)
 
-#define LZMA_FOOTER_SIZE 16
-
 //
 // Define the maximum size of an LZMA input symbol. The maximum number of bits
 // is log2((2^11 / 31) ^ 22) + 26 = 134 + 26 = 160.
@@ -93,6 +89,7 @@ Module Name:
 typedef enum _LZMA_STAGE {
     LzmaStageFileHeader,
     LzmaStageData,
+    LzmaStageBlockHeader,
     LzmaStageFlushingOutput,
     LzmaStageFileFooter,
     LzmaStageComplete
@@ -159,3 +156,30 @@ Return Value:
 
 --*/
 
+ULONG
+LzpCombineCrc32 (
+    ULONG Crc1,
+    ULONG Crc2,
+    ULONGLONG Size2
+    );
+
+/*++
+
+Routine Description:
+
+    This routine combines two CRC-32 values into the CRC-32 of the
+    concatenation of the two buffers they were computed over.
+
+Arguments:
+
+    Crc1 - Supplies the CRC-32 of the first buffer.
+
+    Crc2 - Supplies the CRC-32 of the second buffer.
+
+    Size2 - Supplies the size of the second buffer, in bytes.
+
+Return Value:
+
+    Returns the CRC-32 of the first buffer followed by the second.
+
+--*/
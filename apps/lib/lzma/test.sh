@@ -47,9 +47,59 @@ for f in $files; do
         cmp $f.lz$l $f.lzm$l
         cmp $f.lzm$l.txt $f.lz$l.txt
 
+        # Compress into a block stream with several threads.
+        lzma -clv -$l -T4 -i $f -o $f.lzb$l 2>$f.lzb$l.txt
+
+        # Compress into a block stream with one thread.
+        lzma -clv -$l -T1 --block-size=8388608 -i $f -o $f.lzs$l \
+            2>$f.lzs$l.txt
+
+        # Decompress the block stream, both streaming and in memory mode.
+        lzma -dlv -i $f.lzb$l -o $f.outb$l 2>$f.b$l.txt
+        cmp $f.outb$l $f
+        lzma -d --memory-test=65536 -i $f.lzb$l -o $f.outb$l
+        cmp $f.outb$l $f
+
+        # Decompress the block stream several blocks at a time.
+        lzma -dlv -T4 -i $f.lzb$l -o $f.outb$l 2>$f.bt$l.txt
+        cmp $f.outb$l $f
+        cmp $f.b$l.txt $f.bt$l.txt
+
+        # Multiple threads should fall back to the regular decoder on a
+        # single stream.
+        lzma -d -T4 -i $f.lz$l -o $f.outb$l
+        cmp $f.outb$l $f
+
+        # The number of threads shouldn't change the output.
+        cmp $f.lzb$l $f.lzs$l
+        cmp $f.lzb$l.txt $f.lzs$l.txt
+
         # Clean up.
         rm $f.lz$l $f.lzm$l $f.out$l $f.lzm$l.txt
         rm $f.lz$l.txt $f.$l.txt
+        rm $f.lzb$l $f.lzs$l $f.outb$l $f.lzb$l.txt $f.lzs$l.txt $f.b$l.txt
+        rm $f.bt$l.txt
+    done
+done
+
+#
+# Measure compression and decompression throughput for a single stream and for
+# block streams with increasing numbers of threads.
+#
+
+set +x
+for f in $files; do
+    for l in 4 9; do
+        lzma -c -$l --stats -i $f -o $f.bench 2>>bench.txt
+        lzma -d --stats -i $f.bench -o $f.bench.out 2>>bench.txt
+        for t in 1 2 4 8; do
+            lzma -c -$l -T$t --stats -i $f -o $f.bench 2>>bench.txt
+            lzma -d -T$t --stats -i $f.bench -o $f.bench.out 2>>bench.txt
+        done
+
+        rm $f.bench $f.bench.out
     done
 done
 
+cat bench.txt
+rm bench.txt
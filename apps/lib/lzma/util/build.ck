@@ -26,11 +26,13 @@ Module Name:
 
 --*/
 
-from menv import application, mconfig;
+from menv import addConfig, application, mconfig;
 
 function build() {
     var app;
     var buildApp;
+    var buildConfig;
+    var buildOs = mconfig.build_os;
     var entries;
     var sources;
 
@@ -43,10 +45,21 @@ function build() {
         "inputs": sources + ["apps/lib/lzma:liblzma"],
     };
 
+    //
+    // The build version uses pthreads for compressing on multiple threads,
+    // except on Windows where it sticks to a single thread.
+    //
+
+    buildConfig = {};
+    if ((buildOs != "Windows") && (buildOs != "Minoca")) {
+        addConfig(buildConfig, "DYNLIBS", "-lpthread");
+    }
+
     buildApp = {
         "label": "build_lzma",
         "output": "lzma",
         "inputs": sources + ["apps/lib/lzma:build_liblzma"],
+        "config": buildConfig,
         "build": true,
         "prefix": "build",
         "binplace": "tools/bin"
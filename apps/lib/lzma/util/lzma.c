@@ -36,11 +36,24 @@ Module Name:
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 #include <minoca/lib/types.h>
 #include <minoca/lib/lzma.h>
 
+//
+// Windows builds of the utility run block streams on the main thread.
+//
+
+#ifndef _WIN32
+
+#include <pthread.h>
+
+#define LZMA_UTIL_THREADS 1
+
+#endif
+
 //
 // --------------------------------------------------------------------- Macros
 //
@@ -84,16 +97,40 @@ Module Name:
     "  --pb=<count> - Set number of position bits [0, 4] (default 2).\n" \
     "  --mf=<type> - Set match finder [hc4, bt2, bt3, bt4] (default bt4).\n" \
     "  --no-eos - Do not write end of stream marker.\n" \
+    "  -T, --threads=<count> - Use the given number of threads, or 0 to use\n"\
+    "      one thread per processor (default 1). Compressing with multiple\n" \
+    "      threads produces a block stream, made of independently compressed\n"\
+    "      blocks. Decompressing a block stream with multiple threads\n" \
+    "      decompresses several blocks at once.\n" \
+    "  --block-size=<size> - Set the uncompressed size of each block in a \n" \
+    "      block stream, and produce a block stream even if using a single\n"\
+    "      thread (default 8MB).\n" \
+    "  --stats - Print the time taken and throughput for each stream.\n" \
     "  --help - Display this help message.\n" \
     "  --version -- Display the version information and exit.\n"
 
-#define LZMA_OPTIONS_STRING "cdi:lo:0123456789hvV"
+#define LZMA_OPTIONS_STRING "cdi:lo:0123456789T:hvV"
 
 #define LZMA_UTIL_VERSION_MAJOR 1
 #define LZMA_UTIL_VERSION_MINOR 0
 
 #define LZMA_UTIL_OPTION_VERBOSE 0x00000001
 #define LZMA_UTIL_OPTION_LIST 0x00000002
+#define LZMA_UTIL_OPTION_STATS 0x00000004
+
+//
+// Define the default and minimum uncompressed block sizes for block streams.
+//
+
+#define LZMA_UTIL_DEFAULT_BLOCK_SIZE (8 * 1024 * 1024)
+#define LZMA_UTIL_MIN_BLOCK_SIZE (64 * 1024)
+
+//
+// Define the number of blocks that can be in flight for each thread, which
+// allows the main thread to read ahead and write behind the workers.
+//
+
+#define LZMA_UTIL_BLOCKS_PER_THREAD 2
 
 //
 // ------------------------------------------------------ Data Type Definitions
@@ -111,7 +148,9 @@ typedef enum _LZMA_UTIL_ARGUMENT {
     LzmaUtilLp,
     LzmaUtilPb,
     LzmaUtilMf,
-    LzmaUtilNoEos
+    LzmaUtilNoEos,
+    LzmaUtilBlockSize,
+    LzmaUtilStats
 } LZMA_UTIL_ARGUMENT, *PLZMA_UTIL_ARGUMENT;
 
 typedef enum _LZMA_UTIL_ACTION {
@@ -120,11 +159,134 @@ typedef enum _LZMA_UTIL_ACTION {
     LzmaActionDecompress
 } LZMA_UTIL_ACTION, *PLZMA_UTIL_ACTION;
 
+typedef enum _LZMA_UTIL_BLOCK_STATE {
+    LzmaBlockFree,
+    LzmaBlockQueued,
+    LzmaBlockBusy,
+    LzmaBlockComplete
+} LZMA_UTIL_BLOCK_STATE, *PLZMA_UTIL_BLOCK_STATE;
+
+/*++
+
+Structure Description:
+
+    This structure stores a single block of a block stream as it makes its
+    way through the worker threads.
+
+Members:
+
+    State - Stores the state of the block.
+
+    Status - Stores the result of processing the block.
+
+    Input - Stores a pointer to the input buffer.
+
+    InputCapacity - Stores the size of the input buffer allocation.
+
+    InputSize - Stores the number of valid bytes in the input buffer.
+
+    Output - Stores a pointer to the output buffer.
+
+    OutputCapacity - Stores the size of the output buffer allocation.
+
+    OutputSize - Stores the number of valid bytes in the output buffer.
+
+--*/
+
+typedef struct _LZMA_UTIL_BLOCK {
+    LZMA_UTIL_BLOCK_STATE State;
+    LZ_STATUS Status;
+    PUCHAR Input;
+    UINTN InputCapacity;
+    UINTN InputSize;
+    PUCHAR Output;
+    UINTN OutputCapacity;
+    UINTN OutputSize;
+} LZMA_UTIL_BLOCK, *PLZMA_UTIL_BLOCK;
+
+/*++
+
+Structure Description:
+
+    This structure stores the application context.
+
+Members:
+
+    Lz - Stores the LZ library context for the stream being processed.
+
+    EncoderProperties - Stores the encoder properties from the command line.
+
+    Options - Stores a bitfield of LZMA_UTIL_OPTION_* flags.
+
+    MemoryTest - Stores the buffer size to use in memory test mode, or 0 to
+        use the read and write functions.
+
+    ThreadCount - Stores the number of worker threads to use.
+
+    BlockSize - Stores the uncompressed size of each block in a block stream,
+        or 0 if not producing a block stream.
+
+    BlockProperties - Stores the properties blocks are compressed with.
+
+    BlockAction - Stores whether blocks are being compressed or decompressed.
+
+    StreamHeader - Stores the header of the stream being decompressed, which
+        is peeked at to detect block streams.
+
+    PendingInput - Stores a pointer to input already read from the file but
+        not yet handed to the library.
+
+    PendingInputSize - Stores the number of bytes of pending input.
+
+    Blocks - Stores the array of blocks in flight.
+
+    BlockCount - Stores the number of elements in the blocks array.
+
+    NextJob - Stores the sequence number of the next block a worker should
+        pick up.
+
+    Exit - Stores a boolean indicating that the worker threads should exit.
+
+    Lock - Stores the lock protecting the block states.
+
+    JobReady - Stores the condition workers wait on for new blocks.
+
+    JobComplete - Stores the condition the main thread waits on for blocks
+        to finish.
+
+    Threads - Stores the array of worker thread handles.
+
+    StartedThreadCount - Stores the number of worker threads running.
+
+--*/
+
 typedef struct _LZMA_UTIL {
     LZ_CONTEXT Lz;
     LZMA_ENCODER_PROPERTIES EncoderProperties;
     ULONG Options;
     UINTN MemoryTest;
+    UINTN ThreadCount;
+    UINTN BlockSize;
+    LZMA_ENCODER_PROPERTIES BlockProperties;
+    LZMA_UTIL_ACTION BlockAction;
+    UCHAR StreamHeader[LZMA_HEADER_SIZE];
+    PUCHAR PendingInput;
+    UINTN PendingInputSize;
+    PLZMA_UTIL_BLOCK Blocks;
+    UINTN BlockCount;
+    UINTN NextJob;
+    BOOL Exit;
+
+#ifdef LZMA_UTIL_THREADS
+
+    pthread_mutex_t Lock;
+    pthread_cond_t JobReady;
+    pthread_cond_t JobComplete;
+    pthread_t *Threads;
+    UINTN StartedThreadCount;
+
+#endif
+
 } LZMA_UTIL, *PLZMA_UTIL;
 
 //
@@ -145,6 +307,68 @@ LzpUtilRunMemoryTest (
     LZMA_UTIL_ACTION Action
     );
 
+INT
+LzpUtilCompressBlocks (
+    PLZMA_UTIL Context
+    );
+
+BOOL
+LzpUtilIsBlockStream (
+    PLZMA_UTIL Context
+    );
+
+INT
+LzpUtilDecompressBlocks (
+    PLZMA_UTIL Context
+    );
+
+LZ_STATUS
+LzpUtilReadInput (
+    PLZMA_UTIL Context,
+    PVOID Buffer,
+    UINTN Size
+    );
+
+INT
+LzpUtilStartBlocks (
+    PLZMA_UTIL Context,
+    UINTN InputCapacity,
+    UINTN OutputCapacity
+    );
+
+VOID
+LzpUtilStopBlocks (
+    PLZMA_UTIL Context
+    );
+
+VOID
+LzpUtilQueueBlock (
+    PLZMA_UTIL Context,
+    PLZMA_UTIL_BLOCK Block
+    );
+
+VOID
+LzpUtilWaitForBlock (
+    PLZMA_UTIL Context,
+    PLZMA_UTIL_BLOCK Block
+    );
+
+PVOID
+LzpUtilWorkerThread (
+    PVOID Parameter
+    );
+
+VOID
+LzpUtilProcessBlock (
+    PLZMA_UTIL Context,
+    PLZMA_UTIL_BLOCK Block
+    );
+
+ULONGLONG
+LzpUtilGetMicroseconds (
+    VOID
+    );
+
 PVOID
 LzpUtilReallocate (
     PVOID Allocation,
@@ -198,6 +422,9 @@ struct option LzmaLongOptions[] = {
     {"pb", required_argument, 0, LzmaUtilPb},
     {"mf", required_argument, 0, LzmaUtilMf},
     {"no-eos", no_argument, 0, LzmaUtilNoEos},
+    {"threads", required_argument, 0, 'T'},
+    {"block-size", required_argument, 0, LzmaUtilBlockSize},
+    {"stats", no_argument, 0, LzmaUtilStats},
     {"help", no_argument, 0, 'h'},
     {"version", no_argument, 0, 'V'},
     {"verbose", no_argument, 0, 'v'},
@@ -272,6 +499,7 @@ Return Value:
     Context.Lz.Write = LzpUtilWrite;
     LzLzmaInitializeProperties(&(Context.EncoderProperties));
     Context.EncoderProperties.EndMark = TRUE;
+    Context.ThreadCount = 1;
     Status = 1;
     TotalStatus = 0;
 
@@ -444,6 +672,45 @@ Return Value:
             Context.EncoderProperties.EndMark = FALSE;
             break;
 
+        case 'T':
+            Integer = LzpUtilGetNumericOption(optarg, 0, 256);
+            if (Integer < 0) {
+                goto MainEnd;
+            }
+
+            if (Integer == 0) {
+                Integer = 1;
+
+#ifdef LZMA_UTIL_THREADS
+
+                Integer = sysconf(_SC_NPROCESSORS_ONLN);
+                if (Integer <= 0) {
+                    Integer = 1;
+                }
+
+#endif
+
+            }
+
+            Context.ThreadCount = Integer;
+            break;
+
+        case LzmaUtilBlockSize:
+            Integer = LzpUtilGetNumericOption(optarg,
+                                              LZMA_UTIL_MIN_BLOCK_SIZE,
+                                              LZMA_MAX_BLOCK_SIZE);
+
+            if (Integer < 0) {
+                goto MainEnd;
+            }
+
+            Context.BlockSize = Integer;
+            break;
+
+        case LzmaUtilStats:
+            Context.Options |= LZMA_UTIL_OPTION_STATS;
+            break;
+
         case 'v':
             Context.Options |= LZMA_UTIL_OPTION_VERBOSE;
             break;
@@ -474,6 +741,28 @@ Return Value:
         goto MainEnd;
     }
 
+    //
+    // Multiple threads compress using a block stream.
+    //
+
+    if ((Context.ThreadCount > 1) && (Context.BlockSize == 0)) {
+        Context.BlockSize = LZMA_UTIL_DEFAULT_BLOCK_SIZE;
+    }
+
+#ifndef LZMA_UTIL_THREADS
+
+    Context.ThreadCount = 1;
+
+#endif
+
+    if ((Context.BlockSize != 0) && (Context.MemoryTest != 0)) {
+        fprintf(stderr,
+                "Error: Block streams cannot be combined with memory test "
+                "mode.\n");
+
+        goto MainEnd;
+    }
+
     //
     // Print the listing header.
     //
@@ -602,6 +891,7 @@ Return Value:
 {
 
     PCSTR BaseName;
+    ULONGLONG Elapsed;
     size_t InLength;
     PSTR LastDot;
     PLZ_CONTEXT Lz;
@@ -611,10 +901,13 @@ Return Value:
     ULONG Ratio;
     CHAR RatioString[32];
     PCSTR Search;
+    ULONGLONG StartTime;
     INT Status;
 
     Lz = &(Context->Lz);
     OutPathBuffer = NULL;
+    StartTime = LzpUtilGetMicroseconds();
+    Context->PendingInputSize = 0;
     Status = 2;
 
     //
@@ -730,7 +1023,18 @@ Return Value:
         goto ProcessStreamEnd;
     }
 
-    if (Action == LzmaActionCompress) {
+    //
+    // The block stream routines print their own errors. Their return values
+    // are dropped so that a failed stream exits with the same status whether
+    // or not it went through the threaded path.
+    //
+
+    if ((Action == LzmaActionCompress) && (Context->BlockSize != 0)) {
+        if (LzpUtilCompressBlocks(Context) != 0) {
+            goto ProcessStreamEnd;
+        }
+
+    } else if (Action == LzmaActionCompress) {
         LzStatus = LzLzmaInitializeEncoder(Lz,
                                            &(Context->EncoderProperties),
                                            TRUE);
@@ -761,6 +1065,11 @@ Return Value:
             goto ProcessStreamEnd;
         }
 
+    } else if (LzpUtilIsBlockStream(Context) != FALSE) {
+        if (LzpUtilDecompressBlocks(Context) != 0) {
+            goto ProcessStreamEnd;
+        }
+
     } else {
         LzStatus = LzLzmaInitializeDecoder(Lz, NULL, TRUE);
         if (LzStatus != LzSuccess) {
@@ -815,6 +1124,29 @@ Return Value:
         }
     }
 
+    //
+    // Print the throughput, measured against the uncompressed size.
+    //
+
+    if ((Context->Options & LZMA_UTIL_OPTION_STATS) != 0) {
+        Elapsed = LzpUtilGetMicroseconds() - StartTime;
+        if (Elapsed == 0) {
+            Elapsed = 1;
+        }
+
+        fprintf(stderr,
+                "%s: %s %lld bytes in %lld.%06lld seconds, %lld.%02lld MB/s, "
+                "%d thread(s)\n",
+                InputPath,
+                (Action == LzmaActionCompress) ? "compressed" : "decompressed",
+                Lz->UncompressedSize,
+                Elapsed / 1000000ULL,
+                Elapsed % 1000000ULL,
+                Lz->UncompressedSize / Elapsed,
+                ((Lz->UncompressedSize * 100ULL) / Elapsed) % 100,
+                (INT)(Context->ThreadCount));
+    }
+
     Status = 0;
 
 ProcessStreamEnd:
@@ -1024,108 +1356,930 @@ Return Value:
     return Status;
 }
 
-PVOID
-LzpUtilReallocate (
-    PVOID Allocation,
-    UINTN NewSize
+INT
+LzpUtilCompressBlocks (
+    PLZMA_UTIL Context
     )
 
 /*++
 
 Routine Description:
 
-    This routine represents the prototype of the function called when the LZMA
-    library needs to allocate, reallocate, or free memory.
+    This routine compresses the input into a block stream, farming the blocks
+    out to worker threads. The main thread reads input into free blocks and
+    writes out completed blocks in order.
 
 Arguments:
 
-    Allocation - Supplies an optional pointer to the allocation to resize or
-        free. If NULL, then this routine will allocate new memory.
-
-    NewSize - Supplies the size of the desired allocation. If this is 0 and the
-        allocation parameter is non-null, the given allocation will be freed.
-        Otherwise it will be resized to requested size.
+    Context - Supplies a pointer to the application context.
 
 Return Value:
 
-    Returns a pointer to the allocation on success.
+    0 on success.
 
-    NULL on allocation failure, or in the case the memory is being freed.
+    Non-zero on failure.
 
 --*/
 
 {
 
-    return realloc(Allocation, NewSize);
-}
+    PLZMA_UTIL_BLOCK Block;
+    BOOL InputFinished;
+    PLZ_CONTEXT Lz;
+    LZ_STATUS LzStatus;
+    UINTN ReadIndex;
+    INTN Size;
+    INT Status;
+    UINTN WriteIndex;
 
-INTN
-LzpUtilRead (
-    PLZ_CONTEXT Context,
-    PVOID Buffer,
-    UINTN Size
-    )
+    Lz = &(Context->Lz);
+    ReadIndex = 0;
+    WriteIndex = 0;
+    InputFinished = FALSE;
 
-/*++
+    //
+    // Tell the encoder how big the blocks are so it doesn't use a dictionary
+    // larger than a block.
+    //
 
-Routine Description:
+    memcpy(&(Context->BlockProperties),
+           &(Context->EncoderProperties),
+           sizeof(LZMA_ENCODER_PROPERTIES));
 
-    This routine performs a read from the given input file.
+    Context->BlockProperties.ReduceSize = Context->BlockSize;
+    Context->BlockAction = LzmaActionCompress;
+    LzStatus = LzLzmaInitializeBlockEncoder(Lz, &(Context->BlockProperties));
+    if (LzStatus != LzSuccess) {
+        fprintf(stderr,
+                "Error: Failed to initialize encoder: %s.\n",
+                LzpUtilGetErrorString(LzStatus));
 
-Arguments:
+        return 1;
+    }
 
-    Context - Supplies a pointer to the LZ context.
+    Status = LzpUtilStartBlocks(Context,
+                                Context->BlockSize,
+                                LZMA_BLOCK_BOUND(Context->BlockSize));
 
-    Buffer - Supplies a pointer where the read data should be returned for
-        read operations, or where the data to write exists for write oprations.
+    if (Status != 0) {
+        return Status;
+    }
 
-    Size - Supplies the number of bytes to read or write.
+    while (TRUE) {
 
-Return Value:
+        //
+        // Fill up and queue as many free blocks as possible.
+        //
 
-    Returns the number of bytes read or written. For writes, anything other
-    than the full write size is considered failure. Reads however can return
-    less than asked for. If a read returns zero, that indicates end of file.
+        while ((InputFinished == FALSE) &&
+               (ReadIndex - WriteIndex < Context->BlockCount)) {
 
-    -1 on I/O failure.
+            Block = &(Context->Blocks[ReadIndex % Context->BlockCount]);
+            Size = fread(Block->Input, 1, Context->BlockSize, Lz->ReadContext);
+            if (Size < Context->BlockSize) {
+                if (ferror((FILE *)(Lz->ReadContext))) {
+                    Status = errno;
+                    fprintf(stderr, "lzma: Read Error: %s\n", strerror(Status));
+                    goto CompressBlocksEnd;
+                }
 
---*/
+                InputFinished = TRUE;
+                if (Size == 0) {
+                    break;
+                }
+            }
 
-{
+            Block->InputSize = Size;
+            LzpUtilQueueBlock(Context, Block);
+            ReadIndex += 1;
+        }
 
-    FILE *File;
-    UINTN Result;
+        if (WriteIndex == ReadIndex) {
+            break;
+        }
 
-    File = Context->ReadContext;
-    Result = fread(Buffer, 1, Size, File);
-    if (Result == 0) {
-        if (ferror(File)) {
-            return -1;
+        //
+        // Write out the oldest block once it's done.
+        //
+
+        Block = &(Context->Blocks[WriteIndex % Context->BlockCount]);
+        LzpUtilWaitForBlock(Context, Block);
+        LzStatus = Block->Status;
+        if (LzStatus == LzSuccess) {
+            LzStatus = LzLzmaWriteBlock(Lz, Block->Output, Block->OutputSize);
+        }
+
+        if (LzStatus != LzSuccess) {
+            fprintf(stderr,
+                    "Error: Failed to encode: %s.\n",
+                    LzpUtilGetErrorString(LzStatus));
+
+            Status = 1;
+            goto CompressBlocksEnd;
         }
+
+        Block->State = LzmaBlockFree;
+        WriteIndex += 1;
     }
 
-    return Result;
+    LzStatus = LzLzmaFinishBlockEncoder(Lz);
+    if (LzStatus != LzStreamComplete) {
+        fprintf(stderr,
+                "Error: Failed to finish: %s.\n",
+                LzpUtilGetErrorString(LzStatus));
+
+        Status = 1;
+        goto CompressBlocksEnd;
+    }
+
+    Status = 0;
+
+CompressBlocksEnd:
+    LzpUtilStopBlocks(Context);
+    return Status;
 }
 
-INTN
-LzpUtilWrite (
-    PLZ_CONTEXT Context,
-    PVOID Buffer,
-    UINTN Size
+BOOL
+LzpUtilIsBlockStream (
+    PLZMA_UTIL Context
     )
 
 /*++
 
 Routine Description:
 
-    This routine performs a write to the output stream.
+    This routine peeks at the header of the input to determine whether or not
+    it is a block stream that should be decompressed on multiple threads. If
+    it is not, the header is left pending for the regular decoder to read.
 
 Arguments:
 
-    Context - Supplies a pointer to the LZ context.
+    Context - Supplies a pointer to the application context.
 
-    Buffer - Supplies a pointer where the read data should be returned for
-        read operations, or where the data to write exists for write oprations.
+Return Value:
+
+    TRUE if the input is a block stream that should be decompressed in
+    parallel.
+
+    FALSE otherwise.
+
+--*/
+
+{
+
+    ULONG Magic;
+    UINTN Size;
+
+    if (Context->ThreadCount <= 1) {
+        return FALSE;
+    }
+
+    Size = fread(Context->StreamHeader,
+                 1,
+                 LZMA_HEADER_SIZE,
+                 Context->Lz.ReadContext);
+
+    memcpy(&Magic, Context->StreamHeader, sizeof(Magic));
+    if ((Size == LZMA_HEADER_SIZE) && (Magic == LZMA_BLOCK_HEADER_MAGIC)) {
+        return TRUE;
+    }
+
+    Context->PendingInput = Context->StreamHeader;
+    Context->PendingInputSize = Size;
+    return FALSE;
+}
+
+INT
+LzpUtilDecompressBlocks (
+    PLZMA_UTIL Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine decompresses a block stream whose header has already been
+    read, farming the blocks out to worker threads. The main thread reads
+    compressed blocks into free slots and writes out completed blocks in
+    order.
+
+Arguments:
+
+    Context - Supplies a pointer to the application context.
+
+Return Value:
+
+    0 on success.
+
+    Non-zero on failure.
+
+--*/
+
+{
+
+    PLZMA_UTIL_BLOCK Block;
+    UCHAR BlockHeader[LZMA_BLOCK_HEADER_SIZE];
+    UINTN CompressedSize;
+    UCHAR Footer[LZMA_FOOTER_SIZE];
+    BOOL InputFinished;
+    PLZ_CONTEXT Lz;
+    LZ_STATUS LzStatus;
+    PVOID NewBuffer;
+    UINTN ReadIndex;
+    UINTN Size;
+    INT Status;
+    UINTN UncompressedSize;
+    UINTN WriteIndex;
+
+    Lz = &(Context->Lz);
+    ReadIndex = 0;
+    WriteIndex = 0;
+    InputFinished = FALSE;
+    LzStatus = LzLzmaInitializeBlockDecoder(Lz, Context->StreamHeader);
+    if (LzStatus != LzSuccess) {
+        fprintf(stderr,
+                "Error: Failed to initialize decoder: %s.\n",
+                LzpUtilGetErrorString(LzStatus));
+
+        return 1;
+    }
+
+    //
+    // The block sizes aren't known until their headers are read, so the
+    // buffers are sized as blocks come in.
+    //
+
+    Context->BlockAction = LzmaActionDecompress;
+    Status = LzpUtilStartBlocks(Context, 0, 0);
+    if (Status != 0) {
+        return Status;
+    }
+
+    Status = 1;
+    while (TRUE) {
+
+        //
+        // Read and queue as many blocks as there are free slots for.
+        //
+
+        while ((InputFinished == FALSE) &&
+               (ReadIndex - WriteIndex < Context->BlockCount)) {
+
+            Block = &(Context->Blocks[ReadIndex % Context->BlockCount]);
+            LzStatus = LzpUtilReadInput(Context,
+                                        BlockHeader,
+                                        LZMA_BLOCK_HEADER_SIZE);
+
+            if (LzStatus != LzSuccess) {
+                goto DecompressBlocksEnd;
+            }
+
+            LzStatus = LzLzmaReadBlockHeader(Lz,
+                                             BlockHeader,
+                                             &CompressedSize,
+                                             &UncompressedSize);
+
+            if (LzStatus != LzSuccess) {
+                goto DecompressBlocksEnd;
+            }
+
+            if (CompressedSize == 0) {
+                InputFinished = TRUE;
+                break;
+            }
+
+            Size = LZMA_BLOCK_HEADER_SIZE + CompressedSize;
+            if (Size > Block->InputCapacity) {
+                NewBuffer = realloc(Block->Input, Size);
+                if (NewBuffer == NULL) {
+                    LzStatus = LzErrorMemory;
+                    goto DecompressBlocksEnd;
+                }
+
+                Block->Input = NewBuffer;
+                Block->InputCapacity = Size;
+            }
+
+            if (UncompressedSize > Block->OutputCapacity) {
+                NewBuffer = realloc(Block->Output, UncompressedSize);
+                if (NewBuffer == NULL) {
+                    LzStatus = LzErrorMemory;
+                    goto DecompressBlocksEnd;
+                }
+
+                Block->Output = NewBuffer;
+                Block->OutputCapacity = UncompressedSize;
+            }
+
+            memcpy(Block->Input, BlockHeader, LZMA_BLOCK_HEADER_SIZE);
+            LzStatus = LzpUtilReadInput(Context,
+                                        Block->Input + LZMA_BLOCK_HEADER_SIZE,
+                                        CompressedSize);
+
+            if (LzStatus != LzSuccess) {
+                goto DecompressBlocksEnd;
+            }
+
+            Block->InputSize = Size;
+            LzpUtilQueueBlock(Context, Block);
+            ReadIndex += 1;
+        }
+
+        if (WriteIndex == ReadIndex) {
+            break;
+        }
+
+        //
+        // Write out the oldest block once it's done.
+        //
+
+        Block = &(Context->Blocks[WriteIndex % Context->BlockCount]);
+        LzpUtilWaitForBlock(Context, Block);
+        LzStatus = Block->Status;
+        if (LzStatus != LzSuccess) {
+            goto DecompressBlocksEnd;
+        }
+
+        Size = fwrite(Block->Output, 1, Block->OutputSize, Lz->WriteContext);
+        if (Size != Block->OutputSize) {
+            LzStatus = LzErrorWrite;
+            goto DecompressBlocksEnd;
+        }
+
+        Block->State = LzmaBlockFree;
+        WriteIndex += 1;
+    }
+
+    LzStatus = LzpUtilReadInput(Context, Footer, LZMA_FOOTER_SIZE);
+    if (LzStatus != LzSuccess) {
+        goto DecompressBlocksEnd;
+    }
+
+    LzStatus = LzLzmaFinishBlockDecoder(Lz, Footer);
+    if (LzStatus != LzStreamComplete) {
+        goto DecompressBlocksEnd;
+    }
+
+    Status = 0;
+
+DecompressBlocksEnd:
+    if (Status != 0) {
+        fprintf(stderr,
+                "Error: Failed to decode: %s.\n",
+                LzpUtilGetErrorString(LzStatus));
+    }
+
+    LzpUtilStopBlocks(Context);
+    return Status;
+}
+
+LZ_STATUS
+LzpUtilReadInput (
+    PLZMA_UTIL Context,
+    PVOID Buffer,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads exactly the given number of bytes from the input file.
+
+Arguments:
+
+    Context - Supplies a pointer to the application context.
+
+    Buffer - Supplies a pointer where the data will be returned.
+
+    Size - Supplies the number of bytes to read.
+
+Return Value:
+
+    LzSuccess if all the data was read.
+
+    LzErrorInputEof if the input ended early.
+
+    LzErrorRead on I/O failure.
+
+--*/
+
+{
+
+    FILE *File;
+
+    File = Context->Lz.ReadContext;
+    if (fread(Buffer, 1, Size, File) != Size) {
+        if (ferror(File)) {
+            return LzErrorRead;
+        }
+
+        return LzErrorInputEof;
+    }
+
+    return LzSuccess;
+}
+
+INT
+LzpUtilStartBlocks (
+    PLZMA_UTIL Context,
+    UINTN InputCapacity,
+    UINTN OutputCapacity
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates the blocks used to process a block stream and
+    starts the worker threads.
+
+Arguments:
+
+    Context - Supplies a pointer to the application context.
+
+    InputCapacity - Supplies the initial size of each block's input buffer.
+        Supply zero to allocate the buffers as blocks are read.
+
+    OutputCapacity - Supplies the initial size of each block's output buffer.
+
+Return Value:
+
+    0 on success.
+
+    Non-zero on failure.
+
+--*/
+
+{
+
+    PLZMA_UTIL_BLOCK Block;
+    UINTN Index;
+    INT Status;
+
+    Context->BlockCount = Context->ThreadCount * LZMA_UTIL_BLOCKS_PER_THREAD;
+    Context->Blocks = calloc(Context->BlockCount, sizeof(LZMA_UTIL_BLOCK));
+    if (Context->Blocks == NULL) {
+        Context->BlockCount = 0;
+        return ENOMEM;
+    }
+
+    for (Index = 0; Index < Context->BlockCount; Index += 1) {
+        Block = &(Context->Blocks[Index]);
+        if (InputCapacity != 0) {
+            Block->Input = malloc(InputCapacity);
+            if (Block->Input == NULL) {
+                LzpUtilStopBlocks(Context);
+                return ENOMEM;
+            }
+
+            Block->InputCapacity = InputCapacity;
+        }
+
+        if (OutputCapacity != 0) {
+            Block->Output = malloc(OutputCapacity);
+            if (Block->Output == NULL) {
+                LzpUtilStopBlocks(Context);
+                return ENOMEM;
+            }
+
+            Block->OutputCapacity = OutputCapacity;
+        }
+    }
+
+    Context->NextJob = 0;
+    Context->Exit = FALSE;
+
+#ifdef LZMA_UTIL_THREADS
+
+    if (Context->ThreadCount > 1) {
+        pthread_mutex_init(&(Context->Lock), NULL);
+        pthread_cond_init(&(Context->JobReady), NULL);
+        pthread_cond_init(&(Context->JobComplete), NULL);
+        Context->StartedThreadCount = 0;
+        Context->Threads = malloc(Context->ThreadCount * sizeof(pthread_t));
+        if (Context->Threads == NULL) {
+            LzpUtilStopBlocks(Context);
+            return ENOMEM;
+        }
+
+        for (Index = 0; Index < Context->ThreadCount; Index += 1) {
+            Status = pthread_create(&(Context->Threads[Index]),
+                                    NULL,
+                                    LzpUtilWorkerThread,
+                                    Context);
+
+            if (Status != 0) {
+                fprintf(stderr,
+                        "lzma: Failed to create thread: %s.\n",
+                        strerror(Status));
+
+                LzpUtilStopBlocks(Context);
+                return Status;
+            }
+
+            Context->StartedThreadCount += 1;
+        }
+    }
+
+#endif
+
+    Status = 0;
+    return Status;
+}
+
+VOID
+LzpUtilStopBlocks (
+    PLZMA_UTIL Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for any blocks still being worked on, stops the worker
+    threads, and frees the blocks.
+
+Arguments:
+
+    Context - Supplies a pointer to the application context.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLZMA_UTIL_BLOCK Block;
+    UINTN Index;
+
+    if (Context->Blocks == NULL) {
+        return;
+    }
+
+    //
+    // Wait for in-flight blocks so that no worker touches their buffers after
+    // they're freed, then tell the workers to go away.
+    //
+
+    for (Index = 0; Index < Context->BlockCount; Index += 1) {
+        Block = &(Context->Blocks[Index]);
+        if (Block->State != LzmaBlockFree) {
+            LzpUtilWaitForBlock(Context, Block);
+        }
+    }
+
+#ifdef LZMA_UTIL_THREADS
+
+    if (Context->ThreadCount > 1) {
+        pthread_mutex_lock(&(Context->Lock));
+        Context->Exit = TRUE;
+        pthread_cond_broadcast(&(Context->JobReady));
+        pthread_mutex_unlock(&(Context->Lock));
+        for (Index = 0; Index < Context->StartedThreadCount; Index += 1) {
+            pthread_join(Context->Threads[Index], NULL);
+        }
+
+        free(Context->Threads);
+        Context->Threads = NULL;
+        Context->StartedThreadCount = 0;
+        pthread_cond_destroy(&(Context->JobComplete));
+        pthread_cond_destroy(&(Context->JobReady));
+        pthread_mutex_destroy(&(Context->Lock));
+    }
+
+#endif
+
+    for (Index = 0; Index < Context->BlockCount; Index += 1) {
+        Block = &(Context->Blocks[Index]);
+        free(Block->Input);
+        free(Block->Output);
+    }
+
+    free(Context->Blocks);
+    Context->Blocks = NULL;
+    Context->BlockCount = 0;
+    return;
+}
+
+VOID
+LzpUtilQueueBlock (
+    PLZMA_UTIL Context,
+    PLZMA_UTIL_BLOCK Block
+    )
+
+/*++
+
+Routine Description:
+
+    This routine hands a filled block to the worker threads. Blocks must be
+    queued in the same order they sit in the block array. Without worker
+    threads, the block is processed immediately.
+
+Arguments:
+
+    Context - Supplies a pointer to the application context.
+
+    Block - Supplies a pointer to the block to queue.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    Block->Status = LzSuccess;
+    Block->OutputSize = 0;
+
+#ifdef LZMA_UTIL_THREADS
+
+    if (Context->ThreadCount > 1) {
+        pthread_mutex_lock(&(Context->Lock));
+        Block->State = LzmaBlockQueued;
+        pthread_cond_signal(&(Context->JobReady));
+        pthread_mutex_unlock(&(Context->Lock));
+        return;
+    }
+
+#endif
+
+    LzpUtilProcessBlock(Context, Block);
+    Block->State = LzmaBlockComplete;
+    return;
+}
+
+VOID
+LzpUtilWaitForBlock (
+    PLZMA_UTIL Context,
+    PLZMA_UTIL_BLOCK Block
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for a queued block to be completed by a worker.
+
+Arguments:
+
+    Context - Supplies a pointer to the application context.
+
+    Block - Supplies a pointer to the block to wait for.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+#ifdef LZMA_UTIL_THREADS
+
+    if (Context->ThreadCount > 1) {
+        pthread_mutex_lock(&(Context->Lock));
+        while (Block->State != LzmaBlockComplete) {
+            pthread_cond_wait(&(Context->JobComplete), &(Context->Lock));
+        }
+
+        pthread_mutex_unlock(&(Context->Lock));
+    }
+
+#endif
+
+    return;
+}
+
+PVOID
+LzpUtilWorkerThread (
+    PVOID Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements a worker thread, which processes queued blocks in
+    order until told to exit.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the application context.
+
+Return Value:
+
+    NULL always.
+
+--*/
+
+{
+
+    PLZMA_UTIL_BLOCK Block;
+    PLZMA_UTIL Context;
+
+    Context = Parameter;
+
+#ifdef LZMA_UTIL_THREADS
+
+    pthread_mutex_lock(&(Context->Lock));
+    while (TRUE) {
+        Block = &(Context->Blocks[Context->NextJob % Context->BlockCount]);
+        if (Block->State == LzmaBlockQueued) {
+            Block->State = LzmaBlockBusy;
+            Context->NextJob += 1;
+            pthread_mutex_unlock(&(Context->Lock));
+            LzpUtilProcessBlock(Context, Block);
+            pthread_mutex_lock(&(Context->Lock));
+            Block->State = LzmaBlockComplete;
+            pthread_cond_broadcast(&(Context->JobComplete));
+            continue;
+        }
+
+        if (Context->Exit != FALSE) {
+            break;
+        }
+
+        pthread_cond_wait(&(Context->JobReady), &(Context->Lock));
+    }
+
+    pthread_mutex_unlock(&(Context->Lock));
+
+#endif
+
+    return NULL;
+}
+
+VOID
+LzpUtilProcessBlock (
+    PLZMA_UTIL Context,
+    PLZMA_UTIL_BLOCK Block
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compresses or decompresses a single block. This may run on a
+    worker thread.
+
+Arguments:
+
+    Context - Supplies a pointer to the application context.
+
+    Block - Supplies a pointer to the block to process.
+
+Return Value:
+
+    None. The result is stored in the block.
+
+--*/
+
+{
+
+    LZ_CONTEXT Lz;
+
+    memset(&Lz, 0, sizeof(LZ_CONTEXT));
+    Lz.Context = Context;
+    Lz.Reallocate = LzpUtilReallocate;
+    Lz.Input = Block->Input;
+    Lz.InputSize = Block->InputSize;
+    Lz.Output = Block->Output;
+    Lz.OutputSize = Block->OutputCapacity;
+    if (Context->BlockAction == LzmaActionCompress) {
+        Block->Status = LzLzmaCompressBlock(&Lz, &(Context->BlockProperties));
+
+    } else {
+        Block->Status = LzLzmaDecompressBlock(&Lz, Context->StreamHeader);
+    }
+
+    Block->OutputSize = Block->OutputCapacity - Lz.OutputSize;
+    return;
+}
+
+PVOID
+LzpUtilReallocate (
+    PVOID Allocation,
+    UINTN NewSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine represents the prototype of the function called when the LZMA
+    library needs to allocate, reallocate, or free memory.
+
+Arguments:
+
+    Allocation - Supplies an optional pointer to the allocation to resize or
+        free. If NULL, then this routine will allocate new memory.
+
+    NewSize - Supplies the size of the desired allocation. If this is 0 and the
+        allocation parameter is non-null, the given allocation will be freed.
+        Otherwise it will be resized to requested size.
+
+Return Value:
+
+    Returns a pointer to the allocation on success.
+
+    NULL on allocation failure, or in the case the memory is being freed.
+
+--*/
+
+{
+
+    return realloc(Allocation, NewSize);
+}
+
+INTN
+LzpUtilRead (
+    PLZ_CONTEXT Context,
+    PVOID Buffer,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs a read from the given input file.
+
+Arguments:
+
+    Context - Supplies a pointer to the LZ context.
+
+    Buffer - Supplies a pointer where the read data should be returned for
+        read operations, or where the data to write exists for write oprations.
+
+    Size - Supplies the number of bytes to read or write.
+
+Return Value:
+
+    Returns the number of bytes read or written. For writes, anything other
+    than the full write size is considered failure. Reads however can return
+    less than asked for. If a read returns zero, that indicates end of file.
+
+    -1 on I/O failure.
+
+--*/
+
+{
+
+    FILE *File;
+    UINTN Result;
+    PLZMA_UTIL Util;
+
+    //
+    // Hand out anything that was already read while peeking at the stream.
+    //
+
+    Util = Context->Context;
+    if (Util->PendingInputSize != 0) {
+        Result = Util->PendingInputSize;
+        if (Result > Size) {
+            Result = Size;
+        }
+
+        memcpy(Buffer, Util->PendingInput, Result);
+        Util->PendingInput += Result;
+        Util->PendingInputSize -= Result;
+        return Result;
+    }
+
+    File = Context->ReadContext;
+    Result = fread(Buffer, 1, Size, File);
+    if (Result == 0) {
+        if (ferror(File)) {
+            return -1;
+        }
+    }
+
+    return Result;
+}
+
+INTN
+LzpUtilWrite (
+    PLZ_CONTEXT Context,
+    PVOID Buffer,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs a write to the output stream.
+
+Arguments:
+
+    Context - Supplies a pointer to the LZ context.
+
+    Buffer - Supplies a pointer where the read data should be returned for
+        read operations, or where the data to write exists for write oprations.
 
     Size - Supplies the number of bytes to read or write.
 
@@ -1243,3 +2397,32 @@ Return Value:
     return LzStatusStrings[Status];
 }
 
+ULONGLONG
+LzpUtilGetMicroseconds (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the current time in microseconds, for measuring
+    throughput.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current time in microseconds.
+
+--*/
+
+{
+
+    struct timeval Time;
+
+    gettimeofday(&Time, NULL);
+    return (Time.tv_sec * 1000000ULL) + Time.tv_usec;
+}
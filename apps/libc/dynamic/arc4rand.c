@@ -0,0 +1,656 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU Lesser General Public
+    License version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details.
+
+Module Name:
+
+    arc4rand.c
+
+Abstract:
+
+    This module implements the interfaces that return cryptographically
+    strong random numbers: getrandom, getentropy, and the arc4random family.
+    The arc4random functions run a ChaCha20 generator in the process, keyed
+    from the kernel, and refill its output in large chunks so that most calls
+    never leave user mode.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User Mode C Library
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "libcp.h"
+#include <minoca/lib/crypto.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+#include <unistd.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the size of the key stream buffer. The first key-sized piece of
+// every refill becomes the next key, so output already handed out can't be
+// recovered from the state in memory.
+//
+
+#define ARC4RANDOM_BUFFER_SIZE 4096
+
+//
+// Define how many bytes are handed out before fresh key material is mixed
+// in from the kernel.
+//
+
+#define ARC4RANDOM_RESEED_BYTES (1024 * 1024)
+
+//
+// Define the most getentropy will return in a single call.
+//
+
+#define GETENTROPY_MAX_SIZE 256
+
+#define GETRANDOM_FLAG_MASK (GRND_NONBLOCK | GRND_RANDOM)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines the state of the process-wide arc4random
+    generator.
+
+Members:
+
+    Key - Stores the current ChaCha20 key.
+
+    Buffer - Stores key stream that has been generated but not yet handed
+        out. Bytes are zeroed as they are consumed.
+
+    Available - Stores the number of unused bytes at the end of the buffer.
+
+    BytesSinceReseed - Stores the number of bytes handed out since key
+        material was last pulled from the kernel.
+
+    Seeded - Stores a boolean indicating whether the generator has been
+        keyed from the kernel yet.
+
+--*/
+
+typedef struct _ARC4RANDOM_STATE {
+    UCHAR Key[CHACHA20_KEY_SIZE];
+    UCHAR Buffer[ARC4RANDOM_BUFFER_SIZE];
+    UINTN Available;
+    UINTN BytesSinceReseed;
+    BOOL Seeded;
+} ARC4RANDOM_STATE, *PARC4RANDOM_STATE;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+ClpArc4RandomGetBytes (
+    PVOID Buffer,
+    UINTN Size
+    );
+
+VOID
+ClpArc4RandomReseed (
+    VOID
+    );
+
+VOID
+ClpArc4RandomRefill (
+    VOID
+    );
+
+VOID
+ClpArc4RandomRegisterForkHandlers (
+    VOID
+    );
+
+VOID
+ClpArc4RandomForkPrepare (
+    VOID
+    );
+
+VOID
+ClpArc4RandomForkParent (
+    VOID
+    );
+
+VOID
+ClpArc4RandomForkChild (
+    VOID
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+OS_LOCK ClArc4RandomLock = {0, OS_LOCK_DEFAULT_SPIN_COUNT};
+ARC4RANDOM_STATE ClArc4RandomState;
+pthread_once_t ClArc4RandomForkOnce = PTHREAD_ONCE_INIT;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+LIBC_API
+ssize_t
+getrandom (
+    void *Buffer,
+    size_t Size,
+    unsigned int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine fills a buffer with random bytes from the kernel's random
+    number generators, without going through the random device.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the buffer to fill.
+
+    Size - Supplies the number of bytes to write.
+
+    Flags - Supplies a bitfield of flags. See GRND_* definitions.
+
+Return Value:
+
+    Returns the number of bytes written, which may be less than requested
+    for very large requests.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+{
+
+    UINTN Completed;
+    KSTATUS Status;
+
+    if ((Flags & ~GETRANDOM_FLAG_MASK) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    Completed = Size;
+    Status = OsGetRandomBytes(Buffer, &Completed);
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return Completed;
+}
+
+LIBC_API
+int
+getentropy (
+    void *Buffer,
+    size_t Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine fills a buffer with random bytes suitable for seeding a
+    cryptographic random number generator.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the buffer to fill.
+
+    Size - Supplies the number of bytes to write. This may be at most 256.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to indicate more information. This
+    fails with EIO if more than 256 bytes are requested.
+
+--*/
+
+{
+
+    ssize_t Result;
+
+    if (Size > GETENTROPY_MAX_SIZE) {
+        errno = EIO;
+        return -1;
+    }
+
+    while (Size != 0) {
+        Result = getrandom(Buffer, Size, 0);
+        if (Result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return -1;
+        }
+
+        Buffer += Result;
+        Size -= Result;
+    }
+
+    return 0;
+}
+
+LIBC_API
+uint32_t
+arc4random (
+    void
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns a cryptographically strong random number. It never
+    fails, and needs no seeding.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a random number between 0 and 0xFFFFFFFF, inclusive.
+
+--*/
+
+{
+
+    uint32_t Value;
+
+    ClpArc4RandomGetBytes(&Value, sizeof(Value));
+    return Value;
+}
+
+LIBC_API
+void
+arc4random_buf (
+    void *Buffer,
+    size_t Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine fills a buffer with cryptographically strong random bytes.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the buffer to fill.
+
+    Size - Supplies the number of bytes to write.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ClpArc4RandomGetBytes(Buffer, Size);
+    return;
+}
+
+LIBC_API
+uint32_t
+arc4random_uniform (
+    uint32_t UpperBound
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns a cryptographically strong random number less than
+    the given upper bound. Unlike arc4random() % UpperBound, every result is
+    equally likely.
+
+Arguments:
+
+    UpperBound - Supplies the exclusive upper bound of the result.
+
+Return Value:
+
+    Returns a random number between 0 and UpperBound - 1, inclusive.
+
+    0 if the upper bound is less than 2.
+
+--*/
+
+{
+
+    uint32_t Minimum;
+    uint32_t Value;
+
+    if (UpperBound < 2) {
+        return 0;
+    }
+
+    //
+    // Throw away values below 2^32 % UpperBound, so that what's left is an
+    // exact multiple of the bound and the modulo below isn't biased.
+    //
+
+    Minimum = -UpperBound % UpperBound;
+    do {
+        Value = arc4random();
+
+    } while (Value < Minimum);
+
+    return Value % UpperBound;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+ClpArc4RandomGetBytes (
+    PVOID Buffer,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine fills a buffer from the process-wide arc4random generator.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the buffer to fill.
+
+    Size - Supplies the number of bytes to write.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Count;
+    PUCHAR Output;
+    PUCHAR Source;
+    PARC4RANDOM_STATE State;
+
+    //
+    // Register to wipe the state in forked children, so a parent and child
+    // never hand out the same numbers. This is done outside the lock since
+    // forking acquires the lock with the at-fork lock held.
+    //
+
+    pthread_once(&ClArc4RandomForkOnce, ClpArc4RandomRegisterForkHandlers);
+    Output = Buffer;
+    State = &ClArc4RandomState;
+    OsAcquireLock(&ClArc4RandomLock);
+    if ((State->Seeded == FALSE) ||
+        (State->BytesSinceReseed >= ARC4RANDOM_RESEED_BYTES)) {
+
+        ClpArc4RandomReseed();
+    }
+
+    State->BytesSinceReseed += Size;
+    while (Size != 0) {
+        if (State->Available == 0) {
+            ClpArc4RandomRefill();
+        }
+
+        Count = State->Available;
+        if (Count > Size) {
+            Count = Size;
+        }
+
+        Source = &(State->Buffer[ARC4RANDOM_BUFFER_SIZE - State->Available]);
+        memcpy(Output, Source, Count);
+        memset(Source, 0, Count);
+        State->Available -= Count;
+        Output += Count;
+        Size -= Count;
+    }
+
+    OsReleaseLock(&ClArc4RandomLock);
+    return;
+}
+
+VOID
+ClpArc4RandomReseed (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine mixes fresh key material from the kernel into the arc4random
+    generator and throws away any buffered output. This routine assumes the
+    arc4random lock is held.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Index;
+    UCHAR Seed[CHACHA20_KEY_SIZE];
+    PARC4RANDOM_STATE State;
+
+    State = &ClArc4RandomState;
+
+    //
+    // These interfaces are not allowed to fail, so there is nothing better
+    // to do than abort if the kernel can't supply any randomness.
+    //
+
+    if (getentropy(Seed, sizeof(Seed)) != 0) {
+        abort();
+    }
+
+    for (Index = 0; Index < CHACHA20_KEY_SIZE; Index += 1) {
+        State->Key[Index] ^= Seed[Index];
+    }
+
+    memset(Seed, 0, sizeof(Seed));
+    memset(State->Buffer, 0, sizeof(State->Buffer));
+    State->Available = 0;
+    State->BytesSinceReseed = 0;
+    State->Seeded = TRUE;
+    return;
+}
+
+VOID
+ClpArc4RandomRefill (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine refills the arc4random key stream buffer, replacing the key
+    with the start of the new key stream. This routine assumes the arc4random
+    lock is held.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    CHACHA20_CONTEXT Context;
+    UCHAR Nonce[CHACHA20_NONCE_SIZE];
+    PARC4RANDOM_STATE State;
+
+    State = &ClArc4RandomState;
+    memset(Nonce, 0, sizeof(Nonce));
+    CyChaCha20Initialize(&Context, State->Key, Nonce, 0);
+    CyChaCha20Encrypt(&Context, NULL, State->Buffer, ARC4RANDOM_BUFFER_SIZE);
+    memcpy(State->Key, State->Buffer, CHACHA20_KEY_SIZE);
+    memset(State->Buffer, 0, CHACHA20_KEY_SIZE);
+    memset(&Context, 0, sizeof(Context));
+    State->Available = ARC4RANDOM_BUFFER_SIZE - CHACHA20_KEY_SIZE;
+    return;
+}
+
+VOID
+ClpArc4RandomRegisterForkHandlers (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine registers the arc4random fork handlers. It is called once.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    pthread_atfork(ClpArc4RandomForkPrepare,
+                   ClpArc4RandomForkParent,
+                   ClpArc4RandomForkChild);
+
+    return;
+}
+
+VOID
+ClpArc4RandomForkPrepare (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine acquires the arc4random lock before a fork, so the state
+    isn't copied into the child in the middle of an update.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    OsAcquireLock(&ClArc4RandomLock);
+    return;
+}
+
+VOID
+ClpArc4RandomForkParent (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases the arc4random lock in the parent after a fork.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    OsReleaseLock(&ClArc4RandomLock);
+    return;
+}
+
+VOID
+ClpArc4RandomForkChild (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine wipes the arc4random state in a newly forked child, so that
+    it rekeys from the kernel rather than repeating its parent's output.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    memset(&ClArc4RandomState, 0, sizeof(ARC4RANDOM_STATE));
+    OsInitializeLockDefault(&ClArc4RandomLock);
+    return;
+}
+
@@ -100,6 +100,7 @@ function build() {
     ];
 
     sources = [
+        "arc4rand.c",
         "assert.c",
         "brk.c",
         "bsearch.c",
@@ -121,6 +122,7 @@ function build() {
         "if.c",
         "inet.c",
         "init.c",
+        "inotify.c",
         "kerror.c",
         "langinfo.c",
         "line.c",
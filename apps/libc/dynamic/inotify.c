@@ -0,0 +1,252 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU Lesser General Public
+    License version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details.
+
+Module Name:
+
+    inotify.c
+
+Abstract:
+
+    This module implements support for watching files and directories for
+    changes.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User Mode C Library
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "libcp.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the events that are accepted but never reported. They are quietly
+// dropped from the mask before it goes to the kernel. All other event and
+// flag values are the same as the kernel's FILE_WATCH_* values.
+//
+
+#define INOTIFY_UNSUPPORTED_EVENTS (IN_ACCESS | IN_CLOSE | IN_OPEN)
+
+#define INOTIFY_INIT_FLAG_MASK (IN_NONBLOCK | IN_CLOEXEC)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+LIBC_API
+int
+inotify_init (
+    void
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new watch queue.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a file descriptor for the new queue on success.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+{
+
+    return inotify_init1(0);
+}
+
+LIBC_API
+int
+inotify_init1 (
+    int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new watch queue.
+
+Arguments:
+
+    Flags - Supplies a bitfield of flags governing the new descriptor. See
+        IN_NONBLOCK and IN_CLOEXEC.
+
+Return Value:
+
+    Returns a file descriptor for the new queue on success.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+{
+
+    HANDLE Handle;
+    ULONG OpenFlags;
+    KSTATUS Status;
+
+    if ((Flags & ~INOTIFY_INIT_FLAG_MASK) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    OpenFlags = 0;
+    if ((Flags & IN_CLOEXEC) != 0) {
+        OpenFlags |= SYS_OPEN_FLAG_CLOSE_ON_EXECUTE;
+    }
+
+    if ((Flags & IN_NONBLOCK) != 0) {
+        OpenFlags |= SYS_OPEN_FLAG_NON_BLOCKING;
+    }
+
+    Status = OsCreateWatchQueue(OpenFlags, &Handle);
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return (int)(UINTN)Handle;
+}
+
+LIBC_API
+int
+inotify_add_watch (
+    int FileDescriptor,
+    const char *Path,
+    uint32_t Mask
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a watch on a file or directory to a watch queue, or
+    updates the existing watch if the queue already watches that file.
+
+Arguments:
+
+    FileDescriptor - Supplies the watch queue descriptor.
+
+    Path - Supplies a pointer to the path of the file or directory to watch.
+
+    Mask - Supplies the events to watch for, combined with any IN_ONLYDIR,
+        IN_DONT_FOLLOW, or IN_MASK_ADD flags.
+
+Return Value:
+
+    Returns the watch descriptor on success.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+{
+
+    LONG Descriptor;
+    KSTATUS Status;
+
+    if (Path == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    Mask &= ~INOTIFY_UNSUPPORTED_EVENTS;
+    Status = OsAddWatch((HANDLE)(UINTN)FileDescriptor,
+                        INVALID_HANDLE,
+                        Path,
+                        strlen(Path) + 1,
+                        Mask,
+                        &Descriptor);
+
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return Descriptor;
+}
+
+LIBC_API
+int
+inotify_rm_watch (
+    int FileDescriptor,
+    int WatchDescriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a watch from a watch queue. An IN_IGNORED event is
+    reported for it.
+
+Arguments:
+
+    FileDescriptor - Supplies the watch queue descriptor.
+
+    WatchDescriptor - Supplies the watch descriptor to remove.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+{
+
+    KSTATUS Status;
+
+    Status = OsRemoveWatch((HANDLE)(UINTN)FileDescriptor, WatchDescriptor);
+    if (!KSUCCESS(Status)) {
+        errno = ClConvertKstatusToErrorNumber(Status);
+        return -1;
+    }
+
+    return 0;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
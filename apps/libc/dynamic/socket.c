@@ -36,6 +36,7 @@ Module Name:
 #include <fcntl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/time.h>
@@ -60,7 +61,8 @@ Module Name:
            (MSG_CTRUNC == SOCKET_IO_CONTROL_TRUNCATED) && \
            (MSG_NOSIGNAL == SOCKET_IO_NO_SIGNAL) &&       \
            (MSG_DONTWAIT == SOCKET_IO_NON_BLOCKING) &&    \
-           (MSG_DONTROUTE == SOCKET_IO_DONT_ROUTE))
+           (MSG_DONTROUTE == SOCKET_IO_DONT_ROUTE) &&     \
+           (MSG_WAITFORONE == SOCKET_IO_WAIT_FOR_ONE))
 
 #define ASSERT_SOCKET_TYPES_EQUIVALENT()                   \
     ASSERT((SOCK_DGRAM == NetSocketDatagram) &&            \
@@ -126,10 +128,20 @@ Module Name:
            (TCP_KEEPINTVL == SocketTcpOptionKeepAlivePeriod) && \
            (TCP_KEEPCNT == SocketTcpOptionKeepAliveProbeLimit))
 
+#define ASSERT_SOCKET_UDP_OPTIONS_EQUIVALENT() \
+    ASSERT(UDP_SEGMENT == SocketUdpOptionSegmentSize)
+
 //
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the number of messages sendmmsg and recvmmsg hand to the kernel in
+// a single system call.
+//
+
+#define SOCKET_BATCH_MESSAGE_COUNT 16
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -921,6 +933,165 @@ Return Value:
     return (ssize_t)(Parameters.BytesCompleted);
 }
 
+LIBC_API
+int
+sendmmsg (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends several messages out of a socket with as few system
+    calls as possible. Each message is sent as if by sendmsg.
+
+Arguments:
+
+    Socket - Supplies the file descriptor of the socket to send data out of.
+
+    Messages - Supplies an array of messages to send. On success, the msg_len
+        member of each sent message is set to the number of bytes sent.
+
+    MessageCount - Supplies the number of elements in the message array.
+
+    Flags - Supplies a bitfield of flags governing the transmission of the data.
+        See MSG_* definitions.
+
+Return Value:
+
+    Returns the number of messages sent on success. This may be less than the
+    requested count if an error occurred partway through.
+
+    -1 on error, and the errno variable will be set to contain more information.
+
+--*/
+
+{
+
+    NETWORK_ADDRESS Addresses[SOCKET_BATCH_MESSAGE_COUNT];
+    UINTN BatchCount;
+    UINTN Completed;
+    struct msghdr *Message;
+    UINTN MessageIndex;
+    SOCKET_IO_MESSAGE IoMessages[SOCKET_BATCH_MESSAGE_COUNT];
+    PSOCKET_IO_PARAMETERS Parameters;
+    KSTATUS Status;
+    unsigned int Total;
+    UINTN VectorIndex;
+
+    if ((Messages == NULL) && (MessageCount != 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ASSERT_SOCKET_IO_FLAGS_ARE_EQUIVALENT();
+
+    Status = STATUS_SUCCESS;
+    Total = 0;
+    while (Total < MessageCount) {
+        BatchCount = MessageCount - Total;
+        if (BatchCount > SOCKET_BATCH_MESSAGE_COUNT) {
+            BatchCount = SOCKET_BATCH_MESSAGE_COUNT;
+        }
+
+        for (MessageIndex = 0; MessageIndex < BatchCount; MessageIndex += 1) {
+            Message = &(Messages[Total + MessageIndex].msg_hdr);
+            Parameters = &(IoMessages[MessageIndex].Parameters);
+            Parameters->Size = 0;
+            for (VectorIndex = 0;
+                 VectorIndex < Message->msg_iovlen;
+                 VectorIndex += 1) {
+
+                Parameters->Size += Message->msg_iov[VectorIndex].iov_len;
+            }
+
+            if (Parameters->Size > (UINTN)SSIZE_MAX) {
+                Parameters->Size = (UINTN)SSIZE_MAX;
+            }
+
+            Parameters->BytesCompleted = 0;
+            Parameters->IoFlags = SYS_IO_FLAG_WRITE;
+            Parameters->SocketIoFlags = Flags;
+            Parameters->TimeoutInMilliseconds = SYS_WAIT_TIME_INDEFINITE;
+            Parameters->NetworkAddress = NULL;
+            Parameters->RemotePath = NULL;
+            Parameters->RemotePathSize = 0;
+            if ((Message->msg_name != NULL) && (Message->msg_namelen != 0)) {
+                Status = ClConvertToNetworkAddress(
+                                            Message->msg_name,
+                                            Message->msg_namelen,
+                                            &(Addresses[MessageIndex]),
+                                            &(Parameters->RemotePath),
+                                            &(Parameters->RemotePathSize));
+
+                if (!KSUCCESS(Status)) {
+                    break;
+                }
+
+                Parameters->NetworkAddress = &(Addresses[MessageIndex]);
+            }
+
+            Parameters->ControlData = Message->msg_control;
+            Parameters->ControlDataSize = Message->msg_controllen;
+            IoMessages[MessageIndex].VectorArray =
+                                             (PIO_VECTOR)(Message->msg_iov);
+
+            IoMessages[MessageIndex].VectorCount = Message->msg_iovlen;
+        }
+
+        //
+        // Send everything up to a message with a bad address. The bad one
+        // fails on its own once it reaches the front of the line.
+        //
+
+        if (!KSUCCESS(Status)) {
+            if (MessageIndex == 0) {
+                if (Total != 0) {
+                    break;
+                }
+
+                errno = EINVAL;
+                return -1;
+            }
+
+            BatchCount = MessageIndex;
+        }
+
+        Completed = BatchCount;
+        Status = OsSocketPerformBatchIo((HANDLE)(UINTN)Socket,
+                                        SYS_IO_FLAG_WRITE,
+                                        IoMessages,
+                                        &Completed);
+
+        for (MessageIndex = 0; MessageIndex < Completed; MessageIndex += 1) {
+            Parameters = &(IoMessages[MessageIndex].Parameters);
+            Messages[Total + MessageIndex].msg_len = Parameters->BytesCompleted;
+        }
+
+        Total += Completed;
+        if ((!KSUCCESS(Status)) || (Completed != BatchCount)) {
+            break;
+        }
+    }
+
+    if ((Total == 0) && (!KSUCCESS(Status))) {
+        if (Status == STATUS_NOT_SUPPORTED) {
+            errno = EOPNOTSUPP;
+
+        } else {
+            errno = ClConvertKstatusToErrorNumber(Status);
+        }
+
+        return -1;
+    }
+
+    return Total;
+}
+
 LIBC_API
 ssize_t
 recv (
@@ -1198,6 +1369,182 @@ Return Value:
     return (ssize_t)(Parameters.BytesCompleted);
 }
 
+LIBC_API
+int
+recvmmsg (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags,
+    struct timespec *Timeout
+    )
+
+/*++
+
+Routine Description:
+
+    This routine receives several messages from a socket with as few system
+    calls as possible. Each message is received as if by recvmsg.
+
+Arguments:
+
+    Socket - Supplies the file descriptor of the socket to receive data from.
+
+    Messages - Supplies an array of initialized messages where the received
+        data will be returned. On success, the msg_len member of each received
+        message is set to the number of bytes received.
+
+    MessageCount - Supplies the number of elements in the message array.
+
+    Flags - Supplies a bitfield of flags governing the reception of the data.
+        See MSG_* definitions. MSG_WAITFORONE causes only the first message
+        to wait.
+
+    Timeout - Supplies an optional pointer to the maximum amount of time to
+        wait for each message. Supply NULL to wait indefinitely.
+
+Return Value:
+
+    Returns the number of messages received on success.
+
+    -1 on error, and the errno variable will be set to contain more information.
+
+--*/
+
+{
+
+    NETWORK_ADDRESS Addresses[SOCKET_BATCH_MESSAGE_COUNT];
+    UINTN BatchCount;
+    UINTN Completed;
+    SOCKET_IO_MESSAGE IoMessages[SOCKET_BATCH_MESSAGE_COUNT];
+    struct msghdr *Message;
+    UINTN MessageIndex;
+    PSOCKET_IO_PARAMETERS Parameters;
+    INT Result;
+    KSTATUS Status;
+    ULONG TimeoutInMilliseconds;
+    unsigned int Total;
+    UINTN VectorIndex;
+
+    if ((Messages == NULL) && (MessageCount != 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    Result = ClpConvertSpecificTimeoutToSystemTimeout(Timeout,
+                                                      &TimeoutInMilliseconds);
+
+    if (Result != 0) {
+        errno = Result;
+        return -1;
+    }
+
+    ASSERT_SOCKET_IO_FLAGS_ARE_EQUIVALENT();
+
+    Status = STATUS_SUCCESS;
+    Total = 0;
+    while (Total < MessageCount) {
+        BatchCount = MessageCount - Total;
+        if (BatchCount > SOCKET_BATCH_MESSAGE_COUNT) {
+            BatchCount = SOCKET_BATCH_MESSAGE_COUNT;
+        }
+
+        //
+        // Once something has been received, later batches should not wait if
+        // the caller only wanted to wait for one message.
+        //
+
+        if ((Total != 0) && ((Flags & MSG_WAITFORONE) != 0)) {
+            Flags |= MSG_DONTWAIT;
+        }
+
+        for (MessageIndex = 0; MessageIndex < BatchCount; MessageIndex += 1) {
+            Message = &(Messages[Total + MessageIndex].msg_hdr);
+            Parameters = &(IoMessages[MessageIndex].Parameters);
+            Parameters->Size = 0;
+            for (VectorIndex = 0;
+                 VectorIndex < Message->msg_iovlen;
+                 VectorIndex += 1) {
+
+                Parameters->Size += Message->msg_iov[VectorIndex].iov_len;
+            }
+
+            if (Parameters->Size > (UINTN)SSIZE_MAX) {
+                Parameters->Size = (UINTN)SSIZE_MAX;
+            }
+
+            Parameters->BytesCompleted = 0;
+            Parameters->IoFlags = 0;
+            Parameters->SocketIoFlags = Flags;
+            Parameters->TimeoutInMilliseconds = TimeoutInMilliseconds;
+            Parameters->NetworkAddress = NULL;
+            Parameters->RemotePath = NULL;
+            Parameters->RemotePathSize = 0;
+            if ((Message->msg_name != NULL) && (Message->msg_namelen != 0)) {
+                Addresses[MessageIndex].Domain = NetDomainInvalid;
+                ClpGetPathFromSocketAddress(Message->msg_name,
+                                            &(Message->msg_namelen),
+                                            &(Parameters->RemotePath),
+                                            &(Parameters->RemotePathSize));
+
+                Parameters->NetworkAddress = &(Addresses[MessageIndex]);
+            }
+
+            Parameters->ControlData = Message->msg_control;
+            Parameters->ControlDataSize = Message->msg_controllen;
+            IoMessages[MessageIndex].VectorArray =
+                                             (PIO_VECTOR)(Message->msg_iov);
+
+            IoMessages[MessageIndex].VectorCount = Message->msg_iovlen;
+        }
+
+        Completed = BatchCount;
+        Status = OsSocketPerformBatchIo((HANDLE)(UINTN)Socket,
+                                        0,
+                                        IoMessages,
+                                        &Completed);
+
+        //
+        // Fill in the results for each message received, converting the
+        // network address provided by the kernel to a C library socket
+        // address if requested.
+        //
+
+        for (MessageIndex = 0; MessageIndex < Completed; MessageIndex += 1) {
+            Message = &(Messages[Total + MessageIndex].msg_hdr);
+            Parameters = &(IoMessages[MessageIndex].Parameters);
+            Message->msg_flags = Parameters->SocketIoFlags;
+            Message->msg_controllen = Parameters->ControlDataSize;
+            Messages[Total + MessageIndex].msg_len = Parameters->BytesCompleted;
+            if ((Message->msg_name != NULL) && (Message->msg_namelen != 0)) {
+                ClConvertFromNetworkAddress(&(Addresses[MessageIndex]),
+                                            Message->msg_name,
+                                            &(Message->msg_namelen),
+                                            Parameters->RemotePath,
+                                            Parameters->RemotePathSize);
+            }
+        }
+
+        Total += Completed;
+        if ((!KSUCCESS(Status)) || (Completed != BatchCount)) {
+            break;
+        }
+    }
+
+    if ((Total == 0) && (!KSUCCESS(Status)) && (Status != STATUS_END_OF_FILE)) {
+        if (Status == STATUS_NOT_SUPPORTED) {
+            errno = EOPNOTSUPP;
+
+        } else {
+            errno = ClConvertKstatusToErrorNumber(Status);
+        }
+
+        return -1;
+    }
+
+    return Total;
+}
+
 LIBC_API
 int
 shutdown (
@@ -1312,6 +1659,7 @@ Return Value:
     ASSERT_SOCKET_IPV4_OPTIONS_EQUIVALENT();
     ASSERT_SOCKET_IPV6_OPTIONS_EQUIVALENT();
     ASSERT_SOCKET_TCP_OPTIONS_EQUIVALENT();
+    ASSERT_SOCKET_UDP_OPTIONS_EQUIVALENT();
 
     LocalOptionLength = OptionLength;
     Status = OsSocketGetSetInformation((HANDLE)(UINTN)Socket,
@@ -1396,6 +1744,7 @@ Return Value:
     ASSERT_SOCKET_IPV4_OPTIONS_EQUIVALENT();
     ASSERT_SOCKET_IPV6_OPTIONS_EQUIVALENT();
     ASSERT_SOCKET_TCP_OPTIONS_EQUIVALENT();
+    ASSERT_SOCKET_UDP_OPTIONS_EQUIVALENT();
 
     //
     // Get the converted socket option from the system.
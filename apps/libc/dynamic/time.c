@@ -1737,7 +1737,7 @@ Return Value:
     SYSTEM_TIME SystemTime;
 
     if (Time != NULL) {
-        OsGetSystemTime(&SystemTime);
+        OsGetHighPrecisionSystemTime(&SystemTime);
         Seconds = ClpConvertSystemTimeToUnixTime(&SystemTime);
         Time->tv_sec = Seconds;
         Time->tv_usec = SystemTime.Nanoseconds / NANOSECONDS_PER_MICROSECOND;
@@ -150,7 +150,7 @@ extern "C" {
 // Define the maximum number of bytes in a terminal canonical line.
 //
 
-#define MAX_CANON 511
+#define MAX_CANON 4095
 
 //
 // Define the minimum number of bytes for which space is available in a
@@ -158,7 +158,7 @@ extern "C" {
 // application may require to be typed as input before reading them.
 //
 
-#define MAX_INPUT 511
+#define MAX_INPUT 4095
 
 //
 // Define the maximum length of a file, not including the null terminator.
@@ -0,0 +1,61 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU Lesser General Public
+    License version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details.
+
+Module Name:
+
+    udp.h
+
+Abstract:
+
+    This header contains definitions specific to the User Datagram Protocol
+    (UDP).
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+#ifndef _NETINET_UDP_H
+#define _NETINET_UDP_H
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// UDP socket options.
+//
+
+//
+// Set this option to have each send split into datagrams of the given size,
+// with only the last datagram possibly being shorter. This lets a single
+// system call send many datagrams. Set it to zero to send each buffer as a
+// single datagram. This option takes an integer.
+//
+
+#define UDP_SEGMENT 1
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+#endif
+
@@ -1470,6 +1470,80 @@ Return Value:
 
 --*/
 
+LIBC_API
+uint32_t
+arc4random (
+    void
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns a cryptographically strong random number. It never
+    fails, and needs no seeding.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a random number between 0 and 0xFFFFFFFF, inclusive.
+
+--*/
+
+LIBC_API
+void
+arc4random_buf (
+    void *Buffer,
+    size_t Size
+    );
+
+/*++
+
+Routine Description:
+
+    This routine fills a buffer with cryptographically strong random bytes.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the buffer to fill.
+
+    Size - Supplies the number of bytes to write.
+
+Return Value:
+
+    None.
+
+--*/
+
+LIBC_API
+uint32_t
+arc4random_uniform (
+    uint32_t UpperBound
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns a cryptographically strong random number less than
+    the given upper bound. Unlike arc4random() % UpperBound, every result is
+    equally likely.
+
+Arguments:
+
+    UpperBound - Supplies the exclusive upper bound of the result.
+
+Return Value:
+
+    Returns a random number between 0 and UpperBound - 1, inclusive.
+
+    0 if the upper bound is less than 2.
+
+--*/
+
 LIBC_API
 int
 system (
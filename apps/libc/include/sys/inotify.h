@@ -0,0 +1,322 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU Lesser General Public
+    License version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details.
+
+Module Name:
+
+    inotify.h
+
+Abstract:
+
+    This header contains definitions for watching files and directories for
+    changes.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+#ifndef _SYS_INOTIFY_H
+#define _SYS_INOTIFY_H
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <stdint.h>
+#include <fcntl.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+//
+// Define flags to inotify_init1.
+//
+
+#define IN_NONBLOCK O_NONBLOCK
+#define IN_CLOEXEC O_CLOEXEC
+
+//
+// Define the events that can be watched for and returned.
+//
+
+//
+// This event is accepted for compatibility, but is never reported.
+//
+
+#define IN_ACCESS 0x00000001
+
+//
+// This event is reported when a file is written to or truncated.
+//
+
+#define IN_MODIFY 0x00000002
+
+//
+// This event is reported when the permissions, ownership, time stamps, or
+// link count of a file change.
+//
+
+#define IN_ATTRIB 0x00000004
+
+//
+// These events are accepted for compatibility, but are never reported.
+//
+
+#define IN_CLOSE_WRITE 0x00000008
+#define IN_CLOSE_NOWRITE 0x00000010
+#define IN_OPEN 0x00000020
+
+//
+// These events are reported on a watched directory when an entry is renamed
+// out of or into it. The two halves of a rename share a cookie.
+//
+
+#define IN_MOVED_FROM 0x00000040
+#define IN_MOVED_TO 0x00000080
+
+//
+// These events are reported on a watched directory when an entry is created
+// in or deleted from it.
+//
+
+#define IN_CREATE 0x00000100
+#define IN_DELETE 0x00000200
+
+//
+// These events are reported when the watched file or directory itself loses
+// its last link or is renamed.
+//
+
+#define IN_DELETE_SELF 0x00000400
+#define IN_MOVE_SELF 0x00000800
+
+#define IN_CLOSE (IN_CLOSE_WRITE | IN_CLOSE_NOWRITE)
+#define IN_MOVE (IN_MOVED_FROM | IN_MOVED_TO)
+
+#define IN_ALL_EVENTS                                       \
+    (IN_ACCESS | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE |   \
+     IN_CLOSE_NOWRITE | IN_OPEN | IN_MOVED_FROM |           \
+     IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_DELETE_SELF | \
+     IN_MOVE_SELF)
+
+//
+// Define the bits that are only ever returned in events.
+//
+
+//
+// This bit is set in the event reported when events were dropped because
+// the queue was full. Its watch descriptor is -1.
+//
+
+#define IN_Q_OVERFLOW 0x00004000
+
+//
+// This bit is set in the last event reported for a watch, after it has been
+// removed.
+//
+
+#define IN_IGNORED 0x00008000
+
+//
+// This bit is set if the subject of the event is a directory.
+//
+
+#define IN_ISDIR 0x40000000
+
+//
+// Define the flags that can be passed to inotify_add_watch.
+//
+
+//
+// Set this flag to fail if the path is not a directory.
+//
+
+#define IN_ONLYDIR 0x01000000
+
+//
+// Set this flag to watch a symbolic link itself rather than its target.
+//
+
+#define IN_DONT_FOLLOW 0x02000000
+
+//
+// Set this flag to add to the events of an existing watch on the same file
+// rather than replacing them.
+//
+
+#define IN_MASK_ADD 0x20000000
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines an event read from a watch queue. Reads return
+    whole events only.
+
+Members:
+
+    wd - Stores the watch descriptor the event belongs to.
+
+    mask - Stores the bitmask of events that occurred. See IN_* definitions.
+
+    cookie - Stores a value that ties together the two halves of a rename, or
+        zero.
+
+    len - Stores the size of the name that follows in bytes, including the
+        terminator and any padding. This is zero for events about the watched
+        object itself.
+
+    name - Stores the null terminated name of the directory entry the event
+        is about, for events on watched directories.
+
+--*/
+
+struct inotify_event {
+    int wd;
+    uint32_t mask;
+    uint32_t cookie;
+    uint32_t len;
+    char name[];
+};
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+LIBC_API
+int
+inotify_init (
+    void
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new watch queue.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a file descriptor for the new queue on success.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+LIBC_API
+int
+inotify_init1 (
+    int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new watch queue.
+
+Arguments:
+
+    Flags - Supplies a bitfield of flags governing the new descriptor. See
+        IN_NONBLOCK and IN_CLOEXEC.
+
+Return Value:
+
+    Returns a file descriptor for the new queue on success.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+LIBC_API
+int
+inotify_add_watch (
+    int FileDescriptor,
+    const char *Path,
+    uint32_t Mask
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds a watch on a file or directory to a watch queue, or
+    updates the existing watch if the queue already watches that file.
+
+Arguments:
+
+    FileDescriptor - Supplies the watch queue descriptor.
+
+    Path - Supplies a pointer to the path of the file or directory to watch.
+
+    Mask - Supplies the events to watch for, combined with any IN_ONLYDIR,
+        IN_DONT_FOLLOW, or IN_MASK_ADD flags.
+
+Return Value:
+
+    Returns the watch descriptor on success.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+LIBC_API
+int
+inotify_rm_watch (
+    int FileDescriptor,
+    int WatchDescriptor
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes a watch from a watch queue. An IN_IGNORED event is
+    reported for it.
+
+Arguments:
+
+    FileDescriptor - Supplies the watch queue descriptor.
+
+    WatchDescriptor - Supplies the watch descriptor to remove.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+#ifdef __cplusplus
+
+}
+
+#endif
+#endif
+
@@ -0,0 +1,102 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU Lesser General Public
+    License version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details.
+
+Module Name:
+
+    random.h
+
+Abstract:
+
+    This header contains definitions for getting random bytes straight from
+    the kernel.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+--*/
+
+#ifndef _SYS_RANDOM_H
+#define _SYS_RANDOM_H
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <sys/types.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#endif
+
+//
+// Define flags to getrandom. The kernel generators never block once the
+// system random source is up, and serve both kinds of request the same way,
+// so these are accepted for compatibility.
+//
+
+#define GRND_NONBLOCK 0x00000001
+#define GRND_RANDOM 0x00000002
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// -------------------------------------------------------- Function Prototypes
+//
+
+LIBC_API
+ssize_t
+getrandom (
+    void *Buffer,
+    size_t Size,
+    unsigned int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine fills a buffer with random bytes from the kernel's random
+    number generators, without going through the random device.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the buffer to fill.
+
+    Size - Supplies the number of bytes to write.
+
+    Flags - Supplies a bitfield of flags. See GRND_* definitions.
+
+Return Value:
+
+    Returns the number of bytes written, which may be less than requested
+    for very large requests.
+
+    -1 on failure, and errno will be set to indicate more information.
+
+--*/
+
+#ifdef __cplusplus
+
+}
+
+#endif
+#endif
+
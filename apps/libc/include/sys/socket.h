@@ -240,6 +240,13 @@ extern "C" {
 
 #define MSG_DONTROUTE 0x00000100
 
+//
+// This flag is only valid for recvmmsg. It requests that the call block for
+// the first message, but not wait for any of the messages after it.
+//
+
+#define MSG_WAITFORONE 0x00000200
+
 //
 // Define the shutdown types. Read closes the socket for further reading, write
 // closes the socket for further writing, and rdwr closes the socket for both
@@ -469,6 +476,12 @@ extern "C" {
 // ------------------------------------------------------ Data Type Definitions
 //
 
+//
+// This definition is needed by recvmmsg.
+//
+
+struct timespec;
+
 //
 // Define the unsigned integer type used for the sockaddr family type.
 //
@@ -583,6 +596,26 @@ struct msghdr {
 
 /*++
 
+Structure Description:
+
+    This structure defines a single message in a batch sent with sendmmsg or
+    received with recvmmsg.
+
+Members:
+
+    msg_hdr - Stores the message itself.
+
+    msg_len - Stores the number of bytes sent or received for this message.
+
+--*/
+
+struct mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
+/*++
+
 Structure Description:
 
     This structure defines a socket control message, the header for the socket
@@ -1001,6 +1034,43 @@ Return Value:
 
 --*/
 
+LIBC_API
+int
+sendmmsg (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sends several messages out of a socket with as few system
+    calls as possible. Each message is sent as if by sendmsg.
+
+Arguments:
+
+    Socket - Supplies the file descriptor of the socket to send data out of.
+
+    Messages - Supplies an array of messages to send. On success, the msg_len
+        member of each sent message is set to the number of bytes sent.
+
+    MessageCount - Supplies the number of elements in the message array.
+
+    Flags - Supplies a bitfield of flags governing the transmission of the data.
+        See MSG_* definitions.
+
+Return Value:
+
+    Returns the number of messages sent on success. This may be less than the
+    requested count if an error occurred partway through.
+
+    -1 on error, and the errno variable will be set to contain more information.
+
+--*/
+
 LIBC_API
 ssize_t
 recv (
@@ -1116,6 +1186,48 @@ Return Value:
 
 --*/
 
+LIBC_API
+int
+recvmmsg (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int MessageCount,
+    int Flags,
+    struct timespec *Timeout
+    );
+
+/*++
+
+Routine Description:
+
+    This routine receives several messages from a socket with as few system
+    calls as possible. Each message is received as if by recvmsg.
+
+Arguments:
+
+    Socket - Supplies the file descriptor of the socket to receive data from.
+
+    Messages - Supplies an array of initialized messages where the received
+        data will be returned. On success, the msg_len member of each received
+        message is set to the number of bytes received.
+
+    MessageCount - Supplies the number of elements in the message array.
+
+    Flags - Supplies a bitfield of flags governing the reception of the data.
+        See MSG_* definitions. MSG_WAITFORONE causes only the first message
+        to wait.
+
+    Timeout - Supplies an optional pointer to the maximum amount of time to
+        wait for each message. Supply NULL to wait indefinitely.
+
+Return Value:
+
+    Returns the number of messages received on success.
+
+    -1 on error, and the errno variable will be set to contain more information.
+
+--*/
+
 LIBC_API
 int
 shutdown (
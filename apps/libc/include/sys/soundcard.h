@@ -284,6 +284,23 @@ extern "C" {
 
 #define SNDCTL_DSP_SETTRIGGER 0x501F
 
+//
+// This ioctl blocks until the device completes another fragment. It takes an
+// unsigned int holding the low 32 bits of the fragment count the caller last
+// saw in the mapped status page, and returns the current count. It only makes
+// sense to use together with mmap, and fails if the status page has not been
+// mapped.
+//
+
+#define SNDCTL_DSP_WAIT_FRAGMENT 0x5020
+
+//
+// Define the mmap offset of the device status page. Mapping one page at this
+// offset maps a dsp_mmap_status structure.
+//
+
+#define DSP_MMAP_STATUS_OFFSET 0x100000000LL
+
 //
 // Define the audio format bits.
 //
@@ -456,6 +473,49 @@ typedef struct count_info {
 
 /*++
 
+Structure Description:
+
+    This structure defines the status page of a sound device, which is mapped
+    with mmap at DSP_MMAP_STATUS_OFFSET. The device updates it each time a
+    fragment completes.
+
+Members:
+
+    sequence - Stores a sequence number that is odd while the device is
+        updating the page. Read it before and after reading the other
+        members, and retry if it was odd or changed.
+
+    ptr - Stores the offset of the hardware within the DMA buffer as of the
+        last completed fragment.
+
+    bufsize - Stores the size of the DMA buffer, in bytes.
+
+    fragsize - Stores the size of each fragment, in bytes.
+
+    bytes - Stores the total number of bytes processed by the device.
+
+    blocks - Stores the total number of fragments processed by the device.
+
+    timestamp - Stores the value of the system time counter when the page was
+        last updated.
+
+    frequency - Stores the frequency of the time counter, in Hz.
+
+--*/
+
+typedef struct dsp_mmap_status {
+    volatile unsigned int sequence;
+    unsigned int ptr;
+    unsigned int bufsize;
+    unsigned int fragsize;
+    unsigned long long bytes;
+    unsigned long long blocks;
+    unsigned long long timestamp;
+    unsigned long long frequency;
+} dsp_mmap_status;
+
+/*++
+
 Structure Description:
 
     This structure defines a set of enumerated audio devices. It stores a list
@@ -4083,6 +4083,35 @@ Return Value:
 
 --*/
 
+LIBC_API
+int
+getentropy (
+    void *Buffer,
+    size_t Size
+    );
+
+/*++
+
+Routine Description:
+
+    This routine fills a buffer with random bytes suitable for seeding a
+    cryptographic random number generator.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the buffer to fill.
+
+    Size - Supplies the number of bytes to write. This may be at most 256.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will be set to indicate more information. This
+    fails with EIO if more than 256 bytes are requested.
+
+--*/
+
 #ifdef __cplusplus
 
 }
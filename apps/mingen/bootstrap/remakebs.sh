@@ -53,11 +53,12 @@ for os in Windows Darwin Linux Minoca; do
     ## created mingen will then be able to build the real OS Makefile. The
     ## --unanchored flag prevents the input and output directories from being
     ## filled out. Without it these generated files would change based on the
-    ## caller's build directory.
+    ## caller's build directory. Each OS has a different configuration, so
+    ## there's nothing to gain from leaving a build graph cache in the source.
     ##
 
     mingen --format=make -i$input -O$destdir/Makefile.$os --unanchored \
-        --no-generator --build-os=$os,i686 apps/mingen:build_mingen
+        --no-generator --no-cache --build-os=$os,i686 apps/mingen:build_mingen
 
 done
 
@@ -48,6 +48,15 @@ from io import open;
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+function
+_makePrintSection (
+    file,
+    config,
+    targets,
+    start,
+    end
+    );
+
 function
 _makePrintConfig (
     file,
@@ -126,6 +135,89 @@ var _makeLineContinuation = " \\\n        ";
 // ------------------------------------------------------------------ Functions
 //
 
+class MakeSectionWriter {
+    var _parts;
+
+    function
+    __init (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine initializes a writer that collects the text of one section
+        of the Makefile in memory.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        Returns the initialized object.
+
+    --*/
+
+    {
+
+        _parts = [];
+        return this;
+    }
+
+    function
+    write (
+        data
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine adds text to the section.
+
+    Arguments:
+
+        data - Supplies the string to add.
+
+    Return Value:
+
+        None.
+
+    --*/
+
+    {
+
+        _parts.append(data);
+        return;
+    }
+
+    function
+    text (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine returns the text collected so far.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        Returns the section text.
+
+    --*/
+
+    {
+
+        return "".join(_parts);
+    }
+}
+
 class MakeVariableTransformer {
     function
     __get (
@@ -207,7 +299,9 @@ Routine Description:
     config - Supplies the application configuration
 
     entries - Supplies a dictionary containing the tools, targets, pools, and
-        build directories.
+        build directories. The cachedSections member holds the text of each
+        module's targets that can be reused from the previous run, and the
+        text of every module's targets is saved to the sections member.
 
 Return Value:
 
@@ -219,12 +313,17 @@ Return Value:
 
 {
 
+    var cachedSections = entries.cachedSections;
+    var end;
     var file;
+    var index;
     var makefilePath;
     var module;
+    var section;
     var targetsList = entries.targetsList;
     var tool;
     var tools;
+    var writer;
 
     if (config.output_file) {
         makefilePath = config.output_file;
@@ -280,10 +379,86 @@ Return Value:
 
     //
     // Loop over every target. Targets are bunched together by module due to
-    // the way they're added to the list.
+    // the way they're added to the list, so print them a module at a time,
+    // reusing the previous run's text where possible.
     //
 
-    for (target in targetsList) {
+    index = 0;
+    while (index < targetsList.length()) {
+        module = targetsList[index].module;
+        end = index + 1;
+        while ((end < targetsList.length()) &&
+               (targetsList[end].module == module)) {
+
+            end += 1;
+        }
+
+        section = cachedSections.get(module);
+        if (section == null) {
+            writer = MakeSectionWriter();
+            _makePrintSection(writer, config, targetsList, index, end);
+            section = [writer.text(), false];
+        }
+
+        entries.sections[module] = section;
+        file.write(section[0]);
+        index = end;
+    }
+
+    _makePrintBuildDirectoriesTarget(file, config, entries.buildDirectories);
+    if (config.generator) {
+        _makePrintMakefileTarget(file, config, entries.scripts);
+    }
+
+    file.close();
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+function
+_makePrintSection (
+    file,
+    config,
+    targets,
+    start,
+    end
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints the active targets of one module.
+
+Arguments:
+
+    file - Supplies the file being written.
+
+    config - Supplies the application configuration.
+
+    targets - Supplies the list of all targets.
+
+    start - Supplies the index of the module's first target.
+
+    end - Supplies the index one beyond the module's last target.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    var module;
+    var target;
+    var tool;
+
+    for (index in start..end) {
+        target = targets[index];
         if (!target.active) {
             continue;
         }
@@ -347,19 +522,9 @@ Return Value:
         file.write("\n\n");
     }
 
-    _makePrintBuildDirectoriesTarget(file, config, entries.buildDirectories);
-    if (config.generator) {
-        _makePrintMakefileTarget(file, config, entries.scripts);
-    }
-
-    file.close();
     return;
 }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
-
 function
 _makePrintConfig (
     file,
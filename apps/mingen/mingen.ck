@@ -30,7 +30,11 @@ Module Name:
 // ------------------------------------------------------------------- Includes
 //
 
+import _time;
 from app import argv;
+from io import open;
+from iobase import IoError;
+from json import dumps, loads;
 from make import buildMakefile;
 from ninja import buildNinja;
 from getopt import gnuGetopt;
@@ -46,7 +50,21 @@ from os import getcwd;
 //
 
 var VERSION_MAJOR = 2;
-var VERSION_MINOR = 0;
+var VERSION_MINOR = 1;
+
+//
+// Define the version of the build graph cache format. Bump this whenever the
+// cache layout or the meaning of cached entries changes.
+//
+
+var CACHE_VERSION = 1;
+
+//
+// Define the FNV-1a parameters used to hash build scripts.
+//
+
+var FNV_OFFSET_BASIS = 0x811C9DC5;
+var FNV_PRIME = 0x01000193;
 
 //
 // ------------------------------------------------------ Data Type Definitions
@@ -60,6 +78,60 @@ function
 _loadProjectRoot (
     );
 
+function
+_loadCache (
+    rootEntries
+    );
+
+function
+_saveCache (
+    );
+
+function
+_getCachedEntries (
+    name,
+    scriptFile
+    );
+
+function
+_setCachedEntries (
+    name,
+    scriptFile,
+    entries
+    );
+
+function
+_getFileInfo (
+    path
+    );
+
+function
+_findImports (
+    text
+    );
+
+function
+_resolveImport (
+    name
+    );
+
+function
+_hashString (
+    data
+    );
+
+function
+_findCachedSections (
+    );
+
+function
+_printStats (
+    );
+
+function
+_now (
+    );
+
 function
 _processEntries (
     );
@@ -171,12 +243,14 @@ var longOptions = [
     "expr=",
     "debug",
     "format=",
+    "no-cache",
     "no-generator",
     "input=",
     "dry-run",
     "output=",
     "output-file=",
     "help",
+    "stats",
     "unanchored",
     "verbose",
     "version"
@@ -195,6 +269,8 @@ var usage =
     "  -f, --format=fmt -- Specify the output format as make or ninja. The \n"
     "      default is make.\n"
     "  -g, --no-generator -- Don't include a re-generate rule in the output.\n"
+    "  --no-cache -- Evaluate every build file rather than reusing results \n"
+    "      cached from the previous run.\n"
     "  -n, --dry-run -- Do all the processing, but do not actually create \n"
     "      any output files.\n"
     "  -i, --input=dir -- Sets the top level directory of the source. The \n"
@@ -202,6 +278,7 @@ var usage =
     "  -o, --output=build_dir -- Set the given directory as the build \n"
     "      output directory.\n"
     "  -O, --output-file=file -- Set the output file name.\n"
+    "  --stats -- Print the time spent in each phase of generation.\n"
     "  -u, --unanchored -- Leave the input and output directories blank in \n"
     "      the final build file. They must be specified manually later.\n"
     "  -v, --verbose -- Print more information during processing.\n"
@@ -214,9 +291,11 @@ var config = {
     "debug": false,
     "format": null,
     "generator": true,
+    "cache": true,
     "input": null,
     "output": null,
     "output_file": null,
+    "stats": false,
     "unanchored": false,
     "verbose": false,
     "build_module_name": "build",
@@ -236,6 +315,36 @@ var pools = {};
 var buildDirectories = {};
 var scripts = {};
 
+//
+// Store the build graph cache loaded from the previous run, the cache being
+// built up for the next run, and the information gathered about each script
+// file during this run.
+//
+
+var cache;
+var cachePath;
+var nextCache;
+var cachedModules = {};
+var fileInfo = {};
+var resolvedImports = {};
+
+//
+// Store the time spent in each phase along with some counters, printed with
+// --stats.
+//
+
+var stats = {
+    "root": 0,
+    "cache": 0,
+    "modules": 0,
+    "targets": 0,
+    "select": 0,
+    "output": 0,
+    "evaluated": 0,
+    "cached": 0,
+    "hashed": 0
+};
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -270,6 +379,7 @@ Return Value:
     var currentDirectory = getcwd().replace("\\", "/", -1);
     var entries = {};
     var name;
+    var start;
     var value;
 
     //
@@ -311,6 +421,9 @@ Return Value:
         } else if ((name == "-g") || (name == "--no-generator")) {
             config.generator = false;
 
+        } else if (name == "--no-cache") {
+            config.cache = false;
+
         } else if ((name == "-n") || (name == "--dry-run")) {
             config.format = "none";
 
@@ -327,6 +440,9 @@ Return Value:
         } else if ((name == "-O") || (name == "--output-file")) {
             config.output_file = value;
 
+        } else if (name == "--stats") {
+            config.stats = true;
+
         } else if ((name == "-u") || (name == "--unanchored")) {
             config.unanchored = true;
 
@@ -358,10 +474,16 @@ Return Value:
         Core.print("Module search path: " + Core.modulePath().__str());
     }
 
+    start = _now();
     _loadProjectRoot();
     config.format ?= "make";
+    stats.root = _now() - start;
+    start = _now();
     _processEntries();
+    stats.targets = _now() - start - stats.modules;
+    start = _now();
     _selectTargets();
+    stats.select = _now() - start;
     if (config.verbose) {
         _printAllEntries();
     }
@@ -372,6 +494,9 @@ Return Value:
     entries.pools = pools;
     entries.buildDirectories = buildDirectories;
     entries.scripts = scripts;
+    entries.cachedSections = _findCachedSections();
+    entries.sections = {};
+    start = _now();
     if (config.format == "make") {
         buildMakefile(config, entries);
 
@@ -379,6 +504,22 @@ Return Value:
         buildNinja(config, entries);
     }
 
+    stats.output = _now() - start;
+    if (config.format != "none") {
+        if ((nextCache != null) && (config.targets.length() == 0)) {
+            nextCache.output = {
+                "format": config.format,
+                "sections": entries.sections
+            };
+        }
+
+        _saveCache();
+    }
+
+    if (config.stats) {
+        _printStats();
+    }
+
     if (config.verbose) {
         Core.print("Done");
     }
@@ -415,6 +556,7 @@ Return Value:
     var build;
     var entries;
     var module = Core.importModule(config.build_module_name);
+    var rootEntries;
 
     module.run();
     modules[""] = module;
@@ -430,14 +572,679 @@ Return Value:
 
     build = module.build;
     entries = build();
-    _validateEntries("", entries);
     if (!config.output) {
         config.output = config.input;
     }
 
+    //
+    // The root entries are always evaluated. Together with the configuration
+    // they determine whether the cached results of the other modules apply.
+    //
+
+    if (config.cache) {
+        try {
+            rootEntries = dumps(entries, 0);
+
+        } except TypeError {
+            config.cache = false;
+        }
+
+        if (config.cache) {
+            _loadCache(rootEntries);
+        }
+    }
+
+    _validateEntries("", entries);
+    return;
+}
+
+function
+_loadCache (
+    rootEntries
+    )
+
+/*++
+
+Routine Description:
+
+    This routine loads the build graph cache left by the previous run. The
+    cache is only used if the configuration and root entries match the ones
+    it was created with.
+
+Arguments:
+
+    rootEntries - Supplies the serialized entries of the root build module.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    var data;
+    var file;
+    var fingerprint;
+    var ignoredKeys;
+    var settings = {};
+    var start = _now();
+
+    if (config.output_file) {
+        cachePath = config.output_file + ".cache";
+
+    } else {
+        cachePath = config.output + "/mingen.cache";
+        cachePath = cachePath.template({config.input_variable: config.input},
+                                       0);
+    }
+
+    //
+    // Everything in the configuration can change what the build files
+    // produce, except for options that only affect this run.
+    //
+
+    ignoredKeys = ["argv", "cache", "debug", "default_target", "format",
+                   "generator", "output_file", "stats", "targets",
+                   "unanchored", "verbose"];
+
+    for (key in config) {
+        if (!ignoredKeys.contains(key)) {
+            settings[key] = config[key];
+        }
+    }
+
+    try {
+        fingerprint = dumps([CACHE_VERSION, settings, rootEntries], 0);
+
+    } except TypeError {
+        config.cache = false;
+        return;
+    }
+
+    nextCache = {
+        "fingerprint": fingerprint,
+        "files": {},
+        "modules": {}
+    };
+
+    cache = null;
+    try {
+        file = open(cachePath, "rb");
+        data = file.readall();
+        file.close();
+        cache = loads(data);
+
+    } except IoError {
+        cache = null;
+
+    } except ValueError {
+        cache = null;
+    }
+
+    if ((cache != null) && (cache.get("fingerprint") != fingerprint)) {
+        if (config.verbose) {
+            Core.print("Build configuration changed, ignoring %s" % cachePath);
+        }
+
+        cache = null;
+    }
+
+    //
+    // The root module's entries are part of the fingerprint, so they're known
+    // to be unchanged if the cache applies.
+    //
+
+    if (cache != null) {
+        cachedModules[""] = true;
+    }
+
+    stats.cache += _now() - start;
+    return;
+}
+
+function
+_saveCache (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine writes out the build graph cache for the next run.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    var file;
+    var start = _now();
+
+    if ((!config.cache) || (nextCache == null)) {
+        return;
+    }
+
+    //
+    // Record the information for every file that was looked at, so that an
+    // unchanged file doesn't need to be read and hashed again next time.
+    //
+
+    for (path in fileInfo) {
+        if (fileInfo[path] != null) {
+            nextCache.files[path] = fileInfo[path];
+        }
+    }
+
+    try {
+        file = open(cachePath, "wb");
+        file.write(dumps(nextCache, 0));
+        file.close();
+
+    } except IoError as e {
+        if (config.verbose) {
+            Core.print("Failed to write %s: %s" % [cachePath, e.__str()]);
+        }
+    }
+
+    stats.cache += _now() - start;
+    return;
+}
+
+function
+_getCachedEntries (
+    name,
+    scriptFile
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the entries a build file produced in the previous
+    run, if neither it nor any of the modules it imports have changed since.
+
+Arguments:
+
+    name - Supplies the name of the build module.
+
+    scriptFile - Supplies the path of the build file, relative to the input
+        directory.
+
+Return Value:
+
+    Returns a new copy of the cached list of entries on success.
+
+    null if the build module must be evaluated.
+
+--*/
+
+{
+
+    var current;
+    var entry;
+    var hashes;
+
+    if ((!config.cache) || (cache == null)) {
+        return null;
+    }
+
+    entry = cache.modules.get(name);
+    if (entry == null) {
+        return null;
+    }
+
+    hashes = entry[0];
+    for (path in hashes) {
+        current = _getFileInfo(path);
+        if ((current == null) || (current[2] != hashes[path])) {
+            if (config.debug) {
+                Core.print("%s changed, reevaluating %s" % [path, scriptFile]);
+            }
+
+            return null;
+        }
+    }
+
+    //
+    // The entries are stored in serialized form so they can be handed to the
+    // next cache untouched, as validation modifies the live entries.
+    //
+
+    nextCache.modules[name] = entry;
+    cachedModules[name] = true;
+    return loads(entry[1]);
+}
+
+function
+_setCachedEntries (
+    name,
+    scriptFile,
+    entries
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records the entries a build file produced, along with the
+    hash of the build file and every build script it imports.
+
+Arguments:
+
+    name - Supplies the name of the build module.
+
+    scriptFile - Supplies the path of the build file, relative to the input
+        directory.
+
+    entries - Supplies the unvalidated entries returned by the build function.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    var hashes = {};
+    var index;
+    var info;
+    var path;
+    var pending;
+    var serialized;
+
+    if ((!config.cache) || (nextCache == null)) {
+        return;
+    }
+
+    try {
+        serialized = dumps(entries, 0);
+
+    } except TypeError {
+        return;
+    }
+
+    //
+    // Walk the imports transitively. Imports that don't resolve to a script
+    // are foreign modules, which aren't tracked.
+    //
+
+    pending = [config.input + "/" + scriptFile];
+    for (index = 0; index < pending.length(); index += 1) {
+        path = pending[index];
+        info = _getFileInfo(path);
+        if (info == null) {
+            return;
+        }
+
+        hashes[path] = info[2];
+        for (importName in info[3]) {
+            path = _resolveImport(importName);
+            if ((path != null) && (!hashes.containsKey(path)) &&
+                (!pending.contains(path))) {
+
+                pending.append(path);
+            }
+        }
+    }
+
+    nextCache.modules[name] = [hashes, serialized];
     return;
 }
 
+function
+_getFileInfo (
+    path
+    )
+
+/*++
+
+Routine Description:
+
+    This routine gets the content hash and imports of a build script. The
+    previous run's results are reused if the file's size and modification time
+    haven't changed.
+
+Arguments:
+
+    path - Supplies the path of the script.
+
+Return Value:
+
+    Returns a list of the modification time, size, content hash, and list of
+    imported module names.
+
+    null if the file could not be read.
+
+--*/
+
+{
+
+    var cached;
+    var data;
+    var file;
+    var info;
+    var modified;
+    var size;
+
+    if (fileInfo.containsKey(path)) {
+        return fileInfo[path];
+    }
+
+    try {
+        info = (os.stat)(path);
+        modified = info.st_mtime;
+        size = info.st_size;
+        if (cache != null) {
+            cached = cache.files.get(path);
+            if ((cached != null) && (cached[0] == modified) &&
+                (cached[1] == size)) {
+
+                fileInfo[path] = cached;
+                return cached;
+            }
+        }
+
+        file = open(path, "rb");
+        data = file.readall();
+        file.close();
+
+    } except os.OsError {
+        fileInfo[path] = null;
+        return null;
+
+    } except IoError {
+        fileInfo[path] = null;
+        return null;
+    }
+
+    //
+    // A file modified within the same second as it was hashed could change
+    // again without its modification time moving. Don't let the next run
+    // trust the timestamp in that case.
+    //
+
+    if (modified >= (_time.time)()) {
+        modified = -1;
+    }
+
+    info = [modified, size, _hashString(data), _findImports(data)];
+    fileInfo[path] = info;
+    stats.hashed += 1;
+    return info;
+}
+
+function
+_findImports (
+    text
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the names of the modules imported by a script.
+
+Arguments:
+
+    text - Supplies the contents of the script.
+
+Return Value:
+
+    Returns a list of module names.
+
+--*/
+
+{
+
+    var end;
+    var result = [];
+
+    for (line in text.split("\n", -1)) {
+        if (line.startsWith("import ")) {
+            line = line[7...-1];
+
+        } else if (line.startsWith("from ")) {
+            line = line[5...-1];
+
+        } else {
+            continue;
+        }
+
+        end = line.indexOf(" ");
+        if (end < 0) {
+            end = line.indexOf(";");
+        }
+
+        if (end > 0) {
+            result.append(line[0..end]);
+        }
+    }
+
+    return result;
+}
+
+function
+_resolveImport (
+    name
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the script for a module name along the module path.
+
+Arguments:
+
+    name - Supplies the module name.
+
+Return Value:
+
+    Returns the path to the module's script.
+
+    null if the module isn't a script, or isn't found.
+
+--*/
+
+{
+
+    var path;
+    var result;
+
+    if (resolvedImports.containsKey(name)) {
+        return resolvedImports[name];
+    }
+
+    for (directory in Core.modulePath()) {
+        path = directory + "/" + name.replace(".", "/", -1) + ".ck";
+        if ((os.isfile)(path)) {
+            result = path;
+            break;
+        }
+    }
+
+    resolvedImports[name] = result;
+    return result;
+}
+
+function
+_hashString (
+    data
+    )
+
+/*++
+
+Routine Description:
+
+    This routine computes the 32-bit FNV-1a hash of the given string.
+
+Arguments:
+
+    data - Supplies the string to hash.
+
+Return Value:
+
+    Returns the hash value.
+
+--*/
+
+{
+
+    var hash = FNV_OFFSET_BASIS;
+
+    for (index in 0..data.length()) {
+        hash = ((hash ^ data.byteAt(index)) * FNV_PRIME) & 0xFFFFFFFF;
+    }
+
+    return hash;
+}
+
+function
+_findCachedSections (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines which modules can have their section of the output
+    file copied from the previous run. That's the case when the module's
+    entries came from the cache, and so did the entries of every module its
+    targets refer to, since those determine the input paths printed.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a dictionary of module names and their cached output sections.
+
+--*/
+
+{
+
+    var module;
+    var result = {};
+    var sections;
+    var unchanged = {};
+
+    if ((!config.cache) || (cache == null) || (config.targets.length() != 0)) {
+        return result;
+    }
+
+    sections = cache.get("output");
+    if ((sections == null) || (sections.format != config.format)) {
+        return result;
+    }
+
+    sections = sections.sections;
+    for (module in cachedModules) {
+        unchanged[module] = true;
+    }
+
+    for (target in targetsList) {
+        if (!unchanged.get(target.module)) {
+            continue;
+        }
+
+        for (input in target.inputs + target.implicit + target.orderonly) {
+            if ((input is Dict) && (!cachedModules.get(input.module))) {
+                unchanged[target.module] = false;
+                break;
+            }
+        }
+    }
+
+    for (module in unchanged) {
+        if ((unchanged[module]) && (sections.containsKey(module))) {
+            result[module] = sections[module];
+        }
+    }
+
+    return result;
+}
+
+function
+_printStats (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints the time spent in each phase of generation.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    var total = stats.root + stats.modules + stats.targets + stats.select +
+                stats.output;
+
+    Core.print("mingen statistics:");
+    Core.print("  Root module:     %6dms" % (stats.root / 1000000));
+    Core.print("  Build modules:   %6dms (%d evaluated, %d cached)" %
+               [stats.modules / 1000000, stats.evaluated, stats.cached]);
+
+    Core.print("  Targets:         %6dms (%d targets)" %
+               [stats.targets / 1000000, targetsList.length()]);
+
+    Core.print("  Select:          %6dms" % (stats.select / 1000000));
+    Core.print("  Output:          %6dms (%s)" %
+               [stats.output / 1000000, config.format]);
+
+    Core.print("  Cache:           %6dms (%d files hashed)" %
+               [stats.cache / 1000000, stats.hashed]);
+
+    Core.print("  Total:           %6dms" % ((total + stats.cache) / 1000000));
+    return;
+}
+
+function
+_now (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the current monotonic time.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current time in nanoseconds.
+
+--*/
+
+{
+
+    var value = (_time.clock_gettime)(_time.CLOCK_MONOTONIC);
+
+    return (value[0] * 1000000000) + value[1];
+}
+
 function
 _processEntries (
     )
@@ -544,7 +1351,9 @@ _loadModule (
 Routine Description:
 
     This routine loads the given build file. If it has not yet been run, it
-    runs it and adds the entries to the global list.
+    runs it and adds the entries to the global list. If neither the build file
+    nor anything it imports has changed since the last run, the entries are
+    taken from the cache instead of running the build file.
 
 Arguments:
 
@@ -553,7 +1362,8 @@ Routine Description:
 
 Return Value:
 
-    None.
+    Returns the module, or the script file name if the module's entries came
+    from the cache and it was never imported.
 
 --*/
 
@@ -564,21 +1374,34 @@ Return Value:
     var fullName;
     var module;
     var scriptFile;
+    var start;
 
     module = modules.get(name);
     if (module) {
         return module;
     }
 
+    start = _now();
     fullName = name.replace("/", ".", -1) + "." + config.build_module_name;
-    module = Core.importModule(fullName);
-    module.run();
     scriptFile = fullName.replace(".", "/", -1) + ".ck";
+    entries = _getCachedEntries(name, scriptFile);
+    if (entries != null) {
+        module = scriptFile;
+        stats.cached += 1;
+
+    } else {
+        module = Core.importModule(fullName);
+        module.run();
+        build = module.build;
+        entries = build();
+        _setCachedEntries(name, scriptFile, entries);
+        stats.evaluated += 1;
+    }
+
     scripts[scriptFile] = true;
     modules[name] = module;
-    build = module.build;
-    entries = build();
     _validateEntries(name, entries);
+    stats.modules += _now() - start;
     return module;
 }
 
@@ -49,6 +49,15 @@ from os import OsError, EEXIST, dirname, mkdir;
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+function
+_ninjaPrintSection (
+    file,
+    config,
+    targets,
+    start,
+    end
+    );
+
 function
 _ninjaPrintConfig (
     file,
@@ -120,6 +129,89 @@ var _ninjaLineContinuation = " $\n        ";
 // ------------------------------------------------------------------ Functions
 //
 
+class NinjaSectionWriter {
+    var _parts;
+
+    function
+    __init (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine initializes a writer that collects the text of one section
+        of the Ninja file in memory.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        Returns the initialized object.
+
+    --*/
+
+    {
+
+        _parts = [];
+        return this;
+    }
+
+    function
+    write (
+        data
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine adds text to the section.
+
+    Arguments:
+
+        data - Supplies the string to add.
+
+    Return Value:
+
+        None.
+
+    --*/
+
+    {
+
+        _parts.append(data);
+        return;
+    }
+
+    function
+    text (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine returns the text collected so far.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        Returns the section text.
+
+    --*/
+
+    {
+
+        return "".join(_parts);
+    }
+}
+
 class NinjaVariableTransformer {
     function
     __get (
@@ -201,7 +293,9 @@ Routine Description:
     config - Supplies the application configuration
 
     entries - Supplies a dictionary containing the tools, targets, pools, and
-        build directories.
+        build directories. The cachedSections member holds the text of each
+        module's targets that can be reused from the previous run, and the
+        text of every module's targets is saved to the sections member.
 
 Return Value:
 
@@ -213,15 +307,20 @@ Return Value:
 
 {
 
+    var cachedSections = entries.cachedSections;
+    var end;
     var file;
+    var index;
     var module;
     var ninjaPath;
     var pools;
     var pool;
+    var section;
+    var skipped;
     var skippedNewline = false;
     var targetsList = entries.targetsList;
     var tools;
-    var totalInputs;
+    var writer;
 
     if (config.output_file) {
         ninjaPath = config.output_file;
@@ -314,21 +413,109 @@ Return Value:
     file.write("\n");
 
     //
-    // Loop over and print every active target.
+    // Loop over and print every active target. Targets are bunched together
+    // by module due to the way they're added to the list, so print them a
+    // module at a time, reusing the previous run's text where possible.
     //
 
-    targetsList = entries.targetsList;
-    for (target in targetsList) {
-        if (!target.active) {
-            continue;
+    index = 0;
+    while (index < targetsList.length()) {
+        module = targetsList[index].module;
+        end = index + 1;
+        while ((end < targetsList.length()) &&
+               (targetsList[end].module == module)) {
+
+            end += 1;
         }
 
-        if (target.module != module) {
-            module = target.module;
+        section = cachedSections.get(module);
+        if (section == null) {
+            writer = NinjaSectionWriter();
+            skipped = _ninjaPrintSection(writer,
+                                         config,
+                                         targetsList,
+                                         index,
+                                         end);
+
+            section = [writer.text(), skipped];
+        }
+
+        entries.sections[module] = section;
+        if (section[0] != "") {
             if (skippedNewline) {
                 file.write("\n");
             }
 
+            file.write(section[0]);
+            skippedNewline = section[1];
+        }
+
+        index = end;
+    }
+
+    if (config.generator) {
+        _ninjaPrintRebuildRule(file, config, entries.scripts);
+    }
+
+    _ninjaPrintDefaultTargets(file, config, targetsList);
+    file.close();
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+function
+_ninjaPrintSection (
+    file,
+    config,
+    targets,
+    start,
+    end
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints the active targets of one module.
+
+Arguments:
+
+    file - Supplies the file being written.
+
+    config - Supplies the application configuration.
+
+    targets - Supplies the list of all targets.
+
+    start - Supplies the index of the module's first target.
+
+    end - Supplies the index one beyond the module's last target.
+
+Return Value:
+
+    Returns true if the last target printed was not followed by a blank line.
+
+    Returns false if it was, or if no targets were printed.
+
+--*/
+
+{
+
+    var module;
+    var skippedNewline = false;
+    var target;
+    var totalInputs;
+
+    for (index in start..end) {
+        target = targets[index];
+        if (!target.active) {
+            continue;
+        }
+
+        if (module == null) {
+            module = target.module;
             if (module == "") {
                 file.write("# Define root targets\n");
 
@@ -375,19 +562,9 @@ Return Value:
         }
     }
 
-    if (config.generator) {
-        _ninjaPrintRebuildRule(file, config, entries.scripts);
-    }
-
-    _ninjaPrintDefaultTargets(file, config, targetsList);
-    file.close();
-    return;
+    return skippedNewline;
 }
 
-//
-// --------------------------------------------------------- Internal Functions
-//
-
 function
 _ninjaPrintConfig (
     file,
@@ -51,37 +51,55 @@ Module Name:
 //
 
 #define NETCON_VERSION_MAJOR 1
-#define NETCON_VERSION_MINOR 0
+#define NETCON_VERSION_MINOR 1
 
 #define NETCON_USAGE                                                           \
-    "usage: netcon [-d device] [-j ssid -p] [-l] [-s] [-v]\n\n"                \
+    "usage: netcon [-d device] [-j ssid -p] [-l] [-s] [-v]\n"                  \
+    "       netcon [-d device] [-a dest[/prefix] [-g gateway] [-m metric]]\n"  \
+    "       netcon [-d device] [-g gateway] -x dest[/prefix]\n"                \
+    "       netcon -r\n\n"                                                     \
     "The netcon utility configures network devices.\n\n"                       \
     "Options:\n"                                                               \
+    "  -a --add-route=dest[/prefix] -- Adds a route to the given\n"            \
+    "      destination out the device specified by -d. Leave off the\n"        \
+    "      prefix length to add a host route.\n"                               \
     "  -d --device=device -- Specifies the network device to configure.\n"     \
     "      This is optional for wireless commands if there is only 1\n"        \
     "      wireless device on the system.\n"                                   \
+    "  -g --gateway=address -- Specifies the gateway for a route being\n"      \
+    "      added or deleted.\n"                                                \
     "  -j --join=ssid -- Attempts to join the given wireless network.\n"       \
     "  -l --leave -- Attempts to leave the current wireless network.\n"        \
+    "  -m --metric=metric -- Specifies the metric of a route being added.\n"   \
+    "      Lower metrics are preferred.\n"                                     \
     "  -p --password -- Indicates that the user wants to be prompted for a\n"  \
     "      password during a join operation.\n"                                \
+    "  -r --routes -- Displays the routing tables.\n"                          \
     "  -s --scan -- Displays the list of wireless networks available to\n"     \
     "      the network device specified by -d.\n"                              \
     "  -v --verbose -- Display more detailed information.\n"                   \
+    "  -x --delete-route=dest[/prefix] -- Deletes routes to the given\n"       \
+    "      destination, limited to the device and gateway if supplied.\n"      \
     "  --help -- Display this help text.\n"                                    \
     "  --version -- Display the application version and exit.\n\n"
 
-#define NETCON_OPTIONS_STRING "d:j:lspvh"
+#define NETCON_OPTIONS_STRING "a:d:g:j:lm:prsvx:h"
 
 //
 // Define the set of network configuration flags.
 //
 
-#define NETCON_FLAG_DEVICE_ID 0x00000001
-#define NETCON_FLAG_JOIN      0x00000002
-#define NETCON_FLAG_LEAVE     0x00000004
-#define NETCON_FLAG_PASSWORD  0x00000008
-#define NETCON_FLAG_SCAN      0x00000010
-#define NETCON_FLAG_VERBOSE   0x00000020
+#define NETCON_FLAG_DEVICE_ID    0x00000001
+#define NETCON_FLAG_JOIN         0x00000002
+#define NETCON_FLAG_LEAVE        0x00000004
+#define NETCON_FLAG_PASSWORD     0x00000008
+#define NETCON_FLAG_SCAN         0x00000010
+#define NETCON_FLAG_VERBOSE      0x00000020
+#define NETCON_FLAG_ROUTES       0x00000040
+#define NETCON_FLAG_ADD_ROUTE    0x00000080
+#define NETCON_FLAG_DELETE_ROUTE 0x00000100
+#define NETCON_FLAG_GATEWAY      0x00000200
+#define NETCON_FLAG_METRIC       0x00000400
 
 #define NETCON_FLAG_WIRELESS_MASK \
     (NETCON_FLAG_JOIN | NETCON_FLAG_LEAVE | NETCON_FLAG_SCAN)
@@ -113,12 +131,27 @@ Structure Description:
 
     Ssid - Stores a pointer to the SSID of the network to join.
 
+    RouteDestination - Stores the destination of the route to add or delete.
+
+    RoutePrefixLength - Stores the prefix length of the route to add or
+        delete.
+
+    RouteGateway - Stores the gateway of the route to add or delete, if
+        NETCON_FLAG_GATEWAY is set.
+
+    RouteMetric - Stores the metric of the route to add, if
+        NETCON_FLAG_METRIC is set.
+
 --*/
 
 typedef struct _NETCON_CONTEXT {
     ULONG Flags;
     DEVICE_ID DeviceId;
     PSTR Ssid;
+    NETWORK_ADDRESS RouteDestination;
+    ULONG RoutePrefixLength;
+    NETWORK_ADDRESS RouteGateway;
+    ULONG RouteMetric;
 } NETCON_CONTEXT, *PNETCON_CONTEXT;
 
 /*++
@@ -309,17 +342,53 @@ NetconGet80211DeviceId (
     PDEVICE_ID DeviceId
     );
 
+VOID
+NetconListRoutes (
+    VOID
+    );
+
+VOID
+NetconParseRoute (
+    PNL_SOCKET Socket,
+    PNL_RECEIVE_CONTEXT Context,
+    PVOID Message
+    );
+
+VOID
+NetconChangeRoute (
+    PNETCON_CONTEXT Context
+    );
+
+INT
+NetconParseRouteAddress (
+    PSTR String,
+    PNETWORK_ADDRESS Address,
+    PULONG PrefixLength
+    );
+
+PSTR
+NetconFormatAddress (
+    PNETWORK_ADDRESS Address,
+    PSTR Buffer,
+    UINTN BufferSize
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
 struct option NetconLongOptions[] = {
+    {"add-route", required_argument, 0, 'a'},
     {"device", required_argument, 0, 'd'},
+    {"gateway", required_argument, 0, 'g'},
     {"join", required_argument, 0, 'j'},
     {"leave", no_argument, 0, 'l'},
+    {"metric", required_argument, 0, 'm'},
     {"password", no_argument, 0, 'p'},
+    {"routes", no_argument, 0, 'r'},
     {"scan", no_argument, 0, 's'},
     {"verbose", no_argument, 0, 'v'},
+    {"delete-route", required_argument, 0, 'x'},
     {"help", no_argument, 0, 'h'},
     {"version", no_argument, 0, 'V'},
     {NULL, 0, 0, 0}
@@ -392,6 +461,27 @@ Return Value:
         }
 
         switch (Option) {
+        case 'a':
+        case 'x':
+            ReturnValue = NetconParseRouteAddress(
+                                            optarg,
+                                            &(Context.RouteDestination),
+                                            &(Context.RoutePrefixLength));
+
+            if (ReturnValue != 0) {
+                fprintf(stderr, "Error: Invalid route '%s'.\n", optarg);
+                goto mainEnd;
+            }
+
+            if (Option == 'a') {
+                Context.Flags |= NETCON_FLAG_ADD_ROUTE;
+
+            } else {
+                Context.Flags |= NETCON_FLAG_DELETE_ROUTE;
+            }
+
+            break;
+
         case 'd':
             Context.DeviceId = strtoull(optarg, &AfterScan, 0);
             if (AfterScan == optarg) {
@@ -403,6 +493,19 @@ Return Value:
             Context.Flags |= NETCON_FLAG_DEVICE_ID;
             break;
 
+        case 'g':
+            ReturnValue = NetconParseRouteAddress(optarg,
+                                                  &(Context.RouteGateway),
+                                                  NULL);
+
+            if (ReturnValue != 0) {
+                fprintf(stderr, "Error: Invalid gateway '%s'.\n", optarg);
+                goto mainEnd;
+            }
+
+            Context.Flags |= NETCON_FLAG_GATEWAY;
+            break;
+
         case 'j':
             Context.Ssid = optarg;
             Context.Flags |= NETCON_FLAG_JOIN;
@@ -412,6 +515,21 @@ Return Value:
             Context.Flags |= NETCON_FLAG_LEAVE;
             break;
 
+        case 'm':
+            Context.RouteMetric = strtoul(optarg, &AfterScan, 0);
+            if (AfterScan == optarg) {
+                fprintf(stderr, "Error: Invalid metric '%s'.\n", optarg);
+                ReturnValue = EINVAL;
+                goto mainEnd;
+            }
+
+            Context.Flags |= NETCON_FLAG_METRIC;
+            break;
+
+        case 'r':
+            Context.Flags |= NETCON_FLAG_ROUTES;
+            break;
+
         case 's':
             Context.Flags |= NETCON_FLAG_SCAN;
             break;
@@ -475,6 +593,21 @@ Return Value:
     } else if ((Context.Flags & NETCON_FLAG_SCAN) != 0) {
         NetconScanForNetworks(&Context);
 
+    } else if ((Context.Flags & NETCON_FLAG_ADD_ROUTE) != 0) {
+        if ((Context.Flags & NETCON_FLAG_DEVICE_ID) == 0) {
+            fprintf(stderr, "Error: Adding a route requires a device.\n");
+            ReturnValue = EINVAL;
+            goto mainEnd;
+        }
+
+        NetconChangeRoute(&Context);
+
+    } else if ((Context.Flags & NETCON_FLAG_DELETE_ROUTE) != 0) {
+        NetconChangeRoute(&Context);
+
+    } else if ((Context.Flags & NETCON_FLAG_ROUTES) != 0) {
+        NetconListRoutes();
+
     } else if ((Context.Flags & NETCON_FLAG_DEVICE_ID) != 0) {
         ReturnValue = NetconGetDeviceInformation(Context.DeviceId, &Device);
         if (ReturnValue != 0) {
@@ -2548,3 +2681,628 @@ Return Value:
     return Result;
 }
 
+VOID
+NetconListRoutes (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints out the routing tables.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    USHORT FamilyId;
+    PNL_MESSAGE_BUFFER Message;
+    ULONG MessageLength;
+    NL_RECEIVE_PARAMETERS Parameters;
+    PNL_SOCKET Socket;
+    INT Status;
+
+    Message = NULL;
+    Socket = NULL;
+    Status = NlCreateSocket(NETLINK_GENERIC, NL_ANY_PORT_ID, 0, &Socket);
+    if (Status != 0) {
+        goto ListRoutesEnd;
+    }
+
+    Status = NlGenericGetFamilyId(Socket,
+                                  NETLINK_GENERIC_ROUTE_NAME,
+                                  &FamilyId);
+
+    if (Status != 0) {
+        goto ListRoutesEnd;
+    }
+
+    MessageLength = NETLINK_GENERIC_HEADER_LENGTH;
+    Status = NlAllocateBuffer(MessageLength, &Message);
+    if (Status != 0) {
+        goto ListRoutesEnd;
+    }
+
+    Status = NlGenericAppendHeaders(Socket,
+                                    Message,
+                                    0,
+                                    0,
+                                    FamilyId,
+                                    NETLINK_HEADER_FLAG_DUMP,
+                                    NETLINK_ROUTE_COMMAND_GET,
+                                    0);
+
+    if (Status != 0) {
+        goto ListRoutesEnd;
+    }
+
+    Status = NlSendMessage(Socket, Message, NETLINK_KERNEL_PORT_ID, 0, NULL);
+    if (Status != 0) {
+        goto ListRoutesEnd;
+    }
+
+    //
+    // Each route gets printed as it comes in. The receive returns once the
+    // whole dump and the acknowledgement have arrived.
+    //
+
+    printf("%-44s %-40s %-6s %s\n",
+           "Destination",
+           "Gateway",
+           "Metric",
+           "Device");
+
+    memset(&Parameters, 0, sizeof(NL_RECEIVE_PARAMETERS));
+    Parameters.ReceiveRoutine = NetconParseRoute;
+    Parameters.ReceiveContext.Type = FamilyId;
+    Parameters.Flags = NL_RECEIVE_FLAG_PORT_ID;
+    Parameters.PortId = NETLINK_KERNEL_PORT_ID;
+    Status = NlReceiveMessage(Socket, &Parameters);
+    if (Status != 0) {
+        goto ListRoutesEnd;
+    }
+
+    if (Parameters.ReceiveContext.Status != 0) {
+        Status = Parameters.ReceiveContext.Status;
+        goto ListRoutesEnd;
+    }
+
+ListRoutesEnd:
+    if (Message != NULL) {
+        NlFreeBuffer(Message);
+    }
+
+    if (Socket != NULL) {
+        NlDestroySocket(Socket);
+    }
+
+    if (Status != 0) {
+        perror("netcon: failed to get routes");
+    }
+
+    return;
+}
+
+VOID
+NetconParseRoute (
+    PNL_SOCKET Socket,
+    PNL_RECEIVE_CONTEXT Context,
+    PVOID Message
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses and prints a route message.
+
+Arguments:
+
+    Socket - Supplies a pointer to the netlink socket that received the message.
+
+    Context - Supplies a pointer to the receive context given to the receive
+        message handler.
+
+    Message - Supplies a pointer to the beginning of the netlink message. The
+        length of which can be obtained from the header; it was already
+        validated.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    USHORT AttributeLength;
+    PVOID Attributes;
+    CHAR DestinationBuffer[60];
+    PNETWORK_ADDRESS Destination;
+    PDEVICE_ID DeviceId;
+    PULONG Flags;
+    CHAR GatewayBuffer[60];
+    PNETWORK_ADDRESS Gateway;
+    PNETLINK_GENERIC_HEADER GenericHeader;
+    PNETLINK_HEADER Header;
+    ULONG MessageLength;
+    PULONG Metric;
+    PULONG PrefixLength;
+    INT Status;
+
+    Header = (PNETLINK_HEADER)Message;
+    if (Header->Type != Context->Type) {
+        return;
+    }
+
+    MessageLength = Header->Length;
+    MessageLength -= NETLINK_HEADER_LENGTH;
+    if (MessageLength < sizeof(NETLINK_GENERIC_HEADER)) {
+        return;
+    }
+
+    GenericHeader = NETLINK_DATA(Header);
+    if (GenericHeader->Command != NETLINK_ROUTE_COMMAND_GET) {
+        return;
+    }
+
+    MessageLength -= NETLINK_GENERIC_HEADER_LENGTH;
+    Attributes = NETLINK_GENERIC_DATA(GenericHeader);
+    Status = NlGetAttribute(Attributes,
+                            MessageLength,
+                            NETLINK_ROUTE_ATTRIBUTE_DESTINATION,
+                            (PVOID *)&Destination,
+                            &AttributeLength);
+
+    if ((Status != 0) || (AttributeLength != sizeof(NETWORK_ADDRESS))) {
+        goto ParseRouteEnd;
+    }
+
+    Status = NlGetAttribute(Attributes,
+                            MessageLength,
+                            NETLINK_ROUTE_ATTRIBUTE_GATEWAY,
+                            (PVOID *)&Gateway,
+                            &AttributeLength);
+
+    if ((Status != 0) || (AttributeLength != sizeof(NETWORK_ADDRESS))) {
+        goto ParseRouteEnd;
+    }
+
+    Status = NlGetAttribute(Attributes,
+                            MessageLength,
+                            NETLINK_ROUTE_ATTRIBUTE_DEVICE_ID,
+                            (PVOID *)&DeviceId,
+                            &AttributeLength);
+
+    if ((Status != 0) || (AttributeLength != sizeof(DEVICE_ID))) {
+        goto ParseRouteEnd;
+    }
+
+    Status = NlGetAttribute(Attributes,
+                            MessageLength,
+                            NETLINK_ROUTE_ATTRIBUTE_PREFIX_LENGTH,
+                            (PVOID *)&PrefixLength,
+                            &AttributeLength);
+
+    if ((Status != 0) || (AttributeLength != sizeof(ULONG))) {
+        goto ParseRouteEnd;
+    }
+
+    Status = NlGetAttribute(Attributes,
+                            MessageLength,
+                            NETLINK_ROUTE_ATTRIBUTE_METRIC,
+                            (PVOID *)&Metric,
+                            &AttributeLength);
+
+    if ((Status != 0) || (AttributeLength != sizeof(ULONG))) {
+        goto ParseRouteEnd;
+    }
+
+    Status = NlGetAttribute(Attributes,
+                            MessageLength,
+                            NETLINK_ROUTE_ATTRIBUTE_FLAGS,
+                            (PVOID *)&Flags,
+                            &AttributeLength);
+
+    if ((Status != 0) || (AttributeLength != sizeof(ULONG))) {
+        goto ParseRouteEnd;
+    }
+
+    NetconFormatAddress(Destination,
+                        DestinationBuffer,
+                        sizeof(DestinationBuffer));
+
+    snprintf(DestinationBuffer + strlen(DestinationBuffer),
+             sizeof(DestinationBuffer) - strlen(DestinationBuffer),
+             "/%u",
+             *PrefixLength);
+
+    if ((*Flags & NET_ROUTE_FLAG_GATEWAY) != 0) {
+        NetconFormatAddress(Gateway, GatewayBuffer, sizeof(GatewayBuffer));
+
+    } else {
+        strcpy(GatewayBuffer, "-");
+    }
+
+    printf("%-44s %-40s %-6u 0x%I64x%s\n",
+           DestinationBuffer,
+           GatewayBuffer,
+           *Metric,
+           *DeviceId,
+           ((*Flags & NET_ROUTE_FLAG_AUTOMATIC) != 0) ? "" : " (static)");
+
+    return;
+
+ParseRouteEnd:
+    Context->Status = -1;
+    errno = EINVAL;
+    return;
+}
+
+VOID
+NetconChangeRoute (
+    PNETCON_CONTEXT Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds or deletes the route described by the given context.
+
+Arguments:
+
+    Context - Supplies a pointer to the network configuration context.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UCHAR Command;
+    USHORT FamilyId;
+    PNL_MESSAGE_BUFFER Message;
+    ULONG MessageLength;
+    NL_RECEIVE_PARAMETERS Parameters;
+    ULONG PayloadLength;
+    PNL_SOCKET Socket;
+    INT Status;
+
+    Message = NULL;
+    Socket = NULL;
+    Command = NETLINK_ROUTE_COMMAND_DELETE;
+    if ((Context->Flags & NETCON_FLAG_ADD_ROUTE) != 0) {
+        Command = NETLINK_ROUTE_COMMAND_ADD;
+    }
+
+    Status = NlCreateSocket(NETLINK_GENERIC, NL_ANY_PORT_ID, 0, &Socket);
+    if (Status != 0) {
+        goto ChangeRouteEnd;
+    }
+
+    Status = NlGenericGetFamilyId(Socket,
+                                  NETLINK_GENERIC_ROUTE_NAME,
+                                  &FamilyId);
+
+    if (Status != 0) {
+        goto ChangeRouteEnd;
+    }
+
+    //
+    // The destination and prefix length are always sent. The rest are only
+    // sent if they were supplied.
+    //
+
+    PayloadLength = NETLINK_ATTRIBUTE_SIZE(sizeof(NETWORK_ADDRESS)) +
+                    NETLINK_ATTRIBUTE_SIZE(sizeof(ULONG));
+
+    if ((Context->Flags & NETCON_FLAG_DEVICE_ID) != 0) {
+        PayloadLength += NETLINK_ATTRIBUTE_SIZE(sizeof(DEVICE_ID));
+    }
+
+    if ((Context->Flags & NETCON_FLAG_GATEWAY) != 0) {
+        PayloadLength += NETLINK_ATTRIBUTE_SIZE(sizeof(NETWORK_ADDRESS));
+    }
+
+    if ((Context->Flags & NETCON_FLAG_METRIC) != 0) {
+        PayloadLength += NETLINK_ATTRIBUTE_SIZE(sizeof(ULONG));
+    }
+
+    MessageLength = NETLINK_GENERIC_HEADER_LENGTH + PayloadLength;
+    Status = NlAllocateBuffer(MessageLength, &Message);
+    if (Status != 0) {
+        goto ChangeRouteEnd;
+    }
+
+    Status = NlGenericAppendHeaders(Socket,
+                                    Message,
+                                    PayloadLength,
+                                    0,
+                                    FamilyId,
+                                    0,
+                                    Command,
+                                    0);
+
+    if (Status != 0) {
+        goto ChangeRouteEnd;
+    }
+
+    Status = NlAppendAttribute(Message,
+                               NETLINK_ROUTE_ATTRIBUTE_DESTINATION,
+                               &(Context->RouteDestination),
+                               sizeof(NETWORK_ADDRESS));
+
+    if (Status != 0) {
+        goto ChangeRouteEnd;
+    }
+
+    Status = NlAppendAttribute(Message,
+                               NETLINK_ROUTE_ATTRIBUTE_PREFIX_LENGTH,
+                               &(Context->RoutePrefixLength),
+                               sizeof(ULONG));
+
+    if (Status != 0) {
+        goto ChangeRouteEnd;
+    }
+
+    if ((Context->Flags & NETCON_FLAG_DEVICE_ID) != 0) {
+        Status = NlAppendAttribute(Message,
+                                   NETLINK_ROUTE_ATTRIBUTE_DEVICE_ID,
+                                   &(Context->DeviceId),
+                                   sizeof(DEVICE_ID));
+
+        if (Status != 0) {
+            goto ChangeRouteEnd;
+        }
+    }
+
+    if ((Context->Flags & NETCON_FLAG_GATEWAY) != 0) {
+        Status = NlAppendAttribute(Message,
+                                   NETLINK_ROUTE_ATTRIBUTE_GATEWAY,
+                                   &(Context->RouteGateway),
+                                   sizeof(NETWORK_ADDRESS));
+
+        if (Status != 0) {
+            goto ChangeRouteEnd;
+        }
+    }
+
+    if ((Context->Flags & NETCON_FLAG_METRIC) != 0) {
+        Status = NlAppendAttribute(Message,
+                                   NETLINK_ROUTE_ATTRIBUTE_METRIC,
+                                   &(Context->RouteMetric),
+                                   sizeof(ULONG));
+
+        if (Status != 0) {
+            goto ChangeRouteEnd;
+        }
+    }
+
+    Status = NlSendMessage(Socket, Message, NETLINK_KERNEL_PORT_ID, 0, NULL);
+    if (Status != 0) {
+        goto ChangeRouteEnd;
+    }
+
+    //
+    // Wait for the acknowledgement, which carries the result.
+    //
+
+    memset(&Parameters, 0, sizeof(NL_RECEIVE_PARAMETERS));
+    Parameters.Flags |= NL_RECEIVE_FLAG_PORT_ID;
+    Parameters.PortId = NETLINK_KERNEL_PORT_ID;
+    Status = NlReceiveMessage(Socket, &Parameters);
+    if (Status != 0) {
+        goto ChangeRouteEnd;
+    }
+
+ChangeRouteEnd:
+    if (Message != NULL) {
+        NlFreeBuffer(Message);
+    }
+
+    if (Socket != NULL) {
+        NlDestroySocket(Socket);
+    }
+
+    if (Status != 0) {
+        if (Command == NETLINK_ROUTE_COMMAND_ADD) {
+            perror("netcon: failed to add route");
+
+        } else {
+            perror("netcon: failed to delete route");
+        }
+    }
+
+    return;
+}
+
+INT
+NetconParseRouteAddress (
+    PSTR String,
+    PNETWORK_ADDRESS Address,
+    PULONG PrefixLength
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses an IPv4 or IPv6 address, optionally followed by a
+    slash and a prefix length.
+
+Arguments:
+
+    String - Supplies a pointer to the string to parse. This may be modified.
+
+    Address - Supplies a pointer where the address will be returned.
+
+    PrefixLength - Supplies an optional pointer where the prefix length will
+        be returned. If the string has no prefix length, the full length of
+        the address is returned. If this is NULL, a prefix length is not
+        allowed.
+
+Return Value:
+
+    0 on success.
+
+    EINVAL if the string could not be parsed.
+
+--*/
+
+{
+
+    PSTR AfterScan;
+    ULONG MaxPrefix;
+    struct sockaddr_in Ip4Address;
+    struct sockaddr_in6 Ip6Address;
+    PSTR Slash;
+    KSTATUS Status;
+
+    Slash = strchr(String, '/');
+    if (Slash != NULL) {
+        if (PrefixLength == NULL) {
+            return EINVAL;
+        }
+
+        *Slash = '\0';
+    }
+
+    memset(&Ip4Address, 0, sizeof(struct sockaddr_in));
+    memset(&Ip6Address, 0, sizeof(struct sockaddr_in6));
+    if (inet_pton(AF_INET, String, &(Ip4Address.sin_addr)) == 1) {
+        Ip4Address.sin_family = AF_INET;
+        MaxPrefix = 32;
+        Status = ClConvertToNetworkAddress((struct sockaddr *)&Ip4Address,
+                                           sizeof(struct sockaddr_in),
+                                           Address,
+                                           NULL,
+                                           NULL);
+
+    } else if (inet_pton(AF_INET6, String, &(Ip6Address.sin6_addr)) == 1) {
+        Ip6Address.sin6_family = AF_INET6;
+        MaxPrefix = 128;
+        Status = ClConvertToNetworkAddress((struct sockaddr *)&Ip6Address,
+                                           sizeof(struct sockaddr_in6),
+                                           Address,
+                                           NULL,
+                                           NULL);
+
+    } else {
+        return EINVAL;
+    }
+
+    if (!KSUCCESS(Status)) {
+        return EINVAL;
+    }
+
+    if (PrefixLength != NULL) {
+        *PrefixLength = MaxPrefix;
+        if (Slash != NULL) {
+            *PrefixLength = strtoul(Slash + 1, &AfterScan, 10);
+            if ((AfterScan == Slash + 1) || (*AfterScan != '\0') ||
+                (*PrefixLength > MaxPrefix)) {
+
+                return EINVAL;
+            }
+        }
+    }
+
+    return 0;
+}
+
+PSTR
+NetconFormatAddress (
+    PNETWORK_ADDRESS Address,
+    PSTR Buffer,
+    UINTN BufferSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints an IPv4 or IPv6 address into the given buffer.
+
+Arguments:
+
+    Address - Supplies a pointer to the network address to format.
+
+    Buffer - Supplies a pointer to the buffer where the string will be
+        written.
+
+    BufferSize - Supplies the size of the buffer in bytes.
+
+Return Value:
+
+    Returns the buffer, which contains "?" if the address could not be
+    formatted.
+
+--*/
+
+{
+
+    socklen_t AddressLength;
+    struct sockaddr_in Ip4Address;
+    struct sockaddr_in6 Ip6Address;
+    PCSTR Result;
+    KSTATUS Status;
+
+    Result = NULL;
+    switch (Address->Domain) {
+    case NetDomainIp4:
+        AddressLength = sizeof(struct sockaddr_in);
+        Status = ClConvertFromNetworkAddress(Address,
+                                             (struct sockaddr *)&Ip4Address,
+                                             &AddressLength,
+                                             NULL,
+                                             0);
+
+        if (KSUCCESS(Status)) {
+            Result = inet_ntop(AF_INET,
+                               &(Ip4Address.sin_addr),
+                               Buffer,
+                               BufferSize);
+        }
+
+        break;
+
+    case NetDomainIp6:
+        AddressLength = sizeof(struct sockaddr_in6);
+        Status = ClConvertFromNetworkAddress(Address,
+                                             (struct sockaddr *)&Ip6Address,
+                                             &AddressLength,
+                                             NULL,
+                                             0);
+
+        if (KSUCCESS(Status)) {
+            Result = inet_ntop(AF_INET6,
+                               &(Ip6Address.sin6_addr),
+                               Buffer,
+                               BufferSize);
+        }
+
+        break;
+
+    default:
+        break;
+    }
+
+    if (Result == NULL) {
+        snprintf(Buffer, BufferSize, "?");
+    }
+
+    return Buffer;
+}
+
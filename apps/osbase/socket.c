@@ -435,6 +435,56 @@ Return Value:
     return OsSystemCall(SystemCallSocketPerformVectoredIo, &Request);
 }
 
+OS_API
+KSTATUS
+OsSocketPerformBatchIo (
+    HANDLE Socket,
+    ULONG IoFlags,
+    PSOCKET_IO_MESSAGE Messages,
+    PUINTN MessageCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sends or receives several messages on a socket in a single
+    system call.
+
+Arguments:
+
+    Socket - Supplies the socket handle.
+
+    IoFlags - Supplies the I/O flags for the batch. Set SYS_IO_FLAG_WRITE to
+        send the messages, or leave it clear to receive them.
+
+    Messages - Supplies an array of messages to send or receive. The
+        parameters for each completed message are updated on return.
+
+    MessageCount - Supplies a pointer that on input contains the number of
+        messages in the array. On output, returns the number of messages that
+        were completed.
+
+Return Value:
+
+    Status code. If any messages were completed, success is returned.
+
+--*/
+
+{
+
+    SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO Request;
+    KSTATUS Status;
+
+    Request.Socket = Socket;
+    Request.IoFlags = IoFlags;
+    Request.Messages = Messages;
+    Request.MessageCount = *MessageCount;
+    Status = OsSystemCall(SystemCallSocketPerformBatchIo, &Request);
+    *MessageCount = Request.MessageCount;
+    return Status;
+}
+
 OS_API
 KSTATUS
 OsSocketGetSetInformation (
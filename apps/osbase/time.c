@@ -65,6 +65,11 @@ OspGetTimeOffset (
     PSYSTEM_TIME TimeOffset
     );
 
+ULONGLONG
+OspReadTimeCounter (
+    VOID
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -143,6 +148,17 @@ Return Value:
 {
 
     SYSTEM_CALL_QUERY_TIME_COUNTER Parameters;
+    PUSER_SHARED_DATA UserSharedData;
+
+    //
+    // If the kernel says the counter hardware can be read directly, skip the
+    // system call.
+    //
+
+    UserSharedData = OspGetUserSharedData();
+    if ((UserSharedData->TimeCounterFlags & USER_TIME_COUNTER_READABLE) != 0) {
+        return OspReadTimeCounter() + UserSharedData->TimeCounterOffset;
+    }
 
     OsSystemCall(SystemCallQueryTimeCounter, &Parameters);
     return Parameters.Value;
@@ -43,6 +43,7 @@ function build() {
         "cmd/config.ck",
         "cmd/convert_archive.ck",
         "cmd/del_realm.ck",
+        "cmd/extract_package.ck",
         "cmd/install.ck",
         "cmd/list_realms.ck",
         "cmd/new_realm.ck",
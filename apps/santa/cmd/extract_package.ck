@@ -0,0 +1,143 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    extract_package.ck
+
+Abstract:
+
+    This module implements the extract-package command, which decompresses
+    and unpacks package files into their control directories. The package
+    manager runs several of these at once to extract packages in parallel.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Chalk
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+from getopt import gnuGetopt;
+from santa.config import config;
+from santa.file import mkdir;
+from santa.lib.pkg import Package;
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+var description = "Extract a package file into its control directory";
+
+var shortOptions = "hv";
+var longOptions = [
+    "help",
+    "verbose"
+];
+
+var usage =
+    "usage: santa extract-package [options] control_dir package_file...\n"
+    "This command extracts each package file into the control directory\n"
+    "preceding it without installing it. Options are:\n"
+    "  -v, --verbose -- Print out more information about what's going on.\n"
+    "  -h, --help -- Print this help text.\n";
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+function
+command (
+    args
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the extract-package command.
+
+Arguments:
+
+    args - Supplies the arguments to the function.
+
+Return Value:
+
+    Returns an exit code.
+
+--*/
+
+{
+
+    var controlDirectory;
+    var count;
+    var name;
+    var options = gnuGetopt(args[1...-1], shortOptions, longOptions);
+    var package;
+    var value;
+
+    args = options[1];
+    options = options[0];
+    for (option in options) {
+        name = option[0];
+        value = option[1];
+        if ((name == "-h") || (name == "--help")) {
+            Core.print(usage);
+            return 1;
+
+        } else if ((name == "-v") || (name == "--verbose")) {
+            config.setKey("core.verbose", true);
+
+        } else {
+            Core.raise(ValueError("Invalid option '%s'" % name));
+        }
+    }
+
+    count = args.length();
+    if ((count == 0) || ((count % 2) != 0)) {
+        Core.raise(ValueError("Expected control directory and package pairs"));
+    }
+
+    for (index in 0..(count / 2)) {
+        controlDirectory = args[index * 2];
+        mkdir(controlDirectory);
+        package = Package.fromArchive(controlDirectory, args[index * 2 + 1]);
+        package.extract();
+    }
+
+    return 0;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
@@ -56,10 +56,11 @@ from santa.lib.pkgman import PackageManager;
 
 var description = "Install new packages on the system";
 
-var shortOptions = "c:hr:v";
+var shortOptions = "c:hj:r:v";
 var longOptions = [
     "cross=",
     "help",
+    "jobs=",
     "root=",
     "verbose"
 ];
@@ -69,6 +70,7 @@ var usage =
     "This command VERBs packages. Options are:\n"
     "  -c, --cross=[arch-]os -- VERB an alternate arch/os (eg \"Minoca\" or "
     "\"x86_64-Minoca\"\n"
+    "  -j, --jobs=count -- Extract up to count packages in parallel\n"
     "  -r, --root=dir -- VERB packages at the specified directory\n"
     "  -v, --verbose -- Print out more information about what's going on.\n"
     "  -h, --help -- Print this help text.\n";
@@ -130,6 +132,9 @@ Return Value:
             Core.print(usage.replace("VERB", verb, -1));
             return 1;
 
+        } else if ((name == "-j") || (name == "--jobs")) {
+            config.setKey("core.jobs", Int.fromString(value));
+
         } else if ((name == "-r") || (name == "--root")) {
             parameters.root = value;
 
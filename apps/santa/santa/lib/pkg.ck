@@ -228,6 +228,36 @@ class Package {
         return;
     }
 
+    function
+    extract (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine extracts the package contents into its control directory
+        and saves the updated status, without installing anything. This is
+        safe to run concurrently for different packages, and lets a later
+        install skip the extraction step.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        None. An exception is raised on error.
+
+    --*/
+
+    {
+
+        this._extract();
+        this.save();
+        return;
+    }
+
     function
     install (
         realm,
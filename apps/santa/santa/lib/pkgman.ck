@@ -30,8 +30,13 @@ Module Name:
 // ------------------------------------------------------------------- Includes
 //
 
+import _time;
+from app import argv, execName;
 import io;
+from iobase import IoError;
+from json import dumps, loads;
 import os;
+from spawn import ChildProcess;
 from santa.config import config;
 from santa.file import path, mkdir;
 from santa.lib.config import ConfigFile;
@@ -48,6 +53,13 @@ from santa.lib.santaconfig import SANTA_PACKAGE_STATE_PATH, SANTA_STORAGE_PATH;
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define how many more journal entries than installed packages are allowed
+// to build up before the journal is folded back into the state file.
+//
+
+var PACKAGE_JOURNAL_SLACK = 64;
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -56,6 +68,15 @@ from santa.lib.santaconfig import SANTA_PACKAGE_STATE_PATH, SANTA_STORAGE_PATH;
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+function
+_packageKey (
+    package
+    );
+
+function
+_now (
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -76,9 +97,12 @@ class PackageVersionConflict is Exception {}
 class PackageManager {
     var _realm;
     var _state;
+    var _journalPath;
+    var _journalCount;
     var _addPlan;
     var _removePlan;
     var _nextReferenceCount;
+    var _dirty;
 
     function
     __init (
@@ -118,10 +142,13 @@ class PackageManager {
 
         mkdir((os.dirname)(statePath));
         _state = ConfigFile(statePath, defaultPackageManagerState);
+        _journalPath = statePath + ".log";
+        this._replayJournal();
         this.db = PackageDatabase();
         _addPlan = [];
         _removePlan = [];
         _nextReferenceCount = {};
+        _dirty = {};
         return this;
     }
 
@@ -296,6 +323,7 @@ class PackageManager {
 
         if (package.userCount > 0) {
             package.userCount -= 1;
+            _dirty[package] = true;
 
         } else {
             if (verbose) {
@@ -385,19 +413,19 @@ class PackageManager {
     Routine Description:
 
         This routine commits the current plan to action, executing the
-        specified removals and then additions.
+        specified removals and then additions. Packages being added are
+        extracted by child processes in parallel, while the installation
+        itself proceeds in plan order. Each completed step is recorded in the
+        state journal, so an interrupted commit keeps the state of what was
+        actually done.
 
     Arguments:
 
-        name - Supplies either the name of the package to get.
-
-        parameters - Supplies optional additional parameters about the package
-            to install.
+        None.
 
     Return Value:
 
-        Returns a package dictionary, or raises an exception if the package
-        was not found or included multiple results.
+        None. An exception is raised on error.
 
     --*/
 
@@ -405,11 +433,18 @@ class PackageManager {
 
         var controlDirectory;
         var end = _removePlan.length() - 1;
+        var extractTime = 0;
         var installedPackages = _state.pkgs;
+        var installTime = 0;
+        var jobs = config.getKey("core.jobs");
         var package;
         var packageInfo;
         var packagePath;
+        var removeTime;
         var root;
+        var saveTime;
+        var start = _now();
+        var verbose = config.getKey("core.verbose");
 
         //
         // Process removals backwards.
@@ -428,6 +463,8 @@ class PackageManager {
                     }
                 }
 
+                this._journal("remove", _packageKey(packageInfo));
+
                 //
                 // Consider an option to keep extracted packages around. There
                 // would need to be something at the other end that reconciled
@@ -438,12 +475,28 @@ class PackageManager {
             }
         }
 
+        removeTime = _now() - start;
+
         //
-        // Process addition forwards.
+        // Extract the packages being added in parallel. Extracting only
+        // touches the package's own control directory, so packages can be
+        // extracted in any order. Installing runs scripts and presents files
+        // into the realm, so it then proceeds forwards in plan order.
         //
 
+        start = _now();
+        if ((jobs == null) || (jobs <= 0)) {
+            jobs = (os.nproc)();
+        }
+
         end = _addPlan.length();
+        if ((jobs > 1) && (end > 1)) {
+            this._extractPackages(jobs);
+        }
+
+        extractTime = _now() - start;
         for (index in 0..end) {
+            start = _now();
             packageInfo = _addPlan[index];
             controlDirectory = this._packagePath(packageInfo);
             packagePath = "/".join([packageInfo.repository, packageInfo.file]);
@@ -458,23 +511,49 @@ class PackageManager {
             package.install(_realm, root);
             package.save();
             installedPackages.append(packageInfo);
+            this._journal("set", packageInfo);
+            installTime += _now() - start;
         }
 
         //
         // Set the reference counts where they should be.
         //
 
+        start = _now();
         for (key in _nextReferenceCount) {
             key.referenceCount = _nextReferenceCount[key];
+            _dirty[key] = true;
         }
 
         _nextReferenceCount = {};
 
         //
-        // Save the config, which makes it official.
+        // Record the updated counts of packages that remain installed, which
+        // makes it official.
         //
 
+        for (key in _dirty) {
+            if (installedPackages.contains(key)) {
+                this._journal("set", key);
+            }
+        }
+
+        _dirty = {};
         this._save();
+        saveTime = _now() - start;
+        if (verbose) {
+            Core.print("Removed %d packages in %dms" %
+                       [_removePlan.length(), removeTime / 1000000]);
+
+            Core.print("Extracted %d packages with %d jobs in %dms" %
+                       [end, jobs, extractTime / 1000000]);
+
+            Core.print("Installed %d packages in %dms" %
+                       [end, installTime / 1000000]);
+
+            Core.print("Saved package state in %dms" % (saveTime / 1000000));
+        }
+
         return;
     }
 
@@ -674,7 +753,10 @@ class PackageManager {
 
     Routine Description:
 
-        This routine saves the package manager state.
+        This routine saves the package manager state. Changes are normally
+        already recorded in the journal, so the full state file is only
+        rewritten once the journal has grown well past the number of
+        installed packages.
 
     Arguments:
 
@@ -688,7 +770,247 @@ class PackageManager {
 
     {
 
+        if (_journalCount <= _state.pkgs.length() + PACKAGE_JOURNAL_SLACK) {
+            return;
+        }
+
+        //
+        // Write the complete state first. If the journal removal doesn't
+        // happen, replaying it over the new state is harmless.
+        //
+
         _state.save();
+        try {
+            (os.unlink)(_journalPath);
+
+        } except os.OsError as e {
+            if (e.errno != os.ENOENT) {
+                Core.raise(e);
+            }
+        }
+
+        _journalCount = 0;
+        return;
+    }
+
+    function
+    _journal (
+        action,
+        value
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine appends an entry to the package state journal.
+
+    Arguments:
+
+        action - Supplies the journal action: "set" to add or replace an
+            installed package record, or "remove" to delete one.
+
+        value - Supplies the package record for a set, or the package key
+            for a removal.
+
+    Return Value:
+
+        None. An exception is raised on error.
+
+    --*/
+
+    {
+
+        var file = (io.open)(_journalPath, "ab");
+
+        file.write(dumps({action: value}, 0) + "\n");
+        file.close();
+        _journalCount += 1;
+        return;
+    }
+
+    function
+    _replayJournal (
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine applies the entries of the package state journal on top
+        of the state loaded from the state file.
+
+    Arguments:
+
+        None.
+
+    Return Value:
+
+        None. An exception is raised on error.
+
+    --*/
+
+    {
+
+        var data;
+        var entry;
+        var file;
+        var key;
+        var order = [];
+        var packages = {};
+        var result = [];
+
+        _journalCount = 0;
+        try {
+            file = (io.open)(_journalPath, "rb");
+            data = file.readall();
+            file.close();
+
+        } except IoError as e {
+            if (e.errno == os.ENOENT) {
+                return;
+            }
+
+            Core.raise(e);
+        }
+
+        //
+        // Index the installed packages by key, remembering the original order
+        // so that updated records stay where they were.
+        //
+
+        for (package in _state.pkgs) {
+            key = _packageKey(package);
+            packages[key] = package;
+            order.append(key);
+        }
+
+        for (line in data.split("\n", -1)) {
+            if (line.length() == 0) {
+                continue;
+            }
+
+            //
+            // A torn final line from an interrupted write is ignored.
+            //
+
+            try {
+                entry = loads(line);
+
+            } except Exception {
+                break;
+            }
+
+            _journalCount += 1;
+            if (entry.get("set") != null) {
+                key = _packageKey(entry.set);
+                if (packages.get(key) == null) {
+                    order.append(key);
+                }
+
+                packages[key] = entry.set;
+
+            } else if (entry.get("remove") != null) {
+                packages.remove(entry.remove);
+            }
+        }
+
+        //
+        // Rebuild the list in order, emitting each remaining package once.
+        //
+
+        for (key in order) {
+            entry = packages.get(key);
+            if (entry != null) {
+                result.append(entry);
+                packages.remove(key);
+            }
+        }
+
+        _state.pkgs = result;
+        return;
+    }
+
+    function
+    _extractPackages (
+        jobs
+        )
+
+    /*++
+
+    Routine Description:
+
+        This routine extracts every package in the add plan using child santa
+        processes, at most the given number at a time. Packages are dealt out
+        to the children round robin, so each child pays its startup cost once.
+        A package that fails to extract here is extracted again by the install
+        itself, which reports the error.
+
+    Arguments:
+
+        jobs - Supplies the maximum number of child processes to run.
+
+    Return Value:
+
+        None.
+
+    --*/
+
+    {
+
+        var base = [execName];
+        var child;
+        var children = [];
+        var commands = [];
+        var package;
+        var packagePath;
+        var status;
+        var verbose = config.getKey("core.verbose");
+
+        //
+        // When santa runs as a script rather than a bundled executable, the
+        // interpreter needs the script path as well. The paths passed are
+        // already complete, so the child is not given the root.
+        //
+
+        if ((os.basename)(execName) != (os.basename)(argv[0])) {
+            base.append(argv[0]);
+        }
+
+        base.append("extract-package");
+        if (verbose) {
+            base.append("--verbose");
+        }
+
+        if (jobs > _addPlan.length()) {
+            jobs = _addPlan.length();
+        }
+
+        for (index in 0..jobs) {
+            commands.append(base);
+        }
+
+        for (index in 0.._addPlan.length()) {
+            package = _addPlan[index];
+            packagePath = "/".join([package.repository, package.file]);
+            commands[index % jobs] += [this._packagePath(package),
+                                       path(packagePath)];
+        }
+
+        for (command in commands) {
+            child = ChildProcess(command);
+            child.launch();
+            children.append(child);
+        }
+
+        for (child in children) {
+            status = child.wait(-1);
+            if ((status != 0) && (verbose)) {
+                Core.print("Package extraction exited with status %d" %
+                           status);
+            }
+        }
+
         return;
     }
 
@@ -937,6 +1259,7 @@ class PackageManager {
         }
 
         package.referenceCount -= 1;
+        _dirty[package] = true;
         if ((package.referenceCount != 0) || (userCount)) {
             if (verbose) {
                 if (userCount == null) {
@@ -1226,3 +1549,70 @@ class PackageManager {
 // --------------------------------------------------------- Internal Functions
 //
 
+function
+_packageKey (
+    package
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the string that identifies an installed package
+    record in the state journal.
+
+Arguments:
+
+    package - Supplies the package information dictionary.
+
+Return Value:
+
+    Returns the key string.
+
+--*/
+
+{
+
+    var root = package.get("root");
+
+    if (root == null) {
+        root = "";
+    }
+
+    return "%s-%s/%s-%sr%d:%s" %
+           [package.os,
+            package.arch,
+            package.name,
+            package.version,
+            package.release,
+            root];
+}
+
+function
+_now (
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the current monotonic time, for reporting how long
+    each phase of a commit takes.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current time in nanoseconds.
+
+--*/
+
+{
+
+    var value = (_time.clock_gettime)(_time.CLOCK_MONOTONIC);
+
+    return (value[0] * 1000000000) + value[1];
+}
+
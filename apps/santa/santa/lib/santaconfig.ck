@@ -131,6 +131,13 @@ var defaultConfig = {
 
         "verbose": false,
 
+        //
+        // Define the number of packages to extract in parallel during an
+        // install. Zero uses the number of processors.
+        //
+
+        "jobs": 0,
+
         //
         // Define the directory where global state is stored.
         //
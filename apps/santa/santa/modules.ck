@@ -67,6 +67,7 @@ var builtinCommands = [
     ["config", "Get or set configuration parameters"],
     ["convert-archive", "Converts from an alternate archive (eg .tar.gz)"],
     ["del-realm", "Destroy and delete a realm"],
+    ["extract-package", "Extract a package file without installing it"],
     ["new-realm", "Create a new working environment"],
     ["patch", "Build-time patch management support"],
     ["install", "Install new packages onto the system"],
@@ -164,6 +164,7 @@ function build() {
     minocaSources = [
         "cmds.c",
         "dw.c",
+        "netstat.c",
         "swlib/minocaos.c"
     ];
 
@@ -183,7 +184,8 @@ function build() {
 
     targetLibs = [
         "lib/termlib:termlib",
-        "apps/osbase:libminocaos"
+        "apps/osbase:libminocaos",
+        "apps/netlink:libnetlink"
     ];
 
     buildLibs = [
@@ -212,7 +214,7 @@ function build() {
     buildSourcesConfig = sourcesConfig.copy();
     if (buildOs == "Minoca") {
         buildSources = targetSources;
-        buildConfig["DYNLIBS"] += ["-lminocaos"];
+        buildConfig["DYNLIBS"] += ["-lminocaos", "-lnetlink"];
 
     } else if (buildOs == "Windows") {
         buildSources = baseSources + win32Sources;
@@ -146,6 +146,7 @@ SWISS_COMMAND_ENTRY SwissCommands[] = {
      HostnameMain,
      0},
 
+    {NETSTAT_COMMAND_NAME, NETSTAT_COMMAND_DESCRIPTION, NetstatMain, 0},
     {NULL, NULL, NULL, 0},
 };
 
@@ -0,0 +1,566 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    netstat.c
+
+Abstract:
+
+    This module implements the netstat utility, which prints the network
+    protocol and link statistics kept by the kernel.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/lib/minocaos.h>
+#include <minoca/net/netdrv.h>
+#include <minoca/net/netlink.h>
+#include <minoca/lib/mlibc.h>
+#include <minoca/lib/netlink.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "swlib.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define NETSTAT_VERSION_MAJOR 1
+#define NETSTAT_VERSION_MINOR 0
+
+#define NETSTAT_USAGE                                                          \
+    "usage: netstat -s\n\n"                                                    \
+    "The netstat utility prints network statistics. Options are:\n"           \
+    "  -s, --statistics -- Print the per-protocol and per-link counters.\n"    \
+    "  --help -- Show this help text and exit.\n"                              \
+    "  --version -- Print the application version information and exit.\n"
+
+#define NETSTAT_OPTIONS_STRING "shV"
+
+#define NETSTAT_OPTION_STATISTICS 0x00000001
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure describes how to print a statistics counter.
+
+Members:
+
+    Group - Stores the name of the group the counter belongs to. A group
+        heading is printed whenever this changes.
+
+    Description - Stores the text printed after the counter value.
+
+--*/
+
+typedef struct _NETSTAT_COUNTER {
+    PSTR Group;
+    PSTR Description;
+} NETSTAT_COUNTER, *PNETSTAT_COUNTER;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+INT
+NetstatPrintStatistics (
+    VOID
+    );
+
+VOID
+NetstatParseStatistics (
+    PNL_SOCKET Socket,
+    PNL_RECEIVE_CONTEXT Context,
+    PVOID Message
+    );
+
+VOID
+NetstatPrintCounters (
+    PNETSTAT_COUNTER Counters,
+    ULONG CounterCount,
+    PULONGLONG Values,
+    ULONG ValueCount
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+struct option NetstatLongOptions[] = {
+    {"statistics", no_argument, 0, 's'},
+    {"help", no_argument, 0, 'h'},
+    {"version", no_argument, 0, 'V'},
+    {NULL, 0, 0, 0},
+};
+
+//
+// Define the descriptions of the global counters, indexed by NET_STATISTIC.
+//
+
+NETSTAT_COUNTER NetstatGlobalCounters[NetStatisticCount] = {
+    {"Ip", "total packets received"},
+    {"Ip", "packets with invalid headers"},
+    {"Ip", "packets with unknown protocols"},
+    {"Ip", "packets delivered"},
+    {"Ip", "requests sent out"},
+    {"Ip", "fragments received"},
+    {"Ip", "packets reassembled"},
+    {"Ip", "fragments dropped during reassembly"},
+    {"Ip", "packets fragmented"},
+    {"Ip", "fragments created"},
+    {"Ip6", "total packets received"},
+    {"Ip6", "packets with invalid headers"},
+    {"Ip6", "packets with unknown protocols"},
+    {"Ip6", "packets delivered"},
+    {"Ip6", "requests sent out"},
+    {"Tcp", "active connection openings"},
+    {"Tcp", "passive connection openings"},
+    {"Tcp", "failed connection attempts"},
+    {"Tcp", "connection resets received"},
+    {"Tcp", "segments received"},
+    {"Tcp", "segments sent out"},
+    {"Tcp", "segments retransmitted"},
+    {"Tcp", "segments received out of order"},
+    {"Tcp", "bad segments received"},
+    {"Tcp", "segments with bad checksums"},
+    {"Tcp", "resets sent"},
+    {"Udp", "packets received"},
+    {"Udp", "packets to unknown ports received"},
+    {"Udp", "packet receive errors"},
+    {"Udp", "packets with bad checksums"},
+    {"Udp", "packets dropped for full receive buffers"},
+    {"Udp", "packets sent"},
+    {"Arp", "requests received"},
+    {"Arp", "replies received"},
+    {"Arp", "requests sent"},
+    {"Arp", "replies sent"},
+    {"Ndp", "neighbor solicitations received"},
+    {"Ndp", "neighbor advertisements received"},
+    {"Ndp", "neighbor solicitations sent"},
+    {"Ndp", "neighbor advertisements sent"},
+};
+
+//
+// Define the descriptions of the link counters, indexed by
+// NET_LINK_STATISTIC.
+//
+
+NETSTAT_COUNTER NetstatLinkCounters[NetLinkStatisticCount] = {
+    {NULL, "packets received"},
+    {NULL, "bytes received"},
+    {NULL, "received packets dropped"},
+    {NULL, "packets sent"},
+    {NULL, "bytes sent"},
+    {NULL, "transmit errors"},
+    {NULL, "packets dropped on transmit"},
+};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INT
+NetstatMain (
+    INT ArgumentCount,
+    CHAR **Arguments
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is the main entry point for the netstat utility.
+
+Arguments:
+
+    ArgumentCount - Supplies the number of command line arguments the program
+        was invoked with.
+
+    Arguments - Supplies a tokenized array of command line arguments.
+
+Return Value:
+
+    Returns an integer exit code. 0 for success, nonzero otherwise.
+
+--*/
+
+{
+
+    ULONG ArgumentIndex;
+    INT Option;
+    ULONG Options;
+    int Status;
+
+    Options = 0;
+
+    //
+    // Process the control arguments.
+    //
+
+    while (TRUE) {
+        Option = getopt_long(ArgumentCount,
+                             Arguments,
+                             NETSTAT_OPTIONS_STRING,
+                             NetstatLongOptions,
+                             NULL);
+
+        if (Option == -1) {
+            break;
+        }
+
+        if ((Option == '?') || (Option == ':')) {
+            Status = 1;
+            goto MainEnd;
+        }
+
+        switch (Option) {
+        case 's':
+            Options |= NETSTAT_OPTION_STATISTICS;
+            break;
+
+        case 'V':
+            SwPrintVersion(NETSTAT_VERSION_MAJOR, NETSTAT_VERSION_MINOR);
+            return 1;
+
+        case 'h':
+            printf(NETSTAT_USAGE);
+            return 1;
+
+        default:
+
+            assert(FALSE);
+
+            Status = 1;
+            goto MainEnd;
+        }
+    }
+
+    ArgumentIndex = optind;
+    if (ArgumentIndex != ArgumentCount) {
+        SwPrintError(0, Arguments[ArgumentIndex], "Unexpected operand");
+        Status = 1;
+        goto MainEnd;
+    }
+
+    //
+    // Listing sockets is not supported, so statistics are all there is.
+    //
+
+    if ((Options & NETSTAT_OPTION_STATISTICS) == 0) {
+        SwPrintError(0, NULL, "Only -s is currently supported");
+        Status = 1;
+        goto MainEnd;
+    }
+
+    Status = NetstatPrintStatistics();
+    if (Status != 0) {
+        SwPrintError(Status, NULL, "Failed to get network statistics");
+        Status = 1;
+        goto MainEnd;
+    }
+
+    Status = 0;
+
+MainEnd:
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+INT
+NetstatPrintStatistics (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine requests the network statistics from the kernel and prints
+    them as they arrive.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    USHORT FamilyId;
+    PNL_MESSAGE_BUFFER Message;
+    ULONG MessageLength;
+    NL_RECEIVE_PARAMETERS Parameters;
+    PNL_SOCKET Socket;
+    INT Status;
+
+    Message = NULL;
+    Socket = NULL;
+    Status = NlCreateSocket(NETLINK_GENERIC, NL_ANY_PORT_ID, 0, &Socket);
+    if (Status != 0) {
+        Status = errno;
+        goto PrintStatisticsEnd;
+    }
+
+    Status = NlGenericGetFamilyId(Socket,
+                                  NETLINK_GENERIC_STATISTICS_NAME,
+                                  &FamilyId);
+
+    if (Status != 0) {
+        Status = errno;
+        goto PrintStatisticsEnd;
+    }
+
+    MessageLength = NETLINK_GENERIC_HEADER_LENGTH;
+    Status = NlAllocateBuffer(MessageLength, &Message);
+    if (Status != 0) {
+        Status = errno;
+        goto PrintStatisticsEnd;
+    }
+
+    Status = NlGenericAppendHeaders(Socket,
+                                    Message,
+                                    0,
+                                    0,
+                                    FamilyId,
+                                    NETLINK_HEADER_FLAG_DUMP,
+                                    NETLINK_STATISTICS_COMMAND_GET,
+                                    0);
+
+    if (Status != 0) {
+        Status = errno;
+        goto PrintStatisticsEnd;
+    }
+
+    Status = NlSendMessage(Socket, Message, NETLINK_KERNEL_PORT_ID, 0, NULL);
+    if (Status != 0) {
+        Status = errno;
+        goto PrintStatisticsEnd;
+    }
+
+    //
+    // The global counters come first, followed by a message for each link.
+    // The receive returns once the whole dump has arrived.
+    //
+
+    memset(&Parameters, 0, sizeof(NL_RECEIVE_PARAMETERS));
+    Parameters.ReceiveRoutine = NetstatParseStatistics;
+    Parameters.ReceiveContext.Type = FamilyId;
+    Parameters.Flags = NL_RECEIVE_FLAG_PORT_ID;
+    Parameters.PortId = NETLINK_KERNEL_PORT_ID;
+    Status = NlReceiveMessage(Socket, &Parameters);
+    if (Status != 0) {
+        Status = errno;
+        goto PrintStatisticsEnd;
+    }
+
+    Status = Parameters.ReceiveContext.Status;
+
+PrintStatisticsEnd:
+    if (Message != NULL) {
+        NlFreeBuffer(Message);
+    }
+
+    if (Socket != NULL) {
+        NlDestroySocket(Socket);
+    }
+
+    return Status;
+}
+
+VOID
+NetstatParseStatistics (
+    PNL_SOCKET Socket,
+    PNL_RECEIVE_CONTEXT Context,
+    PVOID Message
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses and prints a statistics message.
+
+Arguments:
+
+    Socket - Supplies a pointer to the netlink socket that received the message.
+
+    Context - Supplies a pointer to the receive context given to the receive
+        message handler.
+
+    Message - Supplies a pointer to the beginning of the netlink message. The
+        length of which can be obtained from the header; it was already
+        validated.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    USHORT AttributeLength;
+    PVOID Attributes;
+    PDEVICE_ID DeviceId;
+    PNETLINK_GENERIC_HEADER GenericHeader;
+    PNETLINK_HEADER Header;
+    ULONG MessageLength;
+    INT Status;
+    PULONGLONG Values;
+
+    Header = (PNETLINK_HEADER)Message;
+    if (Header->Type != Context->Type) {
+        return;
+    }
+
+    MessageLength = Header->Length;
+    MessageLength -= NETLINK_HEADER_LENGTH;
+    if (MessageLength < sizeof(NETLINK_GENERIC_HEADER)) {
+        return;
+    }
+
+    GenericHeader = NETLINK_DATA(Header);
+    if (GenericHeader->Command != NETLINK_STATISTICS_COMMAND_GET) {
+        return;
+    }
+
+    MessageLength -= NETLINK_GENERIC_HEADER_LENGTH;
+    Attributes = NETLINK_GENERIC_DATA(GenericHeader);
+    Status = NlGetAttribute(Attributes,
+                            MessageLength,
+                            NETLINK_STATISTICS_ATTRIBUTE_GLOBAL,
+                            (PVOID *)&Values,
+                            &AttributeLength);
+
+    if (Status == 0) {
+        NetstatPrintCounters(NetstatGlobalCounters,
+                             NetStatisticCount,
+                             Values,
+                             AttributeLength / sizeof(ULONGLONG));
+
+        return;
+    }
+
+    Status = NlGetAttribute(Attributes,
+                            MessageLength,
+                            NETLINK_STATISTICS_ATTRIBUTE_DEVICE_ID,
+                            (PVOID *)&DeviceId,
+                            &AttributeLength);
+
+    if ((Status != 0) || (AttributeLength != sizeof(DEVICE_ID))) {
+        return;
+    }
+
+    Status = NlGetAttribute(Attributes,
+                            MessageLength,
+                            NETLINK_STATISTICS_ATTRIBUTE_LINK,
+                            (PVOID *)&Values,
+                            &AttributeLength);
+
+    if (Status != 0) {
+        return;
+    }
+
+    printf("Link 0x%llx:\n", *DeviceId);
+    NetstatPrintCounters(NetstatLinkCounters,
+                         NetLinkStatisticCount,
+                         Values,
+                         AttributeLength / sizeof(ULONGLONG));
+
+    return;
+}
+
+VOID
+NetstatPrintCounters (
+    PNETSTAT_COUNTER Counters,
+    ULONG CounterCount,
+    PULONGLONG Values,
+    ULONG ValueCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine prints an array of counters.
+
+Arguments:
+
+    Counters - Supplies a pointer to the array of counter descriptions.
+
+    CounterCount - Supplies the number of elements in the description array.
+
+    Values - Supplies a pointer to the counter values.
+
+    ValueCount - Supplies the number of counter values. This may differ from
+        the counter count if the kernel is older or newer than this utility.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Index;
+    PSTR PreviousGroup;
+
+    PreviousGroup = NULL;
+    for (Index = 0; Index < CounterCount; Index += 1) {
+        if (Index >= ValueCount) {
+            break;
+        }
+
+        if ((Counters[Index].Group != NULL) &&
+            ((PreviousGroup == NULL) ||
+             (strcmp(Counters[Index].Group, PreviousGroup) != 0))) {
+
+            printf("%s:\n", Counters[Index].Group);
+            PreviousGroup = Counters[Index].Group;
+        }
+
+        printf("    %llu %s\n", Values[Index], Counters[Index].Description);
+    }
+
+    return;
+}
+
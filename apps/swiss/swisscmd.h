@@ -238,6 +238,9 @@ Module Name:
 #define DNSDOMAINNAME_COMMAND_DESCRIPTION \
     "Print the DNS domain name of the machine"
 
+#define NETSTAT_COMMAND_NAME "netstat"
+#define NETSTAT_COMMAND_DESCRIPTION "Print network statistics"
+
 //
 // Command entry point prototypes.
 //
@@ -2304,3 +2307,28 @@ Return Value:
 
 --*/
 
+INT
+NetstatMain (
+    INT ArgumentCount,
+    CHAR **Arguments
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is the main entry point for the netstat utility.
+
+Arguments:
+
+    ArgumentCount - Supplies the number of command line arguments the program
+        was invoked with.
+
+    Arguments - Supplies a tokenized array of command line arguments.
+
+Return Value:
+
+    Returns an integer exit code. 0 for success, nonzero otherwise.
+
+--*/
+
@@ -32,6 +32,8 @@ Module Name:
 
 #include <assert.h>
 #include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
 #include <unistd.h>
 
 #include <minoca/lib/minocaos.h>
@@ -44,6 +46,16 @@ Module Name:
 
 #define SWISS_ALLOCATION_TAG 0x73697753 // 'siwS'
 
+//
+// Define the events that count as a change to a followed file, and the size
+// of the buffer used to drain the notifications.
+//
+
+#define SWISS_FILE_WATCH_EVENTS \
+    (IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)
+
+#define SWISS_FILE_WATCH_BUFFER_SIZE 1024
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -284,6 +296,119 @@ Return Value:
     return closefrom(Descriptor);
 }
 
+int
+SwCreateFileWatch (
+    const char *Path
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts watching a file for changes, so that a caller
+    following the file can wait for it to change rather than polling.
+
+Arguments:
+
+    Path - Supplies a pointer to the path of the file to watch.
+
+Return Value:
+
+    Returns a file descriptor for the watch on success. The caller should
+    close it when done.
+
+    -1 on failure, and errno will be set to contain more information. This
+    fails with ENOSYS on systems that cannot watch files.
+
+--*/
+
+{
+
+    int Error;
+    int Watch;
+
+    Watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (Watch < 0) {
+        return -1;
+    }
+
+    if (inotify_add_watch(Watch, Path, SWISS_FILE_WATCH_EVENTS) < 0) {
+        Error = errno;
+        close(Watch);
+        errno = Error;
+        return -1;
+    }
+
+    return Watch;
+}
+
+int
+SwWaitForFileWatch (
+    int Watch,
+    int TimeoutMilliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for a watched file to change, and consumes any change
+    notifications that have arrived.
+
+Arguments:
+
+    Watch - Supplies the watch descriptor returned when the watch was created.
+
+    TimeoutMilliseconds - Supplies the maximum number of milliseconds to wait.
+
+Return Value:
+
+    1 if the file changed.
+
+    0 if the timeout expired first.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    char Buffer[SWISS_FILE_WATCH_BUFFER_SIZE];
+    ssize_t BytesRead;
+    struct pollfd PollDescriptor;
+    int Result;
+
+    PollDescriptor.fd = Watch;
+    PollDescriptor.events = POLLIN;
+    PollDescriptor.revents = 0;
+    Result = poll(&PollDescriptor, 1, TimeoutMilliseconds);
+    if (Result <= 0) {
+        if ((Result < 0) && (errno == EINTR)) {
+            return 0;
+        }
+
+        return Result;
+    }
+
+    //
+    // Throw away everything queued. The caller only cares that something
+    // changed, not what, and several writes may have been queued.
+    //
+
+    while (TRUE) {
+        BytesRead = read(Watch, Buffer, sizeof(Buffer));
+        if (BytesRead <= 0) {
+            if ((BytesRead < 0) && (errno == EINTR)) {
+                continue;
+            }
+
+            break;
+        }
+    }
+
+    return 1;
+}
+
 int
 SwResetSystem (
     SWISS_REBOOT_TYPE RebootType
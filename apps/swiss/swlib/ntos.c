@@ -3482,6 +3482,73 @@ Return Value:
     return;
 }
 
+int
+SwCreateFileWatch (
+    const char *Path
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts watching a file for changes, so that a caller
+    following the file can wait for it to change rather than polling.
+
+Arguments:
+
+    Path - Supplies a pointer to the path of the file to watch.
+
+Return Value:
+
+    Returns a file descriptor for the watch on success. The caller should
+    close it when done.
+
+    -1 on failure, and errno will be set to contain more information. This
+    fails with ENOSYS on systems that cannot watch files.
+
+--*/
+
+{
+
+    errno = ENOSYS;
+    return -1;
+}
+
+int
+SwWaitForFileWatch (
+    int Watch,
+    int TimeoutMilliseconds
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits for a watched file to change, and consumes any change
+    notifications that have arrived.
+
+Arguments:
+
+    Watch - Supplies the watch descriptor returned when the watch was created.
+
+    TimeoutMilliseconds - Supplies the maximum number of milliseconds to wait.
+
+Return Value:
+
+    1 if the file changed.
+
+    0 if the timeout expired first.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    errno = ENOSYS;
+    return -1;
+}
+
 int
 SwResetSystem (
     SWISS_REBOOT_TYPE RebootType
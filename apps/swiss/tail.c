@@ -172,12 +172,14 @@ Return Value:
     UINTN StartIndex;
     struct stat Stat;
     int Status;
+    int Watch;
 
     Buffer = NULL;
     Input = NULL;
     Multiplier = 1;
     Offset = TAIL_DEFAULT_OFFSET;
     Options = TAIL_OPTION_FROM_END | TAIL_OPTION_LINES;
+    Watch = -1;
 
     //
     // Handle something like tail -40 myfile or tail -4.
@@ -299,6 +301,16 @@ Return Value:
             goto MainEnd;
         }
 
+        //
+        // Start watching the file before reading any of it, so a write that
+        // lands after the last read still wakes the follow loop. If the file
+        // can't be watched, the follow loop falls back to polling.
+        //
+
+        if ((Options & TAIL_OPTION_FOLLOW) != 0) {
+            Watch = SwCreateFileWatch(FileName);
+        }
+
     } else {
         FileName = "(stdin)";
         Input = stdin;
@@ -497,12 +509,25 @@ Return Value:
             }
 
             //
-            // If following and this is just the end of the file, sleep for a
-            // second and try again.
+            // If following and this is just the end of the file, wait for the
+            // file to change and try again. Check again after a second even
+            // without a notification, and without a watch just poll every
+            // second.
             //
 
             if ((Options & TAIL_OPTION_FOLLOW)) {
-                SwSleep(1000000);
+                fflush(stdout);
+                clearerr(Input);
+                if (Watch >= 0) {
+                    if (SwWaitForFileWatch(Watch, 1000) < 0) {
+                        close(Watch);
+                        Watch = -1;
+                    }
+
+                } else {
+                    SwSleep(1000000);
+                }
+
                 continue;
             }
 
@@ -525,6 +550,10 @@ Return Value:
         fclose(Input);
     }
 
+    if (Watch >= 0) {
+        close(Watch);
+    }
+
     return Status;
 }
 
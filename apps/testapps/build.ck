@@ -42,6 +42,7 @@ function build() {
         "pathtest",
         "perftest",
         "sigtest",
+        "sndlat",
         "socktest",
         "utmrtest"
     ];
@@ -49,6 +49,7 @@ function build() {
         "driver/tdesc.c",
         "driver/testsup.c",
         "driver/tpool.c",
+        "driver/tsock.c",
         "driver/tthread.c",
         "driver/twork.c"
     ];
@@ -58,7 +59,8 @@ function build() {
     ];
 
     driverDynlibs = [
-        "kernel:kernel"
+        "kernel:kernel",
+        "drivers/net/netcore:netcore"
     ];
 
     includes = [
@@ -95,6 +95,7 @@ KTEST_FUNCTION_TABLE KTestFunctionTable[KTestCount] = {
     {KTestDescriptorStressStart},
     {KTestBlockStressStart},
     {KTestBlockStressStart},
+    {KTestSocketLookupStressStart},
 };
 
 //
@@ -0,0 +1,348 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    tsock.c
+
+Abstract:
+
+    This module implements the socket lookup stress test, which hammers on the
+    path used to find the socket for each received packet.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/driver.h>
+#include <minoca/net/netdrv.h>
+#include "ktestdrv.h"
+#include "testsup.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define KTEST_SOCKET_DEFAULT_ITERATIONS 1000000
+#define KTEST_SOCKET_DEFAULT_THREAD_COUNT 4
+#define KTEST_SOCKET_DEFAULT_SOCKET_COUNT 64
+
+//
+// Define how many lookups each unit of progress represents.
+//
+
+#define KTEST_SOCKET_PROGRESS_LOOKUPS 1000
+
+//
+// Define the addresses the fake packets are sent from and to. Since no link
+// is supplied with the packets, these are never considered broadcast.
+//
+
+#define KTEST_SOCKET_LOCAL_ADDRESS 0x0200000A
+#define KTEST_SOCKET_REMOTE_ADDRESS 0x0100000A
+#define KTEST_SOCKET_REMOTE_PORT 1234
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+KTestSocketLookupStressRoutine (
+    PVOID Parameter
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+KSTATUS
+KTestSocketLookupStressStart (
+    PKTEST_START_TEST Command,
+    PKTEST_ACTIVE_TEST Test
+    )
+
+/*++
+
+Routine Description:
+
+    This routine starts a new invocation of the socket lookup stress test.
+
+Arguments:
+
+    Command - Supplies a pointer to the start command.
+
+    Test - Supplies a pointer to the active test structure to initialize.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PKTEST_PARAMETERS Parameters;
+    KSTATUS Status;
+    ULONG ThreadIndex;
+
+    Parameters = &(Test->Parameters);
+    RtlCopyMemory(Parameters, &(Command->Parameters), sizeof(KTEST_PARAMETERS));
+    if (Parameters->Iterations == 0) {
+        Parameters->Iterations = KTEST_SOCKET_DEFAULT_ITERATIONS;
+    }
+
+    if (Parameters->Threads == 0) {
+        Parameters->Threads = KTEST_SOCKET_DEFAULT_THREAD_COUNT;
+    }
+
+    if (Parameters->Parameters[0] == 0) {
+        Parameters->Parameters[0] = KTEST_SOCKET_DEFAULT_SOCKET_COUNT;
+    }
+
+    Test->Total = (Parameters->Iterations + KTEST_SOCKET_PROGRESS_LOOKUPS - 1) /
+                  KTEST_SOCKET_PROGRESS_LOOKUPS;
+    Test->Results.Status = STATUS_SUCCESS;
+    Test->Results.Failures = 0;
+    for (ThreadIndex = 0;
+         ThreadIndex < Test->Parameters.Threads;
+         ThreadIndex += 1) {
+
+        Status = PsCreateKernelThread(KTestSocketLookupStressRoutine,
+                                      Test,
+                                      "KTestSocketLookupStressRoutine");
+
+        if (!KSUCCESS(Status)) {
+            goto SocketLookupStressStartEnd;
+        }
+    }
+
+    Status = STATUS_SUCCESS;
+
+SocketLookupStressStartEnd:
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+KTestSocketLookupStressRoutine (
+    PVOID Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the socket lookup stress test. Each thread binds
+    its own set of UDP sockets to ephemeral ports, then repeatedly looks them
+    up the way the receive path would, making sure the right socket comes
+    back every time.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the thread parameter, which in this
+        case is a pointer to the active test structure.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    NETWORK_ADDRESS BindAddress;
+    NET_RECEIVE_CONTEXT Context;
+    ULONGLONG Elapsed;
+    ULONG Failures;
+    PNET_SOCKET FoundSocket;
+    ULONGLONG Frequency;
+    PIO_HANDLE *Handles;
+    UINTN Index;
+    PKTEST_ACTIVE_TEST Information;
+    UINTN Iteration;
+    NETWORK_ADDRESS LocalAddress;
+    PKTEST_PARAMETERS Parameters;
+    NETWORK_ADDRESS RemoteAddress;
+    PSOCKET Socket;
+    UINTN SocketCount;
+    PNET_SOCKET *Sockets;
+    ULONGLONG Start;
+    KSTATUS Status;
+    ULONG ThreadNumber;
+
+    Failures = 0;
+    Information = Parameter;
+    Parameters = &(Information->Parameters);
+    SocketCount = Parameters->Parameters[0];
+    ThreadNumber = RtlAtomicAdd32(&(Information->ThreadsStarted), 1);
+    Handles = MmAllocatePagedPool(SocketCount * sizeof(PIO_HANDLE),
+                                  KTEST_ALLOCATION_TAG);
+
+    Sockets = MmAllocatePagedPool(SocketCount * sizeof(PNET_SOCKET),
+                                  KTEST_ALLOCATION_TAG);
+
+    if ((Handles == NULL) || (Sockets == NULL)) {
+        Failures += 1;
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto SocketLookupStressRoutineEnd;
+    }
+
+    RtlZeroMemory(Handles, SocketCount * sizeof(PIO_HANDLE));
+
+    //
+    // Bind each socket to the any address on an ephemeral port.
+    //
+
+    RtlZeroMemory(&BindAddress, sizeof(NETWORK_ADDRESS));
+    BindAddress.Domain = NetDomainIp4;
+    for (Index = 0; Index < SocketCount; Index += 1) {
+        Status = IoSocketCreate(NetDomainIp4,
+                                NetSocketDatagram,
+                                SOCKET_INTERNET_PROTOCOL_UDP,
+                                0,
+                                &(Handles[Index]));
+
+        if (!KSUCCESS(Status)) {
+            Failures += 1;
+            goto SocketLookupStressRoutineEnd;
+        }
+
+        Status = IoSocketBindToAddress(TRUE,
+                                       Handles[Index],
+                                       NULL,
+                                       &BindAddress,
+                                       NULL,
+                                       0);
+
+        if (!KSUCCESS(Status)) {
+            Failures += 1;
+            goto SocketLookupStressRoutineEnd;
+        }
+
+        Status = IoGetSocketFromHandle(Handles[Index], &Socket);
+        if (!KSUCCESS(Status)) {
+            Failures += 1;
+            goto SocketLookupStressRoutineEnd;
+        }
+
+        Sockets[Index] = PARENT_STRUCTURE(Socket, NET_SOCKET, KernelSocket);
+    }
+
+    //
+    // Look up the sockets round robin, as if packets were streaming in from a
+    // single remote host to all of them.
+    //
+
+    RtlZeroMemory(&LocalAddress, sizeof(NETWORK_ADDRESS));
+    LocalAddress.Domain = NetDomainIp4;
+    LocalAddress.Address[0] = KTEST_SOCKET_LOCAL_ADDRESS;
+    RtlZeroMemory(&RemoteAddress, sizeof(NETWORK_ADDRESS));
+    RemoteAddress.Domain = NetDomainIp4;
+    RemoteAddress.Address[0] = KTEST_SOCKET_REMOTE_ADDRESS;
+    RemoteAddress.Port = KTEST_SOCKET_REMOTE_PORT;
+    RtlZeroMemory(&Context, sizeof(NET_RECEIVE_CONTEXT));
+    Context.Network = Sockets[0]->Network;
+    Context.Protocol = Sockets[0]->Protocol;
+    Context.Source = &RemoteAddress;
+    Context.Destination = &LocalAddress;
+    Context.ParentProtocolNumber = SOCKET_INTERNET_PROTOCOL_UDP;
+    Start = HlQueryTimeCounter();
+    for (Iteration = 0; Iteration < Parameters->Iterations; Iteration += 1) {
+        if (Information->Cancel != FALSE) {
+            Status = STATUS_SUCCESS;
+            goto SocketLookupStressRoutineEnd;
+        }
+
+        Index = Iteration % SocketCount;
+        LocalAddress.Port = Sockets[Index]->LocalReceiveAddress.Port;
+        FoundSocket = NULL;
+        Status = NetFindSocket(&Context, &FoundSocket);
+        if (!KSUCCESS(Status)) {
+            Failures += 1;
+
+        } else {
+            if (FoundSocket != Sockets[Index]) {
+                Failures += 1;
+            }
+
+            IoSocketReleaseReference(&(FoundSocket->KernelSocket));
+        }
+
+        if ((ThreadNumber == 0) &&
+            ((Iteration % KTEST_SOCKET_PROGRESS_LOOKUPS) == 0)) {
+
+            Information->Progress += 1;
+        }
+    }
+
+    //
+    // The first thread reports its lookup rate, which reflects how much the
+    // other threads got in its way.
+    //
+
+    Elapsed = HlQueryTimeCounter() - Start;
+    if ((ThreadNumber == 0) && (Elapsed != 0)) {
+        Frequency = HlQueryTimeCounterFrequency();
+        Information->Results.Results[0] =
+                                (Parameters->Iterations * Frequency) / Elapsed;
+
+        Information->Results.Results[1] = SocketCount;
+    }
+
+    Status = STATUS_SUCCESS;
+
+SocketLookupStressRoutineEnd:
+    if (Handles != NULL) {
+        for (Index = 0; Index < SocketCount; Index += 1) {
+            if (Handles[Index] != NULL) {
+                IoClose(Handles[Index]);
+            }
+        }
+
+        MmFreePagedPool(Handles);
+    }
+
+    if (Sockets != NULL) {
+        MmFreePagedPool(Sockets);
+    }
+
+    //
+    // Save the results.
+    //
+
+    if (!KSUCCESS(Status)) {
+        Information->Results.Status = Status;
+    }
+
+    Information->Results.Failures += Failures;
+    RtlAtomicAdd32(&(Information->ThreadsFinished), 1);
+    return;
+}
+
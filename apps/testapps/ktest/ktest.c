@@ -76,7 +76,8 @@ Module Name:
     "  -p, --threads <count> -- Set the number of threads to spin up.\n"       \
     "  -t, --test -- Set the test to perform. Valid values are all, \n"        \
     "      pagedpoolstress, nonpagedpoolstress, workstress, threadstress, \n"  \
-    "      descriptorstress, pagedblockstress and nonpagedblockstress.\n"      \
+    "      descriptorstress, pagedblockstress, nonpagedblockstress and \n"     \
+    "      socketlookupstress.\n"                                              \
     "  --debug -- Print lots of information about what's happening.\n"         \
     "  --quiet -- Print only errors.\n"                                        \
     "  --no-cleanup -- Leave test files around for debugging.\n"               \
@@ -176,6 +177,7 @@ PSTR KTestNames[KTestCount] = {
     "descriptorstress",
     "pagedblockstress",
     "nonpagedblockstress",
+    "socketlookupstress",
 };
 
 //
@@ -473,6 +475,18 @@ Return Value:
         }
     }
 
+    if ((Test == KTestAll) || (Test == KTestSocketLookupStress)) {
+        Status = KTestSendStartRequest(DriverHandle,
+                                       KTestSocketLookupStress,
+                                       &Start,
+                                       &HandleCount);
+
+        if (Status != 0) {
+            PRINT_ERROR("Failed to send start request.\n");
+            Failures += 1;
+        }
+    }
+
     //
     // Poll the tests until they are all complete.
     //
@@ -582,6 +596,15 @@ Return Value:
 
                     break;
 
+                case KTestSocketLookupStress:
+                    PRINT("%s: %ld lookups per second with %ld sockets "
+                          "per thread\n",
+                          TestName,
+                          (long)Poll.Results.Results[0],
+                          (long)Poll.Results.Results[1]);
+
+                    break;
+
                 default:
 
                     assert(FALSE);
@@ -63,6 +63,7 @@ typedef enum _KTEST_TYPE {
     KTestDescriptorStress,
     KTestPagedBlockStress,
     KTestNonPagedBlockStress,
+    KTestSocketLookupStress,
     KTestCount
 } KTEST_TYPE, *PKTEST_TYPE;
 
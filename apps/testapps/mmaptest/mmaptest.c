@@ -78,7 +78,7 @@ Module Name:
     "  -i, --iterations <count> -- Set the number of operations to perform.\n" \
     "  -p, --threads <count> -- Set the number of threads to spin up.\n"       \
     "  -t, --test -- Set the test to perform. Valid values are all, \n"        \
-    "      basic, private, shared, shmprivate, and shmshared.\n"               \
+    "      basic, private, shared, shmprivate, shmshared, and faults.\n"       \
     "  --debug -- Print lots of information about what's happening.\n"         \
     "  --quiet -- Print only errors.\n"                                        \
     "  --no-cleanup -- Leave test files around for debugging.\n"               \
@@ -94,6 +94,23 @@ Module Name:
 #define DEFAULT_OPERATION_COUNT (DEFAULT_FILE_COUNT * 50)
 #define DEFAULT_THREAD_COUNT 1
 
+//
+// Define the number of single page mappings the fault benchmark keeps alive
+// at once, and the number of iterations that make up one round of mapping,
+// touching and unmapping all of them.
+//
+
+#define MEMORY_MAP_FAULT_MAPPING_COUNT 4096
+#define MEMORY_MAP_FAULT_ITERATIONS_PER_ROUND 100
+
+//
+// Define the stride used to walk the mappings. It is prime and so coprime
+// with the mapping count, so every mapping is visited once per pass, but
+// consecutive faults land far apart in the address space.
+//
+
+#define MEMORY_MAP_FAULT_STRIDE 1021
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -121,7 +138,8 @@ typedef enum _MEMORY_MAP_TEST_TYPE {
     MemoryMapTestPrivate,
     MemoryMapTestShared,
     MemoryMapTestShmPrivate,
-    MemoryMapTestShmShared
+    MemoryMapTestShmShared,
+    MemoryMapTestFaults
 } MEMORY_MAP_TEST_TYPE, *PMEMORY_MAP_TEST_TYPE;
 
 typedef
@@ -198,6 +216,11 @@ RunMemoryMapShmSharedTest (
     INT Iterations
     );
 
+ULONG
+RunMemoryMapFaultTest (
+    INT Iterations
+    );
+
 static
 VOID
 MemoryMapTestExpectedSignalHandler (
@@ -437,6 +460,9 @@ Return Value:
             } else if (strcasecmp(optarg, "shmshared") == 0) {
                 Test = MemoryMapTestShmShared;
 
+            } else if (strcasecmp(optarg, "faults") == 0) {
+                Test = MemoryMapTestFaults;
+
             } else {
                 PRINT_ERROR("Invalid test: %s.\n", optarg);
                 Status = 1;
@@ -533,6 +559,10 @@ Return Value:
         Failures += RunMemoryMapShmSharedTest(FileCount, FileSize, Iterations);
     }
 
+    if ((Test == MemoryMapTestAll) || (Test == MemoryMapTestFaults)) {
+        Failures += RunMemoryMapFaultTest(Iterations);
+    }
+
     //
     // Wait for any children.
     //
@@ -3018,6 +3048,183 @@ Return Value:
     return Failures;
 }
 
+ULONG
+RunMemoryMapFaultTest (
+    INT Iterations
+    )
+
+/*++
+
+Routine Description:
+
+    This routine benchmarks page faults in a process with thousands of
+    separate mappings. Every round maps a large number of single page
+    anonymous regions, alternating between writable and read-only so that
+    none of them can be merged, faults each one in once in a scattered order,
+    and then unmaps them all.
+
+Arguments:
+
+    Iterations - Supplies the number of iterations to perform. Every
+        MEMORY_MAP_FAULT_ITERATIONS_PER_ROUND iterations make up one round.
+
+Return Value:
+
+    Returns the number of failures in the test suite.
+
+--*/
+
+{
+
+    ULONG Failures;
+    ULONGLONG FaultCount;
+    INT Index;
+    PBYTE *Mappings;
+    INT MappingIndex;
+    size_t PageSize;
+    pid_t Process;
+    INT Protection;
+    INT Result;
+    INT Round;
+    INT RoundCount;
+    struct sigaction SignalAction;
+    struct timeval StartTime;
+    BYTE Value;
+
+    Failures = 0;
+    FaultCount = 0;
+    PageSize = sysconf(_SC_PAGE_SIZE);
+    RoundCount = Iterations / MEMORY_MAP_FAULT_ITERATIONS_PER_ROUND;
+    if (RoundCount == 0) {
+        RoundCount = 1;
+    }
+
+    Mappings = malloc(sizeof(PBYTE) * MEMORY_MAP_FAULT_MAPPING_COUNT);
+    if (Mappings == NULL) {
+        PRINT_ERROR("Failed to allocate mapping array.\n");
+        Failures += 1;
+        goto RunMemoryMapFaultTestEnd;
+    }
+
+    for (Index = 0; Index < MEMORY_MAP_FAULT_MAPPING_COUNT; Index += 1) {
+        Mappings[Index] = MAP_FAILED;
+    }
+
+    SignalAction.sa_sigaction = MemoryMapTestUnexpectedSignalHandler;
+    sigemptyset(&(SignalAction.sa_mask));
+    SignalAction.sa_flags = SA_SIGINFO;
+    sigaction(SIGSEGV, &SignalAction, NULL);
+    sigaction(SIGBUS, &SignalAction, NULL);
+
+    //
+    // Record the test start time.
+    //
+
+    Result = gettimeofday(&StartTime, NULL);
+    if (Result != 0) {
+        PRINT_ERROR("Failed to get time of day: %s.\n", strerror(errno));
+        Failures += 1;
+        goto RunMemoryMapFaultTestEnd;
+    }
+
+    Process = getpid();
+    PRINT("Process %d Running memory map fault test with %d mappings. "
+          "%d rounds.\n",
+          Process,
+          MEMORY_MAP_FAULT_MAPPING_COUNT,
+          RoundCount);
+
+    for (Round = 0; Round < RoundCount; Round += 1) {
+        for (Index = 0; Index < MEMORY_MAP_FAULT_MAPPING_COUNT; Index += 1) {
+            Protection = PROT_READ;
+            if ((Index & 0x1) == 0) {
+                Protection |= PROT_WRITE;
+            }
+
+            Mappings[Index] = mmap(NULL,
+                                   PageSize,
+                                   Protection,
+                                   MAP_ANONYMOUS | MAP_PRIVATE,
+                                   -1,
+                                   0);
+
+            if (Mappings[Index] == MAP_FAILED) {
+                PRINT_ERROR("Failed to create mapping %d: %s.\n",
+                            Index,
+                            strerror(errno));
+
+                Failures += 1;
+                goto RunMemoryMapFaultTestEnd;
+            }
+        }
+
+        //
+        // Touch every mapping once, hopping around the address space. The
+        // writable ones take a write fault, the read-only ones a read fault.
+        //
+
+        MappingIndex = 0;
+        for (Index = 0; Index < MEMORY_MAP_FAULT_MAPPING_COUNT; Index += 1) {
+            MappingIndex = (MappingIndex + MEMORY_MAP_FAULT_STRIDE) %
+                           MEMORY_MAP_FAULT_MAPPING_COUNT;
+
+            if ((MappingIndex & 0x1) == 0) {
+                *(Mappings[MappingIndex]) = (BYTE)MappingIndex | 0x1;
+                Value = *(Mappings[MappingIndex]);
+                if (Value != ((BYTE)MappingIndex | 0x1)) {
+                    PRINT_ERROR("Mapping %d read back %x.\n",
+                                MappingIndex,
+                                Value);
+
+                    Failures += 1;
+                }
+
+            } else {
+                Value = *(Mappings[MappingIndex]);
+                if (Value != 0) {
+                    PRINT_ERROR("Read-only mapping %d read %x, expected 0.\n",
+                                MappingIndex,
+                                Value);
+
+                    Failures += 1;
+                }
+            }
+
+            FaultCount += 1;
+        }
+
+        for (Index = 0; Index < MEMORY_MAP_FAULT_MAPPING_COUNT; Index += 1) {
+            Result = munmap(Mappings[Index], PageSize);
+            if (Result != 0) {
+                PRINT_ERROR("Failed to unmap mapping %d at %p: %s.\n",
+                            Index,
+                            Mappings[Index],
+                            strerror(errno));
+
+                Failures += 1;
+            }
+
+            Mappings[Index] = MAP_FAILED;
+        }
+    }
+
+    PRINT("Faulted %I64d pages.\n", FaultCount);
+    Failures += PrintTestTime(&StartTime);
+
+RunMemoryMapFaultTestEnd:
+    if (Mappings != NULL) {
+        for (Index = 0; Index < MEMORY_MAP_FAULT_MAPPING_COUNT; Index += 1) {
+            if (Mappings[Index] != MAP_FAILED) {
+                munmap(Mappings[Index], PageSize);
+            }
+        }
+
+        free(Mappings);
+    }
+
+    return Failures;
+}
+
 static
 VOID
 MemoryMapTestExpectedSignalHandler (
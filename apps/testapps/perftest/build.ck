@@ -36,8 +36,11 @@ function build() {
     var sources;
 
     sources = [
+        "clock.c",
+        "compare.c",
         "copy.c",
         "create.c",
+        "devio.c",
         "dlopen.c",
         "dup.c",
         "getppid.c",
@@ -47,14 +50,19 @@ function build() {
         "mmap.c",
         "mutex.c",
         "open.c",
+        "pagecache.c",
         "perfsup.c",
         "perftest.c",
         "pipeio.c",
         "pthread.c",
+        "ptyio.c",
+        "random.c",
         "read.c",
         "rename.c",
         "signal.c",
         "stat.c",
+        "udp.c",
+        "wakeup.c",
         "write.c"
     ];
 
@@ -0,0 +1,189 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    clock.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for reading the
+    current time.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+ClockMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the clock read performance benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    unsigned long long Iterations;
+    struct timespec Previous;
+    int Status;
+    struct timespec Time;
+    struct timeval TimeValue;
+
+    Iterations = 0;
+    Result->Type = PtResultIterations;
+    Result->Status = 0;
+    Previous.tv_sec = 0;
+    Previous.tv_nsec = 0;
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    switch (Test->TestType) {
+
+    //
+    // Read the monotonic clock, making sure it really never goes backwards.
+    // It can be read straight from the counter hardware, which makes this a
+    // good check that the hardware counters are in sync across processors.
+    //
+
+    case PtTestClockMonotonic:
+        while (PtIsTimedTestRunning() != 0) {
+            if (clock_gettime(CLOCK_MONOTONIC, &Time) != 0) {
+                Result->Status = errno;
+                break;
+            }
+
+            if ((Time.tv_sec < Previous.tv_sec) ||
+                ((Time.tv_sec == Previous.tv_sec) &&
+                 (Time.tv_nsec < Previous.tv_nsec))) {
+
+                fprintf(stderr,
+                        "Error: Monotonic clock went backwards from "
+                        "%lld.%09ld to %lld.%09ld.\n",
+                        (long long)Previous.tv_sec,
+                        Previous.tv_nsec,
+                        (long long)Time.tv_sec,
+                        Time.tv_nsec);
+
+                Result->Status = EINVAL;
+                break;
+            }
+
+            Previous = Time;
+            Iterations += 1;
+        }
+
+        break;
+
+    case PtTestClockRealtime:
+        while (PtIsTimedTestRunning() != 0) {
+            if (clock_gettime(CLOCK_REALTIME, &Time) != 0) {
+                Result->Status = errno;
+                break;
+            }
+
+            Iterations += 1;
+        }
+
+        break;
+
+    case PtTestGettimeofday:
+        while (PtIsTimedTestRunning() != 0) {
+            if (gettimeofday(&TimeValue, NULL) != 0) {
+                Result->Status = errno;
+                break;
+            }
+
+            Iterations += 1;
+        }
+
+        break;
+
+    default:
+        fprintf(stderr, "Unknown clock test type %d\n", Test->TestType);
+        Result->Status = EINVAL;
+        break;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
@@ -0,0 +1,482 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    compare.c
+
+Abstract:
+
+    This module implements comparison of two sets of performance test results
+    written in the JSON format, flagging the tests that moved by more than a
+    noise threshold.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_COMPARE_LINE_SIZE 1024
+#define PT_COMPARE_NAME_SIZE 64
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines a single result loaded from a JSON results file.
+
+Members:
+
+    Name - Stores the name of the test.
+
+    ProcessCount - Stores the number of processes the test ran with.
+
+    Rate - Stores the average per-process rate, in iterations or bytes per
+        second.
+
+--*/
+
+typedef struct _PT_COMPARE_ENTRY {
+    char Name[PT_COMPARE_NAME_SIZE];
+    long ProcessCount;
+    double Rate;
+} PT_COMPARE_ENTRY, *PPT_COMPARE_ENTRY;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+int
+PtpLoadResults (
+    const char *Path,
+    PPT_COMPARE_ENTRY *Entries,
+    size_t *EntryCount
+    );
+
+int
+PtpParseResultLine (
+    char *Line,
+    PPT_COMPARE_ENTRY Entry
+    );
+
+char *
+PtpFindJsonValue (
+    char *Line,
+    const char *Key
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+int
+PtCompareResults (
+    const char *BaselinePath,
+    const char *ResultPath,
+    double Threshold
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compares two JSON results files and prints the change in each
+    test's rate. Every test reports a rate where larger is better.
+
+Arguments:
+
+    BaselinePath - Supplies the path to the results to compare against.
+
+    ResultPath - Supplies the path to the new results.
+
+    Threshold - Supplies the percentage change below which a difference is
+        considered noise.
+
+Return Value:
+
+    Returns the number of tests that regressed by more than the threshold.
+
+    -1 if either file could not be read.
+
+--*/
+
+{
+
+    PPT_COMPARE_ENTRY Baseline;
+    size_t BaselineCount;
+    double Change;
+    size_t Index;
+    PPT_COMPARE_ENTRY New;
+    size_t NewCount;
+    PPT_COMPARE_ENTRY Old;
+    size_t OldIndex;
+    int Regressions;
+    PPT_COMPARE_ENTRY Results;
+    int Status;
+    const char *Verdict;
+
+    Baseline = NULL;
+    Regressions = -1;
+    Results = NULL;
+    Status = PtpLoadResults(BaselinePath, &Baseline, &BaselineCount);
+    if (Status != 0) {
+        fprintf(stderr,
+                "perftest: Failed to load %s: %s.\n",
+                BaselinePath,
+                strerror(Status));
+
+        goto CompareResultsEnd;
+    }
+
+    Status = PtpLoadResults(ResultPath, &Results, &NewCount);
+    if (Status != 0) {
+        fprintf(stderr,
+                "perftest: Failed to load %s: %s.\n",
+                ResultPath,
+                strerror(Status));
+
+        goto CompareResultsEnd;
+    }
+
+    Regressions = 0;
+    printf("%-24s %5s %14s %14s %9s\n",
+           "Test",
+           "Procs",
+           "Baseline",
+           "Result",
+           "Change");
+
+    for (Index = 0; Index < NewCount; Index += 1) {
+        New = &(Results[Index]);
+        Old = NULL;
+        for (OldIndex = 0; OldIndex < BaselineCount; OldIndex += 1) {
+            if ((Baseline[OldIndex].ProcessCount == New->ProcessCount) &&
+                (strcmp(Baseline[OldIndex].Name, New->Name) == 0)) {
+
+                Old = &(Baseline[OldIndex]);
+                break;
+            }
+        }
+
+        if ((Old == NULL) || (Old->Rate <= 0.0)) {
+            printf("%-24s %5ld %14s %14.3f %9s\n",
+                   New->Name,
+                   New->ProcessCount,
+                   "-",
+                   New->Rate,
+                   "new");
+
+            continue;
+        }
+
+        Change = ((New->Rate - Old->Rate) / Old->Rate) * 100.0;
+        Verdict = "";
+        if (Change < -Threshold) {
+            Verdict = " REGRESSED";
+            Regressions += 1;
+
+        } else if (Change > Threshold) {
+            Verdict = " improved";
+        }
+
+        printf("%-24s %5ld %14.3f %14.3f %+8.2f%%%s\n",
+               New->Name,
+               New->ProcessCount,
+               Old->Rate,
+               New->Rate,
+               Change,
+               Verdict);
+    }
+
+    printf("%d regression(s) beyond %.2f%% noise threshold.\n",
+           Regressions,
+           Threshold);
+
+CompareResultsEnd:
+    if (Baseline != NULL) {
+        free(Baseline);
+    }
+
+    if (Results != NULL) {
+        free(Results);
+    }
+
+    return Regressions;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+int
+PtpLoadResults (
+    const char *Path,
+    PPT_COMPARE_ENTRY *Entries,
+    size_t *EntryCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine loads the successful results out of a JSON results file. This
+    is not a general JSON parser; it relies on perftest writing each result
+    object on a line of its own.
+
+Arguments:
+
+    Path - Supplies the path of the file to load.
+
+    Entries - Supplies a pointer where an array of results will be returned
+        on success. The caller is responsible for freeing this array.
+
+    EntryCount - Supplies a pointer where the number of results will be
+        returned.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    size_t Capacity;
+    size_t Count;
+    PT_COMPARE_ENTRY Entry;
+    FILE *File;
+    char Line[PT_COMPARE_LINE_SIZE];
+    PPT_COMPARE_ENTRY NewEntries;
+    PPT_COMPARE_ENTRY Results;
+    int Status;
+
+    Capacity = 0;
+    Count = 0;
+    Results = NULL;
+    Status = 0;
+    File = fopen(Path, "r");
+    if (File == NULL) {
+        return errno;
+    }
+
+    while (fgets(Line, sizeof(Line), File) != NULL) {
+        if (PtpParseResultLine(Line, &Entry) != 0) {
+            continue;
+        }
+
+        if (Count == Capacity) {
+            Capacity = (Capacity * 2) + 16;
+            NewEntries = realloc(Results, Capacity * sizeof(PT_COMPARE_ENTRY));
+            if (NewEntries == NULL) {
+                Status = ENOMEM;
+                break;
+            }
+
+            Results = NewEntries;
+        }
+
+        Results[Count] = Entry;
+        Count += 1;
+    }
+
+    if ((Status == 0) && (ferror(File) != 0)) {
+        Status = EIO;
+    }
+
+    fclose(File);
+    if (Status != 0) {
+        if (Results != NULL) {
+            free(Results);
+        }
+
+        return Status;
+    }
+
+    *Entries = Results;
+    *EntryCount = Count;
+    return 0;
+}
+
+int
+PtpParseResultLine (
+    char *Line,
+    PPT_COMPARE_ENTRY Entry
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses a single result object line of a JSON results file.
+
+Arguments:
+
+    Line - Supplies the line to parse.
+
+    Entry - Supplies a pointer where the parsed result will be returned.
+
+Return Value:
+
+    0 if the line held a result where every process succeeded.
+
+    -1 if the line is not a result or the result is not usable.
+
+--*/
+
+{
+
+    char *End;
+    size_t Length;
+    char *Value;
+
+    Value = PtpFindJsonValue(Line, "test");
+    if ((Value == NULL) || (*Value != '"')) {
+        return -1;
+    }
+
+    Value += 1;
+    End = strchr(Value, '"');
+    if (End == NULL) {
+        return -1;
+    }
+
+    Length = End - Value;
+    if (Length >= PT_COMPARE_NAME_SIZE) {
+        Length = PT_COMPARE_NAME_SIZE - 1;
+    }
+
+    memcpy(Entry->Name, Value, Length);
+    Entry->Name[Length] = '\0';
+    Value = PtpFindJsonValue(Line, "failed_processes");
+    if ((Value == NULL) || (strtol(Value, NULL, 10) != 0)) {
+        return -1;
+    }
+
+    Value = PtpFindJsonValue(Line, "processes");
+    if (Value == NULL) {
+        return -1;
+    }
+
+    Entry->ProcessCount = strtol(Value, &End, 10);
+    if (End == Value) {
+        return -1;
+    }
+
+    Value = PtpFindJsonValue(Line, "rate");
+    if (Value == NULL) {
+        return -1;
+    }
+
+    Entry->Rate = strtod(Value, &End);
+    if (End == Value) {
+        return -1;
+    }
+
+    return 0;
+}
+
+char *
+PtpFindJsonValue (
+    char *Line,
+    const char *Key
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the value for the given key within a single line JSON
+    object.
+
+Arguments:
+
+    Line - Supplies the line to search.
+
+    Key - Supplies the key to find, without quotes.
+
+Return Value:
+
+    Returns a pointer to the first character of the value on success.
+
+    NULL if the key was not found.
+
+--*/
+
+{
+
+    size_t KeyLength;
+    char *Search;
+
+    KeyLength = strlen(Key);
+    Search = Line;
+    while (1) {
+        Search = strchr(Search, '"');
+        if (Search == NULL) {
+            return NULL;
+        }
+
+        Search += 1;
+        if ((strncmp(Search, Key, KeyLength) == 0) &&
+            (Search[KeyLength] == '"') &&
+            (Search[KeyLength + 1] == ':')) {
+
+            Search += KeyLength + 2;
+            while (*Search == ' ') {
+                Search += 1;
+            }
+
+            return Search;
+        }
+
+        //
+        // Skip to the end of this string so its contents are never mistaken
+        // for the start of a key.
+        //
+
+        Search = strchr(Search, '"');
+        if (Search == NULL) {
+            return NULL;
+        }
+
+        Search += 1;
+    }
+
+    return NULL;
+}
+
@@ -0,0 +1,190 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    devio.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for small
+    synchronous device I/O. The transfers are tiny and the devices do no real
+    work, so the result measures the per-request overhead of the I/O path.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_DEVICE_IO_BUFFER_SIZE 64
+
+#define PT_DEVICE_IO_NULL_PATH "/dev/null"
+#define PT_DEVICE_IO_ZERO_PATH "/dev/zero"
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+DeviceIoMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the device I/O request rate benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char Buffer[PT_DEVICE_IO_BUFFER_SIZE];
+    ssize_t BytesCompleted;
+    int Descriptor;
+    unsigned long long Iterations;
+    int OpenFlags;
+    const char *Path;
+    int Status;
+    int Write;
+
+    Descriptor = -1;
+    Iterations = 0;
+    Result->Type = PtResultIterations;
+    Result->Status = 0;
+    switch (Test->TestType) {
+    case PtTestDeviceNullWrite:
+        Path = PT_DEVICE_IO_NULL_PATH;
+        OpenFlags = O_WRONLY;
+        Write = 1;
+        break;
+
+    case PtTestDeviceZeroRead:
+        Path = PT_DEVICE_IO_ZERO_PATH;
+        OpenFlags = O_RDONLY;
+        Write = 0;
+        break;
+
+    default:
+        fprintf(stderr, "Unknown device I/O test type %d\n", Test->TestType);
+        Result->Status = EINVAL;
+        goto MainEnd;
+    }
+
+    Descriptor = open(Path, OpenFlags);
+    if (Descriptor < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Measure the rate at which small requests can be pushed through the
+    // device.
+    //
+
+    while (PtIsTimedTestRunning() != 0) {
+        do {
+            if (Write != 0) {
+                BytesCompleted = write(Descriptor,
+                                       Buffer,
+                                       PT_DEVICE_IO_BUFFER_SIZE);
+
+            } else {
+                BytesCompleted = read(Descriptor,
+                                      Buffer,
+                                      PT_DEVICE_IO_BUFFER_SIZE);
+            }
+
+        } while ((BytesCompleted < 0) && (errno == EINTR));
+
+        if (BytesCompleted != PT_DEVICE_IO_BUFFER_SIZE) {
+            if (errno == 0) {
+                errno = EIO;
+            }
+
+            Result->Status = errno;
+            break;
+        }
+
+        Iterations += 1;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (Descriptor >= 0) {
+        close(Descriptor);
+    }
+
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
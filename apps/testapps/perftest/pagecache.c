@@ -0,0 +1,348 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    pagecache.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for page cache
+    read bandwidth, both when the data is already cached and when every read
+    has to fill the cache.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_PAGE_CACHE_FILE_NAME_LENGTH 48
+#define PT_PAGE_CACHE_FILE_SIZE (8 * 1024 * 1024)
+#define PT_PAGE_CACHE_BUFFER_SIZE (64 * 1024)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+int
+PtpPageCachePrepareFile (
+    int FileDescriptor,
+    PT_TEST_TYPE TestType,
+    char *Buffer
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+PageCacheMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the page cache read bandwidth benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char *Buffer;
+    ssize_t BytesRead;
+    int FileCreated;
+    int FileDescriptor;
+    char FileName[PT_PAGE_CACHE_FILE_NAME_LENGTH];
+    off_t Offset;
+    int Status;
+    unsigned long long TotalBytes;
+
+    Buffer = NULL;
+    FileCreated = 0;
+    FileDescriptor = -1;
+    Offset = 0;
+    Result->Type = PtResultBytes;
+    Result->Status = 0;
+    TotalBytes = 0;
+    if ((Test->TestType != PtTestPageCacheHit) &&
+        (Test->TestType != PtTestPageCacheMiss)) {
+
+        fprintf(stderr, "Unknown page cache test type %d\n", Test->TestType);
+        Result->Status = EINVAL;
+        goto MainEnd;
+    }
+
+    Buffer = malloc(PT_PAGE_CACHE_BUFFER_SIZE);
+    if (Buffer == NULL) {
+        Result->Status = ENOMEM;
+        goto MainEnd;
+    }
+
+    memset(Buffer, 'a', PT_PAGE_CACHE_BUFFER_SIZE);
+
+    //
+    // Get the process ID and create a process safe file path.
+    //
+
+    Status = snprintf(FileName,
+                      PT_PAGE_CACHE_FILE_NAME_LENGTH,
+                      "pagecache_%d.txt",
+                      getpid());
+
+    if (Status < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    FileDescriptor = open(FileName,
+                          O_RDWR | O_CREAT | O_TRUNC,
+                          S_IRUSR | S_IWUSR);
+
+    if (FileDescriptor < 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    FileCreated = 1;
+    Status = PtpPageCachePrepareFile(FileDescriptor, Test->TestType, Buffer);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Read through the file in large chunks. When the end of the file is
+    // reached, start over from the beginning. For the miss test, truncating
+    // the file away and extending it again evicts everything that was just
+    // read, so the next pass misses all over again.
+    //
+
+    while (PtIsTimedTestRunning() != 0) {
+        if (Offset >= PT_PAGE_CACHE_FILE_SIZE) {
+            Offset = 0;
+            if (Test->TestType == PtTestPageCacheMiss) {
+                Status = PtpPageCachePrepareFile(FileDescriptor,
+                                                 Test->TestType,
+                                                 Buffer);
+
+                if (Status != 0) {
+                    Result->Status = errno;
+                    break;
+                }
+            }
+        }
+
+        do {
+            BytesRead = pread(FileDescriptor,
+                              Buffer,
+                              PT_PAGE_CACHE_BUFFER_SIZE,
+                              Offset);
+
+        } while ((BytesRead < 0) && (errno == EINTR));
+
+        if (BytesRead <= 0) {
+            if (BytesRead == 0) {
+                errno = EIO;
+            }
+
+            Result->Status = errno;
+            break;
+        }
+
+        Offset += BytesRead;
+        TotalBytes += (unsigned long long)BytesRead;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (FileDescriptor >= 0) {
+        close(FileDescriptor);
+    }
+
+    if (FileCreated != 0) {
+        Status = remove(FileName);
+        if ((Status != 0) && (Result->Status == 0)) {
+            Result->Status = errno;
+        }
+    }
+
+    if (Buffer != NULL) {
+        free(Buffer);
+    }
+
+    Result->Data.Bytes = TotalBytes;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+int
+PtpPageCachePrepareFile (
+    int FileDescriptor,
+    PT_TEST_TYPE TestType,
+    char *Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets up the contents of the test file. For the hit test, the
+    file is written out and read once so that every page is resident. For the
+    miss test, the file is truncated to nothing and then extended without
+    being written, so none of its pages are in the cache. There is no
+    portable way to evict a written file's pages, so the miss test measures
+    the cost of populating the cache rather than the speed of the disk.
+
+Arguments:
+
+    FileDescriptor - Supplies the open test file.
+
+    TestType - Supplies the test being run.
+
+    Buffer - Supplies a scratch buffer of the test's chunk size.
+
+Return Value:
+
+    0 on success.
+
+    -1 on failure, and errno will contain more information.
+
+--*/
+
+{
+
+    ssize_t BytesCompleted;
+    off_t Offset;
+    int Status;
+
+    Status = ftruncate(FileDescriptor, 0);
+    if (Status != 0) {
+        return Status;
+    }
+
+    if (TestType == PtTestPageCacheMiss) {
+        return ftruncate(FileDescriptor, PT_PAGE_CACHE_FILE_SIZE);
+    }
+
+    for (Offset = 0;
+         Offset < PT_PAGE_CACHE_FILE_SIZE;
+         Offset += PT_PAGE_CACHE_BUFFER_SIZE) {
+
+        do {
+            BytesCompleted = pwrite(FileDescriptor,
+                                    Buffer,
+                                    PT_PAGE_CACHE_BUFFER_SIZE,
+                                    Offset);
+
+        } while ((BytesCompleted < 0) && (errno == EINTR));
+
+        if (BytesCompleted != PT_PAGE_CACHE_BUFFER_SIZE) {
+            if (BytesCompleted >= 0) {
+                errno = EIO;
+            }
+
+            return -1;
+        }
+    }
+
+    Status = fsync(FileDescriptor);
+    if (Status != 0) {
+        return Status;
+    }
+
+    //
+    // Touch every page once so the timed reads all hit.
+    //
+
+    for (Offset = 0;
+         Offset < PT_PAGE_CACHE_FILE_SIZE;
+         Offset += PT_PAGE_CACHE_BUFFER_SIZE) {
+
+        do {
+            BytesCompleted = pread(FileDescriptor,
+                                   Buffer,
+                                   PT_PAGE_CACHE_BUFFER_SIZE,
+                                   Offset);
+
+        } while ((BytesCompleted < 0) && (errno == EINTR));
+
+        if (BytesCompleted <= 0) {
+            if (BytesCompleted == 0) {
+                errno = EIO;
+            }
+
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
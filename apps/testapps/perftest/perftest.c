@@ -77,12 +77,20 @@ Module Name:
     "      The default will print to standard out.\n"                          \
     "  -l, --list -- List the set of available tests.\n"                       \
     "  -s, --summary -- Print the results in the summary format.\n"            \
+    "  -j, --json -- Print the results as a JSON document.\n"                  \
+    "  -S, --sweep -- Run each test with 1, 2, 4, etc. processes, up to the\n" \
+    "      process count. The count defaults to the number of processors.\n"  \
+    "  -c, --compare <baseline> <results> -- Compare two JSON result files\n" \
+    "      instead of running tests. The exit status is the number of\n"      \
+    "      tests that regressed by more than the threshold.\n"                \
+    "  -T, --threshold <percent> -- Set the change, as a percentage, that\n"  \
+    "      comparisons treat as noise. The default is 5.\n"                    \
     "  --verbose -- Print lots of information about what's happening.\n"       \
     "  --quiet -- Print only errors.\n"                                        \
     "  --help -- Print this help text and exit.\n"                             \
     "  --version -- Print the test version and exit.\n"                        \
 
-#define PT_OPTION_STRING "t:p:d:r:slnvqhV"
+#define PT_OPTION_STRING "t:p:d:r:c:T:sjSlnvqhV"
 
 //
 // Define the default values for each argument.
@@ -90,6 +98,7 @@ Module Name:
 
 #define PT_DEFAULT_TEST PtTestAll
 #define PT_DEFAULT_PROCESS_COUNT 1
+#define PT_DEFAULT_COMPARE_THRESHOLD 5.0
 
 //
 // ------------------------------------------------------ Data Type Definitions
@@ -104,6 +113,7 @@ typedef enum _PT_TEST_VERBOSITY {
 typedef enum _PT_RESULT_FORMAT {
     PtResultFormatDefault,
     PtResultFormatSummary,
+    PtResultFormatJson,
     PtResultFormatCount,
 } PT_RESULT_FORMAT, *PPT_RESULT_FORMAT;
 
@@ -130,6 +140,38 @@ typedef struct _PT_PROCESS {
     PT_TEST_RESULT Result;
 } PT_PROCESS, *PPT_PROCESS;
 
+/*++
+
+Structure Description:
+
+    This structure defines the averaged results of a test across all of the
+    processes that ran it.
+
+Members:
+
+    ValidProcessCount - Stores the number of processes that succeeded.
+
+    Rate - Stores the average per-process rate, in iterations or bytes per
+        second.
+
+    ResourceUsageValid - Stores 1 if the usage percentages are valid, or 0 if
+        the test did not report resource usage.
+
+    UserPercent - Stores the average user time as a percentage of real time.
+
+    KernelPercent - Stores the average system time as a percentage of real
+        time.
+
+--*/
+
+typedef struct _PT_TEST_SUMMARY {
+    long ValidProcessCount;
+    double Rate;
+    int ResourceUsageValid;
+    double UserPercent;
+    double KernelPercent;
+} PT_TEST_SUMMARY, *PPT_TEST_SUMMARY;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
@@ -148,6 +190,14 @@ PtpPrintTestResults (
     long ProcessCount
     );
 
+void
+PtpSummarizeTestResults (
+    PPT_TEST_INFORMATION Test,
+    PPT_PROCESS Processes,
+    long ProcessCount,
+    PPT_TEST_SUMMARY Summary
+    );
+
 void
 PtpPrintTestResult (
     PPT_TEST_RESULT Result
@@ -184,6 +234,10 @@ struct option PtLongOptions[] = {
     {"results", required_argument, 0, 'r'},
     {"list", no_argument, 0, 'l'},
     {"summary", no_argument, 0, 's'},
+    {"json", no_argument, 0, 'j'},
+    {"sweep", no_argument, 0, 'S'},
+    {"compare", required_argument, 0, 'c'},
+    {"threshold", required_argument, 0, 'T'},
     {"verbose", no_argument, 0, 'v'},
     {"quiet", no_argument, 0, 'q'},
     {"help", no_argument, 0, 'h'},
@@ -413,6 +467,125 @@ PT_TEST_INFORMATION PerformanceTests[PtTestTypeCount] = {
      PtTestSignalRestart,
      PtResultIterations,
      SIGNAL_RESTART_DEFAULT_DURATION},
+
+    {CLOCK_MONOTONIC_TEST_NAME,
+     CLOCK_MONOTONIC_TEST_DESCRIPTION,
+     ClockMain,
+     PtTestClockMonotonic,
+     PtResultIterations,
+     CLOCK_MONOTONIC_TEST_DEFAULT_DURATION},
+
+    {CLOCK_REALTIME_TEST_NAME,
+     CLOCK_REALTIME_TEST_DESCRIPTION,
+     ClockMain,
+     PtTestClockRealtime,
+     PtResultIterations,
+     CLOCK_REALTIME_TEST_DEFAULT_DURATION},
+
+    {GETTIMEOFDAY_TEST_NAME,
+     GETTIMEOFDAY_TEST_DESCRIPTION,
+     ClockMain,
+     PtTestGettimeofday,
+     PtResultIterations,
+     GETTIMEOFDAY_TEST_DEFAULT_DURATION},
+
+    {UDP_SEND_TEST_NAME,
+     UDP_SEND_TEST_DESCRIPTION,
+     UdpMain,
+     PtTestUdpSend,
+     PtResultIterations,
+     UDP_SEND_TEST_DEFAULT_DURATION},
+
+    {UDP_BATCH_TEST_NAME,
+     UDP_BATCH_TEST_DESCRIPTION,
+     UdpMain,
+     PtTestUdpBatch,
+     PtResultIterations,
+     UDP_BATCH_TEST_DEFAULT_DURATION},
+
+    {UDP_SEGMENT_TEST_NAME,
+     UDP_SEGMENT_TEST_DESCRIPTION,
+     UdpMain,
+     PtTestUdpSegment,
+     PtResultIterations,
+     UDP_SEGMENT_TEST_DEFAULT_DURATION},
+
+    {DEVICE_NULL_WRITE_TEST_NAME,
+     DEVICE_NULL_WRITE_TEST_DESCRIPTION,
+     DeviceIoMain,
+     PtTestDeviceNullWrite,
+     PtResultIterations,
+     DEVICE_NULL_WRITE_TEST_DEFAULT_DURATION},
+
+    {DEVICE_ZERO_READ_TEST_NAME,
+     DEVICE_ZERO_READ_TEST_DESCRIPTION,
+     DeviceIoMain,
+     PtTestDeviceZeroRead,
+     PtResultIterations,
+     DEVICE_ZERO_READ_TEST_DEFAULT_DURATION},
+
+    {PTY_RAW_TEST_NAME,
+     PTY_RAW_TEST_DESCRIPTION,
+     PtyIoMain,
+     PtTestPtyRaw,
+     PtResultIterations,
+     PTY_RAW_TEST_DEFAULT_DURATION},
+
+    {PTY_COOKED_TEST_NAME,
+     PTY_COOKED_TEST_DESCRIPTION,
+     PtyIoMain,
+     PtTestPtyCooked,
+     PtResultIterations,
+     PTY_COOKED_TEST_DEFAULT_DURATION},
+
+    {PAGE_CACHE_HIT_TEST_NAME,
+     PAGE_CACHE_HIT_TEST_DESCRIPTION,
+     PageCacheMain,
+     PtTestPageCacheHit,
+     PtResultBytes,
+     PAGE_CACHE_HIT_TEST_DEFAULT_DURATION},
+
+    {PAGE_CACHE_MISS_TEST_NAME,
+     PAGE_CACHE_MISS_TEST_DESCRIPTION,
+     PageCacheMain,
+     PtTestPageCacheMiss,
+     PtResultBytes,
+     PAGE_CACHE_MISS_TEST_DEFAULT_DURATION},
+
+    {WAKEUP_PIPE_TEST_NAME,
+     WAKEUP_PIPE_TEST_DESCRIPTION,
+     WakeupMain,
+     PtTestWakeupPipe,
+     PtResultIterations,
+     WAKEUP_PIPE_TEST_DEFAULT_DURATION},
+
+    {WAKEUP_CONDITION_TEST_NAME,
+     WAKEUP_CONDITION_TEST_DESCRIPTION,
+     WakeupMain,
+     PtTestWakeupCondition,
+     PtResultIterations,
+     WAKEUP_CONDITION_TEST_DEFAULT_DURATION},
+
+    {RANDOM_DEVICE_TEST_NAME,
+     RANDOM_DEVICE_TEST_DESCRIPTION,
+     RandomMain,
+     PtTestRandomDevice,
+     PtResultBytes,
+     RANDOM_DEVICE_TEST_DEFAULT_DURATION},
+
+    {RANDOM_GETRANDOM_TEST_NAME,
+     RANDOM_GETRANDOM_TEST_DESCRIPTION,
+     RandomMain,
+     PtTestRandomGetrandom,
+     PtResultBytes,
+     RANDOM_GETRANDOM_TEST_DEFAULT_DURATION},
+
+    {RANDOM_ARC4RANDOM_TEST_NAME,
+     RANDOM_ARC4RANDOM_TEST_DESCRIPTION,
+     RandomMain,
+     PtTestRandomArc4random,
+     PtResultBytes,
+     RANDOM_ARC4RANDOM_TEST_DEFAULT_DURATION},
 };
 
 //
@@ -443,6 +616,12 @@ char *PtProgramPath;
 
 PT_RESULT_FORMAT PtResultFormat = PtResultFormatDefault;
 
+//
+// Store the number of results written so far in the JSON format.
+//
+
+long PtJsonResultCount;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -477,14 +656,20 @@ Return Value:
 {
 
     char *AfterScan;
+    char *CompareBaseline;
     time_t Duration;
     int Failures;
     int Index;
+    int JsonStarted;
     int Option;
     long ProcessCount;
+    int ProcessCountSet;
     PT_TEST_TYPE RequestedTest;
     char *ResultFilePath;
     int Status;
+    int Sweep;
+    long SweepCount;
+    double Threshold;
 
     PtProgramPath = Arguments[0];
 
@@ -498,12 +683,17 @@ Return Value:
         return ExecLoop(ArgumentCount, Arguments);
     }
 
+    CompareBaseline = NULL;
     Duration = 0;
     Failures = 0;
+    JsonStarted = 0;
     ProcessCount = PT_DEFAULT_PROCESS_COUNT;
+    ProcessCountSet = 0;
     RequestedTest = PT_DEFAULT_TEST;
     ResultFilePath = NULL;
     Status = 0;
+    Sweep = 0;
+    Threshold = PT_DEFAULT_COMPARE_THRESHOLD;
     setvbuf(stdout, NULL, _IONBF, 0);
     setvbuf(stderr, NULL, _IONBF, 0);
 
@@ -536,6 +726,7 @@ Return Value:
                 goto MainEnd;
             }
 
+            ProcessCountSet = 1;
             break;
 
         case 'd':
@@ -577,6 +768,28 @@ Return Value:
             PtResultFormat = PtResultFormatSummary;
             break;
 
+        case 'j':
+            PtResultFormat = PtResultFormatJson;
+            break;
+
+        case 'S':
+            Sweep = 1;
+            break;
+
+        case 'c':
+            CompareBaseline = optarg;
+            break;
+
+        case 'T':
+            Threshold = strtod(optarg, &AfterScan);
+            if ((Threshold < 0) || (AfterScan == optarg)) {
+                PT_PRINT_ERROR("Invalid threshold: %s.\n", optarg);
+                Status = EINVAL;
+                goto MainEnd;
+            }
+
+            break;
+
         case 'r':
             ResultFilePath = optarg;
             break;
@@ -609,6 +822,32 @@ Return Value:
         }
     }
 
+    //
+    // Comparing two sets of results doesn't run anything.
+    //
+
+    if (CompareBaseline != NULL) {
+        if (optind != ArgumentCount - 1) {
+            PT_PRINT_ERROR("Compare needs exactly one results file.\n");
+            Status = EINVAL;
+            goto MainEnd;
+        }
+
+        return PtCompareResults(CompareBaseline, Arguments[optind], Threshold);
+    }
+
+    //
+    // A sweep runs up to the process count, which defaults to the number of
+    // processors.
+    //
+
+    if ((Sweep != 0) && (ProcessCountSet == 0)) {
+        ProcessCount = sysconf(_SC_NPROCESSORS_ONLN);
+        if (ProcessCount <= 0) {
+            ProcessCount = 1;
+        }
+    }
+
     //
     // Attempt to open the result file.
     //
@@ -624,6 +863,14 @@ Return Value:
         PtResultFile = stdout;
     }
 
+    if (PtResultFormat == PtResultFormatJson) {
+        PT_PRINT_RESULT("{\n  \"version\": \"%d.%d\",\n  \"results\": [\n",
+                        PT_VERSION_MAJOR,
+                        PT_VERSION_MINOR);
+
+        JsonStarted = 1;
+    }
+
     //
     // Run each of the requested tests with the requested number of threads.
     //
@@ -641,9 +888,30 @@ Return Value:
                 PerformanceTests[Index].Duration = Duration;
             }
 
-            PtpRunPerformanceTest(&(PerformanceTests[Index]),
-                                  ProcessCount,
-                                  &Failures);
+            //
+            // Run the test once with the requested process count, or with
+            // doubling process counts up to it for a sweep.
+            //
+
+            SweepCount = ProcessCount;
+            if (Sweep != 0) {
+                SweepCount = 1;
+            }
+
+            while (1) {
+                PtpRunPerformanceTest(&(PerformanceTests[Index]),
+                                      SweepCount,
+                                      &Failures);
+
+                if (SweepCount >= ProcessCount) {
+                    break;
+                }
+
+                SweepCount *= 2;
+                if (SweepCount > ProcessCount) {
+                    SweepCount = ProcessCount;
+                }
+            }
         }
     }
 
@@ -656,6 +924,10 @@ Return Value:
         PT_PRINT_ERROR("\n   *** %d failures in perftest ***\n", Failures);
     }
 
+    if (JsonStarted != 0) {
+        PT_PRINT_RESULT("\n  ]\n}\n");
+    }
+
     if ((PtResultFile != NULL) && (PtResultFile != stdout)) {
         fclose(PtResultFile);
     }
@@ -722,6 +994,13 @@ Return Value:
              ProcessCount,
              (signed long long)Test->Duration);
 
+    //
+    // Flush any buffered results first, otherwise every child inherits a copy
+    // and writes it out again when it exits.
+    //
+
+    fflush(PtResultFile);
+
     //
     // Fork off the desired number of processes to run the test in parallel.
     //
@@ -918,14 +1197,8 @@ Return Value:
 
 {
 
-    double Average;
-    double AverageDurationMicroseconds;
-    double Frequency;
     int Index;
-    unsigned long long Microseconds;
-    PPT_PROCESS Process;
-    PT_TEST_RESULT TotalResult;
-    long ValidProcessCount;
+    PT_TEST_SUMMARY Summary;
 
     assert(ProcessCount > 0);
 
@@ -943,71 +1216,166 @@ Return Value:
     //
 
     case PtResultFormatSummary:
+        PtpSummarizeTestResults(Test, Processes, ProcessCount, &Summary);
 
         //
-        // Collect the average value and print the result based on the type.
+        // If not all of the processes succeeded, don't count the result. The
+        // summary is only valid if all of the processes succeed.
         //
 
-        ValidProcessCount = 0;
-        memset(&TotalResult, 0, sizeof(PT_TEST_RESULT));
-        for (Index = 0; Index < ProcessCount; Index += 1) {
-            Process = &(Processes[Index]);
+        if (Summary.ValidProcessCount != ProcessCount) {
+            break;
+        }
 
-            assert(Process->Result.Type == Test->ResultType);
+        PT_PRINT_RESULT("%s (%ldp):decimal:%.3f\n",
+                        Test->Name,
+                        ProcessCount,
+                        Summary.Rate);
 
-            if (Process->Result.Status != 0) {
-                PT_PRINT_ERROR("%s test: failed: %s\n",
-                               Test->Name,
-                               strerror(Process->Result.Status));
+        if (Summary.ResourceUsageValid == 0) {
+            break;
+        }
 
-                continue;
-            }
+        PT_PRINT_RESULT("%s (%ldp) User Time %%:decimal:%.02f\n",
+                        Test->Name,
+                        ProcessCount,
+                        Summary.UserPercent);
 
-            switch (Test->ResultType) {
-            case PtResultIterations:
-                TotalResult.Data.Iterations += Process->Result.Data.Iterations;
-                break;
+        PT_PRINT_RESULT("%s (%ldp) Kernel Time %%:decimal:%.02f\n",
+                        Test->Name,
+                        ProcessCount,
+                        Summary.KernelPercent);
 
-            case PtResultBytes:
-                TotalResult.Data.Bytes += Process->Result.Data.Iterations;
-                break;
+        break;
 
-            default:
+    //
+    // The JSON format prints one object per line within the results array, so
+    // that result files can be compared mechanically later.
+    //
 
-                assert(0);
+    case PtResultFormatJson:
+        PtpSummarizeTestResults(Test, Processes, ProcessCount, &Summary);
+        PT_PRINT_RESULT("%s    {\"test\": \"%s\", \"processes\": %ld, "
+                        "\"seconds\": %lld, \"type\": \"%s\", "
+                        "\"failed_processes\": %ld, \"rate\": %.3f",
+                        (PtJsonResultCount != 0) ? ",\n" : "",
+                        Test->Name,
+                        ProcessCount,
+                        (signed long long)Test->Duration,
+                        PtResultTypeStrings[Test->ResultType],
+                        ProcessCount - Summary.ValidProcessCount,
+                        Summary.Rate);
+
+        if (Summary.ResourceUsageValid != 0) {
+            PT_PRINT_RESULT(", \"user_percent\": %.2f, "
+                            "\"kernel_percent\": %.2f",
+                            Summary.UserPercent,
+                            Summary.KernelPercent);
+        }
 
-                return;
-            }
+        PT_PRINT_RESULT("}");
+        PtJsonResultCount += 1;
+        break;
 
-            ValidProcessCount += 1;
-        }
+    //
+    // The default result format prints detailed information for each process.
+    //
+
+    case PtResultFormatDefault:
+    default:
 
         //
-        // If not all of the processes succeeded, don't count the result. The
-        // summary is only valid if all of the processes succeed.
+        // Mark the start of the test in the results file.
         //
 
-        if (ValidProcessCount != ProcessCount) {
-            PT_PRINT_ERROR("%s test: %ld out of %ld processes failed.\n",
-                           Test->Name,
-                           ProcessCount - ValidProcessCount,
-                           ProcessCount);
-
-            break;
-        }
+        PT_PRINT_RESULT("Test Name: %s\n"
+                        "Process Count: %ld\n"
+                        "Seconds: %lld\n"
+                        "Result Type: %s\n"
+                        "Results:\n",
+                        Test->Name,
+                        ProcessCount,
+                        (signed long long)Test->Duration,
+                        PtResultTypeStrings[Test->ResultType]);
 
         //
-        // If all of the process had a valid result, report the summary as the
-        // average result value over the duration of the tests.
+        // Print all the processes' results.
         //
 
+        for (Index = 0; Index < ProcessCount; Index += 1) {
+            PtpPrintTestResult(&(Processes[Index].Result));
+        }
+
+        PT_PRINT_RESULT("\n");
+        break;
+    }
+
+    return;
+}
+
+void
+PtpSummarizeTestResults (
+    PPT_TEST_INFORMATION Test,
+    PPT_PROCESS Processes,
+    long ProcessCount,
+    PPT_TEST_SUMMARY Summary
+    )
+
+/*++
+
+Routine Description:
+
+    This routine averages the results of all the processes that ran a test.
+    Failed processes are reported as errors.
+
+Arguments:
+
+    Test - Supplies a pointer to the test whose results are to be summarized.
+
+    Processes - Supplies a pointer to an array of processes that ran the test.
+
+    ProcessCount - Supplies the number of processes that ran the test.
+
+    Summary - Supplies a pointer where the summary will be returned. The rate
+        and usage values are only valid if every process succeeded.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    double Average;
+    double AverageDurationMicroseconds;
+    int Index;
+    unsigned long long Microseconds;
+    PPT_PROCESS Process;
+    PT_TEST_RESULT TotalResult;
+
+    memset(Summary, 0, sizeof(PT_TEST_SUMMARY));
+    memset(&TotalResult, 0, sizeof(PT_TEST_RESULT));
+    for (Index = 0; Index < ProcessCount; Index += 1) {
+        Process = &(Processes[Index]);
+
+        assert(Process->Result.Type == Test->ResultType);
+
+        if (Process->Result.Status != 0) {
+            PT_PRINT_ERROR("%s test: failed: %s\n",
+                           Test->Name,
+                           strerror(Process->Result.Status));
+
+            continue;
+        }
+
         switch (Test->ResultType) {
         case PtResultIterations:
-            Average = (double)TotalResult.Data.Iterations / ProcessCount;
+            TotalResult.Data.Iterations += Process->Result.Data.Iterations;
             break;
 
         case PtResultBytes:
-            Average = (double)TotalResult.Data.Bytes / ProcessCount;
+            TotalResult.Data.Bytes += Process->Result.Data.Bytes;
             break;
 
         default:
@@ -1017,124 +1385,107 @@ Return Value:
             return;
         }
 
-        assert(Test->Duration > 0);
+        Summary->ValidProcessCount += 1;
+    }
 
-        Frequency = (double)Average / (double)(Test->Duration);
-        PT_PRINT_RESULT("%s (%ldp):decimal:%.3f\n",
-                        Test->Name,
-                        ProcessCount,
-                        Frequency);
+    if (Summary->ValidProcessCount != ProcessCount) {
+        PT_PRINT_ERROR("%s test: %ld out of %ld processes failed.\n",
+                       Test->Name,
+                       ProcessCount - Summary->ValidProcessCount,
+                       ProcessCount);
 
-        //
-        // Not every test reports resource usage data. But, knowning that all
-        // processes succeeded, if the first process reports it, then all
-        // processes should have successfully reported it.
-        //
+        return;
+    }
 
-        if (Processes[0].Result.ResourceUsageValid == 0) {
-            break;
-        }
+    //
+    // If all of the process had a valid result, report the summary as the
+    // average result value over the duration of the tests.
+    //
 
-        //
-        // Collect the total resource usage in order to take an average.
-        //
+    switch (Test->ResultType) {
+    case PtResultIterations:
+        Average = (double)TotalResult.Data.Iterations / ProcessCount;
+        break;
 
-        for (Index = 0; Index < ProcessCount; Index += 1) {
-            Process = &(Processes[Index]);
+    case PtResultBytes:
+        Average = (double)TotalResult.Data.Bytes / ProcessCount;
+        break;
 
-            assert(Process->Result.ResourceUsageValid != 0);
-            assert(Process->Result.Status == 0);
+    default:
 
-            timeradd(&(TotalResult.ResourceUsage.RealTime),
-                     &(Process->Result.ResourceUsage.RealTime),
-                     &(TotalResult.ResourceUsage.RealTime));
+        assert(0);
 
-            timeradd(&(TotalResult.ResourceUsage.UserTime),
-                     &(Process->Result.ResourceUsage.UserTime),
-                     &(TotalResult.ResourceUsage.UserTime));
+        return;
+    }
 
-            timeradd(&(TotalResult.ResourceUsage.SystemTime),
-                     &(Process->Result.ResourceUsage.SystemTime),
-                     &(TotalResult.ResourceUsage.SystemTime));
-        }
+    assert(Test->Duration > 0);
 
-        assert((TotalResult.ResourceUsage.RealTime.tv_sec >= 0) &&
-               (TotalResult.ResourceUsage.RealTime.tv_usec >= 0));
+    Summary->Rate = (double)Average / (double)(Test->Duration);
 
-        assert((TotalResult.ResourceUsage.UserTime.tv_sec >= 0) &&
-               (TotalResult.ResourceUsage.UserTime.tv_usec >= 0));
+    //
+    // Not every test reports resource usage data. But, knowning that all
+    // processes succeeded, if the first process reports it, then all
+    // processes should have successfully reported it.
+    //
 
-        assert((TotalResult.ResourceUsage.SystemTime.tv_sec >= 0) &&
-               (TotalResult.ResourceUsage.SystemTime.tv_usec >= 0));
+    if (Processes[0].Result.ResourceUsageValid == 0) {
+        return;
+    }
 
-        //
-        // Report the average user and system time as a percentage of the
-        // average real time. The real time is taken from the results and not
-        // the test duration as there may have been some time between test
-        // completion and usage collection.
-        //
+    //
+    // Collect the total resource usage in order to take an average.
+    //
 
-        Microseconds = (TotalResult.ResourceUsage.RealTime.tv_sec * 1000000) +
-                       TotalResult.ResourceUsage.RealTime.tv_usec;
+    for (Index = 0; Index < ProcessCount; Index += 1) {
+        Process = &(Processes[Index]);
 
-        AverageDurationMicroseconds = (double)Microseconds /ProcessCount;
-        Microseconds = (TotalResult.ResourceUsage.UserTime.tv_sec * 1000000) +
-                       TotalResult.ResourceUsage.UserTime.tv_usec;
+        assert(Process->Result.ResourceUsageValid != 0);
+        assert(Process->Result.Status == 0);
 
-        Average = (double)Microseconds / ProcessCount;
-        Average /= AverageDurationMicroseconds;
-        Average *= 100;
-        PT_PRINT_RESULT("%s (%ldp) User Time %%:decimal:%.02f\n",
-                        Test->Name,
-                        ProcessCount,
-                        Average);
-
-        Microseconds = (TotalResult.ResourceUsage.SystemTime.tv_sec * 1000000) +
-                       TotalResult.ResourceUsage.SystemTime.tv_usec;
+        timeradd(&(TotalResult.ResourceUsage.RealTime),
+                 &(Process->Result.ResourceUsage.RealTime),
+                 &(TotalResult.ResourceUsage.RealTime));
 
-        Average = (double)Microseconds / ProcessCount;
-        Average /= AverageDurationMicroseconds;
-        Average *= 100;
-        PT_PRINT_RESULT("%s (%ldp) Kernel Time %%:decimal:%.02f\n",
-                        Test->Name,
-                        ProcessCount,
-                        Average);
+        timeradd(&(TotalResult.ResourceUsage.UserTime),
+                 &(Process->Result.ResourceUsage.UserTime),
+                 &(TotalResult.ResourceUsage.UserTime));
 
-        break;
+        timeradd(&(TotalResult.ResourceUsage.SystemTime),
+                 &(Process->Result.ResourceUsage.SystemTime),
+                 &(TotalResult.ResourceUsage.SystemTime));
+    }
 
-    //
-    // The default result format prints detailed information for each process.
-    //
+    assert((TotalResult.ResourceUsage.RealTime.tv_sec >= 0) &&
+           (TotalResult.ResourceUsage.RealTime.tv_usec >= 0));
 
-    case PtResultFormatDefault:
-    default:
+    assert((TotalResult.ResourceUsage.UserTime.tv_sec >= 0) &&
+           (TotalResult.ResourceUsage.UserTime.tv_usec >= 0));
 
-        //
-        // Mark the start of the test in the results file.
-        //
+    assert((TotalResult.ResourceUsage.SystemTime.tv_sec >= 0) &&
+           (TotalResult.ResourceUsage.SystemTime.tv_usec >= 0));
 
-        PT_PRINT_RESULT("Test Name: %s\n"
-                        "Process Count: %ld\n"
-                        "Seconds: %lld\n"
-                        "Result Type: %s\n"
-                        "Results:\n",
-                        Test->Name,
-                        ProcessCount,
-                        (signed long long)Test->Duration,
-                        PtResultTypeStrings[Test->ResultType]);
+    //
+    // Report the average user and system time as a percentage of the average
+    // real time. The real time is taken from the results and not the test
+    // duration as there may have been some time between test completion and
+    // usage collection.
+    //
 
-        //
-        // Print all the processes' results.
-        //
+    Microseconds = (TotalResult.ResourceUsage.RealTime.tv_sec * 1000000) +
+                   TotalResult.ResourceUsage.RealTime.tv_usec;
 
-        for (Index = 0; Index < ProcessCount; Index += 1) {
-            PtpPrintTestResult(&(Processes[Index].Result));
-        }
+    AverageDurationMicroseconds = (double)Microseconds / ProcessCount;
+    Microseconds = (TotalResult.ResourceUsage.UserTime.tv_sec * 1000000) +
+                   TotalResult.ResourceUsage.UserTime.tv_usec;
 
-        PT_PRINT_RESULT("\n");
-        break;
-    }
+    Average = (double)Microseconds / ProcessCount;
+    Summary->UserPercent = (Average / AverageDurationMicroseconds) * 100;
+    Microseconds = (TotalResult.ResourceUsage.SystemTime.tv_sec * 1000000) +
+                   TotalResult.ResourceUsage.SystemTime.tv_usec;
 
+    Average = (double)Microseconds / ProcessCount;
+    Summary->KernelPercent = (Average / AverageDurationMicroseconds) * 100;
+    Summary->ResourceUsageValid = 1;
     return;
 }
 
@@ -145,6 +145,74 @@ Module Name:
 #define SIGNAL_RESTART_DESCRIPTION \
     "Benchmarks how many system call restarts can be made."
 
+#define CLOCK_MONOTONIC_TEST_NAME "clock_monotonic"
+#define CLOCK_MONOTONIC_TEST_DESCRIPTION \
+    "Benchmarks clock_gettime() with CLOCK_MONOTONIC."
+
+#define CLOCK_REALTIME_TEST_NAME "clock_realtime"
+#define CLOCK_REALTIME_TEST_DESCRIPTION \
+    "Benchmarks clock_gettime() with CLOCK_REALTIME."
+
+#define GETTIMEOFDAY_TEST_NAME "gettimeofday"
+#define GETTIMEOFDAY_TEST_DESCRIPTION \
+    "Benchmarks the gettimeofday() C library routine."
+
+#define UDP_SEND_TEST_NAME "udp_send"
+#define UDP_SEND_TEST_DESCRIPTION \
+    "Benchmarks the loopback datagram rate using send() and recv()."
+
+#define UDP_BATCH_TEST_NAME "udp_batch"
+#define UDP_BATCH_TEST_DESCRIPTION \
+    "Benchmarks the loopback datagram rate using sendmmsg() and recvmmsg()."
+
+#define UDP_SEGMENT_TEST_NAME "udp_segment"
+#define UDP_SEGMENT_TEST_DESCRIPTION \
+    "Benchmarks the loopback datagram rate using UDP segmentation offload."
+
+#define DEVICE_NULL_WRITE_TEST_NAME "dev_null_write"
+#define DEVICE_NULL_WRITE_TEST_DESCRIPTION \
+    "Benchmarks the rate of small writes to /dev/null."
+
+#define DEVICE_ZERO_READ_TEST_NAME "dev_zero_read"
+#define DEVICE_ZERO_READ_TEST_DESCRIPTION \
+    "Benchmarks the rate of small reads from /dev/zero."
+
+#define PTY_RAW_TEST_NAME "pty_raw"
+#define PTY_RAW_TEST_DESCRIPTION \
+    "Benchmarks pseudo-terminal output throughput with no processing."
+
+#define PTY_COOKED_TEST_NAME "pty_cooked"
+#define PTY_COOKED_TEST_DESCRIPTION \
+    "Benchmarks pseudo-terminal output throughput with output processing."
+
+#define PAGE_CACHE_HIT_TEST_NAME "page_cache_hit"
+#define PAGE_CACHE_HIT_TEST_DESCRIPTION \
+    "Benchmarks read bandwidth from a file that is entirely cached."
+
+#define PAGE_CACHE_MISS_TEST_NAME "page_cache_miss"
+#define PAGE_CACHE_MISS_TEST_DESCRIPTION \
+    "Benchmarks read bandwidth when every read must fill the page cache."
+
+#define WAKEUP_PIPE_TEST_NAME "wakeup_pipe"
+#define WAKEUP_PIPE_TEST_DESCRIPTION \
+    "Benchmarks the rate two processes can wake each other over pipes."
+
+#define WAKEUP_CONDITION_TEST_NAME "wakeup_cond"
+#define WAKEUP_CONDITION_TEST_DESCRIPTION \
+    "Benchmarks the rate two threads can wake each other with a condvar."
+
+#define RANDOM_DEVICE_TEST_NAME "random_device"
+#define RANDOM_DEVICE_TEST_DESCRIPTION \
+    "Benchmarks read bandwidth from /dev/urandom."
+
+#define RANDOM_GETRANDOM_TEST_NAME "random_getrandom"
+#define RANDOM_GETRANDOM_TEST_DESCRIPTION \
+    "Benchmarks random byte bandwidth from the getrandom system call."
+
+#define RANDOM_ARC4RANDOM_TEST_NAME "random_arc4random"
+#define RANDOM_ARC4RANDOM_TEST_DESCRIPTION \
+    "Benchmarks random byte bandwidth from small arc4random_buf calls."
+
 //
 // Default test durations, in seconds.
 //
@@ -180,6 +248,23 @@ Module Name:
 #define SIGNAL_IGNORED_DEFAULT_DURATION 30
 #define SIGNAL_HANDLED_DEFAULT_DURATION 30
 #define SIGNAL_RESTART_DEFAULT_DURATION 30
+#define CLOCK_MONOTONIC_TEST_DEFAULT_DURATION 10
+#define CLOCK_REALTIME_TEST_DEFAULT_DURATION 10
+#define GETTIMEOFDAY_TEST_DEFAULT_DURATION 10
+#define UDP_SEND_TEST_DEFAULT_DURATION 30
+#define UDP_BATCH_TEST_DEFAULT_DURATION 30
+#define UDP_SEGMENT_TEST_DEFAULT_DURATION 30
+#define DEVICE_NULL_WRITE_TEST_DEFAULT_DURATION 10
+#define DEVICE_ZERO_READ_TEST_DEFAULT_DURATION 10
+#define PTY_RAW_TEST_DEFAULT_DURATION 30
+#define PTY_COOKED_TEST_DEFAULT_DURATION 30
+#define PAGE_CACHE_HIT_TEST_DEFAULT_DURATION 30
+#define PAGE_CACHE_MISS_TEST_DEFAULT_DURATION 30
+#define WAKEUP_PIPE_TEST_DEFAULT_DURATION 30
+#define WAKEUP_CONDITION_TEST_DEFAULT_DURATION 30
+#define RANDOM_DEVICE_TEST_DEFAULT_DURATION 10
+#define RANDOM_GETRANDOM_TEST_DEFAULT_DURATION 10
+#define RANDOM_ARC4RANDOM_TEST_DEFAULT_DURATION 10
 
 //
 // Define the number of variables supplied to an iteration of the execute test
@@ -225,6 +310,23 @@ typedef enum _PT_TEST_TYPE {
     PtTestSignalIgnored,
     PtTestSignalHandled,
     PtTestSignalRestart,
+    PtTestClockMonotonic,
+    PtTestClockRealtime,
+    PtTestGettimeofday,
+    PtTestUdpSend,
+    PtTestUdpBatch,
+    PtTestUdpSegment,
+    PtTestDeviceNullWrite,
+    PtTestDeviceZeroRead,
+    PtTestPtyRaw,
+    PtTestPtyCooked,
+    PtTestPageCacheHit,
+    PtTestPageCacheMiss,
+    PtTestWakeupPipe,
+    PtTestWakeupCondition,
+    PtTestRandomDevice,
+    PtTestRandomGetrandom,
+    PtTestRandomArc4random,
     PtTestTypeCount
 } PT_TEST_TYPE, *PPT_TEST_TYPE;
 
@@ -1021,3 +1123,213 @@ Return Value:
 
 --*/
 
+void
+ClockMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the clock read performance benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+UdpMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the UDP datagram rate benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+DeviceIoMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the device I/O request rate benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+PtyIoMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the pseudo-terminal throughput benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+PageCacheMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the page cache read bandwidth benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+WakeupMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the wakeup latency benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+void
+RandomMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+/*++
+
+Routine Description:
+
+    This routine performs the random number generator benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+//
+// Result comparison routines.
+//
+
+int
+PtCompareResults (
+    const char *BaselinePath,
+    const char *ResultPath,
+    double Threshold
+    );
+
+/*++
+
+Routine Description:
+
+    This routine compares two JSON results files and prints the change in each
+    test's rate. Every test reports a rate where larger is better.
+
+Arguments:
+
+    BaselinePath - Supplies the path to the results to compare against.
+
+    ResultPath - Supplies the path to the new results.
+
+    Threshold - Supplies the percentage change below which a difference is
+        considered noise.
+
+Return Value:
+
+    Returns the number of tests that regressed by more than the threshold.
+
+    -1 if either file could not be read.
+
+--*/
+
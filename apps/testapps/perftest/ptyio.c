@@ -0,0 +1,245 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    ptyio.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for
+    pseudo-terminal output throughput. Data is written to the slave side and
+    drained from the master side, the way a terminal emulator sees the output
+    of a busy program.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <pty.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_PTY_IO_BUFFER_SIZE 4096
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+PtyIoMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the pseudo-terminal throughput benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char *Buffer;
+    ssize_t BytesCompleted;
+    unsigned long long Iterations;
+    int Master;
+    size_t ReadSize;
+    struct termios Settings;
+    int Slave;
+    int Status;
+
+    Iterations = 0;
+    Master = -1;
+    Slave = -1;
+    Result->Type = PtResultIterations;
+    Result->Status = 0;
+
+    //
+    // Allocate a scratch buffer to use for reads and writes. Fill it with
+    // ordinary characters so that output processing never changes the number
+    // of bytes that come out the other side.
+    //
+
+    Buffer = malloc(PT_PTY_IO_BUFFER_SIZE);
+    if (Buffer == NULL) {
+        Result->Status = ENOMEM;
+        goto MainEnd;
+    }
+
+    memset(Buffer, 'a', PT_PTY_IO_BUFFER_SIZE);
+
+    //
+    // Create the terminal pair. The raw test turns off all processing. The
+    // cooked test leaves output processing on, but still disables echo and
+    // canonical input so that nothing comes back at the master.
+    //
+
+    Status = openpty(&Master, &Slave, NULL, NULL, NULL);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    Status = tcgetattr(Slave, &Settings);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    switch (Test->TestType) {
+    case PtTestPtyRaw:
+        cfmakeraw(&Settings);
+        break;
+
+    case PtTestPtyCooked:
+        Settings.c_lflag &= ~(ECHO | ICANON);
+        Settings.c_oflag |= OPOST | ONLCR;
+        break;
+
+    default:
+        Result->Status = EINVAL;
+        goto MainEnd;
+    }
+
+    Status = tcsetattr(Slave, TCSANOW, &Settings);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Measure the terminal output throughput by writing a buffer's worth to
+    // the slave and then draining it all from the master. The master may
+    // return the data in several pieces.
+    //
+
+    while (PtIsTimedTestRunning() != 0) {
+        do {
+            BytesCompleted = write(Slave, Buffer, PT_PTY_IO_BUFFER_SIZE);
+
+        } while ((BytesCompleted < 0) && (errno == EINTR));
+
+        if (BytesCompleted != PT_PTY_IO_BUFFER_SIZE) {
+            if (errno == 0) {
+                errno = EIO;
+            }
+
+            Result->Status = errno;
+            break;
+        }
+
+        ReadSize = 0;
+        while (ReadSize < PT_PTY_IO_BUFFER_SIZE) {
+            do {
+                BytesCompleted = read(Master,
+                                      Buffer + ReadSize,
+                                      PT_PTY_IO_BUFFER_SIZE - ReadSize);
+
+            } while ((BytesCompleted < 0) && (errno == EINTR));
+
+            if (BytesCompleted <= 0) {
+                if ((BytesCompleted == 0) || (errno == 0)) {
+                    errno = EIO;
+                }
+
+                Result->Status = errno;
+                break;
+            }
+
+            ReadSize += BytesCompleted;
+        }
+
+        if (Result->Status != 0) {
+            break;
+        }
+
+        Iterations += 1;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (Slave >= 0) {
+        close(Slave);
+    }
+
+    if (Master >= 0) {
+        close(Master);
+    }
+
+    if (Buffer != NULL) {
+        free(Buffer);
+    }
+
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
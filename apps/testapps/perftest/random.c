@@ -0,0 +1,194 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    random.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for random number
+    generation through the random device, the getrandom system call, and the
+    C library's buffered arc4random generator.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/random.h>
+#include <unistd.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define PT_RANDOM_DEVICE_PATH "/dev/urandom"
+
+//
+// Define the request size for the device and system call tests, and the
+// much smaller size of a typical arc4random_buf caller, like a nonce or key.
+//
+
+#define PT_RANDOM_BUFFER_SIZE 4096
+#define PT_RANDOM_ARC4RANDOM_SIZE 16
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+RandomMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the random number generator benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    char Buffer[PT_RANDOM_BUFFER_SIZE];
+    ssize_t BytesCompleted;
+    int FileDescriptor;
+    int Status;
+    unsigned long long TotalBytes;
+
+    FileDescriptor = -1;
+    Result->Type = PtResultBytes;
+    Result->Status = 0;
+    TotalBytes = 0;
+    switch (Test->TestType) {
+    case PtTestRandomDevice:
+        FileDescriptor = open(PT_RANDOM_DEVICE_PATH, O_RDONLY);
+        if (FileDescriptor < 0) {
+            Result->Status = errno;
+            goto MainEnd;
+        }
+
+        break;
+
+    case PtTestRandomGetrandom:
+    case PtTestRandomArc4random:
+        break;
+
+    default:
+        fprintf(stderr, "Unknown random test type %d\n", Test->TestType);
+        Result->Status = EINVAL;
+        goto MainEnd;
+    }
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    while (PtIsTimedTestRunning() != 0) {
+        switch (Test->TestType) {
+        case PtTestRandomDevice:
+            BytesCompleted = read(FileDescriptor,
+                                  Buffer,
+                                  PT_RANDOM_BUFFER_SIZE);
+
+            break;
+
+        case PtTestRandomGetrandom:
+            BytesCompleted = getrandom(Buffer, PT_RANDOM_BUFFER_SIZE, 0);
+            break;
+
+        case PtTestRandomArc4random:
+        default:
+            arc4random_buf(Buffer, PT_RANDOM_ARC4RANDOM_SIZE);
+            BytesCompleted = PT_RANDOM_ARC4RANDOM_SIZE;
+            break;
+        }
+
+        if (BytesCompleted <= 0) {
+            if (BytesCompleted < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+            } else {
+                errno = EIO;
+            }
+
+            Result->Status = errno;
+            break;
+        }
+
+        TotalBytes += (unsigned long long)BytesCompleted;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (FileDescriptor >= 0) {
+        close(FileDescriptor);
+    }
+
+    Result->Data.Bytes = TotalBytes;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
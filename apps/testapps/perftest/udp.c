@@ -0,0 +1,503 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    udp.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for the UDP
+    datagram rate. There is no loopback interface, so the datagrams are sent
+    to a multicast group with multicast loopback enabled, which sends them
+    back up the stack before they go out on the wire.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the size of each datagram and the number of datagrams sent in each
+// round.
+//
+
+#define PT_UDP_DATAGRAM_SIZE 64
+#define PT_UDP_BATCH_SIZE 32
+
+//
+// Define the administratively scoped multicast group the datagrams are sent
+// to.
+//
+
+#define PT_UDP_GROUP_ADDRESS "239.255.80.84"
+
+//
+// Define how long the receiver waits for a datagram before deciding it was
+// dropped, in seconds.
+//
+
+#define PT_UDP_RECEIVE_TIMEOUT 1
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+int
+PtpUdpCreateSockets (
+    int *Sender,
+    int *Receiver
+    );
+
+int
+PtpUdpReceive (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int Count,
+    int Batch
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+UdpMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the UDP datagram rate benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    int Batch;
+    char Buffer[PT_UDP_DATAGRAM_SIZE * PT_UDP_BATCH_SIZE];
+    ssize_t BytesCompleted;
+    int Index;
+    unsigned long long Iterations;
+    struct mmsghdr Messages[PT_UDP_BATCH_SIZE];
+    int Receiver;
+    int Received;
+    int SegmentSize;
+    int Sender;
+    int Sent;
+    int Status;
+    struct iovec Vectors[PT_UDP_BATCH_SIZE];
+
+    Iterations = 0;
+    Receiver = -1;
+    Sender = -1;
+    Result->Type = PtResultIterations;
+    Result->Status = 0;
+    memset(Buffer, 0, sizeof(Buffer));
+    memset(Messages, 0, sizeof(Messages));
+    for (Index = 0; Index < PT_UDP_BATCH_SIZE; Index += 1) {
+        Vectors[Index].iov_base = Buffer + (Index * PT_UDP_DATAGRAM_SIZE);
+        Vectors[Index].iov_len = PT_UDP_DATAGRAM_SIZE;
+        Messages[Index].msg_hdr.msg_iov = &(Vectors[Index]);
+        Messages[Index].msg_hdr.msg_iovlen = 1;
+    }
+
+    Status = PtpUdpCreateSockets(&Sender, &Receiver);
+    if (Status != 0) {
+        Result->Status = Status;
+        goto MainEnd;
+    }
+
+    Batch = 1;
+    switch (Test->TestType) {
+    case PtTestUdpSend:
+        Batch = 0;
+        break;
+
+    case PtTestUdpBatch:
+        break;
+
+    case PtTestUdpSegment:
+        SegmentSize = PT_UDP_DATAGRAM_SIZE;
+        Status = setsockopt(Sender,
+                            IPPROTO_UDP,
+                            UDP_SEGMENT,
+                            &SegmentSize,
+                            sizeof(SegmentSize));
+
+        if (Status != 0) {
+            Result->Status = errno;
+            goto MainEnd;
+        }
+
+        break;
+
+    default:
+        fprintf(stderr, "Unknown UDP test type %d\n", Test->TestType);
+        Result->Status = EINVAL;
+        goto MainEnd;
+    }
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto MainEnd;
+    }
+
+    //
+    // Each round sends a batch of datagrams and then receives them back. The
+    // iteration count is the number of datagrams that made the round trip.
+    //
+
+    while (PtIsTimedTestRunning() != 0) {
+        switch (Test->TestType) {
+        case PtTestUdpSend:
+            for (Sent = 0; Sent < PT_UDP_BATCH_SIZE; Sent += 1) {
+                do {
+                    BytesCompleted = send(Sender,
+                                          Vectors[Sent].iov_base,
+                                          PT_UDP_DATAGRAM_SIZE,
+                                          0);
+
+                } while ((BytesCompleted < 0) && (errno == EINTR));
+
+                if (BytesCompleted < 0) {
+                    break;
+                }
+            }
+
+            break;
+
+        case PtTestUdpBatch:
+            Sent = 0;
+            while (Sent < PT_UDP_BATCH_SIZE) {
+                Status = sendmmsg(Sender,
+                                  &(Messages[Sent]),
+                                  PT_UDP_BATCH_SIZE - Sent,
+                                  0);
+
+                if (Status < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    break;
+                }
+
+                Sent += Status;
+            }
+
+            break;
+
+        case PtTestUdpSegment:
+        default:
+            do {
+                BytesCompleted = send(Sender, Buffer, sizeof(Buffer), 0);
+
+            } while ((BytesCompleted < 0) && (errno == EINTR));
+
+            Sent = 0;
+            if (BytesCompleted > 0) {
+                Sent = PT_UDP_BATCH_SIZE;
+            }
+
+            break;
+        }
+
+        if (Sent == 0) {
+            Result->Status = errno;
+            break;
+        }
+
+        Received = PtpUdpReceive(Receiver, Messages, Sent, Batch);
+        if (Received < 0) {
+            Result->Status = errno;
+            break;
+        }
+
+        Iterations += Received;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+MainEnd:
+    if (Sender >= 0) {
+        close(Sender);
+    }
+
+    if (Receiver >= 0) {
+        close(Receiver);
+    }
+
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+int
+PtpUdpCreateSockets (
+    int *Sender,
+    int *Receiver
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a receiving socket that has joined the test's
+    multicast group and a sending socket connected to it that loops its
+    datagrams back.
+
+Arguments:
+
+    Sender - Supplies a pointer where the sending socket will be returned.
+
+    Receiver - Supplies a pointer where the receiving socket will be returned.
+
+Return Value:
+
+    0 on success.
+
+    Returns an error number on failure.
+
+--*/
+
+{
+
+    struct sockaddr_in Address;
+    socklen_t AddressLength;
+    int Loop;
+    struct ip_mreq Request;
+    int Status;
+    struct timeval Timeout;
+
+    *Receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    if (*Receiver < 0) {
+        return errno;
+    }
+
+    memset(&Address, 0, sizeof(Address));
+    Address.sin_family = AF_INET;
+    Address.sin_addr.s_addr = htonl(INADDR_ANY);
+    Status = bind(*Receiver, (struct sockaddr *)&Address, sizeof(Address));
+    if (Status != 0) {
+        return errno;
+    }
+
+    AddressLength = sizeof(Address);
+    Status = getsockname(*Receiver,
+                         (struct sockaddr *)&Address,
+                         &AddressLength);
+
+    if (Status != 0) {
+        return errno;
+    }
+
+    memset(&Request, 0, sizeof(Request));
+    Request.imr_multiaddr.s_addr = inet_addr(PT_UDP_GROUP_ADDRESS);
+    Request.imr_interface.s_addr = htonl(INADDR_ANY);
+    Status = setsockopt(*Receiver,
+                        IPPROTO_IP,
+                        IP_ADD_MEMBERSHIP,
+                        &Request,
+                        sizeof(Request));
+
+    if (Status != 0) {
+        return errno;
+    }
+
+    //
+    // Don't let a dropped datagram hang the test forever.
+    //
+
+    Timeout.tv_sec = PT_UDP_RECEIVE_TIMEOUT;
+    Timeout.tv_usec = 0;
+    Status = setsockopt(*Receiver,
+                        SOL_SOCKET,
+                        SO_RCVTIMEO,
+                        &Timeout,
+                        sizeof(Timeout));
+
+    if (Status != 0) {
+        return errno;
+    }
+
+    *Sender = socket(AF_INET, SOCK_DGRAM, 0);
+    if (*Sender < 0) {
+        return errno;
+    }
+
+    Loop = 1;
+    Status = setsockopt(*Sender,
+                        IPPROTO_IP,
+                        IP_MULTICAST_LOOP,
+                        &Loop,
+                        sizeof(Loop));
+
+    if (Status != 0) {
+        return errno;
+    }
+
+    Address.sin_addr = Request.imr_multiaddr;
+    Status = connect(*Sender, (struct sockaddr *)&Address, sizeof(Address));
+    if (Status != 0) {
+        return errno;
+    }
+
+    return 0;
+}
+
+int
+PtpUdpReceive (
+    int Socket,
+    struct mmsghdr *Messages,
+    unsigned int Count,
+    int Batch
+    )
+
+/*++
+
+Routine Description:
+
+    This routine receives the datagrams sent in a round of the test.
+
+Arguments:
+
+    Socket - Supplies the receiving socket.
+
+    Messages - Supplies an array of messages to receive into.
+
+    Count - Supplies the number of datagrams that were sent.
+
+    Batch - Supplies a boolean indicating whether to receive the datagrams
+        with recvmmsg (non-zero) or one at a time with recv (zero).
+
+Return Value:
+
+    Returns the number of datagrams received, which may be less than the count
+    if some were dropped.
+
+    -1 on failure, and errno will be set to contain more information.
+
+--*/
+
+{
+
+    ssize_t BytesCompleted;
+    unsigned int Received;
+    int Status;
+
+    Received = 0;
+    while (Received < Count) {
+        if (Batch != 0) {
+            Status = recvmmsg(Socket,
+                              &(Messages[Received]),
+                              Count - Received,
+                              MSG_WAITFORONE,
+                              NULL);
+
+        } else {
+            BytesCompleted = recv(Socket,
+                                  Messages[Received].msg_hdr.msg_iov->iov_base,
+                                  PT_UDP_DATAGRAM_SIZE,
+                                  0);
+
+            Status = 1;
+            if (BytesCompleted < 0) {
+                Status = -1;
+            }
+        }
+
+        if (Status < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            //
+            // A timeout means the rest of the datagrams were dropped. That's
+            // only a failure if none of them made it.
+            //
+
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK) ||
+                (errno == ETIME)) {
+
+                if (Received == 0) {
+                    errno = ETIMEDOUT;
+                    return -1;
+                }
+
+                break;
+            }
+
+            return -1;
+        }
+
+        Received += Status;
+    }
+
+    return Received;
+}
+
@@ -0,0 +1,451 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    wakeup.c
+
+Abstract:
+
+    This module implements the performance benchmark tests for scheduler
+    wakeup latency. Two parties take turns blocking and waking each other, so
+    each iteration is two full sleep and wake cycles.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "perftest.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines the state shared by the two threads of the
+    condition variable wakeup test.
+
+Members:
+
+    Mutex - Stores the mutex protecting the structure.
+
+    Condition - Stores the condition variable both threads wait on.
+
+    Turn - Stores 1 if it is the worker thread's turn to run, or 0 if it is
+        the main thread's turn.
+
+    Stop - Stores a boolean indicating whether the worker should exit.
+
+--*/
+
+typedef struct _PT_WAKEUP_CONTEXT {
+    pthread_mutex_t Mutex;
+    pthread_cond_t Condition;
+    int Turn;
+    int Stop;
+} PT_WAKEUP_CONTEXT, *PPT_WAKEUP_CONTEXT;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+void
+PtpWakeupPipe (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+void
+PtpWakeupCondition (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    );
+
+void *
+PtpWakeupConditionThread (
+    void *Parameter
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+void
+WakeupMain (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs the wakeup latency benchmark tests.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    Result->Type = PtResultIterations;
+    Result->Status = 0;
+    Result->Data.Iterations = 0;
+    switch (Test->TestType) {
+    case PtTestWakeupPipe:
+        PtpWakeupPipe(Test, Result);
+        break;
+
+    case PtTestWakeupCondition:
+        PtpWakeupCondition(Test, Result);
+        break;
+
+    default:
+        fprintf(stderr, "Unknown wakeup test type %d\n", Test->TestType);
+        Result->Status = EINVAL;
+        break;
+    }
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+void
+PtpWakeupPipe (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine bounces a byte back and forth between this process and a
+    child over a pair of pipes.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ssize_t BytesCompleted;
+    char Character;
+    pid_t Child;
+    int ChildStatus;
+    unsigned long long Iterations;
+    int Request[2];
+    int Response[2];
+    int Status;
+
+    Child = -1;
+    Character = 0;
+    Iterations = 0;
+    Request[0] = -1;
+    Request[1] = -1;
+    Response[0] = -1;
+    Response[1] = -1;
+    if ((pipe(Request) != 0) || (pipe(Response) != 0)) {
+        Result->Status = errno;
+        goto WakeupPipeEnd;
+    }
+
+    Child = fork();
+    if (Child < 0) {
+        Result->Status = errno;
+        goto WakeupPipeEnd;
+    }
+
+    //
+    // The child echoes every byte back until the parent closes its end.
+    //
+
+    if (Child == 0) {
+        close(Request[1]);
+        close(Response[0]);
+        while (1) {
+            do {
+                BytesCompleted = read(Request[0], &Character, 1);
+
+            } while ((BytesCompleted < 0) && (errno == EINTR));
+
+            if (BytesCompleted != 1) {
+                break;
+            }
+
+            do {
+                BytesCompleted = write(Response[1], &Character, 1);
+
+            } while ((BytesCompleted < 0) && (errno == EINTR));
+
+            if (BytesCompleted != 1) {
+                break;
+            }
+        }
+
+        _exit(0);
+    }
+
+    close(Request[0]);
+    Request[0] = -1;
+    close(Response[1]);
+    Response[1] = -1;
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto WakeupPipeEnd;
+    }
+
+    while (PtIsTimedTestRunning() != 0) {
+        do {
+            BytesCompleted = write(Request[1], &Character, 1);
+
+        } while ((BytesCompleted < 0) && (errno == EINTR));
+
+        if (BytesCompleted == 1) {
+            do {
+                BytesCompleted = read(Response[0], &Character, 1);
+
+            } while ((BytesCompleted < 0) && (errno == EINTR));
+        }
+
+        if (BytesCompleted != 1) {
+            if ((BytesCompleted == 0) || (errno == 0)) {
+                errno = EIO;
+            }
+
+            Result->Status = errno;
+            break;
+        }
+
+        Iterations += 1;
+    }
+
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+WakeupPipeEnd:
+    if (Request[1] >= 0) {
+        close(Request[1]);
+    }
+
+    if (Request[0] >= 0) {
+        close(Request[0]);
+    }
+
+    if (Response[1] >= 0) {
+        close(Response[1]);
+    }
+
+    if (Response[0] >= 0) {
+        close(Response[0]);
+    }
+
+    if (Child > 0) {
+        Status = waitpid(Child, &ChildStatus, 0);
+        if ((Status != Child) && (Result->Status == 0)) {
+            Result->Status = ECHILD;
+        }
+    }
+
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+void
+PtpWakeupCondition (
+    PPT_TEST_INFORMATION Test,
+    PPT_TEST_RESULT Result
+    )
+
+/*++
+
+Routine Description:
+
+    This routine bounces a turn back and forth between this thread and a
+    worker thread using a condition variable, which exercises the user mode
+    wait and wake path.
+
+Arguments:
+
+    Test - Supplies a pointer to the performance test being executed.
+
+    Result - Supplies a pointer to a performance test result structure that
+        receives the tests results.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PT_WAKEUP_CONTEXT Context;
+    unsigned long long Iterations;
+    int Status;
+    pthread_t Thread;
+    int ThreadCreated;
+
+    Iterations = 0;
+    ThreadCreated = 0;
+    Context.Turn = 0;
+    Context.Stop = 0;
+    pthread_mutex_init(&(Context.Mutex), NULL);
+    pthread_cond_init(&(Context.Condition), NULL);
+    Status = pthread_create(&Thread,
+                            NULL,
+                            PtpWakeupConditionThread,
+                            &Context);
+
+    if (Status != 0) {
+        Result->Status = Status;
+        goto WakeupConditionEnd;
+    }
+
+    ThreadCreated = 1;
+
+    //
+    // Start the test. This snaps resource usage and starts the clock ticking.
+    //
+
+    Status = PtStartTimedTest(Test->Duration);
+    if (Status != 0) {
+        Result->Status = errno;
+        goto WakeupConditionEnd;
+    }
+
+    pthread_mutex_lock(&(Context.Mutex));
+    while (PtIsTimedTestRunning() != 0) {
+        Context.Turn = 1;
+        pthread_cond_signal(&(Context.Condition));
+        while (Context.Turn != 0) {
+            pthread_cond_wait(&(Context.Condition), &(Context.Mutex));
+        }
+
+        Iterations += 1;
+    }
+
+    pthread_mutex_unlock(&(Context.Mutex));
+    Status = PtFinishTimedTest(Result);
+    if ((Status != 0) && (Result->Status == 0)) {
+        Result->Status = errno;
+    }
+
+WakeupConditionEnd:
+    if (ThreadCreated != 0) {
+        pthread_mutex_lock(&(Context.Mutex));
+        Context.Stop = 1;
+        pthread_cond_signal(&(Context.Condition));
+        pthread_mutex_unlock(&(Context.Mutex));
+        pthread_join(Thread, NULL);
+    }
+
+    pthread_cond_destroy(&(Context.Condition));
+    pthread_mutex_destroy(&(Context.Mutex));
+    Result->Data.Iterations = Iterations;
+    return;
+}
+
+void *
+PtpWakeupConditionThread (
+    void *Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the worker thread of the condition variable
+    wakeup test. It hands the turn straight back every time it gets it.
+
+Arguments:
+
+    Parameter - Supplies a pointer to the shared wakeup context.
+
+Return Value:
+
+    NULL always.
+
+--*/
+
+{
+
+    PPT_WAKEUP_CONTEXT Context;
+
+    Context = Parameter;
+    pthread_mutex_lock(&(Context->Mutex));
+    while (Context->Stop == 0) {
+        if (Context->Turn != 0) {
+            Context->Turn = 0;
+            pthread_cond_signal(&(Context->Condition));
+        }
+
+        pthread_cond_wait(&(Context->Condition), &(Context->Mutex));
+    }
+
+    pthread_mutex_unlock(&(Context->Mutex));
+    return NULL;
+}
+
@@ -0,0 +1,596 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    sndlat.c
+
+Abstract:
+
+    This module implements the sound latency test, which plays a tone through
+    a memory mapped sound output buffer and measures how long it takes to
+    wake up after each fragment completes.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    User
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/lib/minocaos.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/soundcard.h>
+#include <unistd.h>
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+#define PRINT_ERROR(...) fprintf(stderr, "sndlat: " __VA_ARGS__)
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define SOUND_LATENCY_VERSION_MAJOR 1
+#define SOUND_LATENCY_VERSION_MINOR 0
+
+#define SOUND_LATENCY_USAGE                                                    \
+    "Usage: sndlat [options] device\n"                                         \
+    "This utility plays a tone through a memory mapped sound output device \n" \
+    "and measures how late the player wakes up after each fragment. \n"        \
+    "Options are:\n"                                                           \
+    "  -f, --fragment-size <bytes> -- Set the fragment size, which must be \n" \
+    "      a power of two. The default is 1024.\n"                             \
+    "  -c, --fragment-count <count> -- Set the number of fragments in the \n"  \
+    "      buffer. The default is 4.\n"                                        \
+    "  -i, --iterations <count> -- Set the number of fragments to play.\n"     \
+    "  -r, --rate <hz> -- Set the sample rate. The default is 48000.\n"        \
+    "  -v, --verbose -- Print the latency of every fragment.\n"                \
+    "  --help -- Print this help text and exit.\n"                             \
+    "  --version -- Print the test version and exit.\n"                        \
+
+#define SOUND_LATENCY_OPTIONS_STRING "f:c:i:r:vhV"
+
+#define DEFAULT_FRAGMENT_SIZE 1024
+#define DEFAULT_FRAGMENT_COUNT 4
+#define DEFAULT_ITERATIONS 1000
+#define DEFAULT_SAMPLE_RATE 48000
+
+#define SOUND_LATENCY_CHANNELS 2
+#define SOUND_LATENCY_TONE_HZ 440
+#define SOUND_LATENCY_TONE_AMPLITUDE 4096
+
+#define MICROSECONDS_PER_SECOND 1000000ULL
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+SoundLatencyReadStatus (
+    volatile dsp_mmap_status *Status,
+    dsp_mmap_status *Copy
+    );
+
+VOID
+SoundLatencyFillFragment (
+    PUCHAR Fragment,
+    ULONG Size,
+    ULONG Rate,
+    PULONGLONG Phase
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+struct option SoundLatencyLongOptions[] = {
+    {"fragment-size", required_argument, 0, 'f'},
+    {"fragment-count", required_argument, 0, 'c'},
+    {"iterations", required_argument, 0, 'i'},
+    {"rate", required_argument, 0, 'r'},
+    {"verbose", no_argument, 0, 'v'},
+    {"help", no_argument, 0, 'h'},
+    {"version", no_argument, 0, 'V'},
+    {NULL, 0, 0, 0},
+};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+int
+main (
+    int ArgumentCount,
+    char **Arguments
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the sound latency test program.
+
+Arguments:
+
+    ArgumentCount - Supplies the number of elements in the arguments array.
+
+    Arguments - Supplies an array of strings. The array count is bounded by the
+        previous parameter, and the strings are null-terminated.
+
+Return Value:
+
+    0 on success.
+
+    Non-zero on failure.
+
+--*/
+
+{
+
+    PSTR AfterScan;
+    PUCHAR Buffer;
+    ULONG BufferSize;
+    ULONG Completed;
+    dsp_mmap_status Copy;
+    PSTR Device;
+    int FileDescriptor;
+    ULONG FragmentCount;
+    ULONG FragmentOffset;
+    ULONG FragmentSize;
+    ULONG Index;
+    audio_buf_info Info;
+    ULONG Iterations;
+    ULONGLONG Latency;
+    ULONGLONG LatencyMax;
+    ULONGLONG LatencyMin;
+    ULONGLONG LatencyTotal;
+    ULONG Missed;
+    ULONGLONG Now;
+    INT Option;
+    ULONG PageSize;
+    ULONGLONG Phase;
+    ULONG Rate;
+    ULONG Seen;
+    ULONG Shift;
+    INT Status;
+    volatile dsp_mmap_status *StatusPage;
+    int Value;
+    BOOL Verbose;
+
+    Buffer = MAP_FAILED;
+    BufferSize = 0;
+    FileDescriptor = -1;
+    FragmentCount = DEFAULT_FRAGMENT_COUNT;
+    FragmentSize = DEFAULT_FRAGMENT_SIZE;
+    Iterations = DEFAULT_ITERATIONS;
+    PageSize = sysconf(_SC_PAGE_SIZE);
+    Phase = 0;
+    Rate = DEFAULT_SAMPLE_RATE;
+    Status = 1;
+    StatusPage = MAP_FAILED;
+    Verbose = FALSE;
+
+    //
+    // Process the control arguments.
+    //
+
+    while (TRUE) {
+        Option = getopt_long(ArgumentCount,
+                             Arguments,
+                             SOUND_LATENCY_OPTIONS_STRING,
+                             SoundLatencyLongOptions,
+                             NULL);
+
+        if (Option == -1) {
+            break;
+        }
+
+        if ((Option == '?') || (Option == ':')) {
+            goto MainEnd;
+        }
+
+        switch (Option) {
+        case 'f':
+            FragmentSize = strtoul(optarg, &AfterScan, 0);
+            if ((FragmentSize == 0) ||
+                (AfterScan == optarg) ||
+                (POWER_OF_2(FragmentSize) == FALSE)) {
+
+                PRINT_ERROR("Invalid fragment size %s.\n", optarg);
+                goto MainEnd;
+            }
+
+            break;
+
+        case 'c':
+            FragmentCount = strtoul(optarg, &AfterScan, 0);
+            if ((FragmentCount < 2) || (AfterScan == optarg)) {
+                PRINT_ERROR("Invalid fragment count %s.\n", optarg);
+                goto MainEnd;
+            }
+
+            break;
+
+        case 'i':
+            Iterations = strtoul(optarg, &AfterScan, 0);
+            if ((Iterations == 0) || (AfterScan == optarg)) {
+                PRINT_ERROR("Invalid iteration count %s.\n", optarg);
+                goto MainEnd;
+            }
+
+            break;
+
+        case 'r':
+            Rate = strtoul(optarg, &AfterScan, 0);
+            if ((Rate == 0) || (AfterScan == optarg)) {
+                PRINT_ERROR("Invalid rate %s.\n", optarg);
+                goto MainEnd;
+            }
+
+            break;
+
+        case 'v':
+            Verbose = TRUE;
+            break;
+
+        case 'V':
+            printf("Minoca sndlat version %d.%d\n",
+                   SOUND_LATENCY_VERSION_MAJOR,
+                   SOUND_LATENCY_VERSION_MINOR);
+
+            return 1;
+
+        case 'h':
+            printf(SOUND_LATENCY_USAGE);
+            return 1;
+
+        default:
+
+            assert(FALSE);
+
+            goto MainEnd;
+        }
+    }
+
+    if (optind != ArgumentCount - 1) {
+        PRINT_ERROR("Expected a sound output device.\n");
+        goto MainEnd;
+    }
+
+    Device = Arguments[optind];
+    FileDescriptor = open(Device, O_RDWR);
+    if (FileDescriptor < 0) {
+        PRINT_ERROR("Failed to open %s: %s.\n", Device, strerror(errno));
+        goto MainEnd;
+    }
+
+    //
+    // Configure the stream. The fragment size is passed as a power of two.
+    //
+
+    Shift = 0;
+    while ((1UL << Shift) < FragmentSize) {
+        Shift += 1;
+    }
+
+    Value = (FragmentCount << 16) | Shift;
+    if (ioctl(FileDescriptor, SNDCTL_DSP_SETFRAGMENT, &Value) < 0) {
+        PRINT_ERROR("Failed to set fragments: %s.\n", strerror(errno));
+        goto MainEnd;
+    }
+
+    Value = AFMT_S16_LE;
+    if ((ioctl(FileDescriptor, SNDCTL_DSP_SETFMT, &Value) < 0) ||
+        (Value != AFMT_S16_LE)) {
+
+        PRINT_ERROR("Device does not support 16-bit samples.\n");
+        goto MainEnd;
+    }
+
+    Value = SOUND_LATENCY_CHANNELS;
+    if ((ioctl(FileDescriptor, SNDCTL_DSP_CHANNELS, &Value) < 0) ||
+        (Value != SOUND_LATENCY_CHANNELS)) {
+
+        PRINT_ERROR("Device does not support stereo.\n");
+        goto MainEnd;
+    }
+
+    Value = Rate;
+    if (ioctl(FileDescriptor, SNDCTL_DSP_SPEED, &Value) < 0) {
+        PRINT_ERROR("Failed to set rate: %s.\n", strerror(errno));
+        goto MainEnd;
+    }
+
+    Rate = Value;
+    if (ioctl(FileDescriptor, SNDCTL_DSP_GETOSPACE, &Info) < 0) {
+        PRINT_ERROR("Failed to get buffer space: %s.\n", strerror(errno));
+        goto MainEnd;
+    }
+
+    FragmentSize = Info.fragsize;
+    FragmentCount = Info.fragstotal;
+    BufferSize = FragmentSize * FragmentCount;
+
+    //
+    // Stop the device from starting on its own, then map the buffer and the
+    // status page.
+    //
+
+    Value = 0;
+    if (ioctl(FileDescriptor, SNDCTL_DSP_SETTRIGGER, &Value) < 0) {
+        PRINT_ERROR("Failed to clear trigger: %s.\n", strerror(errno));
+        goto MainEnd;
+    }
+
+    Buffer = mmap(NULL,
+                  BufferSize,
+                  PROT_READ | PROT_WRITE,
+                  MAP_SHARED,
+                  FileDescriptor,
+                  0);
+
+    if (Buffer == MAP_FAILED) {
+        PRINT_ERROR("Failed to map buffer: %s.\n", strerror(errno));
+        goto MainEnd;
+    }
+
+    StatusPage = mmap(NULL,
+                      PageSize,
+                      PROT_READ,
+                      MAP_SHARED,
+                      FileDescriptor,
+                      DSP_MMAP_STATUS_OFFSET);
+
+    if (StatusPage == MAP_FAILED) {
+        PRINT_ERROR("Failed to map status page: %s.\n", strerror(errno));
+        goto MainEnd;
+    }
+
+    for (Index = 0; Index < FragmentCount; Index += 1) {
+        SoundLatencyFillFragment(Buffer + (Index * FragmentSize),
+                                 FragmentSize,
+                                 Rate,
+                                 &Phase);
+    }
+
+    SoundLatencyReadStatus(StatusPage, &Copy);
+    Seen = (ULONG)Copy.blocks;
+    printf("Playing %u fragments of %u bytes (%u total) at %u Hz.\n",
+           Iterations,
+           FragmentSize,
+           BufferSize,
+           Rate);
+
+    Value = PCM_ENABLE_OUTPUT;
+    if (ioctl(FileDescriptor, SNDCTL_DSP_SETTRIGGER, &Value) < 0) {
+        PRINT_ERROR("Failed to start output: %s.\n", strerror(errno));
+        goto MainEnd;
+    }
+
+    //
+    // Wait for each fragment to complete and refill the fragment that was
+    // just played, which is now the one furthest ahead of the hardware.
+    //
+
+    Completed = 0;
+    LatencyMax = 0;
+    LatencyMin = -1ULL;
+    LatencyTotal = 0;
+    Missed = 0;
+    while (Completed < Iterations) {
+        Value = Seen;
+        if (ioctl(FileDescriptor, SNDCTL_DSP_WAIT_FRAGMENT, &Value) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            PRINT_ERROR("Failed to wait: %s.\n", strerror(errno));
+            goto MainEnd;
+        }
+
+        Now = OsQueryTimeCounter();
+        SoundLatencyReadStatus(StatusPage, &Copy);
+        Latency = ((Now - Copy.timestamp) * MICROSECONDS_PER_SECOND) /
+                  Copy.frequency;
+
+        if (Latency < LatencyMin) {
+            LatencyMin = Latency;
+        }
+
+        if (Latency > LatencyMax) {
+            LatencyMax = Latency;
+        }
+
+        LatencyTotal += Latency;
+        if ((ULONG)Value - Seen > 1) {
+            Missed += (ULONG)Value - Seen - 1;
+        }
+
+        if (Verbose != FALSE) {
+            printf("%u: offset %u, %llu us\n",
+                   Value,
+                   Copy.ptr,
+                   Latency);
+        }
+
+        Seen = Value;
+        Completed += 1;
+        FragmentOffset = (Copy.ptr + BufferSize - FragmentSize) %
+                         BufferSize;
+
+        FragmentOffset = ALIGN_RANGE_DOWN(FragmentOffset, FragmentSize);
+        SoundLatencyFillFragment(Buffer + FragmentOffset,
+                                 FragmentSize,
+                                 Rate,
+                                 &Phase);
+    }
+
+    printf("Wake latency: min %llu us, average %llu us, max %llu us.\n",
+           LatencyMin,
+           LatencyTotal / Completed,
+           LatencyMax);
+
+    printf("%u fragments completed, %u missed.\n", Completed, Missed);
+    Status = 0;
+    if (Missed != 0) {
+        Status = 1;
+    }
+
+MainEnd:
+    if (FileDescriptor >= 0) {
+        Value = 0;
+        ioctl(FileDescriptor, SNDCTL_DSP_SETTRIGGER, &Value);
+    }
+
+    if (StatusPage != MAP_FAILED) {
+        munmap((void *)StatusPage, PageSize);
+    }
+
+    if (Buffer != MAP_FAILED) {
+        munmap(Buffer, BufferSize);
+    }
+
+    if (FileDescriptor >= 0) {
+        close(FileDescriptor);
+    }
+
+    return Status;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+SoundLatencyReadStatus (
+    volatile dsp_mmap_status *Status,
+    dsp_mmap_status *Copy
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes a consistent snapshot of the sound device status page.
+
+Arguments:
+
+    Status - Supplies a pointer to the mapped status page.
+
+    Copy - Supplies a pointer where the snapshot will be returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    unsigned int Sequence;
+
+    do {
+        Sequence = Status->sequence;
+        RtlMemoryBarrier();
+        Copy->ptr = Status->ptr;
+        Copy->bufsize = Status->bufsize;
+        Copy->fragsize = Status->fragsize;
+        Copy->bytes = Status->bytes;
+        Copy->blocks = Status->blocks;
+        Copy->timestamp = Status->timestamp;
+        Copy->frequency = Status->frequency;
+        RtlMemoryBarrier();
+
+    } while (((Sequence & 0x1) != 0) || (Sequence != Status->sequence));
+
+    Copy->sequence = Sequence;
+    return;
+}
+
+VOID
+SoundLatencyFillFragment (
+    PUCHAR Fragment,
+    ULONG Size,
+    ULONG Rate,
+    PULONGLONG Phase
+    )
+
+/*++
+
+Routine Description:
+
+    This routine fills a fragment with the next piece of a square wave tone.
+
+Arguments:
+
+    Fragment - Supplies a pointer to the fragment within the mapped buffer.
+
+    Size - Supplies the size of the fragment in bytes.
+
+    Rate - Supplies the sample rate.
+
+    Phase - Supplies a pointer to the number of frames generated so far,
+        which is updated.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Channel;
+    ULONG FrameCount;
+    ULONG Index;
+    SHORT Sample;
+    PSHORT Samples;
+
+    Samples = (PSHORT)Fragment;
+    FrameCount = Size / (sizeof(SHORT) * SOUND_LATENCY_CHANNELS);
+    for (Index = 0; Index < FrameCount; Index += 1) {
+        Sample = SOUND_LATENCY_TONE_AMPLITUDE;
+        if (((*Phase * SOUND_LATENCY_TONE_HZ * 2) / Rate) % 2 != 0) {
+            Sample = -SOUND_LATENCY_TONE_AMPLITUDE;
+        }
+
+        for (Channel = 0; Channel < SOUND_LATENCY_CHANNELS; Channel += 1) {
+            *Samples = Sample;
+            Samples += 1;
+        }
+
+        *Phase += 1;
+    }
+
+    return;
+}
+
@@ -280,6 +280,9 @@ Return Value:
     printf("    Failed Allocations: %ld\n",
            MmStatistics.PagedPool.FailedAllocations);
 
+    printf("TLB Shootdowns: %ld\n", MmStatistics.TlbShootdowns);
+    printf("    Invalidate IPIs: %ld\n", MmStatistics.TlbInvalidateIpis);
+    printf("    Full Flushes: %ld\n", MmStatistics.TlbFullFlushes);
     Size = sizeof(IO_CACHE_STATISTICS);
     IoCache.Version = IO_CACHE_STATISTICS_VERSION;
     Status = OsGetSetSystemInformation(SystemInformationIo,
@@ -33,12 +33,23 @@ Module Name:
 #include <minoca/kernel/kernel.h>
 #include <minoca/lib/fat/fat.h>
 #include "firmware.h"
-#include "bootlib.h"
+#include "bootlibp.h"
 
 //
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the size and number of boot block cache entries. Reads no larger
+// than an entry are served from the cache, which reads in the whole aligned
+// entry from the firmware at once. These are the FAT and directory reads that
+// get repeated during path lookups. Larger reads are file data, and go
+// straight to the firmware.
+//
+
+#define BOOT_BLOCK_CACHE_ENTRY_SIZE 0x4000
+#define BOOT_BLOCK_CACHE_ENTRY_COUNT 16
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -66,14 +77,61 @@ typedef struct _BOOT_IO_BUFFER {
     UINTN CurrentOffset;
 } BOOT_IO_BUFFER, *PBOOT_IO_BUFFER;
 
+/*++
+
+Structure Description:
+
+    This structure defines an entry in the boot block cache.
+
+Members:
+
+    Volume - Stores a pointer to the volume the entry's data came from, or
+        NULL if the entry is not valid.
+
+    BlockAddress - Stores the first block cached in the entry. This is always
+        aligned to the number of blocks in an entry.
+
+    LastUse - Stores the value of the cache use counter the last time this
+        entry was touched, used to pick the least recently used entry to
+        replace.
+
+    Data - Stores a pointer to the entry's data buffer, which is allocated the
+        first time the entry is used.
+
+--*/
+
+typedef struct _BOOT_BLOCK_CACHE_ENTRY {
+    PBOOT_VOLUME Volume;
+    ULONGLONG BlockAddress;
+    ULONG LastUse;
+    PVOID Data;
+} BOOT_BLOCK_CACHE_ENTRY, *PBOOT_BLOCK_CACHE_ENTRY;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+KSTATUS
+BopReadCachedBlocks (
+    PBOOT_VOLUME Volume,
+    ULONGLONG BlockAddress,
+    ULONG BlockCount,
+    PVOID Buffer
+    );
+
+PBOOT_BLOCK_CACHE_ENTRY
+BopGetBlockCacheEntry (
+    PBOOT_VOLUME Volume,
+    ULONGLONG BlockAddress
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
+BOOT_BLOCK_CACHE_ENTRY BoBlockCache[BOOT_BLOCK_CACHE_ENTRY_COUNT];
+ULONG BoBlockCacheUseCounter;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -739,10 +797,17 @@ Return Value:
            (BlockCount * Device->Parameters.BlockSize));
 
     Buffer = IoBuffer->Data + IoBuffer->CurrentOffset;
-    Status = FwReadDiskSectors(Device->DiskHandle,
-                               BlockAddress,
-                               BlockCount,
-                               Buffer);
+    if ((BlockCount * Device->Parameters.BlockSize) <=
+        BOOT_BLOCK_CACHE_ENTRY_SIZE) {
+
+        Status = BopReadCachedBlocks(Device, BlockAddress, BlockCount, Buffer);
+
+    } else {
+        Status = FwReadDiskSectors(Device->DiskHandle,
+                                   BlockAddress,
+                                   BlockCount,
+                                   Buffer);
+    }
 
     if (!KSUCCESS(Status)) {
         goto ReadDeviceEnd;
@@ -809,6 +874,7 @@ Return Value:
                                 BlockCount,
                                 Buffer);
 
+    BopInvalidateBlockCache(Device, BlockAddress, BlockCount);
     if (!KSUCCESS(Status)) {
         goto WriteDeviceEnd;
     }
@@ -933,7 +999,236 @@ Return Value:
     return;
 }
 
+VOID
+BopInvalidateBlockCache (
+    PBOOT_VOLUME Volume,
+    ULONGLONG BlockAddress,
+    ULONGLONG BlockCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine evicts any boot block cache entries that overlap the given
+    range of blocks on a volume.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume whose blocks are changing.
+
+    BlockAddress - Supplies the first block to invalidate.
+
+    BlockCount - Supplies the number of blocks to invalidate. Supply
+        MAX_ULONGLONG to invalidate everything from the given block on, for
+        instance when the volume is closed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONGLONG BlockEnd;
+    PBOOT_BLOCK_CACHE_ENTRY Entry;
+    ULONG EntryBlocks;
+    ULONG Index;
+
+    EntryBlocks = BOOT_BLOCK_CACHE_ENTRY_SIZE / Volume->Parameters.BlockSize;
+    BlockEnd = BlockAddress + BlockCount;
+    if (BlockEnd < BlockAddress) {
+        BlockEnd = MAX_ULONGLONG;
+    }
+
+    for (Index = 0; Index < BOOT_BLOCK_CACHE_ENTRY_COUNT; Index += 1) {
+        Entry = &(BoBlockCache[Index]);
+        if ((Entry->Volume == Volume) &&
+            (Entry->BlockAddress < BlockEnd) &&
+            (Entry->BlockAddress + EntryBlocks > BlockAddress)) {
+
+            Entry->Volume = NULL;
+        }
+    }
+
+    return;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+KSTATUS
+BopReadCachedBlocks (
+    PBOOT_VOLUME Volume,
+    ULONGLONG BlockAddress,
+    ULONG BlockCount,
+    PVOID Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads a small number of blocks through the boot block cache,
+    reading whole cache entries from the firmware on a miss.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume to read from.
+
+    BlockAddress - Supplies the first block to read.
+
+    BlockCount - Supplies the number of blocks to read.
+
+    Buffer - Supplies a pointer where the data will be returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONG BlockSize;
+    ULONG BlocksThisRound;
+    ULONGLONG EntryAddress;
+    ULONG EntryBlocks;
+    PBOOT_BLOCK_CACHE_ENTRY Entry;
+    ULONG EntryOffset;
+    KSTATUS Status;
+
+    BlockSize = Volume->Parameters.BlockSize;
+    EntryBlocks = BOOT_BLOCK_CACHE_ENTRY_SIZE / BlockSize;
+    Status = STATUS_SUCCESS;
+    while (BlockCount != 0) {
+
+        //
+        // Go straight to the firmware if a block is bigger than an entry, for
+        // the partial entry at the very end of the disk, or if there's no
+        // memory for an entry.
+        //
+
+        Entry = NULL;
+        EntryAddress = 0;
+        EntryOffset = 0;
+        if (EntryBlocks != 0) {
+            EntryOffset = BlockAddress % EntryBlocks;
+            EntryAddress = BlockAddress - EntryOffset;
+            if (EntryAddress + EntryBlocks <= Volume->Parameters.BlockCount) {
+                Entry = BopGetBlockCacheEntry(Volume, EntryAddress);
+            }
+        }
+
+        if (Entry == NULL) {
+            Status = FwReadDiskSectors(Volume->DiskHandle,
+                                       BlockAddress,
+                                       BlockCount,
+                                       Buffer);
+
+            break;
+        }
+
+        if (Entry->Volume == NULL) {
+            Status = FwReadDiskSectors(Volume->DiskHandle,
+                                       EntryAddress,
+                                       EntryBlocks,
+                                       Entry->Data);
+
+            if (!KSUCCESS(Status)) {
+                break;
+            }
+
+            Entry->Volume = Volume;
+            Entry->BlockAddress = EntryAddress;
+        }
+
+        BlocksThisRound = EntryBlocks - EntryOffset;
+        if (BlocksThisRound > BlockCount) {
+            BlocksThisRound = BlockCount;
+        }
+
+        RtlCopyMemory(Buffer,
+                      Entry->Data + (EntryOffset * BlockSize),
+                      BlocksThisRound * BlockSize);
+
+        BlockAddress += BlocksThisRound;
+        BlockCount -= BlocksThisRound;
+        Buffer += BlocksThisRound * BlockSize;
+    }
+
+    return Status;
+}
+
+PBOOT_BLOCK_CACHE_ENTRY
+BopGetBlockCacheEntry (
+    PBOOT_VOLUME Volume,
+    ULONGLONG BlockAddress
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the boot block cache entry for the given entry-aligned
+    block. On a miss, it returns the least recently used entry, marked invalid
+    so the caller knows to fill it.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume being read.
+
+    BlockAddress - Supplies the first block of the entry.
+
+Return Value:
+
+    Returns a pointer to the cache entry.
+
+    NULL if an entry's data buffer could not be allocated.
+
+--*/
+
+{
+
+    PBOOT_BLOCK_CACHE_ENTRY Entry;
+    ULONG Index;
+    PBOOT_BLOCK_CACHE_ENTRY Victim;
+
+    BoBlockCacheUseCounter += 1;
+    Victim = NULL;
+    for (Index = 0; Index < BOOT_BLOCK_CACHE_ENTRY_COUNT; Index += 1) {
+        Entry = &(BoBlockCache[Index]);
+        if ((Entry->Volume == Volume) &&
+            (Entry->BlockAddress == BlockAddress)) {
+
+            Entry->LastUse = BoBlockCacheUseCounter;
+            return Entry;
+        }
+
+        //
+        // Prefer invalid entries, then the one used longest ago.
+        //
+
+        if ((Victim == NULL) ||
+            ((Victim->Volume != NULL) &&
+             ((Entry->Volume == NULL) ||
+              (Entry->LastUse < Victim->LastUse)))) {
+
+            Victim = Entry;
+        }
+    }
+
+    if (Victim->Data == NULL) {
+        Victim->Data = BoAllocateMemory(BOOT_BLOCK_CACHE_ENTRY_SIZE);
+        if (Victim->Data == NULL) {
+            return NULL;
+        }
+    }
+
+    Victim->Volume = NULL;
+    Victim->LastUse = BoBlockCacheUseCounter;
+    return Victim;
+}
+
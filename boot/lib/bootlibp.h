@@ -66,3 +66,33 @@ Return Value:
 
 --*/
 
+VOID
+BopInvalidateBlockCache (
+    PBOOT_VOLUME Volume,
+    ULONGLONG BlockAddress,
+    ULONGLONG BlockCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine evicts any boot block cache entries that overlap the given
+    range of blocks on a volume.
+
+Arguments:
+
+    Volume - Supplies a pointer to the volume whose blocks are changing.
+
+    BlockAddress - Supplies the first block to invalidate.
+
+    BlockCount - Supplies the number of blocks to invalidate. Supply
+        MAX_ULONGLONG to invalidate everything from the given block on, for
+        instance when the volume is closed.
+
+Return Value:
+
+    None.
+
+--*/
+
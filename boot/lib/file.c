@@ -156,6 +156,7 @@ Return Value:
         return Status;
     }
 
+    BopInvalidateBlockCache(VolumeHandle, 0, MAX_ULONGLONG);
     FwCloseDisk(VolumeHandle->DiskHandle);
     BoFreeMemory(VolumeHandle);
     return STATUS_SUCCESS;
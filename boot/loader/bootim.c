@@ -32,6 +32,7 @@ Module Name:
 
 #include <minoca/kernel/kernel.h>
 #include <minoca/lib/fat/fat.h>
+#include <minoca/lib/lzma.h>
 #include "firmware.h"
 #include "bootlib.h"
 #include "loader.h"
@@ -41,6 +42,14 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the largest uncompressed size a compressed boot file may claim.
+// This is far larger than any boot driver or image, and keeps a corrupt
+// footer from wrapping the buffer size computation.
+//
+
+#define BOOT_MAX_UNCOMPRESSED_FILE_SIZE (256 * _1MB)
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -186,6 +195,17 @@ BopImFinalizeSegments (
     UINTN SegmentCount
     );
 
+KSTATUS
+BopImDecompressFile (
+    PBOOT_FILE_HANDLE BootFileHandle
+    );
+
+PVOID
+BopImLzReallocate (
+    PVOID Allocation,
+    UINTN NewSize
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -559,7 +579,7 @@ Return Value:
                             &BoSystemDirectoryId,
                             BootFileHandle->FileName,
                             &(BootFileHandle->LoadedFileBuffer),
-                            NULL,
+                            &(BootFileHandle->FileSize),
                             NULL);
 
         if (Status == STATUS_PATH_NOT_FOUND) {
@@ -567,13 +587,27 @@ Return Value:
                                 &BoDriversDirectoryId,
                                 BootFileHandle->FileName,
                                 &(BootFileHandle->LoadedFileBuffer),
-                                NULL,
+                                &(BootFileHandle->FileSize),
                                 NULL);
         }
 
         if (!KSUCCESS(Status)) {
             goto ImLoadFileEnd;
         }
+
+        //
+        // Boot drivers may be stored compressed to cut down on the number of
+        // bytes read from the disk, which is slow this early in boot.
+        //
+
+        Status = BopImDecompressFile(BootFileHandle);
+        if (!KSUCCESS(Status)) {
+            BoFreeMemory(BootFileHandle->LoadedFileBuffer);
+            BootFileHandle->LoadedFileBuffer = NULL;
+            goto ImLoadFileEnd;
+        }
+
+        File->Size = BootFileHandle->FileSize;
     }
 
     Status = STATUS_SUCCESS;
@@ -1134,3 +1168,201 @@ Return Value:
     return STATUS_SUCCESS;
 }
 
+KSTATUS
+BopImDecompressFile (
+    PBOOT_FILE_HANDLE BootFileHandle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine decompresses a loaded file in place if it is an LZMA file,
+    replacing the file buffer and size with the uncompressed ones. Files that
+    are not compressed are left alone.
+
+Arguments:
+
+    BootFileHandle - Supplies a pointer to the boot file handle, whose file
+        has been loaded.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN AlignedSize;
+    PUCHAR Compressed;
+    LZ_CONTEXT Context;
+    BOOL DecoderInitialized;
+    UINTN InputSize;
+    LZ_STATUS LzStatus;
+    ULONG Magic;
+    PVOID Output;
+    UINTN OutputSize;
+    KSTATUS Status;
+    ULONGLONG UncompressedSize;
+
+    Compressed = BootFileHandle->LoadedFileBuffer;
+    DecoderInitialized = FALSE;
+    Output = NULL;
+    if (BootFileHandle->FileSize < LZMA_HEADER_SIZE + LZMA_FOOTER_SIZE) {
+        return STATUS_SUCCESS;
+    }
+
+    RtlCopyMemory(&Magic, Compressed, sizeof(ULONG));
+    if (Magic != LZMA_HEADER_MAGIC) {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // The uncompressed size leads off the footer at the end of the file.
+    //
+
+    RtlCopyMemory(&UncompressedSize,
+                  Compressed + BootFileHandle->FileSize - LZMA_FOOTER_SIZE,
+                  sizeof(ULONGLONG));
+
+    if (UncompressedSize > BOOT_MAX_UNCOMPRESSED_FILE_SIZE) {
+        RtlDebugPrint("%s claims an uncompressed size of 0x%I64x.\n",
+                      BootFileHandle->FileName,
+                      UncompressedSize);
+
+        Status = STATUS_FILE_CORRUPT;
+        goto DecompressFileEnd;
+    }
+
+    //
+    // Leave room for a null terminator, as loading the file normally does.
+    //
+
+    AlignedSize = ALIGN_RANGE_UP((UINTN)UncompressedSize + 1, MmPageSize());
+    Output = BoAllocateMemory(AlignedSize);
+    if (Output == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto DecompressFileEnd;
+    }
+
+    RtlZeroMemory(&Context, sizeof(LZ_CONTEXT));
+    Context.Reallocate = BopImLzReallocate;
+    Context.Input = Compressed;
+    Context.InputSize = BootFileHandle->FileSize;
+    Context.Output = Output;
+    Context.OutputSize = (UINTN)UncompressedSize;
+    LzStatus = LzLzmaInitializeDecoder(&Context, NULL, TRUE);
+    if (LzStatus != LzSuccess) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto DecompressFileEnd;
+    }
+
+    DecoderInitialized = TRUE;
+    do {
+        InputSize = Context.InputSize;
+        OutputSize = Context.OutputSize;
+        LzStatus = LzLzmaDecode(&Context, LzFlushNow);
+        if (LzStatus != LzSuccess) {
+            break;
+        }
+
+    } while ((Context.InputSize != InputSize) ||
+             (Context.OutputSize != OutputSize));
+
+    if ((LzStatus != LzStreamComplete) ||
+        (Context.UncompressedSize != UncompressedSize)) {
+
+        RtlDebugPrint("Failed to decompress %s: %d\n",
+                      BootFileHandle->FileName,
+                      LzStatus);
+
+        Status = STATUS_FILE_CORRUPT;
+        goto DecompressFileEnd;
+    }
+
+    *((PUCHAR)Output + UncompressedSize) = '\0';
+    BoFreeMemory(BootFileHandle->LoadedFileBuffer);
+    BootFileHandle->LoadedFileBuffer = Output;
+    BootFileHandle->FileSize = (UINTN)UncompressedSize;
+    Output = NULL;
+    Status = STATUS_SUCCESS;
+
+DecompressFileEnd:
+    if (DecoderInitialized != FALSE) {
+        LzLzmaFinishDecode(&Context);
+    }
+
+    if (Output != NULL) {
+        BoFreeMemory(Output);
+    }
+
+    return Status;
+}
+
+PVOID
+BopImLzReallocate (
+    PVOID Allocation,
+    UINTN NewSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates, reallocates, or frees memory for the LZMA decoder.
+    The boot allocator cannot resize, so each allocation is preceded by its
+    size so that its contents can be carried over to a new one.
+
+Arguments:
+
+    Allocation - Supplies an optional pointer to the allocation to resize or
+        free. If NULL, then this routine will allocate new memory.
+
+    NewSize - Supplies the size of the desired allocation. If this is 0 and the
+        allocation parameter is non-null, the given allocation will be freed.
+        Otherwise it will be resized to requested size.
+
+Return Value:
+
+    Returns a pointer to the allocation on success.
+
+    NULL on allocation failure, or in the case the memory is being freed.
+
+--*/
+
+{
+
+    PUINTN NewAllocation;
+    PUINTN OldAllocation;
+
+    OldAllocation = NULL;
+    if (Allocation != NULL) {
+        OldAllocation = (PUINTN)Allocation - 1;
+    }
+
+    NewAllocation = NULL;
+    if (NewSize != 0) {
+        NewAllocation = BoAllocateMemory(NewSize + sizeof(UINTN));
+        if (NewAllocation == NULL) {
+            return NULL;
+        }
+
+        *NewAllocation = NewSize;
+        NewAllocation += 1;
+        if (OldAllocation != NULL) {
+            if (*OldAllocation < NewSize) {
+                NewSize = *OldAllocation;
+            }
+
+            RtlCopyMemory(NewAllocation, Allocation, NewSize);
+        }
+    }
+
+    if (OldAllocation != NULL) {
+        BoFreeMemory(OldAllocation);
+    }
+
+    return NewAllocation;
+}
+
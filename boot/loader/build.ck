@@ -137,6 +137,7 @@ function build() {
     baseLibs = [
         "lib/basevid:basevid",
         "lib/fatlib:fat",
+        "apps/lib/lzma:lzmab",
         "kernel/mm:mmboot",
         baseRtl,
         "lib/rtl/kmode:krtl",
@@ -101,7 +101,8 @@ E1000DestroyLink (
 
 KSTATUS
 E1000pProcessResourceRequirements (
-    PIRP Irp
+    PIRP Irp,
+    PE1000_DEVICE Device
     );
 
 KSTATUS
@@ -110,11 +111,27 @@ E1000pStartDevice (
     PE1000_DEVICE Device
     );
 
+KSTATUS
+E1000pConnectQueueInterrupts (
+    PIRP Irp,
+    PE1000_DEVICE Device
+    );
+
+VOID
+E1000pProcessPciMsiInterfaceChangeNotification (
+    PVOID Context,
+    PDEVICE Device,
+    PVOID InterfaceBuffer,
+    ULONG InterfaceBufferSize,
+    BOOL Arrival
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
 PDRIVER E1000Driver = NULL;
+UUID E1000PciMsiInterfaceUuid = UUID_PCI_MESSAGE_SIGNALED_INTERRUPTS;
 
 //
 // List the supported PCI devices and what is known about them. All are assumed
@@ -223,6 +240,7 @@ Return Value:
     PE1000_DEVICE_ENTRY DeviceEntry;
     ULONG DeviceNumber;
     ULONG ItemsScanned;
+    ULONG QueueIndex;
     KSTATUS Status;
 
     Device = MmAllocateNonPagedPool(sizeof(E1000_DEVICE), E1000_ALLOCATION_TAG);
@@ -233,6 +251,11 @@ Return Value:
 
     RtlZeroMemory(Device, sizeof(E1000_DEVICE));
     Device->InterruptHandle = INVALID_HANDLE;
+    for (QueueIndex = 0; QueueIndex < E1000_MAX_QUEUES; QueueIndex += 1) {
+        Device->Queues[QueueIndex].InterruptHandle = INVALID_HANDLE;
+    }
+
+    Device->QueueCount = 1;
     Device->OsDevice = DeviceToken;
 
     //
@@ -332,7 +355,7 @@ Return Value:
     if (Irp->Direction == IrpUp) {
         switch (Irp->MinorCode) {
         case IrpMinorQueryResources:
-            Status = E1000pProcessResourceRequirements(Irp);
+            Status = E1000pProcessResourceRequirements(Irp, DeviceContext);
             if (!KSUCCESS(Status)) {
                 IoCompleteIrp(E1000Driver, Irp, Status);
             }
@@ -603,6 +626,7 @@ Return Value:
     Properties.Interface.GetSetInformation = E1000GetSetInformation;
     Properties.Interface.DestroyLink = E1000DestroyLink;
     Properties.Capabilities = Device->SupportedCapabilities;
+    Properties.QueueCount = Device->QueueCount;
     Status = NetAddLink(&Properties, &(Device->NetworkLink));
     if (!KSUCCESS(Status)) {
         goto AddNetworkDeviceEnd;
@@ -625,7 +649,8 @@ Return Value:
 
 KSTATUS
 E1000pProcessResourceRequirements (
-    PIRP Irp
+    PIRP Irp,
+    PE1000_DEVICE Device
     )
 
 /*++
@@ -634,12 +659,16 @@ Routine Description:
 
     This routine filters through the resource requirements presented by the
     bus for an e1000 LAN controller. It adds an interrupt vector requirement for
-    any interrupt line requested.
+    any interrupt line requested. On controllers that support multiple queues,
+    it prefers a block of MSI-X vectors, one per queue plus one for everything
+    else.
 
 Arguments:
 
     Irp - Supplies a pointer to the I/O request packet.
 
+    Device - Supplies a pointer to the device information.
+
 Return Value:
 
     Status code.
@@ -648,9 +677,16 @@ Return Value:
 
 {
 
-    PRESOURCE_CONFIGURATION_LIST Requirements;
+    PRESOURCE_CONFIGURATION_LIST ConfigurationList;
+    ULONGLONG EdgeTriggered;
+    ULONGLONG LineCharacteristics;
+    PRESOURCE_REQUIREMENT NextRequirement;
+    PRESOURCE_REQUIREMENT Requirement;
+    PRESOURCE_REQUIREMENT_LIST RequirementList;
     KSTATUS Status;
-    RESOURCE_REQUIREMENT VectorRequirement;
+    ULONGLONG VectorCharacteristics;
+    PRESOURCE_REQUIREMENT VectorRequirement;
+    RESOURCE_REQUIREMENT VectorTemplate;
 
     ASSERT((Irp->MajorCode == IrpMajorStateChange) &&
            (Irp->MinorCode == IrpMinorQueryResources));
@@ -659,22 +695,117 @@ Return Value:
     // Initialize a nice interrupt vector requirement in preparation.
     //
 
-    RtlZeroMemory(&VectorRequirement, sizeof(RESOURCE_REQUIREMENT));
-    VectorRequirement.Type = ResourceTypeInterruptVector;
-    VectorRequirement.Minimum = 0;
-    VectorRequirement.Maximum = -1;
-    VectorRequirement.Length = 1;
+    RtlZeroMemory(&VectorTemplate, sizeof(RESOURCE_REQUIREMENT));
+    VectorTemplate.Type = ResourceTypeInterruptVector;
+    VectorTemplate.Minimum = 0;
+    VectorTemplate.Maximum = -1;
+    VectorTemplate.Length = 1;
 
     //
-    // Loop through all configuration lists, creating a vector for each line.
+    // Only the 82574 has the MSI-X support needed to run more than one queue.
     //
 
-    Requirements = Irp->U.QueryResources.ResourceRequirements;
-    Status = IoCreateAndAddInterruptVectorsForLines(Requirements,
-                                                    &VectorRequirement);
+    if ((Device->MacType == E1000Mac82574) &&
+        ((Device->PciMsiFlags & E1000_PCI_MSI_FLAG_INTERFACE_REGISTERED) ==
+         0)) {
 
-    if (!KSUCCESS(Status)) {
-        goto ProcessResourceRequirementsEnd;
+        Status = IoRegisterForInterfaceNotifications(
+                                &E1000PciMsiInterfaceUuid,
+                                E1000pProcessPciMsiInterfaceChangeNotification,
+                                Irp->Device,
+                                Device,
+                                TRUE);
+
+        if (!KSUCCESS(Status)) {
+            goto ProcessResourceRequirementsEnd;
+        }
+
+        Device->PciMsiFlags |= E1000_PCI_MSI_FLAG_INTERFACE_REGISTERED;
+    }
+
+    ConfigurationList = Irp->U.QueryResources.ResourceRequirements;
+    if ((Device->PciMsiFlags & E1000_PCI_MSI_FLAG_INTERFACE_AVAILABLE) != 0) {
+
+        //
+        // Ask for a contiguous block of vectors in every configuration. If
+        // that cannot be satisfied, fall back to a single vector for the
+        // legacy interrupt line, and a single queue.
+        //
+
+        RequirementList = IoGetNextResourceConfiguration(ConfigurationList,
+                                                         NULL);
+
+        while (RequirementList != NULL) {
+            VectorTemplate.Characteristics = INTERRUPT_VECTOR_EDGE_TRIGGERED;
+            VectorTemplate.Length = E1000_MSIX_VECTOR_COUNT;
+            VectorTemplate.OwningRequirement = NULL;
+            Status = IoCreateAndAddResourceRequirement(&VectorTemplate,
+                                                       RequirementList,
+                                                       &VectorRequirement);
+
+            if (!KSUCCESS(Status)) {
+                goto ProcessResourceRequirementsEnd;
+            }
+
+            Requirement = IoGetNextResourceRequirement(RequirementList, NULL);
+            while (Requirement != NULL) {
+                NextRequirement = IoGetNextResourceRequirement(RequirementList,
+                                                               Requirement);
+
+                if (Requirement->Type != ResourceTypeInterruptLine) {
+                    Requirement = NextRequirement;
+                    continue;
+                }
+
+                VectorCharacteristics = 0;
+                LineCharacteristics = Requirement->Characteristics;
+                if ((LineCharacteristics & INTERRUPT_LINE_ACTIVE_LOW) != 0) {
+                    VectorCharacteristics |= INTERRUPT_VECTOR_ACTIVE_LOW;
+                }
+
+                if ((LineCharacteristics & INTERRUPT_LINE_ACTIVE_HIGH) != 0) {
+                    VectorCharacteristics |= INTERRUPT_VECTOR_ACTIVE_HIGH;
+                }
+
+                EdgeTriggered = LineCharacteristics &
+                                INTERRUPT_LINE_EDGE_TRIGGERED;
+
+                if (EdgeTriggered != 0) {
+                    VectorCharacteristics |= INTERRUPT_VECTOR_EDGE_TRIGGERED;
+                }
+
+                VectorTemplate.Characteristics = VectorCharacteristics;
+                VectorTemplate.Length = 1;
+                VectorTemplate.OwningRequirement = Requirement;
+                Status = IoCreateAndAddResourceRequirementAlternative(
+                                                            &VectorTemplate,
+                                                            VectorRequirement);
+
+                if (!KSUCCESS(Status)) {
+                    goto ProcessResourceRequirementsEnd;
+                }
+
+                Requirement = NextRequirement;
+            }
+
+            RequirementList = IoGetNextResourceConfiguration(ConfigurationList,
+                                                             RequirementList);
+        }
+
+        Device->PciMsiFlags |= E1000_PCI_MSI_FLAG_RESOURCES_REQUESTED;
+
+    //
+    // Otherwise loop through all configuration lists, creating a vector for
+    // each line.
+    //
+
+    } else {
+        Status = IoCreateAndAddInterruptVectorsForLines(ConfigurationList,
+                                                        &VectorTemplate);
+
+        if (!KSUCCESS(Status)) {
+            goto ProcessResourceRequirementsEnd;
+        }
     }
 
 ProcessResourceRequirementsEnd:
@@ -733,8 +864,8 @@ Return Value:
     while (Allocation != NULL) {
 
         //
-        // If the resource is an interrupt vector, then it should have an
-        // owning interrupt line allocation.
+        // If the resource is an interrupt vector, then it either has an owning
+        // interrupt line allocation, or is a block of MSI-X vectors.
         //
 
         if (Allocation->Type == ResourceTypeInterruptVector) {
@@ -744,14 +875,28 @@ Return Value:
             //
 
             ASSERT(Device->InterruptResourcesFound == FALSE);
-            ASSERT(Allocation->OwningAllocation != NULL);
 
             //
-            // Save the line and vector number.
+            // Save the line and vector number. With MSI-X, the vectors come
+            // in a block: one per queue and then one for everything else.
             //
 
             LineAllocation = Allocation->OwningAllocation;
-            Device->InterruptLine = LineAllocation->Allocation;
+            if (LineAllocation == NULL) {
+
+                ASSERT((Device->PciMsiFlags &
+                        E1000_PCI_MSI_FLAG_RESOURCES_REQUESTED) != 0);
+
+                Device->InterruptLine = INVALID_INTERRUPT_LINE;
+                Device->PciMsiFlags |= E1000_PCI_MSI_FLAG_RESOURCES_ALLOCATED;
+                if (Allocation->Length >= E1000_MSIX_VECTOR_COUNT) {
+                    Device->QueueCount = E1000_MAX_QUEUES;
+                }
+
+            } else {
+                Device->InterruptLine = LineAllocation->Allocation;
+            }
+
             Device->InterruptVector = Allocation->Allocation;
             Device->InterruptResourcesFound = TRUE;
 
@@ -867,6 +1012,15 @@ Return Value:
         goto StartDeviceEnd;
     }
 
+    //
+    // With multiple queues, each queue gets its own MSI-X vector.
+    //
+
+    if (Device->QueueCount > 1) {
+        Status = E1000pConnectQueueInterrupts(Irp, Device);
+        goto StartDeviceEnd;
+    }
+
     //
     // Attempt to connect the interrupt.
     //
@@ -895,3 +1049,189 @@ Return Value:
     return Status;
 }
 
+KSTATUS
+E1000pConnectQueueInterrupts (
+    PIRP Irp,
+    PE1000_DEVICE Device
+    )
+
+/*++
+
+Routine Description:
+
+    This routine connects and enables the MSI-X vectors for a device running
+    multiple queues. Each queue's vector is aimed at the processor the
+    networking core spreads that queue to, so that receive processing for a
+    flow stays on one processor.
+
+Arguments:
+
+    Irp - Supplies a pointer to the start IRP.
+
+    Device - Supplies a pointer to the device information.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    IO_CONNECT_INTERRUPT_PARAMETERS Connect;
+    PCI_MSI_INFORMATION MsiInformation;
+    PINTERFACE_PCI_MSI MsiInterface;
+    PROCESSOR_SET ProcessorSet;
+    PE1000_QUEUE Queue;
+    ULONG QueueIndex;
+    KSTATUS Status;
+
+    ASSERT(Device->InterruptLine == INVALID_INTERRUPT_LINE);
+    ASSERT((Device->PciMsiFlags & E1000_PCI_MSI_FLAG_RESOURCES_ALLOCATED) != 0);
+    ASSERT(Device->NetworkLink != NULL);
+
+    RtlZeroMemory(&Connect, sizeof(IO_CONNECT_INTERRUPT_PARAMETERS));
+    Connect.Version = IO_CONNECT_INTERRUPT_PARAMETERS_VERSION;
+    Connect.Device = Device->OsDevice;
+    Connect.LineNumber = INVALID_INTERRUPT_LINE;
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        Queue = &(Device->Queues[QueueIndex]);
+
+        ASSERT(Queue->InterruptHandle == INVALID_HANDLE);
+
+        Connect.Vector = Device->InterruptVector + QueueIndex;
+        Connect.InterruptServiceRoutine = E1000pQueueInterruptService;
+        Connect.LowLevelServiceRoutine = E1000pQueueInterruptServiceWorker;
+        Connect.Context = Queue;
+        Connect.Interrupt = &(Queue->InterruptHandle);
+        Status = IoConnectInterrupt(&Connect);
+        if (!KSUCCESS(Status)) {
+            goto ConnectQueueInterruptsEnd;
+        }
+    }
+
+    ASSERT(Device->InterruptHandle == INVALID_HANDLE);
+
+    Connect.Vector = Device->InterruptVector + E1000_MSIX_OTHER_VECTOR;
+    Connect.InterruptServiceRoutine = E1000pInterruptService;
+    Connect.LowLevelServiceRoutine = E1000pInterruptServiceWorker;
+    Connect.Context = Device;
+    Connect.Interrupt = &(Device->InterruptHandle);
+    Status = IoConnectInterrupt(&Connect);
+    if (!KSUCCESS(Status)) {
+        goto ConnectQueueInterruptsEnd;
+    }
+
+    //
+    // Program the MSI-X table entries, then turn MSI-X on.
+    //
+
+    MsiInterface = &(Device->PciMsiInterface);
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        NetGetQueueProcessorSet(Device->NetworkLink, QueueIndex, &ProcessorSet);
+        Status = MsiInterface->SetVectors(MsiInterface->DeviceToken,
+                                          PciMsiTypeExtended,
+                                          Device->InterruptVector + QueueIndex,
+                                          QueueIndex,
+                                          1,
+                                          &ProcessorSet);
+
+        if (!KSUCCESS(Status)) {
+            goto ConnectQueueInterruptsEnd;
+        }
+    }
+
+    ProcessorSet.Target = ProcessorTargetAny;
+    Status = MsiInterface->SetVectors(
+                            MsiInterface->DeviceToken,
+                            PciMsiTypeExtended,
+                            Device->InterruptVector + E1000_MSIX_OTHER_VECTOR,
+                            E1000_MSIX_OTHER_VECTOR,
+                            1,
+                            &ProcessorSet);
+
+    if (!KSUCCESS(Status)) {
+        goto ConnectQueueInterruptsEnd;
+    }
+
+    RtlZeroMemory(&MsiInformation, sizeof(PCI_MSI_INFORMATION));
+    MsiInformation.Version = PCI_MSI_INTERFACE_INFORMATION_VERSION;
+    MsiInformation.MsiType = PciMsiTypeExtended;
+    MsiInformation.Flags = PCI_MSI_INTERFACE_FLAG_ENABLED;
+    MsiInformation.VectorCount = E1000_MSIX_VECTOR_COUNT;
+    Status = MsiInterface->GetSetInformation(MsiInterface->DeviceToken,
+                                             &MsiInformation,
+                                             TRUE);
+
+    if (!KSUCCESS(Status)) {
+        goto ConnectQueueInterruptsEnd;
+    }
+
+    E1000pEnableInterrupts(Device);
+
+ConnectQueueInterruptsEnd:
+    return Status;
+}
+
+VOID
+E1000pProcessPciMsiInterfaceChangeNotification (
+    PVOID Context,
+    PDEVICE Device,
+    PVOID InterfaceBuffer,
+    ULONG InterfaceBufferSize,
+    BOOL Arrival
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called when a PCI MSI interface changes in availability.
+
+Arguments:
+
+    Context - Supplies the caller's context pointer, supplied when the caller
+        requested interface notifications.
+
+    Device - Supplies a pointer to the device exposing or deleting the
+        interface.
+
+    InterfaceBuffer - Supplies a pointer to the interface buffer of the
+        interface.
+
+    InterfaceBufferSize - Supplies the buffer size.
+
+    Arrival - Supplies TRUE if a new interface is arriving, or FALSE if an
+        interface is departing.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PE1000_DEVICE E1000Device;
+
+    E1000Device = (PE1000_DEVICE)Context;
+    if (Arrival != FALSE) {
+        if (InterfaceBufferSize >= sizeof(INTERFACE_PCI_MSI)) {
+
+            ASSERT((E1000Device->PciMsiFlags &
+                    E1000_PCI_MSI_FLAG_INTERFACE_AVAILABLE) == 0);
+
+            RtlCopyMemory(&(E1000Device->PciMsiInterface),
+                          InterfaceBuffer,
+                          sizeof(INTERFACE_PCI_MSI));
+
+            E1000Device->PciMsiFlags |= E1000_PCI_MSI_FLAG_INTERFACE_AVAILABLE;
+        }
+
+    } else {
+        E1000Device->PciMsiFlags &= ~E1000_PCI_MSI_FLAG_INTERFACE_AVAILABLE;
+    }
+
+    return;
+}
+
@@ -26,6 +26,8 @@ Module Name:
 // ------------------------------------------------------------------- Includes
 //
 
+#include <minoca/intrface/pci.h>
+
 //
 // --------------------------------------------------------------------- Macros
 //
@@ -47,6 +49,14 @@ Module Name:
 #define E1000_WRITE_ARRAY(_Controller, _Register, _Offset, _Value) \
     E1000_WRITE((_Controller), (_Register) + ((_Offset) << 2), (_Value))
 
+//
+// This macro returns the register offset of a queue's copy of one of the
+// queue 0 descriptor ring registers.
+//
+
+#define E1000_QUEUE_REGISTER(_Register, _Queue) \
+    ((_Register) + ((_Queue) * E1000_QUEUE_REGISTER_STRIDE))
+
 //
 // ---------------------------------------------------------------- Definitions
 //
@@ -95,6 +105,44 @@ Module Name:
 
 #define E1000_MAX_TRANSMIT_PACKET_LIST_COUNT (E1000_TX_RING_SIZE * 2)
 
+//
+// Define the maximum number of transmit and receive queue pairs. Only the
+// 82574 has more than one, and only when MSI-X is available.
+//
+
+#define E1000_MAX_QUEUES 2
+
+//
+// Define the distance between the register sets of consecutive queues.
+//
+
+#define E1000_QUEUE_REGISTER_STRIDE 0x100
+
+//
+// Define the MSI-X vectors used in multi-queue mode: one for each queue pair
+// and one more for everything else, like link status changes.
+//
+
+#define E1000_MSIX_VECTOR_COUNT (E1000_MAX_QUEUES + 1)
+#define E1000_MSIX_OTHER_VECTOR E1000_MAX_QUEUES
+
+//
+// Define the number of entries in the RSS redirection table, and the number
+// of 32-bit registers in the RSS random key.
+//
+
+#define E1000_REDIRECTION_TABLE_SIZE 128
+#define E1000_RSS_KEY_REGISTER_COUNT 10
+
+//
+// Define a set of flags used to determine if MSI-X interrupts should be used.
+//
+
+#define E1000_PCI_MSI_FLAG_INTERFACE_REGISTERED 0x00000001
+#define E1000_PCI_MSI_FLAG_INTERFACE_AVAILABLE  0x00000002
+#define E1000_PCI_MSI_FLAG_RESOURCES_REQUESTED  0x00000004
+#define E1000_PCI_MSI_FLAG_RESOURCES_ALLOCATED  0x00000008
+
 //
 // Flow control values.
 //
@@ -347,6 +395,7 @@ Module Name:
 #define E1000_EXTENDED_CONTROL_LINK_SERDES (0x2 << 22)
 #define E1000_EXTENDED_CONTROL_LINK_TBI (0x3 << 22)
 #define E1000_EXTENDED_CONTROL_DRIVER_LOADED (1 << 28)
+#define E1000_EXTENDED_CONTROL_PBA_SUPPORT (1 << 31)
 
 //
 // MDI control register bits.
@@ -429,6 +478,39 @@ Module Name:
 #define E1000_RX_CHECKSUM_IP_OFFLOAD (1 << 8)
 #define E1000_RX_CHECKSUM_TCP_UDP_OFFLOAD (1 << 9)
 #define E1000_RX_CHECKSUM_IPV6_OFFLOAD (1 << 10)
+#define E1000_RX_CHECKSUM_PACKET_CHECKSUM_DISABLE (1 << 13)
+
+//
+// Receive filter control register bits.
+//
+
+#define E1000_RX_FILTER_CONTROL_EXTENDED_STATUS (1 << 15)
+
+//
+// Multiple receive queues command register bits.
+//
+
+#define E1000_MULTIPLE_RX_QUEUES_RSS (1 << 0)
+#define E1000_MULTIPLE_RX_QUEUES_HASH_TCP_IP4 (1 << 16)
+#define E1000_MULTIPLE_RX_QUEUES_HASH_IP4 (1 << 17)
+#define E1000_MULTIPLE_RX_QUEUES_HASH_TCP_IP6 (1 << 18)
+#define E1000_MULTIPLE_RX_QUEUES_HASH_IP6_EX (1 << 19)
+#define E1000_MULTIPLE_RX_QUEUES_HASH_IP6 (1 << 20)
+
+//
+// Redirection table entry bits. Each register holds four one byte entries.
+//
+
+#define E1000_REDIRECTION_ENTRY_QUEUE_SHIFT 7
+#define E1000_REDIRECTION_ENTRIES_PER_REGISTER 4
+
+//
+// Extended receive descriptor status and error bits. The low byte of status
+// matches the legacy descriptor status, and the errors live in the high byte
+// in the same layout as the legacy descriptor errors.
+//
+
+#define E1000_RX_EXTENDED_ERROR_SHIFT 24
 
 //
 // Receive descriptor control register bits.
@@ -535,6 +617,17 @@ Module Name:
 #define E1000_INTERRUPT_PHY_INTERRUPT (1 << 12)
 #define E1000_INTERRUPT_TX_LOW_THRESHOLD (1 << 15)
 #define E1000_INTERRUPT_SMALL_RX_PACKET (1 << 16)
+#define E1000_INTERRUPT_RX_QUEUE0 (1 << 20)
+#define E1000_INTERRUPT_TX_QUEUE0 (1 << 22)
+#define E1000_INTERRUPT_OTHER (1 << 24)
+
+//
+// Define the MSI-X interrupt cause bits belonging to a queue pair.
+//
+
+#define E1000_INTERRUPT_QUEUE_MASK(_Queue)     \
+    ((E1000_INTERRUPT_RX_QUEUE0 << (_Queue)) | \
+     (E1000_INTERRUPT_TX_QUEUE0 << (_Queue)))
 
 //
 // Define the mask of interrupts to enable here.
@@ -547,6 +640,27 @@ Module Name:
      E1000_INTERRUPT_RX_SEQUENCE_ERROR | \
      E1000_INTERRUPT_LINK_STATUS_CHANGE)
 
+//
+// Define the mask of non-queue interrupts to enable when using MSI-X.
+//
+
+#define E1000_INTERRUPT_OTHER_ENABLE_MASK \
+    (E1000_INTERRUPT_OTHER | \
+     E1000_INTERRUPT_RX_SEQUENCE_ERROR | \
+     E1000_INTERRUPT_LINK_STATUS_CHANGE)
+
+//
+// 82574 interrupt vector allocation register bits. Each cause gets a four bit
+// field holding the MSI-X vector index and a valid bit.
+//
+
+#define E1000_IVAR_RX_QUEUE_SHIFT 0
+#define E1000_IVAR_TX_QUEUE_SHIFT 8
+#define E1000_IVAR_OTHER_SHIFT 16
+#define E1000_IVAR_FIELD_BITS 4
+#define E1000_IVAR_VALID 0x8
+#define E1000_IVAR_TX_INTERRUPT_ON_WRITE_BACK (1 << 31)
+
 //
 // Management control register bits
 //
@@ -722,7 +836,9 @@ typedef enum _E1000_REGISTER {
     E1000InterruptCauseSet = 0x00C8,
     E1000InterruptMaskSet = 0x00D0,
     E1000InterruptMaskClear = 0x00D8,
+    E1000InterruptAutoClear = 0x00DC,
     E1000InterruptAckAutoMask = 0x00E0,
+    E1000InterruptVectorAllocation = 0x00E4,
     E1000RxControl = 0x0100,
     E1000EarlyRxThreshold = 0x2008,
     E1000FlowRxThresholdLow = 0x2160,
@@ -906,8 +1022,41 @@ typedef struct _E1000_RX_DESCRIPTOR {
     USHORT VlanTag;
 } PACKED E1000_RX_DESCRIPTOR, *PE1000_RX_DESCRIPTOR;
 
+/*++
+
+Structure Description:
+
+    This structure defines the hardware mandated format for an extended
+    receive descriptor, which the 82574 requires for receive-side scaling.
+    Software fills in the buffer address, and the hardware overwrites it with
+    the RSS information when it writes the descriptor back.
+
+Members:
+
+    Address - Stores the byte aligned buffer address where the received data is
+        put. On write back, this holds the RSS type and the RSS hash.
+
+    StatusErrors - Stores the status bits in the low bits and the error bits
+        in the high byte. See E1000_RX_STATUS_* and E1000_RX_ERROR_*
+        definitions.
+
+    Length - Stores the length of the received data.
+
+    VlanTag - Stores the VLAN information.
+
+--*/
+
+typedef struct _E1000_RX_EXTENDED_DESCRIPTOR {
+    ULONGLONG Address;
+    ULONG StatusErrors;
+    USHORT Length;
+    USHORT VlanTag;
+} PACKED E1000_RX_EXTENDED_DESCRIPTOR, *PE1000_RX_EXTENDED_DESCRIPTOR;
+
 #pragma pack(pop)
 
+typedef struct _E1000_DEVICE E1000_DEVICE, *PE1000_DEVICE;
+
 /*++
 
 Structure Description:
@@ -945,31 +1094,20 @@ typedef struct _E1000_EEPROM_INFO {
 
 Structure Description:
 
-    This structure defines an Intel e1000 LAN device.
+    This structure defines a transmit and receive queue pair of an e1000
+    device.
 
 Members:
 
-    OsDevice - Stores a pointer to the OS device object.
-
-    InterruptLine - Stores the interrupt line that this controller's interrupt
-        comes in on.
-
-    InterruptVector - Stores the interrupt vector that this controller's
-        interrupt comes in on.
-
-    InterruptResourcesFound - Stores a boolean indicating whether or not the
-        interrupt line and interrupt vector fields are valid.
-
-    InterruptHandle - Stores a pointer to the handle received when the
-        interrupt was connected.
+    Device - Stores a pointer back to the device that owns the queue.
 
-    ControllerBase - Stores the virtual address of the memory mapping to the
-        E1000's registers.
+    Index - Stores the zero-based index of the queue.
 
-    FlashBase - Stores a pointer to the alternate memory BAR, used for mapping
-        flash sometimes.
+    InterruptHandle - Stores a pointer to the handle received when the queue's
+        MSI-X interrupt was connected. This is only used in multi-queue mode.
 
-    NetworkLink - Stores a pointer to the core networking link.
+    PendingStatusBits - Stores the bitfield of the queue's interrupt status
+        bits that have yet to be dealt with by software.
 
     RxIoBuffer - Stores a pointer to the I/O buffer associated with the receive
         descriptors.
@@ -1003,6 +1141,65 @@ Structure Description:
 
     TxPacketList - Stores a list of network packets waiting to be sent.
 
+--*/
+
+typedef struct _E1000_QUEUE {
+    PE1000_DEVICE Device;
+    ULONG Index;
+    HANDLE InterruptHandle;
+    ULONG PendingStatusBits;
+    PIO_BUFFER RxIoBuffer;
+    PE1000_RX_DESCRIPTOR RxDescriptors;
+    PNET_PACKET_BUFFER *RxPackets;
+    ULONG RxListBegin;
+    PQUEUED_LOCK RxListLock;
+    PIO_BUFFER TxIoBuffer;
+    PE1000_TX_DESCRIPTOR TxDescriptors;
+    PNET_PACKET_BUFFER *TxPacket;
+    ULONG TxNextReap;
+    ULONG TxNextToUse;
+    PQUEUED_LOCK TxListLock;
+    NET_PACKET_LIST TxPacketList;
+} E1000_QUEUE, *PE1000_QUEUE;
+
+/*++
+
+Structure Description:
+
+    This structure defines an Intel e1000 LAN device.
+
+Members:
+
+    OsDevice - Stores a pointer to the OS device object.
+
+    InterruptLine - Stores the interrupt line that this controller's interrupt
+        comes in on.
+
+    InterruptVector - Stores the interrupt vector that this controller's
+        interrupt comes in on. With MSI-X, this is the first of a contiguous
+        range of vectors, one for each queue followed by the other vector.
+
+    InterruptResourcesFound - Stores a boolean indicating whether or not the
+        interrupt line and interrupt vector fields are valid.
+
+    InterruptHandle - Stores a pointer to the handle received when the
+        interrupt was connected. With MSI-X, this is the interrupt for
+        everything other than the queues.
+
+    ControllerBase - Stores the virtual address of the memory mapping to the
+        E1000's registers.
+
+    FlashBase - Stores a pointer to the alternate memory BAR, used for mapping
+        flash sometimes.
+
+    NetworkLink - Stores a pointer to the core networking link.
+
+    Queues - Stores the transmit and receive queue pairs.
+
+    QueueCount - Stores the number of queue pairs in use. When more than one
+        is in use, receive-side scaling spreads incoming flows across them
+        and each gets its own MSI-X interrupt.
+
     LinkSpeed - Stores the current link speed. If 0, the link is not active.
 
     LinkCheckTimer - Stores a pointer to the timer that fires periodically to
@@ -1034,9 +1231,15 @@ Structure Description:
     ConfigurationLock - Stores a queued lock that synchronizes changes to the
         enabled capabilities field and their supporting hardware registers.
 
+    PciMsiFlags - Stores a bitmask of flags indicating whether or not MSI-X
+        interrupts should be used. See E1000_PCI_MSI_FLAG_* for definitions.
+
+    PciMsiInterface - Stores the interface to enable PCI message signaled
+        interrupts.
+
 --*/
 
-typedef struct _E1000_DEVICE {
+struct _E1000_DEVICE {
     PDEVICE OsDevice;
     ULONGLONG InterruptLine;
     ULONGLONG InterruptVector;
@@ -1045,18 +1248,8 @@ typedef struct _E1000_DEVICE {
     PVOID ControllerBase;
     PVOID FlashBase;
     PNET_LINK NetworkLink;
-    PIO_BUFFER RxIoBuffer;
-    PE1000_RX_DESCRIPTOR RxDescriptors;
-    PNET_PACKET_BUFFER *RxPackets;
-    ULONG RxListBegin;
-    PQUEUED_LOCK RxListLock;
-    PIO_BUFFER TxIoBuffer;
-    PE1000_TX_DESCRIPTOR TxDescriptors;
-    PNET_PACKET_BUFFER *TxPacket;
-    ULONG TxNextReap;
-    ULONG TxNextToUse;
-    PQUEUED_LOCK TxListLock;
-    NET_PACKET_LIST TxPacketList;
+    E1000_QUEUE Queues[E1000_MAX_QUEUES];
+    ULONG QueueCount;
     ULONGLONG LinkSpeed;
     PKTIMER LinkCheckTimer;
     ULONG PendingStatusBits;
@@ -1070,7 +1263,9 @@ typedef struct _E1000_DEVICE {
     ULONG SupportedCapabilities;
     ULONG EnabledCapabilities;
     PQUEUED_LOCK ConfigurationLock;
-} E1000_DEVICE, *PE1000_DEVICE;
+    ULONG PciMsiFlags;
+    INTERFACE_PCI_MSI PciMsiInterface;
+};
 
 //
 // -------------------------------------------------------------------- Globals
@@ -1262,6 +1457,51 @@ Return Value:
 
 --*/
 
+INTERRUPT_STATUS
+E1000pQueueInterruptService (
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the interrupt service routine for a single queue's
+    MSI-X interrupt.
+
+Arguments:
+
+    Context - Supplies the context pointer given to the system when the
+        interrupt was connected. In this case, this points to the e1000 queue.
+
+Return Value:
+
+    Interrupt status.
+
+--*/
+
+INTERRUPT_STATUS
+E1000pQueueInterruptServiceWorker (
+    PVOID Parameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine processes a single queue's MSI-X interrupt at low level.
+
+Arguments:
+
+    Parameter - Supplies an optional parameter passed in by the creator of the
+        work item. In this case, this points to the e1000 queue.
+
+Return Value:
+
+    Interrupt status.
+
+--*/
+
 //
 // Administrative functions called by the hardware side.
 //
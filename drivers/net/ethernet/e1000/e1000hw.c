@@ -175,21 +175,32 @@ E1000pSetReceiveAddress (
 
 KSTATUS
 E1000pFillRxDescriptors (
-    PE1000_DEVICE Device
+    PE1000_QUEUE Queue
     );
 
 VOID
 E1000pReapTxDescriptors (
-    PE1000_DEVICE Device
+    PE1000_QUEUE Queue
     );
 
 VOID
 E1000pReapReceivedFrames (
-    PE1000_DEVICE Device
+    PE1000_QUEUE Queue
+    );
+
+KSTATUS
+E1000pQueueTransmitPackets (
+    PE1000_QUEUE Queue,
+    PNET_PACKET_LIST PacketList
     );
 
 VOID
 E1000pSendPendingPackets (
+    PE1000_QUEUE Queue
+    );
+
+VOID
+E1000pConfigureMultipleQueues (
     PE1000_DEVICE Device
     );
 
@@ -204,6 +215,16 @@ E1000pUpdateFilterMode (
 
 BOOL E1000DisablePacketDropping = FALSE;
 
+//
+// Define the key used to hash incoming flows onto receive queues. This is the
+// widely used default key, which spreads traffic well.
+//
+
+ULONG E1000RssKey[E1000_RSS_KEY_REGISTER_COUNT] = {
+    0xDA565A6D, 0xC20E5B25, 0x3D256741, 0xB08FA343, 0xCB2BCAD0,
+    0xB4307BAE, 0xA32DCB77, 0x0CF23080, 0x3BB7426A, 0xFA01ACBE
+};
+
 E1000_PHY_ENTRY E1000PhyEntries[] = {
     {0x01410C30, E1000PhyM88},
     {0x01410C50, E1000PhyM88},
@@ -263,42 +284,58 @@ Return Value:
 {
 
     PE1000_DEVICE Device;
-    UINTN PacketListCount;
+    ULONG Index;
+    PNET_PACKET_BUFFER Packet;
+    NET_PACKET_LIST QueueLists[E1000_MAX_QUEUES];
+    KSTATUS QueueStatus;
     KSTATUS Status;
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
     Device = (PE1000_DEVICE)DeviceContext;
-    KeAcquireQueuedLock(Device->TxListLock);
-    if (Device->LinkSpeed == 0) {
-        Status = STATUS_NO_NETWORK_CONNECTION;
-        goto SendEnd;
+    if (Device->QueueCount == 1) {
+        return E1000pQueueTransmitPackets(&(Device->Queues[0]), PacketList);
     }
 
     //
-    // If there is any room in the packet list (or dropping packets is
-    // disabled), add all of the packets to the list waiting to be sent.
+    // Sort the packets onto their transmit queues. Packets from the same flow
+    // always pick the same queue, so they are never reordered.
     //
 
-    PacketListCount = Device->TxPacketList.Count;
-    if ((PacketListCount < E1000_MAX_TRANSMIT_PACKET_LIST_COUNT) ||
-        (E1000DisablePacketDropping != FALSE)) {
+    for (Index = 0; Index < Device->QueueCount; Index += 1) {
+        NET_INITIALIZE_PACKET_LIST(&(QueueLists[Index]));
+    }
 
-        NET_APPEND_PACKET_LIST(PacketList, &(Device->TxPacketList));
-        E1000pSendPendingPackets(Device);
-        Status = STATUS_SUCCESS;
+    while (NET_PACKET_LIST_EMPTY(PacketList) == FALSE) {
+        Packet = LIST_VALUE(PacketList->Head.Next,
+                            NET_PACKET_BUFFER,
+                            ListEntry);
+
+        NET_REMOVE_PACKET_FROM_LIST(Packet, PacketList);
+        Index = NetSelectTransmitQueue(Device->NetworkLink, Packet);
+        NET_ADD_PACKET_TO_LIST(Packet, &(QueueLists[Index]));
+    }
 
     //
-    // Otherwise report that the resource is use as it is too busy to handle
-    // more packets.
+    // Hand each queue its packets. Any packets a queue could not take go back
+    // on the caller's list to be released.
     //
 
-    } else {
-        Status = STATUS_RESOURCE_IN_USE;
+    Status = STATUS_SUCCESS;
+    for (Index = 0; Index < Device->QueueCount; Index += 1) {
+        if (NET_PACKET_LIST_EMPTY(&(QueueLists[Index])) != FALSE) {
+            continue;
+        }
+
+        QueueStatus = E1000pQueueTransmitPackets(&(Device->Queues[Index]),
+                                                 &(QueueLists[Index]));
+
+        if (!KSUCCESS(QueueStatus)) {
+            NET_APPEND_PACKET_LIST(&(QueueLists[Index]), PacketList);
+            Status = QueueStatus;
+        }
     }
 
-SendEnd:
-    KeReleaseQueuedLock(Device->TxListLock);
     return Status;
 }
 
@@ -451,6 +488,8 @@ Return Value:
 
     ULONG AllocationSize;
     ULONG Capabilities;
+    ULONG Index;
+    PE1000_QUEUE Queue;
     ULONG ReceiveSize;
     KSTATUS Status;
     ULONG TxDescriptorSize;
@@ -474,110 +513,120 @@ Return Value:
     Device->SupportedCapabilities |= NET_LINK_CAPABILITY_PROMISCUOUS_MODE |
                                      NET_LINK_CAPABILITY_MULTICAST_ALL;
 
-    //
-    // Initialize the transmit and receive list locks.
-    //
-
-    Device->TxListLock = KeCreateQueuedLock();
-    if (Device->TxListLock == NULL) {
-        Status = STATUS_INSUFFICIENT_RESOURCES;
-        goto InitializeDeviceStructuresEnd;
-    }
-
-    Device->RxListLock = KeCreateQueuedLock();
-    if (Device->RxListLock == NULL) {
-        Status = STATUS_INSUFFICIENT_RESOURCES;
-        goto InitializeDeviceStructuresEnd;
-    }
-
     Device->ConfigurationLock = KeCreateQueuedLock();
     if (Device->ConfigurationLock == NULL) {
         Status = STATUS_INSUFFICIENT_RESOURCES;
         goto InitializeDeviceStructuresEnd;
     }
 
-    //
-    // Allocate the receive buffers, including space for the descriptors and
-    // space for the data.
-    //
-
     ASSERT(MmPageSize() >= sizeof(E1000_RX_DESCRIPTOR) * E1000_RX_RING_SIZE);
+    ASSERT(sizeof(E1000_RX_EXTENDED_DESCRIPTOR) ==
+           sizeof(E1000_RX_DESCRIPTOR));
+
+    ASSERT((Device->QueueCount != 0) &&
+           (Device->QueueCount <= E1000_MAX_QUEUES));
 
     ReceiveSize = sizeof(E1000_RX_DESCRIPTOR) * E1000_RX_RING_SIZE;
+    TxDescriptorSize = sizeof(E1000_TX_DESCRIPTOR) * E1000_TX_RING_SIZE;
 
-    ASSERT(Device->RxIoBuffer == NULL);
+    ASSERT(MmPageSize() >= TxDescriptorSize);
 
-    Device->RxIoBuffer = MmAllocateNonPagedIoBuffer(0,
-                                                    MAX_ULONG,
-                                                    16,
-                                                    ReceiveSize,
-                                                    0);
+    for (Index = 0; Index < Device->QueueCount; Index += 1) {
+        Queue = &(Device->Queues[Index]);
+        Queue->Device = Device;
+        Queue->Index = Index;
 
-    if (Device->RxIoBuffer == NULL) {
-        Status = STATUS_INSUFFICIENT_RESOURCES;
-        goto InitializeDeviceStructuresEnd;
-    }
+        //
+        // Initialize the transmit and receive list locks.
+        //
 
-    ASSERT(Device->RxIoBuffer->Fragment[0].VirtualAddress != NULL);
+        Queue->TxListLock = KeCreateQueuedLock();
+        if (Queue->TxListLock == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto InitializeDeviceStructuresEnd;
+        }
 
-    Device->RxDescriptors = Device->RxIoBuffer->Fragment[0].VirtualAddress;
-    Device->RxListBegin = 0;
+        Queue->RxListLock = KeCreateQueuedLock();
+        if (Queue->RxListLock == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto InitializeDeviceStructuresEnd;
+        }
 
-    //
-    // Allocate the transmit descriptors (which don't include the data to
-    // transmit).
-    //
+        //
+        // Allocate the receive buffers, including space for the descriptors
+        // and space for the data.
+        //
 
-    TxDescriptorSize = sizeof(E1000_TX_DESCRIPTOR) * E1000_TX_RING_SIZE;
+        ASSERT(Queue->RxIoBuffer == NULL);
 
-    ASSERT(MmPageSize() >= TxDescriptorSize);
-    ASSERT(Device->TxIoBuffer == NULL);
+        Queue->RxIoBuffer = MmAllocateNonPagedIoBuffer(0,
+                                                       MAX_ULONG,
+                                                       16,
+                                                       ReceiveSize,
+                                                       0);
 
-    Device->TxIoBuffer = MmAllocateNonPagedIoBuffer(0,
-                                                    MAX_ULONG,
-                                                    16,
-                                                    TxDescriptorSize,
-                                                    0);
+        if (Queue->RxIoBuffer == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto InitializeDeviceStructuresEnd;
+        }
 
-    if (Device->TxIoBuffer == NULL) {
-        Status = STATUS_INSUFFICIENT_RESOURCES;
-        goto InitializeDeviceStructuresEnd;
-    }
+        ASSERT(Queue->RxIoBuffer->Fragment[0].VirtualAddress != NULL);
 
-    ASSERT(Device->TxIoBuffer->FragmentCount == 1);
-    ASSERT(Device->TxIoBuffer->Fragment[0].VirtualAddress != NULL);
+        Queue->RxDescriptors = Queue->RxIoBuffer->Fragment[0].VirtualAddress;
+        Queue->RxListBegin = 0;
 
-    Device->TxDescriptors = Device->TxIoBuffer->Fragment[0].VirtualAddress;
-    Device->TxNextReap = 0;
-    Device->TxNextToUse = 0;
-    RtlZeroMemory(Device->TxDescriptors, TxDescriptorSize);
-    NET_INITIALIZE_PACKET_LIST(&(Device->TxPacketList));
+        //
+        // Allocate the transmit descriptors (which don't include the data to
+        // transmit).
+        //
 
-    //
-    // Allocate an array of pointers to net packet buffers that runs parallel
-    // to the transmit and receive arrays.
-    //
+        ASSERT(Queue->TxIoBuffer == NULL);
 
-    AllocationSize = sizeof(PNET_PACKET_BUFFER) *
-                     (E1000_TX_RING_SIZE + E1000_RX_RING_SIZE);
+        Queue->TxIoBuffer = MmAllocateNonPagedIoBuffer(0,
+                                                       MAX_ULONG,
+                                                       16,
+                                                       TxDescriptorSize,
+                                                       0);
 
-    Device->TxPacket = MmAllocatePagedPool(AllocationSize,
-                                           E1000_ALLOCATION_TAG);
+        if (Queue->TxIoBuffer == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto InitializeDeviceStructuresEnd;
+        }
 
-    if (Device->TxPacket == NULL) {
-        Status = STATUS_INSUFFICIENT_RESOURCES;
-        goto InitializeDeviceStructuresEnd;
-    }
+        ASSERT(Queue->TxIoBuffer->FragmentCount == 1);
+        ASSERT(Queue->TxIoBuffer->Fragment[0].VirtualAddress != NULL);
 
-    RtlZeroMemory(Device->TxPacket, AllocationSize);
-    Device->RxPackets = Device->TxPacket + E1000_TX_RING_SIZE;
+        Queue->TxDescriptors = Queue->TxIoBuffer->Fragment[0].VirtualAddress;
+        Queue->TxNextReap = 0;
+        Queue->TxNextToUse = 0;
+        RtlZeroMemory(Queue->TxDescriptors, TxDescriptorSize);
+        NET_INITIALIZE_PACKET_LIST(&(Queue->TxPacketList));
 
-    //
-    // Initialize the receive frame list.
-    //
+        //
+        // Allocate an array of pointers to net packet buffers that runs
+        // parallel to the transmit and receive arrays.
+        //
+
+        AllocationSize = sizeof(PNET_PACKET_BUFFER) *
+                         (E1000_TX_RING_SIZE + E1000_RX_RING_SIZE);
+
+        Queue->TxPacket = MmAllocatePagedPool(AllocationSize,
+                                              E1000_ALLOCATION_TAG);
+
+        if (Queue->TxPacket == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto InitializeDeviceStructuresEnd;
+        }
+
+        RtlZeroMemory(Queue->TxPacket, AllocationSize);
+        Queue->RxPackets = Queue->TxPacket + E1000_TX_RING_SIZE;
 
-    RtlZeroMemory(Device->RxDescriptors,
-                  sizeof(E1000_RX_DESCRIPTOR) * E1000_RX_RING_SIZE);
+        //
+        // Initialize the receive frame list.
+        //
+
+        RtlZeroMemory(Queue->RxDescriptors, ReceiveSize);
+    }
 
     //
     // Disable all interrupts.
@@ -588,36 +637,40 @@ Return Value:
 
 InitializeDeviceStructuresEnd:
     if (!KSUCCESS(Status)) {
-        if (Device->TxListLock != NULL) {
-            KeDestroyQueuedLock(Device->TxListLock);
-            Device->TxListLock = NULL;
-        }
-
-        if (Device->RxListLock != NULL) {
-            KeDestroyQueuedLock(Device->RxListLock);
-            Device->RxListLock = NULL;
-        }
-
         if (Device->ConfigurationLock != NULL) {
             KeDestroyQueuedLock(Device->ConfigurationLock);
             Device->ConfigurationLock = NULL;
         }
 
-        if (Device->RxIoBuffer != NULL) {
-            MmFreeIoBuffer(Device->RxIoBuffer);
-            Device->RxIoBuffer = NULL;
-            Device->RxDescriptors = NULL;
-        }
+        for (Index = 0; Index < E1000_MAX_QUEUES; Index += 1) {
+            Queue = &(Device->Queues[Index]);
+            if (Queue->TxListLock != NULL) {
+                KeDestroyQueuedLock(Queue->TxListLock);
+                Queue->TxListLock = NULL;
+            }
 
-        if (Device->TxIoBuffer != NULL) {
-            MmFreeIoBuffer(Device->TxIoBuffer);
-            Device->TxIoBuffer = NULL;
-            Device->TxDescriptors = NULL;
-        }
+            if (Queue->RxListLock != NULL) {
+                KeDestroyQueuedLock(Queue->RxListLock);
+                Queue->RxListLock = NULL;
+            }
 
-        if (Device->TxPacket != NULL) {
-            MmFreePagedPool(Device->TxPacket);
-            Device->TxPacket = NULL;
+            if (Queue->RxIoBuffer != NULL) {
+                MmFreeIoBuffer(Queue->RxIoBuffer);
+                Queue->RxIoBuffer = NULL;
+                Queue->RxDescriptors = NULL;
+            }
+
+            if (Queue->TxIoBuffer != NULL) {
+                MmFreeIoBuffer(Queue->TxIoBuffer);
+                Queue->TxIoBuffer = NULL;
+                Queue->TxDescriptors = NULL;
+            }
+
+            if (Queue->TxPacket != NULL) {
+                MmFreePagedPool(Queue->TxPacket);
+                Queue->TxPacket = NULL;
+                Queue->RxPackets = NULL;
+            }
         }
     }
 
@@ -652,6 +705,9 @@ Return Value:
     ULONG Index;
     ULONG Management;
     UCHAR NullAddress[ETHERNET_ADDRESS_SIZE];
+    PHYSICAL_ADDRESS PhysicalAddress;
+    PE1000_QUEUE Queue;
+    ULONG QueueIndex;
     ULONG RxChecksumControl;
     ULONG RxControl;
     KSTATUS Status;
@@ -663,10 +719,13 @@ Return Value:
     // Destroy any old packets lying around.
     //
 
-    for (Index = 0; Index < E1000_TX_RING_SIZE; Index += 1) {
-        if (Device->TxPacket[Index] != NULL) {
-            NetFreeBuffer(Device->TxPacket[Index]);
-            Device->TxPacket[Index] = NULL;
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        Queue = &(Device->Queues[QueueIndex]);
+        for (Index = 0; Index < E1000_TX_RING_SIZE; Index += 1) {
+            if (Queue->TxPacket[Index] != NULL) {
+                NetFreeBuffer(Queue->TxPacket[Index]);
+                Queue->TxPacket[Index] = NULL;
+            }
         }
     }
 
@@ -742,9 +801,11 @@ Return Value:
         }
     }
 
-    Status = E1000pFillRxDescriptors(Device);
-    if (!KSUCCESS(Status)) {
-        goto ResetDeviceEnd;
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        Status = E1000pFillRxDescriptors(&(Device->Queues[QueueIndex]));
+        if (!KSUCCESS(Status)) {
+            goto ResetDeviceEnd;
+        }
     }
 
     //
@@ -799,20 +860,31 @@ Return Value:
     // Initialize transmit.
     //
 
-    E1000_WRITE(Device,
-                E1000TxDescriptorLength0,
-                sizeof(E1000_TX_DESCRIPTOR) * E1000_TX_RING_SIZE);
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        Queue = &(Device->Queues[QueueIndex]);
+        PhysicalAddress = Queue->TxIoBuffer->Fragment[0].PhysicalAddress;
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000TxDescriptorLength0, QueueIndex),
+                    sizeof(E1000_TX_DESCRIPTOR) * E1000_TX_RING_SIZE);
 
-    E1000_WRITE(Device,
-                E1000TxDescriptorBaseHigh0,
-                Device->TxIoBuffer->Fragment[0].PhysicalAddress >> 32);
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000TxDescriptorBaseHigh0,
+                                         QueueIndex),
+                    PhysicalAddress >> 32);
 
-    E1000_WRITE(Device,
-                E1000TxDescriptorBaseLow0,
-                (ULONG)(Device->TxIoBuffer->Fragment[0].PhysicalAddress));
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000TxDescriptorBaseLow0, QueueIndex),
+                    (ULONG)PhysicalAddress);
+
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000TxDescriptorTail0, QueueIndex),
+                    0);
+
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000TxDescriptorHead0, QueueIndex),
+                    0);
+    }
 
-    E1000_WRITE(Device, E1000TxDescriptorTail0, 0);
-    E1000_WRITE(Device, E1000TxDescriptorHead0, 0);
     E1000_WRITE(Device, E1000TxIpg, E1000_TX_IPG_VALUE);
     E1000_WRITE(Device, E1000TxInterruptDelayValue, E1000_TX_INTERRUPT_DELAY);
     E1000_WRITE(Device,
@@ -825,15 +897,19 @@ Return Value:
                  E1000_TX_CONTROL_RETRANSMIT_LATE_COLLISION;
 
     E1000_WRITE(Device, E1000TxControl, TxControl);
-    if (Device->MacType == E1000MacI354) {
-        E1000_WRITE(Device,
-                    E1000TxDescriptorControl0,
-                    E1000_TXD_CONTROL_DEFAULT_VALUE_I354);
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        if (Device->MacType == E1000MacI354) {
+            E1000_WRITE(Device,
+                        E1000_QUEUE_REGISTER(E1000TxDescriptorControl0,
+                                             QueueIndex),
+                        E1000_TXD_CONTROL_DEFAULT_VALUE_I354);
 
-    } else {
-        E1000_WRITE(Device,
-                    E1000TxDescriptorControl0,
-                    E1000_TXD_CONTROL_DEFAULT_VALUE);
+        } else {
+            E1000_WRITE(Device,
+                        E1000_QUEUE_REGISTER(E1000TxDescriptorControl0,
+                                             QueueIndex),
+                        E1000_TXD_CONTROL_DEFAULT_VALUE);
+        }
     }
 
     //
@@ -861,41 +937,62 @@ Return Value:
                 E1000RxInterruptAbsoluteDelayTimer,
                 E1000_RX_ABSOLUTE_INTERRUPT_DELAY);
 
-    E1000_WRITE(Device,
-                E1000RxDescriptorLength0,
-                sizeof(E1000_RX_DESCRIPTOR) * E1000_RX_RING_SIZE);
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        Queue = &(Device->Queues[QueueIndex]);
+        PhysicalAddress = Queue->RxIoBuffer->Fragment[0].PhysicalAddress;
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000RxDescriptorLength0, QueueIndex),
+                    sizeof(E1000_RX_DESCRIPTOR) * E1000_RX_RING_SIZE);
 
-    E1000_WRITE(Device,
-                E1000RxDescriptorBaseHigh0,
-                Device->RxIoBuffer->Fragment[0].PhysicalAddress >> 32);
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000RxDescriptorBaseHigh0,
+                                         QueueIndex),
+                    PhysicalAddress >> 32);
 
-    E1000_WRITE(Device,
-                E1000RxDescriptorBaseLow0,
-                (ULONG)(Device->RxIoBuffer->Fragment[0].PhysicalAddress));
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000RxDescriptorBaseLow0, QueueIndex),
+                    (ULONG)PhysicalAddress);
+
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000RxDescriptorTail0, QueueIndex),
+                    E1000_RX_RING_SIZE - 1);
+
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000RxDescriptorHead0, QueueIndex),
+                    0);
+    }
 
-    E1000_WRITE(Device, E1000RxDescriptorTail0, E1000_RX_RING_SIZE - 1);
-    E1000_WRITE(Device, E1000RxDescriptorHead0, 0);
     RxChecksumControl = E1000_RX_CHECKSUM_START | E1000_RX_CHECKSUM_IP_OFFLOAD |
                         E1000_RX_CHECKSUM_TCP_UDP_OFFLOAD |
                         E1000_RX_CHECKSUM_IPV6_OFFLOAD;
 
     E1000_WRITE(Device, E1000RxChecksumControl, RxChecksumControl);
-    if (Device->MacType == E1000MacI354) {
-        E1000_WRITE(Device,
-                    E1000RxDescriptorControl0,
-                    E1000_RXD_CONTROL_DEFAULT_VALUE_I354);
-
-    } else {
-        E1000_WRITE(Device,
-                    E1000RxDescriptorControl0,
-                    E1000_RXD_CONTROL_DEFAULT_VALUE);
+    if (Device->QueueCount > 1) {
+        E1000pConfigureMultipleQueues(Device);
     }
 
-    //
-    // Write the tail again after enabling the ring to kick it into gear.
-    //
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        if (Device->MacType == E1000MacI354) {
+            E1000_WRITE(Device,
+                        E1000_QUEUE_REGISTER(E1000RxDescriptorControl0,
+                                             QueueIndex),
+                        E1000_RXD_CONTROL_DEFAULT_VALUE_I354);
+
+        } else {
+            E1000_WRITE(Device,
+                        E1000_QUEUE_REGISTER(E1000RxDescriptorControl0,
+                                             QueueIndex),
+                        E1000_RXD_CONTROL_DEFAULT_VALUE);
+        }
+
+        //
+        // Write the tail again after enabling the ring to kick it into gear.
+        //
 
-    E1000_WRITE(Device, E1000RxDescriptorTail0, E1000_RX_RING_SIZE - 1);
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000RxDescriptorTail0, QueueIndex),
+                    E1000_RX_RING_SIZE - 1);
+    }
 
     //
     // Enable receive globally. The receive control value may have been changed
@@ -935,20 +1032,35 @@ Return Value:
 
 {
 
+    ULONG Cause;
+    ULONG Mask;
+    ULONG QueueIndex;
+
     //
-    // Enable interrupts.
+    // Enable interrupts. With multiple queues, each queue's causes come in on
+    // its own vector and everything else comes in on the other vector.
     //
 
-    E1000_WRITE(Device, E1000InterruptMaskSet, E1000_INTERRUPT_ENABLE_MASK);
+    Cause = E1000_INTERRUPT_LINK_STATUS_CHANGE;
+    if (Device->QueueCount > 1) {
+        Mask = E1000_INTERRUPT_OTHER_ENABLE_MASK;
+        for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+            Mask |= E1000_INTERRUPT_QUEUE_MASK(QueueIndex);
+        }
+
+        Cause |= E1000_INTERRUPT_OTHER;
+
+    } else {
+        Mask = E1000_INTERRUPT_ENABLE_MASK;
+    }
+
+    E1000_WRITE(Device, E1000InterruptMaskSet, Mask);
 
     //
     // Fire off a link status change interrupt to determine the link parameters.
     //
 
-    E1000_WRITE(Device,
-                E1000InterruptCauseSet,
-                E1000_INTERRUPT_LINK_STATUS_CHANGE);
-
+    E1000_WRITE(Device, E1000InterruptCauseSet, Cause);
     return;
 }
 
@@ -978,7 +1090,7 @@ Return Value:
 {
 
     PE1000_DEVICE Device;
-    USHORT PendingBits;
+    ULONG PendingBits;
 
     Device = (PE1000_DEVICE)Context;
     PendingBits = E1000_READ(Device, E1000InterruptCauseRead);
@@ -1050,17 +1162,25 @@ Return Value:
     }
 
     //
-    // Process new receive frames.
+    // With multiple queues, each queue's own interrupt takes care of its
+    // descriptor rings.
     //
 
-    E1000pReapReceivedFrames(Device);
+    if (Device->QueueCount == 1) {
 
-    //
-    // If the command unit finished what it was up to, reap that memory.
-    //
+        //
+        // Process new receive frames.
+        //
+
+        E1000pReapReceivedFrames(&(Device->Queues[0]));
+
+        //
+        // If the command unit finished what it was up to, reap that memory.
+        //
 
-    if ((PendingBits & E1000_INTERRUPT_TX_DESCRIPTOR_WRITTEN_BACK) != 0) {
-        E1000pReapTxDescriptors(Device);
+        if ((PendingBits & E1000_INTERRUPT_TX_DESCRIPTOR_WRITTEN_BACK) != 0) {
+            E1000pReapTxDescriptors(&(Device->Queues[0]));
+        }
     }
 
     //
@@ -1071,6 +1191,89 @@ Return Value:
     return InterruptStatusClaimed;
 }
 
+INTERRUPT_STATUS
+E1000pQueueInterruptService (
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the interrupt service routine for a single queue's
+    MSI-X interrupt.
+
+Arguments:
+
+    Context - Supplies the context pointer given to the system when the
+        interrupt was connected. In this case, this points to the e1000 queue.
+
+Return Value:
+
+    Interrupt status.
+
+--*/
+
+{
+
+    ULONG PendingBits;
+    PE1000_QUEUE Queue;
+
+    //
+    // MSI-X vectors are never shared, and the hardware already cleared the
+    // queue's causes when it sent the message. Mask them until the worker has
+    // drained the rings.
+    //
+
+    Queue = (PE1000_QUEUE)Context;
+    PendingBits = E1000_INTERRUPT_QUEUE_MASK(Queue->Index);
+    RtlAtomicOr32(&(Queue->PendingStatusBits), PendingBits);
+    E1000_WRITE(Queue->Device, E1000InterruptMaskClear, PendingBits);
+    return InterruptStatusClaimed;
+}
+
+INTERRUPT_STATUS
+E1000pQueueInterruptServiceWorker (
+    PVOID Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine processes a single queue's MSI-X interrupt at low level.
+
+Arguments:
+
+    Parameter - Supplies an optional parameter passed in by the creator of the
+        work item. In this case, this points to the e1000 queue.
+
+Return Value:
+
+    Interrupt status.
+
+--*/
+
+{
+
+    ULONG PendingBits;
+    PE1000_QUEUE Queue;
+
+    Queue = (PE1000_QUEUE)Parameter;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    PendingBits = RtlAtomicExchange32(&(Queue->PendingStatusBits), 0);
+    if (PendingBits == 0) {
+        return InterruptStatusNotClaimed;
+    }
+
+    E1000pReapReceivedFrames(Queue);
+    E1000pReapTxDescriptors(Queue);
+    E1000_WRITE(Queue->Device, E1000InterruptMaskSet, PendingBits);
+    return InterruptStatusClaimed;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
@@ -2546,7 +2749,7 @@ Return Value:
 
 KSTATUS
 E1000pFillRxDescriptors (
-    PE1000_DEVICE Device
+    PE1000_QUEUE Queue
     )
 
 /*++
@@ -2557,7 +2760,7 @@ Routine Description:
 
 Arguments:
 
-    Device - Supplies a pointer to the device.
+    Queue - Supplies a pointer to the queue whose receive ring is filled.
 
 Return Value:
 
@@ -2573,14 +2776,14 @@ Return Value:
     KSTATUS Status;
 
     for (Index = 0; Index < E1000_RX_RING_SIZE; Index += 1) {
-        if (Device->RxPackets[Index] != NULL) {
+        if (Queue->RxPackets[Index] != NULL) {
             continue;
         }
 
         Status = NetAllocateBuffer(0,
                                    E1000_RX_DATA_SIZE,
                                    0,
-                                   Device->NetworkLink,
+                                   Queue->Device->NetworkLink,
                                    0,
                                    &Buffer);
 
@@ -2588,8 +2791,8 @@ Return Value:
             return Status;
         }
 
-        Device->RxPackets[Index] = Buffer;
-        RxDescriptor = &(Device->RxDescriptors[Index]);
+        Queue->RxPackets[Index] = Buffer;
+        RxDescriptor = &(Queue->RxDescriptors[Index]);
         RxDescriptor->Address = Buffer->BufferPhysicalAddress;
         RxDescriptor->Status = 0;
         RxDescriptor->Length = 0;
@@ -2600,7 +2803,7 @@ Return Value:
 
 VOID
 E1000pReapTxDescriptors (
-    PE1000_DEVICE Device
+    PE1000_QUEUE Queue
     )
 
 /*++
@@ -2611,7 +2814,7 @@ Routine Description:
 
 Arguments:
 
-    Device - Supplies a pointer to the device.
+    Queue - Supplies a pointer to the queue to reap.
 
 Return Value:
 
@@ -2626,9 +2829,12 @@ Return Value:
     ULONG ReapCount;
     ULONG ReapIndex;
 
-    KeAcquireQueuedLock(Device->TxListLock);
-    Head = E1000_READ(Device, E1000TxDescriptorHead0);
-    ReapIndex = Device->TxNextReap;
+    KeAcquireQueuedLock(Queue->TxListLock);
+    Head = E1000_READ(Queue->Device,
+                      E1000_QUEUE_REGISTER(E1000TxDescriptorHead0,
+                                           Queue->Index));
+
+    ReapIndex = Queue->TxNextReap;
 
     //
     // If the current head is beyond its previous location, then the number of
@@ -2653,25 +2859,25 @@ Return Value:
 
     if (ReapCount != 0) {
         for (Index = 0; Index < ReapCount; Index += 1) {
-            NetFreeBuffer(Device->TxPacket[ReapIndex]);
-            Device->TxPacket[ReapIndex] = NULL;
+            NetFreeBuffer(Queue->TxPacket[ReapIndex]);
+            Queue->TxPacket[ReapIndex] = NULL;
             ReapIndex += 1;
             if (ReapIndex == E1000_TX_RING_SIZE) {
                 ReapIndex = 0;
             }
         }
 
-        Device->TxNextReap = Head;
-        E1000pSendPendingPackets(Device);
+        Queue->TxNextReap = Head;
+        E1000pSendPendingPackets(Queue);
     }
 
-    KeReleaseQueuedLock(Device->TxListLock);
+    KeReleaseQueuedLock(Queue->TxListLock);
     return;
 }
 
 VOID
 E1000pReapReceivedFrames (
-    PE1000_DEVICE Device
+    PE1000_QUEUE Queue
     )
 
 /*++
@@ -2682,7 +2888,8 @@ Routine Description:
 
 Arguments:
 
-    Device - Supplies a pointer to the device.
+    Queue - Supplies a pointer to the queue whose received frames should be
+        processed.
 
 Return Value:
 
@@ -2694,31 +2901,64 @@ Return Value:
 
     PE1000_RX_DESCRIPTOR Descriptor;
     ULONG DescriptorIndex;
+    UCHAR DescriptorStatus;
+    PE1000_DEVICE Device;
+    UCHAR Errors;
+    PE1000_RX_EXTENDED_DESCRIPTOR ExtendedDescriptor;
     ULONG Flags;
+    USHORT Length;
     ULONG NewTail;
     PNET_PACKET_BUFFER Packet;
+    ULONG StatusErrors;
 
-    KeAcquireQueuedLock(Device->RxListLock);
-    DescriptorIndex = Device->RxListBegin;
-    Descriptor = &(Device->RxDescriptors[DescriptorIndex]);
-    while ((Descriptor->Status & E1000_RX_STATUS_DONE) != 0) {
+    Device = Queue->Device;
+    KeAcquireQueuedLock(Queue->RxListLock);
+    DescriptorIndex = Queue->RxListBegin;
+    while (TRUE) {
+        Descriptor = &(Queue->RxDescriptors[DescriptorIndex]);
+        ExtendedDescriptor = (PE1000_RX_EXTENDED_DESCRIPTOR)Descriptor;
+        Packet = Queue->RxPackets[DescriptorIndex];
 
         //
-        // Handling packets that spawn multiple descriptors is not currently
-        // supported.
+        // Receive-side scaling uses extended descriptors, which lay the
+        // status out differently. The buffer address is overwritten with the
+        // RSS hash when the descriptor is written back.
         //
 
-        ASSERT((Descriptor->Status & E1000_RX_STATUS_END_OF_PACKET) != 0);
+        if (Device->QueueCount > 1) {
+            StatusErrors = ExtendedDescriptor->StatusErrors;
+            if ((StatusErrors & E1000_RX_STATUS_DONE) == 0) {
+                break;
+            }
+
+            DescriptorStatus = (UCHAR)StatusErrors;
+            Errors = (UCHAR)(StatusErrors >> E1000_RX_EXTENDED_ERROR_SHIFT);
+            Length = ExtendedDescriptor->Length;
+
+        } else {
+            DescriptorStatus = Descriptor->Status;
+            if ((DescriptorStatus & E1000_RX_STATUS_DONE) == 0) {
+                break;
+            }
+
+            Errors = Descriptor->Errors;
+            Length = Descriptor->Length;
 
-        if (Descriptor->Errors != 0) {
-            RtlDebugPrint("E1000: RX Packet Error %02x\n", Descriptor->Errors);
+            ASSERT(Packet->BufferPhysicalAddress == Descriptor->Address);
         }
 
-        Packet = Device->RxPackets[DescriptorIndex];
+        //
+        // Handling packets that spawn multiple descriptors is not currently
+        // supported.
+        //
+
+        ASSERT((DescriptorStatus & E1000_RX_STATUS_END_OF_PACKET) != 0);
 
-        ASSERT(Packet->BufferPhysicalAddress == Descriptor->Address);
+        if (Errors != 0) {
+            RtlDebugPrint("E1000: RX Packet Error %02x\n", Errors);
+        }
 
-        Packet->DataSize = Descriptor->Length;
+        Packet->DataSize = Length;
         Packet->DataOffset = 0;
         Packet->FooterOffset = Packet->DataSize;
 
@@ -2727,9 +2967,9 @@ Return Value:
         //
 
         Flags = 0;
-        if ((Descriptor->Status & E1000_RX_STATUS_IGNORE_CHECKSUM) == 0) {
-            if ((Descriptor->Status & E1000_RX_STATUS_IP4_CHECKSUM) != 0) {
-                if ((Descriptor->Errors & E1000_RX_ERROR_IP_CHECKSUM) != 0) {
+        if ((DescriptorStatus & E1000_RX_STATUS_IGNORE_CHECKSUM) == 0) {
+            if ((DescriptorStatus & E1000_RX_STATUS_IP4_CHECKSUM) != 0) {
+                if ((Errors & E1000_RX_ERROR_IP_CHECKSUM) != 0) {
                     Flags |= NET_PACKET_FLAG_IP_CHECKSUM_FAILED;
 
                 } else {
@@ -2737,10 +2977,8 @@ Return Value:
                 }
             }
 
-            if ((Descriptor->Status & E1000_RX_STATUS_TCP_CHECKSUM) != 0) {
-                if ((Descriptor->Errors &
-                     E1000_RX_ERROR_TCP_UDP_CHECKSUM) != 0) {
-
+            if ((DescriptorStatus & E1000_RX_STATUS_TCP_CHECKSUM) != 0) {
+                if ((Errors & E1000_RX_ERROR_TCP_UDP_CHECKSUM) != 0) {
                     Flags |= NET_PACKET_FLAG_TCP_CHECKSUM_FAILED;
 
                 } else {
@@ -2748,10 +2986,8 @@ Return Value:
                 }
             }
 
-            if ((Descriptor->Status & E1000_RX_STATUS_UDP_CHECKSUM) != 0) {
-                if ((Descriptor->Errors &
-                     E1000_RX_ERROR_TCP_UDP_CHECKSUM) != 0) {
-
+            if ((DescriptorStatus & E1000_RX_STATUS_UDP_CHECKSUM) != 0) {
+                if ((Errors & E1000_RX_ERROR_TCP_UDP_CHECKSUM) != 0) {
                     Flags |= NET_PACKET_FLAG_UDP_CHECKSUM_FAILED;
 
                 } else {
@@ -2762,21 +2998,26 @@ Return Value:
 
         Packet->Flags = Flags;
         NetProcessReceivedPacket(Device->NetworkLink, Packet);
-        Descriptor->Status = 0;
+        if (Device->QueueCount > 1) {
+            ExtendedDescriptor->Address = Packet->BufferPhysicalAddress;
+            ExtendedDescriptor->StatusErrors = 0;
+
+        } else {
+            Descriptor->Status = 0;
+        }
+
         DescriptorIndex += 1;
         if (DescriptorIndex == E1000_RX_RING_SIZE) {
             DescriptorIndex = 0;
         }
-
-        Descriptor = &(Device->RxDescriptors[DescriptorIndex]);
     }
 
     //
     // Write the new tail if there is one.
     //
 
-    if (DescriptorIndex != Device->RxListBegin) {
-        Device->RxListBegin = DescriptorIndex;
+    if (DescriptorIndex != Queue->RxListBegin) {
+        Queue->RxListBegin = DescriptorIndex;
         if (DescriptorIndex == 0) {
             NewTail = E1000_RX_RING_SIZE - 1;
 
@@ -2785,16 +3026,86 @@ Return Value:
         }
 
         RtlMemoryBarrier();
-        E1000_WRITE(Device, E1000RxDescriptorTail0, NewTail);
+        E1000_WRITE(Device,
+                    E1000_QUEUE_REGISTER(E1000RxDescriptorTail0, Queue->Index),
+                    NewTail);
     }
 
-    KeReleaseQueuedLock(Device->RxListLock);
+    KeReleaseQueuedLock(Queue->RxListLock);
     return;
 }
 
+KSTATUS
+E1000pQueueTransmitPackets (
+    PE1000_QUEUE Queue,
+    PNET_PACKET_LIST PacketList
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues packets for transmission on a single queue.
+
+Arguments:
+
+    Queue - Supplies a pointer to the queue to send the packets on.
+
+    PacketList - Supplies a pointer to a list of network packets to send.
+        Packets that are accepted are removed from the list.
+
+Return Value:
+
+    STATUS_SUCCESS if all packets were queued.
+
+    STATUS_RESOURCE_IN_USE if the packets were dropped due to the queue
+    being backed up with too many packets to send.
+
+    STATUS_NO_NETWORK_CONNECTION if the link is down.
+
+--*/
+
+{
+
+    UINTN PacketListCount;
+    KSTATUS Status;
+
+    KeAcquireQueuedLock(Queue->TxListLock);
+    if (Queue->Device->LinkSpeed == 0) {
+        Status = STATUS_NO_NETWORK_CONNECTION;
+        goto QueueTransmitPacketsEnd;
+    }
+
+    //
+    // If there is any room in the packet list (or dropping packets is
+    // disabled), add all of the packets to the list waiting to be sent.
+    //
+
+    PacketListCount = Queue->TxPacketList.Count;
+    if ((PacketListCount < E1000_MAX_TRANSMIT_PACKET_LIST_COUNT) ||
+        (E1000DisablePacketDropping != FALSE)) {
+
+        NET_APPEND_PACKET_LIST(PacketList, &(Queue->TxPacketList));
+        E1000pSendPendingPackets(Queue);
+        Status = STATUS_SUCCESS;
+
+    //
+    // Otherwise report that the resource is use as it is too busy to handle
+    // more packets.
+    //
+
+    } else {
+        Status = STATUS_RESOURCE_IN_USE;
+    }
+
+QueueTransmitPacketsEnd:
+    KeReleaseQueuedLock(Queue->TxListLock);
+    return Status;
+}
+
 VOID
 E1000pSendPendingPackets (
-    PE1000_DEVICE Device
+    PE1000_QUEUE Queue
     )
 
 /*++
@@ -2802,11 +3113,12 @@ E1000pSendPendingPackets (
 Routine Description:
 
     This routine sends as many packets as can fit in the hardware descriptor
-    buffer. This routine assumes the command list lock is already held.
+    buffer. This routine assumes the queue's transmit list lock is already
+    held.
 
 Arguments:
 
-    Device - Supplies a pointer to the device.
+    Queue - Supplies a pointer to the queue to send on.
 
 Return Value:
 
@@ -2820,7 +3132,7 @@ Return Value:
     PNET_PACKET_BUFFER Packet;
     ULONG Space;
 
-    if (NET_PACKET_LIST_EMPTY(&(Device->TxPacketList))) {
+    if (NET_PACKET_LIST_EMPTY(&(Queue->TxPacketList))) {
         return;
     }
 
@@ -2830,9 +3142,9 @@ Return Value:
     // queue can never be completely full, otherwise it would look empty.
     //
 
-    if (Device->TxNextToUse >= Device->TxNextReap) {
-        Space = E1000_TX_RING_SIZE - Device->TxNextToUse +
-                Device->TxNextReap - 1;
+    if (Queue->TxNextToUse >= Queue->TxNextReap) {
+        Space = E1000_TX_RING_SIZE - Queue->TxNextToUse +
+                Queue->TxNextReap - 1;
 
     //
     // In the wrapped case, the head is catching up to a slow tail. Use the
@@ -2840,7 +3152,7 @@ Return Value:
     //
 
     } else {
-        Space = Device->TxNextReap - Device->TxNextToUse - 1;
+        Space = Queue->TxNextReap - Queue->TxNextToUse - 1;
     }
 
     //
@@ -2851,15 +3163,15 @@ Return Value:
         return;
     }
 
-    while ((NET_PACKET_LIST_EMPTY(&(Device->TxPacketList)) == FALSE) &&
+    while ((NET_PACKET_LIST_EMPTY(&(Queue->TxPacketList)) == FALSE) &&
            (Space != 0)) {
 
-        Packet = LIST_VALUE(Device->TxPacketList.Head.Next,
+        Packet = LIST_VALUE(Queue->TxPacketList.Head.Next,
                             NET_PACKET_BUFFER,
                             ListEntry);
 
-        NET_REMOVE_PACKET_FROM_LIST(Packet, &(Device->TxPacketList));
-        Descriptor = &(Device->TxDescriptors[Device->TxNextToUse]);
+        NET_REMOVE_PACKET_FROM_LIST(Packet, &(Queue->TxPacketList));
+        Descriptor = &(Queue->TxDescriptors[Queue->TxNextToUse]);
         Descriptor->Address = Packet->BufferPhysicalAddress +
                               Packet->DataOffset;
 
@@ -2870,21 +3182,152 @@ Return Value:
                               E1000_TX_COMMAND_END;
 
         Descriptor->Status = 0;
-        Device->TxPacket[Device->TxNextToUse] = Packet;
+        Queue->TxPacket[Queue->TxNextToUse] = Packet;
 
         //
         // Advance the descriptor, and account for the space.
         //
 
-        Device->TxNextToUse += 1;
-        if (Device->TxNextToUse == E1000_TX_RING_SIZE) {
-            Device->TxNextToUse = 0;
+        Queue->TxNextToUse += 1;
+        if (Queue->TxNextToUse == E1000_TX_RING_SIZE) {
+            Queue->TxNextToUse = 0;
         }
 
         Space -= 1;
     }
 
-    E1000_WRITE(Device, E1000TxDescriptorTail0, Device->TxNextToUse);
+    E1000_WRITE(Queue->Device,
+                E1000_QUEUE_REGISTER(E1000TxDescriptorTail0, Queue->Index),
+                Queue->TxNextToUse);
+
+    return;
+}
+
+VOID
+E1000pConfigureMultipleQueues (
+    PE1000_DEVICE Device
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets up receive-side scaling and the MSI-X interrupt routing
+    for an 82574 using more than one queue. Receive must not be enabled yet.
+
+Arguments:
+
+    Device - Supplies a pointer to the device.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Entry;
+    ULONG EntryShift;
+    ULONG Index;
+    ULONG QueueIndex;
+    ULONG Shift;
+    ULONG Table;
+    ULONG Value;
+
+    ASSERT(Device->MacType == E1000Mac82574);
+    ASSERT((Device->QueueCount > 1) &&
+           (Device->QueueCount <= E1000_MAX_QUEUES));
+
+    //
+    // Route each queue's receive and transmit causes to the queue's MSI-X
+    // vector, and everything else to the vector after the queues.
+    //
+
+    Value = E1000_IVAR_TX_INTERRUPT_ON_WRITE_BACK;
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        Shift = E1000_IVAR_RX_QUEUE_SHIFT +
+                (QueueIndex * E1000_IVAR_FIELD_BITS);
+
+        Value |= (E1000_IVAR_VALID | QueueIndex) << Shift;
+        Shift = E1000_IVAR_TX_QUEUE_SHIFT +
+                (QueueIndex * E1000_IVAR_FIELD_BITS);
+
+        Value |= (E1000_IVAR_VALID | QueueIndex) << Shift;
+    }
+
+    Value |= (E1000_IVAR_VALID | E1000_MSIX_OTHER_VECTOR) <<
+             E1000_IVAR_OTHER_SHIFT;
+
+    E1000_WRITE(Device, E1000InterruptVectorAllocation, Value);
+
+    //
+    // The queue interrupt routines never read the cause register, as that
+    // would clear the causes of the other queues too. Have the hardware clear
+    // each queue's causes when it sends the queue's message instead.
+    //
+
+    Value = 0;
+    for (QueueIndex = 0; QueueIndex < Device->QueueCount; QueueIndex += 1) {
+        Value |= E1000_INTERRUPT_QUEUE_MASK(QueueIndex);
+    }
+
+    E1000_WRITE(Device, E1000InterruptAutoClear, Value);
+    Value = E1000_READ(Device, E1000ExtendedDeviceControl);
+    Value |= E1000_EXTENDED_CONTROL_PBA_SUPPORT;
+    E1000_WRITE(Device, E1000ExtendedDeviceControl, Value);
+
+    //
+    // The hardware only reports the RSS hash, and only distributes packets,
+    // when using extended receive descriptors with the packet checksum field
+    // disabled. The status bits still report checksum offload results.
+    //
+
+    Value = E1000_READ(Device, E1000RxFilterControl);
+    Value |= E1000_RX_FILTER_CONTROL_EXTENDED_STATUS;
+    E1000_WRITE(Device, E1000RxFilterControl, Value);
+    Value = E1000_READ(Device, E1000RxChecksumControl);
+    Value |= E1000_RX_CHECKSUM_PACKET_CHECKSUM_DISABLE;
+    E1000_WRITE(Device, E1000RxChecksumControl, Value);
+
+    //
+    // Program the hash key, then spread the redirection table evenly across
+    // the queues.
+    //
+
+    for (Index = 0; Index < E1000_RSS_KEY_REGISTER_COUNT; Index += 1) {
+        E1000_WRITE_ARRAY(Device, E1000RssRandomKey, Index, E1000RssKey[Index]);
+    }
+
+    Table = 0;
+    for (Entry = 0; Entry < E1000_REDIRECTION_TABLE_SIZE; Entry += 1) {
+        QueueIndex = Entry % Device->QueueCount;
+        EntryShift = (Entry % E1000_REDIRECTION_ENTRIES_PER_REGISTER) *
+                     BITS_PER_BYTE;
+
+        Table |= (QueueIndex << E1000_REDIRECTION_ENTRY_QUEUE_SHIFT) <<
+                 EntryShift;
+
+        if ((Entry % E1000_REDIRECTION_ENTRIES_PER_REGISTER) ==
+            (E1000_REDIRECTION_ENTRIES_PER_REGISTER - 1)) {
+
+            E1000_WRITE_ARRAY(Device,
+                              E1000RedirectionTable,
+                              Entry / E1000_REDIRECTION_ENTRIES_PER_REGISTER,
+                              Table);
+
+            Table = 0;
+        }
+    }
+
+    Value = E1000_MULTIPLE_RX_QUEUES_RSS |
+            E1000_MULTIPLE_RX_QUEUES_HASH_TCP_IP4 |
+            E1000_MULTIPLE_RX_QUEUES_HASH_IP4 |
+            E1000_MULTIPLE_RX_QUEUES_HASH_TCP_IP6 |
+            E1000_MULTIPLE_RX_QUEUES_HASH_IP6_EX |
+            E1000_MULTIPLE_RX_QUEUES_HASH_IP6;
+
+    E1000_WRITE(Device, E1000MultipleRxQueuesCommand, Value);
     return;
 }
 
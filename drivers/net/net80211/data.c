@@ -50,6 +50,11 @@ Net80211pSendNullDataFrame (
     USHORT FrameControl
     );
 
+ULONGLONG
+Net80211pGetPacketListSize (
+    PNET_PACKET_LIST PacketList
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -101,12 +106,14 @@ Return Value:
 {
 
     PNET80211_BSS_ENTRY Bss;
+    ULONGLONG ByteCount;
     PLIST_ENTRY CurrentEntry;
     BOOL DataPaused;
     PNET80211_DATA_FRAME_HEADER Header;
     ULONG Index;
     PNET8022_LLC_HEADER LlcHeader;
     PNET_PACKET_BUFFER Packet;
+    UINTN PacketCount;
     NET_PACKET_LIST PausedPacketList;
     PNET_DEVICE_LINK_SEND Send;
     PNET8022_SNAP_EXTENSION SnapExtension;
@@ -258,6 +265,8 @@ Return Value:
     //
 
     if (NET_PACKET_LIST_EMPTY(PacketList) == FALSE) {
+        ByteCount = Net80211pGetPacketListSize(PacketList);
+        PacketCount = PacketList->Count;
         Send = Link->Properties.Interface.Send;
         Status = Send(Link->Properties.DeviceContext, PacketList);
 
@@ -268,9 +277,30 @@ Return Value:
         //
 
         if (Status == STATUS_RESOURCE_IN_USE) {
+            NetAddLinkStatistic(Link->NetworkLink,
+                                NetLinkStatisticTransmitDrops,
+                                PacketList->Count);
+
+            PacketCount -= PacketList->Count;
+            ByteCount -= Net80211pGetPacketListSize(PacketList);
             NetDestroyBufferList(PacketList);
             Status = STATUS_SUCCESS;
         }
+
+        if (KSUCCESS(Status)) {
+            NetAddLinkStatistic(Link->NetworkLink,
+                                NetLinkStatisticTransmittedPackets,
+                                PacketCount);
+
+            NetAddLinkStatistic(Link->NetworkLink,
+                                NetLinkStatisticTransmittedBytes,
+                                ByteCount);
+
+        } else {
+            NetAddLinkStatistic(Link->NetworkLink,
+                                NetLinkStatisticTransmitErrors,
+                                PacketCount);
+        }
     }
 
     Net80211pBssEntryReleaseReference(Bss);
@@ -715,3 +745,42 @@ Return Value:
     return Status;
 }
 
+ULONGLONG
+Net80211pGetPacketListSize (
+    PNET_PACKET_LIST PacketList
+    )
+
+/*++
+
+Routine Description:
+
+    This routine totals up the number of bytes in a list of packets, for the
+    link statistics.
+
+Arguments:
+
+    PacketList - Supplies a pointer to the packet list.
+
+Return Value:
+
+    Returns the total size of the packets, in bytes.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PNET_PACKET_BUFFER Packet;
+    ULONGLONG Size;
+
+    Size = 0;
+    CurrentEntry = PacketList->Head.Next;
+    while (CurrentEntry != &(PacketList->Head)) {
+        Packet = LIST_VALUE(CurrentEntry, NET_PACKET_BUFFER, ListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        Size += Packet->FooterOffset - Packet->DataOffset;
+    }
+
+    return Size;
+}
+
@@ -65,6 +65,13 @@ Module Name:
      (((_NewSocket)->Flags & NET_SOCKET_FLAG_REUSE_TIME_WAIT) != 0) && \
      (((_OldSocket)->Flags & NET_SOCKET_FLAG_REUSE_TIME_WAIT) != 0))
 
+//
+// This macro converts a socket hash value into a bucket index.
+//
+
+#define NET_SOCKET_HASH_INDEX(_Hash) \
+    (((_Hash) ^ ((_Hash) >> 16)) & (NET_SOCKET_HASH_BUCKET_COUNT - 1))
+
 //
 // ---------------------------------------------------------------- Definitions
 //
@@ -78,6 +85,13 @@ Module Name:
 #define NET_EPHEMERAL_PORT_COUNT \
     (NET_EPHEMERAL_PORT_END - NET_EPHEMERAL_PORT_START)
 
+//
+// Define the FNV-1a constants used to hash socket addresses.
+//
+
+#define NET_SOCKET_HASH_SEED 0x811C9DC5
+#define NET_SOCKET_HASH_PRIME 0x01000193
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -145,6 +159,33 @@ NetpCompareUnboundSockets (
     PRED_BLACK_TREE_NODE SecondNode
     );
 
+VOID
+NetpRehashSocket (
+    PNET_SOCKET Socket,
+    NET_SOCKET_BINDING_TYPE BindingType,
+    PNETWORK_ADDRESS LocalReceiveAddress,
+    PNETWORK_ADDRESS RemoteAddress
+    );
+
+VOID
+NetpUnhashSocket (
+    PNET_SOCKET Socket
+    );
+
+PNET_SOCKET
+NetpFindHashedSocket (
+    PNET_PROTOCOL_ENTRY Protocol,
+    PNETWORK_ADDRESS LocalAddress,
+    PNETWORK_ADDRESS RemoteAddress
+    );
+
+ULONG
+NetpHashNetworkAddress (
+    PNETWORK_ADDRESS Address,
+    BOOL PortOnly,
+    ULONG Hash
+    );
+
 COMPARISON_RESULT
 NetpCompareAddressTranslationEntries (
     PRED_BLACK_TREE Tree,
@@ -257,6 +298,10 @@ Return Value:
         Properties->TransmitAlignment = 1;
     }
 
+    if (Properties->QueueCount == 0) {
+        Properties->QueueCount = 1;
+    }
+
     if ((!POWER_OF_2(Properties->TransmitAlignment)) ||
         (Properties->PhysicalAddress.Domain == NetDomainInvalid) ||
         (Properties->MaxPhysicalAddress == 0) ||
@@ -282,6 +327,11 @@ Return Value:
         goto AddLinkEnd;
     }
 
+    Status = NetpCreateLinkStatistics(Link);
+    if (!KSUCCESS(Status)) {
+        goto AddLinkEnd;
+    }
+
     for (Index = 0; Index < NetDomainSocketNetworkCount; Index += 1) {
         INITIALIZE_LIST_HEAD(&(Link->LinkAddressArray[Index]));
     }
@@ -432,6 +482,7 @@ Return Value:
                 KeDestroyEvent(Link->AddressTranslationEvent);
             }
 
+            NetpDestroyLinkStatistics(Link);
             MmFreePagedPool(Link);
             Link = NULL;
         }
@@ -876,6 +927,13 @@ Return Value:
         KeReleaseSharedExclusiveLockExclusive(NetLinkListLock);
     }
 
+    //
+    // Remove every route going out over the link, as each holds a reference
+    // on it.
+    //
+
+    NetpRemoveLinkRoutes(Link, NULL);
+
     //
     // Dereference the link. The final clean-up will be triggered once the last
     // reference is released.
@@ -885,6 +943,136 @@ Return Value:
     return;
 }
 
+NET_API
+ULONG
+NetComputeFlowHash (
+    PNETWORK_ADDRESS Source,
+    PNETWORK_ADDRESS Destination
+    )
+
+/*++
+
+Routine Description:
+
+    This routine computes the flow hash for packets traveling between the
+    given addresses and ports.
+
+Arguments:
+
+    Source - Supplies a pointer to the source address and port of the flow.
+
+    Destination - Supplies a pointer to the destination address and port of
+        the flow.
+
+Return Value:
+
+    Returns the flow hash.
+
+--*/
+
+{
+
+    ULONG Hash;
+
+    Hash = NetpHashNetworkAddress(Source, FALSE, NET_SOCKET_HASH_SEED);
+    Hash = NetpHashNetworkAddress(Destination, FALSE, Hash);
+    return Hash;
+}
+
+NET_API
+ULONG
+NetSelectTransmitQueue (
+    PNET_LINK Link,
+    PNET_PACKET_BUFFER Packet
+    )
+
+/*++
+
+Routine Description:
+
+    This routine selects the transmit queue a packet should be sent on for a
+    multi-queue link. Packets of the same flow always land on the same queue,
+    so they are never reordered with respect to each other.
+
+Arguments:
+
+    Link - Supplies a pointer to the link the packet is being sent on.
+
+    Packet - Supplies a pointer to the packet being sent.
+
+Return Value:
+
+    Returns the zero-based index of the transmit queue to use.
+
+--*/
+
+{
+
+    ULONG Hash;
+    ULONG QueueCount;
+
+    QueueCount = Link->Properties.QueueCount;
+    if (QueueCount <= 1) {
+        return 0;
+    }
+
+    //
+    // The low bits of the hash were mixed last, so fold in the high bits
+    // before picking a queue.
+    //
+
+    Hash = Packet->FlowHash;
+    Hash ^= Hash >> 16;
+    return Hash % QueueCount;
+}
+
+NET_API
+VOID
+NetGetQueueProcessorSet (
+    PNET_LINK Link,
+    ULONG QueueIndex,
+    PPROCESSOR_SET ProcessorSet
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the processor a multi-queue link should direct the
+    given queue's interrupts to. Queues are spread round robin across the
+    active processors so that receive processing for different flows runs in
+    parallel.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+    QueueIndex - Supplies the zero-based index of the queue.
+
+    ProcessorSet - Supplies a pointer where the target processor set is
+        returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG ProcessorCount;
+
+    ProcessorCount = KeGetActiveProcessorCount();
+    if ((Link->Properties.QueueCount <= 1) || (ProcessorCount <= 1)) {
+        ProcessorSet->Target = ProcessorTargetAny;
+        return;
+    }
+
+    ProcessorSet->Target = ProcessorTargetSingleProcessor;
+    ProcessorSet->U.Number = QueueIndex % ProcessorCount;
+    return;
+}
+
 NET_API
 KSTATUS
 NetFindLinkForLocalAddress (
@@ -1045,6 +1233,16 @@ Return Value:
     ASSERT(KeGetRunLevel() == RunLevelLow);
     ASSERT(RemoteAddress->Domain < NetDomainSocketNetworkCount);
 
+    //
+    // Ask the routing table first. If no route covers the destination, fall
+    // back to the first link that is up and configured.
+    //
+
+    Status = NetpFindRoutedLink(RemoteAddress, LinkResult, NULL);
+    if (KSUCCESS(Status)) {
+        return Status;
+    }
+
     Domain = RemoteAddress->Domain;
     KeAcquireSharedExclusiveLockShared(NetLinkListLock);
     if (LIST_EMPTY(&NetLinkList)) {
@@ -1076,13 +1274,6 @@ Return Value:
             continue;
         }
 
-        //
-        // TODO: Properly determine the route for this destination, rather
-        // than just connecting through the first working network link and
-        // first address inside it. Make sure to not use the routing tables if
-        // SOCKET_IO_DONT_ROUTE is set at time of send/receive.
-        //
-
         KeAcquireQueuedLock(Link->QueuedLock);
         if (LIST_EMPTY(LinkAddressList) == FALSE) {
             CurrentAddressEntry = LinkAddressList->Next;
@@ -1195,6 +1386,48 @@ Return Value:
     return Status;
 }
 
+NET_API
+VOID
+NetEnumerateLinks (
+    PNET_LINK_ENUMERATION_ROUTINE Routine,
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine calls the given routine for each network link in the system.
+
+Arguments:
+
+    Routine - Supplies a pointer to the routine to call for each link.
+
+    Context - Supplies a context pointer to pass to the routine.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PNET_LINK CurrentLink;
+
+    KeAcquireSharedExclusiveLockShared(NetLinkListLock);
+    CurrentEntry = NetLinkList.Next;
+    while (CurrentEntry != &NetLinkList) {
+        CurrentLink = LIST_VALUE(CurrentEntry, NET_LINK, ListEntry);
+        Routine(CurrentLink, Context);
+        CurrentEntry = CurrentEntry->Next;
+    }
+
+    KeReleaseSharedExclusiveLockShared(NetLinkListLock);
+    return;
+}
+
 NET_API
 KSTATUS
 NetCreateLinkAddressEntry (
@@ -1335,6 +1568,7 @@ Return Value:
                  &(Link->LinkAddressArray[Address->Domain]));
 
     KeReleaseQueuedLock(Link->QueuedLock);
+    NetpAddLinkAddressRoutes(Link, LinkAddress);
     Status = STATUS_SUCCESS;
 
 CreateLinkAddressEnd:
@@ -1378,6 +1612,7 @@ Return Value:
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
+    NetpRemoveLinkRoutes(Link, LinkAddress);
     KeAcquireQueuedLock(Link->QueuedLock);
     LIST_REMOVE(&(LinkAddress->ListEntry));
     KeReleaseQueuedLock(Link->QueuedLock);
@@ -1964,11 +2199,13 @@ Return Value:
     NET_LINK_LOCAL_ADDRESS LocalInformationBuffer;
     BOOL LockHeld;
     PNET_NETWORK_ENTRY Network;
+    PNETWORK_ADDRESS NewReceiveAddress;
     ULONG OldFlags;
     ULONG OriginalPort;
     PNET_PROTOCOL_ENTRY Protocol;
     PNETWORK_ADDRESS ReceiveAddress;
     BOOL Reinsert;
+    PNET_ROUTE Route;
     NET_SOCKET SearchSocket;
     PNETWORK_ADDRESS SendAddress;
     BOOL SkipLocalValidation;
@@ -1988,18 +2225,25 @@ Return Value:
     Protocol = Socket->Protocol;
     Network = Socket->Network;
     Reinsert = FALSE;
+    Route = NULL;
 
     //
     // If the socket is to be fully bound, then a remote address must have been
     // supplied. Make sure local information is present as well via an implicit
-    // local binding.
+    // local binding. Hang on to the route used so the socket can cache it.
     //
 
     if ((BindingType == SocketFullyBound) && (LocalInformation == NULL)) {
         OriginalPort = RemoteAddress->Port;
         RemoteAddress->Port = 0;
-        Status = NetFindLinkForRemoteAddress(RemoteAddress,
-                                             &LocalInformationBuffer);
+        Status = NetpFindRoutedLink(RemoteAddress,
+                                    &LocalInformationBuffer,
+                                    &Route);
+
+        if (!KSUCCESS(Status)) {
+            Status = NetFindLinkForRemoteAddress(RemoteAddress,
+                                                 &LocalInformationBuffer);
+        }
 
         RemoteAddress->Port = OriginalPort;
         if (!KSUCCESS(Status)) {
@@ -2351,17 +2595,11 @@ Return Value:
     }
 
     //
-    // This socket is good to go to use the remote address.
+    // This socket is good to go to use the remote address. It gets copied in
+    // when the socket moves hash buckets below.
     //
 
-    if (RemoteAddress != NULL) {
-
-        ASSERT(BindingType == SocketFullyBound);
-
-        RtlCopyMemory(&(Socket->RemoteAddress),
-                      RemoteAddress,
-                      sizeof(NETWORK_ADDRESS));
-    }
+    ASSERT((RemoteAddress == NULL) || (BindingType == SocketFullyBound));
 
     //
     // If the current local information is to be overwritten, then zero it out.
@@ -2373,6 +2611,11 @@ Return Value:
         NetLinkReleaseReference(Socket->Link);
         Socket->Link = NULL;
         Socket->LinkAddress = NULL;
+        if (Socket->Route != NULL) {
+            NetRouteReleaseReference(Socket->Route);
+            Socket->Route = NULL;
+        }
+
         RtlCopyMemory(&(Socket->PacketSizeInformation),
                       &(Socket->UnboundPacketSizeInformation),
                       sizeof(NET_PACKET_SIZE_INFORMATION));
@@ -2382,6 +2625,7 @@ Return Value:
     // Set the local information in the socket if it isn't already set.
     //
 
+    NewReceiveAddress = NULL;
     if (Socket->Link == NULL) {
 
         ASSERT(LocalInformation != NULL);
@@ -2411,16 +2655,15 @@ Return Value:
         // from having that broadcast/multicast address being overwritten when
         // it connects to a remote address. The send address, however, should
         // be updated, as that is specific to the link that can reach the
-        // remote address.
+        // remote address. Lookups compare against the receive address, so it
+        // is copied in when the socket moves hash buckets below.
         //
 
         if ((Socket->BindingType < SocketLocallyBound) ||
             (Socket->BindingType == SocketBindingInvalid) ||
             ((Flags & NET_SOCKET_BINDING_FLAG_OVERWRITE_LOCAL) != 0)) {
 
-            RtlCopyMemory(&(Socket->LocalReceiveAddress),
-                          ReceiveAddress,
-                          sizeof(NETWORK_ADDRESS));
+            NewReceiveAddress = ReceiveAddress;
         }
 
         RtlCopyMemory(&(Socket->LocalSendAddress),
@@ -2453,6 +2696,16 @@ Return Value:
         IoSocketAddReference(&(Socket->KernelSocket));
     }
 
+    //
+    // Move the socket to the hash bucket for its new binding, filling in the
+    // new addresses along the way. Until now it stayed in its old bucket, if
+    // any, with its old addresses, so that packets for its old binding kept
+    // finding it. On failure the addresses are untouched, so the hash is
+    // already correct.
+    //
+
+    NetpRehashSocket(Socket, BindingType, NewReceiveAddress, RemoteAddress);
+
     //
     // Welcome this new friend into the bound sockets tree.
     //
@@ -2460,7 +2713,19 @@ Return Value:
     RtlRedBlackTreeInsert(&(Protocol->SocketTree[BindingType]),
                           &(Socket->TreeEntry));
 
-    Socket->BindingType = BindingType;
+    //
+    // Cache the route to the remote address so sends don't have to look it up
+    // again, as long as it goes out the link the socket ended up on.
+    //
+
+    if ((Route != NULL) &&
+        (Socket->Route == NULL) &&
+        (Route->Link == Socket->Link)) {
+
+        Socket->Route = Route;
+        Route = NULL;
+    }
+
     Status = STATUS_SUCCESS;
 
 BindSocketEnd:
@@ -2484,6 +2749,10 @@ Return Value:
         NetLinkReleaseReference(LocalInformationBuffer.Link);
     }
 
+    if (Route != NULL) {
+        NetRouteReleaseReference(Route);
+    }
+
     return Status;
 }
 
@@ -2513,6 +2782,7 @@ Return Value:
 {
 
     PNET_PROTOCOL_ENTRY Protocol;
+    NETWORK_ADDRESS RemoteAddress;
     KSTATUS Status;
 
     //
@@ -2533,22 +2803,20 @@ Return Value:
     //
     // The disconnect just wipes out the remote address. The socket may
     // have been implicitly bound on the connect. So be it. It stays
-    // locally bound.
+    // locally bound. Any cached route stays with the socket like the link
+    // does, since senders look at it without the lock. It no longer
+    // matches the remote address, so it won't get used.
     //
 
-    RtlZeroMemory(&(Socket->RemoteAddress), sizeof(NETWORK_ADDRESS));
+    RtlZeroMemory(&RemoteAddress, sizeof(NETWORK_ADDRESS));
 
     //
     // If the socket was previously inactive before becoming fully bound,
-    // return it to the inactive state and clear it from the last found
-    // cache of one.
+    // return it to the inactive state.
     //
 
     if ((Socket->Flags & NET_SOCKET_FLAG_PREVIOUSLY_ACTIVE) == 0) {
         RtlAtomicAnd32(&(Socket->Flags), ~NET_SOCKET_FLAG_ACTIVE);
-        if (Socket == Protocol->LastSocket) {
-            Protocol->LastSocket = NULL;
-        }
     }
 
     //
@@ -2560,10 +2828,11 @@ Return Value:
     RtlRedBlackTreeRemove(&(Protocol->SocketTree[SocketFullyBound]),
                           &(Socket->TreeEntry));
 
+    NetpRehashSocket(Socket, SocketLocallyBound, NULL, &RemoteAddress);
     RtlRedBlackTreeInsert(&(Protocol->SocketTree[SocketLocallyBound]),
                           &(Socket->TreeEntry));
 
-    Socket->BindingType = SocketLocallyBound;
+    Status = STATUS_SUCCESS;
 
 DisconnectSocketEnd:
     KeReleaseSharedExclusiveLockExclusive(Protocol->SocketLock);
@@ -2667,7 +2936,6 @@ Return Value:
     BOOL FindAll;
     PRED_BLACK_TREE_NODE FoundNode;
     PNET_SOCKET FoundSocket;
-    PNET_SOCKET LastSocket;
     PNETWORK_ADDRESS LocalAddress;
     PNET_NETWORK_ENTRY Network;
     PRED_BLACK_TREE_NODE NextNode;
@@ -2726,30 +2994,22 @@ Return Value:
     }
 
     //
-    // Check to see if the given remote and local addresses match the last
-    // fully bound socket found. This speeds up the search process when there
-    // isn't a whole lot of activity. This cannot be done if multiple sockets
-    // need to be found as it would start the search iteration in the wrong
-    // location.
+    // A unicast packet goes to at most one socket. Look it up in the hash
+    // tables, which only need the lock for a single bucket rather than the
+    // protocol's socket lock.
     //
 
-    KeAcquireSharedExclusiveLockShared(Protocol->SocketLock);
     if (FindAll == FALSE) {
-        LastSocket = Protocol->LastSocket;
-        if (LastSocket != NULL) {
-
-            ASSERT(LastSocket->BindingType == SocketFullyBound);
+        FoundSocket = NetpFindHashedSocket(Protocol,
+                                           LocalAddress,
+                                           RemoteAddress);
 
-            Result = NetpMatchFullyBoundSocket(LastSocket,
-                                               LocalAddress,
-                                               RemoteAddress);
-
-            if (Result == ComparisonResultSame) {
-                FoundNode = NULL;
-                FoundSocket = LastSocket;
-                goto FindSocketEnd;
-            }
+        Status = STATUS_NOT_FOUND;
+        if (FoundSocket != NULL) {
+            Status = STATUS_SUCCESS;
         }
+
+        goto FindSocketEnd;
     }
 
     //
@@ -2764,213 +3024,165 @@ Return Value:
                   RemoteAddress,
                   sizeof(NETWORK_ADDRESS));
 
-    //
-    // If only one socket needs to be found check each binding tree looking
-    // for a match, starting with the most specified parameters (local and
-    // remote address), and working towards the most generic parameters
-    // (local port only).
-    //
-
-    if (FindAll == FALSE) {
-        Tree = &(Protocol->SocketTree[SocketFullyBound]);
-        FoundNode = RtlRedBlackTreeSearch(Tree, &(SearchEntry.TreeEntry));
-        if (FoundNode != NULL) {
-            goto FindSocketEnd;
-        }
-
-        Tree = &(Protocol->SocketTree[SocketLocallyBound]);
-        FoundNode = RtlRedBlackTreeSearch(Tree, &(SearchEntry.TreeEntry));
-        if (FoundNode != NULL) {
-            goto FindSocketEnd;
-        }
-
-        Tree = &(Protocol->SocketTree[SocketUnbound]);
-        FoundNode = RtlRedBlackTreeSearch(Tree, &(SearchEntry.TreeEntry));
-        if (FoundNode != NULL) {
-            goto FindSocketEnd;
-        }
-
     //
     // Otherwise go about finding the lowest socket in the unbound tree that
     // matches the criteria. Return it. The caller should call again and this
     // will pick up where it left off, iterating through that first tree. When
-    // that tree is exhausted of matches, it will move to the next tree. This
-    // could greatly benefit from a hash table. RTL is yet to include a hash
-    // table library as the problem of how to grow hash tables is yet to be
-    // investigated.
+    // that tree is exhausted of matches, it will move to the next tree.
     //
 
-    } else {
-        BindingType = SocketUnbound;
-        if (PreviousSocket != NULL) {
-            BindingType = PreviousSocket->BindingType;
-        }
-
-        FoundNode = NULL;
-        while (BindingType < SocketBindingTypeCount) {
-            Tree = &(Protocol->SocketTree[BindingType]);
-            BindingType += 1;
+    KeAcquireSharedExclusiveLockShared(Protocol->SocketLock);
+    BindingType = SocketUnbound;
+    if (PreviousSocket != NULL) {
+        BindingType = PreviousSocket->BindingType;
+    }
 
-            //
-            // Pick up where the last search left off if a previous socket was
-            // provided.
-            //
+    FoundNode = NULL;
+    while (BindingType < SocketBindingTypeCount) {
+        Tree = &(Protocol->SocketTree[BindingType]);
+        BindingType += 1;
 
-            if (PreviousSocket != NULL) {
-                PreviousNode = &(PreviousSocket->TreeEntry);
-                while (TRUE) {
-                    NextNode = RtlRedBlackTreeGetNextNode(Tree,
-                                                          FALSE,
-                                                          PreviousNode);
+        //
+        // Pick up where the last search left off if a previous socket was
+        // provided.
+        //
 
-                    if (NextNode == NULL) {
-                        break;
-                    }
+        if (PreviousSocket != NULL) {
+            PreviousNode = &(PreviousSocket->TreeEntry);
+            while (TRUE) {
+                NextNode = RtlRedBlackTreeGetNextNode(Tree,
+                                                      FALSE,
+                                                      PreviousNode);
 
-                    NextSocket = RED_BLACK_TREE_VALUE(NextNode,
-                                                      NET_SOCKET,
-                                                      TreeEntry);
+                if (NextNode == NULL) {
+                    break;
+                }
 
-                    if ((NextSocket->Flags & NET_SOCKET_FLAG_ACTIVE) == 0) {
-                        PreviousNode = NextNode;
-                        continue;
-                    }
+                NextSocket = RED_BLACK_TREE_VALUE(NextNode,
+                                                  NET_SOCKET,
+                                                  TreeEntry);
 
-                    break;
+                if ((NextSocket->Flags & NET_SOCKET_FLAG_ACTIVE) == 0) {
+                    PreviousNode = NextNode;
+                    continue;
                 }
 
-                if (NextNode != NULL) {
-                    Result = Tree->CompareFunction(Tree,
-                                                   NextNode,
-                                                   &(SearchEntry.TreeEntry));
+                break;
+            }
 
-                    if (Result == ComparisonResultSame) {
-                        FoundNode = NextNode;
-                        goto FindSocketEnd;
-                    }
+            if (NextNode != NULL) {
+                Result = Tree->CompareFunction(Tree,
+                                               NextNode,
+                                               &(SearchEntry.TreeEntry));
+
+                if (Result == ComparisonResultSame) {
+                    FoundNode = NextNode;
+                    goto FindSocketTreeEnd;
                 }
+            }
 
-                //
-                // There are no more matching sockets in this tree. Skip to the
-                // next tree.
-                //
+            //
+            // There are no more matching sockets in this tree. Skip to the
+            // next tree.
+            //
+
+            PreviousSocket = NULL;
+            continue;
 
-                PreviousSocket = NULL;
+        //
+        // Otherwise find the first matching, active socket in the new tree.
+        //
+
+        } else {
+            NextNode = RtlRedBlackTreeSearch(Tree,
+                                             &(SearchEntry.TreeEntry));
+
+            if (NextNode == NULL) {
                 continue;
+            }
 
             //
-            // Otherwise find the first matching, active socket in the new tree.
+            // A match was found. Find the lowest match in the tree. When
+            // the loop exits, it will be the previous node touched.
             //
 
-            } else {
-                NextNode = RtlRedBlackTreeSearch(Tree,
-                                                 &(SearchEntry.TreeEntry));
+            do {
+                PreviousNode = NextNode;
+                NextNode = RtlRedBlackTreeGetNextNode(Tree,
+                                                      TRUE,
+                                                      PreviousNode);
 
                 if (NextNode == NULL) {
-                    continue;
+                    break;
                 }
 
-                //
-                // A match was found. Find the lowest match in the tree. When
-                // the loop exits, it will be the previous node touched.
-                //
+                Result = Tree->CompareFunction(Tree,
+                                               NextNode,
+                                               &(SearchEntry.TreeEntry));
 
-                do {
-                    PreviousNode = NextNode;
-                    NextNode = RtlRedBlackTreeGetNextNode(Tree,
-                                                          TRUE,
-                                                          PreviousNode);
+            } while (Result == ComparisonResultSame);
 
-                    if (NextNode == NULL) {
-                        break;
-                    }
+            //
+            // Now move forward finding the first active socket that
+            // matches.
+            //
 
-                    Result = Tree->CompareFunction(Tree,
-                                                   NextNode,
-                                                   &(SearchEntry.TreeEntry));
+            NextNode = PreviousNode;
+            do {
+                NextSocket = RED_BLACK_TREE_VALUE(NextNode,
+                                                  NET_SOCKET,
+                                                  TreeEntry);
 
-                } while (Result == ComparisonResultSame);
-
-                //
-                // Now move forward finding the first active socket that
-                // matches.
-                //
-
-                NextNode = PreviousNode;
-                do {
-                    NextSocket = RED_BLACK_TREE_VALUE(NextNode,
-                                                      NET_SOCKET,
-                                                      TreeEntry);
-
-                    if ((NextSocket->Flags & NET_SOCKET_FLAG_ACTIVE) != 0) {
-                        FoundNode = NextNode;
-                        goto FindSocketEnd;
-                    }
+                if ((NextSocket->Flags & NET_SOCKET_FLAG_ACTIVE) != 0) {
+                    FoundNode = NextNode;
+                    goto FindSocketTreeEnd;
+                }
 
-                    NextNode = RtlRedBlackTreeGetNextNode(Tree,
-                                                          FALSE,
-                                                          NextNode);
+                NextNode = RtlRedBlackTreeGetNextNode(Tree,
+                                                      FALSE,
+                                                      NextNode);
 
-                    if (NextNode == NULL) {
-                        break;
-                    }
+                if (NextNode == NULL) {
+                    break;
+                }
 
-                    Result = Tree->CompareFunction(Tree,
-                                                   NextNode,
-                                                   &(SearchEntry.TreeEntry));
+                Result = Tree->CompareFunction(Tree,
+                                               NextNode,
+                                               &(SearchEntry.TreeEntry));
 
-                } while (Result == ComparisonResultSame);
+            } while (Result == ComparisonResultSame);
 
-                //
-                // If no active sockets were found, move to the next tree.
-                //
+            //
+            // If no active sockets were found, move to the next tree.
+            //
 
-                continue;
-            }
+            continue;
         }
     }
 
-FindSocketEnd:
+FindSocketTreeEnd:
+    Status = STATUS_NOT_FOUND;
     if (FoundNode != NULL) {
         FoundSocket = RED_BLACK_TREE_VALUE(FoundNode, NET_SOCKET, TreeEntry);
-    }
-
-    Status = STATUS_NOT_FOUND;
-    if (FoundSocket != NULL) {
 
         //
-        // If the socket is not active, act as if it were never seen. The
-        // cached socket should never be found as inactive. Deactivating the
-        // cached socket clears the cache.
+        // If the socket is not active, act as if it were never seen.
+        // Otherwise, increment the reference count so the socket cannot
+        // disappear once the lock is released.
         //
 
         if ((FoundSocket->Flags & NET_SOCKET_FLAG_ACTIVE) == 0) {
-
-            ASSERT(FoundSocket != Protocol->LastSocket);
-
             FoundSocket = NULL;
 
-        //
-        // Otherwise, increment the reference count so the socket cannot
-        // disappear once the lock is released.
-        //
-
         } else {
             IoSocketAddReference(&(FoundSocket->KernelSocket));
-            if (FindAll != FALSE) {
-                Status = STATUS_MORE_PROCESSING_REQUIRED;
-
-            } else {
-                if (FoundSocket->BindingType == SocketFullyBound) {
-                    Protocol->LastSocket = FoundSocket;
-                }
-
-                Status = STATUS_SUCCESS;
-            }
+            Status = STATUS_MORE_PROCESSING_REQUIRED;
         }
     }
 
     KeReleaseSharedExclusiveLockShared(Protocol->SocketLock);
+
+FindSocketEnd:
     *Socket = FoundSocket;
     return Status;
 }
@@ -3022,9 +3234,11 @@ Return Value:
     NET_LINK_ADDRESS_STATE State;
     BOOL StaticAddress;
     KSTATUS Status;
+    BOOL UpdateRoutes;
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
+    UpdateRoutes = FALSE;
     if (Information->Version < NETWORK_DEVICE_INFORMATION_VERSION) {
         return STATUS_INVALID_PARAMETER;
     }
@@ -3215,6 +3429,7 @@ Return Value:
         }
 
         RtlAtomicExchange32(&(LinkAddressEntry->State), State);
+        UpdateRoutes = TRUE;
     }
 
     //
@@ -3283,6 +3498,17 @@ Return Value:
 
 GetSetNetworkDeviceInformationEnd:
     KeReleaseQueuedLock(Link->QueuedLock);
+
+    //
+    // Replace the automatic routes for the address now that the link lock is
+    // released, as route lookups acquire it with the table lock held.
+    //
+
+    if (UpdateRoutes != FALSE) {
+        NetpRemoveLinkRoutes(Link, LinkAddressEntry);
+        NetpAddLinkAddressRoutes(Link, LinkAddressEntry);
+    }
+
     return Status;
 }
 
@@ -3352,7 +3578,15 @@ Return Value:
     }
 
     INITIALIZE_LIST_HEAD(&NetLinkList);
-    Status = STATUS_SUCCESS;
+    Status = NetpInitializeStatistics();
+    if (!KSUCCESS(Status)) {
+        goto InitializeNetworkLayerEnd;
+    }
+
+    Status = NetpInitializeRoutes();
+    if (!KSUCCESS(Status)) {
+        goto InitializeNetworkLayerEnd;
+    }
 
 InitializeNetworkLayerEnd:
     if (!KSUCCESS(Status)) {
@@ -3620,6 +3854,128 @@ Return Value:
     return ComparisonResultSame;
 }
 
+KSTATUS
+NetpCreateSocketHash (
+    PNET_PROTOCOL_ENTRY Protocol
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates the socket hash tables for a protocol.
+
+Arguments:
+
+    Protocol - Supplies a pointer to the protocol entry.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PNET_SOCKET_HASH_BUCKET Bucket;
+    ULONG Index;
+    PNET_SOCKET_HASH SocketHash;
+    KSTATUS Status;
+
+    ASSERT(Protocol->SocketHash == NULL);
+
+    SocketHash = MmAllocatePagedPool(sizeof(NET_SOCKET_HASH),
+                                     NET_CORE_ALLOCATION_TAG);
+
+    if (SocketHash == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateSocketHashEnd;
+    }
+
+    RtlZeroMemory(SocketHash, sizeof(NET_SOCKET_HASH));
+    Protocol->SocketHash = SocketHash;
+    for (Index = 0; Index < NET_SOCKET_HASH_BUCKET_COUNT; Index += 1) {
+        Bucket = &(SocketHash->FullyBound[Index]);
+        INITIALIZE_LIST_HEAD(&(Bucket->ListHead));
+        Bucket->Lock = KeCreateQueuedLock();
+        if (Bucket->Lock == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto CreateSocketHashEnd;
+        }
+
+        Bucket = &(SocketHash->Listening[Index]);
+        INITIALIZE_LIST_HEAD(&(Bucket->ListHead));
+        Bucket->Lock = KeCreateQueuedLock();
+        if (Bucket->Lock == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto CreateSocketHashEnd;
+        }
+    }
+
+    Status = STATUS_SUCCESS;
+
+CreateSocketHashEnd:
+    if (!KSUCCESS(Status)) {
+        if (Protocol->SocketHash != NULL) {
+            NetpDestroySocketHash(Protocol);
+        }
+    }
+
+    return Status;
+}
+
+VOID
+NetpDestroySocketHash (
+    PNET_PROTOCOL_ENTRY Protocol
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys a protocol's socket hash tables. The tables must be
+    empty.
+
+Arguments:
+
+    Protocol - Supplies a pointer to the protocol entry.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNET_SOCKET_HASH_BUCKET Bucket;
+    ULONG Index;
+    PNET_SOCKET_HASH SocketHash;
+
+    SocketHash = Protocol->SocketHash;
+    for (Index = 0; Index < NET_SOCKET_HASH_BUCKET_COUNT; Index += 1) {
+        Bucket = &(SocketHash->FullyBound[Index]);
+        if (Bucket->Lock != NULL) {
+
+            ASSERT(LIST_EMPTY(&(Bucket->ListHead)) != FALSE);
+
+            KeDestroyQueuedLock(Bucket->Lock);
+        }
+
+        Bucket = &(SocketHash->Listening[Index]);
+        if (Bucket->Lock != NULL) {
+
+            ASSERT(LIST_EMPTY(&(Bucket->ListHead)) != FALSE);
+
+            KeDestroyQueuedLock(Bucket->Lock);
+        }
+    }
+
+    MmFreePagedPool(SocketHash);
+    Protocol->SocketHash = NULL;
+    return;
+}
+
 NET_API
 USHORT
 NetChecksumData (
@@ -3792,6 +4148,7 @@ Return Value:
     Link->DataLinkEntry->Interface.DestroyLink(Link);
     Link->Properties.Interface.DestroyLink(Link->Properties.DeviceContext);
     IoDeviceReleaseReference(Link->Properties.Device);
+    NetpDestroyLinkStatistics(Link);
     MmFreePagedPool(Link);
     return;
 }
@@ -3835,7 +4192,7 @@ Return Value:
     if (((Socket->Flags & NET_SOCKET_FLAG_ACTIVE) == 0) &&
         (Socket->BindingType == SocketBindingInvalid)) {
 
-        ASSERT(Socket != Protocol->LastSocket);
+        ASSERT(Socket->HashBucket == NULL);
 
         return;
     }
@@ -3854,12 +4211,12 @@ Return Value:
     Socket->BindingType = SocketBindingInvalid;
 
     //
-    // If it was in the socket "cache", then remove it.
+    // Pull it out of the hash too. Once this returns no lookup can find the
+    // socket, and any lookup that already found it has taken its own
+    // reference.
     //
 
-    if (Socket == Protocol->LastSocket) {
-        Protocol->LastSocket = NULL;
-    }
+    NetpUnhashSocket(Socket);
 
     //
     // Release that reference that was added when the socket was added to the
@@ -4187,6 +4544,340 @@ Return Value:
     return ComparisonResultSame;
 }
 
+VOID
+NetpRehashSocket (
+    PNET_SOCKET Socket,
+    NET_SOCKET_BINDING_TYPE BindingType,
+    PNETWORK_ADDRESS LocalReceiveAddress,
+    PNETWORK_ADDRESS RemoteAddress
+    )
+
+/*++
+
+Routine Description:
+
+    This routine moves a socket into the hash bucket for a new binding,
+    updating the binding type and the addresses that lookups compare against
+    along the way. The old and new bucket locks are both held while the
+    socket changes, so a lookup sees either its old binding or its new one.
+    The protocol's socket lock must be held exclusively.
+
+Arguments:
+
+    Socket - Supplies a pointer to the socket to move.
+
+    BindingType - Supplies the socket's new binding type.
+
+    LocalReceiveAddress - Supplies an optional pointer to the socket's new
+        local receive address. If NULL, the current one is kept.
+
+    RemoteAddress - Supplies an optional pointer to the socket's new remote
+        address. If NULL, the current one is kept.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNET_SOCKET_HASH_BUCKET Bucket;
+    PNET_SOCKET_HASH_BUCKET FirstBucket;
+    ULONG Hash;
+    PNET_SOCKET_HASH_BUCKET OldBucket;
+    PNET_SOCKET_HASH_BUCKET SecondBucket;
+    PNET_SOCKET_HASH SocketHash;
+
+    ASSERT(KeIsSharedExclusiveLockHeldExclusive(Socket->Protocol->SocketLock) !=
+           FALSE);
+
+    if (LocalReceiveAddress == NULL) {
+        LocalReceiveAddress = &(Socket->LocalReceiveAddress);
+    }
+
+    if (RemoteAddress == NULL) {
+        RemoteAddress = &(Socket->RemoteAddress);
+    }
+
+    SocketHash = Socket->Protocol->SocketHash;
+    if (BindingType == SocketFullyBound) {
+        Hash = NetpHashNetworkAddress(LocalReceiveAddress,
+                                      FALSE,
+                                      NET_SOCKET_HASH_SEED);
+
+        Hash = NetpHashNetworkAddress(RemoteAddress, FALSE, Hash);
+        Bucket = &(SocketHash->FullyBound[NET_SOCKET_HASH_INDEX(Hash)]);
+
+    } else {
+
+        ASSERT((BindingType == SocketLocallyBound) ||
+               (BindingType == SocketUnbound));
+
+        Hash = NetpHashNetworkAddress(LocalReceiveAddress,
+                                      TRUE,
+                                      NET_SOCKET_HASH_SEED);
+
+        Bucket = &(SocketHash->Listening[NET_SOCKET_HASH_INDEX(Hash)]);
+    }
+
+    //
+    // Acquire the bucket locks in address order so that two sockets moving
+    // in opposite directions cannot deadlock.
+    //
+
+    OldBucket = Socket->HashBucket;
+    FirstBucket = Bucket;
+    SecondBucket = NULL;
+    if ((OldBucket != NULL) && (OldBucket != Bucket)) {
+        if (OldBucket < Bucket) {
+            FirstBucket = OldBucket;
+            SecondBucket = Bucket;
+
+        } else {
+            SecondBucket = OldBucket;
+        }
+    }
+
+    KeAcquireQueuedLock(FirstBucket->Lock);
+    if (SecondBucket != NULL) {
+        KeAcquireQueuedLock(SecondBucket->Lock);
+    }
+
+    if (LocalReceiveAddress != &(Socket->LocalReceiveAddress)) {
+        RtlCopyMemory(&(Socket->LocalReceiveAddress),
+                      LocalReceiveAddress,
+                      sizeof(NETWORK_ADDRESS));
+    }
+
+    if (RemoteAddress != &(Socket->RemoteAddress)) {
+        RtlCopyMemory(&(Socket->RemoteAddress),
+                      RemoteAddress,
+                      sizeof(NETWORK_ADDRESS));
+    }
+
+    Socket->BindingType = BindingType;
+    if (OldBucket != NULL) {
+        LIST_REMOVE(&(Socket->HashEntry));
+    }
+
+    INSERT_BEFORE(&(Socket->HashEntry), &(Bucket->ListHead));
+    Socket->HashBucket = Bucket;
+    if (SecondBucket != NULL) {
+        KeReleaseQueuedLock(SecondBucket->Lock);
+    }
+
+    KeReleaseQueuedLock(FirstBucket->Lock);
+    return;
+}
+
+VOID
+NetpUnhashSocket (
+    PNET_SOCKET Socket
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a socket from its protocol's socket hash, if it is
+    on it. The protocol's socket lock must be held exclusively.
+
+Arguments:
+
+    Socket - Supplies a pointer to the socket to remove.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNET_SOCKET_HASH_BUCKET Bucket;
+
+    ASSERT(KeIsSharedExclusiveLockHeldExclusive(Socket->Protocol->SocketLock) !=
+           FALSE);
+
+    Bucket = Socket->HashBucket;
+    if (Bucket == NULL) {
+        return;
+    }
+
+    KeAcquireQueuedLock(Bucket->Lock);
+    LIST_REMOVE(&(Socket->HashEntry));
+    Socket->HashBucket = NULL;
+    KeReleaseQueuedLock(Bucket->Lock);
+    return;
+}
+
+PNET_SOCKET
+NetpFindHashedSocket (
+    PNET_PROTOCOL_ENTRY Protocol,
+    PNETWORK_ADDRESS LocalAddress,
+    PNETWORK_ADDRESS RemoteAddress
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the socket that should receive a unicast packet,
+    preferring fully bound sockets, then locally bound sockets, then unbound
+    sockets. Only the lock for each bucket searched is acquired.
+
+Arguments:
+
+    Protocol - Supplies a pointer to the protocol to search.
+
+    LocalAddress - Supplies a pointer to the local address the packet was sent
+        to.
+
+    RemoteAddress - Supplies a pointer to the remote address the packet came
+        from.
+
+Return Value:
+
+    Returns a pointer to the matching active socket, with a reference added
+    that the caller is responsible for releasing.
+
+    NULL if no socket matches.
+
+--*/
+
+{
+
+    PNET_SOCKET_HASH_BUCKET Bucket;
+    PLIST_ENTRY CurrentEntry;
+    PNET_SOCKET FoundSocket;
+    ULONG Hash;
+    COMPARISON_RESULT Result;
+    PNET_SOCKET Socket;
+    PNET_SOCKET_HASH SocketHash;
+    PNET_SOCKET UnboundSocket;
+
+    FoundSocket = NULL;
+    SocketHash = Protocol->SocketHash;
+    Hash = NetpHashNetworkAddress(LocalAddress, FALSE, NET_SOCKET_HASH_SEED);
+    Hash = NetpHashNetworkAddress(RemoteAddress, FALSE, Hash);
+    Bucket = &(SocketHash->FullyBound[NET_SOCKET_HASH_INDEX(Hash)]);
+    KeAcquireQueuedLock(Bucket->Lock);
+    CurrentEntry = Bucket->ListHead.Next;
+    while (CurrentEntry != &(Bucket->ListHead)) {
+        Socket = LIST_VALUE(CurrentEntry, NET_SOCKET, HashEntry);
+        CurrentEntry = CurrentEntry->Next;
+        if ((Socket->Flags & NET_SOCKET_FLAG_ACTIVE) == 0) {
+            continue;
+        }
+
+        Result = NetpMatchFullyBoundSocket(Socket, LocalAddress, RemoteAddress);
+        if (Result == ComparisonResultSame) {
+            FoundSocket = Socket;
+            IoSocketAddReference(&(FoundSocket->KernelSocket));
+            break;
+        }
+    }
+
+    KeReleaseQueuedLock(Bucket->Lock);
+    if (FoundSocket != NULL) {
+        return FoundSocket;
+    }
+
+    //
+    // Locally bound and unbound sockets share a bucket for the same port. An
+    // exact match on the local address wins over a socket bound only to the
+    // port.
+    //
+
+    UnboundSocket = NULL;
+    Hash = NetpHashNetworkAddress(LocalAddress, TRUE, NET_SOCKET_HASH_SEED);
+    Bucket = &(SocketHash->Listening[NET_SOCKET_HASH_INDEX(Hash)]);
+    KeAcquireQueuedLock(Bucket->Lock);
+    CurrentEntry = Bucket->ListHead.Next;
+    while (CurrentEntry != &(Bucket->ListHead)) {
+        Socket = LIST_VALUE(CurrentEntry, NET_SOCKET, HashEntry);
+        CurrentEntry = CurrentEntry->Next;
+        if (((Socket->Flags & NET_SOCKET_FLAG_ACTIVE) == 0) ||
+            (Socket->LocalReceiveAddress.Port != LocalAddress->Port) ||
+            (Socket->LocalReceiveAddress.Domain != LocalAddress->Domain)) {
+
+            continue;
+        }
+
+        if (Socket->BindingType == SocketLocallyBound) {
+            Result = NetpCompareNetworkAddresses(&(Socket->LocalReceiveAddress),
+                                                 LocalAddress);
+
+            if (Result == ComparisonResultSame) {
+                FoundSocket = Socket;
+                break;
+            }
+
+        } else if ((Socket->BindingType == SocketUnbound) &&
+                   (UnboundSocket == NULL)) {
+
+            UnboundSocket = Socket;
+        }
+    }
+
+    if (FoundSocket == NULL) {
+        FoundSocket = UnboundSocket;
+    }
+
+    if (FoundSocket != NULL) {
+        IoSocketAddReference(&(FoundSocket->KernelSocket));
+    }
+
+    KeReleaseQueuedLock(Bucket->Lock);
+    return FoundSocket;
+}
+
+ULONG
+NetpHashNetworkAddress (
+    PNETWORK_ADDRESS Address,
+    BOOL PortOnly,
+    ULONG Hash
+    )
+
+/*++
+
+Routine Description:
+
+    This routine folds a network address into a socket hash value.
+
+Arguments:
+
+    Address - Supplies a pointer to the network address to hash.
+
+    PortOnly - Supplies a boolean indicating whether to only hash the network
+        and port (TRUE) or to include the address itself (FALSE).
+
+    Hash - Supplies the hash value so far.
+
+Return Value:
+
+    Returns the new hash value.
+
+--*/
+
+{
+
+    PUCHAR Bytes;
+    ULONG Index;
+
+    Hash = (Hash ^ Address->Port) * NET_SOCKET_HASH_PRIME;
+    Hash = (Hash ^ Address->Domain) * NET_SOCKET_HASH_PRIME;
+    if (PortOnly == FALSE) {
+        Bytes = (PUCHAR)(Address->Address);
+        for (Index = 0; Index < MAX_NETWORK_ADDRESS_SIZE; Index += 1) {
+            Hash = (Hash ^ Bytes[Index]) * NET_SOCKET_HASH_PRIME;
+        }
+    }
+
+    return Hash;
+}
+
 COMPARISON_RESULT
 NetpCompareAddressTranslationEntries (
     PRED_BLACK_TREE Tree,
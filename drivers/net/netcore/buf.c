@@ -305,6 +305,7 @@ Return Value:
         Buffer->DataSize = DataSize;
         Buffer->DataOffset = HeaderSize;
         Buffer->FooterOffset = Buffer->DataOffset + Size;
+        Buffer->FlowHash = 0;
 
         //
         // If padding was added to the packet, then zero it.
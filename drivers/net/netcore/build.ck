@@ -51,8 +51,12 @@ function build() {
         "netcore.c",
         "netlink/netlink.c",
         "netlink/genctrl.c",
+        "netlink/genroute.c",
+        "netlink/genstats.c",
         "netlink/generic.c",
         "raw.c",
+        "route.c",
+        "stats.c",
         "tcp.c",
         "tcpcong.c",
         "udp.c"
@@ -439,14 +439,17 @@ Return Value:
 
 {
 
+    ULONGLONG ByteCount;
     ULONG ByteIndex;
     PUCHAR CurrentElement;
     PLIST_ENTRY CurrentEntry;
     PVOID DeviceContext;
     PNET_LINK Link;
     PNET_PACKET_BUFFER Packet;
+    UINTN PacketCount;
     KSTATUS Status;
 
+    ByteCount = 0;
     Link = (PNET_LINK)DataLinkContext;
     CurrentEntry = PacketList->Head.Next;
     while (CurrentEntry != &(PacketList->Head)) {
@@ -505,8 +508,10 @@ Return Value:
         //
 
         *((PUSHORT)CurrentElement) = CPU_TO_NETWORK16((USHORT)ProtocolNumber);
+        ByteCount += Packet->FooterOffset - Packet->DataOffset;
     }
 
+    PacketCount = PacketList->Count;
     DeviceContext = Link->Properties.DeviceContext;
     Status = Link->Properties.Interface.Send(DeviceContext, PacketList);
 
@@ -522,10 +527,39 @@ Return Value:
                           PacketList->Count);
         }
 
+        //
+        // Whatever is left on the list never made it out.
+        //
+
+        NetAddLinkStatistic(Link,
+                            NetLinkStatisticTransmitDrops,
+                            PacketList->Count);
+
+        PacketCount -= PacketList->Count;
+        CurrentEntry = PacketList->Head.Next;
+        while (CurrentEntry != &(PacketList->Head)) {
+            Packet = LIST_VALUE(CurrentEntry, NET_PACKET_BUFFER, ListEntry);
+            CurrentEntry = CurrentEntry->Next;
+            ByteCount -= Packet->FooterOffset - Packet->DataOffset;
+        }
+
         NetDestroyBufferList(PacketList);
         Status = STATUS_SUCCESS;
     }
 
+    if (KSUCCESS(Status)) {
+        NetAddLinkStatistic(Link,
+                            NetLinkStatisticTransmittedPackets,
+                            PacketCount);
+
+        NetAddLinkStatistic(Link,
+                            NetLinkStatisticTransmittedBytes,
+                            ByteCount);
+
+    } else {
+        NetAddLinkStatistic(Link, NetLinkStatisticTransmitErrors, PacketCount);
+    }
+
     return Status;
 }
 
@@ -581,6 +615,7 @@ Return Value:
                       "header.\n",
                       NetworkProtocol);
 
+        NetAddLinkStatistic(Link, NetLinkStatisticReceiveDrops, 1);
         return;
     }
 
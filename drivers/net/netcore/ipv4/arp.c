@@ -403,6 +403,7 @@ Return Value:
     //
 
     if (Operation == ARP_OPERATION_REQUEST) {
+        NetAddStatistic(NetStatisticArpInRequests, 1);
         if (NetArpDebug != FALSE) {
             RtlDebugPrint("ARP RX: Who has ");
             NetDebugPrintAddress(&TargetNetworkAddress);
@@ -440,6 +441,8 @@ Return Value:
         return;
     }
 
+    NetAddStatistic(NetStatisticArpInReplies, 1);
+
     //
     // Debug print the response.
     //
@@ -812,6 +815,8 @@ Return Value:
         goto ArpSendRequestEnd;
     }
 
+    NetAddStatistic(NetStatisticArpOutRequests, 1);
+
 ArpSendRequestEnd:
     if (LockHeld != FALSE) {
         KeReleaseQueuedLock(Link->QueuedLock);
@@ -1013,6 +1018,8 @@ Return Value:
         goto ArpSendReplyEnd;
     }
 
+    NetAddStatistic(NetStatisticArpOutReplies, 1);
+
 ArpSendReplyEnd:
     if (LockHeld != FALSE) {
         KeReleaseQueuedLock(Link->QueuedLock);
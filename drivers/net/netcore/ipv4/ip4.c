@@ -1035,6 +1035,7 @@ Return Value:
     ULONG HeaderSize;
     PNET_LINK Link;
     PNET_LINK_ADDRESS_ENTRY LinkAddress;
+    ULONG FlowHash;
     PIP4_ADDRESS LocalAddress;
     ULONG MaxFragmentLength;
     ULONG MaxPacketSize;
@@ -1135,13 +1136,17 @@ Return Value:
     }
 
     //
-    // Add the IP4 and Ethernet headers to each packet.
+    // Add the IP4 and Ethernet headers to each packet, tagging each with the
+    // flow it belongs to so multi-queue links keep the flow on one queue.
     //
 
+    NetAddStatistic(NetStatisticIp4OutRequests, PacketList->Count);
+    FlowHash = NetComputeFlowHash(Source, Destination);
     CurrentEntry = PacketList->Head.Next;
     while (CurrentEntry != &(PacketList->Head)) {
         Packet = LIST_VALUE(CurrentEntry, NET_PACKET_BUFFER, ListEntry);
         CurrentEntry = CurrentEntry->Next;
+        Packet->FlowHash = FlowHash;
 
         //
         // If the socket is supposed to include the IP header in its
@@ -1206,6 +1211,8 @@ Return Value:
                     goto Ip4SendEnd;
                 }
 
+                Fragment->FlowHash = FlowHash;
+
                 //
                 // Copy the data from the packet to the fragment.
                 //
@@ -1274,11 +1281,14 @@ Return Value:
                 //
 
                 NET_INSERT_PACKET_BEFORE(Fragment, Packet, PacketList);
+                NetAddStatistic(NetStatisticIp4FragmentsCreated, 1);
                 PacketBuffer += FragmentLength;
                 BytesCompleted += FragmentLength;
                 BytesRemaining -= FragmentLength;
             }
 
+            NetAddStatistic(NetStatisticIp4FragmentsOk, 1);
+
             //
             // Remove the original packet. It just got fragmented. And move on
             // to the next packet ID.
@@ -1484,6 +1494,7 @@ Return Value:
     IP4_ADDRESS SourceAddress;
     USHORT TotalLength;
 
+    NetAddStatistic(NetStatisticIp4InReceives, 1);
     ReassembledPacket = NULL;
     Packet = ReceiveContext->Packet;
     Header = (PIP4_HEADER)(Packet->Buffer + Packet->DataOffset);
@@ -1496,6 +1507,7 @@ Return Value:
         RtlDebugPrint("Invalid IPv4 version. Byte: 0x%02x.\n",
                       Header->VersionAndHeaderLength);
 
+        NetAddStatistic(NetStatisticIp4InHeaderErrors, 1);
         goto Ip4ProcessReceivedDataEnd;
     }
 
@@ -1506,6 +1518,7 @@ Return Value:
         RtlDebugPrint("Invalid IPv4 header length. Byte: 0x%02x.\n",
                       Header->VersionAndHeaderLength);
 
+        NetAddStatistic(NetStatisticIp4InHeaderErrors, 1);
         goto Ip4ProcessReceivedDataEnd;
     }
 
@@ -1520,6 +1533,7 @@ Return Value:
                       TotalLength,
                       (Packet->FooterOffset - Packet->DataOffset));
 
+        NetAddStatistic(NetStatisticIp4InHeaderErrors, 1);
         goto Ip4ProcessReceivedDataEnd;
     }
 
@@ -1537,6 +1551,7 @@ Return Value:
                           "0x%04x, should have been zero.\n",
                           ComputedChecksum);
 
+            NetAddStatistic(NetStatisticIp4InHeaderErrors, 1);
             goto Ip4ProcessReceivedDataEnd;
         }
     }
@@ -1602,6 +1617,7 @@ Return Value:
             goto Ip4ProcessReceivedDataEnd;
         }
 
+        NetAddStatistic(NetStatisticIp4ReassemblyRequired, 1);
         ReassembledPacket = NetpIp4ProcessPacketFragment(ReceiveContext->Link,
                                                          Packet);
 
@@ -1609,6 +1625,7 @@ Return Value:
             goto Ip4ProcessReceivedDataEnd;
         }
 
+        NetAddStatistic(NetStatisticIp4ReassemblyOk, 1);
         Packet = ReassembledPacket;
 
         //
@@ -1679,6 +1696,7 @@ Return Value:
                       "0x%02x.\n",
                       Header->Protocol);
 
+        NetAddStatistic(NetStatisticIp4InUnknownProtocols, 1);
         goto Ip4ProcessReceivedDataEnd;
     }
 
@@ -1686,6 +1704,7 @@ Return Value:
     // Update the packet's data offset so that it starts at the protocol layer.
     //
 
+    NetAddStatistic(NetStatisticIp4InDelivers, 1);
     Packet->DataOffset += HeaderSize;
     ReceiveContext->Protocol = ProtocolEntry;
     ProtocolEntry->Interface.ProcessReceivedData(ReceiveContext);
@@ -2470,6 +2489,7 @@ Return Value:
     BOOL LockHeld;
     NET_TRANSLATION_REQUEST Request;
     UINTN RequestSize;
+    PNET_ROUTE Route;
     KSTATUS Status;
     ULONG SubnetBroadcast;
     PIP4_ADDRESS SubnetMask;
@@ -2479,6 +2499,7 @@ Return Value:
     AddressType = NetAddressUnknown;
     Ip4Address = (PIP4_ADDRESS)NetworkAddress;
     LockHeld = FALSE;
+    Route = NULL;
 
     //
     // This function is very simple: it perform some filtering on known
@@ -2506,6 +2527,35 @@ Return Value:
         goto Ip4TranslateNetworkAddressEnd;
     }
 
+    //
+    // Find the route to the destination. Connected sockets have it cached,
+    // as long as it hasn't since been deleted. The route table lock can't be
+    // acquired with the link lock held, so do this first. If there's no route
+    // out this link, fall back to the link address's own gateway.
+    //
+
+    Route = Socket->Route;
+    if ((Route != NULL) &&
+        ((Route->Flags & NET_ROUTE_FLAG_DELETED) == 0) &&
+        (Ip4Address->Address ==
+         ((PIP4_ADDRESS)&(Socket->RemoteAddress))->Address)) {
+
+        NetRouteAddReference(Route);
+
+    } else {
+        Status = NetLookupRoute(NetworkAddress, &Route);
+        if (!KSUCCESS(Status)) {
+            Route = NULL;
+        }
+
+        Status = STATUS_SUCCESS;
+    }
+
+    if ((Route != NULL) && (Route->Link != Link)) {
+        NetRouteReleaseReference(Route);
+        Route = NULL;
+    }
+
     //
     // Make sure the link address is still configured when using it.
     //
@@ -2529,24 +2579,17 @@ Return Value:
     //
     // This calculates if any bits are different within the subnet mask. If
     // they are, then the destination is outside of the subnet and should go to
-    // the default gateway.
+    // a gateway.
     //
 
     BitsDifferentInSubnet = ((Ip4Address->Address ^ LocalIpAddress->Address) &
                             SubnetMask->Address);
 
-    if (BitsDifferentInSubnet != 0) {
-        RtlCopyMemory(&DefaultGateway,
-                      &(LinkAddress->DefaultGateway),
-                      sizeof(NETWORK_ADDRESS));
-
-        NetworkAddress = &DefaultGateway;
-
     //
     // Check to see if the address is a subnet broadcast address.
     //
 
-    } else {
+    if (BitsDifferentInSubnet == 0) {
         SubnetBroadcast = (LocalIpAddress->Address & SubnetMask->Address) |
                           ~SubnetMask->Address;
 
@@ -2556,6 +2599,28 @@ Return Value:
         }
     }
 
+    //
+    // The route decides the next hop if there is one: either its gateway, or
+    // the destination itself for directly connected routes.
+    //
+
+    if (Route != NULL) {
+        if ((Route->Flags & NET_ROUTE_FLAG_GATEWAY) != 0) {
+            RtlCopyMemory(&DefaultGateway,
+                          &(Route->Gateway),
+                          sizeof(NETWORK_ADDRESS));
+
+            NetworkAddress = &DefaultGateway;
+        }
+
+    } else if (BitsDifferentInSubnet != 0) {
+        RtlCopyMemory(&DefaultGateway,
+                      &(LinkAddress->DefaultGateway),
+                      sizeof(NETWORK_ADDRESS));
+
+        NetworkAddress = &DefaultGateway;
+    }
+
     KeReleaseQueuedLock(Link->QueuedLock);
     LockHeld = FALSE;
 
@@ -2612,6 +2677,10 @@ Return Value:
         KeReleaseQueuedLock(Link->QueuedLock);
     }
 
+    if (Route != NULL) {
+        NetRouteReleaseReference(Route);
+    }
+
     //
     // Sending to a broadcast address must be specifically requested through
     // socket options.
@@ -2676,6 +2745,7 @@ Return Value:
     PNET_PACKET_BUFFER CompletedPacket;
     PLIST_ENTRY CurrentEntry;
     PVOID DestinationBuffer;
+    BOOL Dropped;
     PRED_BLACK_TREE_NODE FoundNode;
     USHORT FragmentEnd;
     PIP4_FRAGMENT_ENTRY FragmentEntry;
@@ -2699,6 +2769,7 @@ Return Value:
     ULONG TotalLength;
 
     CompletedPacket = NULL;
+    Dropped = TRUE;
     Header = (PIP4_HEADER)(PacketFragment->Buffer + PacketFragment->DataOffset);
     KeAcquireQueuedLock(NetIp4FragmentedPacketLock);
 
@@ -3028,8 +3099,14 @@ Return Value:
         }
     }
 
+    Dropped = FALSE;
+
 Ip4ProcessPacketFragmentEnd:
     KeReleaseQueuedLock(NetIp4FragmentedPacketLock);
+    if (Dropped != FALSE) {
+        NetAddStatistic(NetStatisticIp4ReassemblyFailures, 1);
+    }
+
     return CompletedPacket;
 }
 
@@ -889,6 +889,7 @@ Return Value:
 
     PLIST_ENTRY CurrentEntry;
     ULONG DataOffset;
+    ULONG FlowHash;
     ULONG FooterOffset;
     PIP6_HEADER Header;
     UCHAR HopLimit;
@@ -992,13 +993,17 @@ Return Value:
     }
 
     //
-    // Add the IP6 and Ethernet headers to each packet.
+    // Add the IP6 and Ethernet headers to each packet, tagging each with the
+    // flow it belongs to so multi-queue links keep the flow on one queue.
     //
 
+    NetAddStatistic(NetStatisticIp6OutRequests, PacketList->Count);
+    FlowHash = NetComputeFlowHash(Source, Destination);
     CurrentEntry = PacketList->Head.Next;
     while (CurrentEntry != &(PacketList->Head)) {
         Packet = LIST_VALUE(CurrentEntry, NET_PACKET_BUFFER, ListEntry);
         CurrentEntry = CurrentEntry->Next;
+        Packet->FlowHash = FlowHash;
 
         //
         // If the socket is supposed to include the IP header in its
@@ -1217,6 +1222,7 @@ Return Value:
     ULONG Version;
     ULONG VersionClassFlow;
 
+    NetAddStatistic(NetStatisticIp6InReceives, 1);
     Packet = ReceiveContext->Packet;
     PacketLength = Packet->FooterOffset - Packet->DataOffset;
 
@@ -1226,6 +1232,7 @@ Return Value:
 
     if (PacketLength < sizeof(IP6_HEADER)) {
         RtlDebugPrint("Invalid IPv6 packet length: 0x%08x.\n", PacketLength);
+        NetAddStatistic(NetStatisticIp6InHeaderErrors, 1);
         goto Ip6ProcessReceivedDataEnd;
     }
 
@@ -1238,6 +1245,7 @@ Return Value:
     Version = (VersionClassFlow & IP6_VERSION_MASK) >> IP6_VERSION_SHIFT;
     if (Version != IP6_VERSION) {
         RtlDebugPrint("Invalid IPv6 version. Byte: 0x%02x.\n", Version);
+        NetAddStatistic(NetStatisticIp6InHeaderErrors, 1);
         goto Ip6ProcessReceivedDataEnd;
     }
 
@@ -1252,6 +1260,7 @@ Return Value:
                       TotalLength,
                       (PacketLength - sizeof(IP6_HEADER)));
 
+        NetAddStatistic(NetStatisticIp6InHeaderErrors, 1);
         goto Ip6ProcessReceivedDataEnd;
     }
 
@@ -1338,8 +1347,12 @@ Return Value:
     //
 
     if (ReceiveContext->Protocol != NULL) {
+        NetAddStatistic(NetStatisticIp6InDelivers, 1);
         ProtocolEntry = ReceiveContext->Protocol;
         ProtocolEntry->Interface.ProcessReceivedData(ReceiveContext);
+
+    } else {
+        NetAddStatistic(NetStatisticIp6InUnknownProtocols, 1);
     }
 
 Ip6ProcessReceivedDataEnd:
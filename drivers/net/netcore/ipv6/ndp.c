@@ -575,10 +575,12 @@ Return Value:
         break;
 
     case ICMP6_MESSAGE_TYPE_NDP_NEIGHBOR_SOLICITATION:
+        NetAddStatistic(NetStatisticNdpInSolicitations, 1);
         NetpNdpProcessNeighborSolicitation(ReceiveContext);
         break;
 
     case ICMP6_MESSAGE_TYPE_NDP_NEIGHBOR_ADVERTISEMENT:
+        NetAddStatistic(NetStatisticNdpInAdvertisements, 1);
         NetpNdpProcessNeighborAdvertisement(ReceiveContext);
         break;
 
@@ -1823,6 +1825,13 @@ Return Value:
         goto NdpSendPacketsEnd;
     }
 
+    if (Type == ICMP6_MESSAGE_TYPE_NDP_NEIGHBOR_SOLICITATION) {
+        NetAddStatistic(NetStatisticNdpOutSolicitations, 1);
+
+    } else if (Type == ICMP6_MESSAGE_TYPE_NDP_NEIGHBOR_ADVERTISEMENT) {
+        NetAddStatistic(NetStatisticNdpOutAdvertisements, 1);
+    }
+
 NdpSendPacketsEnd:
     if (!KSUCCESS(Status)) {
         NetDestroyBufferList(PacketList);
@@ -505,6 +505,11 @@ Return Value:
                               0,
                               NetpCompareFullyBoundSockets);
 
+    Status = NetpCreateSocketHash(NewProtocolCopy);
+    if (!KSUCCESS(Status)) {
+        goto RegisterProtocolEnd;
+    }
+
     KeAcquireSharedExclusiveLockExclusive(NetPluginListLock);
     LockHeld = TRUE;
 
@@ -1205,6 +1210,11 @@ Return Value:
 
 {
 
+    NetAddLinkStatistic(Link, NetLinkStatisticReceivedPackets, 1);
+    NetAddLinkStatistic(Link,
+                        NetLinkStatisticReceivedBytes,
+                        Packet->FooterOffset - Packet->DataOffset);
+
     //
     // Call the data link layer to process the packet.
     //
@@ -1495,6 +1505,8 @@ Return Value:
     Socket->Protocol = ProtocolEntry;
     Socket->Network = NetworkEntry;
     Socket->BindingType = SocketBindingInvalid;
+    Socket->HashBucket = NULL;
+    Socket->Route = NULL;
     Socket->LastError = STATUS_SUCCESS;
     RtlCopyMemory(&(Socket->UnboundPacketSizeInformation),
                   &(Socket->PacketSizeInformation),
@@ -1576,6 +1588,11 @@ Return Value:
         NetTranslationEntryReleaseReference(NetSocket->RemoteTranslation);
     }
 
+    if (NetSocket->Route != NULL) {
+        NetRouteReleaseReference(NetSocket->Route);
+        NetSocket->Route = NULL;
+    }
+
     if (NetSocket->Link != NULL) {
         NetLinkReleaseReference(NetSocket->Link);
         NetSocket->Link = NULL;
@@ -2534,6 +2551,10 @@ Return Value:
 
 {
 
+    if (Protocol->SocketHash != NULL) {
+        NetpDestroySocketHash(Protocol);
+    }
+
     if (Protocol->SocketLock != NULL) {
         KeDestroySharedExclusiveLock(Protocol->SocketLock);
     }
@@ -52,10 +52,64 @@ Module Name:
 
 #define NET_PRINT_ADDRESS_STRING_LENGTH 200
 
+//
+// Define the number of buckets in each of a protocol's socket hash tables.
+// This must be a power of two.
+//
+
+#define NET_SOCKET_HASH_BUCKET_COUNT 64
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure defines a single bucket of a socket hash table.
+
+Members:
+
+    Lock - Stores a pointer to the lock protecting the bucket's list. Lookups
+        only need this lock, which keeps receives for different flows from
+        contending on a single protocol-wide lock.
+
+    ListHead - Stores the head of the list of sockets in the bucket, linked
+        by their hash entries.
+
+--*/
+
+typedef struct _NET_SOCKET_HASH_BUCKET {
+    PQUEUED_LOCK Lock;
+    LIST_ENTRY ListHead;
+} NET_SOCKET_HASH_BUCKET, *PNET_SOCKET_HASH_BUCKET;
+
+/*++
+
+Structure Description:
+
+    This structure defines the socket hash tables for a protocol. Sockets are
+    only added or removed with the protocol's socket lock held exclusively
+    and the bucket lock held. A socket moving between buckets holds both
+    bucket locks, lower address first, while its binding type and addresses
+    change.
+
+Members:
+
+    FullyBound - Stores the buckets for fully bound sockets, hashed by local
+        and remote address and port.
+
+    Listening - Stores the buckets for locally bound and unbound sockets,
+        hashed by local port only.
+
+--*/
+
+struct _NET_SOCKET_HASH {
+    NET_SOCKET_HASH_BUCKET FullyBound[NET_SOCKET_HASH_BUCKET_COUNT];
+    NET_SOCKET_HASH_BUCKET Listening[NET_SOCKET_HASH_BUCKET_COUNT];
+};
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -268,6 +322,219 @@ Return Value:
 
 --*/
 
+KSTATUS
+NetpCreateSocketHash (
+    PNET_PROTOCOL_ENTRY Protocol
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates the socket hash tables for a protocol.
+
+Arguments:
+
+    Protocol - Supplies a pointer to the protocol entry.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+VOID
+NetpDestroySocketHash (
+    PNET_PROTOCOL_ENTRY Protocol
+    );
+
+/*++
+
+Routine Description:
+
+    This routine destroys a protocol's socket hash tables. The tables must be
+    empty.
+
+Arguments:
+
+    Protocol - Supplies a pointer to the protocol entry.
+
+Return Value:
+
+    None.
+
+--*/
+
+KSTATUS
+NetpInitializeStatistics (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes the system-wide network statistics counters.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+NetpCreateLinkStatistics (
+    PNET_LINK Link
+    );
+
+/*++
+
+Routine Description:
+
+    This routine allocates the statistics counters for a new link.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+VOID
+NetpDestroyLinkStatistics (
+    PNET_LINK Link
+    );
+
+/*++
+
+Routine Description:
+
+    This routine frees the statistics counters for a link.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+Return Value:
+
+    None.
+
+--*/
+
+KSTATUS
+NetpInitializeRoutes (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes the routing tables.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+NetpFindRoutedLink (
+    PNETWORK_ADDRESS RemoteAddress,
+    PNET_LINK_LOCAL_ADDRESS LinkResult,
+    PNET_ROUTE *Route
+    );
+
+/*++
+
+Routine Description:
+
+    This routine uses the routing table to find the link and local address
+    used to reach the given remote address.
+
+Arguments:
+
+    RemoteAddress - Supplies a pointer to the address to reach.
+
+    LinkResult - Supplies a pointer that receives the link information. A
+        reference is taken on the link on success.
+
+    Route - Supplies an optional pointer that receives a referenced pointer
+        to the route that was used.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_DESTINATION_UNREACHABLE if no usable route exists.
+
+--*/
+
+VOID
+NetpAddLinkAddressRoutes (
+    PNET_LINK Link,
+    PNET_LINK_ADDRESS_ENTRY LinkAddress
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds the automatic routes for a newly configured link
+    address: one for its subnet and a default route through its gateway.
+    Failures are not fatal, as link selection falls back to scanning the
+    links when no route matches.
+
+Arguments:
+
+    Link - Supplies a pointer to the link that owns the address.
+
+    LinkAddress - Supplies a pointer to the configured link address entry.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+NetpRemoveLinkRoutes (
+    PNET_LINK Link,
+    PNET_LINK_ADDRESS_ENTRY LinkAddress
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes routes going out over the given link. This must be
+    called with the link's queued lock released.
+
+Arguments:
+
+    Link - Supplies a pointer to the link whose routes should be removed.
+
+    LinkAddress - Supplies an optional pointer to a link address entry. If
+        supplied, only routes sending from that address are removed.
+        Otherwise every route over the link is removed.
+
+Return Value:
+
+    None.
+
+--*/
+
 //
 // Prototypes to the entry points for built in protocols.
 //
@@ -1021,6 +1021,8 @@ Return Value:
         }
 
         NetlinkpGenericControlInitialize();
+        NetlinkpGenericRouteInitialize();
+        NetlinkpGenericStatisticsInitialize();
     }
 
 InitializeEnd:
@@ -129,6 +129,48 @@ Return Value:
 
 --*/
 
+VOID
+NetlinkpGenericRouteInitialize (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes the built in generic netlink route family.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+NetlinkpGenericStatisticsInitialize (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes the built in generic netlink statistics family.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
 PNETLINK_GENERIC_FAMILY
 NetlinkpGenericLookupFamilyById (
     ULONG FamilyId
@@ -0,0 +1,850 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    genroute.c
+
+Abstract:
+
+    This module implements the generic netlink route family, which allows user
+    mode to view and change the routing tables.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+//
+// Like the control family, avoid including netcore.h, but still redefine
+// those functions that would otherwise generate imports.
+//
+
+#define NET_API __DLLEXPORT
+
+#include <minoca/kernel/driver.h>
+#include <minoca/net/netdrv.h>
+#include <minoca/net/netlink.h>
+#include "generic.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define NETLINK_ROUTE_ALLOCATION_TAG 0x52746C4E // 'RtlN'
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores the context used to collect routes out of the
+    routing tables.
+
+Members:
+
+    Routes - Stores an optional pointer to the array of routes to fill in. If
+        this is NULL, routes are just counted.
+
+    Count - Stores the number of routes seen so far.
+
+    Capacity - Stores the number of elements in the route array.
+
+--*/
+
+typedef struct _NETLINK_ROUTE_COLLECTION {
+    PNET_ROUTE *Routes;
+    UINTN Count;
+    UINTN Capacity;
+} NETLINK_ROUTE_COLLECTION, *PNETLINK_ROUTE_COLLECTION;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+KSTATUS
+NetlinkpGenericRouteAdd (
+    PNET_SOCKET Socket,
+    PNET_PACKET_BUFFER Packet,
+    PNETLINK_GENERIC_COMMAND_INFORMATION Command
+    );
+
+KSTATUS
+NetlinkpGenericRouteDelete (
+    PNET_SOCKET Socket,
+    PNET_PACKET_BUFFER Packet,
+    PNETLINK_GENERIC_COMMAND_INFORMATION Command
+    );
+
+KSTATUS
+NetlinkpGenericRouteGet (
+    PNET_SOCKET Socket,
+    PNET_PACKET_BUFFER Packet,
+    PNETLINK_GENERIC_COMMAND_INFORMATION Command
+    );
+
+KSTATUS
+NetlinkpGenericRouteParse (
+    PNET_PACKET_BUFFER Packet,
+    PNET_LINK *Link,
+    PNETWORK_ADDRESS Destination,
+    PULONG PrefixLength,
+    PNETWORK_ADDRESS Gateway,
+    PBOOL GatewayValid
+    );
+
+VOID
+NetlinkpGenericRouteCollect (
+    PNET_ROUTE Route,
+    PVOID Context
+    );
+
+KSTATUS
+NetlinkpGenericRouteGetAddress (
+    PVOID Attributes,
+    ULONG AttributesLength,
+    USHORT Type,
+    PNETWORK_ADDRESS Address
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+NETLINK_GENERIC_COMMAND NetlinkGenericRouteCommands[] = {
+    {
+        NETLINK_ROUTE_COMMAND_ADD,
+        0,
+        NetlinkpGenericRouteAdd
+    },
+
+    {
+        NETLINK_ROUTE_COMMAND_DELETE,
+        0,
+        NetlinkpGenericRouteDelete
+    },
+
+    {
+        NETLINK_ROUTE_COMMAND_GET,
+        NETLINK_HEADER_FLAG_DUMP,
+        NetlinkpGenericRouteGet
+    },
+};
+
+NETLINK_GENERIC_FAMILY_PROPERTIES NetlinkGenericRouteFamilyProperties = {
+    NETLINK_GENERIC_FAMILY_PROPERTIES_VERSION,
+    0,
+    sizeof(NETLINK_GENERIC_ROUTE_NAME),
+    NETLINK_GENERIC_ROUTE_NAME,
+    NetlinkGenericRouteCommands,
+    sizeof(NetlinkGenericRouteCommands) /
+        sizeof(NetlinkGenericRouteCommands[0]),
+
+    NULL,
+    0
+};
+
+PNETLINK_GENERIC_FAMILY NetlinkGenericRouteFamily = NULL;
+
+//
+// Define the domains whose routing tables are reported.
+//
+
+NET_DOMAIN_TYPE NetlinkGenericRouteDomains[] = {
+    NetDomainIp4,
+    NetDomainIp6
+};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+VOID
+NetlinkpGenericRouteInitialize (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes the built in generic netlink route family.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    KSTATUS Status;
+
+    Status = NetlinkGenericRegisterFamily(&NetlinkGenericRouteFamilyProperties,
+                                          &NetlinkGenericRouteFamily);
+
+    if (!KSUCCESS(Status)) {
+
+        ASSERT(KSUCCESS(Status));
+
+    }
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+KSTATUS
+NetlinkpGenericRouteAdd (
+    PNET_SOCKET Socket,
+    PNET_PACKET_BUFFER Packet,
+    PNETLINK_GENERIC_COMMAND_INFORMATION Command
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called to add a route. The device ID, destination, and
+    prefix length attributes are required. The gateway and metric are
+    optional.
+
+Arguments:
+
+    Socket - Supplies a pointer to the socket that received the packet.
+
+    Packet - Supplies a pointer to a structure describing the incoming packet.
+        This structure may be used as a scratch space while this routine
+        executes and the packet travels up the stack, but will not be accessed
+        after this routine returns.
+
+    Command - Supplies a pointer to the command information.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PVOID Attributes;
+    ULONG AttributesLength;
+    NETWORK_ADDRESS Destination;
+    NETWORK_ADDRESS Gateway;
+    BOOL GatewayValid;
+    PNET_LINK Link;
+    ULONG Metric;
+    PVOID MetricData;
+    USHORT MetricLength;
+    ULONG PrefixLength;
+    KSTATUS Status;
+
+    Link = NULL;
+    Status = NetlinkpGenericRouteParse(Packet,
+                                       &Link,
+                                       &Destination,
+                                       &PrefixLength,
+                                       &Gateway,
+                                       &GatewayValid);
+
+    if (!KSUCCESS(Status)) {
+        goto GenericRouteAddEnd;
+    }
+
+    if (Link == NULL) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto GenericRouteAddEnd;
+    }
+
+    Metric = NET_ROUTE_DEFAULT_METRIC;
+    Attributes = Packet->Buffer + Packet->DataOffset;
+    AttributesLength = Packet->FooterOffset - Packet->DataOffset;
+    Status = NetlinkGetAttribute(Attributes,
+                                 AttributesLength,
+                                 NETLINK_ROUTE_ATTRIBUTE_METRIC,
+                                 &MetricData,
+                                 &MetricLength);
+
+    if (KSUCCESS(Status)) {
+        if (MetricLength != sizeof(ULONG)) {
+            Status = STATUS_DATA_LENGTH_MISMATCH;
+            goto GenericRouteAddEnd;
+        }
+
+        Metric = *((PULONG)MetricData);
+    }
+
+    if (GatewayValid != FALSE) {
+        Status = NetAddRoute(Link,
+                             NULL,
+                             &Destination,
+                             PrefixLength,
+                             &Gateway,
+                             Metric,
+                             0);
+
+    } else {
+        Status = NetAddRoute(Link,
+                             NULL,
+                             &Destination,
+                             PrefixLength,
+                             NULL,
+                             Metric,
+                             0);
+    }
+
+GenericRouteAddEnd:
+    if (Link != NULL) {
+        NetLinkReleaseReference(Link);
+    }
+
+    return Status;
+}
+
+KSTATUS
+NetlinkpGenericRouteDelete (
+    PNET_SOCKET Socket,
+    PNET_PACKET_BUFFER Packet,
+    PNETLINK_GENERIC_COMMAND_INFORMATION Command
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called to delete routes. The destination and prefix length
+    attributes are required. If a device ID or gateway is supplied, only
+    routes matching them are deleted.
+
+Arguments:
+
+    Socket - Supplies a pointer to the socket that received the packet.
+
+    Packet - Supplies a pointer to a structure describing the incoming packet.
+        This structure may be used as a scratch space while this routine
+        executes and the packet travels up the stack, but will not be accessed
+        after this routine returns.
+
+    Command - Supplies a pointer to the command information.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    NETWORK_ADDRESS Destination;
+    NETWORK_ADDRESS Gateway;
+    PNETWORK_ADDRESS GatewayPointer;
+    BOOL GatewayValid;
+    PNET_LINK Link;
+    ULONG PrefixLength;
+    KSTATUS Status;
+
+    Link = NULL;
+    Status = NetlinkpGenericRouteParse(Packet,
+                                       &Link,
+                                       &Destination,
+                                       &PrefixLength,
+                                       &Gateway,
+                                       &GatewayValid);
+
+    if (!KSUCCESS(Status)) {
+        goto GenericRouteDeleteEnd;
+    }
+
+    GatewayPointer = NULL;
+    if (GatewayValid != FALSE) {
+        GatewayPointer = &Gateway;
+    }
+
+    Status = NetRemoveRoute(&Destination, PrefixLength, GatewayPointer, Link);
+
+GenericRouteDeleteEnd:
+    if (Link != NULL) {
+        NetLinkReleaseReference(Link);
+    }
+
+    return Status;
+}
+
+KSTATUS
+NetlinkpGenericRouteGet (
+    PNET_SOCKET Socket,
+    PNET_PACKET_BUFFER Packet,
+    PNETLINK_GENERIC_COMMAND_INFORMATION Command
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called to dump the routing tables. Each route is sent back
+    as its own message in a multipart reply.
+
+Arguments:
+
+    Socket - Supplies a pointer to the socket that received the packet.
+
+    Packet - Supplies a pointer to a structure describing the incoming packet.
+        This structure may be used as a scratch space while this routine
+        executes and the packet travels up the stack, but will not be accessed
+        after this routine returns.
+
+    Command - Supplies a pointer to the command information.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+    NETLINK_ROUTE_COLLECTION Collection;
+    DEVICE_ID DeviceId;
+    UINTN DomainCount;
+    UINTN DomainIndex;
+    ULONG Flags;
+    UINTN Index;
+    ULONG PayloadLength;
+    PNET_PACKET_BUFFER Results;
+    ULONG ResultsLength;
+    PNET_ROUTE Route;
+    KSTATUS Status;
+
+    DomainCount = sizeof(NetlinkGenericRouteDomains) /
+                  sizeof(NetlinkGenericRouteDomains[0]);
+
+    Results = NULL;
+    RtlZeroMemory(&Collection, sizeof(NETLINK_ROUTE_COLLECTION));
+
+    //
+    // Count the routes, then grab references on them all so the messages can
+    // be built without holding the table locks. If routes came in between
+    // the two passes, they'll be reported on the next request.
+    //
+
+    for (DomainIndex = 0; DomainIndex < DomainCount; DomainIndex += 1) {
+        NetEnumerateRoutes(NetlinkGenericRouteDomains[DomainIndex],
+                           NetlinkpGenericRouteCollect,
+                           &Collection);
+    }
+
+    if (Collection.Count != 0) {
+        Collection.Capacity = Collection.Count;
+        AllocationSize = Collection.Capacity * sizeof(PNET_ROUTE);
+        Collection.Routes = MmAllocatePagedPool(AllocationSize,
+                                                NETLINK_ROUTE_ALLOCATION_TAG);
+
+        if (Collection.Routes == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto GenericRouteGetEnd;
+        }
+
+        Collection.Count = 0;
+        for (DomainIndex = 0; DomainIndex < DomainCount; DomainIndex += 1) {
+            NetEnumerateRoutes(NetlinkGenericRouteDomains[DomainIndex],
+                               NetlinkpGenericRouteCollect,
+                               &Collection);
+        }
+
+        if (Collection.Count > Collection.Capacity) {
+            Collection.Count = Collection.Capacity;
+        }
+    }
+
+    //
+    // Every route message is the same size. Leave room for the done message
+    // at the end.
+    //
+
+    PayloadLength = NETLINK_ATTRIBUTE_SIZE(sizeof(DEVICE_ID)) +
+                    (NETLINK_ATTRIBUTE_SIZE(sizeof(NETWORK_ADDRESS)) * 2) +
+                    (NETLINK_ATTRIBUTE_SIZE(sizeof(ULONG)) * 3);
+
+    ResultsLength = (NETLINK_HEADER_LENGTH + NETLINK_GENERIC_HEADER_LENGTH +
+                     PayloadLength) * Collection.Count;
+
+    ResultsLength += NETLINK_HEADER_LENGTH;
+    Status = NetAllocateBuffer(0, ResultsLength, 0, NULL, 0, &Results);
+    if (!KSUCCESS(Status)) {
+        goto GenericRouteGetEnd;
+    }
+
+    for (Index = 0; Index < Collection.Count; Index += 1) {
+        Route = Collection.Routes[Index];
+        Status = NetlinkGenericAppendHeaders(NetlinkGenericRouteFamily,
+                                             Results,
+                                             PayloadLength,
+                                             Command->Message.SequenceNumber,
+                                             NETLINK_HEADER_FLAG_MULTIPART,
+                                             NETLINK_ROUTE_COMMAND_GET,
+                                             0);
+
+        if (!KSUCCESS(Status)) {
+            goto GenericRouteGetEnd;
+        }
+
+        DeviceId = IoGetDeviceNumericId(Route->Link->Properties.Device);
+        Status = NetlinkAppendAttribute(Results,
+                                        NETLINK_ROUTE_ATTRIBUTE_DEVICE_ID,
+                                        &DeviceId,
+                                        sizeof(DEVICE_ID));
+
+        if (!KSUCCESS(Status)) {
+            goto GenericRouteGetEnd;
+        }
+
+        Status = NetlinkAppendAttribute(Results,
+                                        NETLINK_ROUTE_ATTRIBUTE_DESTINATION,
+                                        &(Route->Destination),
+                                        sizeof(NETWORK_ADDRESS));
+
+        if (!KSUCCESS(Status)) {
+            goto GenericRouteGetEnd;
+        }
+
+        Status = NetlinkAppendAttribute(Results,
+                                        NETLINK_ROUTE_ATTRIBUTE_PREFIX_LENGTH,
+                                        &(Route->PrefixLength),
+                                        sizeof(ULONG));
+
+        if (!KSUCCESS(Status)) {
+            goto GenericRouteGetEnd;
+        }
+
+        Status = NetlinkAppendAttribute(Results,
+                                        NETLINK_ROUTE_ATTRIBUTE_GATEWAY,
+                                        &(Route->Gateway),
+                                        sizeof(NETWORK_ADDRESS));
+
+        if (!KSUCCESS(Status)) {
+            goto GenericRouteGetEnd;
+        }
+
+        Status = NetlinkAppendAttribute(Results,
+                                        NETLINK_ROUTE_ATTRIBUTE_METRIC,
+                                        &(Route->Metric),
+                                        sizeof(ULONG));
+
+        if (!KSUCCESS(Status)) {
+            goto GenericRouteGetEnd;
+        }
+
+        Flags = Route->Flags;
+        Status = NetlinkAppendAttribute(Results,
+                                        NETLINK_ROUTE_ATTRIBUTE_FLAGS,
+                                        &Flags,
+                                        sizeof(ULONG));
+
+        if (!KSUCCESS(Status)) {
+            goto GenericRouteGetEnd;
+        }
+    }
+
+    Status = NetlinkSendMultipartMessage(Socket,
+                                         Results,
+                                         Command->Message.SourceAddress,
+                                         Command->Message.SequenceNumber);
+
+    if (!KSUCCESS(Status)) {
+        goto GenericRouteGetEnd;
+    }
+
+GenericRouteGetEnd:
+    if (Results != NULL) {
+        NetFreeBuffer(Results);
+    }
+
+    if (Collection.Routes != NULL) {
+        for (Index = 0; Index < Collection.Count; Index += 1) {
+            NetRouteReleaseReference(Collection.Routes[Index]);
+        }
+
+        MmFreePagedPool(Collection.Routes);
+    }
+
+    return Status;
+}
+
+KSTATUS
+NetlinkpGenericRouteParse (
+    PNET_PACKET_BUFFER Packet,
+    PNET_LINK *Link,
+    PNETWORK_ADDRESS Destination,
+    PULONG PrefixLength,
+    PNETWORK_ADDRESS Gateway,
+    PBOOL GatewayValid
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses the attributes common to route add and delete
+    requests.
+
+Arguments:
+
+    Packet - Supplies a pointer to the netlink message to parse.
+
+    Link - Supplies a pointer where the link named by the optional device ID
+        attribute will be returned, or NULL if there was no device ID. The
+        caller is responsible for releasing the reference on the link.
+
+    Destination - Supplies a pointer where the destination will be returned.
+
+    PrefixLength - Supplies a pointer where the prefix length will be
+        returned.
+
+    Gateway - Supplies a pointer where the gateway will be returned if one
+        was supplied.
+
+    GatewayValid - Supplies a pointer where a boolean will be returned
+        indicating whether or not a gateway attribute was present.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PVOID Attributes;
+    ULONG AttributesLength;
+    PVOID Data;
+    USHORT DataLength;
+    PDEVICE Device;
+    KSTATUS Status;
+
+    Attributes = Packet->Buffer + Packet->DataOffset;
+    AttributesLength = Packet->FooterOffset - Packet->DataOffset;
+    Device = NULL;
+    *Link = NULL;
+    *GatewayValid = FALSE;
+    Status = NetlinkpGenericRouteGetAddress(Attributes,
+                                            AttributesLength,
+                                            NETLINK_ROUTE_ATTRIBUTE_DESTINATION,
+                                            Destination);
+
+    if (!KSUCCESS(Status)) {
+        goto GenericRouteParseEnd;
+    }
+
+    Status = NetlinkGetAttribute(Attributes,
+                                 AttributesLength,
+                                 NETLINK_ROUTE_ATTRIBUTE_PREFIX_LENGTH,
+                                 &Data,
+                                 &DataLength);
+
+    if (!KSUCCESS(Status)) {
+        goto GenericRouteParseEnd;
+    }
+
+    if (DataLength != sizeof(ULONG)) {
+        Status = STATUS_DATA_LENGTH_MISMATCH;
+        goto GenericRouteParseEnd;
+    }
+
+    *PrefixLength = *((PULONG)Data);
+
+    //
+    // The gateway is optional, and must be in the same domain as the
+    // destination if supplied.
+    //
+
+    Status = NetlinkpGenericRouteGetAddress(Attributes,
+                                            AttributesLength,
+                                            NETLINK_ROUTE_ATTRIBUTE_GATEWAY,
+                                            Gateway);
+
+    if (KSUCCESS(Status)) {
+        if (Gateway->Domain != Destination->Domain) {
+            Status = STATUS_INVALID_PARAMETER;
+            goto GenericRouteParseEnd;
+        }
+
+        *GatewayValid = TRUE;
+
+    } else if (Status != STATUS_NOT_FOUND) {
+        goto GenericRouteParseEnd;
+    }
+
+    //
+    // The device ID is optional too.
+    //
+
+    Status = NetlinkGetAttribute(Attributes,
+                                 AttributesLength,
+                                 NETLINK_ROUTE_ATTRIBUTE_DEVICE_ID,
+                                 &Data,
+                                 &DataLength);
+
+    if (!KSUCCESS(Status)) {
+        if (Status == STATUS_NOT_FOUND) {
+            Status = STATUS_SUCCESS;
+        }
+
+        goto GenericRouteParseEnd;
+    }
+
+    if (DataLength != sizeof(DEVICE_ID)) {
+        Status = STATUS_DATA_LENGTH_MISMATCH;
+        goto GenericRouteParseEnd;
+    }
+
+    Device = IoGetDeviceByNumericId(*((PDEVICE_ID)Data));
+    if (Device == NULL) {
+        Status = STATUS_NO_SUCH_DEVICE;
+        goto GenericRouteParseEnd;
+    }
+
+    Status = NetLookupLinkByDevice(Device, Link);
+    if (!KSUCCESS(Status)) {
+        goto GenericRouteParseEnd;
+    }
+
+GenericRouteParseEnd:
+    if (Device != NULL) {
+        IoDeviceReleaseReference(Device);
+    }
+
+    return Status;
+}
+
+VOID
+NetlinkpGenericRouteCollect (
+    PNET_ROUTE Route,
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called for each route in a routing table. It counts the
+    route and, if there's room, saves it with a reference.
+
+Arguments:
+
+    Route - Supplies a pointer to the route.
+
+    Context - Supplies a pointer to the route collection.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNETLINK_ROUTE_COLLECTION Collection;
+
+    Collection = Context;
+    if ((Collection->Routes != NULL) &&
+        (Collection->Count < Collection->Capacity)) {
+
+        NetRouteAddReference(Route);
+        Collection->Routes[Collection->Count] = Route;
+    }
+
+    Collection->Count += 1;
+    return;
+}
+
+KSTATUS
+NetlinkpGenericRouteGetAddress (
+    PVOID Attributes,
+    ULONG AttributesLength,
+    USHORT Type,
+    PNETWORK_ADDRESS Address
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads a network address attribute, making sure it's in a
+    domain that has a routing table.
+
+Arguments:
+
+    Attributes - Supplies a pointer to the start of the attributes.
+
+    AttributesLength - Supplies the length of the attributes, in bytes.
+
+    Type - Supplies the attribute type to get.
+
+    Address - Supplies a pointer where the address will be returned.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_NOT_FOUND if the attribute is not present.
+
+    Other error codes if the attribute is malformed.
+
+--*/
+
+{
+
+    PVOID Data;
+    USHORT DataLength;
+    KSTATUS Status;
+
+    Status = NetlinkGetAttribute(Attributes,
+                                 AttributesLength,
+                                 Type,
+                                 &Data,
+                                 &DataLength);
+
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    if (DataLength != sizeof(NETWORK_ADDRESS)) {
+        return STATUS_DATA_LENGTH_MISMATCH;
+    }
+
+    RtlCopyMemory(Address, Data, sizeof(NETWORK_ADDRESS));
+    if ((Address->Domain != NetDomainIp4) &&
+        (Address->Domain != NetDomainIp6)) {
+
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    return STATUS_SUCCESS;
+}
+
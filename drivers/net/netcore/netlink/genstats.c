@@ -0,0 +1,388 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    genstats.c
+
+Abstract:
+
+    This module implements the generic netlink statistics family, which
+    reports the protocol and link counters to user mode.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+//
+// Like the control family, avoid including netcore.h, but still redefine
+// those functions that would otherwise generate imports.
+//
+
+#define NET_API __DLLEXPORT
+
+#include <minoca/kernel/driver.h>
+#include <minoca/net/netdrv.h>
+#include <minoca/net/netlink.h>
+#include "generic.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define NETLINK_STATISTICS_ALLOCATION_TAG 0x53746C4E // 'StlN'
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure stores the context used to collect the network links.
+
+Members:
+
+    Links - Stores an optional pointer to the array of links to fill in. If
+        this is NULL, links are just counted.
+
+    Count - Stores the number of links seen so far.
+
+    Capacity - Stores the number of elements in the link array.
+
+--*/
+
+typedef struct _NETLINK_LINK_COLLECTION {
+    PNET_LINK *Links;
+    UINTN Count;
+    UINTN Capacity;
+} NETLINK_LINK_COLLECTION, *PNETLINK_LINK_COLLECTION;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+KSTATUS
+NetlinkpGenericStatisticsGet (
+    PNET_SOCKET Socket,
+    PNET_PACKET_BUFFER Packet,
+    PNETLINK_GENERIC_COMMAND_INFORMATION Command
+    );
+
+VOID
+NetlinkpGenericStatisticsCollectLink (
+    PNET_LINK Link,
+    PVOID Context
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+NETLINK_GENERIC_COMMAND NetlinkGenericStatisticsCommands[] = {
+    {
+        NETLINK_STATISTICS_COMMAND_GET,
+        NETLINK_HEADER_FLAG_DUMP,
+        NetlinkpGenericStatisticsGet
+    },
+};
+
+NETLINK_GENERIC_FAMILY_PROPERTIES NetlinkGenericStatisticsFamilyProperties = {
+    NETLINK_GENERIC_FAMILY_PROPERTIES_VERSION,
+    0,
+    sizeof(NETLINK_GENERIC_STATISTICS_NAME),
+    NETLINK_GENERIC_STATISTICS_NAME,
+    NetlinkGenericStatisticsCommands,
+    sizeof(NetlinkGenericStatisticsCommands) /
+        sizeof(NetlinkGenericStatisticsCommands[0]),
+
+    NULL,
+    0
+};
+
+PNETLINK_GENERIC_FAMILY NetlinkGenericStatisticsFamily = NULL;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+VOID
+NetlinkpGenericStatisticsInitialize (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes the built in generic netlink statistics family.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNETLINK_GENERIC_FAMILY_PROPERTIES Properties;
+    KSTATUS Status;
+
+    Properties = &NetlinkGenericStatisticsFamilyProperties;
+    Status = NetlinkGenericRegisterFamily(Properties,
+                                          &NetlinkGenericStatisticsFamily);
+
+    if (!KSUCCESS(Status)) {
+
+        ASSERT(KSUCCESS(Status));
+
+    }
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+KSTATUS
+NetlinkpGenericStatisticsGet (
+    PNET_SOCKET Socket,
+    PNET_PACKET_BUFFER Packet,
+    PNETLINK_GENERIC_COMMAND_INFORMATION Command
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called to dump the network statistics. The first message
+    in the multipart reply holds the system-wide counters, and each link gets
+    a message of its own after that.
+
+Arguments:
+
+    Socket - Supplies a pointer to the socket that received the packet.
+
+    Packet - Supplies a pointer to a structure describing the incoming packet.
+        This structure may be used as a scratch space while this routine
+        executes and the packet travels up the stack, but will not be accessed
+        after this routine returns.
+
+    Command - Supplies a pointer to the command information.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+    NETLINK_LINK_COLLECTION Collection;
+    DEVICE_ID DeviceId;
+    ULONGLONG GlobalValues[NetStatisticCount];
+    ULONG GlobalPayloadLength;
+    UINTN Index;
+    PNET_LINK Link;
+    ULONG LinkPayloadLength;
+    ULONGLONG LinkValues[NetLinkStatisticCount];
+    PNET_PACKET_BUFFER Results;
+    ULONG ResultsLength;
+    KSTATUS Status;
+
+    Results = NULL;
+    RtlZeroMemory(&Collection, sizeof(NETLINK_LINK_COLLECTION));
+
+    //
+    // Count the links, then grab references on them all so the messages can
+    // be built without holding the link list lock. Links that show up in
+    // between the two passes are reported on the next request.
+    //
+
+    NetEnumerateLinks(NetlinkpGenericStatisticsCollectLink, &Collection);
+    if (Collection.Count != 0) {
+        Collection.Capacity = Collection.Count;
+        AllocationSize = Collection.Capacity * sizeof(PNET_LINK);
+        Collection.Links = MmAllocatePagedPool(
+                                            AllocationSize,
+                                            NETLINK_STATISTICS_ALLOCATION_TAG);
+
+        if (Collection.Links == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto GenericStatisticsGetEnd;
+        }
+
+        Collection.Count = 0;
+        NetEnumerateLinks(NetlinkpGenericStatisticsCollectLink, &Collection);
+        if (Collection.Count > Collection.Capacity) {
+            Collection.Count = Collection.Capacity;
+        }
+    }
+
+    //
+    // Size the reply: one global message, one message per link, and the done
+    // message at the end.
+    //
+
+    GlobalPayloadLength = NETLINK_ATTRIBUTE_SIZE(sizeof(GlobalValues));
+    LinkPayloadLength = NETLINK_ATTRIBUTE_SIZE(sizeof(DEVICE_ID)) +
+                        NETLINK_ATTRIBUTE_SIZE(sizeof(LinkValues));
+
+    ResultsLength = NETLINK_HEADER_LENGTH + NETLINK_GENERIC_HEADER_LENGTH +
+                    GlobalPayloadLength;
+
+    ResultsLength += (NETLINK_HEADER_LENGTH + NETLINK_GENERIC_HEADER_LENGTH +
+                      LinkPayloadLength) * Collection.Count;
+
+    ResultsLength += NETLINK_HEADER_LENGTH;
+    Status = NetAllocateBuffer(0, ResultsLength, 0, NULL, 0, &Results);
+    if (!KSUCCESS(Status)) {
+        goto GenericStatisticsGetEnd;
+    }
+
+    Status = NetlinkGenericAppendHeaders(NetlinkGenericStatisticsFamily,
+                                         Results,
+                                         GlobalPayloadLength,
+                                         Command->Message.SequenceNumber,
+                                         NETLINK_HEADER_FLAG_MULTIPART,
+                                         NETLINK_STATISTICS_COMMAND_GET,
+                                         0);
+
+    if (!KSUCCESS(Status)) {
+        goto GenericStatisticsGetEnd;
+    }
+
+    NetGetStatistics(GlobalValues, NetStatisticCount);
+    Status = NetlinkAppendAttribute(Results,
+                                    NETLINK_STATISTICS_ATTRIBUTE_GLOBAL,
+                                    GlobalValues,
+                                    sizeof(GlobalValues));
+
+    if (!KSUCCESS(Status)) {
+        goto GenericStatisticsGetEnd;
+    }
+
+    for (Index = 0; Index < Collection.Count; Index += 1) {
+        Link = Collection.Links[Index];
+        Status = NetlinkGenericAppendHeaders(NetlinkGenericStatisticsFamily,
+                                             Results,
+                                             LinkPayloadLength,
+                                             Command->Message.SequenceNumber,
+                                             NETLINK_HEADER_FLAG_MULTIPART,
+                                             NETLINK_STATISTICS_COMMAND_GET,
+                                             0);
+
+        if (!KSUCCESS(Status)) {
+            goto GenericStatisticsGetEnd;
+        }
+
+        DeviceId = IoGetDeviceNumericId(Link->Properties.Device);
+        Status = NetlinkAppendAttribute(Results,
+                                        NETLINK_STATISTICS_ATTRIBUTE_DEVICE_ID,
+                                        &DeviceId,
+                                        sizeof(DEVICE_ID));
+
+        if (!KSUCCESS(Status)) {
+            goto GenericStatisticsGetEnd;
+        }
+
+        NetGetLinkStatistics(Link, LinkValues, NetLinkStatisticCount);
+        Status = NetlinkAppendAttribute(Results,
+                                        NETLINK_STATISTICS_ATTRIBUTE_LINK,
+                                        LinkValues,
+                                        sizeof(LinkValues));
+
+        if (!KSUCCESS(Status)) {
+            goto GenericStatisticsGetEnd;
+        }
+    }
+
+    Status = NetlinkSendMultipartMessage(Socket,
+                                         Results,
+                                         Command->Message.SourceAddress,
+                                         Command->Message.SequenceNumber);
+
+    if (!KSUCCESS(Status)) {
+        goto GenericStatisticsGetEnd;
+    }
+
+GenericStatisticsGetEnd:
+    if (Results != NULL) {
+        NetFreeBuffer(Results);
+    }
+
+    if (Collection.Links != NULL) {
+        for (Index = 0; Index < Collection.Count; Index += 1) {
+            NetLinkReleaseReference(Collection.Links[Index]);
+        }
+
+        MmFreePagedPool(Collection.Links);
+    }
+
+    return Status;
+}
+
+VOID
+NetlinkpGenericStatisticsCollectLink (
+    PNET_LINK Link,
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called for each network link. It counts the link and, if
+    there's room, saves it with a reference.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+    Context - Supplies a pointer to the link collection.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNETLINK_LINK_COLLECTION Collection;
+
+    Collection = Context;
+    if ((Collection->Links != NULL) &&
+        (Collection->Count < Collection->Capacity)) {
+
+        NetLinkAddReference(Link);
+        Collection->Links[Collection->Count] = Link;
+    }
+
+    Collection->Count += 1;
+    return;
+}
+
@@ -0,0 +1,1744 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    route.c
+
+Abstract:
+
+    This module implements the routing tables, which decide which link and
+    gateway packets bound for a given destination go out through.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/driver.h>
+#include <minoca/net/ip4.h>
+#include <minoca/net/ip6.h>
+#include "netcore.h"
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// This macro returns the given bit of an address, counting from the most
+// significant bit of the first byte.
+//
+
+#define NET_ROUTE_ADDRESS_BIT(_Address, _Bit)                   \
+    ((((PUCHAR)(_Address))[(_Bit) / BITS_PER_BYTE] >>           \
+      (BITS_PER_BYTE - 1 - ((_Bit) % BITS_PER_BYTE))) & 0x1)
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define NET_ROUTE_ALLOCATION_TAG 0x74756F52 // 'tuoR'
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef struct _NET_ROUTE_NODE NET_ROUTE_NODE, *PNET_ROUTE_NODE;
+
+/*++
+
+Structure Description:
+
+    This structure defines a node in a routing table. The table is a path
+    compressed binary trie: every node either holds routes or has two
+    children, so the depth of a lookup is bounded by the number of distinct
+    prefixes along the path rather than the number of address bits.
+
+Members:
+
+    Parent - Stores a pointer to the parent node, or NULL for the root.
+
+    Child - Stores pointers to the child nodes. The child at index N continues
+        the prefix with a bit of value N.
+
+    Prefix - Stores the prefix bits of this node. Any bits beyond the prefix
+        length are zero.
+
+    PrefixLength - Stores the number of significant bits in the prefix.
+
+    RouteList - Stores the head of the list of routes for this exact prefix,
+        sorted by metric.
+
+--*/
+
+struct _NET_ROUTE_NODE {
+    PNET_ROUTE_NODE Parent;
+    PNET_ROUTE_NODE Child[2];
+    UCHAR Prefix[MAX_NETWORK_ADDRESS_SIZE];
+    ULONG PrefixLength;
+    LIST_ENTRY RouteList;
+};
+
+/*++
+
+Structure Description:
+
+    This structure defines a routing table for a single network domain.
+
+Members:
+
+    Lock - Stores a pointer to the lock protecting the table. Lookups acquire
+        it shared, and may acquire a link's queued lock while holding it.
+
+    AddressBits - Stores the number of bits in an address of this domain. A
+        value of zero indicates the domain has no routing table.
+
+    Root - Stores the root node of the trie, which has a zero length prefix
+        and holds the default routes. It is never freed.
+
+--*/
+
+typedef struct _NET_ROUTE_TABLE {
+    PSHARED_EXCLUSIVE_LOCK Lock;
+    ULONG AddressBits;
+    NET_ROUTE_NODE Root;
+} NET_ROUTE_TABLE, *PNET_ROUTE_TABLE;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+PNET_ROUTE_TABLE
+NetpGetRouteTable (
+    NET_DOMAIN_TYPE Domain
+    );
+
+KSTATUS
+NetpSearchRouteTable (
+    PNET_ROUTE_TABLE Table,
+    PNETWORK_ADDRESS Destination,
+    PNET_LINK_LOCAL_ADDRESS LinkResult,
+    PNET_ROUTE *Route
+    );
+
+BOOL
+NetpGetRouteLocalAddress (
+    PNET_ROUTE Route,
+    PNET_LINK_LOCAL_ADDRESS LinkResult
+    );
+
+PNET_ROUTE_NODE
+NetpInsertRouteNode (
+    PNET_ROUTE_TABLE Table,
+    PUCHAR Prefix,
+    ULONG PrefixLength
+    );
+
+PNET_ROUTE_NODE
+NetpFindRouteNode (
+    PNET_ROUTE_TABLE Table,
+    PUCHAR Prefix,
+    ULONG PrefixLength
+    );
+
+VOID
+NetpPruneRouteNode (
+    PNET_ROUTE_TABLE Table,
+    PNET_ROUTE_NODE Node
+    );
+
+PNET_ROUTE_NODE
+NetpGetNextRouteNode (
+    PNET_ROUTE_TABLE Table,
+    PNET_ROUTE_NODE Node
+    );
+
+VOID
+NetpUnlinkRoute (
+    PNET_ROUTE Route,
+    PLIST_ENTRY ReleaseList
+    );
+
+VOID
+NetpReleaseRouteList (
+    PLIST_ENTRY ReleaseList
+    );
+
+ULONG
+NetpGetCommonPrefixLength (
+    PUCHAR First,
+    PUCHAR Second,
+    ULONG MaxLength
+    );
+
+VOID
+NetpMaskRoutePrefix (
+    PUCHAR Prefix,
+    ULONG PrefixLength
+    );
+
+ULONG
+NetpGetSubnetPrefixLength (
+    PNETWORK_ADDRESS Subnet,
+    ULONG AddressBits
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the routing tables, indexed by domain.
+//
+
+NET_ROUTE_TABLE NetRouteTables[NetDomainSocketNetworkCount];
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+NET_API
+KSTATUS
+NetAddRoute (
+    PNET_LINK Link,
+    PNET_LINK_ADDRESS_ENTRY LinkAddress,
+    PNETWORK_ADDRESS Destination,
+    ULONG PrefixLength,
+    PNETWORK_ADDRESS Gateway,
+    ULONG Metric,
+    ULONG Flags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a route to the routing table for the destination's
+    domain.
+
+Arguments:
+
+    Link - Supplies a pointer to the link packets following the route leave
+        through.
+
+    LinkAddress - Supplies an optional pointer to the link address entry
+        packets following the route are sent from. If NULL, any configured
+        address on the link is used.
+
+    Destination - Supplies a pointer to the destination prefix.
+
+    PrefixLength - Supplies the number of significant bits in the destination.
+        Supply zero to create a default route.
+
+    Gateway - Supplies an optional pointer to the gateway to send packets
+        through. If NULL, destinations are assumed to be directly reachable
+        on the link.
+
+    Metric - Supplies the cost of the route. Lower metrics are preferred.
+
+    Flags - Supplies a bitmask of route flags. See NET_ROUTE_FLAG_* for
+        definitions. The gateway flag is derived from the gateway parameter.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_NOT_SUPPORTED if the domain has no routing table.
+
+    STATUS_INVALID_PARAMETER if the prefix length is too long.
+
+    STATUS_DUPLICATE_ENTRY if an identical route already exists.
+
+    STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PNET_ROUTE ExistingRoute;
+    PNET_ROUTE NewRoute;
+    PNET_ROUTE_NODE Node;
+    BOOL SameGateway;
+    KSTATUS Status;
+    PNET_ROUTE_TABLE Table;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    Node = NULL;
+    NewRoute = NULL;
+    Table = NetpGetRouteTable(Destination->Domain);
+    if (Table == NULL) {
+        Status = STATUS_NOT_SUPPORTED;
+        goto AddRouteEnd;
+    }
+
+    if ((PrefixLength > Table->AddressBits) ||
+        ((Gateway != NULL) && (Gateway->Domain != Destination->Domain))) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto AddRouteEnd;
+    }
+
+    NewRoute = MmAllocatePagedPool(sizeof(NET_ROUTE), NET_ROUTE_ALLOCATION_TAG);
+    if (NewRoute == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto AddRouteEnd;
+    }
+
+    RtlZeroMemory(NewRoute, sizeof(NET_ROUTE));
+    NewRoute->ReferenceCount = 1;
+    Flags &= ~(NET_ROUTE_FLAG_GATEWAY | NET_ROUTE_FLAG_DELETED);
+    NewRoute->Flags = Flags;
+    RtlCopyMemory(&(NewRoute->Destination),
+                  Destination,
+                  sizeof(NETWORK_ADDRESS));
+
+    NewRoute->Destination.Port = 0;
+    NetpMaskRoutePrefix((PUCHAR)(NewRoute->Destination.Address),
+                        PrefixLength);
+
+    NewRoute->PrefixLength = PrefixLength;
+    NewRoute->Gateway.Domain = Destination->Domain;
+    if (Gateway != NULL) {
+        RtlCopyMemory(&(NewRoute->Gateway), Gateway, sizeof(NETWORK_ADDRESS));
+        NewRoute->Gateway.Port = 0;
+        NewRoute->Flags |= NET_ROUTE_FLAG_GATEWAY;
+    }
+
+    NewRoute->Link = Link;
+    NewRoute->LinkAddress = LinkAddress;
+    NewRoute->Metric = Metric;
+    KeAcquireSharedExclusiveLockExclusive(Table->Lock);
+    Node = NetpInsertRouteNode(Table,
+                               (PUCHAR)(NewRoute->Destination.Address),
+                               PrefixLength);
+
+    if (Node == NULL) {
+        KeReleaseSharedExclusiveLockExclusive(Table->Lock);
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto AddRouteEnd;
+    }
+
+    //
+    // Refuse exact duplicates, and otherwise find the first route with a
+    // higher metric. Routes of equal metric stay in the order they were added.
+    //
+
+    CurrentEntry = Node->RouteList.Next;
+    while (CurrentEntry != &(Node->RouteList)) {
+        ExistingRoute = LIST_VALUE(CurrentEntry, NET_ROUTE, ListEntry);
+        SameGateway = RtlCompareMemory(ExistingRoute->Gateway.Address,
+                                       NewRoute->Gateway.Address,
+                                       sizeof(NewRoute->Gateway.Address));
+
+        if ((ExistingRoute->Link == Link) &&
+            (ExistingRoute->LinkAddress == LinkAddress) &&
+            (SameGateway != FALSE)) {
+
+            KeReleaseSharedExclusiveLockExclusive(Table->Lock);
+            Status = STATUS_DUPLICATE_ENTRY;
+            goto AddRouteEnd;
+        }
+
+        if (ExistingRoute->Metric > Metric) {
+            break;
+        }
+
+        CurrentEntry = CurrentEntry->Next;
+    }
+
+    NetLinkAddReference(Link);
+    INSERT_BEFORE(&(NewRoute->ListEntry), CurrentEntry);
+    KeReleaseSharedExclusiveLockExclusive(Table->Lock);
+    NewRoute = NULL;
+    Status = STATUS_SUCCESS;
+
+AddRouteEnd:
+    if (NewRoute != NULL) {
+        MmFreePagedPool(NewRoute);
+    }
+
+    return Status;
+}
+
+NET_API
+KSTATUS
+NetRemoveRoute (
+    PNETWORK_ADDRESS Destination,
+    ULONG PrefixLength,
+    PNETWORK_ADDRESS Gateway,
+    PNET_LINK Link
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes routes from the routing table for the destination's
+    domain.
+
+Arguments:
+
+    Destination - Supplies a pointer to the destination prefix to remove.
+
+    PrefixLength - Supplies the number of significant bits in the destination.
+
+    Gateway - Supplies an optional pointer to the gateway of the route to
+        remove. If NULL, routes to the prefix through any gateway are removed.
+
+    Link - Supplies an optional pointer to the link of the route to remove. If
+        NULL, routes to the prefix over any link are removed.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one route was removed.
+
+    STATUS_NOT_FOUND if no routes matched.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PNET_ROUTE_NODE Node;
+    UCHAR Prefix[MAX_NETWORK_ADDRESS_SIZE];
+    LIST_ENTRY ReleaseList;
+    PNET_ROUTE Route;
+    BOOL SameGateway;
+    KSTATUS Status;
+    PNET_ROUTE_TABLE Table;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    Table = NetpGetRouteTable(Destination->Domain);
+    if ((Table == NULL) || (PrefixLength > Table->AddressBits)) {
+        return STATUS_NOT_FOUND;
+    }
+
+    RtlCopyMemory(Prefix, Destination->Address, MAX_NETWORK_ADDRESS_SIZE);
+    NetpMaskRoutePrefix(Prefix, PrefixLength);
+    INITIALIZE_LIST_HEAD(&ReleaseList);
+    Status = STATUS_NOT_FOUND;
+    KeAcquireSharedExclusiveLockExclusive(Table->Lock);
+    Node = NetpFindRouteNode(Table, Prefix, PrefixLength);
+    if (Node != NULL) {
+        CurrentEntry = Node->RouteList.Next;
+        while (CurrentEntry != &(Node->RouteList)) {
+            Route = LIST_VALUE(CurrentEntry, NET_ROUTE, ListEntry);
+            CurrentEntry = CurrentEntry->Next;
+            if ((Link != NULL) && (Route->Link != Link)) {
+                continue;
+            }
+
+            if (Gateway != NULL) {
+                SameGateway = RtlCompareMemory(Route->Gateway.Address,
+                                               Gateway->Address,
+                                               sizeof(Gateway->Address));
+
+                if (SameGateway == FALSE) {
+                    continue;
+                }
+            }
+
+            NetpUnlinkRoute(Route, &ReleaseList);
+            Status = STATUS_SUCCESS;
+        }
+
+        NetpPruneRouteNode(Table, Node);
+    }
+
+    KeReleaseSharedExclusiveLockExclusive(Table->Lock);
+    NetpReleaseRouteList(&ReleaseList);
+    return Status;
+}
+
+NET_API
+KSTATUS
+NetLookupRoute (
+    PNETWORK_ADDRESS Destination,
+    PNET_ROUTE *Route
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the best usable route to the given destination: the
+    lowest metric route of the longest matching prefix whose link is up and
+    has a configured address.
+
+Arguments:
+
+    Destination - Supplies a pointer to the destination address.
+
+    Route - Supplies a pointer where a pointer to the route will be returned
+        on success. The caller is responsible for releasing the reference
+        taken on the route.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_DESTINATION_UNREACHABLE if no usable route exists.
+
+--*/
+
+{
+
+    KSTATUS Status;
+    PNET_ROUTE_TABLE Table;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    *Route = NULL;
+    Table = NetpGetRouteTable(Destination->Domain);
+    if (Table == NULL) {
+        return STATUS_DESTINATION_UNREACHABLE;
+    }
+
+    KeAcquireSharedExclusiveLockShared(Table->Lock);
+    Status = NetpSearchRouteTable(Table, Destination, NULL, Route);
+    KeReleaseSharedExclusiveLockShared(Table->Lock);
+    return Status;
+}
+
+NET_API
+KSTATUS
+NetEnumerateRoutes (
+    NET_DOMAIN_TYPE Domain,
+    PNET_ROUTE_ENUMERATION_ROUTINE Routine,
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine calls the given routine for each route in a routing table.
+
+Arguments:
+
+    Domain - Supplies the network domain whose routes should be enumerated.
+
+    Routine - Supplies a pointer to the routine to call for each route.
+
+    Context - Supplies a context pointer to pass to the routine.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_NOT_SUPPORTED if the domain has no routing table.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PNET_ROUTE_NODE Node;
+    PNET_ROUTE Route;
+    PNET_ROUTE_TABLE Table;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    Table = NetpGetRouteTable(Domain);
+    if (Table == NULL) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    KeAcquireSharedExclusiveLockShared(Table->Lock);
+    Node = &(Table->Root);
+    while (Node != NULL) {
+        CurrentEntry = Node->RouteList.Next;
+        while (CurrentEntry != &(Node->RouteList)) {
+            Route = LIST_VALUE(CurrentEntry, NET_ROUTE, ListEntry);
+            CurrentEntry = CurrentEntry->Next;
+            Routine(Route, Context);
+        }
+
+        Node = NetpGetNextRouteNode(Table, Node);
+    }
+
+    KeReleaseSharedExclusiveLockShared(Table->Lock);
+    return STATUS_SUCCESS;
+}
+
+NET_API
+VOID
+NetRouteAddReference (
+    PNET_ROUTE Route
+    )
+
+/*++
+
+Routine Description:
+
+    This routine increases the reference count on a route.
+
+Arguments:
+
+    Route - Supplies a pointer to the route.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG OldReferenceCount;
+
+    OldReferenceCount = RtlAtomicAdd32(&(Route->ReferenceCount), 1);
+
+    ASSERT((OldReferenceCount != 0) && (OldReferenceCount < 0x10000000));
+
+    return;
+}
+
+NET_API
+VOID
+NetRouteReleaseReference (
+    PNET_ROUTE Route
+    )
+
+/*++
+
+Routine Description:
+
+    This routine decreases the reference count on a route, destroying it if
+    the count drops to zero.
+
+Arguments:
+
+    Route - Supplies a pointer to the route.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG OldReferenceCount;
+
+    OldReferenceCount = RtlAtomicAdd32(&(Route->ReferenceCount), -1);
+
+    ASSERT(OldReferenceCount != 0);
+
+    if (OldReferenceCount == 1) {
+
+        ASSERT((Route->Flags & NET_ROUTE_FLAG_DELETED) != 0);
+
+        NetLinkReleaseReference(Route->Link);
+        MmFreePagedPool(Route);
+    }
+
+    return;
+}
+
+KSTATUS
+NetpInitializeRoutes (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes the routing tables.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    NET_DOMAIN_TYPE Domain;
+    KSTATUS Status;
+    PNET_ROUTE_TABLE Table;
+
+    RtlZeroMemory(NetRouteTables, sizeof(NetRouteTables));
+    NetRouteTables[NetDomainIp4].AddressBits = IP4_ADDRESS_SIZE *
+                                               BITS_PER_BYTE;
+
+    NetRouteTables[NetDomainIp6].AddressBits = IP6_ADDRESS_SIZE *
+                                               BITS_PER_BYTE;
+
+    for (Domain = 0; Domain < NetDomainSocketNetworkCount; Domain += 1) {
+        Table = &(NetRouteTables[Domain]);
+        if (Table->AddressBits == 0) {
+            continue;
+        }
+
+        ASSERT(Table->AddressBits <=
+               (MAX_NETWORK_ADDRESS_SIZE * BITS_PER_BYTE));
+
+        INITIALIZE_LIST_HEAD(&(Table->Root.RouteList));
+        Table->Lock = KeCreateSharedExclusiveLock();
+        if (Table->Lock == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto InitializeRoutesEnd;
+        }
+    }
+
+    Status = STATUS_SUCCESS;
+
+InitializeRoutesEnd:
+    if (!KSUCCESS(Status)) {
+        for (Domain = 0; Domain < NetDomainSocketNetworkCount; Domain += 1) {
+            Table = &(NetRouteTables[Domain]);
+            if (Table->Lock != NULL) {
+                KeDestroySharedExclusiveLock(Table->Lock);
+                Table->Lock = NULL;
+            }
+
+            Table->AddressBits = 0;
+        }
+    }
+
+    return Status;
+}
+
+KSTATUS
+NetpFindRoutedLink (
+    PNETWORK_ADDRESS RemoteAddress,
+    PNET_LINK_LOCAL_ADDRESS LinkResult,
+    PNET_ROUTE *Route
+    )
+
+/*++
+
+Routine Description:
+
+    This routine uses the routing table to find the link and local address
+    used to reach the given remote address.
+
+Arguments:
+
+    RemoteAddress - Supplies a pointer to the address to reach.
+
+    LinkResult - Supplies a pointer that receives the link information. A
+        reference is taken on the link on success.
+
+    Route - Supplies an optional pointer that receives a referenced pointer
+        to the route that was used.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_DESTINATION_UNREACHABLE if no usable route exists.
+
+--*/
+
+{
+
+    PNET_ROUTE FoundRoute;
+    KSTATUS Status;
+    PNET_ROUTE_TABLE Table;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    Table = NetpGetRouteTable(RemoteAddress->Domain);
+    if (Table == NULL) {
+        return STATUS_DESTINATION_UNREACHABLE;
+    }
+
+    KeAcquireSharedExclusiveLockShared(Table->Lock);
+    Status = NetpSearchRouteTable(Table,
+                                  RemoteAddress,
+                                  LinkResult,
+                                  &FoundRoute);
+
+    KeReleaseSharedExclusiveLockShared(Table->Lock);
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    //
+    // The route holds a reference on its link, so the link can be referenced
+    // safely for the caller now that the table lock is released.
+    //
+
+    NetLinkAddReference(LinkResult->Link);
+    if (Route != NULL) {
+        *Route = FoundRoute;
+
+    } else {
+        NetRouteReleaseReference(FoundRoute);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+NetpAddLinkAddressRoutes (
+    PNET_LINK Link,
+    PNET_LINK_ADDRESS_ENTRY LinkAddress
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds the automatic routes for a newly configured link
+    address: one for its subnet and a default route through its gateway.
+    Failures are not fatal, as link selection falls back to scanning the
+    links when no route matches.
+
+Arguments:
+
+    Link - Supplies a pointer to the link that owns the address.
+
+    LinkAddress - Supplies a pointer to the configured link address entry.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    NETWORK_ADDRESS Address;
+    NETWORK_ADDRESS AnyAddress;
+    NETWORK_ADDRESS Gateway;
+    BOOL GatewayValid;
+    ULONG PrefixLength;
+    NETWORK_ADDRESS Subnet;
+    PNET_ROUTE_TABLE Table;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    //
+    // Snap the addressing parameters under the link lock so they're not torn
+    // by a concurrent reconfiguration.
+    //
+
+    KeAcquireQueuedLock(Link->QueuedLock);
+    if (LinkAddress->State < NetLinkAddressConfigured) {
+        KeReleaseQueuedLock(Link->QueuedLock);
+        return;
+    }
+
+    RtlCopyMemory(&Address, &(LinkAddress->Address), sizeof(NETWORK_ADDRESS));
+    RtlCopyMemory(&Subnet, &(LinkAddress->Subnet), sizeof(NETWORK_ADDRESS));
+    RtlCopyMemory(&Gateway,
+                  &(LinkAddress->DefaultGateway),
+                  sizeof(NETWORK_ADDRESS));
+
+    KeReleaseQueuedLock(Link->QueuedLock);
+    Table = NetpGetRouteTable(Address.Domain);
+    if (Table == NULL) {
+        return;
+    }
+
+    //
+    // Add the connected route for the subnet, through which everything on the
+    // local network is reached directly.
+    //
+
+    PrefixLength = NetpGetSubnetPrefixLength(&Subnet, Table->AddressBits);
+    if (PrefixLength != 0) {
+        NetAddRoute(Link,
+                    LinkAddress,
+                    &Address,
+                    PrefixLength,
+                    NULL,
+                    NET_ROUTE_DEFAULT_METRIC,
+                    NET_ROUTE_FLAG_AUTOMATIC);
+    }
+
+    //
+    // Add a default route through the gateway, if there is one.
+    //
+
+    RtlZeroMemory(&AnyAddress, sizeof(NETWORK_ADDRESS));
+    AnyAddress.Domain = Address.Domain;
+    GatewayValid = RtlCompareMemory(Gateway.Address,
+                                    AnyAddress.Address,
+                                    sizeof(AnyAddress.Address));
+
+    if (GatewayValid == FALSE) {
+        Gateway.Domain = Address.Domain;
+        Gateway.Port = 0;
+        NetAddRoute(Link,
+                    LinkAddress,
+                    &AnyAddress,
+                    0,
+                    &Gateway,
+                    NET_ROUTE_DEFAULT_METRIC,
+                    NET_ROUTE_FLAG_AUTOMATIC);
+    }
+
+    return;
+}
+
+VOID
+NetpRemoveLinkRoutes (
+    PNET_LINK Link,
+    PNET_LINK_ADDRESS_ENTRY LinkAddress
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes routes going out over the given link. This must be
+    called with the link's queued lock released.
+
+Arguments:
+
+    Link - Supplies a pointer to the link whose routes should be removed.
+
+    LinkAddress - Supplies an optional pointer to a link address entry. If
+        supplied, only routes sending from that address are removed.
+        Otherwise every route over the link is removed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    NET_DOMAIN_TYPE Domain;
+    PNET_ROUTE_NODE NextNode;
+    PNET_ROUTE_NODE Node;
+    BOOL Prune;
+    LIST_ENTRY ReleaseList;
+    PNET_ROUTE Route;
+    PNET_ROUTE_TABLE Table;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    INITIALIZE_LIST_HEAD(&ReleaseList);
+    for (Domain = 0; Domain < NetDomainSocketNetworkCount; Domain += 1) {
+        Table = &(NetRouteTables[Domain]);
+        if (Table->AddressBits == 0) {
+            continue;
+        }
+
+        if ((LinkAddress != NULL) && (LinkAddress->Address.Domain != Domain)) {
+            continue;
+        }
+
+        KeAcquireSharedExclusiveLockExclusive(Table->Lock);
+        Node = &(Table->Root);
+        while (Node != NULL) {
+
+            //
+            // Get the next node before pruning this one. Pruning only ever
+            // frees this node or its parent, neither of which can come next.
+            //
+
+            NextNode = NetpGetNextRouteNode(Table, Node);
+            Prune = FALSE;
+            CurrentEntry = Node->RouteList.Next;
+            while (CurrentEntry != &(Node->RouteList)) {
+                Route = LIST_VALUE(CurrentEntry, NET_ROUTE, ListEntry);
+                CurrentEntry = CurrentEntry->Next;
+                if ((Route->Link == Link) &&
+                    ((LinkAddress == NULL) ||
+                     (Route->LinkAddress == LinkAddress))) {
+
+                    NetpUnlinkRoute(Route, &ReleaseList);
+                    Prune = TRUE;
+                }
+            }
+
+            if (Prune != FALSE) {
+                NetpPruneRouteNode(Table, Node);
+            }
+
+            Node = NextNode;
+        }
+
+        KeReleaseSharedExclusiveLockExclusive(Table->Lock);
+    }
+
+    NetpReleaseRouteList(&ReleaseList);
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+PNET_ROUTE_TABLE
+NetpGetRouteTable (
+    NET_DOMAIN_TYPE Domain
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the routing table for the given domain.
+
+Arguments:
+
+    Domain - Supplies the network domain.
+
+Return Value:
+
+    Returns a pointer to the routing table, or NULL if the domain has none.
+
+--*/
+
+{
+
+    if ((Domain >= NetDomainSocketNetworkCount) ||
+        (NetRouteTables[Domain].AddressBits == 0)) {
+
+        return NULL;
+    }
+
+    return &(NetRouteTables[Domain]);
+}
+
+KSTATUS
+NetpSearchRouteTable (
+    PNET_ROUTE_TABLE Table,
+    PNETWORK_ADDRESS Destination,
+    PNET_LINK_LOCAL_ADDRESS LinkResult,
+    PNET_ROUTE *Route
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the best usable route to the given destination. The
+    table lock must be held.
+
+Arguments:
+
+    Table - Supplies a pointer to the routing table to search.
+
+    Destination - Supplies a pointer to the destination address.
+
+    LinkResult - Supplies an optional pointer that receives the local address
+        information for the route. No reference is taken on the link.
+
+    Route - Supplies a pointer where a referenced pointer to the route is
+        returned on success.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_DESTINATION_UNREACHABLE if no usable route exists.
+
+--*/
+
+{
+
+    PUCHAR Address;
+    ULONG Bit;
+    ULONG CommonLength;
+    PLIST_ENTRY CurrentEntry;
+    PNET_ROUTE CurrentRoute;
+    PNET_ROUTE_NODE Match;
+    PNET_ROUTE_NODE Node;
+    BOOL Usable;
+
+    *Route = NULL;
+    Address = (PUCHAR)(Destination->Address);
+
+    //
+    // Walk down the trie to the longest prefix that matches. Every node
+    // passed along the way has a prefix of the destination too.
+    //
+
+    Match = NULL;
+    Node = &(Table->Root);
+    while (Node != NULL) {
+        CommonLength = NetpGetCommonPrefixLength(Node->Prefix,
+                                                 Address,
+                                                 Node->PrefixLength);
+
+        if (CommonLength != Node->PrefixLength) {
+            break;
+        }
+
+        Match = Node;
+        if (Node->PrefixLength >= Table->AddressBits) {
+            break;
+        }
+
+        Bit = NET_ROUTE_ADDRESS_BIT(Address, Node->PrefixLength);
+        Node = Node->Child[Bit];
+    }
+
+    //
+    // Work back up towards the default routes, taking the cheapest route of
+    // the most specific prefix that can actually be used right now.
+    //
+
+    Node = Match;
+    while (Node != NULL) {
+        CurrentEntry = Node->RouteList.Next;
+        while (CurrentEntry != &(Node->RouteList)) {
+            CurrentRoute = LIST_VALUE(CurrentEntry, NET_ROUTE, ListEntry);
+            CurrentEntry = CurrentEntry->Next;
+            Usable = NetpGetRouteLocalAddress(CurrentRoute, LinkResult);
+            if (Usable != FALSE) {
+                NetRouteAddReference(CurrentRoute);
+                *Route = CurrentRoute;
+                return STATUS_SUCCESS;
+            }
+        }
+
+        Node = Node->Parent;
+    }
+
+    return STATUS_DESTINATION_UNREACHABLE;
+}
+
+BOOL
+NetpGetRouteLocalAddress (
+    PNET_ROUTE Route,
+    PNET_LINK_LOCAL_ADDRESS LinkResult
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether a route can be used, and if so, which
+    local address packets sent along it come from. The route's table lock must
+    be held.
+
+Arguments:
+
+    Route - Supplies a pointer to the route.
+
+    LinkResult - Supplies an optional pointer that receives the link, link
+        address entry, and local address. No reference is taken on the link.
+
+Return Value:
+
+    TRUE if the route's link is up and has a configured address.
+
+    FALSE if the route cannot currently be used.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PNET_LINK_ADDRESS_ENTRY FoundAddress;
+    PNET_LINK Link;
+    PNET_LINK_ADDRESS_ENTRY LinkAddress;
+    PLIST_ENTRY LinkAddressList;
+
+    Link = Route->Link;
+    if (Link->LinkUp == FALSE) {
+        return FALSE;
+    }
+
+    FoundAddress = NULL;
+    KeAcquireQueuedLock(Link->QueuedLock);
+    if (Route->LinkAddress != NULL) {
+        if (Route->LinkAddress->State >= NetLinkAddressConfigured) {
+            FoundAddress = Route->LinkAddress;
+        }
+
+    } else {
+        LinkAddressList = &(Link->LinkAddressArray[Route->Destination.Domain]);
+        CurrentEntry = LinkAddressList->Next;
+        while (CurrentEntry != LinkAddressList) {
+            LinkAddress = LIST_VALUE(CurrentEntry,
+                                     NET_LINK_ADDRESS_ENTRY,
+                                     ListEntry);
+
+            if (LinkAddress->State >= NetLinkAddressConfigured) {
+                FoundAddress = LinkAddress;
+                break;
+            }
+
+            CurrentEntry = CurrentEntry->Next;
+        }
+    }
+
+    //
+    // Copy the local address under the lock to prevent a torn read.
+    //
+
+    if ((FoundAddress != NULL) && (LinkResult != NULL)) {
+        LinkResult->Link = Link;
+        LinkResult->LinkAddress = FoundAddress;
+        RtlCopyMemory(&(LinkResult->ReceiveAddress),
+                      &(FoundAddress->Address),
+                      sizeof(NETWORK_ADDRESS));
+
+        RtlCopyMemory(&(LinkResult->SendAddress),
+                      &(FoundAddress->Address),
+                      sizeof(NETWORK_ADDRESS));
+
+        ASSERT(LinkResult->SendAddress.Port == 0);
+    }
+
+    KeReleaseQueuedLock(Link->QueuedLock);
+    if (FoundAddress == NULL) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+PNET_ROUTE_NODE
+NetpInsertRouteNode (
+    PNET_ROUTE_TABLE Table,
+    PUCHAR Prefix,
+    ULONG PrefixLength
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds or creates the trie node for the given prefix. The
+    table lock must be held exclusively.
+
+Arguments:
+
+    Table - Supplies a pointer to the routing table.
+
+    Prefix - Supplies a pointer to the prefix bytes, masked to the prefix
+        length.
+
+    PrefixLength - Supplies the number of significant bits in the prefix.
+
+Return Value:
+
+    Returns a pointer to the node on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    ULONG Bit;
+    PNET_ROUTE_NODE Child;
+    ULONG CommonLength;
+    PNET_ROUTE_NODE Leaf;
+    ULONG MaxLength;
+    PNET_ROUTE_NODE NewNode;
+    PNET_ROUTE_NODE Node;
+    PNET_ROUTE_NODE Split;
+
+    Node = &(Table->Root);
+    while (TRUE) {
+
+        //
+        // Everything up to this node matches, so if the lengths match this is
+        // the node.
+        //
+
+        if (Node->PrefixLength == PrefixLength) {
+            return Node;
+        }
+
+        ASSERT(Node->PrefixLength < PrefixLength);
+
+        Bit = NET_ROUTE_ADDRESS_BIT(Prefix, Node->PrefixLength);
+        Child = Node->Child[Bit];
+        if (Child == NULL) {
+            break;
+        }
+
+        MaxLength = Child->PrefixLength;
+        if (PrefixLength < MaxLength) {
+            MaxLength = PrefixLength;
+        }
+
+        CommonLength = NetpGetCommonPrefixLength(Child->Prefix,
+                                                 Prefix,
+                                                 MaxLength);
+
+        if (CommonLength == Child->PrefixLength) {
+            Node = Child;
+            continue;
+        }
+
+        //
+        // The new prefix diverges partway into the child's prefix (or ends
+        // there). A node is needed at the point of divergence.
+        //
+
+        Split = MmAllocatePagedPool(sizeof(NET_ROUTE_NODE),
+                                    NET_ROUTE_ALLOCATION_TAG);
+
+        if (Split == NULL) {
+            return NULL;
+        }
+
+        RtlZeroMemory(Split, sizeof(NET_ROUTE_NODE));
+        INITIALIZE_LIST_HEAD(&(Split->RouteList));
+        RtlCopyMemory(Split->Prefix, Prefix, MAX_NETWORK_ADDRESS_SIZE);
+        NetpMaskRoutePrefix(Split->Prefix, CommonLength);
+        Split->PrefixLength = CommonLength;
+        Leaf = NULL;
+        if (CommonLength != PrefixLength) {
+            Leaf = MmAllocatePagedPool(sizeof(NET_ROUTE_NODE),
+                                       NET_ROUTE_ALLOCATION_TAG);
+
+            if (Leaf == NULL) {
+                MmFreePagedPool(Split);
+                return NULL;
+            }
+
+            RtlZeroMemory(Leaf, sizeof(NET_ROUTE_NODE));
+            INITIALIZE_LIST_HEAD(&(Leaf->RouteList));
+            RtlCopyMemory(Leaf->Prefix, Prefix, MAX_NETWORK_ADDRESS_SIZE);
+            Leaf->PrefixLength = PrefixLength;
+            Leaf->Parent = Split;
+            Split->Child[NET_ROUTE_ADDRESS_BIT(Prefix, CommonLength)] = Leaf;
+        }
+
+        Split->Parent = Node;
+        Split->Child[NET_ROUTE_ADDRESS_BIT(Child->Prefix, CommonLength)] =
+                                                                        Child;
+
+        Child->Parent = Split;
+        Node->Child[Bit] = Split;
+        if (Leaf != NULL) {
+            return Leaf;
+        }
+
+        return Split;
+    }
+
+    //
+    // There's nothing down this branch yet, so hang a new leaf right here.
+    //
+
+    NewNode = MmAllocatePagedPool(sizeof(NET_ROUTE_NODE),
+                                  NET_ROUTE_ALLOCATION_TAG);
+
+    if (NewNode == NULL) {
+        return NULL;
+    }
+
+    RtlZeroMemory(NewNode, sizeof(NET_ROUTE_NODE));
+    INITIALIZE_LIST_HEAD(&(NewNode->RouteList));
+    RtlCopyMemory(NewNode->Prefix, Prefix, MAX_NETWORK_ADDRESS_SIZE);
+    NewNode->PrefixLength = PrefixLength;
+    NewNode->Parent = Node;
+    Node->Child[Bit] = NewNode;
+    return NewNode;
+}
+
+PNET_ROUTE_NODE
+NetpFindRouteNode (
+    PNET_ROUTE_TABLE Table,
+    PUCHAR Prefix,
+    ULONG PrefixLength
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds the trie node for exactly the given prefix. The table
+    lock must be held.
+
+Arguments:
+
+    Table - Supplies a pointer to the routing table.
+
+    Prefix - Supplies a pointer to the prefix bytes, masked to the prefix
+        length.
+
+    PrefixLength - Supplies the number of significant bits in the prefix.
+
+Return Value:
+
+    Returns a pointer to the node, or NULL if there is none.
+
+--*/
+
+{
+
+    ULONG CommonLength;
+    PNET_ROUTE_NODE Node;
+
+    Node = &(Table->Root);
+    while (Node != NULL) {
+        if (Node->PrefixLength > PrefixLength) {
+            break;
+        }
+
+        CommonLength = NetpGetCommonPrefixLength(Node->Prefix,
+                                                 Prefix,
+                                                 Node->PrefixLength);
+
+        if (CommonLength != Node->PrefixLength) {
+            break;
+        }
+
+        if (Node->PrefixLength == PrefixLength) {
+            return Node;
+        }
+
+        Node = Node->Child[NET_ROUTE_ADDRESS_BIT(Prefix, Node->PrefixLength)];
+    }
+
+    return NULL;
+}
+
+VOID
+NetpPruneRouteNode (
+    PNET_ROUTE_TABLE Table,
+    PNET_ROUTE_NODE Node
+    )
+
+/*++
+
+Routine Description:
+
+    This routine frees a trie node if it no longer holds routes and isn't
+    needed to join two branches, and then does the same for its parent if
+    that frees it up. The table lock must be held exclusively.
+
+Arguments:
+
+    Table - Supplies a pointer to the routing table.
+
+    Node - Supplies a pointer to the node that may have become unnecessary.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNET_ROUTE_NODE Child;
+    ULONG Index;
+    PNET_ROUTE_NODE Parent;
+
+    while ((Node != &(Table->Root)) && (LIST_EMPTY(&(Node->RouteList)))) {
+        if ((Node->Child[0] != NULL) && (Node->Child[1] != NULL)) {
+            break;
+        }
+
+        Child = Node->Child[0];
+        if (Child == NULL) {
+            Child = Node->Child[1];
+        }
+
+        Parent = Node->Parent;
+        Index = 0;
+        if (Parent->Child[1] == Node) {
+            Index = 1;
+        }
+
+        Parent->Child[Index] = Child;
+        MmFreePagedPool(Node);
+
+        //
+        // A node with one child can simply be spliced out, which doesn't
+        // change how many children the parent has.
+        //
+
+        if (Child != NULL) {
+            Child->Parent = Parent;
+            break;
+        }
+
+        Node = Parent;
+    }
+
+    return;
+}
+
+PNET_ROUTE_NODE
+NetpGetNextRouteNode (
+    PNET_ROUTE_TABLE Table,
+    PNET_ROUTE_NODE Node
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the node after the given one in a pre-order walk of
+    the trie. The table lock must be held.
+
+Arguments:
+
+    Table - Supplies a pointer to the routing table.
+
+    Node - Supplies a pointer to the current node.
+
+Return Value:
+
+    Returns a pointer to the next node, or NULL if the walk is complete.
+
+--*/
+
+{
+
+    PNET_ROUTE_NODE Parent;
+
+    if (Node->Child[0] != NULL) {
+        return Node->Child[0];
+    }
+
+    if (Node->Child[1] != NULL) {
+        return Node->Child[1];
+    }
+
+    while (Node != &(Table->Root)) {
+        Parent = Node->Parent;
+        if ((Parent->Child[0] == Node) && (Parent->Child[1] != NULL)) {
+            return Parent->Child[1];
+        }
+
+        Node = Parent;
+    }
+
+    return NULL;
+}
+
+VOID
+NetpUnlinkRoute (
+    PNET_ROUTE Route,
+    PLIST_ENTRY ReleaseList
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes a route out of its table. The table lock must be held
+    exclusively. The table's reference on the route is released later by
+    NetpReleaseRouteList, once the lock is dropped.
+
+Arguments:
+
+    Route - Supplies a pointer to the route to remove.
+
+    ReleaseList - Supplies a pointer to the list to put the route on.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    RtlAtomicOr32(&(Route->Flags), NET_ROUTE_FLAG_DELETED);
+    LIST_REMOVE(&(Route->ListEntry));
+    INSERT_BEFORE(&(Route->ListEntry), ReleaseList);
+    return;
+}
+
+VOID
+NetpReleaseRouteList (
+    PLIST_ENTRY ReleaseList
+    )
+
+/*++
+
+Routine Description:
+
+    This routine releases the table references on a list of removed routes.
+
+Arguments:
+
+    ReleaseList - Supplies a pointer to the head of the list of routes.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PNET_ROUTE Route;
+
+    while (LIST_EMPTY(ReleaseList) == FALSE) {
+        Route = LIST_VALUE(ReleaseList->Next, NET_ROUTE, ListEntry);
+        LIST_REMOVE(&(Route->ListEntry));
+        Route->ListEntry.Next = NULL;
+        NetRouteReleaseReference(Route);
+    }
+
+    return;
+}
+
+ULONG
+NetpGetCommonPrefixLength (
+    PUCHAR First,
+    PUCHAR Second,
+    ULONG MaxLength
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines how many leading bits two prefixes share.
+
+Arguments:
+
+    First - Supplies a pointer to the first prefix.
+
+    Second - Supplies a pointer to the second prefix.
+
+    MaxLength - Supplies the maximum number of bits to compare.
+
+Return Value:
+
+    Returns the number of leading bits the prefixes have in common, up to the
+    given maximum.
+
+--*/
+
+{
+
+    ULONG ByteIndex;
+    UCHAR Difference;
+    ULONG Length;
+
+    Length = 0;
+    for (ByteIndex = 0; Length < MaxLength; ByteIndex += 1) {
+        Difference = First[ByteIndex] ^ Second[ByteIndex];
+        if (Difference == 0) {
+            Length += BITS_PER_BYTE;
+            continue;
+        }
+
+        while ((Difference & 0x80) == 0) {
+            Difference <<= 1;
+            Length += 1;
+        }
+
+        break;
+    }
+
+    if (Length > MaxLength) {
+        Length = MaxLength;
+    }
+
+    return Length;
+}
+
+VOID
+NetpMaskRoutePrefix (
+    PUCHAR Prefix,
+    ULONG PrefixLength
+    )
+
+/*++
+
+Routine Description:
+
+    This routine zeroes all the bits of a prefix beyond its length.
+
+Arguments:
+
+    Prefix - Supplies a pointer to the prefix bytes, which are at least
+        MAX_NETWORK_ADDRESS_SIZE long.
+
+    PrefixLength - Supplies the number of significant bits.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG ByteIndex;
+
+    ByteIndex = PrefixLength / BITS_PER_BYTE;
+    if ((PrefixLength % BITS_PER_BYTE) != 0) {
+        Prefix[ByteIndex] &= (UCHAR)(0xFF00 >> (PrefixLength % BITS_PER_BYTE));
+        ByteIndex += 1;
+    }
+
+    if (ByteIndex < MAX_NETWORK_ADDRESS_SIZE) {
+        RtlZeroMemory(&(Prefix[ByteIndex]),
+                      MAX_NETWORK_ADDRESS_SIZE - ByteIndex);
+    }
+
+    return;
+}
+
+ULONG
+NetpGetSubnetPrefixLength (
+    PNETWORK_ADDRESS Subnet,
+    ULONG AddressBits
+    )
+
+/*++
+
+Routine Description:
+
+    This routine converts a subnet mask into a prefix length by counting its
+    leading one bits.
+
+Arguments:
+
+    Subnet - Supplies a pointer to the subnet mask.
+
+    AddressBits - Supplies the number of bits in an address of the domain.
+
+Return Value:
+
+    Returns the prefix length of the subnet.
+
+--*/
+
+{
+
+    ULONG Length;
+    PUCHAR Mask;
+
+    Mask = (PUCHAR)(Subnet->Address);
+    Length = 0;
+    while ((Length < AddressBits) &&
+           (NET_ROUTE_ADDRESS_BIT(Mask, Length) != 0)) {
+
+        Length += 1;
+    }
+
+    return Length;
+}
+
@@ -0,0 +1,509 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    stats.c
+
+Abstract:
+
+    This module implements the network statistics counters. Each processor
+    gets its own cache line aligned block of counters so that the hot send and
+    receive paths never contend with one another. The blocks are summed when
+    the counters are read.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/driver.h>
+#include "netcore.h"
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// This macro returns the size of one processor's block of the given number of
+// counters, padded out so that the next processor's block starts on its own
+// cache line.
+//
+
+#define NET_STATISTICS_STRIDE(_Count) \
+    ALIGN_RANGE_UP((_Count) * sizeof(ULONGLONG), NET_STATISTICS_ALIGNMENT)
+
+//
+// This macro returns the size of the allocation needed to hold the given
+// number of counters for every processor, including the slop needed to align
+// the start of the array.
+//
+
+#define NET_STATISTICS_ALLOCATION_SIZE(_Count)                          \
+    ((NET_STATISTICS_STRIDE(_Count) * NetStatisticsProcessorCount) +    \
+     NET_STATISTICS_ALIGNMENT)
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define NET_STATISTICS_ALLOCATION_TAG 0x74617453 // 'tatS'
+
+//
+// Define the alignment of each processor's block of counters, which is the
+// largest common cache line size.
+//
+
+#define NET_STATISTICS_ALIGNMENT 64
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+PULONGLONG
+NetpGetStatisticsBlock (
+    PULONGLONG Allocation,
+    ULONG Count,
+    ULONG Processor
+    );
+
+VOID
+NetpSumStatistics (
+    PULONGLONG Allocation,
+    ULONG CounterCount,
+    PULONGLONG Values,
+    ULONG Count
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the number of per-processor blocks in each statistics array.
+//
+
+ULONG NetStatisticsProcessorCount;
+
+//
+// Store the system-wide statistics counters.
+//
+
+PULONGLONG NetStatistics;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+NET_API
+VOID
+NetAddStatistic (
+    NET_STATISTIC Statistic,
+    ULONGLONG Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds to one of the system-wide network statistics counters.
+    The counters are kept per processor, so this is cheap and lock free, and
+    can be called at any run level.
+
+Arguments:
+
+    Statistic - Supplies the counter to add to.
+
+    Value - Supplies the amount to add.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PULONGLONG Block;
+
+    ASSERT(Statistic < NetStatisticCount);
+
+    if (NetStatistics == NULL) {
+        return;
+    }
+
+    //
+    // The thread may migrate to another processor before the add lands, so
+    // the add still has to be atomic. It is nearly always uncontended though,
+    // which is what makes it cheap.
+    //
+
+    Block = NetpGetStatisticsBlock(NetStatistics,
+                                   NetStatisticCount,
+                                   KeGetCurrentProcessorNumber());
+
+    RtlAtomicAdd64(&(Block[Statistic]), Value);
+    return;
+}
+
+NET_API
+VOID
+NetAddLinkStatistic (
+    PNET_LINK Link,
+    NET_LINK_STATISTIC Statistic,
+    ULONGLONG Value
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds to one of a link's statistics counters. The counters are
+    kept per processor, so this is cheap and lock free, and can be called at
+    any run level.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+    Statistic - Supplies the counter to add to.
+
+    Value - Supplies the amount to add.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PULONGLONG Block;
+
+    ASSERT(Statistic < NetLinkStatisticCount);
+
+    if (Link->Statistics == NULL) {
+        return;
+    }
+
+    Block = NetpGetStatisticsBlock(Link->Statistics,
+                                   NetLinkStatisticCount,
+                                   KeGetCurrentProcessorNumber());
+
+    RtlAtomicAdd64(&(Block[Statistic]), Value);
+    return;
+}
+
+NET_API
+VOID
+NetGetStatistics (
+    PULONGLONG Values,
+    ULONG Count
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sums the system-wide network statistics across all
+    processors. The result is not an atomic snapshot, as counters may be
+    updated while they are being read.
+
+Arguments:
+
+    Values - Supplies a pointer to an array that receives the counter values,
+        indexed by NET_STATISTIC.
+
+    Count - Supplies the number of elements in the array. Counters beyond the
+        array are not returned, and array elements beyond the last counter are
+        set to zero.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    NetpSumStatistics(NetStatistics, NetStatisticCount, Values, Count);
+    return;
+}
+
+NET_API
+VOID
+NetGetLinkStatistics (
+    PNET_LINK Link,
+    PULONGLONG Values,
+    ULONG Count
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sums a link's statistics counters across all processors.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+    Values - Supplies a pointer to an array that receives the counter values,
+        indexed by NET_LINK_STATISTIC.
+
+    Count - Supplies the number of elements in the array. Counters beyond the
+        array are not returned, and array elements beyond the last counter are
+        set to zero.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    NetpSumStatistics(Link->Statistics, NetLinkStatisticCount, Values, Count);
+    return;
+}
+
+KSTATUS
+NetpInitializeStatistics (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes the system-wide network statistics counters.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+
+    NetStatisticsProcessorCount = KeGetActiveProcessorCount();
+    if (NetStatisticsProcessorCount == 0) {
+        NetStatisticsProcessorCount = 1;
+    }
+
+    AllocationSize = NET_STATISTICS_ALLOCATION_SIZE(NetStatisticCount);
+    NetStatistics = MmAllocateNonPagedPool(AllocationSize,
+                                           NET_STATISTICS_ALLOCATION_TAG);
+
+    if (NetStatistics == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(NetStatistics, AllocationSize);
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+NetpCreateLinkStatistics (
+    PNET_LINK Link
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates the statistics counters for a new link.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+
+    ASSERT(Link->Statistics == NULL);
+
+    AllocationSize = NET_STATISTICS_ALLOCATION_SIZE(NetLinkStatisticCount);
+    Link->Statistics = MmAllocateNonPagedPool(AllocationSize,
+                                              NET_STATISTICS_ALLOCATION_TAG);
+
+    if (Link->Statistics == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(Link->Statistics, AllocationSize);
+    return STATUS_SUCCESS;
+}
+
+VOID
+NetpDestroyLinkStatistics (
+    PNET_LINK Link
+    )
+
+/*++
+
+Routine Description:
+
+    This routine frees the statistics counters for a link.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (Link->Statistics != NULL) {
+        MmFreeNonPagedPool(Link->Statistics);
+        Link->Statistics = NULL;
+    }
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+PULONGLONG
+NetpGetStatisticsBlock (
+    PULONGLONG Allocation,
+    ULONG Count,
+    ULONG Processor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns a processor's block of counters within a statistics
+    array.
+
+Arguments:
+
+    Allocation - Supplies a pointer to the statistics array allocation.
+
+    Count - Supplies the number of counters in each block.
+
+    Processor - Supplies the processor number. Processors that came online
+        after the array was allocated share blocks with the original ones.
+
+Return Value:
+
+    Returns a pointer to the first counter in the processor's block.
+
+--*/
+
+{
+
+    UINTN Address;
+
+    if (Processor >= NetStatisticsProcessorCount) {
+        Processor %= NetStatisticsProcessorCount;
+    }
+
+    Address = ALIGN_RANGE_UP((UINTN)Allocation, NET_STATISTICS_ALIGNMENT);
+    Address += Processor * NET_STATISTICS_STRIDE(Count);
+    return (PULONGLONG)Address;
+}
+
+VOID
+NetpSumStatistics (
+    PULONGLONG Allocation,
+    ULONG CounterCount,
+    PULONGLONG Values,
+    ULONG Count
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sums a statistics array across all processors.
+
+Arguments:
+
+    Allocation - Supplies a pointer to the statistics array allocation.
+
+    CounterCount - Supplies the number of counters in each block.
+
+    Values - Supplies a pointer to an array that receives the sums.
+
+    Count - Supplies the number of elements in the values array.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PULONGLONG Block;
+    ULONG Index;
+    ULONG Processor;
+
+    RtlZeroMemory(Values, Count * sizeof(ULONGLONG));
+    if (Allocation == NULL) {
+        return;
+    }
+
+    if (Count > CounterCount) {
+        Count = CounterCount;
+    }
+
+    for (Processor = 0;
+         Processor < NetStatisticsProcessorCount;
+         Processor += 1) {
+
+        //
+        // Use an atomic operation to read each counter, as a plain 64-bit
+        // read can tear on 32-bit architectures.
+        //
+
+        Block = NetpGetStatisticsBlock(Allocation, CounterCount, Processor);
+        for (Index = 0; Index < Count; Index += 1) {
+            Values[Index] += RtlAtomicOr64(&(Block[Index]), 0);
+        }
+    }
+
+    return;
+}
+
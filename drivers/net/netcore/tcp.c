@@ -2187,6 +2187,7 @@ Return Value:
     // Validate the packet is at least as long as the header plus its options.
     //
 
+    NetAddStatistic(NetStatisticTcpInSegments, 1);
     Packet = ReceiveContext->Packet;
     Length = Packet->FooterOffset - Packet->DataOffset;
     if (Length < sizeof(TCP_HEADER)) {
@@ -2194,6 +2195,7 @@ Return Value:
                       "Header. Length = %d\n",
                       Length);
 
+        NetAddStatistic(NetStatisticTcpInErrors, 1);
         return;
     }
 
@@ -2206,6 +2208,7 @@ Return Value:
                       "minimum 20.\n",
                       HeaderLength);
 
+        NetAddStatistic(NetStatisticTcpInErrors, 1);
         return;
     }
 
@@ -2215,6 +2218,7 @@ Return Value:
                       Length,
                       HeaderLength);
 
+        NetAddStatistic(NetStatisticTcpInErrors, 1);
         return;
     }
 
@@ -2245,6 +2249,8 @@ Return Value:
                           ReceiveContext->Destination->Port,
                           ReceiveContext->Source->Port);
 
+            NetAddStatistic(NetStatisticTcpInErrors, 1);
+            NetAddStatistic(NetStatisticTcpInChecksumErrors, 1);
             return;
         }
     }
@@ -5747,6 +5753,11 @@ Return Value:
         goto TcpSendControlPacketEnd;
     }
 
+    NetAddStatistic(NetStatisticTcpOutSegments, 1);
+    if ((Flags & TCP_HEADER_FLAG_RESET) != 0) {
+        NetAddStatistic(NetStatisticTcpOutResets, 1);
+    }
+
 TcpSendControlPacketEnd:
     if (!KSUCCESS(Status)) {
         NetDestroyBufferList(&PacketList);
@@ -5820,6 +5831,12 @@ Return Value:
                       Length);
     }
 
+    if (TCP_SEQUENCE_GREATER_THAN(SequenceNumber,
+                                  Socket->ReceiveNextSequence)) {
+
+        NetAddStatistic(NetStatisticTcpOutOfOrderSegments, 1);
+    }
+
     //
     // Loop through every segment to find a segment with a larger sequence than
     // this one. If such a segment is found, then try to fill in the hole
@@ -6665,6 +6682,7 @@ Return Value:
                 NetpTcpTransmissionTimeout(Socket, Segment);
                 NetpTcpGetTransmitTimeoutInterval(Socket, Segment);
                 Segment->SendAttemptCount += 1;
+                NetAddStatistic(NetStatisticTcpRetransmittedSegments, 1);
                 break;
             }
         }
@@ -6683,6 +6701,7 @@ Return Value:
     // Otherwise send off the whole group of packets.
     //
 
+    NetAddStatistic(NetStatisticTcpOutSegments, PacketList.Count);
     Status = Socket->NetSocket.Network->Interface.Send(
                                             &(Socket->NetSocket),
                                             &(Socket->NetSocket.RemoteAddress),
@@ -6774,6 +6793,11 @@ Return Value:
         goto TcpSendSegmentEnd;
     }
 
+    NetAddStatistic(NetStatisticTcpOutSegments, 1);
+    if (Segment->SendAttemptCount != 0) {
+        NetAddStatistic(NetStatisticTcpRetransmittedSegments, 1);
+    }
+
     //
     // Update the next pointer and window if this is the first time this packet
     // is being sent.
@@ -7848,6 +7872,33 @@ Return Value:
     Socket->PreviousState = OldState;
     Socket->State = NewState;
 
+    //
+    // Update the connection statistics, which are defined in terms of state
+    // transitions.
+    //
+
+    if (NewState == TcpStateSynSent) {
+        NetAddStatistic(NetStatisticTcpActiveOpens, 1);
+
+    } else if ((NewState == TcpStateSynReceived) &&
+               (OldState != TcpStateSynSent)) {
+
+        NetAddStatistic(NetStatisticTcpPassiveOpens, 1);
+
+    } else if (((OldState == TcpStateSynSent) ||
+                (OldState == TcpStateSynReceived)) &&
+               ((NewState == TcpStateInitialized) ||
+                (NewState == TcpStateClosed))) {
+
+        NetAddStatistic(NetStatisticTcpAttemptFailures, 1);
+
+    } else if (((OldState == TcpStateEstablished) ||
+                (OldState == TcpStateCloseWait)) &&
+               (NewState == TcpStateClosed)) {
+
+        NetAddStatistic(NetStatisticTcpEstablishedResets, 1);
+    }
+
     //
     // Modify the socket based on the new state.
     //
@@ -8253,6 +8304,8 @@ Return Value:
         goto TcpSendSynEnd;
     }
 
+    NetAddStatistic(NetStatisticTcpOutSegments, 1);
+
 TcpSendSynEnd:
     if (!KSUCCESS(Status)) {
         NetDestroyBufferList(&PacketList);
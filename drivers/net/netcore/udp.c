@@ -84,6 +84,13 @@ Module Name:
 
 #define UDP_SEND_MINIMUM 1
 
+//
+// Define the maximum number of datagrams a single segmented send can be
+// split into.
+//
+
+#define UDP_MAX_SEGMENT_COUNT 64
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -127,6 +134,9 @@ Structure Description:
 
     MaxPacketSize - Stores the maximum size of UDP datagrams.
 
+    SegmentSize - Stores the size of the datagrams each send is split into,
+        not including the UDP header. Zero means each send is one datagram.
+
 --*/
 
 typedef struct _UDP_SOCKET {
@@ -140,6 +150,7 @@ typedef struct _UDP_SOCKET {
     ULONG DroppedPacketCount;
     ULONG ShutdownTypes;
     USHORT MaxPacketSize;
+    ULONG SegmentSize;
 } UDP_SOCKET, *PUDP_SOCKET;
 
 /*++
@@ -399,6 +410,13 @@ UDP_SOCKET_OPTION NetUdpSocketOptions[] = {
         sizeof(SOCKET_TIME),
         TRUE
     },
+
+    {
+        SocketInformationUdp,
+        SocketUdpOptionSegmentSize,
+        sizeof(ULONG),
+        TRUE
+    },
 };
 
 //
@@ -954,6 +972,7 @@ Return Value:
 {
 
     UINTN BytesComplete;
+    UINTN DatagramSize;
     PNETWORK_ADDRESS Destination;
     NETWORK_ADDRESS DestinationLocal;
     ULONG Flags;
@@ -964,8 +983,10 @@ Return Value:
     PNET_SOCKET_LINK_OVERRIDE LinkOverride;
     NET_SOCKET_LINK_OVERRIDE LinkOverrideBuffer;
     NETWORK_ADDRESS LocalAddress;
+    UINTN Offset;
     PNET_PACKET_BUFFER Packet;
     NET_PACKET_LIST PacketList;
+    UINTN SegmentSize;
     UINTN Size;
     PNETWORK_ADDRESS Source;
     KSTATUS Status;
@@ -1044,11 +1065,28 @@ Return Value:
     }
 
     //
-    // If the size, including the header, is greater than the UDP socket's
+    // If segmentation is enabled, the send is split into datagrams of the
+    // segment size, with only the last one possibly being shorter. Otherwise
+    // the whole send is one datagram.
+    //
+
+    SegmentSize = UdpSocket->SegmentSize;
+    if ((SegmentSize == 0) || (SegmentSize >= Size)) {
+        SegmentSize = Size;
+
+    } else if (((Size + SegmentSize - 1) / SegmentSize) >
+               UDP_MAX_SEGMENT_COUNT) {
+
+        Status = STATUS_MESSAGE_TOO_LONG;
+        goto UdpSendEnd;
+    }
+
+    //
+    // If a datagram, including the header, is greater than the UDP socket's
     // maximum packet size, fail.
     //
 
-    if ((Size + sizeof(UDP_HEADER)) > UdpSocket->MaxPacketSize) {
+    if ((SegmentSize + sizeof(UDP_HEADER)) > UdpSocket->MaxPacketSize) {
         Status = STATUS_MESSAGE_TOO_LONG;
         goto UdpSendEnd;
     }
@@ -1124,66 +1162,80 @@ Return Value:
     }
 
     //
-    // Allocate a buffer for the packet.
+    // Build a packet for each datagram. They all go down to the network layer
+    // together so that the cost of getting there is only paid once.
     //
 
-    Status = NetAllocateBuffer(HeaderSize,
-                               Size,
-                               FooterSize,
-                               Link,
-                               0,
-                               &Packet);
+    Offset = 0;
+    do {
+        DatagramSize = Size - Offset;
+        if (DatagramSize > SegmentSize) {
+            DatagramSize = SegmentSize;
+        }
 
-    if (!KSUCCESS(Status)) {
-        goto UdpSendEnd;
-    }
+        Status = NetAllocateBuffer(HeaderSize,
+                                   DatagramSize,
+                                   FooterSize,
+                                   Link,
+                                   0,
+                                   &Packet);
 
-    NET_ADD_PACKET_TO_LIST(Packet, &PacketList);
+        if (!KSUCCESS(Status)) {
+            goto UdpSendEnd;
+        }
 
-    //
-    // Copy the packet data.
-    //
+        NET_ADD_PACKET_TO_LIST(Packet, &PacketList);
 
-    Status = MmCopyIoBufferData(IoBuffer,
-                                Packet->Buffer + Packet->DataOffset,
-                                BytesComplete,
-                                Size - BytesComplete,
-                                FALSE);
+        //
+        // Copy the packet data.
+        //
 
-    if (!KSUCCESS(Status)) {
-        goto UdpSendEnd;
-    }
+        Status = MmCopyIoBufferData(IoBuffer,
+                                    Packet->Buffer + Packet->DataOffset,
+                                    Offset,
+                                    DatagramSize,
+                                    FALSE);
 
-    //
-    // Add the UDP header.
-    //
+        if (!KSUCCESS(Status)) {
+            goto UdpSendEnd;
+        }
 
-    ASSERT(Packet->DataOffset >= sizeof(UDP_HEADER));
+        //
+        // Add the UDP header.
+        //
 
-    Packet->DataOffset -= sizeof(UDP_HEADER);
-    UdpHeader = (PUDP_HEADER)(Packet->Buffer + Packet->DataOffset);
-    UdpHeader->SourcePort = CPU_TO_NETWORK16(Source->Port);
-    UdpHeader->DestinationPort = CPU_TO_NETWORK16(Destination->Port);
-    UdpHeader->Length = CPU_TO_NETWORK16(Size + sizeof(UDP_HEADER));
-    UdpHeader->Checksum = 0;
-    if ((Link->Properties.Capabilities &
-        NET_LINK_CAPABILITY_TRANSMIT_UDP_CHECKSUM_OFFLOAD) != 0) {
+        ASSERT(Packet->DataOffset >= sizeof(UDP_HEADER));
+
+        Packet->DataOffset -= sizeof(UDP_HEADER);
+        UdpHeader = (PUDP_HEADER)(Packet->Buffer + Packet->DataOffset);
+        UdpHeader->SourcePort = CPU_TO_NETWORK16(Source->Port);
+        UdpHeader->DestinationPort = CPU_TO_NETWORK16(Destination->Port);
+        UdpHeader->Length = CPU_TO_NETWORK16(DatagramSize + sizeof(UDP_HEADER));
+        UdpHeader->Checksum = 0;
+        if ((Link->Properties.Capabilities &
+            NET_LINK_CAPABILITY_TRANSMIT_UDP_CHECKSUM_OFFLOAD) != 0) {
+
+            Packet->Flags |= NET_PACKET_FLAG_UDP_CHECKSUM_OFFLOAD;
+
+        } else if (Socket->KernelSocket.Domain == NetDomainIp6) {
+            UdpHeader->Checksum = NetpUdpChecksumData(
+                                            Socket->Network,
+                                            UdpHeader,
+                                            DatagramSize + sizeof(UDP_HEADER),
+                                            Source,
+                                            Destination);
+        }
 
-        Packet->Flags |= NET_PACKET_FLAG_UDP_CHECKSUM_OFFLOAD;
+        Offset += DatagramSize;
 
-    } else if (Socket->KernelSocket.Domain == NetDomainIp6) {
-        UdpHeader->Checksum = NetpUdpChecksumData(Socket->Network,
-                                                  UdpHeader,
-                                                  Size + sizeof(UDP_HEADER),
-                                                  Source,
-                                                  Destination);
-    }
+    } while (Offset < Size);
 
     //
-    // Send the datagram down to the network layer, which may have to send it
-    // in fragments.
+    // Send the datagrams down to the network layer, which may have to send
+    // them in fragments.
     //
 
+    NetAddStatistic(NetStatisticUdpOutDatagrams, PacketList.Count);
     Status = Socket->Network->Interface.Send(Socket,
                                              Destination,
                                              LinkOverride,
@@ -1260,6 +1312,7 @@ Return Value:
                       Length,
                       (Packet->FooterOffset - Packet->DataOffset));
 
+        NetAddStatistic(NetStatisticUdpInErrors, 1);
         return;
     }
 
@@ -1274,6 +1327,8 @@ Return Value:
     if (ReceiveContext->Network->Domain == NetDomainIp6) {
         if (Header->Checksum == 0) {
             RtlDebugPrint("UDP: Ignoring packet with IPv6 checksum of 0.\n");
+            NetAddStatistic(NetStatisticUdpInErrors, 1);
+            NetAddStatistic(NetStatisticUdpInChecksumErrors, 1);
             return;
         }
 
@@ -1290,6 +1345,8 @@ Return Value:
                           ReceiveContext->Source->Port,
                           ReceiveContext->Destination->Port);
 
+            NetAddStatistic(NetStatisticUdpInErrors, 1);
+            NetAddStatistic(NetStatisticUdpInChecksumErrors, 1);
             return;
         }
     }
@@ -1328,6 +1385,9 @@ Return Value:
 
     if (PreviousSocket != NULL) {
         IoSocketReleaseReference(&(PreviousSocket->KernelSocket));
+
+    } else {
+        NetAddStatistic(NetStatisticUdpNoPorts, 1);
     }
 
     return;
@@ -1407,6 +1467,7 @@ Return Value:
                                     UDP_PROTOCOL_ALLOCATION_TAG);
 
     if (UdpPacket == NULL) {
+        NetAddStatistic(NetStatisticUdpInErrors, 1);
         Status = STATUS_INSUFFICIENT_RESOURCES;
         goto ProcessReceivedSocketDataEnd;
     }
@@ -1444,9 +1505,11 @@ Return Value:
 
         IoSetIoObjectState(Socket->KernelSocket.IoState, POLL_EVENT_IN, TRUE);
         UdpPacket = NULL;
+        NetAddStatistic(NetStatisticUdpInDatagrams, 1);
 
     } else {
         UdpSocket->DroppedPacketCount += 1;
+        NetAddStatistic(NetStatisticUdpReceiveBufferErrors, 1);
     }
 
     KeReleaseQueuedLock(UdpSocket->ReceiveLock);
@@ -1870,146 +1933,176 @@ Return Value:
     }
 
     //
-    // There are currently no UDP options.
-    //
-
-    ASSERT(InformationType != SocketInformationUdp);
-
-    //
-    // Parse the basic socket option, getting the information from the UDP
-    // socket or setting the new state in the UDP socket.
+    // Parse the socket option, getting the information from the UDP socket or
+    // setting the new state in the UDP socket.
     //
 
     Source = NULL;
     Status = STATUS_SUCCESS;
-    switch ((SOCKET_BASIC_OPTION)Option) {
-    case SocketBasicOptionSendBufferSize:
-        if (Set != FALSE) {
-            SizeOption = *((PULONG)Data);
+    if (InformationType == SocketInformationBasic) {
+        switch ((SOCKET_BASIC_OPTION)Option) {
+        case SocketBasicOptionSendBufferSize:
+            if (Set != FALSE) {
+                SizeOption = *((PULONG)Data);
+
+                ASSERT(UDP_MAX_PACKET_SIZE <= SOCKET_OPTION_MAX_ULONG);
+
+                SizeInformation = &(Socket->PacketSizeInformation);
+                if (SizeOption > UDP_MAX_PACKET_SIZE) {
+                    SizeOption = UDP_MAX_PACKET_SIZE;
 
-            ASSERT(UDP_MAX_PACKET_SIZE <= SOCKET_OPTION_MAX_ULONG);
+                } else if (SizeOption < SizeInformation->MaxPacketSize) {
+                    SizeOption = SizeInformation->MaxPacketSize;
+                }
 
-            SizeInformation = &(Socket->PacketSizeInformation);
-            if (SizeOption > UDP_MAX_PACKET_SIZE) {
-                SizeOption = UDP_MAX_PACKET_SIZE;
+                UdpSocket->MaxPacketSize = SizeOption;
 
-            } else if (SizeOption < SizeInformation->MaxPacketSize) {
-                SizeOption = SizeInformation->MaxPacketSize;
+            } else {
+                SizeOption = UdpSocket->MaxPacketSize;
+                Source = &SizeOption;
             }
 
-            UdpSocket->MaxPacketSize = SizeOption;
+            break;
+
+        case SocketBasicOptionSendMinimum:
 
-        } else {
-            SizeOption = UdpSocket->MaxPacketSize;
+            ASSERT(Set == FALSE);
+
+            SizeOption = UDP_SEND_MINIMUM;
             Source = &SizeOption;
-        }
+            break;
 
-        break;
+        case SocketBasicOptionReceiveBufferSize:
+            if (Set != FALSE) {
+                SizeOption = *((PULONG)Data);
+                if (SizeOption > SOCKET_OPTION_MAX_ULONG) {
+                    SizeOption = SOCKET_OPTION_MAX_ULONG;
+                }
 
-    case SocketBasicOptionSendMinimum:
+                if (SizeOption < UDP_MIN_RECEIVE_BUFFER_SIZE) {
+                    SizeOption = UDP_MIN_RECEIVE_BUFFER_SIZE;
+                }
 
-        ASSERT(Set == FALSE);
+                //
+                // Set the receive buffer size and truncate the available
+                // free space if necessary. Do not remove any packets that
+                // have already been received. This is not meant to be a
+                // truncate call.
+                //
+
+                KeAcquireQueuedLock(UdpSocket->ReceiveLock);
+                UdpSocket->ReceiveBufferTotalSize = SizeOption;
+                if (UdpSocket->ReceiveBufferFreeSize > SizeOption) {
+                    UdpSocket->ReceiveBufferFreeSize = SizeOption;
+                }
 
-        SizeOption = UDP_SEND_MINIMUM;
-        Source = &SizeOption;
-        break;
+                KeReleaseQueuedLock(UdpSocket->ReceiveLock);
 
-    case SocketBasicOptionReceiveBufferSize:
-        if (Set != FALSE) {
-            SizeOption = *((PULONG)Data);
-            if (SizeOption > SOCKET_OPTION_MAX_ULONG) {
-                SizeOption = SOCKET_OPTION_MAX_ULONG;
+            } else {
+                SizeOption = UdpSocket->ReceiveBufferTotalSize;
+                Source = &SizeOption;
             }
 
-            if (SizeOption < UDP_MIN_RECEIVE_BUFFER_SIZE) {
-                SizeOption = UDP_MIN_RECEIVE_BUFFER_SIZE;
-            }
+            break;
 
-            //
-            // Set the receive buffer size and truncate the available free
-            // space if necessary. Do not remove any packets that have already
-            // been received. This is not meant to be a truncate call.
-            //
+        case SocketBasicOptionReceiveMinimum:
+            if (Set != FALSE) {
+                SizeOption = *((PULONG)Data);
+                if (SizeOption > SOCKET_OPTION_MAX_ULONG) {
+                    SizeOption = SOCKET_OPTION_MAX_ULONG;
+                }
 
-            KeAcquireQueuedLock(UdpSocket->ReceiveLock);
-            UdpSocket->ReceiveBufferTotalSize = SizeOption;
-            if (UdpSocket->ReceiveBufferFreeSize > SizeOption) {
-                UdpSocket->ReceiveBufferFreeSize = SizeOption;
+                UdpSocket->ReceiveMinimum = SizeOption;
+
+            } else {
+                Source = &SizeOption;
+                SizeOption = UdpSocket->ReceiveMinimum;
             }
 
-            KeReleaseQueuedLock(UdpSocket->ReceiveLock);
+            break;
 
-        } else {
-            SizeOption = UdpSocket->ReceiveBufferTotalSize;
-            Source = &SizeOption;
-        }
+        case SocketBasicOptionReceiveTimeout:
+            if (Set != FALSE) {
+                SocketTime = (PSOCKET_TIME)Data;
+                if (SocketTime->Seconds < 0) {
+                    Status = STATUS_DOMAIN_ERROR;
+                    break;
+                }
 
-        break;
+                Milliseconds = SocketTime->Seconds * MILLISECONDS_PER_SECOND;
+                if (Milliseconds < SocketTime->Seconds) {
+                    Status = STATUS_DOMAIN_ERROR;
+                    break;
+                }
+
+                Milliseconds += SocketTime->Microseconds /
+                                MICROSECONDS_PER_MILLISECOND;
 
-    case SocketBasicOptionReceiveMinimum:
-        if (Set != FALSE) {
-            SizeOption = *((PULONG)Data);
-            if (SizeOption > SOCKET_OPTION_MAX_ULONG) {
-                SizeOption = SOCKET_OPTION_MAX_ULONG;
+                if ((Milliseconds < 0) || (Milliseconds > MAX_LONG)) {
+                    Status = STATUS_DOMAIN_ERROR;
+                    break;
+                }
+
+                UdpSocket->ReceiveTimeout = (ULONG)(LONG)Milliseconds;
+
+            } else {
+                Source = &SocketTimeBuffer;
+                if (UdpSocket->ReceiveTimeout == WAIT_TIME_INDEFINITE) {
+                    SocketTimeBuffer.Seconds = 0;
+                    SocketTimeBuffer.Microseconds = 0;
+
+                } else {
+                    SocketTimeBuffer.Seconds = UdpSocket->ReceiveTimeout /
+                                               MILLISECONDS_PER_SECOND;
+
+                    SocketTimeBuffer.Microseconds =
+                                        (UdpSocket->ReceiveTimeout %
+                                         MILLISECONDS_PER_SECOND) *
+                                        MICROSECONDS_PER_MILLISECOND;
+                }
             }
 
-            UdpSocket->ReceiveMinimum = SizeOption;
+            break;
 
-        } else {
-            Source = &SizeOption;
-            SizeOption = UdpSocket->ReceiveMinimum;
-        }
+        default:
 
-        break;
+            ASSERT(FALSE);
 
-    case SocketBasicOptionReceiveTimeout:
-        if (Set != FALSE) {
-            SocketTime = (PSOCKET_TIME)Data;
-            if (SocketTime->Seconds < 0) {
-                Status = STATUS_DOMAIN_ERROR;
-                break;
-            }
+            Status = STATUS_NOT_HANDLED;
+            break;
+        }
 
-            Milliseconds = SocketTime->Seconds * MILLISECONDS_PER_SECOND;
-            if (Milliseconds < SocketTime->Seconds) {
-                Status = STATUS_DOMAIN_ERROR;
-                break;
-            }
+    } else {
 
-            Milliseconds += SocketTime->Microseconds /
-                            MICROSECONDS_PER_MILLISECOND;
+        ASSERT(InformationType == SocketInformationUdp);
 
-            if ((Milliseconds < 0) || (Milliseconds > MAX_LONG)) {
-                Status = STATUS_DOMAIN_ERROR;
-                break;
-            }
+        switch ((SOCKET_UDP_OPTION)Option) {
+        case SocketUdpOptionSegmentSize:
+            if (Set != FALSE) {
+                SizeOption = *((PULONG)Data);
+                if ((SizeOption + sizeof(UDP_HEADER)) >
+                    UdpSocket->MaxPacketSize) {
 
-            UdpSocket->ReceiveTimeout = (ULONG)(LONG)Milliseconds;
+                    Status = STATUS_INVALID_PARAMETER;
+                    break;
+                }
 
-        } else {
-            Source = &SocketTimeBuffer;
-            if (UdpSocket->ReceiveTimeout == WAIT_TIME_INDEFINITE) {
-                SocketTimeBuffer.Seconds = 0;
-                SocketTimeBuffer.Microseconds = 0;
+                UdpSocket->SegmentSize = SizeOption;
 
             } else {
-                SocketTimeBuffer.Seconds = UdpSocket->ReceiveTimeout /
-                                           MILLISECONDS_PER_SECOND;
-
-                SocketTimeBuffer.Microseconds = (UdpSocket->ReceiveTimeout %
-                                                 MILLISECONDS_PER_SECOND) *
-                                                MICROSECONDS_PER_MILLISECOND;
+                SizeOption = UdpSocket->SegmentSize;
+                Source = &SizeOption;
             }
-        }
 
-        break;
+            break;
 
-    default:
+        default:
 
-        ASSERT(FALSE);
+            ASSERT(FALSE);
 
-        Status = STATUS_NOT_HANDLED;
-        break;
+            Status = STATUS_NOT_SUPPORTED_BY_PROTOCOL;
+            break;
+        }
     }
 
     if (!KSUCCESS(Status)) {
@@ -122,6 +122,19 @@ RamDiskDispatchSystemControl (
     PVOID IrpContext
     );
 
+KSTATUS
+RamDiskDispatchFastIo (
+    PVOID DeviceContext,
+    BOOL Write,
+    PIRP_READ_WRITE Request
+    );
+
+KSTATUS
+RamDiskPerformIo (
+    PIRP_READ_WRITE Request,
+    BOOL Write
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -186,6 +199,7 @@ Return Value:
     FunctionTable.DispatchClose = RamDiskDispatchClose;
     FunctionTable.DispatchIo = RamDiskDispatchIo;
     FunctionTable.DispatchSystemControl = RamDiskDispatchSystemControl;
+    FunctionTable.DispatchFastIo = RamDiskDispatchFastIo;
     Status = IoRegisterDriverFunctions(Driver, &FunctionTable);
     if (!KSUCCESS(Status)) {
         goto DriverEntryEnd;
@@ -515,86 +529,17 @@ Return Value:
 
 {
 
-    UINTN BytesToComplete;
-    KSTATUS CompletionStatus;
-    PRAM_DISK_DEVICE Disk;
-    IO_OFFSET IoOffset;
-    ULONG IrpReadWriteFlags;
-    BOOL ReadWriteIrpPrepared;
     KSTATUS Status;
-    BOOL ToIoBuffer;
+    BOOL Write;
 
     ASSERT(Irp->Direction == IrpDown);
 
-    Disk = Irp->U.ReadWrite.DeviceContext;
-    ReadWriteIrpPrepared = FALSE;
-
-    ASSERT(IS_ALIGNED(Irp->U.ReadWrite.IoOffset, RAM_DISK_SECTOR_SIZE));
-    ASSERT(IS_ALIGNED(Irp->U.ReadWrite.IoSizeInBytes, RAM_DISK_SECTOR_SIZE));
-    ASSERT(Irp->U.ReadWrite.IoBuffer != NULL);
-
-    Irp->U.ReadWrite.IoBytesCompleted = 0;
-    IoOffset = Irp->U.ReadWrite.IoOffset;
-    if (IoOffset >= Disk->Size) {
-        Status = STATUS_OUT_OF_BOUNDS;
-        goto DispatchIoEnd;
-    }
-
-    BytesToComplete = Irp->U.ReadWrite.IoSizeInBytes;
-    if ((IoOffset + BytesToComplete) > Disk->Size) {
-        BytesToComplete = Disk->Size - Irp->U.ReadWrite.IoOffset;
-    }
-
-    ToIoBuffer = TRUE;
-    IrpReadWriteFlags = IRP_READ_WRITE_FLAG_POLLED;
+    Write = FALSE;
     if (Irp->MinorCode == IrpMinorIoWrite) {
-        ToIoBuffer = FALSE;
-        IrpReadWriteFlags |= IRP_READ_WRITE_FLAG_WRITE;
+        Write = TRUE;
     }
 
-    //
-    // Prepare the I/O buffer for polled I/O.
-    //
-
-    Status = IoPrepareReadWriteIrp(&(Irp->U.ReadWrite),
-                                   1,
-                                   0,
-                                   MAX_ULONGLONG,
-                                   IrpReadWriteFlags);
-
-    if (!KSUCCESS(Status)) {
-        goto DispatchIoEnd;
-    }
-
-    ReadWriteIrpPrepared = TRUE;
-
-    //
-    // Transfer the data between the disk and I/O buffer.
-    //
-
-    Status = MmCopyIoBufferData(Irp->U.ReadWrite.IoBuffer,
-                                (PUCHAR)Disk->Buffer + IoOffset,
-                                0,
-                                BytesToComplete,
-                                ToIoBuffer);
-
-    if (!KSUCCESS(Status)) {
-        goto DispatchIoEnd;
-    }
-
-    Irp->U.ReadWrite.IoBytesCompleted = BytesToComplete;
-
-DispatchIoEnd:
-    if (ReadWriteIrpPrepared != FALSE) {
-        CompletionStatus = IoCompleteReadWriteIrp(&(Irp->U.ReadWrite),
-                                                  IrpReadWriteFlags);
-
-        if (!KSUCCESS(CompletionStatus) && KSUCCESS(Status)) {
-            Status = CompletionStatus;
-        }
-    }
-
-    Irp->U.ReadWrite.NewIoOffset = IoOffset + Irp->U.ReadWrite.IoBytesCompleted;
+    Status = RamDiskPerformIo(&(Irp->U.ReadWrite), Write);
     IoCompleteIrp(RamDiskDriver, Irp, Status);
     return;
 }
@@ -728,3 +673,145 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
+KSTATUS
+RamDiskDispatchFastIo (
+    PVOID DeviceContext,
+    BOOL Write,
+    PIRP_READ_WRITE Request
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs a read or write without an IRP. The RAM disk never
+    blocks, so it can always complete the request inline.
+
+Arguments:
+
+    DeviceContext - Supplies the context pointer supplied by the driver when it
+        attached itself to the driver stack.
+
+    Write - Supplies a boolean indicating whether this is a write (TRUE) or a
+        read (FALSE).
+
+    Request - Supplies a pointer to the read/write parameters.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    return RamDiskPerformIo(Request, Write);
+}
+
+KSTATUS
+RamDiskPerformIo (
+    PIRP_READ_WRITE Request,
+    BOOL Write
+    )
+
+/*++
+
+Routine Description:
+
+    This routine copies data between the RAM disk and an I/O buffer.
+
+Arguments:
+
+    Request - Supplies a pointer to the read/write parameters. The bytes
+        completed and new I/O offset are filled in on return.
+
+    Write - Supplies a boolean indicating whether this is a write (TRUE) or a
+        read (FALSE).
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN BytesToComplete;
+    KSTATUS CompletionStatus;
+    PRAM_DISK_DEVICE Disk;
+    IO_OFFSET IoOffset;
+    ULONG IrpReadWriteFlags;
+    BOOL ReadWriteIrpPrepared;
+    KSTATUS Status;
+    BOOL ToIoBuffer;
+
+    Disk = Request->DeviceContext;
+    ReadWriteIrpPrepared = FALSE;
+
+    ASSERT(IS_ALIGNED(Request->IoOffset, RAM_DISK_SECTOR_SIZE));
+    ASSERT(IS_ALIGNED(Request->IoSizeInBytes, RAM_DISK_SECTOR_SIZE));
+    ASSERT(Request->IoBuffer != NULL);
+
+    Request->IoBytesCompleted = 0;
+    IoOffset = Request->IoOffset;
+    if (IoOffset >= Disk->Size) {
+        Status = STATUS_OUT_OF_BOUNDS;
+        goto PerformIoEnd;
+    }
+
+    BytesToComplete = Request->IoSizeInBytes;
+    if ((IoOffset + BytesToComplete) > Disk->Size) {
+        BytesToComplete = Disk->Size - Request->IoOffset;
+    }
+
+    ToIoBuffer = TRUE;
+    IrpReadWriteFlags = IRP_READ_WRITE_FLAG_POLLED;
+    if (Write != FALSE) {
+        ToIoBuffer = FALSE;
+        IrpReadWriteFlags |= IRP_READ_WRITE_FLAG_WRITE;
+    }
+
+    //
+    // Prepare the I/O buffer for polled I/O.
+    //
+
+    Status = IoPrepareReadWriteIrp(Request,
+                                   1,
+                                   0,
+                                   MAX_ULONGLONG,
+                                   IrpReadWriteFlags);
+
+    if (!KSUCCESS(Status)) {
+        goto PerformIoEnd;
+    }
+
+    ReadWriteIrpPrepared = TRUE;
+
+    //
+    // Transfer the data between the disk and I/O buffer.
+    //
+
+    Status = MmCopyIoBufferData(Request->IoBuffer,
+                                (PUCHAR)Disk->Buffer + IoOffset,
+                                0,
+                                BytesToComplete,
+                                ToIoBuffer);
+
+    if (!KSUCCESS(Status)) {
+        goto PerformIoEnd;
+    }
+
+    Request->IoBytesCompleted = BytesToComplete;
+
+PerformIoEnd:
+    if (ReadWriteIrpPrepared != FALSE) {
+        CompletionStatus = IoCompleteReadWriteIrp(Request, IrpReadWriteFlags);
+        if (!KSUCCESS(CompletionStatus) && KSUCCESS(Status)) {
+            Status = CompletionStatus;
+        }
+    }
+
+    Request->NewIoOffset = IoOffset + Request->IoBytesCompleted;
+    return Status;
+}
+
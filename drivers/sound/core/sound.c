@@ -159,6 +159,40 @@ SoundpSetHandleDefaults (
     PSOUND_DEVICE_HANDLE Handle
     );
 
+KSTATUS
+SoundpCreateMmapStatus (
+    PSOUND_DEVICE_HANDLE Handle
+    );
+
+VOID
+SoundpDestroyMmapStatus (
+    PSOUND_DEVICE_HANDLE Handle
+    );
+
+VOID
+SoundpResetMmapStatus (
+    PSOUND_IO_BUFFER Buffer
+    );
+
+VOID
+SoundpUpdateMmapStatus (
+    PSOUND_IO_BUFFER Buffer,
+    UINTN Offset,
+    UINTN BytesCompleted
+    );
+
+KSTATUS
+SoundpWaitForFragment (
+    PSOUND_DEVICE_HANDLE Handle,
+    PULONG FragmentCount
+    );
+
+KSTATUS
+SoundpGetHardwareOffset (
+    PSOUND_DEVICE_HANDLE Handle,
+    PUINTN Offset
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -835,6 +869,7 @@ Return Value:
         Handle->Buffer.IoBuffer = NULL;
     }
 
+    SoundpDestroyMmapStatus(Handle);
     NonPaged = FALSE;
     if ((Handle->Controller->Host.Flags &
          SOUND_CONTROLLER_FLAG_NON_PAGED_SOUND_BUFFER) != 0) {
@@ -923,10 +958,12 @@ Return Value:
     ULONG Events;
     PUINTN LinearOffset;
     BOOL LockHeld;
+    ULONG PageSize;
     ULONG ReturnedEvents;
     PIO_BUFFER SourceBuffer;
     UINTN SourceOffset;
     KSTATUS Status;
+    UINTN StatusOffset;
     ULONGLONG TimeCounterFrequency;
     ULONG WaitTime;
 
@@ -1036,6 +1073,45 @@ Return Value:
                 goto PerformIoEnd;
             }
 
+            //
+            // The status page sits at its own offset, well beyond the end of
+            // any DMA buffer. Create it the first time it is mapped.
+            //
+
+            if (*IoOffset >= SOUND_MMAP_STATUS_OFFSET) {
+                PageSize = MmPageSize();
+                StatusOffset = *IoOffset - SOUND_MMAP_STATUS_OFFSET;
+                if (StatusOffset >= PageSize) {
+                    Status = STATUS_END_OF_FILE;
+                    goto PerformIoEnd;
+                }
+
+                if (SizeInBytes > (PageSize - StatusOffset)) {
+                    SizeInBytes = PageSize - StatusOffset;
+                    BytesRemaining = SizeInBytes;
+                }
+
+                KeAcquireQueuedLock(Handle->Lock);
+                LockHeld = TRUE;
+                if (Handle->MmapStatusIoBuffer == NULL) {
+                    Status = SoundpCreateMmapStatus(Handle);
+                    if (!KSUCCESS(Status)) {
+                        goto PerformIoEnd;
+                    }
+                }
+
+                Status = MmAppendIoBuffer(IoBuffer,
+                                          Handle->MmapStatusIoBuffer,
+                                          StatusOffset,
+                                          SizeInBytes);
+
+                if (KSUCCESS(Status)) {
+                    BytesRemaining = 0;
+                }
+
+                goto PerformIoEnd;
+            }
+
             if (*IoOffset >= Handle->Buffer.Size) {
                 Status = STATUS_END_OF_FILE;
                 goto PerformIoEnd;
@@ -1269,6 +1345,7 @@ Return Value:
     UINTN FragmentsCompleted;
     ULONG FragmentShift;
     UINTN FragmentSize;
+    UINTN HardwareOffset;
     ULONG Index;
     ULONG IntegerUlong;
     BOOL LockHeld;
@@ -1462,6 +1539,20 @@ Return Value:
         Handle->Buffer.FragmentsCompleted = FragmentsCompleted;
         Position.Offset = (LONG)ControllerOffset;
 
+        //
+        // The controller offset only moves when a fragment completes. Report
+        // where the hardware actually is if the controller can say.
+        //
+
+        if (Handle->State == SoundDeviceStateRunning) {
+            Status = SoundpGetHardwareOffset(Handle, &HardwareOffset);
+            if (KSUCCESS(Status)) {
+                Position.Offset = (LONG)HardwareOffset;
+            }
+
+            Status = STATUS_SUCCESS;
+        }
+
         //
         // This IOCTL is used in conjunction with mmap. As user mode will not
         // make any official reads/writes, use this as an opportunity to move
@@ -1940,6 +2031,31 @@ Return Value:
         IntegerUlong = Handle->Route;
         break;
 
+    case SoundWaitForFragment:
+        CopySize = sizeof(ULONG);
+        if (RequestBufferSize < CopySize) {
+            Status = STATUS_DATA_LENGTH_MISMATCH;
+            break;
+        }
+
+        if (FromKernelMode != FALSE) {
+            IntegerUlong = *((PULONG)RequestBuffer);
+
+        } else {
+            Status = MmCopyFromUserMode(&IntegerUlong, RequestBuffer, CopySize);
+            if (!KSUCCESS(Status)) {
+                break;
+            }
+        }
+
+        Status = SoundpWaitForFragment(Handle, &IntegerUlong);
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        CopyOutBuffer = &IntegerUlong;
+        break;
+
     default:
         Status = STATUS_NOT_SUPPORTED;
         break;
@@ -2118,6 +2234,16 @@ Return Value:
 
     Buffer->BytesCompleted += BytesCompleted;
     SoundpUpdateBufferState(Buffer, Type, Offset, BytesCompleted, FALSE);
+
+    //
+    // Publish the new position to any user mode mapping and wake anyone
+    // waiting on the next fragment.
+    //
+
+    if (Buffer->MmapStatus != NULL) {
+        SoundpUpdateMmapStatus(Buffer, Offset, BytesCompleted);
+    }
+
     return;
 }
 
@@ -3302,6 +3428,365 @@ Return Value:
 
     Handle->Volume = SOUND_VOLUME_DEFAULT;
     Handle->Route = 0;
+    if (Handle->Buffer.MmapStatus != NULL) {
+        SoundpResetMmapStatus(&(Handle->Buffer));
+        KeSignalEvent(Handle->Buffer.FragmentEvent, SignalOptionSignalAll);
+    }
+
     return;
 }
 
+KSTATUS
+SoundpCreateMmapStatus (
+    PSOUND_DEVICE_HANDLE Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates the status page that reports the buffer position to
+    user mode mappings of the device. This routine assumes the handle's queued
+    lock is held.
+
+Arguments:
+
+    Handle - Supplies a pointer to the sound device handle.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PKEVENT Event;
+    ULONG Flags;
+    PIO_BUFFER IoBuffer;
+    PSOUND_MMAP_STATUS MmapStatus;
+    KSTATUS Status;
+
+    ASSERT(KeIsQueuedLockHeld(Handle->Lock) != FALSE);
+    ASSERT(Handle->MmapStatusIoBuffer == NULL);
+
+    Event = NULL;
+
+    //
+    // The page gets mapped with the same cache attributes as the DMA buffer,
+    // so allocate it to match.
+    //
+
+    Flags = IO_BUFFER_FLAG_PHYSICALLY_CONTIGUOUS;
+    if ((Handle->Controller->Host.Flags &
+         SOUND_CONTROLLER_FLAG_NON_CACHED_DMA_BUFFER) != 0) {
+
+        Flags |= IO_BUFFER_FLAG_MAP_NON_CACHED;
+    }
+
+    IoBuffer = MmAllocateNonPagedIoBuffer(0,
+                                          MAX_ULONGLONG,
+                                          0,
+                                          MmPageSize(),
+                                          Flags);
+
+    if (IoBuffer == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateMmapStatusEnd;
+    }
+
+    Event = KeCreateEvent(NULL);
+    if (Event == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto CreateMmapStatusEnd;
+    }
+
+    MmapStatus = IoBuffer->Fragment[0].VirtualAddress;
+    RtlZeroMemory(MmapStatus, MmPageSize());
+    Handle->Buffer.FragmentEvent = Event;
+    Handle->Buffer.MmapStatus = MmapStatus;
+    SoundpResetMmapStatus(&(Handle->Buffer));
+    Handle->MmapStatusIoBuffer = IoBuffer;
+    Status = STATUS_SUCCESS;
+
+CreateMmapStatusEnd:
+    if (!KSUCCESS(Status)) {
+        if (Event != NULL) {
+            KeDestroyEvent(Event);
+        }
+
+        if (IoBuffer != NULL) {
+            MmFreeIoBuffer(IoBuffer);
+        }
+    }
+
+    return Status;
+}
+
+VOID
+SoundpDestroyMmapStatus (
+    PSOUND_DEVICE_HANDLE Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys the status page of a sound device handle, if it has
+    one. The device must not be running.
+
+Arguments:
+
+    Handle - Supplies a pointer to the sound device handle.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (Handle->MmapStatusIoBuffer == NULL) {
+        return;
+    }
+
+    Handle->Buffer.MmapStatus = NULL;
+    KeDestroyEvent(Handle->Buffer.FragmentEvent);
+    Handle->Buffer.FragmentEvent = NULL;
+    MmFreeIoBuffer(Handle->MmapStatusIoBuffer);
+    Handle->MmapStatusIoBuffer = NULL;
+    return;
+}
+
+VOID
+SoundpResetMmapStatus (
+    PSOUND_IO_BUFFER Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine rewrites the entire status page from the current state of
+    the sound buffer.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the sound buffer whose status page should
+        be reset.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PSOUND_MMAP_STATUS MmapStatus;
+
+    MmapStatus = Buffer->MmapStatus;
+    MmapStatus->Sequence += 1;
+    RtlMemoryBarrier();
+    MmapStatus->Offset = Buffer->ControllerOffset;
+    MmapStatus->BufferSize = Buffer->Size;
+    MmapStatus->FragmentSize = Buffer->FragmentSize;
+    MmapStatus->TotalBytes = Buffer->BytesCompleted;
+    MmapStatus->FragmentCount = Buffer->BytesCompleted >> Buffer->FragmentShift;
+    MmapStatus->TimeCounter = HlQueryTimeCounter();
+    MmapStatus->TimeCounterFrequency = HlQueryTimeCounterFrequency();
+    RtlMemoryBarrier();
+    MmapStatus->Sequence += 1;
+    return;
+}
+
+VOID
+SoundpUpdateMmapStatus (
+    PSOUND_IO_BUFFER Buffer,
+    UINTN Offset,
+    UINTN BytesCompleted
+    )
+
+/*++
+
+Routine Description:
+
+    This routine publishes a new buffer position to the status page and
+    wakes anyone waiting for a fragment to complete. This routine can be
+    called at dispatch level.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the sound buffer that moved.
+
+    Offset - Supplies the controller's new offset into the buffer.
+
+    BytesCompleted - Supplies the number of bytes the controller moved since
+        the last update.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PSOUND_MMAP_STATUS MmapStatus;
+
+    //
+    // An odd sequence number tells readers an update is in progress, so they
+    // retry rather than use a torn set of values.
+    //
+
+    MmapStatus = Buffer->MmapStatus;
+    MmapStatus->Sequence += 1;
+    RtlMemoryBarrier();
+    MmapStatus->Offset = Offset;
+    MmapStatus->TotalBytes += BytesCompleted;
+    MmapStatus->FragmentCount = MmapStatus->TotalBytes >> Buffer->FragmentShift;
+    MmapStatus->TimeCounter = HlQueryTimeCounter();
+    RtlMemoryBarrier();
+    MmapStatus->Sequence += 1;
+    KeSignalEvent(Buffer->FragmentEvent, SignalOptionSignalAll);
+    return;
+}
+
+KSTATUS
+SoundpWaitForFragment (
+    PSOUND_DEVICE_HANDLE Handle,
+    PULONG FragmentCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine waits until the number of completed fragments reported in
+    the status page differs from the given count.
+
+Arguments:
+
+    Handle - Supplies a pointer to the sound device handle.
+
+    FragmentCount - Supplies a pointer that on input contains the low 32 bits
+        of the last fragment count the caller saw. On output, returns the low
+        32 bits of the current fragment count.
+
+Return Value:
+
+    STATUS_SUCCESS once the fragment count has moved.
+
+    STATUS_NOT_READY if the status page has not been mapped or the device is
+    not running.
+
+    STATUS_OPERATION_WOULD_BLOCK if the handle is non-blocking and no new
+    fragment has completed.
+
+    STATUS_INTERRUPTED if the wait was interrupted.
+
+--*/
+
+{
+
+    ULONG Current;
+    PKEVENT Event;
+    KSTATUS Status;
+    ULONG Timeout;
+
+    if (Handle->Buffer.MmapStatus == NULL) {
+        return STATUS_NOT_READY;
+    }
+
+    Event = Handle->Buffer.FragmentEvent;
+    Timeout = WAIT_TIME_INDEFINITE;
+    if ((Handle->Flags & SOUND_DEVICE_HANDLE_FLAG_NON_BLOCKING) != 0) {
+        Timeout = 0;
+    }
+
+    //
+    // Unsignal the event before checking the count so that a fragment
+    // completing between the check and the wait is not missed.
+    //
+
+    while (TRUE) {
+        KeSignalEvent(Event, SignalOptionUnsignal);
+        Current = (ULONG)(Handle->Buffer.MmapStatus->FragmentCount);
+        if (Current != *FragmentCount) {
+            *FragmentCount = Current;
+            return STATUS_SUCCESS;
+        }
+
+        if (Handle->State != SoundDeviceStateRunning) {
+            return STATUS_NOT_READY;
+        }
+
+        Status = KeWaitForEvent(Event, TRUE, Timeout);
+        if (Status == STATUS_TIMEOUT) {
+            return STATUS_OPERATION_WOULD_BLOCK;
+        }
+
+        if (!KSUCCESS(Status)) {
+            return Status;
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+SoundpGetHardwareOffset (
+    PSOUND_DEVICE_HANDLE Handle,
+    PUINTN Offset
+    )
+
+/*++
+
+Routine Description:
+
+    This routine asks the controller where the hardware currently is in the
+    buffer, which may be between fragment boundaries.
+
+Arguments:
+
+    Handle - Supplies a pointer to the sound device handle.
+
+    Offset - Supplies a pointer that receives the hardware's offset into the
+        buffer, in bytes.
+
+Return Value:
+
+    Status code. STATUS_NOT_SUPPORTED if the controller can't report a
+    position more precise than the last completed fragment.
+
+--*/
+
+{
+
+    PSOUND_CONTROLLER Controller;
+    PSOUND_GET_SET_INFORMATION GetSetInformation;
+    UINTN Size;
+    KSTATUS Status;
+
+    Controller = Handle->Controller;
+    Size = sizeof(UINTN);
+    GetSetInformation = Controller->Host.FunctionTable->GetSetInformation;
+    Status = GetSetInformation(Controller->Host.Context,
+                               Handle->Device->Context,
+                               SoundDeviceInformationPosition,
+                               Offset,
+                               &Size,
+                               FALSE);
+
+    if (!KSUCCESS(Status)) {
+        return Status;
+    }
+
+    if ((Size != sizeof(UINTN)) || (*Offset >= Handle->Buffer.Size)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    return STATUS_SUCCESS;
+}
+
@@ -183,6 +183,9 @@ Structure Description:
         default is route 0. The route information is stored in the sound
         device structure.
 
+    MmapStatusIoBuffer - Stores a pointer to the I/O buffer holding the status
+        page, which is created the first time the page is mapped.
+
 --*/
 
 struct _SOUND_DEVICE_HANDLE {
@@ -197,6 +200,7 @@ struct _SOUND_DEVICE_HANDLE {
     ULONG SampleRate;
     ULONG Volume;
     ULONG Route;
+    PIO_BUFFER MmapStatusIoBuffer;
 };
 
 //
@@ -359,6 +359,7 @@ Return Value:
 
     PHDA_CONTROLLER Controller;
     PHDA_DEVICE HdaDevice;
+    ULONG Offset;
     KSTATUS Status;
     ULONG Volume;
 
@@ -397,6 +398,42 @@ Return Value:
         Status = STATUS_SUCCESS;
         break;
 
+    //
+    // The link position in buffer register tracks the DMA engine byte by
+    // byte, unlike the buffer's controller offset which only moves when a
+    // fragment completes.
+    //
+
+    case SoundDeviceInformationPosition:
+        if (Set != FALSE) {
+            Status = STATUS_NOT_SUPPORTED;
+            goto SoundGetSetInformationEnd;
+        }
+
+        if (*DataSize < sizeof(UINTN)) {
+            *DataSize = sizeof(UINTN);
+            Status = STATUS_DATA_LENGTH_MISMATCH;
+            goto SoundGetSetInformationEnd;
+        }
+
+        if ((HdaDevice->State != SoundDeviceStateRunning) ||
+            (HdaDevice->StreamIndex == HDA_INVALID_STREAM)) {
+
+            Status = STATUS_NOT_READY;
+            goto SoundGetSetInformationEnd;
+        }
+
+        Offset = HDA_STREAM_READ32(Controller,
+                                   HdaDevice->StreamIndex,
+                                   HdaStreamRegisterLinkPositionInBuffer);
+
+        ASSERT(POWER_OF_2(HdaDevice->Buffer->Size) != FALSE);
+
+        *(PUINTN)Data = REMAINDER(Offset, HdaDevice->Buffer->Size);
+        *DataSize = sizeof(UINTN);
+        Status = STATUS_SUCCESS;
+        break;
+
     default:
         Status = STATUS_NOT_SUPPORTED;
         break;
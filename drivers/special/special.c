@@ -170,9 +170,23 @@ SpecialDispatchUserControl (
     PVOID IrpContext
     );
 
+KSTATUS
+SpecialDispatchFastIo (
+    PVOID DeviceContext,
+    BOOL Write,
+    PIRP_READ_WRITE Request
+    );
+
+KSTATUS
+SpecialPerformIo (
+    PSPECIAL_DEVICE Device,
+    PIRP_READ_WRITE Request,
+    BOOL Write
+    );
+
 KSTATUS
 SpecialFillZeroes (
-    PIRP Irp
+    PIRP_READ_WRITE Request
     );
 
 KSTATUS
@@ -190,7 +204,8 @@ SpecialPseudoRandomRemoveDevice (
 KSTATUS
 SpecialPerformPseudoRandomIo (
     PSPECIAL_DEVICE Device,
-    PIRP Irp
+    PIRP_READ_WRITE Request,
+    BOOL Write
     );
 
 VOID
@@ -286,6 +301,7 @@ Return Value:
     FunctionTable.DispatchIo = SpecialDispatchIo;
     FunctionTable.DispatchSystemControl = SpecialDispatchSystemControl;
     FunctionTable.DispatchUserControl = SpecialDispatchUserControl;
+    FunctionTable.DispatchFastIo = SpecialDispatchFastIo;
     Status = IoRegisterDriverFunctions(Driver, &FunctionTable);
     return Status;
 }
@@ -682,87 +698,18 @@ Return Value:
 
 {
 
-    PSPECIAL_DEVICE Device;
     KSTATUS Status;
+    BOOL Write;
 
     ASSERT(Irp->MajorCode == IrpMajorIo);
     ASSERT(Irp->Direction == IrpDown);
 
-    Device = (PSPECIAL_DEVICE)DeviceContext;
-    switch (Device->Type) {
-
-    //
-    // The null device accepts and discards all input, and produces no output.
-    //
-
-    case SpecialDeviceNull:
-        if (Irp->MinorCode == IrpMinorIoRead) {
-            Irp->U.ReadWrite.IoBytesCompleted = 0;
-
-        } else {
-
-            ASSERT(Irp->MinorCode == IrpMinorIoWrite);
-
-            Irp->U.ReadWrite.IoBytesCompleted = Irp->U.ReadWrite.IoSizeInBytes;
-        }
-
-        Status = STATUS_SUCCESS;
-        break;
-
-    //
-    // The zero device accepts and discards all input, and produces a
-    // continuous stream of zero bytes.
-    //
-
-    case SpecialDeviceZero:
-        if (Irp->MinorCode == IrpMinorIoRead) {
-            Status = SpecialFillZeroes(Irp);
-
-        } else {
-
-            ASSERT(Irp->MinorCode == IrpMinorIoWrite);
-
-            Irp->U.ReadWrite.IoBytesCompleted = Irp->U.ReadWrite.IoSizeInBytes;
-            Status = STATUS_SUCCESS;
-        }
-
-        break;
-
-    //
-    // The full device produces a continuous stream of zero bytes when read,
-    // and returns "disk full" when written to.
-    //
-
-    case SpecialDeviceFull:
-        if (Irp->MinorCode == IrpMinorIoRead) {
-            Status = SpecialFillZeroes(Irp);
-
-        } else {
-
-            ASSERT(Irp->MinorCode == IrpMinorIoWrite);
-
-            Status = STATUS_VOLUME_FULL;
-        }
-
-        break;
-
-    //
-    // The urandom device produces psuedo-random numbers when read, and adds
-    // entropy when written to.
-    //
-
-    case SpecialDevicePseudoRandom:
-        Status = SpecialPerformPseudoRandomIo(Device, Irp);
-        break;
-
-    default:
-
-        ASSERT(FALSE);
-
-        Status = STATUS_FILE_CORRUPT;
-        break;
+    Write = FALSE;
+    if (Irp->MinorCode == IrpMinorIoWrite) {
+        Write = TRUE;
     }
 
+    Status = SpecialPerformIo(DeviceContext, &(Irp->U.ReadWrite), Write);
     IoCompleteIrp(SpecialDriver, Irp, Status);
     return;
 }
@@ -895,9 +842,142 @@ Return Value:
     return;
 }
 
+KSTATUS
+SpecialDispatchFastIo (
+    PVOID DeviceContext,
+    BOOL Write,
+    PIRP_READ_WRITE Request
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs a read or write without an IRP. None of the special
+    devices ever block, so the request is always completed inline.
+
+Arguments:
+
+    DeviceContext - Supplies the context pointer supplied by the driver when it
+        attached itself to the driver stack.
+
+    Write - Supplies a boolean indicating whether this is a write (TRUE) or a
+        read (FALSE).
+
+    Request - Supplies a pointer to the read/write parameters.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    return SpecialPerformIo(DeviceContext, Request, Write);
+}
+
+KSTATUS
+SpecialPerformIo (
+    PSPECIAL_DEVICE Device,
+    PIRP_READ_WRITE Request,
+    BOOL Write
+    )
+
+/*++
+
+Routine Description:
+
+    This routine performs a read or write on a special device.
+
+Arguments:
+
+    Device - Supplies a pointer to the special device context.
+
+    Request - Supplies a pointer to the read/write parameters.
+
+    Write - Supplies a boolean indicating whether this is a write (TRUE) or a
+        read (FALSE).
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    KSTATUS Status;
+
+    switch (Device->Type) {
+
+    //
+    // The null device accepts and discards all input, and produces no output.
+    //
+
+    case SpecialDeviceNull:
+        Request->IoBytesCompleted = 0;
+        if (Write != FALSE) {
+            Request->IoBytesCompleted = Request->IoSizeInBytes;
+        }
+
+        Status = STATUS_SUCCESS;
+        break;
+
+    //
+    // The zero device accepts and discards all input, and produces a
+    // continuous stream of zero bytes.
+    //
+
+    case SpecialDeviceZero:
+        if (Write == FALSE) {
+            Status = SpecialFillZeroes(Request);
+
+        } else {
+            Request->IoBytesCompleted = Request->IoSizeInBytes;
+            Status = STATUS_SUCCESS;
+        }
+
+        break;
+
+    //
+    // The full device produces a continuous stream of zero bytes when read,
+    // and returns "disk full" when written to.
+    //
+
+    case SpecialDeviceFull:
+        if (Write == FALSE) {
+            Status = SpecialFillZeroes(Request);
+
+        } else {
+            Status = STATUS_VOLUME_FULL;
+        }
+
+        break;
+
+    //
+    // The urandom device produces psuedo-random numbers when read, and adds
+    // entropy when written to.
+    //
+
+    case SpecialDevicePseudoRandom:
+        Status = SpecialPerformPseudoRandomIo(Device, Request, Write);
+        break;
+
+    default:
+
+        ASSERT(FALSE);
+
+        Status = STATUS_FILE_CORRUPT;
+        break;
+    }
+
+    return Status;
+}
+
 KSTATUS
 SpecialFillZeroes (
-    PIRP Irp
+    PIRP_READ_WRITE Request
     )
 
 /*++
@@ -908,7 +988,7 @@ Routine Description:
 
 Arguments:
 
-    Irp - Supplies a pointer to the I/O request packet.
+    Request - Supplies a pointer to the read parameters.
 
 Return Value:
 
@@ -920,18 +1000,14 @@ Return Value:
 
     KSTATUS Status;
 
-    ASSERT(Irp->MinorCode == IrpMinorIoRead);
-    ASSERT(Irp->U.ReadWrite.IoBuffer != NULL);
-
-    Status = MmZeroIoBuffer(Irp->U.ReadWrite.IoBuffer,
-                            0,
-                            Irp->U.ReadWrite.IoSizeInBytes);
+    ASSERT(Request->IoBuffer != NULL);
 
+    Status = MmZeroIoBuffer(Request->IoBuffer, 0, Request->IoSizeInBytes);
     if (!KSUCCESS(Status)) {
         return Status;
     }
 
-    Irp->U.ReadWrite.IoBytesCompleted = Irp->U.ReadWrite.IoSizeInBytes;
+    Request->IoBytesCompleted = Request->IoSizeInBytes;
     return STATUS_SUCCESS;
 }
 
@@ -1038,7 +1114,8 @@ Return Value:
 KSTATUS
 SpecialPerformPseudoRandomIo (
     PSPECIAL_DEVICE Device,
-    PIRP Irp
+    PIRP_READ_WRITE Request,
+    BOOL Write
     )
 
 /*++
@@ -1051,7 +1128,10 @@ Routine Description:
 
     Device - Supplies a pointer to the special device context.
 
-    Irp - Supplies a pointer to the I/O request packet.
+    Request - Supplies a pointer to the read/write parameters.
+
+    Write - Supplies a boolean indicating whether this is a write (TRUE) or a
+        read (FALSE).
 
 Return Value:
 
@@ -1071,11 +1151,11 @@ Return Value:
     UINTN Size;
     KSTATUS Status;
 
-    ASSERT(Irp->U.ReadWrite.IoBuffer != NULL);
+    ASSERT(Request->IoBuffer != NULL);
 
-    IoBuffer = Irp->U.ReadWrite.IoBuffer;
+    IoBuffer = Request->IoBuffer;
     IoBufferOffset = 0;
-    BytesRemaining = Irp->U.ReadWrite.IoSizeInBytes;
+    BytesRemaining = Request->IoSizeInBytes;
 
     //
     // Allocate a non-paged buffer because acquiring the lock raises to
@@ -1098,7 +1178,7 @@ Return Value:
             Size = BytesRemaining;
         }
 
-        if (Irp->MinorCode == IrpMinorIoWrite) {
+        if (Write != FALSE) {
             Status = MmCopyIoBufferData(IoBuffer,
                                         Buffer,
                                         IoBufferOffset,
@@ -1115,12 +1195,23 @@ Return Value:
             KeReleaseSpinLock(&(PseudoRandom->Lock));
             KeLowerRunLevel(OldRunLevel);
 
+        //
+        // Reads are served by the kernel's per-processor generators, which
+        // are reseeded from the system random source, so readers don't
+        // contend on the pool lock. Fall back to the pool directly if the
+        // kernel has no random source yet.
+        //
+
         } else {
-            OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
-            KeAcquireSpinLock(&(PseudoRandom->Lock));
-            CyFortunaGetRandomBytes(Fortuna, Buffer, Size);
-            KeReleaseSpinLock(&(PseudoRandom->Lock));
-            KeLowerRunLevel(OldRunLevel);
+            Status = KeGetRandomBytes(Buffer, Size);
+            if (!KSUCCESS(Status)) {
+                OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+                KeAcquireSpinLock(&(PseudoRandom->Lock));
+                CyFortunaGetRandomBytes(Fortuna, Buffer, Size);
+                KeReleaseSpinLock(&(PseudoRandom->Lock));
+                KeLowerRunLevel(OldRunLevel);
+            }
+
             Status = MmCopyIoBufferData(IoBuffer,
                                         Buffer,
                                         IoBufferOffset,
@@ -1143,8 +1234,7 @@ Return Value:
         MmFreeNonPagedPool(Buffer);
     }
 
-    Irp->U.ReadWrite.IoBytesCompleted = Irp->U.ReadWrite.IoSizeInBytes -
-                                        BytesRemaining;
+    Request->IoBytesCompleted = Request->IoSizeInBytes - BytesRemaining;
 
     return Status;
 }
@@ -40,6 +40,8 @@ Module Name:
 #define SSDT_SIGNATURE 0x54445353 // 'SSDT'
 #define DBG2_SIGNATURE 0x32474244 // 'DBG2'
 #define GTDT_SIGNATURE 0x54445447 // 'GTDT'
+#define FPDT_SIGNATURE 0x54445046 // 'FPDT'
+#define FBPT_SIGNATURE 0x54504246 // 'FBPT'
 
 #define ACPI_20_RSDP_REVISION 0x02
 #define ACPI_30_RSDT_REVISION 0x01
@@ -726,6 +728,30 @@ typedef enum _MADT_ENTRY_TYPE {
 #define DEBUG_PORT_16550_OEM_FLAG_64_BYTE_FIFO                  0x00000001
 #define DEBUG_PORT_16550_OEM_FLAG_TRANSMIT_TRIGGER_2_CHARACTERS 0x00000002
 
+//
+// Define firmware performance data table record types.
+//
+
+#define FPDT_RECORD_BASIC_BOOT_POINTER 0x0000
+#define FPDT_RECORD_BASIC_BOOT_PERFORMANCE 0x0002
+#define FPDT_RECORD_GUID_EVENT 0x1010
+
+#define FPDT_RECORD_REVISION 1
+#define FPDT_RECORD_BASIC_BOOT_PERFORMANCE_REVISION 2
+
+//
+// Define the progress IDs used in GUID event records. Values below 0x10 are
+// reserved for module start and end events keyed by the module's file GUID.
+// Values at or above 0x8000 are vendor defined boot phases.
+//
+
+#define FPDT_PROGRESS_MODULE_START 0x0001
+#define FPDT_PROGRESS_MODULE_END 0x0002
+#define FPDT_PROGRESS_DISPATCHER_START 0x8000
+#define FPDT_PROGRESS_DISPATCHER_END 0x8001
+#define FPDT_PROGRESS_CONNECT_START 0x8002
+#define FPDT_PROGRESS_CONNECT_END 0x8003
+
 //
 // Define Intel-specific fixed function hardware register flags and bitfields.
 //
@@ -1666,6 +1692,146 @@ typedef struct _GTDT {
     ULONG NonSecurePl2Flags;
 } PACKED GTDT, *PGTDT;
 
+/*++
+
+Structure Description:
+
+    This structure defines the header common to every firmware performance
+    record.
+
+Members:
+
+    Type - Stores the record type. See FPDT_RECORD_* definitions.
+
+    Length - Stores the length of the record in bytes, including this header.
+
+    Revision - Stores the revision of the record format.
+
+--*/
+
+typedef struct _FPDT_RECORD_HEADER {
+    USHORT Type;
+    UCHAR Length;
+    UCHAR Revision;
+} PACKED FPDT_RECORD_HEADER, *PFPDT_RECORD_HEADER;
+
+/*++
+
+Structure Description:
+
+    This structure defines the Firmware Performance Data Table, which points
+    the operating system at the firmware boot performance table.
+
+Members:
+
+    Header - Stores the table header, including the signature, 'FPDT'.
+
+    BootPointer - Stores the record header of the basic boot pointer record.
+
+    Reserved - Stores a reserved value set to zero.
+
+    BootTableAddress - Stores the physical address of the firmware basic boot
+        performance table.
+
+--*/
+
+typedef struct _FPDT {
+    DESCRIPTION_HEADER Header;
+    FPDT_RECORD_HEADER BootPointer;
+    ULONG Reserved;
+    ULONGLONG BootTableAddress;
+} PACKED FPDT, *PFPDT;
+
+/*++
+
+Structure Description:
+
+    This structure defines the header of the firmware basic boot performance
+    table. The table lives in reserved memory and is followed by a basic boot
+    performance record and then any number of GUID event records.
+
+Members:
+
+    Signature - Stores the signature, 'FBPT'.
+
+    Length - Stores the length of the table in bytes, including this header
+        and all the records that follow it.
+
+--*/
+
+typedef struct _FBPT {
+    ULONG Signature;
+    ULONG Length;
+} PACKED FBPT, *PFBPT;
+
+/*++
+
+Structure Description:
+
+    This structure defines the basic boot performance record. All timestamps
+    are in nanoseconds since the firmware started counting, and are zero if
+    the phase has not been reached.
+
+Members:
+
+    Header - Stores the record header.
+
+    Reserved - Stores a reserved value set to zero.
+
+    ResetEnd - Stores the time the firmware began executing.
+
+    OsLoaderLoadImageStart - Stores the time the firmware started loading the
+        OS loader image.
+
+    OsLoaderStartImageStart - Stores the time the firmware started executing
+        the OS loader image.
+
+    ExitBootServicesEntry - Stores the time the OS loader called exit boot
+        services.
+
+    ExitBootServicesExit - Stores the time exit boot services returned.
+
+--*/
+
+typedef struct _FPDT_BASIC_BOOT_RECORD {
+    FPDT_RECORD_HEADER Header;
+    ULONG Reserved;
+    ULONGLONG ResetEnd;
+    ULONGLONG OsLoaderLoadImageStart;
+    ULONGLONG OsLoaderStartImageStart;
+    ULONGLONG ExitBootServicesEntry;
+    ULONGLONG ExitBootServicesExit;
+} PACKED FPDT_BASIC_BOOT_RECORD, *PFPDT_BASIC_BOOT_RECORD;
+
+/*++
+
+Structure Description:
+
+    This structure defines a GUID event record, which marks a point in time
+    during boot attributed to a particular module or phase.
+
+Members:
+
+    Header - Stores the record header.
+
+    ProgressId - Stores the kind of event. See FPDT_PROGRESS_* definitions.
+
+    ApicId - Stores the identifier of the processor that logged the event.
+
+    Timestamp - Stores the time of the event in nanoseconds.
+
+    Guid - Stores the GUID of the module or phase the event belongs to.
+
+--*/
+
+typedef struct _FPDT_GUID_EVENT_RECORD {
+    FPDT_RECORD_HEADER Header;
+    USHORT ProgressId;
+    ULONG ApicId;
+    ULONGLONG Timestamp;
+    UCHAR Guid[16];
+} PACKED FPDT_GUID_EVENT_RECORD, *PFPDT_GUID_EVENT_RECORD;
+
 #pragma pack(pop)
 
 //
@@ -520,6 +520,34 @@ Return Value:
 
 --*/
 
+KERNEL_API
+BOOL
+HlQueryUserTimeCounter (
+    PULONGLONG Offset
+    );
+
+/*++
+
+Routine Description:
+
+    This routine determines whether user mode can compute the time counter by
+    reading the counter hardware directly. This is only possible if the time
+    counter is a full 64-bit, invariant counter that user mode has been
+    granted access to.
+
+Arguments:
+
+    Offset - Supplies a pointer where the value to add to the raw hardware
+        counter will be returned on success.
+
+Return Value:
+
+    TRUE if user mode can read the time counter directly.
+
+    FALSE if user mode must ask the kernel for the time counter.
+
+--*/
+
 KERNEL_API
 VOID
 HlBusySpin (
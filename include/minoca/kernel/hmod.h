@@ -187,6 +187,14 @@ Module Name:
 
 #define TIMER_FEATURE_ABSOLUTE 0x00000100
 
+//
+// Set this flag if the timer's counter can be read directly by user mode
+// using the architecture's counter instruction (rdtsc on PC, the virtual count
+// register on ARM), and the timer module has granted user mode that access.
+//
+
+#define TIMER_FEATURE_USER_READABLE 0x00000200
+
 //
 // Define calendar timer features.
 //
@@ -99,7 +99,7 @@ Module Name:
 // Define the current version number of the driver function table.
 //
 
-#define DRIVER_FUNCTION_TABLE_VERSION 1
+#define DRIVER_FUNCTION_TABLE_VERSION 2
 
 //
 // Define the name of the local terminal.
@@ -823,6 +823,109 @@ Module Name:
 
 #define PIPE_ATOMIC_WRITE_SIZE 4096
 
+//
+// Define the file watch event bits. These match the values used by the C
+// library's inotify interface, so events can be handed to user mode as is.
+//
+
+//
+// This bit is set when a watched file, or a file in a watched directory, is
+// written to or truncated.
+//
+
+#define FILE_WATCH_EVENT_MODIFY 0x00000002
+
+//
+// This bit is set when the permissions, ownership, time stamps, or other
+// attributes of a watched file change.
+//
+
+#define FILE_WATCH_EVENT_ATTRIBUTES 0x00000004
+
+//
+// These bits are set on a watched directory when an entry is renamed out of
+// or into it. The two halves of a rename share a cookie.
+//
+
+#define FILE_WATCH_EVENT_MOVED_FROM 0x00000040
+#define FILE_WATCH_EVENT_MOVED_TO 0x00000080
+
+//
+// These bits are set on a watched directory when an entry is created in or
+// deleted from it.
+//
+
+#define FILE_WATCH_EVENT_CREATE 0x00000100
+#define FILE_WATCH_EVENT_DELETE 0x00000200
+
+//
+// These bits are set when the watched object itself loses its last link or
+// is renamed.
+//
+
+#define FILE_WATCH_EVENT_DELETE_SELF 0x00000400
+#define FILE_WATCH_EVENT_MOVE_SELF 0x00000800
+
+//
+// This bit is set in the event queued when events were dropped because the
+// queue was full. Its descriptor is -1.
+//
+
+#define FILE_WATCH_EVENT_OVERFLOW 0x00004000
+
+//
+// This bit is set in the last event delivered for a watch, after it has been
+// removed.
+//
+
+#define FILE_WATCH_EVENT_IGNORED 0x00008000
+
+//
+// This bit is set in an event if the subject is a directory.
+//
+
+#define FILE_WATCH_EVENT_DIRECTORY 0x40000000
+
+#define FILE_WATCH_EVENT_MASK                                           \
+    (FILE_WATCH_EVENT_MODIFY | FILE_WATCH_EVENT_ATTRIBUTES |            \
+     FILE_WATCH_EVENT_MOVED_FROM | FILE_WATCH_EVENT_MOVED_TO |          \
+     FILE_WATCH_EVENT_CREATE | FILE_WATCH_EVENT_DELETE |                \
+     FILE_WATCH_EVENT_DELETE_SELF | FILE_WATCH_EVENT_MOVE_SELF)
+
+//
+// Define the flags that can be passed when adding a file watch.
+//
+
+//
+// Set this flag to fail if the path is not a directory.
+//
+
+#define FILE_WATCH_FLAG_DIRECTORY 0x01000000
+
+//
+// Set this flag to watch a symbolic link itself rather than its target.
+//
+
+#define FILE_WATCH_FLAG_NO_FOLLOW 0x02000000
+
+//
+// Set this flag to add to the events of an existing watch on the same file
+// rather than replacing them.
+//
+
+#define FILE_WATCH_FLAG_ADD 0x20000000
+
+#define FILE_WATCH_FLAG_MASK                                    \
+    (FILE_WATCH_FLAG_DIRECTORY | FILE_WATCH_FLAG_NO_FOLLOW |    \
+     FILE_WATCH_FLAG_ADD)
+
+//
+// Define the maximum number of events a watch queue holds before it starts
+// dropping them.
+//
+
+#define FILE_WATCH_MAX_QUEUED_EVENTS 16384
+
 //
 // Define I/O test hook bits.
 //
@@ -944,6 +1047,7 @@ typedef struct _DRIVER DRIVER, *PDRIVER;
 typedef struct _IRP IRP, *PIRP;
 typedef struct _STREAM_BUFFER STREAM_BUFFER, *PSTREAM_BUFFER;
 typedef struct _IO_HANDLE IO_HANDLE, *PIO_HANDLE;
+typedef struct _IRP_READ_WRITE IRP_READ_WRITE, *PIRP_READ_WRITE;
 typedef struct _PAGE_CACHE_ENTRY PAGE_CACHE_ENTRY, *PPAGE_CACHE_ENTRY;
 
 typedef enum _SEEK_COMMAND {
@@ -1318,6 +1422,44 @@ Return Value:
 
 --*/
 
+typedef
+KSTATUS
+(*PDRIVER_FAST_IO) (
+    PVOID DeviceContext,
+    BOOL Write,
+    PIRP_READ_WRITE Request
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called to perform a synchronous read or write without an
+    IRP. It is only called on the topmost driver in the device's stack. The
+    driver must not block for long and must not pend the request; if it
+    cannot finish the request inline it should return STATUS_NOT_HANDLED, and
+    the request will be sent down the stack in an I/O IRP instead.
+
+Arguments:
+
+    DeviceContext - Supplies the context pointer supplied by the driver when it
+        attached itself to the driver stack.
+
+    Write - Supplies a boolean indicating whether this is a write (TRUE) or a
+        read (FALSE).
+
+    Request - Supplies a pointer to the read/write parameters, which are the
+        same ones that would have been sent in the I/O IRP. The driver fills
+        in the bytes completed and new I/O offset as it would for an IRP.
+
+Return Value:
+
+    STATUS_NOT_HANDLED if the request should be sent in an IRP instead.
+
+    Otherwise, returns the completion status of the request.
+
+--*/
+
 typedef
 VOID
 (*PINTERFACE_NOTIFICATION_CALLBACK) (
@@ -1398,6 +1540,10 @@ Structure Description:
     DispatchUserControl - Stores a pointer to the routine used to dispatch
         user control IRPs.
 
+    DispatchFastIo - Stores an optional pointer to the routine used to perform
+        synchronous reads and writes without an IRP. This member was added in
+        version 2 of the table.
+
 --*/
 
 typedef struct _DRIVER_FUNCTION_TABLE {
@@ -1412,6 +1558,7 @@ typedef struct _DRIVER_FUNCTION_TABLE {
     PDRIVER_DISPATCH DispatchIo;
     PDRIVER_DISPATCH DispatchSystemControl;
     PDRIVER_DISPATCH DispatchUserControl;
+    PDRIVER_FAST_IO DispatchFastIo;
 } DRIVER_FUNCTION_TABLE, *PDRIVER_FUNCTION_TABLE;
 
 /*++
@@ -1640,6 +1787,38 @@ typedef struct _SET_FILE_INFORMATION {
 
 /*++
 
+Structure Description:
+
+    This structure defines a single event read from a file watch queue. The
+    null terminated name of the directory entry the event is about follows
+    the structure directly, padded out so the next event is aligned.
+
+Members:
+
+    Descriptor - Stores the descriptor of the watch the event belongs to, as
+        returned when the watch was added.
+
+    Events - Stores the bitmask of events that occurred. See
+        FILE_WATCH_EVENT_* definitions.
+
+    Cookie - Stores a value that ties together the two halves of a rename,
+        or zero.
+
+    NameSize - Stores the size of the name that follows in bytes, including
+        the terminator and any padding. This is zero for events about the
+        watched object itself.
+
+--*/
+
+typedef struct _FILE_WATCH_EVENT {
+    LONG Descriptor;
+    ULONG Events;
+    ULONG Cookie;
+    ULONG NameSize;
+} FILE_WATCH_EVENT, *PFILE_WATCH_EVENT;
+
+/*++
+
 Structure Description:
 
     This structure defines a link between an I/O object state and a particular
@@ -2020,7 +2199,7 @@ Structure Description:
 
 --*/
 
-typedef struct _IRP_READ_WRITE {
+struct _IRP_READ_WRITE {
     PVOID DeviceContext;
     PIO_BUFFER IoBuffer;
     IRP_IO_BUFFER_STATE IoBufferState;
@@ -2031,7 +2210,7 @@ typedef struct _IRP_READ_WRITE {
     UINTN IoBytesCompleted;
     IO_OFFSET NewIoOffset;
     PFILE_PROPERTIES FileProperties;
-} IRP_READ_WRITE, *PIRP_READ_WRITE;
+};
 
 /*++
 
@@ -5693,6 +5872,84 @@ Return Value:
 
 --*/
 
+INTN
+IoSysCreateWatchQueue (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a file watch queue on behalf of a user mode
+    application.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysAddWatch (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds a watch on a file or directory to a file watch queue on
+    behalf of a user mode application.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysRemoveWatch (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes a watch from a file watch queue on behalf of a user
+    mode application.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
 INTN
 IoSysGetCurrentDirectory (
     PVOID SystemCallParameter
@@ -6288,6 +6545,32 @@ IoSysSocketPerformVectoredIo (
 
 /*++
 
+Routine Description:
+
+    This routine handles the system call that sends or receives a batch of
+    messages on a socket.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+INTN
+IoSysSocketPerformBatchIo (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
 Routine Description:
 
     This routine handles the system call that performs socket I/O using I/O
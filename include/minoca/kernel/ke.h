@@ -165,6 +165,18 @@ Module Name:
 
 #define ARM_FEATURE_NEON32     0x00000008
 
+//
+// Define user shared data time counter flags.
+//
+
+//
+// This bit is set if user mode can compute the time counter on its own by
+// reading the counter hardware (see TIMER_FEATURE_USER_READABLE) and adding
+// the time counter offset.
+//
+
+#define USER_TIME_COUNTER_READABLE 0x00000001
+
 //
 // Define the set of DCP flags.
 //
@@ -280,6 +292,7 @@ typedef enum _CLOCK_TIMER_MODE {
 
 typedef struct _KTIMER KTIMER, *PKTIMER;
 typedef struct _KTIMER_DATA KTIMER_DATA, *PKTIMER_DATA;
+typedef struct _KRANDOM_DATA KRANDOM_DATA, *PKRANDOM_DATA;
 typedef struct _WORK_ITEM WORK_ITEM, *PWORK_ITEM;
 typedef struct _WORK_QUEUE WORK_QUEUE, *PWORK_QUEUE;
 typedef struct _SCHEDULER_DATA SCHEDULER_DATA, *PSCHEDULER_DATA;
@@ -647,6 +660,14 @@ Structure Description:
 
     CpuVersion - Stores the processor identification information for this CPU.
 
+    AddressSpace - Stores a pointer to the address space currently loaded on
+        this processor, or NULL if the processor has not yet switched address
+        spaces. This is used to direct TLB invalidations of user mode
+        addresses only at the processors that might be caching them.
+
+    RandomData - Stores a pointer to the processor's random number generator,
+        which is periodically reseeded from the system random source.
+
 --*/
 
 typedef struct _PROCESSOR_BLOCK PROCESSOR_BLOCK, *PPROCESSOR_BLOCK;
@@ -682,6 +703,8 @@ struct _PROCESSOR_BLOCK {
     PVOID SwapPage;
     UINTN NmiCount;
     PROCESSOR_IDENTIFICATION CpuVersion;
+    volatile PVOID AddressSpace;
+    PKRANDOM_DATA RandomData;
 };
 
 /*++
@@ -974,6 +997,13 @@ Structure Description:
     ProcessorFeatures - Stores a bitfield of architecture-specific feature
         flags.
 
+    TimeCounterFlags - Stores a bitfield of flags describing how user mode
+        can read the time counter. See USER_TIME_COUNTER_* definitions.
+
+    TimeCounterOffset - Stores the value to add to the raw counter hardware
+        value to get the time counter, if user mode can read the counter
+        directly. This value won't change once the system is booted.
+
 --*/
 
 typedef struct _USER_SHARED_DATA {
@@ -988,6 +1018,8 @@ typedef struct _USER_SHARED_DATA {
     volatile ULONGLONG TickCount;
     volatile ULONGLONG TickCount2;
     ULONG ProcessorFeatures;
+    ULONG TimeCounterFlags;
+    ULONGLONG TimeCounterOffset;
 } USER_SHARED_DATA, *PUSER_SHARED_DATA;
 
 //
@@ -2809,6 +2841,31 @@ Return Value:
 
 --*/
 
+INTN
+KeSysGetRandomBytes (
+    PVOID SystemCallParameter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for getting random bytes.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
 INTN
 KeSysDelayExecution (
     PVOID SystemCallParameter
@@ -208,6 +208,14 @@ Module Name:
 
 #define SOCKET_IO_DONT_ROUTE 0x00000100
 
+//
+// This flag is only meaningful for batched receives. It requests that the
+// batch wait for the first message, but not block waiting for any of the
+// messages after it.
+//
+
+#define SOCKET_IO_WAIT_FOR_ONE 0x00000200
+
 //
 // Define common internet protocol numbers, as defined by the IANA.
 //
@@ -731,6 +739,28 @@ typedef enum _SOCKET_TCP_OPTION {
 
 /*++
 
+Enumeration Description:
+
+    This enumeration describes the various UDP options for the UDP socket
+    information class.
+
+Values:
+
+    SocketUdpOptionInvalid - Indicates an invalid UDP socket option.
+
+    SocketUdpOptionSegmentSize - Indicates the size of the datagrams that a
+        single large send is split into. Zero disables segmentation, so that
+        each send is exactly one datagram. This option takes a ULONG.
+
+--*/
+
+typedef enum _SOCKET_UDP_OPTION {
+    SocketUdpOptionInvalid,
+    SocketUdpOptionSegmentSize
+} SOCKET_UDP_OPTION, *PSOCKET_UDP_OPTION;
+
+/*++
+
 Structure Description:
 
     This structure defines the common portion of a socket that must be at the
@@ -825,6 +855,32 @@ typedef struct _SOCKET_IO_PARAMETERS {
 
 /*++
 
+Structure Description:
+
+    This structure defines a single message within a batched socket I/O
+    request.
+
+Members:
+
+    Parameters - Stores the socket I/O parameters for this message. On
+        return, the bytes completed, flags, remote address, and control data
+        are filled in for the message.
+
+    VectorArray - Stores a pointer to an array of I/O vectors describing the
+        data buffer for this message.
+
+    VectorCount - Stores the number of elements in the vector array.
+
+--*/
+
+typedef struct _SOCKET_IO_MESSAGE {
+    SOCKET_IO_PARAMETERS Parameters;
+    PIO_VECTOR VectorArray;
+    UINTN VectorCount;
+} SOCKET_IO_MESSAGE, *PSOCKET_IO_MESSAGE;
+
+/*++
+
 Structure Description:
 
     This structure defines a socket control message, the header for the socket
@@ -91,7 +91,7 @@ Module Name:
 
 #define USER_STACK_HEADROOM (128 * _1MB)
 #define USER_STACK_MAX (((UINTN)MAX_USER_ADDRESS + 1) * 3 / 4)
-#define MM_STATISTICS_VERSION 1
+#define MM_STATISTICS_VERSION 2
 #define MM_STATISTICS_MAX_VERSION 0x10000000
 
 //
@@ -301,14 +301,21 @@ Module Name:
     MmFreePhysicalPages((_PhysicalAddress), 1)
 
 //
-// These macros acquire the address space lock.
+// These macros acquire the address space lock. Exclusive mode is needed to
+// change the set of image sections, shared mode is enough to look them up.
 //
 
 #define MmAcquireAddressSpaceLock(_AddressSpace) \
-    KeAcquireQueuedLock((_AddressSpace)->Lock)
+    KeAcquireSharedExclusiveLockExclusive((_AddressSpace)->Lock)
 
 #define MmReleaseAddressSpaceLock(_AddressSpace) \
-    KeReleaseQueuedLock((_AddressSpace)->Lock)
+    KeReleaseSharedExclusiveLockExclusive((_AddressSpace)->Lock)
+
+#define MmAcquireAddressSpaceLockShared(_AddressSpace) \
+    KeAcquireSharedExclusiveLockShared((_AddressSpace)->Lock)
+
+#define MmReleaseAddressSpaceLockShared(_AddressSpace) \
+    KeReleaseSharedExclusiveLockShared((_AddressSpace)->Lock)
 
 //
 // ------------------------------------------------------ Data Type Definitions
@@ -677,6 +684,15 @@ Structure Description:
     NonPagedPhysicalPages - Stores the number of physical pages that are
         pinned in memory and cannot be paged out to disk.
 
+    TlbShootdowns - Stores the number of TLB invalidations since boot that
+        had to be coordinated with other processors.
+
+    TlbInvalidateIpis - Stores the number of TLB invalidation IPIs sent to
+        other processors since boot.
+
+    TlbFullFlushes - Stores the number of times a range invalidation was
+        large enough that the entire TLB was flushed instead.
+
 --*/
 
 typedef struct _MM_STATISTICS {
@@ -687,6 +703,9 @@ typedef struct _MM_STATISTICS {
     UINTN PhysicalPages;
     UINTN AllocatedPhysicalPages;
     UINTN NonPagedPhysicalPages;
+    UINTN TlbShootdowns;
+    UINTN TlbInvalidateIpis;
+    UINTN TlbFullFlushes;
 } MM_STATISTICS, *PMM_STATISTICS;
 
 /*++
@@ -717,11 +736,19 @@ Structure Description:
 
 Members:
 
-    Lock - Stores a pointer to the queued lock serializing access to the
-        image section list.
+    Lock - Stores a pointer to the shared-exclusive lock serializing access
+        to the image section list and tree.
 
     SectionListHead - Stores the head of the list of image sections mapped
-        into this process.
+        into this process, sorted by address.
+
+    SectionTree - Stores the tree of image sections mapped into this process,
+        keyed by starting address. Sections never overlap, so the section
+        covering an address is the closest one starting at or below it.
+
+    SectionGeneration - Stores a system-wide unique value that changes every
+        time an image section is removed from this address space. Threads
+        use it to tell whether their cached last-hit section is still valid.
 
     Accountant - Stores a pointer to the address tracking information for this
         space.
@@ -743,6 +770,8 @@ Structure Description:
 typedef struct _ADDRESS_SPACE {
     PVOID Lock;
     LIST_ENTRY SectionListHead;
+    RED_BLACK_TREE SectionTree;
+    ULONGLONG SectionGeneration;
     PMEMORY_ACCOUNTING Accountant;
     volatile UINTN ResidentSet;
     volatile UINTN MaxResidentSet;
@@ -3377,6 +3406,61 @@ Return Value:
 
 --*/
 
+PVOID
+MmGetDirectMapAddress (
+    PHYSICAL_ADDRESS PhysicalAddress,
+    UINTN Size
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the address of the given physical memory within the
+    kernel's permanent direct map of RAM. Direct map addresses are always
+    mapped cached, never need to be unmapped, and can be used from any
+    address space.
+
+Arguments:
+
+    PhysicalAddress - Supplies the physical address to look up.
+
+    Size - Supplies the number of bytes that need to be accessible starting at
+        the given physical address.
+
+Return Value:
+
+    Returns the direct map address corresponding to the physical address.
+
+    NULL if the range is not entirely covered by the direct map, or if the
+    architecture has no direct map.
+
+--*/
+
+BOOL
+MmIsDirectMapAddress (
+    PVOID Address
+    );
+
+/*++
+
+Routine Description:
+
+    This routine determines whether the given virtual address lies within the
+    kernel's direct map of RAM. Such addresses must never be unmapped.
+
+Arguments:
+
+    Address - Supplies the virtual address to check.
+
+Return Value:
+
+    TRUE if the address is a direct map address.
+
+    FALSE if the address is not part of the direct map.
+
+--*/
+
 VOID
 MmVolumeArrival (
     PCSTR VolumeName,
@@ -1703,6 +1703,16 @@ Structure Description:
 
     Limits - Stores the resource limits associated with the thread.
 
+    SectionHint - Stores a pointer to the image section this thread most
+        recently looked up. This is only a hint, and is only valid while
+        the section hint address space and generation match.
+
+    SectionHintAddressSpace - Stores a pointer to the address space the
+        section hint was found in.
+
+    SectionHintGeneration - Stores the section generation of the address
+        space at the time the section hint was recorded.
+
 --*/
 
 struct _KTHREAD {
@@ -1741,6 +1751,9 @@ struct _KTHREAD {
     RUNTIME_TIMER UserTimer;
     RUNTIME_TIMER ProfileTimer;
     RESOURCE_LIMIT Limits[ResourceLimitCount];
+    PVOID SectionHint;
+    PVOID SectionHintAddressSpace;
+    ULONGLONG SectionHintGeneration;
 };
 
 /*++
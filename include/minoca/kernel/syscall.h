@@ -179,6 +179,13 @@ Module Name:
 
 #define SYS_MAP_FLUSH_FLAG_ASYNC 0x00000001
 
+//
+// Define the most random data a single get random bytes system call returns.
+// Larger requests are cut short so that they don't hog the processor.
+//
+
+#define SYS_RANDOM_MAX_SIZE (32 * 1024 * 1024)
+
 //
 // Define wait system call flags.
 //
@@ -357,6 +364,11 @@ typedef enum _SYSTEM_CALL_NUMBER {
     SystemCallSetITimer,
     SystemCallSetResourceLimit,
     SystemCallSetBreak,
+    SystemCallSocketPerformBatchIo,
+    SystemCallGetRandomBytes,
+    SystemCallCreateWatchQueue,
+    SystemCallAddWatch,
+    SystemCallRemoveWatch,
     SystemCallCount
 } SYSTEM_CALL_NUMBER, *PSYSTEM_CALL_NUMBER;
 
@@ -2484,6 +2496,139 @@ typedef struct _SYSTEM_CALL_SET_BREAK {
 
 /*++
 
+Structure Description:
+
+    This structure defines the system call parameters for sending or receiving
+    a batch of messages on a socket in a single system call.
+
+Members:
+
+    Socket - Stores the socket to use.
+
+    IoFlags - Stores the I/O flags for the batch. If SYS_IO_FLAG_WRITE is set,
+        the messages are sent. Otherwise they are received.
+
+    Messages - Stores a pointer to the array of messages to send or receive.
+        The parameters of each message that was processed are updated on
+        return.
+
+    MessageCount - Stores the number of elements in the message array. On
+        return, contains the number of messages that were completed.
+
+--*/
+
+typedef struct _SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO {
+    HANDLE Socket;
+    ULONG IoFlags;
+    PSOCKET_IO_MESSAGE Messages;
+    UINTN MessageCount;
+} SYSCALL_STRUCT SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO,
+    *PSYSTEM_CALL_SOCKET_PERFORM_BATCH_IO;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for getting random
+    bytes from the kernel's random number generators.
+
+Members:
+
+    Buffer - Stores a pointer to the buffer to fill with random bytes.
+
+    Size - Stores the number of bytes requested. On return, contains the
+        number of bytes written, which may be less than requested if the
+        request was larger than SYS_RANDOM_MAX_SIZE.
+
+--*/
+
+typedef struct _SYSTEM_CALL_GET_RANDOM_BYTES {
+    PVOID Buffer;
+    UINTN Size;
+} SYSCALL_STRUCT SYSTEM_CALL_GET_RANDOM_BYTES, *PSYSTEM_CALL_GET_RANDOM_BYTES;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for creating a file
+    watch queue.
+
+Members:
+
+    OpenFlags - Stores the set of open flags associated with the handle. Only
+        SYS_OPEN_FLAG_CLOSE_ON_EXECUTE and SYS_OPEN_FLAG_NON_BLOCKING are
+        accepted.
+
+    Handle - Stores the returned handle to the watch queue.
+
+--*/
+
+typedef struct _SYSTEM_CALL_CREATE_WATCH_QUEUE {
+    ULONG OpenFlags;
+    HANDLE Handle;
+} SYSCALL_STRUCT SYSTEM_CALL_CREATE_WATCH_QUEUE,
+    *PSYSTEM_CALL_CREATE_WATCH_QUEUE;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for adding a file watch
+    to a watch queue.
+
+Members:
+
+    Queue - Stores the handle to the watch queue.
+
+    Directory - Stores an optional handle to the directory to start path
+        traversal from if the specified path is relative. Supply INVALID_HANDLE
+        here to use the current directory for relative paths.
+
+    Path - Stores a pointer to the path of the file or directory to watch.
+
+    PathLength - Stores the length of the path buffer in bytes, including the
+        null terminator.
+
+    Events - Stores the bitmask of events to watch for, combined with any
+        flags. See FILE_WATCH_EVENT_* and FILE_WATCH_FLAG_* definitions.
+
+    Descriptor - Stores the returned descriptor for the watch, which is
+        reported in its events.
+
+--*/
+
+typedef struct _SYSTEM_CALL_ADD_WATCH {
+    HANDLE Queue;
+    HANDLE Directory;
+    PSTR Path;
+    ULONG PathLength;
+    ULONG Events;
+    LONG Descriptor;
+} SYSCALL_STRUCT SYSTEM_CALL_ADD_WATCH, *PSYSTEM_CALL_ADD_WATCH;
+
+/*++
+
+Structure Description:
+
+    This structure defines the system call parameters for removing a file
+    watch from a watch queue.
+
+Members:
+
+    Queue - Stores the handle to the watch queue.
+
+    Descriptor - Stores the descriptor of the watch to remove.
+
+--*/
+
+typedef struct _SYSTEM_CALL_REMOVE_WATCH {
+    HANDLE Queue;
+    LONG Descriptor;
+} SYSCALL_STRUCT SYSTEM_CALL_REMOVE_WATCH, *PSYSTEM_CALL_REMOVE_WATCH;
+
+/*++
+
 Structure Description:
 
     This structure defines the system call parameters for getting or setting
@@ -2589,6 +2734,11 @@ typedef union _SYSTEM_CALL_PARAMETER_UNION {
     SYSTEM_CALL_SET_ITIMER SetITimer;
     SYSTEM_CALL_SET_RESOURCE_LIMIT SetResourceLimit;
     SYSTEM_CALL_SET_BREAK SetBreak;
+    SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO SocketPerformBatchIo;
+    SYSTEM_CALL_GET_RANDOM_BYTES GetRandomBytes;
+    SYSTEM_CALL_CREATE_WATCH_QUEUE CreateWatchQueue;
+    SYSTEM_CALL_ADD_WATCH AddWatch;
+    SYSTEM_CALL_REMOVE_WATCH RemoveWatch;
 } SYSCALL_STRUCT SYSTEM_CALL_PARAMETER_UNION, *PSYSTEM_CALL_PARAMETER_UNION;
 
 typedef
@@ -97,6 +97,15 @@ Module Name:
 
 #define X64_SELF_MAP_INDEX (X64_PTE_COUNT - 2)
 
+//
+// Define the bits of CR3 used when process context identifiers are enabled.
+// The low bits hold the PCID, and setting the high bit on a write preserves
+// the TLB entries already tagged with that PCID.
+//
+
+#define X64_CR3_PCID_MASK 0x0000000000000FFFULL
+#define X64_CR3_NO_FLUSH 0x8000000000000000ULL
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -607,6 +616,16 @@ Structure Description:
     ActivePageTables - Stores the number of page table pages that are in
         service for user mode of this process.
 
+    Id - Stores a unique identifier for the address space, used to tag its
+        TLB entries with a process context identifier. This is zero for the
+        kernel address space. Identifiers are never reused.
+
+    TlbGeneration - Stores a counter that is incremented whenever a user mode
+        translation in the address space is invalidated. Processors not
+        running in the address space at the time miss the invalidation, and
+        use this to know they need to flush the address space's TLB entries
+        when they next switch to it.
+
 --*/
 
 typedef struct _ADDRESS_SPACE_X64 {
@@ -614,6 +633,8 @@ typedef struct _ADDRESS_SPACE_X64 {
     PHYSICAL_ADDRESS Pml4Physical;
     UINTN AllocatedPageTables;
     UINTN ActivePageTables;
+    ULONGLONG Id;
+    volatile ULONGLONG TlbGeneration;
 } ADDRESS_SPACE_X64, *PADDRESS_SPACE_X64;
 
 //
@@ -931,6 +952,28 @@ Return Value:
 
 --*/
 
+VOID
+ArCleanInvalidateCacheLine (
+    PVOID Address
+    );
+
+/*++
+
+Routine Description:
+
+    This routine writes back and invalidates the cache line containing the
+    given address in every cache in the coherency domain (CLFLUSH).
+
+Arguments:
+
+    Address - Supplies a virtual address within the line to flush.
+
+Return Value:
+
+    None.
+
+--*/
+
 UINTN
 ArGetControlRegister0 (
     VOID
@@ -256,7 +256,11 @@ Module Name:
 #define X86_CPUID_BASIC_EAX_EXTENDED_FAMILY_MASK (0xFF << 20)
 #define X86_CPUID_BASIC_EAX_EXTENDED_FAMILY_SHIFT 20
 
+#define X86_CPUID_BASIC_EBX_CLFLUSH_SIZE_MASK (0xFF << 8)
+#define X86_CPUID_BASIC_EBX_CLFLUSH_SIZE_SHIFT 8
+
 #define X86_CPUID_BASIC_ECX_MONITOR (1 << 3)
+#define X86_CPUID_BASIC_ECX_PCID (1 << 17)
 #define X86_CPUID_BASIC_EDX_SYSENTER (1 << 11)
 #define X86_CPUID_BASIC_EDX_CMOV (1 << 15)
 #define X86_CPUID_BASIC_EDX_FX_SAVE_RESTORE (1 << 24)
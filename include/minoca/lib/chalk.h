@@ -104,6 +104,23 @@ Module Name:
 
 #define CK_CONFIGURATION_DEBUG_COMPILER 0x00000002
 
+//
+// Define profiler flags.
+//
+
+//
+// Set this flag to record the call stack each time the profiler is ticked.
+//
+
+#define CK_PROFILE_SAMPLE 0x00000001
+
+//
+// Set this flag to count the calls to and inclusive time spent in each
+// function.
+//
+
+#define CK_PROFILE_COUNT 0x00000002
+
 //
 // Define the maximum UTF-8 value that can be encoded.
 //
@@ -719,6 +736,118 @@ Return Value:
 
 --*/
 
+CK_API
+BOOL
+CkStartProfiler (
+    PCK_VM Vm,
+    ULONG Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine starts profiling the given VM. Stack samples are only taken
+    when the profiler is ticked, so the caller must also arrange for
+    CkProfilerTick to be called periodically.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Flags - Supplies a bitfield of flags governing what to collect. See
+        CK_PROFILE_* definitions.
+
+Return Value:
+
+    TRUE on success.
+
+    FALSE on allocation failure or if the profiler is already running.
+
+--*/
+
+CK_API
+VOID
+CkProfilerTick (
+    PCK_VM Vm
+    );
+
+/*++
+
+Routine Description:
+
+    This routine requests a stack sample. The sample is taken the next time
+    the interpreter calls, returns, or loops. This routine only sets a
+    counter, so it is safe to call from a signal handler or timer thread, as
+    long as the profiler is not being stopped at the same time.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
+CK_API
+VOID
+CkWriteProfile (
+    PCK_VM Vm,
+    ULONG Flags,
+    PCK_WRITE Write
+    );
+
+/*++
+
+Routine Description:
+
+    This routine prints the collected profile. Stack samples are printed in
+    the folded format used by flame graph tools: one line per unique stack,
+    with frames separated by semicolons, followed by the sample count.
+    Function counters are printed one per line as the call count, the
+    inclusive time in microseconds, and the function name, sorted by time.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+    Flags - Supplies the part of the profile to print. Supply exactly one of
+        the CK_PROFILE_* flags.
+
+    Write - Supplies a pointer to the routine called to print each line.
+
+Return Value:
+
+    None.
+
+--*/
+
+CK_API
+VOID
+CkStopProfiler (
+    PCK_VM Vm
+    );
+
+/*++
+
+Routine Description:
+
+    This routine stops profiling the given VM and discards the collected
+    profile. The caller must make sure nothing is still ticking the
+    profiler.
+
+Arguments:
+
+    Vm - Supplies a pointer to the virtual machine.
+
+Return Value:
+
+    None.
+
+--*/
+
 CK_API
 BOOL
 CkPreloadForeignModule (
@@ -84,6 +84,15 @@ Module Name:
 #define FORTUNA_HASH_KEY_SIZE 32
 #define FORTUNA_POOL_COUNT 23
 
+//
+// Define ChaCha20 parameters.
+//
+
+#define CHACHA20_KEY_SIZE 32
+#define CHACHA20_NONCE_SIZE 12
+#define CHACHA20_BLOCK_SIZE 64
+#define CHACHA20_STATE_SIZE 16
+
 //
 // Define big integer parameters.
 //
@@ -307,6 +316,30 @@ typedef struct _FORTUNA_CONTEXT {
     ULONGLONG LastReseedTime;
 } FORTUNA_CONTEXT, *PFORTUNA_CONTEXT;
 
+/*++
+
+Structure Description:
+
+    This structure stores the context used by the ChaCha20 stream cipher.
+
+Members:
+
+    State - Stores the cipher state: the constants, key, block counter, and
+        nonce.
+
+    KeyStream - Stores the most recently generated block of key stream.
+
+    KeyStreamOffset - Stores the offset of the next unused byte in the key
+        stream block. This is CHACHA20_BLOCK_SIZE if the block is used up.
+
+--*/
+
+typedef struct _CHACHA20_CONTEXT {
+    ULONG State[CHACHA20_STATE_SIZE];
+    UCHAR KeyStream[CHACHA20_BLOCK_SIZE];
+    UINTN KeyStreamOffset;
+} CHACHA20_CONTEXT, *PCHACHA20_CONTEXT;
+
 //
 // Define functions called by the big integer library.
 //
@@ -1412,6 +1445,73 @@ Return Value:
 
 --*/
 
+CRYPTO_API
+VOID
+CyChaCha20Initialize (
+    PCHACHA20_CONTEXT Context,
+    UCHAR Key[CHACHA20_KEY_SIZE],
+    UCHAR Nonce[CHACHA20_NONCE_SIZE],
+    ULONG Counter
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes a ChaCha20 context with a key, nonce, and
+    starting block counter.
+
+Arguments:
+
+    Context - Supplies a pointer to the context to initialize.
+
+    Key - Supplies the 256-bit key.
+
+    Nonce - Supplies the 96-bit nonce.
+
+    Counter - Supplies the block number to start the key stream at.
+
+Return Value:
+
+    None.
+
+--*/
+
+CRYPTO_API
+VOID
+CyChaCha20Encrypt (
+    PCHACHA20_CONTEXT Context,
+    PCVOID Input,
+    PVOID Output,
+    UINTN Size
+    );
+
+/*++
+
+Routine Description:
+
+    This routine encrypts or decrypts data with ChaCha20. Since this is a
+    stream cipher the two operations are the same. Successive calls continue
+    where the previous call left off in the key stream.
+
+Arguments:
+
+    Context - Supplies a pointer to the initialized context.
+
+    Input - Supplies an optional pointer to the data to encrypt. If NULL, the
+        raw key stream is written to the output.
+
+    Output - Supplies a pointer where the encrypted data will be returned.
+        This may be the same as the input buffer.
+
+    Size - Supplies the number of bytes to process.
+
+Return Value:
+
+    None.
+
+--*/
+
 CRYPTO_API
 KSTATUS
 CyRsaInitializeContext (
@@ -40,6 +40,12 @@ Module Name:
 
 #define LZMA_MINIMUM_DICT_SIZE (1 << 12)
 
+//
+// Define the number of bytes of encoded properties at the start of a stream.
+//
+
+#define LZMA_PROPERTIES_SIZE 5
+
 //
 // Define the magic value at the top of the file format.
 //
@@ -49,6 +55,46 @@ Module Name:
 
 #define LZMA_HEADER_SIZE (LZMA_HEADER_MAGIC_SIZE + LZMA_PROPERTIES_SIZE)
 
+//
+// Define the size of the footer at the end of the file format, containing the
+// 64-bit uncompressed size, the compressed CRC32, and the uncompressed CRC32.
+//
+
+#define LZMA_FOOTER_SIZE 16
+
+//
+// Define the magic value at the top of a block stream. A block stream has the
+// same header as a regular file (but with this magic), followed by a series of
+// independently compressed blocks, each preceded by a block header. A block
+// header with a compressed size of zero terminates the series, and is
+// followed by the same footer a regular file has. Since the blocks share no
+// state, they can be compressed and decompressed in parallel.
+//
+
+#define LZMA_BLOCK_HEADER_MAGIC 0x424D5A4C
+
+//
+// Define the size of the header preceding each block in a block stream. It
+// contains the compressed size, uncompressed size, compressed CRC32, and
+// uncompressed CRC32 of the block, in that order, as 32-bit values.
+//
+
+#define LZMA_BLOCK_HEADER_SIZE 16
+
+//
+// Define the largest uncompressed size of a single block.
+//
+
+#define LZMA_MAX_BLOCK_SIZE (1UL << 30)
+
+//
+// This macro evaluates to the largest size a block with the given uncompressed
+// size can occupy once compressed, including its block header.
+//
+
+#define LZMA_BLOCK_BOUND(_Size) \
+    ((_Size) + ((_Size) / 3) + 128 + LZMA_BLOCK_HEADER_SIZE)
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -291,7 +337,9 @@ Structure Description:
         The default is TRUE.
 
     ThreadCount - Stores the thread count to use while encoding. Valid values
-        are 1 and 2. The default is 2.
+        are 1 and 2. The default is 2. A single stream is always encoded on
+        the calling thread; to compress on more threads, split the input into
+        a block stream and compress each block with LzLzmaCompressBlock.
 
 --*/
 
@@ -422,6 +470,124 @@ Return Value:
 
 --*/
 
+LZ_STATUS
+LzLzmaInitializeBlockEncoder (
+    PLZ_CONTEXT Context,
+    PLZMA_ENCODER_PROPERTIES Properties
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes a given LZ context for writing a block stream, and
+    writes out the stream header. Blocks are compressed separately with
+    LzLzmaCompressBlock and then added to the stream in order with
+    LzLzmaWriteBlock. This routine must be called before any blocks are
+    compressed.
+
+Arguments:
+
+    Context - Supplies a pointer to the context, which should already be
+        initialized by the user. If the write function is not supplied,
+        output goes to the output buffer.
+
+    Properties - Supplies a pointer to the properties that each block will be
+        compressed with.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+LZ_STATUS
+LzLzmaCompressBlock (
+    PLZ_CONTEXT Context,
+    PLZMA_ENCODER_PROPERTIES Properties
+    );
+
+/*++
+
+Routine Description:
+
+    This routine compresses the entire input buffer of the given context into
+    a single block, complete with its block header, in the output buffer. The
+    read and write functions are not used. Different contexts can compress
+    blocks concurrently.
+
+Arguments:
+
+    Context - Supplies a pointer to the context. Only the reallocate routine
+        and the input and output buffers need to be set up. The output buffer
+        should be at least LZMA_BLOCK_BOUND(InputSize) bytes. On success, the
+        input and output pointers and sizes are advanced.
+
+    Properties - Supplies a pointer to the properties to compress with. These
+        should be the same properties used to initialize the block encoder.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+LZ_STATUS
+LzLzmaWriteBlock (
+    PLZ_CONTEXT Context,
+    PCVOID Block,
+    UINTN Size
+    );
+
+/*++
+
+Routine Description:
+
+    This routine appends a block created by LzLzmaCompressBlock to a block
+    stream.
+
+Arguments:
+
+    Context - Supplies a pointer to the context initialized with
+        LzLzmaInitializeBlockEncoder.
+
+    Block - Supplies a pointer to the compressed block, starting with its block
+        header.
+
+    Size - Supplies the size of the compressed block in bytes, including the
+        block header.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+LZ_STATUS
+LzLzmaFinishBlockEncoder (
+    PLZ_CONTEXT Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine terminates a block stream, writing the final block header
+    and the file footer.
+
+Arguments:
+
+    Context - Supplies a pointer to the context initialized with
+        LzLzmaInitializeBlockEncoder.
+
+Return Value:
+
+    LzStreamComplete on success.
+
+    Other LZ Status codes on failure.
+
+--*/
+
 LZ_STATUS
 LzLzmaInitializeDecoder (
     PLZ_CONTEXT Context,
@@ -501,3 +667,128 @@ Return Value:
 
 --*/
 
+LZ_STATUS
+LzLzmaInitializeBlockDecoder (
+    PLZ_CONTEXT Context,
+    PCVOID Header
+    );
+
+/*++
+
+Routine Description:
+
+    This routine initializes a given LZ context for validating a block stream
+    whose blocks are decompressed separately with LzLzmaDecompressBlock. The
+    caller reads the stream itself, handing each block header to
+    LzLzmaReadBlockHeader and the footer to LzLzmaFinishBlockDecoder.
+
+Arguments:
+
+    Context - Supplies a pointer to the context. Only the reallocate routine
+        is used.
+
+    Header - Supplies a pointer to the LZMA_HEADER_SIZE byte stream header.
+
+Return Value:
+
+    LzErrorMagic if the header is not the start of a block stream.
+
+    Other LZ Status codes.
+
+--*/
+
+LZ_STATUS
+LzLzmaReadBlockHeader (
+    PLZ_CONTEXT Context,
+    PCVOID BlockHeader,
+    PUINTN CompressedSize,
+    PUINTN UncompressedSize
+    );
+
+/*++
+
+Routine Description:
+
+    This routine validates the next block header in a block stream and adds
+    the block to the running stream sizes and CRCs.
+
+Arguments:
+
+    Context - Supplies a pointer to the context initialized with
+        LzLzmaInitializeBlockDecoder.
+
+    BlockHeader - Supplies a pointer to the LZMA_BLOCK_HEADER_SIZE byte block
+        header.
+
+    CompressedSize - Supplies a pointer where the size of the compressed data
+        following the block header will be returned. Zero is returned for the
+        header that terminates the stream.
+
+    UncompressedSize - Supplies a pointer where the size of the block once
+        decompressed will be returned.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+LZ_STATUS
+LzLzmaDecompressBlock (
+    PLZ_CONTEXT Context,
+    PCVOID Header
+    );
+
+/*++
+
+Routine Description:
+
+    This routine decompresses a single block of a block stream, verifying its
+    sizes and CRCs. The read and write functions are not used. Different
+    contexts can decompress blocks concurrently.
+
+Arguments:
+
+    Context - Supplies a pointer to the context. Only the reallocate routine
+        and the input and output buffers need to be set up. The input should
+        start with the block header, and the output buffer must be large
+        enough to hold the entire decompressed block. On success, the input
+        and output pointers and sizes are advanced.
+
+    Header - Supplies a pointer to the LZMA_HEADER_SIZE byte stream header,
+        which contains the properties the blocks were compressed with.
+
+Return Value:
+
+    LZ Status code.
+
+--*/
+
+LZ_STATUS
+LzLzmaFinishBlockDecoder (
+    PLZ_CONTEXT Context,
+    PCVOID Footer
+    );
+
+/*++
+
+Routine Description:
+
+    This routine validates the footer of a block stream against the running
+    sizes and CRCs.
+
+Arguments:
+
+    Context - Supplies a pointer to the context initialized with
+        LzLzmaInitializeBlockDecoder.
+
+    Footer - Supplies a pointer to the LZMA_FOOTER_SIZE byte footer.
+
+Return Value:
+
+    LzStreamComplete on success.
+
+    Other LZ Status codes on failure.
+
+--*/
+
@@ -2481,6 +2481,134 @@ Return Value:
 
 --*/
 
+OS_API
+KSTATUS
+OsGetRandomBytes (
+    PVOID Buffer,
+    PUINTN Size
+    );
+
+/*++
+
+Routine Description:
+
+    This routine fills a buffer with random bytes from the kernel's random
+    number generators. This does not go through the random device, so it
+    works without a file system or any free handles.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the buffer to fill.
+
+    Size - Supplies a pointer that on input contains the number of bytes
+        requested. On output, contains the number of bytes written, which is
+        less than requested if the request was larger than
+        SYS_RANDOM_MAX_SIZE.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsCreateWatchQueue (
+    ULONG OpenFlags,
+    PHANDLE Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new file watch queue, which returns events
+    describing changes to the files and directories it watches when read.
+
+Arguments:
+
+    OpenFlags - Supplies the open flags for the queue handle. Only
+        SYS_OPEN_FLAG_CLOSE_ON_EXECUTE and SYS_OPEN_FLAG_NON_BLOCKING are
+        accepted.
+
+    Handle - Supplies a pointer where the handle to the queue will be returned
+        on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsAddWatch (
+    HANDLE Queue,
+    HANDLE Directory,
+    PCSTR Path,
+    ULONG PathLength,
+    ULONG Events,
+    PLONG Descriptor
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds a watch on a file or directory to a file watch queue. If
+    the queue already watches the file, its existing watch is updated.
+
+Arguments:
+
+    Queue - Supplies the handle to the watch queue.
+
+    Directory - Supplies an optional handle to a directory to start path
+        traversal from if the path is relative. Supply INVALID_HANDLE to use
+        the current working directory.
+
+    Path - Supplies a pointer to the path of the file or directory to watch.
+
+    PathLength - Supplies the length of the path buffer in bytes, including the
+        null terminator.
+
+    Events - Supplies the bitmask of events to watch for, combined with any
+        flags. See FILE_WATCH_EVENT_* and FILE_WATCH_FLAG_* definitions.
+
+    Descriptor - Supplies a pointer where the descriptor identifying the watch
+        in its events will be returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+OS_API
+KSTATUS
+OsRemoveWatch (
+    HANDLE Queue,
+    LONG Descriptor
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes a watch from a file watch queue. A final event with
+    FILE_WATCH_EVENT_IGNORED set is queued for the watch.
+
+Arguments:
+
+    Queue - Supplies the handle to the watch queue.
+
+    Descriptor - Supplies the descriptor of the watch to remove.
+
+Return Value:
+
+    Status code.
+
+--*/
+
 OS_API
 PVOID
 OsHeapAllocate (
@@ -2998,6 +3126,42 @@ Return Value:
 
 --*/
 
+OS_API
+KSTATUS
+OsSocketPerformBatchIo (
+    HANDLE Socket,
+    ULONG IoFlags,
+    PSOCKET_IO_MESSAGE Messages,
+    PUINTN MessageCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sends or receives several messages on a socket in a single
+    system call.
+
+Arguments:
+
+    Socket - Supplies the socket handle.
+
+    IoFlags - Supplies the I/O flags for the batch. Set SYS_IO_FLAG_WRITE to
+        send the messages, or leave it clear to receive them.
+
+    Messages - Supplies an array of messages to send or receive. The
+        parameters for each completed message are updated on return.
+
+    MessageCount - Supplies a pointer that on input contains the number of
+        messages in the array. On output, returns the number of messages that
+        were completed.
+
+Return Value:
+
+    Status code. If any messages were completed, success is returned.
+
+--*/
+
 OS_API
 KSTATUS
 OsSocketGetSetInformation (
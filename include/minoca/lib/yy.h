@@ -363,6 +363,8 @@ typedef struct _YY_PARSER {
 // Lexer definitions
 //
 
+typedef struct _YY_LEX_TABLE YY_LEX_TABLE, *PYY_LEX_TABLE;
+
 /*++
 
 Structure Description:
@@ -414,6 +416,10 @@ Structure Description:
     TokenBase - Stores the value to assign for the first expression. 512 is
         usually a good value, as it won't alias with the literal characters.
 
+    Table - Stores an optional pointer to the compiled form of the expressions
+        and ignore expressions, created with YyLexCompile. If this is NULL, the
+        expressions are interpreted directly for each token.
+
 --*/
 
 typedef struct _LEXER {
@@ -431,6 +437,7 @@ typedef struct _LEXER {
     PSTR *IgnoreExpressions;
     PSTR *ExpressionNames;
     ULONG TokenBase;
+    PYY_LEX_TABLE Table;
 } LEXER, *PLEXER;
 
 /*++
@@ -840,6 +847,80 @@ Return Value:
 
 --*/
 
+YY_API
+KSTATUS
+YyLexCompile (
+    PLEXER Lexer,
+    PYY_REALLOCATE Reallocate,
+    PVOID Context,
+    PYY_LEX_TABLE *Table
+    );
+
+/*++
+
+Routine Description:
+
+    This routine compiles the expressions and ignore expressions of the given
+    lexer into a single deterministic state machine for each set, so that
+    tokens can be matched in one pass over the input rather than by trying
+    every expression in turn. Expressions using constructs that the state
+    machine cannot represent exactly are left to the expression interpreter.
+    The resulting table can be shared by any number of lexers using the same
+    expressions, and is attached by setting the table member of the lexer.
+
+Arguments:
+
+    Lexer - Supplies a pointer to a lexer whose expressions and ignore
+        expressions are filled in.
+
+    Reallocate - Supplies a pointer to the function used to allocate and free
+        memory.
+
+    Context - Supplies the context pointer to pass to the reallocate function.
+
+    Table - Supplies a pointer where a pointer to the compiled table will be
+        returned on success.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+
+    STATUS_NOT_SUPPORTED if the state machine grew too large. The lexer works
+    correctly without a table in this case.
+
+--*/
+
+YY_API
+VOID
+YyLexDestroyTable (
+    PYY_LEX_TABLE Table,
+    PYY_REALLOCATE Reallocate,
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine destroys a compiled lexer table.
+
+Arguments:
+
+    Table - Supplies a pointer to the table to destroy.
+
+    Reallocate - Supplies a pointer to the function used to allocate and free
+        memory.
+
+    Context - Supplies the context pointer to pass to the reallocate function.
+
+Return Value:
+
+    None.
+
+--*/
+
 //
 // Parser functions
 //
@@ -149,7 +149,7 @@ Module Name:
 // Define the current version number of the net link properties structure.
 //
 
-#define NET_LINK_PROPERTIES_VERSION 1
+#define NET_LINK_PROPERTIES_VERSION 2
 
 //
 // Define some common network link speeds.
@@ -288,6 +288,37 @@ Module Name:
 #define NET_PROTOCOL_FLAG_NO_BIND_PERMISSIONS 0x00000020
 #define NET_PROTOCOL_FLAG_CONNECTION_BASED    0x00000040
 
+//
+// Define the route flags.
+//
+
+//
+// This flag is set if the route sends traffic through a gateway rather than
+// directly to the destination.
+//
+
+#define NET_ROUTE_FLAG_GATEWAY   0x00000001
+
+//
+// This flag is set if the route was created automatically when a link
+// address was configured, rather than being added explicitly.
+//
+
+#define NET_ROUTE_FLAG_AUTOMATIC 0x00000002
+
+//
+// This flag is set once the route has been removed from its routing table.
+// Holders of a reference should look up a fresh route.
+//
+
+#define NET_ROUTE_FLAG_DELETED   0x00000004
+
+//
+// Define the metric given to routes that are created automatically.
+//
+
+#define NET_ROUTE_DEFAULT_METRIC 100
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -323,9 +354,77 @@ typedef enum _NET_LINK_ADDRESS_STATE {
     NetLinkAddressConfiguredStatic
 } NET_LINK_ADDRESS_STATE, *PNET_LINK_ADDRESS_STATE;
 
+//
+// Define the system-wide protocol statistics counters. These are patterned
+// after the SNMP MIB-II counters. User mode sees these values as an array of
+// 64-bit counters indexed by this enum, so only ever add to the end of each
+// group and never reorder.
+//
+
+typedef enum _NET_STATISTIC {
+    NetStatisticIp4InReceives,
+    NetStatisticIp4InHeaderErrors,
+    NetStatisticIp4InUnknownProtocols,
+    NetStatisticIp4InDelivers,
+    NetStatisticIp4OutRequests,
+    NetStatisticIp4ReassemblyRequired,
+    NetStatisticIp4ReassemblyOk,
+    NetStatisticIp4ReassemblyFailures,
+    NetStatisticIp4FragmentsOk,
+    NetStatisticIp4FragmentsCreated,
+    NetStatisticIp6InReceives,
+    NetStatisticIp6InHeaderErrors,
+    NetStatisticIp6InUnknownProtocols,
+    NetStatisticIp6InDelivers,
+    NetStatisticIp6OutRequests,
+    NetStatisticTcpActiveOpens,
+    NetStatisticTcpPassiveOpens,
+    NetStatisticTcpAttemptFailures,
+    NetStatisticTcpEstablishedResets,
+    NetStatisticTcpInSegments,
+    NetStatisticTcpOutSegments,
+    NetStatisticTcpRetransmittedSegments,
+    NetStatisticTcpOutOfOrderSegments,
+    NetStatisticTcpInErrors,
+    NetStatisticTcpInChecksumErrors,
+    NetStatisticTcpOutResets,
+    NetStatisticUdpInDatagrams,
+    NetStatisticUdpNoPorts,
+    NetStatisticUdpInErrors,
+    NetStatisticUdpInChecksumErrors,
+    NetStatisticUdpReceiveBufferErrors,
+    NetStatisticUdpOutDatagrams,
+    NetStatisticArpInRequests,
+    NetStatisticArpInReplies,
+    NetStatisticArpOutRequests,
+    NetStatisticArpOutReplies,
+    NetStatisticNdpInSolicitations,
+    NetStatisticNdpInAdvertisements,
+    NetStatisticNdpOutSolicitations,
+    NetStatisticNdpOutAdvertisements,
+    NetStatisticCount
+} NET_STATISTIC, *PNET_STATISTIC;
+
+//
+// Define the per-link statistics counters.
+//
+
+typedef enum _NET_LINK_STATISTIC {
+    NetLinkStatisticReceivedPackets,
+    NetLinkStatisticReceivedBytes,
+    NetLinkStatisticReceiveDrops,
+    NetLinkStatisticTransmittedPackets,
+    NetLinkStatisticTransmittedBytes,
+    NetLinkStatisticTransmitErrors,
+    NetLinkStatisticTransmitDrops,
+    NetLinkStatisticCount
+} NET_LINK_STATISTIC, *PNET_LINK_STATISTIC;
+
 typedef struct _NET_PROTOCOL_ENTRY NET_PROTOCOL_ENTRY, *PNET_PROTOCOL_ENTRY;
 typedef struct _NET_NETWORK_ENTRY NET_NETWORK_ENTRY, *PNET_NETWORK_ENTRY;
 typedef struct _NET_RECEIVE_CONTEXT NET_RECEIVE_CONTEXT, *PNET_RECEIVE_CONTEXT;
+typedef struct _NET_SOCKET_HASH NET_SOCKET_HASH, *PNET_SOCKET_HASH;
+typedef struct _NET_ROUTE NET_ROUTE, *PNET_ROUTE;
 
 /*++
 
@@ -444,6 +543,10 @@ Structure Description:
         beginning of the footer data (ie the location to store the first byte
         of new footer).
 
+    FlowHash - Stores a hash of the addresses and ports of the flow the packet
+        belongs to, or zero if unknown. Multi-queue links use this to keep
+        every packet of a flow on the same transmit queue.
+
 --*/
 
 typedef struct _NET_PACKET_BUFFER {
@@ -456,6 +559,7 @@ typedef struct _NET_PACKET_BUFFER {
     ULONG DataSize;
     ULONG DataOffset;
     ULONG FooterOffset;
+    ULONG FlowHash;
 } NET_PACKET_BUFFER, *PNET_PACKET_BUFFER;
 
 /*++
@@ -638,6 +742,12 @@ Structure Description:
     Interface - Stores the list of functions used by the core networking
         library to call into the link.
 
+    QueueCount - Stores the number of transmit and receive queue pairs the
+        device is using. Zero is treated as one. Devices with more than one
+        queue pick a transmit queue for each packet with
+        NetSelectTransmitQueue and bind each queue's receive processing to the
+        processor returned by NetGetQueueProcessorSet.
+
 --*/
 
 typedef struct _NET_LINK_PROPERTIES {
@@ -651,6 +761,7 @@ typedef struct _NET_LINK_PROPERTIES {
     PHYSICAL_ADDRESS MaxPhysicalAddress;
     NETWORK_ADDRESS PhysicalAddress;
     NET_DEVICE_LINK_INTERFACE Interface;
+    ULONG QueueCount;
 } NET_LINK_PROPERTIES, *PNET_LINK_PROPERTIES;
 
 /*++
@@ -728,6 +839,10 @@ Structure Description:
     MulticastGroupList - Stores a list of the multicast groups to which this
         link belongs.
 
+    Statistics - Stores a pointer to the link's per-processor statistics
+        counters. Use the statistics routines rather than touching these
+        directly.
+
 --*/
 
 typedef struct _NET_LINK {
@@ -743,8 +858,35 @@ typedef struct _NET_LINK {
     PKEVENT AddressTranslationEvent;
     RED_BLACK_TREE AddressTranslationTree;
     LIST_ENTRY MulticastGroupList;
+    PULONGLONG Statistics;
 } NET_LINK, *PNET_LINK;
 
+typedef
+VOID
+(*PNET_LINK_ENUMERATION_ROUTINE) (
+    PNET_LINK Link,
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called once for each network link in the system. The link
+    list is locked while the routine runs, so it must not add or remove links.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+    Context - Supplies the context pointer handed to the enumeration.
+
+Return Value:
+
+    None.
+
+--*/
+
 typedef
 KSTATUS
 (*PNET_DATA_LINK_INITIALIZE_LINK) (
@@ -1113,6 +1255,83 @@ typedef struct _NET_LINK_LOCAL_ADDRESS {
 
 /*++
 
+Structure Description:
+
+    This structure defines a route in one of the routing tables. Once a route
+    is created, only its flags ever change.
+
+Members:
+
+    ListEntry - Stores pointers to the next and previous routes for the same
+        destination prefix, sorted by metric. This is internal to the core
+        networking library.
+
+    ReferenceCount - Stores the reference count of the route.
+
+    Flags - Stores a bitmask of route flags. See NET_ROUTE_FLAG_* for
+        definitions.
+
+    Destination - Stores the destination prefix of the route. Any bits beyond
+        the prefix length are zero.
+
+    PrefixLength - Stores the number of significant bits in the destination.
+        A prefix length of zero describes a default route.
+
+    Gateway - Stores the address of the gateway to send packets through, if
+        the gateway flag is set.
+
+    Link - Stores a pointer to the link packets following this route are sent
+        out of. The route holds a reference on the link.
+
+    LinkAddress - Stores an optional pointer to the link address entry to send
+        from. If this is NULL, any configured address on the link is used.
+        This is only valid while the route is in its table.
+
+    Metric - Stores the cost of the route. Among routes to the same prefix,
+        the lowest metric route that is usable wins.
+
+--*/
+
+struct _NET_ROUTE {
+    LIST_ENTRY ListEntry;
+    volatile ULONG ReferenceCount;
+    volatile ULONG Flags;
+    NETWORK_ADDRESS Destination;
+    ULONG PrefixLength;
+    NETWORK_ADDRESS Gateway;
+    PNET_LINK Link;
+    PNET_LINK_ADDRESS_ENTRY LinkAddress;
+    ULONG Metric;
+};
+
+typedef
+VOID
+(*PNET_ROUTE_ENUMERATION_ROUTINE) (
+    PNET_ROUTE Route,
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called once for each route in a routing table. The table
+    is locked while the routine runs, so it must not add or remove routes.
+
+Arguments:
+
+    Route - Supplies a pointer to the route.
+
+    Context - Supplies the context pointer handed to the enumeration.
+
+Return Value:
+
+    None.
+
+--*/
+
+/*++
+
 Structure Description:
 
     This structure defines a multicast group join/leave request.
@@ -1227,6 +1446,17 @@ Structure Description:
     TreeEntry - Stores the information about this socket in the tree of
         sockets (which is either on the link itself or global).
 
+    HashEntry - Stores pointers to the next and previous sockets in the
+        protocol's socket hash bucket, used to find the socket when packets
+        arrive.
+
+    HashBucket - Stores a pointer to the socket hash bucket the socket is
+        currently on, or NULL if it is not on one. This is internal to the
+        core networking library.
+
+    Route - Stores an optional pointer to the route fully bound sockets use to
+        reach their remote address. The socket holds a reference on it.
+
     BindingType - Stores the type of binding for this socket (unbound, locally
         bound, or fully bound).
 
@@ -1285,6 +1515,9 @@ typedef struct _NET_SOCKET {
     NETWORK_ADDRESS RemotePhysicalAddress;
     PNET_TRANSLATION_ENTRY RemoteTranslation;
     RED_BLACK_TREE_NODE TreeEntry;
+    LIST_ENTRY HashEntry;
+    PVOID HashBucket;
+    PNET_ROUTE Route;
     NET_SOCKET_BINDING_TYPE BindingType;
     volatile ULONG Flags;
     NET_PACKET_SIZE_INFORMATION PacketSizeInformation;
@@ -1839,13 +2072,17 @@ Structure Description:
     Flags - Stores a bitmask of protocol flags. See NET_PROTOCOL_FLAG_* for
         definitions.
 
-    LastSocket - Stores a pointer to the last socket that received a packet.
+    SocketHash - Stores a pointer to the hash tables used to find the socket
+        for a unicast packet, used internally by the core networking library.
+        Protocols should initialize this to NULL.
 
     SocketLock - Stores a pointer to a shared exclusive lock that protects the
-        socket trees.
+        socket trees. Changes to the socket hash are also made with this lock
+        held exclusively.
 
     SocketTree - Stores an array of Red Black Trees, one each for fully bound,
-        locally bound, and unbound sockets.
+        locally bound, and unbound sockets. These are used for binding and for
+        finding every socket that matches a broadcast or multicast packet.
 
     Interface - Stores the interface presented to the kernel for this type of
         socket.
@@ -1857,7 +2094,7 @@ struct _NET_PROTOCOL_ENTRY {
     NET_SOCKET_TYPE Type;
     ULONG ParentProtocolNumber;
     ULONG Flags;
-    volatile PNET_SOCKET LastSocket;
+    PNET_SOCKET_HASH SocketHash;
     PSHARED_EXCLUSIVE_LOCK SocketLock;
     RED_BLACK_TREE SocketTree[SocketBindingTypeCount];
     NET_PROTOCOL_INTERFACE Interface;
@@ -3065,6 +3302,92 @@ Return Value:
 
 --*/
 
+NET_API
+ULONG
+NetComputeFlowHash (
+    PNETWORK_ADDRESS Source,
+    PNETWORK_ADDRESS Destination
+    );
+
+/*++
+
+Routine Description:
+
+    This routine computes the flow hash for packets traveling between the
+    given addresses and ports.
+
+Arguments:
+
+    Source - Supplies a pointer to the source address and port of the flow.
+
+    Destination - Supplies a pointer to the destination address and port of
+        the flow.
+
+Return Value:
+
+    Returns the flow hash.
+
+--*/
+
+NET_API
+ULONG
+NetSelectTransmitQueue (
+    PNET_LINK Link,
+    PNET_PACKET_BUFFER Packet
+    );
+
+/*++
+
+Routine Description:
+
+    This routine selects the transmit queue a packet should be sent on for a
+    multi-queue link. Packets of the same flow always land on the same queue,
+    so they are never reordered with respect to each other.
+
+Arguments:
+
+    Link - Supplies a pointer to the link the packet is being sent on.
+
+    Packet - Supplies a pointer to the packet being sent.
+
+Return Value:
+
+    Returns the zero-based index of the transmit queue to use.
+
+--*/
+
+NET_API
+VOID
+NetGetQueueProcessorSet (
+    PNET_LINK Link,
+    ULONG QueueIndex,
+    PPROCESSOR_SET ProcessorSet
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the processor a multi-queue link should direct the
+    given queue's interrupts to. Queues are spread round robin across the
+    active processors so that receive processing for different flows runs in
+    parallel.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+    QueueIndex - Supplies the zero-based index of the queue.
+
+    ProcessorSet - Supplies a pointer where the target processor set is
+        returned.
+
+Return Value:
+
+    None.
+
+--*/
+
 NET_API
 KSTATUS
 NetFindLinkForLocalAddress (
@@ -3131,6 +3454,347 @@ Return Value:
 
 --*/
 
+NET_API
+KSTATUS
+NetAddRoute (
+    PNET_LINK Link,
+    PNET_LINK_ADDRESS_ENTRY LinkAddress,
+    PNETWORK_ADDRESS Destination,
+    ULONG PrefixLength,
+    PNETWORK_ADDRESS Gateway,
+    ULONG Metric,
+    ULONG Flags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds a route to the routing table for the destination's
+    domain.
+
+Arguments:
+
+    Link - Supplies a pointer to the link packets following the route leave
+        through.
+
+    LinkAddress - Supplies an optional pointer to the link address entry
+        packets following the route are sent from. If NULL, any configured
+        address on the link is used.
+
+    Destination - Supplies a pointer to the destination prefix.
+
+    PrefixLength - Supplies the number of significant bits in the destination.
+        Supply zero to create a default route.
+
+    Gateway - Supplies an optional pointer to the gateway to send packets
+        through. If NULL, destinations are assumed to be directly reachable
+        on the link.
+
+    Metric - Supplies the cost of the route. Lower metrics are preferred.
+
+    Flags - Supplies a bitmask of route flags. See NET_ROUTE_FLAG_* for
+        definitions. The gateway flag is derived from the gateway parameter.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_NOT_SUPPORTED if the domain has no routing table.
+
+    STATUS_INVALID_PARAMETER if the prefix length is too long.
+
+    STATUS_DUPLICATE_ENTRY if an identical route already exists.
+
+    STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+
+--*/
+
+NET_API
+KSTATUS
+NetRemoveRoute (
+    PNETWORK_ADDRESS Destination,
+    ULONG PrefixLength,
+    PNETWORK_ADDRESS Gateway,
+    PNET_LINK Link
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes routes from the routing table for the destination's
+    domain.
+
+Arguments:
+
+    Destination - Supplies a pointer to the destination prefix to remove.
+
+    PrefixLength - Supplies the number of significant bits in the destination.
+
+    Gateway - Supplies an optional pointer to the gateway of the route to
+        remove. If NULL, routes to the prefix through any gateway are removed.
+
+    Link - Supplies an optional pointer to the link of the route to remove. If
+        NULL, routes to the prefix over any link are removed.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one route was removed.
+
+    STATUS_NOT_FOUND if no routes matched.
+
+--*/
+
+NET_API
+KSTATUS
+NetLookupRoute (
+    PNETWORK_ADDRESS Destination,
+    PNET_ROUTE *Route
+    );
+
+/*++
+
+Routine Description:
+
+    This routine finds the best usable route to the given destination: the
+    lowest metric route of the longest matching prefix whose link is up and
+    has a configured address.
+
+Arguments:
+
+    Destination - Supplies a pointer to the destination address.
+
+    Route - Supplies a pointer where a pointer to the route will be returned
+        on success. The caller is responsible for releasing the reference
+        taken on the route.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_DESTINATION_UNREACHABLE if no usable route exists.
+
+--*/
+
+NET_API
+KSTATUS
+NetEnumerateRoutes (
+    NET_DOMAIN_TYPE Domain,
+    PNET_ROUTE_ENUMERATION_ROUTINE Routine,
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine calls the given routine for each route in a routing table.
+
+Arguments:
+
+    Domain - Supplies the network domain whose routes should be enumerated.
+
+    Routine - Supplies a pointer to the routine to call for each route.
+
+    Context - Supplies a context pointer to pass to the routine.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_NOT_SUPPORTED if the domain has no routing table.
+
+--*/
+
+NET_API
+VOID
+NetRouteAddReference (
+    PNET_ROUTE Route
+    );
+
+/*++
+
+Routine Description:
+
+    This routine increases the reference count on a route.
+
+Arguments:
+
+    Route - Supplies a pointer to the route.
+
+Return Value:
+
+    None.
+
+--*/
+
+NET_API
+VOID
+NetRouteReleaseReference (
+    PNET_ROUTE Route
+    );
+
+/*++
+
+Routine Description:
+
+    This routine decreases the reference count on a route, destroying it if
+    the count drops to zero.
+
+Arguments:
+
+    Route - Supplies a pointer to the route.
+
+Return Value:
+
+    None.
+
+--*/
+
+NET_API
+VOID
+NetEnumerateLinks (
+    PNET_LINK_ENUMERATION_ROUTINE Routine,
+    PVOID Context
+    );
+
+/*++
+
+Routine Description:
+
+    This routine calls the given routine for each network link in the system.
+
+Arguments:
+
+    Routine - Supplies a pointer to the routine to call for each link.
+
+    Context - Supplies a context pointer to pass to the routine.
+
+Return Value:
+
+    None.
+
+--*/
+
+NET_API
+VOID
+NetAddStatistic (
+    NET_STATISTIC Statistic,
+    ULONGLONG Value
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds to one of the system-wide network statistics counters.
+    The counters are kept per processor, so this is cheap and lock free, and
+    can be called at any run level.
+
+Arguments:
+
+    Statistic - Supplies the counter to add to.
+
+    Value - Supplies the amount to add.
+
+Return Value:
+
+    None.
+
+--*/
+
+NET_API
+VOID
+NetAddLinkStatistic (
+    PNET_LINK Link,
+    NET_LINK_STATISTIC Statistic,
+    ULONGLONG Value
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds to one of a link's statistics counters. The counters are
+    kept per processor, so this is cheap and lock free, and can be called at
+    any run level.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+    Statistic - Supplies the counter to add to.
+
+    Value - Supplies the amount to add.
+
+Return Value:
+
+    None.
+
+--*/
+
+NET_API
+VOID
+NetGetStatistics (
+    PULONGLONG Values,
+    ULONG Count
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sums the system-wide network statistics across all
+    processors. The result is not an atomic snapshot, as counters may be
+    updated while they are being read.
+
+Arguments:
+
+    Values - Supplies a pointer to an array that receives the counter values,
+        indexed by NET_STATISTIC.
+
+    Count - Supplies the number of elements in the array. Counters beyond the
+        array are not returned, and array elements beyond the last counter are
+        set to zero.
+
+Return Value:
+
+    None.
+
+--*/
+
+NET_API
+VOID
+NetGetLinkStatistics (
+    PNET_LINK Link,
+    PULONGLONG Values,
+    ULONG Count
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sums a link's statistics counters across all processors.
+
+Arguments:
+
+    Link - Supplies a pointer to the link.
+
+    Values - Supplies a pointer to an array that receives the counter values,
+        indexed by NET_LINK_STATISTIC.
+
+    Count - Supplies the number of elements in the array. Counters beyond the
+        array are not returned, and array elements beyond the last counter are
+        set to zero.
+
+Return Value:
+
+    None.
+
+--*/
+
 NET_API
 KSTATUS
 NetLookupLinkByDevice (
@@ -209,6 +209,8 @@ Module Name:
 
 #define NETLINK_GENERIC_CONTROL_NAME "nlctrl"
 #define NETLINK_GENERIC_80211_NAME   "nl80211"
+#define NETLINK_GENERIC_ROUTE_NAME   "nlroute"
+#define NETLINK_GENERIC_STATISTICS_NAME "nlstats"
 
 //
 // Define the generic control command values.
@@ -293,6 +295,44 @@ Module Name:
 
 #define NETLINK_80211_MULTICAST_SCAN_NAME "scan"
 
+//
+// Define the generic route command values.
+//
+
+#define NETLINK_ROUTE_COMMAND_ADD 1
+#define NETLINK_ROUTE_COMMAND_DELETE 2
+#define NETLINK_ROUTE_COMMAND_GET 3
+#define NETLINK_ROUTE_COMMAND_MAX 255
+
+//
+// Define the generic route attributes. Addresses are passed as full
+// NETWORK_ADDRESS structures.
+//
+
+#define NETLINK_ROUTE_ATTRIBUTE_DEVICE_ID 1
+#define NETLINK_ROUTE_ATTRIBUTE_DESTINATION 2
+#define NETLINK_ROUTE_ATTRIBUTE_PREFIX_LENGTH 3
+#define NETLINK_ROUTE_ATTRIBUTE_GATEWAY 4
+#define NETLINK_ROUTE_ATTRIBUTE_METRIC 5
+#define NETLINK_ROUTE_ATTRIBUTE_FLAGS 6
+
+//
+// Define the generic statistics command values.
+//
+
+#define NETLINK_STATISTICS_COMMAND_GET 1
+#define NETLINK_STATISTICS_COMMAND_MAX 255
+
+//
+// Define the generic statistics attributes. The global and link attributes
+// are arrays of 64-bit counters indexed by NET_STATISTIC and
+// NET_LINK_STATISTIC respectively. Newer kernels may return longer arrays.
+//
+
+#define NETLINK_STATISTICS_ATTRIBUTE_GLOBAL 1
+#define NETLINK_STATISTICS_ATTRIBUTE_DEVICE_ID 2
+#define NETLINK_STATISTICS_ATTRIBUTE_LINK 3
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
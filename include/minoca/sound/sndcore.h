@@ -71,6 +71,7 @@ typedef struct _SOUND_DEVICE_HANDLE SOUND_DEVICE_HANDLE, *PSOUND_DEVICE_HANDLE;
 typedef enum _SOUND_DEVICE_INFORMATION_TYPE {
     SoundDeviceInformationState,
     SoundDeviceInformationVolume,
+    SoundDeviceInformationPosition,
 } SOUND_DEVICE_INFORMATION_TYPE, *PSOUND_DEVICE_INFORMATION_TYPE;
 
 typedef enum _SOUND_DEVICE_STATE {
@@ -133,6 +134,14 @@ Structure Description:
     FragmentsCompleted - Stores the total fragments that had been process by
         the device by the last time the buffer position information was queried.
 
+    MmapStatus - Stores an optional pointer to the status page shared with a
+        user mode mapping of the device. This is owned by the sound core, which
+        updates it whenever the controller reports a new offset.
+
+    FragmentEvent - Stores an optional pointer to an event that the sound core
+        signals each time the controller reports a new offset. It exists
+        whenever the status page does.
+
 --*/
 
 typedef struct _SOUND_IO_BUFFER {
@@ -148,6 +157,8 @@ typedef struct _SOUND_IO_BUFFER {
     volatile UINTN BytesAvailable;
     volatile UINTN BytesCompleted;
     volatile UINTN FragmentsCompleted;
+    PSOUND_MMAP_STATUS MmapStatus;
+    PKEVENT FragmentEvent;
 } SOUND_IO_BUFFER, *PSOUND_IO_BUFFER;
 
 /*++
@@ -502,7 +513,10 @@ Structure Description:
     FreeDmaBuffer - Stores a pointer to a function that destroys a DMA buffer.
 
     GetSetInformation - Stores a pointer to a function that gets and sets
-        sound device state.
+        sound device state. Getting SoundDeviceInformationPosition returns the
+        running device's current offset within its buffer as a UINTN, which
+        may fall between fragment boundaries. Controllers that can't report it
+        return STATUS_NOT_SUPPORTED.
 
 --*/
 
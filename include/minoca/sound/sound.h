@@ -133,6 +133,15 @@ Module Name:
 
 #define SOUND_ROUTE_NAME_SIZE 2048
 
+//
+// Define the file offset at which the status page is mapped. Mapping a sound
+// device at offset zero maps its DMA buffer. Mapping one page at this offset
+// maps a read-only SOUND_MMAP_STATUS structure that the device keeps up to
+// date as fragments complete.
+//
+
+#define SOUND_MMAP_STATUS_OFFSET 0x100000000ULL
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -174,6 +183,7 @@ typedef enum _SOUND_CONTROL {
     SoundSetSampleRate = 0x501D,
     SoundSetStereo = 0x501E,
     SoundEnableDevice = 0x501F,
+    SoundWaitForFragment = 0x5020,
 } SOUND_CONTROL, *PSOUND_CONTROL;
 
 /*++
@@ -233,6 +243,52 @@ typedef struct _SOUND_POSITION_INFORMATION {
 
 /*++
 
+Structure Description:
+
+    This structure describes the status page that can be mapped from a sound
+    device alongside its DMA buffer. The device updates it each time a
+    fragment completes, so a client that has mapped the buffer can find the
+    hardware position without a system call.
+
+Members:
+
+    Sequence - Stores a sequence number that is odd while the device is
+        updating the page. Readers should read it, read the other members,
+        and retry if the sequence number was odd or has changed.
+
+    Offset - Stores the offset of the hardware within the DMA buffer as of
+        the last completed fragment.
+
+    BufferSize - Stores the size of the DMA buffer, in bytes.
+
+    FragmentSize - Stores the size of each fragment, in bytes.
+
+    TotalBytes - Stores the total number of bytes processed by the device
+        since it was last reset.
+
+    FragmentCount - Stores the total number of fragments processed by the
+        device since it was last reset.
+
+    TimeCounter - Stores the value of the system time counter when the page
+        was last updated.
+
+    TimeCounterFrequency - Stores the frequency of the time counter, in Hz.
+
+--*/
+
+typedef struct _SOUND_MMAP_STATUS {
+    volatile ULONG Sequence;
+    ULONG Offset;
+    ULONG BufferSize;
+    ULONG FragmentSize;
+    ULONGLONG TotalBytes;
+    ULONGLONG FragmentCount;
+    ULONGLONG TimeCounter;
+    ULONGLONG TimeCounterFrequency;
+} SOUND_MMAP_STATUS, *PSOUND_MMAP_STATUS;
+
+/*++
+
 Structure Description:
 
     This structure defines a set of available routes that can be set for a
@@ -55,6 +55,12 @@ Module Name:
 #define GT_CONTROL_INTERRUPT_MASKED          0x00000002
 #define GT_CONTROL_TIMER_ENABLE              0x00000001
 
+//
+// Define the bits for the generic timer kernel control register.
+//
+
+#define GT_KERNEL_CONTROL_PL0_VIRTUAL_COUNT  0x00000002
+
 //
 // --------------------------------------------------------------------- Macros
 //
@@ -105,6 +111,16 @@ HlpGtGetVirtualCount (
     VOID
     );
 
+ULONG
+HlpGtGetKernelControl (
+    VOID
+    );
+
+VOID
+HlpGtSetKernelControl (
+    ULONG Control
+    );
+
 VOID
 HlpGtSetVirtualTimerCompare (
     ULONGLONG CompareValue
@@ -198,7 +214,8 @@ Return Value:
     Gt.Features = TIMER_FEATURE_ABSOLUTE |
                   TIMER_FEATURE_ONE_SHOT |
                   TIMER_FEATURE_READABLE |
-                  TIMER_FEATURE_PER_PROCESSOR;
+                  TIMER_FEATURE_PER_PROCESSOR |
+                  TIMER_FEATURE_USER_READABLE;
 
     Gt.CounterBitWidth = 64;
     Gt.CounterFrequency = Frequency;
@@ -257,11 +274,22 @@ Return Value:
 
 {
 
+    ULONG Control;
+
     //
     // The timer is already running, just make sure interrupts are off.
     //
 
     HlpGtSetVirtualTimerControl(0);
+
+    //
+    // Let user mode read the virtual count so it can get the time without a
+    // system call. The physical count and the timers stay kernel only.
+    //
+
+    Control = HlpGtGetKernelControl();
+    Control |= GT_KERNEL_CONTROL_PL0_VIRTUAL_COUNT;
+    HlpGtSetKernelControl(Control);
     return STATUS_SUCCESS;
 }
 
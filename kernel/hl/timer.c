@@ -261,6 +261,56 @@ Return Value:
     return HlProcessorCounter->CounterFrequency;
 }
 
+KERNEL_API
+BOOL
+HlQueryUserTimeCounter (
+    PULONGLONG Offset
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether user mode can compute the time counter by
+    reading the counter hardware directly. This is only possible if the time
+    counter is a full 64-bit, invariant counter that user mode has been
+    granted access to.
+
+Arguments:
+
+    Offset - Supplies a pointer where the value to add to the raw hardware
+        counter will be returned on success.
+
+Return Value:
+
+    TRUE if user mode can read the time counter directly.
+
+    FALSE if user mode must ask the kernel for the time counter.
+
+--*/
+
+{
+
+    PHARDWARE_TIMER Timer;
+
+    Timer = HlTimeCounter;
+    if ((Timer == NULL) ||
+        ((Timer->Features & TIMER_FEATURE_USER_READABLE) == 0) ||
+        ((Timer->Features & TIMER_FEATURE_VARIANT) != 0) ||
+        (Timer->CounterBitWidth < 64)) {
+
+        return FALSE;
+    }
+
+    //
+    // A 64-bit counter never takes a software rollover, so the offset set
+    // when the time counter was zeroed at boot is all user mode needs.
+    //
+
+    READ_INT64_SYNC(&(Timer->SoftwareOffset), Offset);
+    return TRUE;
+}
+
 KERNEL_API
 VOID
 HlBusySpin (
@@ -124,7 +124,8 @@ Return Value:
     TscTimer.Features = TIMER_FEATURE_PER_PROCESSOR |
                         TIMER_FEATURE_READABLE |
                         TIMER_FEATURE_WRITABLE |
-                        TIMER_FEATURE_PROCESSOR_COUNTER;
+                        TIMER_FEATURE_PROCESSOR_COUNTER |
+                        TIMER_FEATURE_USER_READABLE;
 
     //
     // Determine if the TSC varies with processor power management states.
@@ -72,7 +72,8 @@ function build() {
         "stream.c",
         "testhook.c",
         "unsocket.c",
-        "userio.c"
+        "userio.c",
+        "watch.c"
     ];
 
     if ((arch == "armv7") || (arch == "armv6")) {
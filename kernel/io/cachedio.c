@@ -2187,7 +2187,7 @@ Return Value:
 
         ASSERT(IS_DEVICE_OR_VOLUME(Device));
 
-        Status = IopSendIoIrp(Device, IrpMinorIoWrite, &Parameters);
+        Status = IopSendIoIrp(Device, IrpMinorIoWrite, &Parameters, NULL);
 
         //
         // Roll the I/O buffer's offset back to where it was before this I/O.
@@ -2400,7 +2400,7 @@ Return Value:
     Parameters.IoBytesCompleted = 0;
     Parameters.NewIoOffset = Parameters.IoOffset;
     Parameters.IoBuffer = AlignedIoBuffer;
-    Status = IopSendIoIrp(Device, IrpMinorIoWrite, &Parameters);
+    Status = IopSendIoIrp(Device, IrpMinorIoWrite, &Parameters, NULL);
 
     //
     // Determine how many of the bytes meant to be written were delivered.
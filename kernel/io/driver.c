@@ -109,6 +109,7 @@ Return Value:
 
 {
 
+    UINTN CopySize;
     KSTATUS Status;
 
     Status = STATUS_INVALID_PARAMETER;
@@ -122,12 +123,17 @@ Return Value:
 
     //
     // The driver seems to have filled out the correct fields. Save the
-    // function table in the driver structure.
+    // function table in the driver structure. Version 1 tables end before the
+    // fast I/O routine, so don't read beyond that.
     //
 
-    RtlCopyMemory(&(Driver->FunctionTable),
-                  FunctionTable,
-                  sizeof(DRIVER_FUNCTION_TABLE));
+    CopySize = sizeof(DRIVER_FUNCTION_TABLE);
+    if (FunctionTable->Version < 2) {
+        CopySize = FIELD_OFFSET(DRIVER_FUNCTION_TABLE, DispatchFastIo);
+        RtlZeroMemory(&(Driver->FunctionTable), sizeof(DRIVER_FUNCTION_TABLE));
+    }
+
+    RtlCopyMemory(&(Driver->FunctionTable), FunctionTable, CopySize);
 
     Status = STATUS_SUCCESS;
 
@@ -817,6 +817,7 @@ Return Value:
 
                 RtlZeroMemory(NewObject, sizeof(FILE_OBJECT));
                 INITIALIZE_LIST_HEAD(&(NewObject->FileLockList));
+                INITIALIZE_LIST_HEAD(&(NewObject->WatchList));
                 INITIALIZE_LIST_HEAD(&(NewObject->DirtyPageList));
                 RtlRedBlackTreeInitialize(&(NewObject->PageCacheTree),
                                           0,
@@ -1221,6 +1222,7 @@ Return Value:
         ASSERT((Object->Flags & FILE_OBJECT_FLAG_CLOSING) != 0);
         ASSERT(Object->PathEntryCount == 0);
         ASSERT(LIST_EMPTY(&(Object->FileLockList)) != FALSE);
+        ASSERT(LIST_EMPTY(&(Object->WatchList)) != FALSE);
 
         //
         // If this was an object manager object, release the reference on the
@@ -231,6 +231,11 @@ Return Value:
         goto InitializeEnd;
     }
 
+    Status = IopInitializeIrpLookaside();
+    if (!KSUCCESS(Status)) {
+        goto InitializeEnd;
+    }
+
     //
     // Create the pipe directory.
     //
@@ -343,6 +348,15 @@ Return Value:
         goto InitializeEnd;
     }
 
+    //
+    // Initialize file watch support.
+    //
+
+    Status = IopInitializeFileWatchSupport();
+    if (!KSUCCESS(Status)) {
+        goto InitializeEnd;
+    }
+
     //
     // Initialize the device database.
     //
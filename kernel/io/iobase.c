@@ -1494,10 +1494,15 @@ Return Value:
         if (!KSUCCESS(Status)) {
             goto SetFileInformationEnd;
         }
+
+        IopNotifyPathEntryWatches(Handle->PathPoint.PathEntry,
+                                  FILE_WATCH_EVENT_MODIFY);
     }
 
     if (Updated != FALSE) {
         IopMarkFileObjectPropertiesDirty(FileObject);
+        IopNotifyPathEntryWatches(Handle->PathPoint.PathEntry,
+                                  FILE_WATCH_EVENT_ATTRIBUTES);
     }
 
     Status = STATUS_SUCCESS;
@@ -1715,6 +1720,7 @@ Return Value:
     PATH_POINT SourcePathPoint;
     PPATH_POINT SourceStartPathPoint;
     KSTATUS Status;
+    ULONG WatchEvents;
 
     DestinationDirectory = NULL;
     DestinationDirectoryPathPoint.PathEntry = NULL;
@@ -2260,6 +2266,14 @@ Return Value:
         ASSERT(DestinationFileObject != NULL);
 
         IopFileObjectDecrementHardLinkCount(DestinationFileObject);
+        if (DestinationFileObject->Properties.HardLinkCount == 0) {
+            IopNotifyFileWatches(DestinationFileObject,
+                                 FILE_WATCH_EVENT_DELETE_SELF,
+                                 0,
+                                 NULL,
+                                 0);
+        }
+
         IopPathUnlink(DestinationPathPoint.PathEntry);
 
     //
@@ -2291,6 +2305,16 @@ Return Value:
             IopUpdateFileObjectTime(DestinationDirectoryFileObject,
                                     FileObjectModifiedTime);
 
+            WatchEvents = IO_FILE_WATCH_EVENTS(
+                                            FILE_WATCH_EVENT_CREATE,
+                                            SourceFileObject->Properties.Type);
+
+            IopNotifyFileWatches(DestinationDirectoryFileObject,
+                                 WatchEvents,
+                                 0,
+                                 DestinationFile,
+                                 DestinationFileSize);
+
         //
         // Otherwise, the delta is -1. Decrement the hard link count and unlink
         // it from the source path entry. Unfortunately, this rename turned
@@ -2302,6 +2326,16 @@ Return Value:
             ASSERT(RenameRequest.SourceFileHardLinkDelta == (ULONG)-1);
 
             IopFileObjectDecrementHardLinkCount(SourceFileObject);
+            WatchEvents = IO_FILE_WATCH_EVENTS(
+                                            FILE_WATCH_EVENT_DELETE,
+                                            SourceFileObject->Properties.Type);
+
+            IopNotifyFileWatches(SourceDirectoryFileObject,
+                                 WatchEvents,
+                                 0,
+                                 SourcePathPoint.PathEntry->Name,
+                                 SourcePathPoint.PathEntry->NameSize);
+
             IopPathUnlink(SourcePathPoint.PathEntry);
             IopUpdateFileObjectTime(SourceDirectoryFileObject,
                                     FileObjectModifiedTime);
@@ -2356,6 +2390,14 @@ Return Value:
 
         IopUpdateFileObjectTime(SourceDirectoryFileObject,
                                 FileObjectModifiedTime);
+
+        IopNotifyFileWatchesOfRename(SourceDirectoryFileObject,
+                                     SourcePathPoint.PathEntry->Name,
+                                     SourcePathPoint.PathEntry->NameSize,
+                                     DestinationDirectoryFileObject,
+                                     DestinationFile,
+                                     DestinationFileSize,
+                                     SourceFileObject);
     }
 
     IopUpdateFileObjectTime(SourceFileObject, FileObjectStatusTime);
@@ -3489,6 +3531,9 @@ Return Value:
             if (!KSUCCESS(Status)) {
                 goto OpenPathEntryEnd;
             }
+
+            IopNotifyPathEntryWatches(PathPoint->PathEntry,
+                                      FILE_WATCH_EVENT_MODIFY);
         }
 
         Status = STATUS_SUCCESS;
@@ -3545,6 +3590,9 @@ Return Value:
             if (!KSUCCESS(Status)) {
                 goto OpenPathEntryEnd;
             }
+
+            IopNotifyPathEntryWatches(PathPoint->PathEntry,
+                                      FILE_WATCH_EVENT_MODIFY);
         }
 
         Status = STATUS_SUCCESS;
@@ -3832,6 +3880,15 @@ Return Value:
         }
     }
 
+    //
+    // Destroy the I/O IRP the handle was holding on to.
+    //
+
+    if (IoHandle->IoIrp != NULL) {
+        IoDestroyIrp(IoHandle->IoIrp);
+        IoHandle->IoIrp = NULL;
+    }
+
     //
     // Clear the asynchronous receiver information from this handle.
     //
@@ -3963,6 +4020,7 @@ Return Value:
     BOOL SendUnlinkRequest;
     KSTATUS Status;
     BOOL Unlinked;
+    ULONG WatchEvents;
 
     LocksHeld = FALSE;
     ParentPathPoint.PathEntry = NULL;
@@ -4149,6 +4207,23 @@ Return Value:
     //
 
     if (Unlinked != FALSE) {
+        WatchEvents = IO_FILE_WATCH_EVENTS(FILE_WATCH_EVENT_DELETE,
+                                           FileObject->Properties.Type);
+
+        IopNotifyFileWatches(DirectoryFileObject,
+                             WatchEvents,
+                             0,
+                             PathPoint->PathEntry->Name,
+                             PathPoint->PathEntry->NameSize);
+
+        if (FileObject->Properties.HardLinkCount == 0) {
+            IopNotifyFileWatches(FileObject,
+                                 FILE_WATCH_EVENT_DELETE_SELF,
+                                 0,
+                                 NULL,
+                                 0);
+        }
+
         IopPathUnlink(PathPoint->PathEntry);
     }
 
@@ -5398,6 +5473,11 @@ Return Value:
         goto PerformIoOperationEnd;
     }
 
+    if ((Context->Write != FALSE) && (Context->BytesCompleted != 0)) {
+        IopNotifyPathEntryWatches(Handle->PathPoint.PathEntry,
+                                  FILE_WATCH_EVENT_MODIFY);
+    }
+
 PerformIoOperationEnd:
 
     ASSERT(Context->BytesCompleted <= Context->SizeInBytes);
@@ -5579,7 +5659,7 @@ Return Value:
     // Fire off the I/O.
     //
 
-    Status = IopSendIoIrp(Device, MinorCode, &Parameters);
+    Status = IopSendIoIrp(Device, MinorCode, &Parameters, Handle);
     Context->BytesCompleted = Parameters.IoBytesCompleted;
     if (Context->Offset == IO_OFFSET_NONE) {
         RtlAtomicExchange64((PULONGLONG)&(Handle->CurrentOffset),
@@ -5693,7 +5773,7 @@ Return Value:
 
     ASSERT(IS_DEVICE_OR_VOLUME(Device));
 
-    Status = IopSendIoIrp(Device, IrpMinorIoRead, &Parameters);
+    Status = IopSendIoIrp(Device, IrpMinorIoRead, &Parameters, NULL);
     if (KSUCCESS(Status) || (Status == STATUS_END_OF_FILE)) {
         if ((Handle->OpenFlags & OPEN_FLAG_NO_ACCESS_TIME) == 0) {
 
@@ -63,6 +63,7 @@ Module Name:
 #define FILE_LOCK_ALLOCATION_TAG 0x6B434C46 // 'kcLF'
 #define SOCKET_INFORMATION_ALLOCATION_TAG 0x666E4953 // 'fnIS'
 #define UNIX_SOCKET_ALLOCATION_TAG 0x6F536E55 // 'oSnU'
+#define FILE_WATCH_ALLOCATION_TAG 0x68637457 // 'hctW'
 
 #define IRP_MAGIC_VALUE (USHORT)IRP_ALLOCATION_TAG
 
@@ -305,6 +306,15 @@ Module Name:
 #define IO_IS_MOUNT_POINT(_PathPoint) \
     ((_PathPoint)->PathEntry == (_PathPoint)->MountPoint->TargetEntry)
 
+//
+// This macro returns the given file watch events, adding the directory bit
+// if the I/O object type the events are about is a directory.
+//
+
+#define IO_FILE_WATCH_EVENTS(_Events, _IoObjectType)            \
+    (((_IoObjectType) == IoObjectRegularDirectory) ?            \
+     ((_Events) | FILE_WATCH_EVENT_DIRECTORY) : (_Events))
+
 //
 // This macro determines whether this is a cacheable file-ish object. It
 // excludes block and character devices.
@@ -342,6 +352,7 @@ typedef enum _FILE_OBJECT_TIME_TYPE {
 } FILE_OBJECT_TIME_TYPE, *PFILE_OBJECT_TIME_TYPE;
 
 typedef struct _DEVICE_POWER DEVICE_POWER, *PDEVICE_POWER;
+typedef struct _FILE_WATCH_QUEUE FILE_WATCH_QUEUE, *PFILE_WATCH_QUEUE;
 
 /*++
 
@@ -409,6 +420,9 @@ Structure Description:
     FileLockEvent - Stores a pointer to the event that's signalled when a file
         object lock is released.
 
+    WatchList - Stores the head of the list of file watches attached to this
+        file object. This is protected by the global file watch lock.
+
 --*/
 
 typedef struct _FILE_OBJECT FILE_OBJECT, *PFILE_OBJECT;
@@ -431,6 +445,7 @@ struct _FILE_OBJECT {
     FILE_PROPERTIES Properties;
     LIST_ENTRY FileLockList;
     PKEVENT FileLockEvent;
+    LIST_ENTRY WatchList;
 };
 
 /*++
@@ -593,6 +608,9 @@ Structure Description:
 
     Async - Stores an optional pointer to the asynchronous receiver state.
 
+    IoIrp - Stores an optional pointer to an I/O IRP kept around for reuse by
+        synchronous character device I/O on this handle.
+
 --*/
 
 struct _IO_HANDLE {
@@ -605,6 +623,7 @@ struct _IO_HANDLE {
     PFILE_OBJECT FileObject;
     IO_OFFSET CurrentOffset;
     PASYNC_IO_RECEIVER Async;
+    PIRP IoIrp;
 };
 
 /*++
@@ -3210,6 +3229,29 @@ Return Value:
 
 --*/
 
+PFILE_WATCH_QUEUE
+IopGetFileWatchQueue (
+    PIO_HANDLE Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine returns the file watch queue behind the given handle.
+
+Arguments:
+
+    Handle - Supplies a pointer to the I/O handle.
+
+Return Value:
+
+    Returns a pointer to the watch queue on success.
+
+    NULL if the handle is not a handle to a watch queue.
+
+--*/
+
 KSTATUS
 IopInitializeTerminalSupport (
     VOID
@@ -3803,6 +3845,336 @@ Return Value:
 
 --*/
 
+KSTATUS
+IopInitializeFileWatchSupport (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine is called during system initialization to set up support for
+    file watch queues.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopCreateFileWatchQueue (
+    BOOL FromKernelMode,
+    ULONG OpenFlags,
+    PIO_HANDLE *Handle
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates a new file watch queue. The queue is the read side of
+    an anonymous pipe, from which file watch events are read.
+
+Arguments:
+
+    FromKernelMode - Supplies a boolean indicating whether this request is
+        originating from kernel mode or user mode.
+
+    OpenFlags - Supplies the open flags for the queue handle. See OPEN_FLAG_*
+        definitions.
+
+    Handle - Supplies a pointer where a handle to the new queue will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopAddFileWatch (
+    BOOL FromKernelMode,
+    PIO_HANDLE QueueHandle,
+    PIO_HANDLE Directory,
+    PCSTR Path,
+    ULONG PathLength,
+    ULONG Events,
+    PLONG Descriptor
+    );
+
+/*++
+
+Routine Description:
+
+    This routine adds a watch on a file or directory to a file watch queue. If
+    the queue already watches the file, the existing watch is updated instead.
+
+Arguments:
+
+    FromKernelMode - Supplies a boolean indicating whether this request is
+        originating from kernel mode or user mode.
+
+    QueueHandle - Supplies a pointer to an open handle to the watch queue.
+
+    Directory - Supplies an optional pointer to an open handle to a directory
+        for relative paths. Supply NULL to use the current working directory.
+
+    Path - Supplies a pointer to the path of the file or directory to watch.
+
+    PathLength - Supplies the length of the path buffer in bytes, including the
+        null terminator.
+
+    Events - Supplies the bitmask of events to watch for, combined with any
+        flags. See FILE_WATCH_EVENT_* and FILE_WATCH_FLAG_* definitions.
+
+    Descriptor - Supplies a pointer where the descriptor for the watch will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+KSTATUS
+IopRemoveFileWatch (
+    PIO_HANDLE QueueHandle,
+    LONG Descriptor
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes a watch from a file watch queue, queuing a final
+    ignored event for it.
+
+Arguments:
+
+    QueueHandle - Supplies a pointer to an open handle to the watch queue.
+
+    Descriptor - Supplies the descriptor of the watch to remove.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+VOID
+IopCloseFileWatchQueue (
+    PFILE_WATCH_QUEUE Queue
+    );
+
+/*++
+
+Routine Description:
+
+    This routine removes all the watches from a file watch queue. It is called
+    when the last handle to the queue is closed.
+
+Arguments:
+
+    Queue - Supplies a pointer to the watch queue.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopDestroyFileWatchQueue (
+    PFILE_WATCH_QUEUE Queue
+    );
+
+/*++
+
+Routine Description:
+
+    This routine destroys a file watch queue and any events still in it. The
+    queue must have no watches left.
+
+Arguments:
+
+    Queue - Supplies a pointer to the watch queue.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopConnectFileWatchQueue (
+    PFILE_WATCH_QUEUE Queue,
+    PIO_OBJECT_STATE IoState
+    );
+
+/*++
+
+Routine Description:
+
+    This routine connects a file watch queue to the I/O object state of the
+    pipe that owns it, which is signaled when events are queued.
+
+Arguments:
+
+    Queue - Supplies a pointer to the watch queue.
+
+    IoState - Supplies a pointer to the owning pipe's I/O object state.
+
+Return Value:
+
+    None.
+
+--*/
+
+KSTATUS
+IopReadFileWatchQueue (
+    PFILE_WATCH_QUEUE Queue,
+    PIO_CONTEXT IoContext
+    );
+
+/*++
+
+Routine Description:
+
+    This routine reads whole events out of a file watch queue, blocking until
+    at least one is available unless the timeout is zero.
+
+Arguments:
+
+    Queue - Supplies a pointer to the watch queue.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one event was read.
+
+    STATUS_BUFFER_TOO_SMALL if the first event does not fit in the buffer.
+
+    STATUS_TIMEOUT if there are no events and the timeout expired.
+
+    Other error codes on failure.
+
+--*/
+
+VOID
+IopNotifyFileWatches (
+    PFILE_OBJECT FileObject,
+    ULONG Events,
+    ULONG Cookie,
+    PCSTR Name,
+    ULONG NameSize
+    );
+
+/*++
+
+Routine Description:
+
+    This routine queues an event to every watch on the given file object that
+    is interested in it.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the file object the event occurred on.
+
+    Events - Supplies the bitmask of events that occurred. See
+        FILE_WATCH_EVENT_* definitions.
+
+    Cookie - Supplies the cookie tying together the two halves of a rename, or
+        zero.
+
+    Name - Supplies an optional pointer to the name of the directory entry the
+        event is about, for events on directories.
+
+    NameSize - Supplies the size of the name in bytes, including the null
+        terminator.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopNotifyPathEntryWatches (
+    PPATH_ENTRY PathEntry,
+    ULONG Events
+    );
+
+/*++
+
+Routine Description:
+
+    This routine queues an event to the watches on a path entry's file object,
+    and to the watches on its parent directory along with the entry's name.
+
+Arguments:
+
+    PathEntry - Supplies a pointer to the path entry the event occurred on.
+
+    Events - Supplies the bitmask of events that occurred. See
+        FILE_WATCH_EVENT_* definitions.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+IopNotifyFileWatchesOfRename (
+    PFILE_OBJECT SourceDirectory,
+    PCSTR SourceName,
+    ULONG SourceNameSize,
+    PFILE_OBJECT DestinationDirectory,
+    PCSTR DestinationName,
+    ULONG DestinationNameSize,
+    PFILE_OBJECT FileObject
+    );
+
+/*++
+
+Routine Description:
+
+    This routine queues the events for a successful rename: a moved from event
+    in the source directory and a moved to event in the destination, sharing a
+    cookie, and a move self event on the renamed file.
+
+Arguments:
+
+    SourceDirectory - Supplies a pointer to the source directory.
+
+    SourceName - Supplies a pointer to the old name of the file.
+
+    SourceNameSize - Supplies the size of the old name in bytes, including the
+        null terminator.
+
+    DestinationDirectory - Supplies a pointer to the destination directory.
+
+    DestinationName - Supplies a pointer to the new name of the file.
+
+    DestinationNameSize - Supplies the size of the new name in bytes,
+        including the null terminator.
+
+    FileObject - Supplies a pointer to the file that was renamed.
+
+Return Value:
+
+    None.
+
+--*/
+
 KSTATUS
 IopInitializePathSupport (
     VOID
@@ -4501,14 +4873,16 @@ KSTATUS
 IopSendIoIrp (
     PDEVICE Device,
     IRP_MINOR_CODE MinorCodeNumber,
-    PIRP_READ_WRITE Request
+    PIRP_READ_WRITE Request,
+    PIO_HANDLE IoHandle
     );
 
 /*++
 
 Routine Description:
 
-    This routine sends an I/O IRP.
+    This routine sends an I/O IRP. If the topmost driver on the device
+    supports fast I/O, the request is handed to it directly without an IRP.
 
 Arguments:
 
@@ -4519,6 +4893,11 @@ Routine Description:
     Request - Supplies a pointer that on input contains the I/O request
         parameters.
 
+    IoHandle - Supplies an optional pointer to the I/O handle the request was
+        made on. If supplied, the I/O IRP cached in the handle is used instead
+        of creating a new one, and the IRP is left in the handle afterwards
+        for the next request.
+
 Return Value:
 
     Status code.
@@ -4620,6 +4999,28 @@ Return Value:
 
 --*/
 
+KSTATUS
+IopInitializeIrpLookaside (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates the per-processor lookaside lists that IRPs are
+    recycled through. It must be called after all processors are started.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
 KSTATUS
 IopQueueResourceAssignment (
     PDEVICE Device
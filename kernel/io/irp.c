@@ -36,6 +36,14 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the number of IRP stack depths that get their own lookaside list,
+// and the number of free IRPs each processor's list holds on to.
+//
+
+#define IRP_LOOKASIDE_DEPTHS 8
+#define IRP_LOOKASIDE_MAX_COUNT 32
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -98,6 +106,9 @@ Structure Description:
     Flags - Stores a set of informational flags about the IRP. See IRP_*
         definitions.
 
+    NextFree - Stores a pointer to the next free IRP of the same stack depth
+        while this IRP is parked on a lookaside list.
+
 --*/
 
 typedef struct _IRP_INTERNAL {
@@ -109,8 +120,33 @@ typedef struct _IRP_INTERNAL {
     ULONG StackIndex;
     ULONG StackSize;
     ULONG Flags;
+    struct _IRP_INTERNAL *NextFree;
 } IRP_INTERNAL, *PIRP_INTERNAL;
 
+/*++
+
+Structure Description:
+
+    This structure defines a processor's set of IRP lookaside lists, one per
+    stack depth. Destroyed IRPs are parked here with their stacks still
+    attached, so creating an IRP of the same depth later needs neither a new
+    object nor a new stack. The lists are only ever touched by their own
+    processor at dispatch level, so they need no lock.
+
+Members:
+
+    Head - Stores the heads of the free lists, indexed by stack depth minus
+        one.
+
+    Count - Stores the number of free IRPs on each list.
+
+--*/
+
+typedef struct _IRP_LOOKASIDE {
+    PIRP_INTERNAL Head[IRP_LOOKASIDE_DEPTHS];
+    ULONG Count[IRP_LOOKASIDE_DEPTHS];
+} IRP_LOOKASIDE, *PIRP_LOOKASIDE;
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
@@ -130,6 +166,23 @@ IopAdvanceIrpStackLocation (
     PIRP_INTERNAL Irp
     );
 
+KSTATUS
+IopSendFastIo (
+    PDEVICE Device,
+    IRP_MINOR_CODE MinorCodeNumber,
+    PIRP_READ_WRITE Request
+    );
+
+PIRP_INTERNAL
+IopAllocateLookasideIrp (
+    ULONG StackSize
+    );
+
+BOOL
+IopFreeLookasideIrp (
+    PIRP_INTERNAL Irp
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -140,6 +193,14 @@ IopAdvanceIrpStackLocation (
 
 POBJECT_HEADER IoIrpDirectory = NULL;
 
+//
+// Store the per-processor IRP lookaside lists, and the number of processors
+// they cover.
+//
+
+PIRP_LOOKASIDE *IoIrpLookaside;
+ULONG IoIrpLookasideCount;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -438,6 +499,7 @@ Return Value:
     PDRIVER_DISPATCH DestroyIrp;
     ULONG EntryIndex;
     PIRP_INTERNAL Irp;
+    ULONG StackSize;
     KSTATUS Status;
 
     ASSERT(KeGetRunLevel() <= RunLevelDispatch);
@@ -460,42 +522,15 @@ Return Value:
         }
     }
 
-    //
-    // Attempt to allocate and initialize the IRP.
-    //
-
-    Irp = ObCreateObject(ObjectIrp,
-                         IoIrpDirectory,
-                         NULL,
-                         0,
-                         sizeof(IRP_INTERNAL),
-                         NULL,
-                         0,
-                         IRP_ALLOCATION_TAG);
-
-    if (Irp == NULL) {
-        Status = STATUS_INSUFFICIENT_RESOURCES;
-        goto CreateIrpEnd;
-    }
-
-    Irp->Magic = IRP_MAGIC_VALUE;
-    Irp->MajorCode = MajorCode;
-    Irp->Device = Device;
-    Irp->Public.Device = Device;
-    Irp->Public.MajorCode = MajorCode;
-    Irp->Flags = 0;
-    Irp->Stack = NULL;
-    Irp->StackIndex = 0;
-
     //
     // Figure out the size of the IRP stack, which is a chain of all the
     // target devices. Don't follow the target device through volumes.
     //
 
-    Irp->StackSize = 0;
+    StackSize = 0;
     CurrentTarget = Device;
     while (CurrentTarget != NULL) {
-        Irp->StackSize += CurrentTarget->DriverStackSize;
+        StackSize += CurrentTarget->DriverStackSize;
         if (CurrentTarget->Header.Type != ObjectDevice) {
             break;
         }
@@ -504,15 +539,43 @@ Return Value:
     }
 
     //
-    // Allocate the IRP stack.
+    // Reuse a destroyed IRP of the same depth if this processor has one
+    // parked, which comes with its stack. Otherwise allocate a new IRP and
+    // stack.
     //
 
-    AllocationSize = sizeof(IRP_STACK_ENTRY) * Irp->StackSize;
-    Irp->Stack = MmAllocateNonPagedPool(AllocationSize, IRP_ALLOCATION_TAG);
-    if (Irp->Stack == NULL) {
-        Status = STATUS_INSUFFICIENT_RESOURCES;
+    AllocationSize = sizeof(IRP_STACK_ENTRY) * StackSize;
+    Irp = IopAllocateLookasideIrp(StackSize);
+    if (Irp == NULL) {
+        Irp = ObCreateObject(ObjectIrp,
+                             IoIrpDirectory,
+                             NULL,
+                             0,
+                             sizeof(IRP_INTERNAL),
+                             NULL,
+                             0,
+                             IRP_ALLOCATION_TAG);
+
+        if (Irp == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto CreateIrpEnd;
+        }
+
+        Irp->StackSize = StackSize;
+        Irp->Stack = MmAllocateNonPagedPool(AllocationSize, IRP_ALLOCATION_TAG);
+        if (Irp->Stack == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto CreateIrpEnd;
+        }
     }
 
+    Irp->Magic = IRP_MAGIC_VALUE;
+    Irp->MajorCode = MajorCode;
+    Irp->Device = Device;
+    Irp->Public.Device = Device;
+    Irp->Public.MajorCode = MajorCode;
+    Irp->Flags = 0;
+    Irp->StackIndex = 0;
     RtlZeroMemory(Irp->Stack, AllocationSize);
     IoInitializeIrp(&(Irp->Public));
 
@@ -600,12 +663,18 @@ Return Value:
                     }
                 }
 
-                MmFreeNonPagedPool(Irp->Stack);
             }
 
             ASSERT(Irp->Public.Header.ReferenceCount == 1);
 
-            ObReleaseReference(Irp);
+            if (IopFreeLookasideIrp(Irp) == FALSE) {
+                if (Irp->Stack != NULL) {
+                    MmFreeNonPagedPool(Irp->Stack);
+                }
+
+                ObReleaseReference(Irp);
+            }
+
             Irp = NULL;
         }
     }
@@ -691,8 +760,16 @@ Return Value:
         }
     }
 
-    MmFreeNonPagedPool(InternalIrp->Stack);
-    ObReleaseReference(Irp);
+    //
+    // Park the IRP on this processor's lookaside list if there's room, or
+    // free it for real.
+    //
+
+    if (IopFreeLookasideIrp(InternalIrp) == FALSE) {
+        MmFreeNonPagedPool(InternalIrp->Stack);
+        ObReleaseReference(Irp);
+    }
+
     return;
 }
 
@@ -1373,14 +1450,16 @@ KSTATUS
 IopSendIoIrp (
     PDEVICE Device,
     IRP_MINOR_CODE MinorCodeNumber,
-    PIRP_READ_WRITE Request
+    PIRP_READ_WRITE Request,
+    PIO_HANDLE IoHandle
     )
 
 /*++
 
 Routine Description:
 
-    This routine sends an I/O IRP.
+    This routine sends an I/O IRP. If the topmost driver on the device
+    supports fast I/O, the request is handed to it directly without an IRP.
 
 Arguments:
 
@@ -1391,6 +1470,11 @@ Routine Description:
     Request - Supplies a pointer that on input contains the I/O request
         parameters.
 
+    IoHandle - Supplies an optional pointer to the I/O handle the request was
+        made on. If supplied, the I/O IRP cached in the handle is used instead
+        of creating a new one, and the IRP is left in the handle afterwards
+        for the next request.
+
 Return Value:
 
     Status code.
@@ -1400,18 +1484,14 @@ Return Value:
 {
 
     PIRP IoIrp;
+    UINTN OldIrp;
     KSTATUS Status;
     PKTHREAD Thread;
 
     ASSERT((Device != NULL) && (Device != IoRootDevice));
     ASSERT(KeGetRunLevel() < RunLevelDispatch);
 
-    IoIrp = IoCreateIrp(Device, IrpMajorIo, 0);
-    if (IoIrp == NULL) {
-        Status = STATUS_INSUFFICIENT_RESOURCES;
-        goto SendIoIrpEnd;
-    }
-
+    IoIrp = NULL;
     Thread = KeGetCurrentThread();
 
     //
@@ -1420,48 +1500,92 @@ Return Value:
     //
 
     Thread->Flags &= ~THREAD_FLAG_NON_IO_FAULT;
+    Request->IoBufferState.IoBuffer = NULL;
+    Status = IopSendFastIo(Device, MinorCodeNumber, Request);
+    if (Status == STATUS_NOT_HANDLED) {
 
-    //
-    // Copy the supplied contents in and send the IRP.
-    //
+        //
+        // Take the handle's cached IRP if there is one. Concurrent requests
+        // on the same handle find the slot empty and create their own.
+        //
 
-    IoIrp->MinorCode = MinorCodeNumber;
-    RtlCopyMemory(&(IoIrp->U.ReadWrite), Request, sizeof(IRP_READ_WRITE));
-    IoIrp->U.ReadWrite.IoBufferState.IoBuffer = NULL;
-    Status = IoSendSynchronousIrp(IoIrp);
-    if (!KSUCCESS(Status)) {
-        goto SendIoIrpEnd;
+        if (IoHandle != NULL) {
+            IoIrp = (PIRP)RtlAtomicExchange((PUINTN)&(IoHandle->IoIrp),
+                                            (UINTN)NULL);
+
+            if (IoIrp != NULL) {
+
+                ASSERT(IoIrp->Device == Device);
+
+                IoInitializeIrp(IoIrp);
+            }
+        }
+
+        if (IoIrp == NULL) {
+            IoIrp = IoCreateIrp(Device, IrpMajorIo, 0);
+            if (IoIrp == NULL) {
+                Status = STATUS_INSUFFICIENT_RESOURCES;
+                goto SendIoIrpEnd;
+            }
+        }
+
+        //
+        // Copy the supplied contents in and send the IRP.
+        //
+
+        IoIrp->MinorCode = MinorCodeNumber;
+        RtlCopyMemory(&(IoIrp->U.ReadWrite), Request, sizeof(IRP_READ_WRITE));
+        Status = IoSendSynchronousIrp(IoIrp);
+        if (!KSUCCESS(Status)) {
+            goto SendIoIrpEnd;
+        }
+
+        ASSERT(IoIrp->U.ReadWrite.IoBufferState.IoBuffer == NULL);
+
+        RtlCopyMemory(Request, &(IoIrp->U.ReadWrite), sizeof(IRP_READ_WRITE));
+        Status = IoGetIrpStatus(IoIrp);
     }
 
-    ASSERT(IoIrp->U.ReadWrite.IoBufferState.IoBuffer == NULL);
+    ASSERT(Request->IoBufferState.IoBuffer == NULL);
 
-    RtlCopyMemory(Request, &(IoIrp->U.ReadWrite), sizeof(IRP_READ_WRITE));
     if (Device->Header.Type == ObjectDevice) {
         if (MinorCodeNumber == IrpMinorIoWrite) {
             RtlAtomicAdd64(&(IoGlobalStatistics.BytesWritten),
-                           IoIrp->U.ReadWrite.IoBytesCompleted);
-
-            Thread->ResourceUsage.BytesWritten +=
-                                           IoIrp->U.ReadWrite.IoBytesCompleted;
+                           Request->IoBytesCompleted);
 
+            Thread->ResourceUsage.BytesWritten += Request->IoBytesCompleted;
             Thread->ResourceUsage.DeviceWrites += 1;
 
         } else {
             RtlAtomicAdd64(&(IoGlobalStatistics.BytesRead),
-                           IoIrp->U.ReadWrite.IoBytesCompleted);
-
-            Thread->ResourceUsage.BytesRead +=
-                                           IoIrp->U.ReadWrite.IoBytesCompleted;
+                           Request->IoBytesCompleted);
 
+            Thread->ResourceUsage.BytesRead += Request->IoBytesCompleted;
             Thread->ResourceUsage.DeviceReads += 1;
         }
     }
 
-    Status = IoGetIrpStatus(IoIrp);
-
 SendIoIrpEnd:
     if (IoIrp != NULL) {
-        IoDestroyIrp(IoIrp);
+
+        //
+        // Put the IRP back in the handle for next time, unless another
+        // request already beat this one to it.
+        //
+
+        if (IoHandle != NULL) {
+            OldIrp = RtlAtomicCompareExchange((PUINTN)&(IoHandle->IoIrp),
+                                              (UINTN)IoIrp,
+                                              (UINTN)NULL);
+
+            if (OldIrp == (UINTN)NULL) {
+                IoIrp = NULL;
+            }
+        }
+
+        if (IoIrp != NULL) {
+            IoDestroyIrp(IoIrp);
+        }
     }
 
     return Status;
@@ -1501,7 +1625,7 @@ Return Value:
     ULONGLONG FileSize;
     KSTATUS Status;
 
-    Status = IopSendIoIrp(Device, IrpMinorIoRead, Request);
+    Status = IopSendIoIrp(Device, IrpMinorIoRead, Request, NULL);
     FileProperties = Request->FileProperties;
     FileSize = FileProperties->Size;
     if ((Request->IoOffset + Request->IoBytesCompleted) > FileSize) {
@@ -1706,6 +1830,73 @@ Return Value:
     return Status;
 }
 
+KSTATUS
+IopInitializeIrpLookaside (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates the per-processor lookaside lists that IRPs are
+    recycled through. It must be called after all processors are started.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+    PIRP_LOOKASIDE *Lookaside;
+    ULONG Processor;
+    ULONG ProcessorCount;
+
+    ProcessorCount = KeGetActiveProcessorCount();
+    if (ProcessorCount == 0) {
+        ProcessorCount = 1;
+    }
+
+    AllocationSize = ProcessorCount * sizeof(PIRP_LOOKASIDE);
+    Lookaside = MmAllocateNonPagedPool(AllocationSize, IRP_ALLOCATION_TAG);
+    if (Lookaside == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    //
+    // Allocate each processor's lists separately to keep them off of each
+    // other's cache lines.
+    //
+
+    for (Processor = 0; Processor < ProcessorCount; Processor += 1) {
+        Lookaside[Processor] = MmAllocateNonPagedPool(sizeof(IRP_LOOKASIDE),
+                                                      IRP_ALLOCATION_TAG);
+
+        if (Lookaside[Processor] == NULL) {
+            while (Processor != 0) {
+                Processor -= 1;
+                MmFreeNonPagedPool(Lookaside[Processor]);
+            }
+
+            MmFreeNonPagedPool(Lookaside);
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        RtlZeroMemory(Lookaside[Processor], sizeof(IRP_LOOKASIDE));
+    }
+
+    IoIrpLookasideCount = ProcessorCount;
+    IoIrpLookaside = Lookaside;
+    return STATUS_SUCCESS;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
@@ -1939,3 +2130,200 @@ Return Value:
     return FALSE;
 }
 
+KSTATUS
+IopSendFastIo (
+    PDEVICE Device,
+    IRP_MINOR_CODE MinorCodeNumber,
+    PIRP_READ_WRITE Request
+    )
+
+/*++
+
+Routine Description:
+
+    This routine attempts to hand a read or write directly to the topmost
+    driver in the device's stack, skipping the IRP.
+
+Arguments:
+
+    Device - Supplies a pointer to the target device.
+
+    MinorCodeNumber - Supplies the I/O minor code, either read or write.
+
+    Request - Supplies a pointer to the I/O request parameters.
+
+Return Value:
+
+    STATUS_NOT_HANDLED if the request needs to be sent in an IRP.
+
+    Otherwise, returns the completion status of the request.
+
+--*/
+
+{
+
+    PDRIVER_FAST_IO FastIo;
+    PDRIVER_STACK_ENTRY StackEntry;
+    BOOL Write;
+
+    if (LIST_EMPTY(&(Device->DriverStackHead)) != FALSE) {
+        return STATUS_NOT_HANDLED;
+    }
+
+    StackEntry = LIST_VALUE(Device->DriverStackHead.Next,
+                            DRIVER_STACK_ENTRY,
+                            ListEntry);
+
+    FastIo = StackEntry->Driver->FunctionTable.DispatchFastIo;
+    if (FastIo == NULL) {
+        return STATUS_NOT_HANDLED;
+    }
+
+    Write = FALSE;
+    if (MinorCodeNumber == IrpMinorIoWrite) {
+        Write = TRUE;
+    }
+
+    return FastIo(StackEntry->DriverContext, Write, Request);
+}
+
+PIRP_INTERNAL
+IopAllocateLookasideIrp (
+    ULONG StackSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes a parked IRP of the given stack depth from the current
+    processor's lookaside list. The IRP's stack comes with it, and everything
+    but its object header, stack, and stack size is zeroed.
+
+Arguments:
+
+    StackSize - Supplies the number of entries in the stack.
+
+Return Value:
+
+    Returns a pointer to the IRP on success.
+
+    NULL if there is no IRP of that depth parked on this processor.
+
+--*/
+
+{
+
+    PIRP_INTERNAL Irp;
+    PIRP_LOOKASIDE Lookaside;
+    RUNLEVEL OldRunLevel;
+    ULONG Processor;
+    PIRP_STACK_ENTRY Stack;
+
+    if ((StackSize == 0) ||
+        (StackSize > IRP_LOOKASIDE_DEPTHS) ||
+        (IoIrpLookaside == NULL)) {
+
+        return NULL;
+    }
+
+    //
+    // Raising to dispatch keeps the thread on this processor, and nothing at
+    // a higher run level touches the lists.
+    //
+
+    Irp = NULL;
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    Processor = KeGetCurrentProcessorNumber();
+    if (Processor < IoIrpLookasideCount) {
+        Lookaside = IoIrpLookaside[Processor];
+        Irp = Lookaside->Head[StackSize - 1];
+        if (Irp != NULL) {
+            Lookaside->Head[StackSize - 1] = Irp->NextFree;
+            Lookaside->Count[StackSize - 1] -= 1;
+        }
+    }
+
+    KeLowerRunLevel(OldRunLevel);
+    if (Irp == NULL) {
+        return NULL;
+    }
+
+    ASSERT((Irp->StackSize == StackSize) &&
+           (Irp->Public.Header.ReferenceCount == 1));
+
+    //
+    // Leave nothing behind from the IRP's last use. The object was signaled
+    // when it last completed, so reset it to the state of a new object.
+    //
+
+    Stack = Irp->Stack;
+    RtlZeroMemory((PUCHAR)Irp + sizeof(OBJECT_HEADER),
+                  sizeof(IRP_INTERNAL) - sizeof(OBJECT_HEADER));
+
+    Irp->Stack = Stack;
+    Irp->StackSize = StackSize;
+    ObSignalObject(Irp, SignalOptionUnsignal);
+    return Irp;
+}
+
+BOOL
+IopFreeLookasideIrp (
+    PIRP_INTERNAL Irp
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parks an IRP whose drivers have already torn down their
+    state on the current processor's lookaside list, if there is room.
+
+Arguments:
+
+    Irp - Supplies a pointer to the IRP to park.
+
+Return Value:
+
+    TRUE if the IRP was parked. The caller must not touch it again.
+
+    FALSE if the IRP could not be parked, and the caller must free its stack
+    and release it.
+
+--*/
+
+{
+
+    PIRP_LOOKASIDE Lookaside;
+    RUNLEVEL OldRunLevel;
+    BOOL Parked;
+    ULONG Processor;
+    ULONG StackSize;
+
+    StackSize = Irp->StackSize;
+    if ((StackSize == 0) ||
+        (StackSize > IRP_LOOKASIDE_DEPTHS) ||
+        (Irp->Stack == NULL) ||
+        (Irp->Public.Header.ReferenceCount != 1) ||
+        (IoIrpLookaside == NULL)) {
+
+        return FALSE;
+    }
+
+    Parked = FALSE;
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    Processor = KeGetCurrentProcessorNumber();
+    if (Processor < IoIrpLookasideCount) {
+        Lookaside = IoIrpLookaside[Processor];
+        if (Lookaside->Count[StackSize - 1] < IRP_LOOKASIDE_MAX_COUNT) {
+            Irp->NextFree = Lookaside->Head[StackSize - 1];
+            Lookaside->Head[StackSize - 1] = Irp;
+            Lookaside->Count[StackSize - 1] += 1;
+            Parked = TRUE;
+        }
+    }
+
+    KeLowerRunLevel(OldRunLevel);
+    return Parked;
+}
+
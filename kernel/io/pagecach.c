@@ -780,7 +780,10 @@ IoGetPageCacheEntryVirtualAddress (
 
 Routine Description:
 
-    This routine gets the given page cache entry's virtual address.
+    This routine gets the given page cache entry's virtual address. If the
+    entry has no mapping of its own, its address in the kernel's direct map of
+    RAM is returned if there is one. Such an address is not owned by the
+    entry.
 
 Arguments:
 
@@ -788,7 +791,8 @@ Routine Description:
 
 Return Value:
 
-    Returns the virtual address of the given page cache entry.
+    Returns the virtual address of the given page cache entry, or NULL if it
+    is not mapped.
 
 --*/
 
@@ -828,6 +832,19 @@ Return Value:
         Entry->VirtualAddress = VirtualAddress;
     }
 
+    //
+    // The direct map is always cached, so it can't be used for files that
+    // demand some other kind of mapping.
+    //
+
+    if ((VirtualAddress == NULL) &&
+        ((Entry->FileObject->MapFlags &
+          (MAP_FLAG_CACHE_DISABLE | MAP_FLAG_WRITE_THROUGH)) == 0)) {
+
+        VirtualAddress = MmGetDirectMapAddress(Entry->PhysicalAddress,
+                                               MmPageSize());
+    }
+
     return VirtualAddress;
 }
 
@@ -855,7 +872,8 @@ Routine Description:
 Return Value:
 
     Returns TRUE if the set succeeds or FALSE if another virtual address is
-    already set for the page cache entry.
+    already set for the page cache entry. Direct map addresses are never set,
+    as the page cache entry can't own them.
 
 --*/
 
@@ -869,7 +887,8 @@ Return Value:
            (IS_POINTER_ALIGNED(VirtualAddress, MmPageSize()) != FALSE));
 
     if ((Entry->VirtualAddress != NULL) ||
-        (IoPageCacheDisableVirtualAddresses != FALSE)) {
+        (IoPageCacheDisableVirtualAddresses != FALSE) ||
+        (MmIsDirectMapAddress(VirtualAddress) != FALSE)) {
 
         return FALSE;
     }
@@ -3463,7 +3482,9 @@ Return Value:
     NewEntry->Offset = Offset;
     NewEntry->PhysicalAddress = PhysicalAddress;
     if (VirtualAddress != NULL) {
-        if (IoPageCacheDisableVirtualAddresses == FALSE) {
+        if ((IoPageCacheDisableVirtualAddresses == FALSE) &&
+            (MmIsDirectMapAddress(VirtualAddress) == FALSE)) {
+
             NewEntry->VirtualAddress = VirtualAddress;
         }
     }
@@ -2531,6 +2531,7 @@ Return Value:
     PPATH_POINT ShmDirectory;
     KSTATUS Status;
     PKTHREAD Thread;
+    ULONG WatchEvents;
 
     Child = NULL;
     Created = FALSE;
@@ -2713,6 +2714,14 @@ Return Value:
                 ASSERT(Created != FALSE);
 
                 Create->Created = Created;
+                WatchEvents = IO_FILE_WATCH_EVENTS(FILE_WATCH_EVENT_CREATE,
+                                                   Properties.Type);
+
+                IopNotifyFileWatches(DirectoryFileObject,
+                                     WatchEvents,
+                                     0,
+                                     Name,
+                                     NameSize);
 
             //
             // The creation request didn't work. It can only turn into an open
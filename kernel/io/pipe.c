@@ -70,6 +70,10 @@ Structure Description:
 
     WriterCount - Stores the number of writers that have the pipe open.
 
+    WatchQueue - Stores an optional pointer to the file watch queue read
+        through this pipe. Watch queue pipes have no stream buffer and are only
+        ever open for reading.
+
 --*/
 
 typedef struct _PIPE {
@@ -78,6 +82,7 @@ typedef struct _PIPE {
     PSTREAM_BUFFER StreamBuffer;
     ULONG ReaderCount;
     ULONG WriterCount;
+    PFILE_WATCH_QUEUE WatchQueue;
 } PIPE, *PPIPE;
 
 /*++
@@ -278,7 +283,9 @@ Routine Description:
     NameSize - Supplies the size of the name in bytes including the null
         terminator.
 
-    Create - Supplies a pointer to the creation parameters.
+    Create - Supplies a pointer to the creation parameters. If the context
+        is not NULL, it points to a file watch queue that the new pipe takes
+        ownership of.
 
     FileObject - Supplies a pointer where a pointer to a newly created pipe
         file object will be returned on success.
@@ -385,14 +392,24 @@ Return Value:
 
     ASSERT((*FileObject)->IoState != NULL);
 
-    NewPipe->StreamBuffer = IoCreateStreamBuffer((*FileObject)->IoState,
-                                                 0,
-                                                 0,
-                                                 PIPE_ATOMIC_WRITE_SIZE);
+    //
+    // A watch queue takes the place of the stream buffer.
+    //
 
-    if (NewPipe->StreamBuffer == NULL) {
-        Status = STATUS_INSUFFICIENT_RESOURCES;
-        goto CreatePipeEnd;
+    if (Create->Context != NULL) {
+        NewPipe->WatchQueue = Create->Context;
+        IopConnectFileWatchQueue(NewPipe->WatchQueue, (*FileObject)->IoState);
+
+    } else {
+        NewPipe->StreamBuffer = IoCreateStreamBuffer((*FileObject)->IoState,
+                                                     0,
+                                                     0,
+                                                     PIPE_ATOMIC_WRITE_SIZE);
+
+        if (NewPipe->StreamBuffer == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto CreatePipeEnd;
+        }
     }
 
     //
@@ -534,6 +551,21 @@ Return Value:
         goto OpenPipeEnd;
     }
 
+    //
+    // Watch queues can only be read, and have no writers to wait for.
+    //
+
+    if (Pipe->WatchQueue != NULL) {
+        if ((IoHandle->Access & IO_ACCESS_WRITE) != 0) {
+            Status = STATUS_ACCESS_DENIED;
+            goto OpenPipeEnd;
+        }
+
+        Pipe->ReaderCount += 1;
+        Status = STATUS_SUCCESS;
+        goto OpenPipeEnd;
+    }
+
     IoState = IoStreamBufferGetIoObjectState(Pipe->StreamBuffer);
     if ((IoHandle->Access & IO_ACCESS_READ) != 0) {
         Pipe->ReaderCount += 1;
@@ -673,6 +705,7 @@ Return Value:
     PIO_OBJECT_STATE IoState;
     BOOL LockHeld;
     PPIPE Pipe;
+    ULONG ReaderCount;
 
     FileObject = IoHandle->FileObject;
     FileProperties = &(FileObject->Properties);
@@ -682,6 +715,24 @@ Return Value:
     KeAcquireSharedExclusiveLockExclusive(FileObject->Lock);
     LockHeld = TRUE;
     Pipe = FileObject->SpecialIo;
+
+    //
+    // Remove all the watches from a watch queue when its last handle closes.
+    // This has to happen now rather than when the pipe is destroyed, since
+    // the watches hold references on the file objects they watch.
+    //
+
+    if (Pipe->WatchQueue != NULL) {
+        Pipe->ReaderCount -= 1;
+        ReaderCount = Pipe->ReaderCount;
+        KeReleaseSharedExclusiveLockExclusive(FileObject->Lock);
+        if (ReaderCount == 0) {
+            IopCloseFileWatchQueue(Pipe->WatchQueue);
+        }
+
+        return STATUS_SUCCESS;
+    }
+
     IoState = IoStreamBufferGetIoObjectState(Pipe->StreamBuffer);
     if ((IoHandle->Access & IO_ACCESS_READ) != 0) {
         Pipe->ReaderCount -= 1;
@@ -781,6 +832,13 @@ Return Value:
     ASSERT(FileObject->Properties.Type == IoObjectPipe);
 
     Pipe = FileObject->SpecialIo;
+    if (Pipe->WatchQueue != NULL) {
+
+        ASSERT(IoContext->Write == FALSE);
+
+        return IopReadFileWatchQueue(Pipe->WatchQueue, IoContext);
+    }
+
     PipeBytesCompleted = 0;
     NonBlocking = FALSE;
     if (IoContext->Write != FALSE) {
@@ -826,6 +884,49 @@ Return Value:
     return Status;
 }
 
+PFILE_WATCH_QUEUE
+IopGetFileWatchQueue (
+    PIO_HANDLE Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the file watch queue behind the given handle.
+
+Arguments:
+
+    Handle - Supplies a pointer to the I/O handle.
+
+Return Value:
+
+    Returns a pointer to the watch queue on success.
+
+    NULL if the handle is not a handle to a watch queue.
+
+--*/
+
+{
+
+    PFILE_OBJECT FileObject;
+    PPIPE Pipe;
+
+    FileObject = Handle->FileObject;
+    if ((FileObject == NULL) ||
+        (FileObject->Properties.Type != IoObjectPipe)) {
+
+        return NULL;
+    }
+
+    Pipe = FileObject->SpecialIo;
+    if (Pipe == NULL) {
+        return NULL;
+    }
+
+    return Pipe->WatchQueue;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
@@ -860,6 +961,10 @@ Return Value:
         IoDestroyStreamBuffer(Pipe->StreamBuffer);
     }
 
+    if (Pipe->WatchQueue != NULL) {
+        IopDestroyFileWatchQueue(Pipe->WatchQueue);
+    }
+
     return;
 }
 
@@ -59,12 +59,22 @@ Module Name:
 
 //
 // Define terminal limits. The input queue length must always be at least the
-// max canonical length since the line gets dumped into the input queue.
+// max canonical length since the line gets dumped into the input queue. The
+// buffers are sized in whole pages. The output buffer is large so that bulk
+// output like build logs reaches the master in big chunks rather than waking
+// it up every few hundred bytes.
 //
 
-#define TERMINAL_INPUT_BUFFER_SIZE 512
+#define TERMINAL_INPUT_BUFFER_SIZE 0x1000
 #define TERMINAL_CANONICAL_BUFFER_SIZE (TERMINAL_INPUT_BUFFER_SIZE - 1)
-#define TERMINAL_OUTPUT_BUFFER_SIZE 256
+#define TERMINAL_OUTPUT_BUFFER_SIZE 0x4000
+
+//
+// Define the size of the bounce buffer used to pull data out of the caller's
+// buffer when output processing is on.
+//
+
+#define TERMINAL_OUTPUT_BOUNCE_SIZE 256
 
 //
 // Default control characters.
@@ -341,6 +351,17 @@ IopTerminalGetOutputBufferSpace (
     PTERMINAL Terminal
     );
 
+BOOL
+IopTerminalIsOutputRaw (
+    PTERMINAL Terminal
+    );
+
+VOID
+IopTerminalSetIoObjectState (
+    PIO_OBJECT_STATE IoState,
+    ULONG Events
+    );
+
 KSTATUS
 IopTerminalFixUpCanonicalLine (
     PTERMINAL Terminal,
@@ -3320,7 +3341,7 @@ Return Value:
                     }
 
                     IoSetIoObjectState(MasterIoState, POLL_EVENT_OUT, FALSE);
-                    IoSetIoObjectState(SlaveIoState, POLL_EVENT_IN, TRUE);
+                    IopTerminalSetIoObjectState(SlaveIoState, POLL_EVENT_IN);
                     InputAdded = FALSE;
                     KeReleaseQueuedLock(Terminal->Lock);
                     LockHeld = FALSE;
@@ -3390,7 +3411,7 @@ Return Value:
 
             while (IopTerminalGetInputBufferSpace(Terminal) == 0) {
                 IoSetIoObjectState(MasterIoState, POLL_EVENT_OUT, FALSE);
-                IoSetIoObjectState(SlaveIoState, POLL_EVENT_IN, TRUE);
+                IopTerminalSetIoObjectState(SlaveIoState, POLL_EVENT_IN);
                 KeReleaseQueuedLock(Terminal->Lock);
                 LockHeld = FALSE;
                 InputAdded = FALSE;
@@ -3522,14 +3543,14 @@ Return Value:
             LockHeld = TRUE;
         }
 
-        IoSetIoObjectState(MasterIoState, POLL_EVENT_IN, TRUE);
+        IopTerminalSetIoObjectState(MasterIoState, POLL_EVENT_IN);
     }
 
     if (InputAdded != FALSE) {
 
         ASSERT(LockHeld != FALSE);
 
-        IoSetIoObjectState(SlaveIoState, POLL_EVENT_IN, TRUE);
+        IopTerminalSetIoObjectState(SlaveIoState, POLL_EVENT_IN);
     }
 
     if (LockHeld != FALSE) {
@@ -3572,9 +3593,10 @@ Return Value:
     BOOL AnythingWritten;
     UINTN BytesThisRound;
     UINTN BytesWritten;
-    UCHAR LocalBytes[64];
+    UCHAR LocalBytes[TERMINAL_OUTPUT_BOUNCE_SIZE];
     BOOL LockHeld;
     PIO_OBJECT_STATE MasterIoState;
+    BOOL RawOutput;
     ULONG ReturnedEvents;
     PTERMINAL_SLAVE Slave;
     PIO_OBJECT_STATE SlaveIoState;
@@ -3619,10 +3641,13 @@ Return Value:
     }
 
     //
-    // Loop writing bytes until it's done.
+    // Loop writing bytes until it's done. The settings can only change with
+    // the lock held, so the output processing check is redone whenever the
+    // lock is reacquired.
     //
 
     Status = STATUS_SUCCESS;
+    RawOutput = IopTerminalIsOutputRaw(Terminal);
     Space = IopTerminalGetOutputBufferSpace(Terminal);
     while (BytesWritten != IoContext->SizeInBytes) {
 
@@ -3631,7 +3656,7 @@ Return Value:
         //
 
         if (Space == 0) {
-            IoSetIoObjectState(MasterIoState, POLL_EVENT_IN, TRUE);
+            IopTerminalSetIoObjectState(MasterIoState, POLL_EVENT_IN);
             IoSetIoObjectState(SlaveIoState, POLL_EVENT_OUT, FALSE);
             KeReleaseQueuedLock(Terminal->Lock);
             LockHeld = FALSE;
@@ -3652,6 +3677,7 @@ Return Value:
 
             KeAcquireQueuedLock(Terminal->Lock);
             LockHeld = TRUE;
+            RawOutput = IopTerminalIsOutputRaw(Terminal);
             Space = IopTerminalGetOutputBufferSpace(Terminal);
             continue;
         }
@@ -3661,6 +3687,48 @@ Return Value:
             BytesThisRound = IoContext->SizeInBytes - BytesWritten;
         }
 
+        //
+        // If no bytes need translating, copy the data straight from the I/O
+        // buffer into the output buffer, up to the point where it wraps.
+        //
+
+        if (RawOutput != FALSE) {
+            if (BytesThisRound >
+                TERMINAL_OUTPUT_BUFFER_SIZE - Terminal->OutputBufferEnd) {
+
+                BytesThisRound = TERMINAL_OUTPUT_BUFFER_SIZE -
+                                 Terminal->OutputBufferEnd;
+            }
+
+            Status = MmCopyIoBufferData(
+                            IoContext->IoBuffer,
+                            Terminal->OutputBuffer + Terminal->OutputBufferEnd,
+                            BytesWritten,
+                            BytesThisRound,
+                            FALSE);
+
+            if (!KSUCCESS(Status)) {
+                break;
+            }
+
+            Terminal->OutputBufferEnd += BytesThisRound;
+            if (Terminal->OutputBufferEnd == TERMINAL_OUTPUT_BUFFER_SIZE) {
+                Terminal->OutputBufferEnd = 0;
+            }
+
+            if (Terminal->HardwareHandle != NULL) {
+                Status = IopTerminalFlushOutputToDevice(Terminal);
+                if (!KSUCCESS(Status)) {
+                    goto TerminalSlaveWriteEnd;
+                }
+            }
+
+            Space = IopTerminalGetOutputBufferSpace(Terminal);
+            AnythingWritten = TRUE;
+            BytesWritten += BytesThisRound;
+            continue;
+        }
+
         //
         // Copy the data from the I/O buffer to a local bounce buffer, then
         // into the output buffer.
@@ -3713,7 +3781,7 @@ Return Value:
             LockHeld = TRUE;
         }
 
-        IoSetIoObjectState(MasterIoState, POLL_EVENT_IN, TRUE);
+        IopTerminalSetIoObjectState(MasterIoState, POLL_EVENT_IN);
     }
 
     if (LockHeld != FALSE) {
@@ -3801,7 +3869,7 @@ Return Value:
             }
 
             IoSetIoObjectState(MasterIoState, POLL_EVENT_IN, FALSE);
-            IoSetIoObjectState(SlaveIoState, POLL_EVENT_OUT, TRUE);
+            IopTerminalSetIoObjectState(SlaveIoState, POLL_EVENT_OUT);
             KeReleaseQueuedLock(Terminal->Lock);
             LockHeld = FALSE;
             Status = IoWaitForIoObjectState(MasterIoState,
@@ -3873,7 +3941,7 @@ Return Value:
             LockHeld = TRUE;
         }
 
-        IoSetIoObjectState(SlaveIoState, POLL_EVENT_OUT, TRUE);
+        IopTerminalSetIoObjectState(SlaveIoState, POLL_EVENT_OUT);
         Space = IopTerminalGetOutputBufferSpace(Terminal);
         if (Space == TERMINAL_OUTPUT_BUFFER_SIZE - 1) {
             IoSetIoObjectState(MasterIoState, POLL_EVENT_IN, FALSE);
@@ -4031,7 +4099,7 @@ Return Value:
             }
 
             IoSetIoObjectState(SlaveIoState, POLL_EVENT_IN, FALSE);
-            IoSetIoObjectState(MasterIoState, POLL_EVENT_OUT, TRUE);
+            IopTerminalSetIoObjectState(MasterIoState, POLL_EVENT_OUT);
             KeReleaseQueuedLock(Terminal->Lock);
             LockHeld = FALSE;
             Status = IoWaitForIoObjectState(SlaveIoState,
@@ -4149,7 +4217,7 @@ Return Value:
             LockHeld = TRUE;
         }
 
-        IoSetIoObjectState(MasterIoState, POLL_EVENT_OUT, TRUE);
+        IopTerminalSetIoObjectState(MasterIoState, POLL_EVENT_OUT);
         Space = IopTerminalGetInputBufferSpace(Terminal);
         if (Space == TERMINAL_INPUT_BUFFER_SIZE - 1) {
             IoSetIoObjectState(SlaveIoState, POLL_EVENT_IN, FALSE);
@@ -4214,8 +4282,11 @@ Return Value:
     ULONG Mask;
     PIO_OBJECT_STATE MasterIoState;
     ULONG OutputFlags;
+    BOOL RawOutput;
     ULONG RepeatIndex;
     ULONG ReturnedEvents;
+    UINTN RunIndex;
+    UINTN RunSize;
     PIO_OBJECT_STATE SlaveIoState;
     ULONG Space;
     KSTATUS Status;
@@ -4224,6 +4295,7 @@ Return Value:
     DidLeadingCharacter = FALSE;
     LockHeld = TRUE;
     OutputFlags = Terminal->Settings.OutputFlags;
+    RawOutput = IopTerminalIsOutputRaw(Terminal);
     MasterIoState = Terminal->MasterFileObject->IoState;
     SlaveIoState = Terminal->SlaveFileObject->IoState;
     Space = IopTerminalGetOutputBufferSpace(Terminal);
@@ -4246,7 +4318,7 @@ Return Value:
             }
 
             while (Space == 0) {
-                IoSetIoObjectState(MasterIoState, POLL_EVENT_IN, TRUE);
+                IopTerminalSetIoObjectState(MasterIoState, POLL_EVENT_IN);
                 IoSetIoObjectState(SlaveIoState, POLL_EVENT_OUT, FALSE);
                 KeReleaseQueuedLock(Terminal->Lock);
                 LockHeld = FALSE;
@@ -4270,6 +4342,55 @@ Return Value:
                 Space = IopTerminalGetOutputBufferSpace(Terminal);
             }
 
+            //
+            // Copy a run of bytes that need no translation in one go. Stop
+            // before any carriage return or newline if output processing is
+            // on, as those go through the byte at a time path below.
+            //
+
+            if (DidLeadingCharacter == FALSE) {
+                RunSize = SizeInBytes - ByteIndex;
+                if (RunSize > Space) {
+                    RunSize = Space;
+                }
+
+                if (RunSize >
+                    TERMINAL_OUTPUT_BUFFER_SIZE - Terminal->OutputBufferEnd) {
+
+                    RunSize = TERMINAL_OUTPUT_BUFFER_SIZE -
+                              Terminal->OutputBufferEnd;
+                }
+
+                if (RawOutput == FALSE) {
+                    for (RunIndex = 0; RunIndex < RunSize; RunIndex += 1) {
+                        Byte = ByteBuffer[ByteIndex + RunIndex];
+                        if ((Byte == '\r') || (Byte == '\n')) {
+                            break;
+                        }
+                    }
+
+                    RunSize = RunIndex;
+                }
+
+                if (RunSize != 0) {
+                    RtlCopyMemory(
+                            Terminal->OutputBuffer + Terminal->OutputBufferEnd,
+                            ByteBuffer + ByteIndex,
+                            RunSize);
+
+                    Terminal->OutputBufferEnd += RunSize;
+                    if (Terminal->OutputBufferEnd ==
+                        TERMINAL_OUTPUT_BUFFER_SIZE) {
+
+                        Terminal->OutputBufferEnd = 0;
+                    }
+
+                    Space -= RunSize;
+                    ByteIndex += RunSize - 1;
+                    continue;
+                }
+            }
+
             //
             // Process any output flags.
             //
@@ -4419,6 +4540,87 @@ Return Value:
     return Space;
 }
 
+BOOL
+IopTerminalIsOutputRaw (
+    PTERMINAL Terminal
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether or not the terminal's output settings
+    leave every byte untouched on the way out, in which case output can be
+    copied in bulk. This routine assumes the terminal lock is held.
+
+Arguments:
+
+    Terminal - Supplies a pointer to the terminal.
+
+Return Value:
+
+    TRUE if no output byte is translated.
+
+    FALSE if carriage returns or newlines need processing.
+
+--*/
+
+{
+
+    ULONG Mask;
+    ULONG OutputFlags;
+
+    OutputFlags = Terminal->Settings.OutputFlags;
+    if ((OutputFlags & TERMINAL_OUTPUT_CR_TO_NEWLINE) != 0) {
+        return FALSE;
+    }
+
+    Mask = TERMINAL_OUTPUT_POST_PROCESS | TERMINAL_OUTPUT_NEWLINE_TO_CRLF;
+    if ((OutputFlags & Mask) == Mask) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+VOID
+IopTerminalSetIoObjectState (
+    PIO_OBJECT_STATE IoState,
+    ULONG Events
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets poll events on one side of a terminal, skipping the
+    event signaling if they're all already set. Data moving through the
+    terminal in many small pieces would otherwise signal the other side's
+    events again on every piece. This routine assumes the terminal lock is
+    held, which is also held by anyone clearing the events.
+
+Arguments:
+
+    IoState - Supplies a pointer to the I/O object state to change.
+
+    Events - Supplies a mask of poll events to set. See POLL_EVENT_*
+        definitions.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if ((IoState->Events & Events) != Events) {
+        IoSetIoObjectState(IoState, Events, TRUE);
+    }
+
+    return;
+}
+
 KSTATUS
 IopTerminalFixUpCanonicalLine (
     PTERMINAL Terminal,
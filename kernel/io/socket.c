@@ -1849,6 +1849,175 @@ Return Value:
     return Status;
 }
 
+INTN
+IoSysSocketPerformBatchIo (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine handles the system call that sends or receives a batch of
+    messages on a socket.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    UINTN Completed;
+    PIO_BUFFER IoBuffer;
+    ULONG IoFlags;
+    PIO_HANDLE IoHandle;
+    SOCKET_IO_MESSAGE Message;
+    PSOCKET_IO_MESSAGE UserMessage;
+    PSYSTEM_CALL_SOCKET_PERFORM_BATCH_IO Parameters;
+    PKPROCESS Process;
+    KSTATUS Status;
+    BOOL Write;
+
+    Completed = 0;
+    Parameters = (PSYSTEM_CALL_SOCKET_PERFORM_BATCH_IO)SystemCallParameter;
+    IoFlags = Parameters->IoFlags & SYS_IO_FLAG_MASK;
+    Process = PsGetCurrentProcess();
+    Write = FALSE;
+    if ((IoFlags & SYS_IO_FLAG_WRITE) != 0) {
+        Write = TRUE;
+    }
+
+    ASSERT(SYS_WAIT_TIME_INDEFINITE == WAIT_TIME_INDEFINITE);
+
+    //
+    // Look up the handle once for the whole batch. This is the point of the
+    // batch, as the per-message cost is then just the protocol work.
+    //
+
+    IoHandle = ObGetHandleValue(Process->HandleTable, Parameters->Socket, NULL);
+    if (IoHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysSocketPerformBatchIoEnd;
+    }
+
+    Status = STATUS_SUCCESS;
+    while (Completed < Parameters->MessageCount) {
+        UserMessage = &(Parameters->Messages[Completed]);
+        Status = MmCopyFromUserMode(&Message,
+                                    UserMessage,
+                                    sizeof(SOCKET_IO_MESSAGE));
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        Message.Parameters.BytesCompleted = 0;
+        Message.Parameters.IoFlags = IoFlags;
+        Status = MmCreateIoBufferFromVector(Message.VectorArray,
+                                            FALSE,
+                                            Message.VectorCount,
+                                            &IoBuffer);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        //
+        // Non-blocking handles always have a timeout of zero. If the caller
+        // only wanted to wait for the first message, don't wait on any of
+        // the others either.
+        //
+
+        if (((IoHandle->OpenFlags & OPEN_FLAG_NON_BLOCKING) != 0) ||
+            ((Completed != 0) &&
+             ((Message.Parameters.SocketIoFlags &
+               SOCKET_IO_WAIT_FOR_ONE) != 0))) {
+
+            Message.Parameters.TimeoutInMilliseconds = 0;
+        }
+
+        if (Write != FALSE) {
+            Status = IoSocketSendData(FALSE,
+                                      IoHandle,
+                                      &(Message.Parameters),
+                                      IoBuffer);
+
+            //
+            // Send a pipe signal if the returning status was "broken pipe".
+            //
+
+            if (Status == STATUS_BROKEN_PIPE) {
+
+                ASSERT(Process != PsGetKernelProcess());
+
+                PsSignalProcess(Process, SIGNAL_BROKEN_PIPE, NULL);
+            }
+
+        } else {
+            Status = IoSocketReceiveData(FALSE,
+                                         IoHandle,
+                                         &(Message.Parameters),
+                                         IoBuffer);
+        }
+
+        MmFreeIoBuffer(IoBuffer);
+
+        //
+        // A message that partially completed still counts, since its data
+        // has already gone out or been consumed.
+        //
+
+        if ((!KSUCCESS(Status)) && (Message.Parameters.BytesCompleted == 0)) {
+            break;
+        }
+
+        MmCopyToUserMode(&(UserMessage->Parameters),
+                         &(Message.Parameters),
+                         sizeof(SOCKET_IO_PARAMETERS));
+
+        Completed += 1;
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+    }
+
+    //
+    // If some messages made it, report success. The error, if persistent,
+    // will come back on the next call.
+    //
+
+    if (Completed != 0) {
+        Status = STATUS_SUCCESS;
+    }
+
+SysSocketPerformBatchIoEnd:
+
+    //
+    // An interrupted socket cannot be restarted if a timeout has been set.
+    //
+
+    if (Status == STATUS_INTERRUPTED) {
+        Status = IopConvertInterruptedSocketStatus(IoHandle, 0, Write);
+    }
+
+    if (IoHandle != NULL) {
+        IoIoHandleReleaseReference(IoHandle);
+    }
+
+    Parameters->MessageCount = Completed;
+    return Status;
+}
+
 INTN
 IoSysSocketGetSetInformation (
     PVOID SystemCallParameter
@@ -0,0 +1,1371 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    watch.c
+
+Abstract:
+
+    This module implements file watch queues, which deliver notifications of
+    changes to watched files and directories. A watch queue is the read side
+    of an anonymous pipe. Watches attach to the file objects behind path
+    entries, and the I/O manager queues events to them as files are created,
+    deleted, written, truncated, renamed, or have their attributes changed.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Kernel
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <minoca/kernel/kernel.h>
+#include "iop.h"
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the default permissions for a watch queue's pipe.
+//
+
+#define FILE_WATCH_QUEUE_PERMISSIONS \
+    (FILE_PERMISSION_USER_READ | FILE_PERMISSION_USER_WRITE)
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines a file watch queue.
+
+Members:
+
+    Lock - Stores a pointer to the lock protecting the event list.
+
+    EventList - Stores the head of the list of queued events, oldest first.
+
+    EventCount - Stores the number of events on the event list.
+
+    WatchList - Stores the head of the list of watches owned by this queue.
+        This is protected by the global file watch lock.
+
+    NextDescriptor - Stores the descriptor to hand out to the next watch.
+        This is protected by the global file watch lock.
+
+    IoState - Stores a pointer to the I/O object state of the pipe that owns
+        the queue, which is signaled when events are queued.
+
+    Closed - Stores a boolean indicating whether the last handle to the queue
+        has been closed. This is protected by the global file watch lock.
+
+--*/
+
+struct _FILE_WATCH_QUEUE {
+    PQUEUED_LOCK Lock;
+    LIST_ENTRY EventList;
+    ULONG EventCount;
+    LIST_ENTRY WatchList;
+    LONG NextDescriptor;
+    PIO_OBJECT_STATE IoState;
+    BOOL Closed;
+};
+
+/*++
+
+Structure Description:
+
+    This structure defines a single watch on a file object.
+
+Members:
+
+    QueueListEntry - Stores pointers to the next and previous watches in the
+        queue.
+
+    FileListEntry - Stores pointers to the next and previous watches on the
+        file object.
+
+    Queue - Stores a pointer to the queue that receives the watch's events.
+
+    FileObject - Stores a pointer to the watched file object. The watch holds
+        a reference on it.
+
+    Descriptor - Stores the descriptor identifying the watch to user mode.
+
+    Events - Stores the bitmask of events the watch is interested in. See
+        FILE_WATCH_EVENT_* definitions.
+
+--*/
+
+typedef struct _FILE_WATCH {
+    LIST_ENTRY QueueListEntry;
+    LIST_ENTRY FileListEntry;
+    PFILE_WATCH_QUEUE Queue;
+    PFILE_OBJECT FileObject;
+    LONG Descriptor;
+    ULONG Events;
+} FILE_WATCH, *PFILE_WATCH;
+
+/*++
+
+Structure Description:
+
+    This structure defines an event sitting in a watch queue. The name, if
+    any, follows the event directly.
+
+Members:
+
+    ListEntry - Stores pointers to the next and previous events in the queue.
+
+    Event - Stores the event as it is returned to the reader.
+
+--*/
+
+typedef struct _FILE_WATCH_RECORD {
+    LIST_ENTRY ListEntry;
+    FILE_WATCH_EVENT Event;
+} FILE_WATCH_RECORD, *PFILE_WATCH_RECORD;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+IopQueueFileWatchEvent (
+    PFILE_WATCH_QUEUE Queue,
+    LONG Descriptor,
+    ULONG Events,
+    ULONG Cookie,
+    PCSTR Name,
+    ULONG NameSize
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the lock that protects the watch lists of every file object and
+// queue. Events are delivered with it held shared. It is a leaf lock apart
+// from the queue locks, so events can be delivered with file object locks
+// held.
+//
+
+PSHARED_EXCLUSIVE_LOCK IoFileWatchLock;
+
+//
+// Store the last cookie handed out to tie together the halves of a rename.
+//
+
+volatile ULONG IoFileWatchCookie;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+INTN
+IoSysCreateWatchQueue (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a file watch queue on behalf of a user mode
+    application.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PKPROCESS CurrentProcess;
+    ULONG HandleFlags;
+    ULONG OpenFlags;
+    PSYSTEM_CALL_CREATE_WATCH_QUEUE Parameters;
+    PIO_HANDLE QueueHandle;
+    KSTATUS Status;
+
+    CurrentProcess = PsGetCurrentProcess();
+
+    ASSERT(CurrentProcess != PsGetKernelProcess());
+
+    Parameters = (PSYSTEM_CALL_CREATE_WATCH_QUEUE)SystemCallParameter;
+    Parameters->Handle = INVALID_HANDLE;
+    QueueHandle = NULL;
+    if ((Parameters->OpenFlags &
+         ~(SYS_OPEN_FLAG_NON_BLOCKING | SYS_OPEN_FLAG_CLOSE_ON_EXECUTE)) != 0) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto SysCreateWatchQueueEnd;
+    }
+
+    OpenFlags = Parameters->OpenFlags & SYS_OPEN_FLAG_NON_BLOCKING;
+    Status = IopCreateFileWatchQueue(FALSE, OpenFlags, &QueueHandle);
+    if (!KSUCCESS(Status)) {
+        goto SysCreateWatchQueueEnd;
+    }
+
+    HandleFlags = 0;
+    if ((Parameters->OpenFlags & SYS_OPEN_FLAG_CLOSE_ON_EXECUTE) != 0) {
+        HandleFlags |= FILE_DESCRIPTOR_CLOSE_ON_EXECUTE;
+    }
+
+    Status = ObCreateHandle(CurrentProcess->HandleTable,
+                            QueueHandle,
+                            HandleFlags,
+                            &(Parameters->Handle));
+
+    if (!KSUCCESS(Status)) {
+        goto SysCreateWatchQueueEnd;
+    }
+
+    Status = STATUS_SUCCESS;
+
+SysCreateWatchQueueEnd:
+    if (!KSUCCESS(Status)) {
+        if (QueueHandle != NULL) {
+            IoClose(QueueHandle);
+        }
+    }
+
+    return Status;
+}
+
+INTN
+IoSysAddWatch (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a watch on a file or directory to a file watch queue on
+    behalf of a user mode application.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PKPROCESS CurrentProcess;
+    PIO_HANDLE Directory;
+    PSYSTEM_CALL_ADD_WATCH Parameters;
+    PSTR PathCopy;
+    PIO_HANDLE QueueHandle;
+    KSTATUS Status;
+
+    CurrentProcess = PsGetCurrentProcess();
+
+    ASSERT(CurrentProcess != PsGetKernelProcess());
+
+    Directory = NULL;
+    Parameters = (PSYSTEM_CALL_ADD_WATCH)SystemCallParameter;
+    Parameters->Descriptor = -1;
+    PathCopy = NULL;
+    QueueHandle = NULL;
+    Status = MmCreateCopyOfUserModeString(Parameters->Path,
+                                          Parameters->PathLength,
+                                          FI_ALLOCATION_TAG,
+                                          &PathCopy);
+
+    if (!KSUCCESS(Status)) {
+        goto SysAddWatchEnd;
+    }
+
+    QueueHandle = ObGetHandleValue(CurrentProcess->HandleTable,
+                                   Parameters->Queue,
+                                   NULL);
+
+    if (QueueHandle == NULL) {
+        Status = STATUS_INVALID_HANDLE;
+        goto SysAddWatchEnd;
+    }
+
+    if (Parameters->Directory != INVALID_HANDLE) {
+        Directory = ObGetHandleValue(CurrentProcess->HandleTable,
+                                     Parameters->Directory,
+                                     NULL);
+
+        if (Directory == NULL) {
+            Status = STATUS_INVALID_HANDLE;
+            goto SysAddWatchEnd;
+        }
+    }
+
+    Status = IopAddFileWatch(FALSE,
+                             QueueHandle,
+                             Directory,
+                             PathCopy,
+                             Parameters->PathLength,
+                             Parameters->Events,
+                             &(Parameters->Descriptor));
+
+SysAddWatchEnd:
+    if (QueueHandle != NULL) {
+        IoIoHandleReleaseReference(QueueHandle);
+    }
+
+    if (Directory != NULL) {
+        IoIoHandleReleaseReference(Directory);
+    }
+
+    if (PathCopy != NULL) {
+        MmFreePagedPool(PathCopy);
+    }
+
+    return Status;
+}
+
+INTN
+IoSysRemoveWatch (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a watch from a file watch queue on behalf of a user
+    mode application.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PKPROCESS CurrentProcess;
+    PSYSTEM_CALL_REMOVE_WATCH Parameters;
+    PIO_HANDLE QueueHandle;
+    KSTATUS Status;
+
+    CurrentProcess = PsGetCurrentProcess();
+
+    ASSERT(CurrentProcess != PsGetKernelProcess());
+
+    Parameters = (PSYSTEM_CALL_REMOVE_WATCH)SystemCallParameter;
+    QueueHandle = ObGetHandleValue(CurrentProcess->HandleTable,
+                                   Parameters->Queue,
+                                   NULL);
+
+    if (QueueHandle == NULL) {
+        return STATUS_INVALID_HANDLE;
+    }
+
+    Status = IopRemoveFileWatch(QueueHandle, Parameters->Descriptor);
+    IoIoHandleReleaseReference(QueueHandle);
+    return Status;
+}
+
+KSTATUS
+IopInitializeFileWatchSupport (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called during system initialization to set up support for
+    file watch queues.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    IoFileWatchLock = KeCreateSharedExclusiveLock();
+    if (IoFileWatchLock == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+IopCreateFileWatchQueue (
+    BOOL FromKernelMode,
+    ULONG OpenFlags,
+    PIO_HANDLE *Handle
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new file watch queue. The queue is the read side of
+    an anonymous pipe, from which file watch events are read.
+
+Arguments:
+
+    FromKernelMode - Supplies a boolean indicating whether this request is
+        originating from kernel mode or user mode.
+
+    OpenFlags - Supplies the open flags for the queue handle. See OPEN_FLAG_*
+        definitions.
+
+    Handle - Supplies a pointer where a handle to the new queue will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    CREATE_PARAMETERS Create;
+    PFILE_WATCH_QUEUE Queue;
+    KSTATUS Status;
+
+    *Handle = NULL;
+    Queue = MmAllocatePagedPool(sizeof(FILE_WATCH_QUEUE),
+                                FILE_WATCH_ALLOCATION_TAG);
+
+    if (Queue == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(Queue, sizeof(FILE_WATCH_QUEUE));
+    INITIALIZE_LIST_HEAD(&(Queue->EventList));
+    INITIALIZE_LIST_HEAD(&(Queue->WatchList));
+    Queue->NextDescriptor = 1;
+    Queue->Lock = KeCreateQueuedLock();
+    if (Queue->Lock == NULL) {
+        IopDestroyFileWatchQueue(Queue);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    //
+    // Once the pipe is created it owns the queue, and destroys it along with
+    // itself.
+    //
+
+    Create.Type = IoObjectPipe;
+    Create.Context = Queue;
+    Create.Permissions = FILE_WATCH_QUEUE_PERMISSIONS;
+    Create.Created = FALSE;
+    Status = IopOpen(FromKernelMode,
+                     NULL,
+                     NULL,
+                     0,
+                     IO_ACCESS_READ,
+                     OpenFlags | OPEN_FLAG_CREATE | OPEN_FLAG_FAIL_IF_EXISTS,
+                     &Create,
+                     Handle);
+
+    if ((!KSUCCESS(Status)) && (Create.Created == FALSE)) {
+        IopDestroyFileWatchQueue(Queue);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopAddFileWatch (
+    BOOL FromKernelMode,
+    PIO_HANDLE QueueHandle,
+    PIO_HANDLE Directory,
+    PCSTR Path,
+    ULONG PathLength,
+    ULONG Events,
+    PLONG Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds a watch on a file or directory to a file watch queue. If
+    the queue already watches the file, the existing watch is updated instead.
+
+Arguments:
+
+    FromKernelMode - Supplies a boolean indicating whether this request is
+        originating from kernel mode or user mode.
+
+    QueueHandle - Supplies a pointer to an open handle to the watch queue.
+
+    Directory - Supplies an optional pointer to an open handle to a directory
+        for relative paths. Supply NULL to use the current working directory.
+
+    Path - Supplies a pointer to the path of the file or directory to watch.
+
+    PathLength - Supplies the length of the path buffer in bytes, including the
+        null terminator.
+
+    Events - Supplies the bitmask of events to watch for, combined with any
+        flags. See FILE_WATCH_EVENT_* and FILE_WATCH_FLAG_* definitions.
+
+    Descriptor - Supplies a pointer where the descriptor for the watch will be
+        returned on success.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PIO_HANDLE FileHandle;
+    PFILE_OBJECT FileObject;
+    BOOL LockHeld;
+    PFILE_WATCH NewWatch;
+    ULONG OpenFlags;
+    PFILE_WATCH_QUEUE Queue;
+    KSTATUS Status;
+    PFILE_WATCH Watch;
+
+    FileHandle = NULL;
+    LockHeld = FALSE;
+    NewWatch = NULL;
+    Queue = IopGetFileWatchQueue(QueueHandle);
+    if (Queue == NULL) {
+        Status = STATUS_INVALID_PARAMETER;
+        goto AddFileWatchEnd;
+    }
+
+    if (((Events & FILE_WATCH_EVENT_MASK) == 0) ||
+        ((Events & ~(FILE_WATCH_EVENT_MASK | FILE_WATCH_FLAG_MASK)) != 0)) {
+
+        Status = STATUS_INVALID_PARAMETER;
+        goto AddFileWatchEnd;
+    }
+
+    //
+    // Open the path just for information, the same way getting its
+    // properties does, and then make sure the caller can read it.
+    //
+
+    OpenFlags = 0;
+    if ((Events & FILE_WATCH_FLAG_NO_FOLLOW) != 0) {
+        OpenFlags |= OPEN_FLAG_SYMBOLIC_LINK;
+    }
+
+    if ((Events & FILE_WATCH_FLAG_DIRECTORY) != 0) {
+        OpenFlags |= OPEN_FLAG_DIRECTORY;
+    }
+
+    Status = IoOpen(FromKernelMode,
+                    Directory,
+                    Path,
+                    PathLength,
+                    0,
+                    OpenFlags,
+                    FILE_PERMISSION_NONE,
+                    &FileHandle);
+
+    if (!KSUCCESS(Status)) {
+        goto AddFileWatchEnd;
+    }
+
+    Status = IopCheckPermissions(FromKernelMode,
+                                 &(FileHandle->PathPoint),
+                                 IO_ACCESS_READ);
+
+    if (!KSUCCESS(Status)) {
+        goto AddFileWatchEnd;
+    }
+
+    FileObject = FileHandle->PathPoint.PathEntry->FileObject;
+    NewWatch = MmAllocatePagedPool(sizeof(FILE_WATCH),
+                                   FILE_WATCH_ALLOCATION_TAG);
+
+    if (NewWatch == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto AddFileWatchEnd;
+    }
+
+    KeAcquireSharedExclusiveLockExclusive(IoFileWatchLock);
+    LockHeld = TRUE;
+    if (Queue->Closed != FALSE) {
+        Status = STATUS_TOO_LATE;
+        goto AddFileWatchEnd;
+    }
+
+    //
+    // A queue has at most one watch per file. Adding the same file again
+    // replaces or adds to the events of the existing watch.
+    //
+
+    CurrentEntry = FileObject->WatchList.Next;
+    while (CurrentEntry != &(FileObject->WatchList)) {
+        Watch = LIST_VALUE(CurrentEntry, FILE_WATCH, FileListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        if (Watch->Queue != Queue) {
+            continue;
+        }
+
+        if ((Events & FILE_WATCH_FLAG_ADD) != 0) {
+            Watch->Events |= Events & FILE_WATCH_EVENT_MASK;
+
+        } else {
+            Watch->Events = Events & FILE_WATCH_EVENT_MASK;
+        }
+
+        *Descriptor = Watch->Descriptor;
+        Status = STATUS_SUCCESS;
+        goto AddFileWatchEnd;
+    }
+
+    NewWatch->Queue = Queue;
+    NewWatch->FileObject = FileObject;
+    NewWatch->Descriptor = Queue->NextDescriptor;
+    NewWatch->Events = Events & FILE_WATCH_EVENT_MASK;
+    Queue->NextDescriptor += 1;
+    IopFileObjectAddReference(FileObject);
+    INSERT_BEFORE(&(NewWatch->FileListEntry), &(FileObject->WatchList));
+    INSERT_BEFORE(&(NewWatch->QueueListEntry), &(Queue->WatchList));
+    *Descriptor = NewWatch->Descriptor;
+    NewWatch = NULL;
+    Status = STATUS_SUCCESS;
+
+AddFileWatchEnd:
+    if (LockHeld != FALSE) {
+        KeReleaseSharedExclusiveLockExclusive(IoFileWatchLock);
+    }
+
+    if (NewWatch != NULL) {
+        MmFreePagedPool(NewWatch);
+    }
+
+    if (FileHandle != NULL) {
+        IoClose(FileHandle);
+    }
+
+    return Status;
+}
+
+KSTATUS
+IopRemoveFileWatch (
+    PIO_HANDLE QueueHandle,
+    LONG Descriptor
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes a watch from a file watch queue, queuing a final
+    ignored event for it.
+
+Arguments:
+
+    QueueHandle - Supplies a pointer to an open handle to the watch queue.
+
+    Descriptor - Supplies the descriptor of the watch to remove.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PFILE_WATCH_QUEUE Queue;
+    PFILE_WATCH Watch;
+
+    Queue = IopGetFileWatchQueue(QueueHandle);
+    if (Queue == NULL) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    KeAcquireSharedExclusiveLockExclusive(IoFileWatchLock);
+    CurrentEntry = Queue->WatchList.Next;
+    while (CurrentEntry != &(Queue->WatchList)) {
+        Watch = LIST_VALUE(CurrentEntry, FILE_WATCH, QueueListEntry);
+        if (Watch->Descriptor == Descriptor) {
+            break;
+        }
+
+        CurrentEntry = CurrentEntry->Next;
+    }
+
+    if (CurrentEntry == &(Queue->WatchList)) {
+        KeReleaseSharedExclusiveLockExclusive(IoFileWatchLock);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    LIST_REMOVE(&(Watch->QueueListEntry));
+    LIST_REMOVE(&(Watch->FileListEntry));
+    KeReleaseSharedExclusiveLockExclusive(IoFileWatchLock);
+    IopQueueFileWatchEvent(Queue,
+                           Descriptor,
+                           FILE_WATCH_EVENT_IGNORED,
+                           0,
+                           NULL,
+                           0);
+
+    IopFileObjectReleaseReference(Watch->FileObject);
+    MmFreePagedPool(Watch);
+    return STATUS_SUCCESS;
+}
+
+VOID
+IopCloseFileWatchQueue (
+    PFILE_WATCH_QUEUE Queue
+    )
+
+/*++
+
+Routine Description:
+
+    This routine removes all the watches from a file watch queue. It is called
+    when the last handle to the queue is closed.
+
+Arguments:
+
+    Queue - Supplies a pointer to the watch queue.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    LIST_ENTRY WatchList;
+    PFILE_WATCH Watch;
+
+    //
+    // Pull every watch off its file under the lock, and then release the file
+    // object references once nothing is held.
+    //
+
+    INITIALIZE_LIST_HEAD(&WatchList);
+    KeAcquireSharedExclusiveLockExclusive(IoFileWatchLock);
+    Queue->Closed = TRUE;
+    while (LIST_EMPTY(&(Queue->WatchList)) == FALSE) {
+        Watch = LIST_VALUE(Queue->WatchList.Next, FILE_WATCH, QueueListEntry);
+        LIST_REMOVE(&(Watch->QueueListEntry));
+        LIST_REMOVE(&(Watch->FileListEntry));
+        INSERT_BEFORE(&(Watch->QueueListEntry), &WatchList);
+    }
+
+    KeReleaseSharedExclusiveLockExclusive(IoFileWatchLock);
+    while (LIST_EMPTY(&WatchList) == FALSE) {
+        Watch = LIST_VALUE(WatchList.Next, FILE_WATCH, QueueListEntry);
+        LIST_REMOVE(&(Watch->QueueListEntry));
+        IopFileObjectReleaseReference(Watch->FileObject);
+        MmFreePagedPool(Watch);
+    }
+
+    return;
+}
+
+VOID
+IopDestroyFileWatchQueue (
+    PFILE_WATCH_QUEUE Queue
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys a file watch queue and any events still in it. The
+    queue must have no watches left.
+
+Arguments:
+
+    Queue - Supplies a pointer to the watch queue.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PFILE_WATCH_RECORD Record;
+
+    ASSERT(LIST_EMPTY(&(Queue->WatchList)) != FALSE);
+
+    while (LIST_EMPTY(&(Queue->EventList)) == FALSE) {
+        Record = LIST_VALUE(Queue->EventList.Next,
+                            FILE_WATCH_RECORD,
+                            ListEntry);
+
+        LIST_REMOVE(&(Record->ListEntry));
+        MmFreePagedPool(Record);
+    }
+
+    if (Queue->Lock != NULL) {
+        KeDestroyQueuedLock(Queue->Lock);
+    }
+
+    MmFreePagedPool(Queue);
+    return;
+}
+
+VOID
+IopConnectFileWatchQueue (
+    PFILE_WATCH_QUEUE Queue,
+    PIO_OBJECT_STATE IoState
+    )
+
+/*++
+
+Routine Description:
+
+    This routine connects a file watch queue to the I/O object state of the
+    pipe that owns it, which is signaled when events are queued.
+
+Arguments:
+
+    Queue - Supplies a pointer to the watch queue.
+
+    IoState - Supplies a pointer to the owning pipe's I/O object state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(Queue->IoState == NULL);
+
+    Queue->IoState = IoState;
+    IoSetIoObjectState(IoState, POLL_EVENT_IN | POLL_EVENT_OUT, FALSE);
+    return;
+}
+
+KSTATUS
+IopReadFileWatchQueue (
+    PFILE_WATCH_QUEUE Queue,
+    PIO_CONTEXT IoContext
+    )
+
+/*++
+
+Routine Description:
+
+    This routine reads whole events out of a file watch queue, blocking until
+    at least one is available unless the timeout is zero.
+
+Arguments:
+
+    Queue - Supplies a pointer to the watch queue.
+
+    IoContext - Supplies a pointer to the I/O context.
+
+Return Value:
+
+    STATUS_SUCCESS if at least one event was read.
+
+    STATUS_BUFFER_TOO_SMALL if the first event does not fit in the buffer.
+
+    STATUS_TIMEOUT if there are no events and the timeout expired.
+
+    Other error codes on failure.
+
+--*/
+
+{
+
+    UINTN BytesRead;
+    ULONG ReadCount;
+    LIST_ENTRY ReadList;
+    PFILE_WATCH_RECORD Record;
+    UINTN Size;
+    KSTATUS Status;
+
+    INITIALIZE_LIST_HEAD(&ReadList);
+    BytesRead = 0;
+    ReadCount = 0;
+    Status = STATUS_SUCCESS;
+    while (TRUE) {
+        Status = IoWaitForIoObjectState(Queue->IoState,
+                                        POLL_EVENT_IN,
+                                        TRUE,
+                                        IoContext->TimeoutInMilliseconds,
+                                        NULL);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        //
+        // Take as many whole events as fit. Another reader may have beaten
+        // this one to the events, in which case go back to waiting.
+        //
+
+        KeAcquireQueuedLock(Queue->Lock);
+        while (LIST_EMPTY(&(Queue->EventList)) == FALSE) {
+            Record = LIST_VALUE(Queue->EventList.Next,
+                                FILE_WATCH_RECORD,
+                                ListEntry);
+
+            Size = sizeof(FILE_WATCH_EVENT) + Record->Event.NameSize;
+            if (BytesRead + Size > IoContext->SizeInBytes) {
+                if (BytesRead == 0) {
+                    Status = STATUS_BUFFER_TOO_SMALL;
+                }
+
+                break;
+            }
+
+            LIST_REMOVE(&(Record->ListEntry));
+            INSERT_BEFORE(&(Record->ListEntry), &ReadList);
+            Queue->EventCount -= 1;
+            ReadCount += 1;
+            BytesRead += Size;
+        }
+
+        if (LIST_EMPTY(&(Queue->EventList)) != FALSE) {
+            IoSetIoObjectState(Queue->IoState, POLL_EVENT_IN, FALSE);
+        }
+
+        KeReleaseQueuedLock(Queue->Lock);
+        if ((BytesRead != 0) || (!KSUCCESS(Status))) {
+            break;
+        }
+    }
+
+    //
+    // Copy the events out with the queue unlocked, as touching the caller's
+    // buffer may fault.
+    //
+
+    BytesRead = 0;
+    while (LIST_EMPTY(&ReadList) == FALSE) {
+        Record = LIST_VALUE(ReadList.Next, FILE_WATCH_RECORD, ListEntry);
+        Size = sizeof(FILE_WATCH_EVENT) + Record->Event.NameSize;
+        Status = MmCopyIoBufferData(IoContext->IoBuffer,
+                                    &(Record->Event),
+                                    BytesRead,
+                                    Size,
+                                    TRUE);
+
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        LIST_REMOVE(&(Record->ListEntry));
+        MmFreePagedPool(Record);
+        ReadCount -= 1;
+        BytesRead += Size;
+    }
+
+    //
+    // If the copy failed partway through, put the events that didn't make it
+    // back at the head of the queue, in their original order. Events already
+    // copied are reported as a short read rather than thrown away with an
+    // error; the failure resurfaces on the next read.
+    //
+
+    if (LIST_EMPTY(&ReadList) == FALSE) {
+        if (BytesRead != 0) {
+            Status = STATUS_SUCCESS;
+        }
+
+        KeAcquireQueuedLock(Queue->Lock);
+        if (LIST_EMPTY(&(Queue->EventList)) == FALSE) {
+            APPEND_LIST(&(Queue->EventList), &ReadList);
+        }
+
+        MOVE_LIST(&ReadList, &(Queue->EventList));
+        Queue->EventCount += ReadCount;
+        IoSetIoObjectState(Queue->IoState, POLL_EVENT_IN, TRUE);
+        KeReleaseQueuedLock(Queue->Lock);
+    }
+
+    IoContext->BytesCompleted = BytesRead;
+    return Status;
+}
+
+VOID
+IopNotifyFileWatches (
+    PFILE_OBJECT FileObject,
+    ULONG Events,
+    ULONG Cookie,
+    PCSTR Name,
+    ULONG NameSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues an event to every watch on the given file object that
+    is interested in it.
+
+Arguments:
+
+    FileObject - Supplies a pointer to the file object the event occurred on.
+
+    Events - Supplies the bitmask of events that occurred. See
+        FILE_WATCH_EVENT_* definitions.
+
+    Cookie - Supplies the cookie tying together the two halves of a rename, or
+        zero.
+
+    Name - Supplies an optional pointer to the name of the directory entry the
+        event is about, for events on directories.
+
+    NameSize - Supplies the size of the name in bytes, including the null
+        terminator.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PLIST_ENTRY CurrentEntry;
+    PFILE_WATCH Watch;
+
+    //
+    // Almost nothing is watched, so avoid the lock entirely in that case. A
+    // watch racing to be added may miss this event, which is fine since it
+    // was not in place when the event happened.
+    //
+
+    if (LIST_EMPTY(&(FileObject->WatchList)) != FALSE) {
+        return;
+    }
+
+    KeAcquireSharedExclusiveLockShared(IoFileWatchLock);
+    CurrentEntry = FileObject->WatchList.Next;
+    while (CurrentEntry != &(FileObject->WatchList)) {
+        Watch = LIST_VALUE(CurrentEntry, FILE_WATCH, FileListEntry);
+        CurrentEntry = CurrentEntry->Next;
+        if ((Watch->Events & Events & FILE_WATCH_EVENT_MASK) != 0) {
+            IopQueueFileWatchEvent(Watch->Queue,
+                                   Watch->Descriptor,
+                                   Events,
+                                   Cookie,
+                                   Name,
+                                   NameSize);
+        }
+    }
+
+    KeReleaseSharedExclusiveLockShared(IoFileWatchLock);
+    return;
+}
+
+VOID
+IopNotifyPathEntryWatches (
+    PPATH_ENTRY PathEntry,
+    ULONG Events
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues an event to the watches on a path entry's file object,
+    and to the watches on its parent directory along with the entry's name.
+
+Arguments:
+
+    PathEntry - Supplies a pointer to the path entry the event occurred on.
+
+    Events - Supplies the bitmask of events that occurred. See
+        FILE_WATCH_EVENT_* definitions.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PFILE_OBJECT FileObject;
+    PPATH_ENTRY Parent;
+
+    FileObject = PathEntry->FileObject;
+    Events = IO_FILE_WATCH_EVENTS(Events, FileObject->Properties.Type);
+    IopNotifyFileWatches(FileObject, Events, 0, NULL, 0);
+    Parent = PathEntry->Parent;
+    if ((Parent != NULL) && (Parent->FileObject != NULL) &&
+        (PathEntry->Name != NULL)) {
+
+        IopNotifyFileWatches(Parent->FileObject,
+                             Events,
+                             0,
+                             PathEntry->Name,
+                             PathEntry->NameSize);
+    }
+
+    return;
+}
+
+VOID
+IopNotifyFileWatchesOfRename (
+    PFILE_OBJECT SourceDirectory,
+    PCSTR SourceName,
+    ULONG SourceNameSize,
+    PFILE_OBJECT DestinationDirectory,
+    PCSTR DestinationName,
+    ULONG DestinationNameSize,
+    PFILE_OBJECT FileObject
+    )
+
+/*++
+
+Routine Description:
+
+    This routine queues the events for a successful rename: a moved from event
+    in the source directory and a moved to event in the destination, sharing a
+    cookie, and a move self event on the renamed file.
+
+Arguments:
+
+    SourceDirectory - Supplies a pointer to the source directory.
+
+    SourceName - Supplies a pointer to the old name of the file.
+
+    SourceNameSize - Supplies the size of the old name in bytes, including the
+        null terminator.
+
+    DestinationDirectory - Supplies a pointer to the destination directory.
+
+    DestinationName - Supplies a pointer to the new name of the file.
+
+    DestinationNameSize - Supplies the size of the new name in bytes,
+        including the null terminator.
+
+    FileObject - Supplies a pointer to the file that was renamed.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Cookie;
+    ULONG Events;
+    IO_OBJECT_TYPE Type;
+
+    if ((LIST_EMPTY(&(SourceDirectory->WatchList)) != FALSE) &&
+        (LIST_EMPTY(&(DestinationDirectory->WatchList)) != FALSE) &&
+        (LIST_EMPTY(&(FileObject->WatchList)) != FALSE)) {
+
+        return;
+    }
+
+    Cookie = RtlAtomicAdd32(&IoFileWatchCookie, 1) + 1;
+    Type = FileObject->Properties.Type;
+    Events = IO_FILE_WATCH_EVENTS(FILE_WATCH_EVENT_MOVED_FROM, Type);
+    IopNotifyFileWatches(SourceDirectory,
+                         Events,
+                         Cookie,
+                         SourceName,
+                         SourceNameSize);
+
+    Events = IO_FILE_WATCH_EVENTS(FILE_WATCH_EVENT_MOVED_TO, Type);
+    IopNotifyFileWatches(DestinationDirectory,
+                         Events,
+                         Cookie,
+                         DestinationName,
+                         DestinationNameSize);
+
+    Events = IO_FILE_WATCH_EVENTS(FILE_WATCH_EVENT_MOVE_SELF, Type);
+    IopNotifyFileWatches(FileObject, Events, 0, NULL, 0);
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+IopQueueFileWatchEvent (
+    PFILE_WATCH_QUEUE Queue,
+    LONG Descriptor,
+    ULONG Events,
+    ULONG Cookie,
+    PCSTR Name,
+    ULONG NameSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine adds an event to a watch queue. An event identical to the
+    last one queued is dropped, so a stream of writes to a file only shows up
+    once until the reader catches up. If the queue is full, the event is
+    dropped and a single overflow event is queued in its place.
+
+Arguments:
+
+    Queue - Supplies a pointer to the watch queue.
+
+    Descriptor - Supplies the descriptor of the watch the event belongs to.
+
+    Events - Supplies the bitmask of events that occurred.
+
+    Cookie - Supplies the rename cookie, or zero.
+
+    Name - Supplies an optional pointer to the name the event is about.
+
+    NameSize - Supplies the size of the name in bytes, including the null
+        terminator.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG AllocationSize;
+    PFILE_WATCH_RECORD Last;
+    PSTR LastName;
+    ULONG PaddedSize;
+    PFILE_WATCH_RECORD Record;
+    PSTR RecordName;
+
+    //
+    // Pad the name so the event after it stays aligned.
+    //
+
+    PaddedSize = 0;
+    if ((Name != NULL) && (NameSize != 0)) {
+        PaddedSize = ALIGN_RANGE_UP(NameSize, sizeof(FILE_WATCH_EVENT));
+    }
+
+    AllocationSize = sizeof(FILE_WATCH_RECORD) + PaddedSize;
+    Record = MmAllocatePagedPool(AllocationSize, FILE_WATCH_ALLOCATION_TAG);
+    if (Record == NULL) {
+        return;
+    }
+
+    RtlZeroMemory(Record, AllocationSize);
+    Record->Event.Descriptor = Descriptor;
+    Record->Event.Events = Events;
+    Record->Event.Cookie = Cookie;
+    Record->Event.NameSize = PaddedSize;
+    RecordName = (PSTR)(&(Record->Event) + 1);
+    if (PaddedSize != 0) {
+        RtlStringCopy(RecordName, Name, NameSize);
+    }
+
+    KeAcquireQueuedLock(Queue->Lock);
+    if (LIST_EMPTY(&(Queue->EventList)) == FALSE) {
+        Last = LIST_VALUE(Queue->EventList.Previous,
+                          FILE_WATCH_RECORD,
+                          ListEntry);
+
+        //
+        // Coalesce with the event at the tail if it's the same.
+        //
+
+        LastName = (PSTR)(&(Last->Event) + 1);
+        if ((Last->Event.Descriptor == Descriptor) &&
+            (Last->Event.Events == Events) &&
+            (Last->Event.Cookie == Cookie) &&
+            (Last->Event.NameSize == PaddedSize) &&
+            (RtlCompareMemory(LastName, RecordName, PaddedSize) != FALSE)) {
+
+            goto QueueFileWatchEventEnd;
+        }
+
+        //
+        // If the queue is full, queue one overflow event and then drop
+        // everything until the reader drains it.
+        //
+
+        if (Queue->EventCount >= FILE_WATCH_MAX_QUEUED_EVENTS) {
+            if (Last->Event.Events == FILE_WATCH_EVENT_OVERFLOW) {
+                goto QueueFileWatchEventEnd;
+            }
+
+            Record->Event.Descriptor = -1;
+            Record->Event.Events = FILE_WATCH_EVENT_OVERFLOW;
+            Record->Event.Cookie = 0;
+            Record->Event.NameSize = 0;
+        }
+    }
+
+    INSERT_BEFORE(&(Record->ListEntry), &(Queue->EventList));
+    Queue->EventCount += 1;
+    Record = NULL;
+    IoSetIoObjectState(Queue->IoState, POLL_EVENT_IN, TRUE);
+
+QueueFileWatchEventEnd:
+    KeReleaseQueuedLock(Queue->Lock);
+    if (Record != NULL) {
+        MmFreePagedPool(Record);
+    }
+
+    return;
+}
+
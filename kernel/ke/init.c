@@ -262,6 +262,16 @@ Return Value:
             goto InitializeEnd;
         }
 
+        //
+        // Create the processor's random number generator.
+        //
+
+        ProcessorBlock->RandomData = KepCreateRandomData();
+        if (ProcessorBlock->RandomData == NULL) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto InitializeEnd;
+        }
+
         //
         // Perform architecture-specific setup for the user shared data page.
         //
@@ -524,6 +534,12 @@ Return Value:
     UserSharedData->ProcessorCounterFrequency =
                                             HlQueryProcessorCounterFrequency();
 
+    if (HlQueryUserTimeCounter(&(UserSharedData->TimeCounterOffset)) !=
+        FALSE) {
+
+        UserSharedData->TimeCounterFlags |= USER_TIME_COUNTER_READABLE;
+    }
+
     //
     // If no calendar services are around, set this to the boot time and go
     // from there.
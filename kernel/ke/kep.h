@@ -467,6 +467,30 @@ Return Value:
 
 --*/
 
+PKRANDOM_DATA
+KepCreateRandomData (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine creates the random number generator for a new processor. The
+    generator is seeded from the system random source on first use.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a pointer to the random data on success.
+
+    NULL on allocation failure.
+
+--*/
+
 VOID
 KepInitializeScheduler (
     PPROCESSOR_BLOCK ProcessorBlock
@@ -13,7 +13,10 @@ Module Name:
 
 Abstract:
 
-    This module implements kernel-wide entropy management.
+    This module implements kernel-wide entropy management. Random bytes are
+    served from a ChaCha20 generator on each processor, which is periodically
+    reseeded from the system's pseudo-random source. This keeps the common
+    path free of any shared lock.
 
 Author:
 
@@ -31,20 +34,97 @@ Module Name:
 
 #include <minoca/kernel/kernel.h>
 #include <minoca/intrface/random.h>
+#include <minoca/lib/crypto.h>
 #include "kep.h"
 
 //
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the size of the key stream buffer each processor keeps. The first
+// key-sized piece of every refill becomes the next key, so earlier output
+// can't be reconstructed from the generator's state.
+//
+
+#define KE_RANDOM_BUFFER_SIZE 512
+
+//
+// Define the number of bytes generated at dispatch level at a time. Output
+// is bounced through the stack so that callers' buffers can be paged.
+//
+
+#define KE_RANDOM_CHUNK_SIZE 256
+
+//
+// Define how often each processor's generator is rekeyed from the system
+// random source, by bytes produced and by time.
+//
+
+#define KE_RANDOM_RESEED_BYTES (1024 * 1024)
+#define KE_RANDOM_RESEED_INTERVAL_SECONDS 300
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure defines the random number generator state for a single
+    processor. It is only touched at dispatch level on its own processor.
+
+Members:
+
+    Key - Stores the current ChaCha20 key.
+
+    Buffer - Stores key stream that has been generated but not yet handed
+        out. Bytes are zeroed as they are consumed.
+
+    Available - Stores the number of unused bytes at the end of the buffer.
+
+    BytesSinceReseed - Stores the number of bytes handed out since the
+        generator was last reseeded.
+
+    NextReseedTime - Stores the recent time counter value after which the
+        generator should be reseeded.
+
+    Seeded - Stores a boolean indicating whether the generator has been
+        seeded from the system random source yet.
+
+--*/
+
+struct _KRANDOM_DATA {
+    UCHAR Key[CHACHA20_KEY_SIZE];
+    UCHAR Buffer[KE_RANDOM_BUFFER_SIZE];
+    UINTN Available;
+    UINTN BytesSinceReseed;
+    ULONGLONG NextReseedTime;
+    BOOL Seeded;
+};
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+KSTATUS
+KepGetRandomChunk (
+    PVOID Buffer,
+    UINTN Size
+    );
+
+VOID
+KepReseedRandomData (
+    PKRANDOM_DATA Data,
+    PINTERFACE_PSEUDO_RANDOM_SOURCE Interface
+    );
+
+VOID
+KepRefillRandomData (
+    PKRANDOM_DATA Data
+    );
+
 VOID
 KepPseudoRandomInterfaceCallback (
     PVOID Context,
@@ -102,15 +182,101 @@ Return Value:
 
 {
 
-    PINTERFACE_PSEUDO_RANDOM_SOURCE Interface;
+    UCHAR Chunk[KE_RANDOM_CHUNK_SIZE];
+    UINTN ChunkSize;
+    KSTATUS Status;
 
-    Interface = KePseudoRandomInterface;
-    if (Interface == NULL) {
-        return STATUS_NO_SUCH_DEVICE;
+    Status = STATUS_SUCCESS;
+    while (Size != 0) {
+        ChunkSize = KE_RANDOM_CHUNK_SIZE;
+        if (ChunkSize > Size) {
+            ChunkSize = Size;
+        }
+
+        Status = KepGetRandomChunk(Chunk, ChunkSize);
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        RtlCopyMemory(Buffer, Chunk, ChunkSize);
+        Buffer += ChunkSize;
+        Size -= ChunkSize;
     }
 
-    Interface->GetBytes(Interface, Buffer, Size);
-    return STATUS_SUCCESS;
+    RtlZeroMemory(Chunk, sizeof(Chunk));
+    return Status;
+}
+
+INTN
+KeSysGetRandomBytes (
+    PVOID SystemCallParameter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine implements the system call for getting random bytes.
+
+Arguments:
+
+    SystemCallParameter - Supplies a pointer to the parameters supplied with
+        the system call. This structure will be a stack-local copy of the
+        actual parameters passed from user-mode.
+
+Return Value:
+
+    STATUS_SUCCESS or positive integer on success.
+
+    Error status code on failure.
+
+--*/
+
+{
+
+    PVOID Buffer;
+    UCHAR Chunk[KE_RANDOM_CHUNK_SIZE];
+    UINTN ChunkSize;
+    UINTN Completed;
+    PSYSTEM_CALL_GET_RANDOM_BYTES Parameters;
+    UINTN Size;
+    KSTATUS Status;
+
+    Parameters = (PSYSTEM_CALL_GET_RANDOM_BYTES)SystemCallParameter;
+    Buffer = Parameters->Buffer;
+    Size = Parameters->Size;
+    if (Size > SYS_RANDOM_MAX_SIZE) {
+        Size = SYS_RANDOM_MAX_SIZE;
+    }
+
+    Completed = 0;
+    Status = STATUS_SUCCESS;
+    while (Completed < Size) {
+        ChunkSize = KE_RANDOM_CHUNK_SIZE;
+        if (ChunkSize > Size - Completed) {
+            ChunkSize = Size - Completed;
+        }
+
+        Status = KepGetRandomChunk(Chunk, ChunkSize);
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        Status = MmCopyToUserMode(Buffer + Completed, Chunk, ChunkSize);
+        if (!KSUCCESS(Status)) {
+            break;
+        }
+
+        Completed += ChunkSize;
+    }
+
+    RtlZeroMemory(Chunk, sizeof(Chunk));
+    Parameters->Size = Completed;
+    if (Completed != 0) {
+        Status = STATUS_SUCCESS;
+    }
+
+    return Status;
 }
 
 KSTATUS
@@ -155,6 +321,43 @@ Return Value:
     return STATUS_SUCCESS;
 }
 
+PKRANDOM_DATA
+KepCreateRandomData (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates the random number generator for a new processor. The
+    generator is seeded from the system random source on first use.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns a pointer to the random data on success.
+
+    NULL on allocation failure.
+
+--*/
+
+{
+
+    PKRANDOM_DATA Data;
+
+    Data = MmAllocateNonPagedPool(sizeof(KRANDOM_DATA), KE_ALLOCATION_TAG);
+    if (Data == NULL) {
+        return NULL;
+    }
+
+    RtlZeroMemory(Data, sizeof(KRANDOM_DATA));
+    return Data;
+}
+
 VOID
 KepAddTimePointEntropy (
     VOID
@@ -193,6 +396,180 @@ Return Value:
 // --------------------------------------------------------- Internal Functions
 //
 
+KSTATUS
+KepGetRandomChunk (
+    PVOID Buffer,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine fills a buffer from the current processor's random number
+    generator, reseeding it first if it is due.
+
+Arguments:
+
+    Buffer - Supplies a pointer to the non-paged buffer to fill.
+
+    Size - Supplies the number of bytes to return.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_NO_SUCH_DEVICE if no pseudo-random interface is present.
+
+--*/
+
+{
+
+    UINTN Count;
+    PKRANDOM_DATA Data;
+    PINTERFACE_PSEUDO_RANDOM_SOURCE Interface;
+    RUNLEVEL OldRunLevel;
+    PUCHAR Output;
+    PUCHAR Source;
+
+    ASSERT(KeGetRunLevel() <= RunLevelDispatch);
+
+    Interface = KePseudoRandomInterface;
+    if (Interface == NULL) {
+        return STATUS_NO_SUCH_DEVICE;
+    }
+
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    Data = KeGetCurrentProcessorBlock()->RandomData;
+
+    //
+    // Processors that haven't set up a generator go straight to the source.
+    //
+
+    if (Data == NULL) {
+        Interface->GetBytes(Interface, Buffer, Size);
+        KeLowerRunLevel(OldRunLevel);
+        return STATUS_SUCCESS;
+    }
+
+    if ((Data->Seeded == FALSE) ||
+        (Data->BytesSinceReseed >= KE_RANDOM_RESEED_BYTES) ||
+        (KeGetRecentTimeCounter() >= Data->NextReseedTime)) {
+
+        KepReseedRandomData(Data, Interface);
+    }
+
+    Output = Buffer;
+    Data->BytesSinceReseed += Size;
+    while (Size != 0) {
+        if (Data->Available == 0) {
+            KepRefillRandomData(Data);
+        }
+
+        Count = Data->Available;
+        if (Count > Size) {
+            Count = Size;
+        }
+
+        Source = &(Data->Buffer[KE_RANDOM_BUFFER_SIZE - Data->Available]);
+        RtlCopyMemory(Output, Source, Count);
+        RtlZeroMemory(Source, Count);
+        Data->Available -= Count;
+        Output += Count;
+        Size -= Count;
+    }
+
+    KeLowerRunLevel(OldRunLevel);
+    return STATUS_SUCCESS;
+}
+
+VOID
+KepReseedRandomData (
+    PKRANDOM_DATA Data,
+    PINTERFACE_PSEUDO_RANDOM_SOURCE Interface
+    )
+
+/*++
+
+Routine Description:
+
+    This routine mixes fresh bytes from the system random source into a
+    processor's generator key and throws away any buffered output. This
+    routine runs at dispatch level.
+
+Arguments:
+
+    Data - Supplies a pointer to the generator to reseed.
+
+    Interface - Supplies a pointer to the system random source.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONGLONG Frequency;
+    UINTN Index;
+    UCHAR Seed[CHACHA20_KEY_SIZE];
+
+    Interface->GetBytes(Interface, Seed, sizeof(Seed));
+    for (Index = 0; Index < CHACHA20_KEY_SIZE; Index += 1) {
+        Data->Key[Index] ^= Seed[Index];
+    }
+
+    RtlZeroMemory(Seed, sizeof(Seed));
+    RtlZeroMemory(Data->Buffer, sizeof(Data->Buffer));
+    Data->Available = 0;
+    Data->BytesSinceReseed = 0;
+    Frequency = HlQueryTimeCounterFrequency();
+    Data->NextReseedTime = KeGetRecentTimeCounter() +
+                           (Frequency * KE_RANDOM_RESEED_INTERVAL_SECONDS);
+
+    Data->Seeded = TRUE;
+    return;
+}
+
+VOID
+KepRefillRandomData (
+    PKRANDOM_DATA Data
+    )
+
+/*++
+
+Routine Description:
+
+    This routine refills a processor's key stream buffer. The start of the new
+    key stream replaces the key and is wiped from the buffer, so the state
+    left behind can't be used to recover anything already handed out.
+
+Arguments:
+
+    Data - Supplies a pointer to the generator to refill.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    CHACHA20_CONTEXT Context;
+    UCHAR Nonce[CHACHA20_NONCE_SIZE];
+
+    RtlZeroMemory(Nonce, sizeof(Nonce));
+    CyChaCha20Initialize(&Context, Data->Key, Nonce, 0);
+    CyChaCha20Encrypt(&Context, NULL, Data->Buffer, KE_RANDOM_BUFFER_SIZE);
+    RtlCopyMemory(Data->Key, Data->Buffer, CHACHA20_KEY_SIZE);
+    RtlZeroMemory(Data->Buffer, CHACHA20_KEY_SIZE);
+    RtlZeroMemory(&Context, sizeof(Context));
+    Data->Available = KE_RANDOM_BUFFER_SIZE - CHACHA20_KEY_SIZE;
+    return;
+}
+
 VOID
 KepPseudoRandomInterfaceCallback (
     PVOID Context,
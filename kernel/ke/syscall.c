@@ -221,6 +221,21 @@ SYSTEM_CALL_TABLE_ENTRY KeSystemCallTable[SystemCallCount] = {
     {MmSysSetBreak,
         sizeof(SYSTEM_CALL_SET_BREAK),
         sizeof(SYSTEM_CALL_SET_BREAK)},
+    {IoSysSocketPerformBatchIo,
+        sizeof(SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO),
+        sizeof(SYSTEM_CALL_SOCKET_PERFORM_BATCH_IO)},
+    {KeSysGetRandomBytes,
+        sizeof(SYSTEM_CALL_GET_RANDOM_BYTES),
+        sizeof(SYSTEM_CALL_GET_RANDOM_BYTES)},
+    {IoSysCreateWatchQueue,
+        sizeof(SYSTEM_CALL_CREATE_WATCH_QUEUE),
+        sizeof(SYSTEM_CALL_CREATE_WATCH_QUEUE)},
+    {IoSysAddWatch,
+        sizeof(SYSTEM_CALL_ADD_WATCH),
+        sizeof(SYSTEM_CALL_ADD_WATCH)},
+    {IoSysRemoveWatch,
+        sizeof(SYSTEM_CALL_REMOVE_WATCH),
+        sizeof(SYSTEM_CALL_REMOVE_WATCH)},
 };
 
 //
@@ -818,10 +818,78 @@ Return Value:
     Space = (PADDRESS_SPACE_ARM)AddressSpace;
     ProcessorBlock = KeGetCurrentProcessorBlock();
     ProcessorBlock->Tss = Space->PageDirectory;
+
+    //
+    // Advertise the new address space before loading it so that TLB
+    // invalidations for it are not missed. Switching TTBR0 flushes the entire
+    // TLB anyway.
+    //
+
+    ProcessorBlock->AddressSpace = AddressSpace;
+    RtlMemoryBarrier();
     ArSwitchTtbr0(Space->PageDirectoryPhysical);
     return;
 }
 
+PVOID
+MmGetDirectMapAddress (
+    PHYSICAL_ADDRESS PhysicalAddress,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the address of the given physical memory within the
+    kernel's permanent direct map of RAM. The 32-bit address
+    space is too small to map all of RAM, so there is no direct map on ARM.
+
+Arguments:
+
+    PhysicalAddress - Supplies the physical address to look up.
+
+    Size - Supplies the number of bytes that need to be accessible starting at
+        the given physical address.
+
+Return Value:
+
+    NULL always.
+
+--*/
+
+{
+
+    return NULL;
+}
+
+BOOL
+MmIsDirectMapAddress (
+    PVOID Address
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether the given virtual address lies within the
+    kernel's direct map of RAM.
+
+Arguments:
+
+    Address - Supplies the virtual address to check.
+
+Return Value:
+
+    FALSE always, as there is no direct map.
+
+--*/
+
+{
+
+    return FALSE;
+}
+
 KSTATUS
 MmpArchInitialize (
     PKERNEL_INITIALIZATION_BLOCK Parameters,
@@ -1711,6 +1779,40 @@ Return Value:
     return;
 }
 
+KSTATUS
+MmpSetDirectMapCacheAttributes (
+    PHYSICAL_ADDRESS PhysicalAddress,
+    UINTN Size,
+    ULONG MapFlags
+    )
+
+/*++
+
+Routine Description:
+
+    This routine sets the memory type the kernel's direct map uses for the
+    given physical pages. There is no direct map on ARM, so there is
+    nothing to keep in sync.
+
+Arguments:
+
+    PhysicalAddress - Supplies the page aligned physical address of the range.
+
+    Size - Supplies the size of the range in bytes.
+
+    MapFlags - Supplies the map flags the pages are otherwise mapped with.
+
+Return Value:
+
+    STATUS_SUCCESS always.
+
+--*/
+
+{
+
+    return STATUS_SUCCESS;
+}
+
 PHYSICAL_ADDRESS
 MmpVirtualToPhysical (
     PVOID VirtualAddress,
@@ -138,6 +138,31 @@ MmpDestroyImageSectionMappings (
     PIMAGE_SECTION Section
     );
 
+VOID
+MmpLinkImageSection (
+    PADDRESS_SPACE AddressSpace,
+    PIMAGE_SECTION Section,
+    PLIST_ENTRY EntryBefore
+    );
+
+VOID
+MmpUnlinkImageSection (
+    PIMAGE_SECTION Section
+    );
+
+PLIST_ENTRY
+MmpFindFirstImageSectionEntry (
+    PADDRESS_SPACE AddressSpace,
+    PVOID Address
+    );
+
+COMPARISON_RESULT
+MmpCompareImageSectionNodes (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -148,6 +173,14 @@ MmpDestroyImageSectionMappings (
 
 PADDRESS_SPACE MmKernelAddressSpace;
 
+//
+// Store the last section generation handed out. Every address space gets a
+// fresh value whenever a section is removed from it, so a generation number
+// never identifies more than one address space state.
+//
+
+volatile ULONGLONG MmSectionGeneration;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -189,6 +222,11 @@ Return Value:
     }
 
     INITIALIZE_LIST_HEAD(&(Space->SectionListHead));
+    RtlRedBlackTreeInitialize(&(Space->SectionTree),
+                              0,
+                              MmpCompareImageSectionNodes);
+
+    Space->SectionGeneration = RtlAtomicAdd64(&MmSectionGeneration, 1) + 1;
     if (MmKernelAddressSpace == NULL) {
         MmKernelAddressSpace = Space;
         Space->Accountant = &MmKernelVirtualSpace;
@@ -213,7 +251,7 @@ Return Value:
         }
     }
 
-    Space->Lock = KeCreateQueuedLock();
+    Space->Lock = KeCreateSharedExclusiveLock();
     if (Space->Lock == NULL) {
         Status = STATUS_INSUFFICIENT_RESOURCES;
         goto CreateAddressSpaceEnd;
@@ -265,7 +303,7 @@ Return Value:
     }
 
     if (AddressSpace->Lock != NULL) {
-        KeDestroyQueuedLock(AddressSpace->Lock);
+        KeDestroySharedExclusiveLock(AddressSpace->Lock);
     }
 
     MmpArchDestroyAddressSpace(AddressSpace);
@@ -593,7 +631,7 @@ Return Value:
     MmAcquireAddressSpaceLock(AddressSpace);
     Status = STATUS_SUCCESS;
     End = Address + Size;
-    CurrentEntry = AddressSpace->SectionListHead.Next;
+    CurrentEntry = MmpFindFirstImageSectionEntry(AddressSpace, Address);
     while (CurrentEntry != &(AddressSpace->SectionListHead)) {
         Section = LIST_VALUE(CurrentEntry, IMAGE_SECTION, AddressListEntry);
         if (Section->VirtualAddress >= End) {
@@ -947,9 +985,11 @@ Return Value:
 {
 
     PIMAGE_SECTION CurrentSection;
-    PLIST_ENTRY CurrentSectionEntry;
+    PRED_BLACK_TREE_NODE FoundNode;
     ULONG PageShift;
+    IMAGE_SECTION SearchSection;
     KSTATUS Status;
+    PKTHREAD Thread;
     ULONGLONG VirtualAddressPage;
 
     PageShift = MmPageShift();
@@ -957,37 +997,79 @@ Return Value:
 
     ASSERT(KeGetRunLevel() == RunLevelLow);
 
-    MmAcquireAddressSpaceLock(AddressSpace);
-    CurrentSectionEntry = AddressSpace->SectionListHead.Next;
-    while (CurrentSectionEntry != &(AddressSpace->SectionListHead)) {
-        CurrentSection = LIST_VALUE(CurrentSectionEntry,
-                                    IMAGE_SECTION,
-                                    AddressListEntry);
+    //
+    // Lookups don't change the section tree, so they can run in parallel
+    // with each other. The thread hint is only touched by its own thread.
+    //
 
-        CurrentSectionEntry = CurrentSectionEntry->Next;
+    MmAcquireAddressSpaceLockShared(AddressSpace);
+    CurrentSection = NULL;
+    Thread = KeGetCurrentThread();
 
-        //
-        // If the VA is inside the current section, return it.
-        //
+    //
+    // Try the section this thread found last time first. If no section has
+    // been removed from the address space since then, the hint still points
+    // at a live section in the tree, though it may have shrunk.
+    //
+
+    if ((Thread != NULL) &&
+        (Thread->SectionHintAddressSpace == AddressSpace) &&
+        (Thread->SectionHintGeneration == AddressSpace->SectionGeneration)) {
+
+        CurrentSection = Thread->SectionHint;
+        if ((CurrentSection->VirtualAddress > VirtualAddress) ||
+            (CurrentSection->VirtualAddress + CurrentSection->Size <=
+             VirtualAddress)) {
+
+            CurrentSection = NULL;
+        }
+    }
+
+    //
+    // Otherwise find the closest section starting at or below the address,
+    // and see if it reaches far enough.
+    //
+
+    if (CurrentSection == NULL) {
+        SearchSection.VirtualAddress = VirtualAddress;
+        FoundNode = RtlRedBlackTreeSearchClosest(
+                                            &(AddressSpace->SectionTree),
+                                            &(SearchSection.AddressTreeNode),
+                                            FALSE);
+
+        if (FoundNode == NULL) {
+            goto LookupSectionEnd;
+        }
 
-        if ((CurrentSection->VirtualAddress <= VirtualAddress) &&
-            (CurrentSection->VirtualAddress +
-             CurrentSection->Size > VirtualAddress)) {
+        CurrentSection = RED_BLACK_TREE_VALUE(FoundNode,
+                                              IMAGE_SECTION,
+                                              AddressTreeNode);
 
-            VirtualAddressPage = (UINTN)VirtualAddress >> PageShift;
-            *Section = CurrentSection;
-            *PageOffset = VirtualAddressPage -
-                          ((UINTN)CurrentSection->VirtualAddress >>
-                           PageShift);
+        ASSERT(CurrentSection->VirtualAddress <= VirtualAddress);
+
+        if (CurrentSection->VirtualAddress + CurrentSection->Size <=
+            VirtualAddress) {
 
-            MmpImageSectionAddReference(CurrentSection);
-            Status = STATUS_SUCCESS;
             goto LookupSectionEnd;
         }
+
+        if (Thread != NULL) {
+            Thread->SectionHint = CurrentSection;
+            Thread->SectionHintAddressSpace = AddressSpace;
+            Thread->SectionHintGeneration = AddressSpace->SectionGeneration;
+        }
     }
 
+    VirtualAddressPage = (UINTN)VirtualAddress >> PageShift;
+    *Section = CurrentSection;
+    *PageOffset = VirtualAddressPage -
+                  ((UINTN)CurrentSection->VirtualAddress >> PageShift);
+
+    MmpImageSectionAddReference(CurrentSection);
+    Status = STATUS_SUCCESS;
+
 LookupSectionEnd:
-    MmReleaseAddressSpaceLock(AddressSpace);
+    MmReleaseAddressSpaceLockShared(AddressSpace);
     return Status;
 }
 
@@ -1092,7 +1174,7 @@ Return Value:
         goto AddImageSectionEnd;
     }
 
-    INSERT_AFTER(&(NewSection->AddressListEntry), EntryBefore);
+    MmpLinkImageSection(AddressSpace, NewSection, EntryBefore);
     MmReleaseAddressSpaceLock(AddressSpace);
     if (ImageHandle != INVALID_HANDLE) {
         Status = IoNotifyFileMapping(ImageHandle, TRUE);
@@ -1144,9 +1226,8 @@ Return Value:
         if (NewSection != NULL) {
             if (NewSection->AddressListEntry.Next != NULL) {
                 MmAcquireAddressSpaceLock(AddressSpace);
-                LIST_REMOVE(&(NewSection->AddressListEntry));
+                MmpUnlinkImageSection(NewSection);
                 MmReleaseAddressSpaceLock(AddressSpace);
-                NewSection->AddressListEntry.Next = NULL;
             }
 
             if (NewSection->ImageListEntry.Next != NULL) {
@@ -1433,7 +1514,9 @@ Return Value:
 
     MmAcquireAddressSpaceLock(DestinationAddressSpace);
     AddressLockHeld = TRUE;
-    CurrentEntry = DestinationAddressSpace->SectionListHead.Next;
+    CurrentEntry = MmpFindFirstImageSectionEntry(DestinationAddressSpace,
+                                                 NewSection->VirtualAddress);
+
     while (CurrentEntry != &(DestinationAddressSpace->SectionListHead)) {
         CurrentSection = LIST_VALUE(CurrentEntry,
                                     IMAGE_SECTION,
@@ -1450,7 +1533,10 @@ Return Value:
     // Insert the section onto the destination section list.
     //
 
-    INSERT_BEFORE(&(NewSection->AddressListEntry), CurrentEntry);
+    MmpLinkImageSection(DestinationAddressSpace,
+                        NewSection,
+                        CurrentEntry->Previous);
+
     Status = STATUS_SUCCESS;
 
 CopyImageSectionEnd:
@@ -2530,6 +2616,7 @@ Return Value:
 
 {
 
+    PADDRESS_SPACE AddressSpace;
     PLIST_ENTRY CurrentEntry;
     PVOID End;
     PIMAGE_SECTION Section;
@@ -2537,7 +2624,11 @@ Return Value:
 
     Status = STATUS_SUCCESS;
     End = Address + Size;
-    CurrentEntry = SectionListHead->Next;
+    AddressSpace = PARENT_STRUCTURE(SectionListHead,
+                                    ADDRESS_SPACE,
+                                    SectionListHead);
+
+    CurrentEntry = MmpFindFirstImageSectionEntry(AddressSpace, Address);
     while (CurrentEntry != SectionListHead) {
         Section = LIST_VALUE(CurrentEntry, IMAGE_SECTION, AddressListEntry);
         if (Section->VirtualAddress >= End) {
@@ -3197,8 +3288,9 @@ Return Value:
     //
 
     if (RemainderSection != NULL) {
-        INSERT_AFTER(&(RemainderSection->AddressListEntry),
-                     &(Section->AddressListEntry));
+        MmpLinkImageSection(Section->AddressSpace,
+                            RemainderSection,
+                            &(Section->AddressListEntry));
     }
 
     KeReleaseQueuedLock(Section->Lock);
@@ -3345,8 +3437,7 @@ Return Value:
         MmAcquireAddressSpaceLock(Section->AddressSpace);
     }
 
-    LIST_REMOVE(&(Section->AddressListEntry));
-    Section->AddressListEntry.Next = NULL;
+    MmpUnlinkImageSection(Section);
     if (AddressSpaceLockHeld == FALSE) {
         MmReleaseAddressSpaceLock(Section->AddressSpace);
     }
@@ -4269,3 +4360,202 @@ Return Value:
     return;
 }
 
+VOID
+MmpLinkImageSection (
+    PADDRESS_SPACE AddressSpace,
+    PIMAGE_SECTION Section,
+    PLIST_ENTRY EntryBefore
+    )
+
+/*++
+
+Routine Description:
+
+    This routine puts an image section online in its address space, adding
+    it to both the sorted section list and the section tree. This routine
+    assumes the address space lock is held exclusively.
+
+Arguments:
+
+    AddressSpace - Supplies a pointer to the address space to add the section
+        to.
+
+    Section - Supplies a pointer to the section to add.
+
+    EntryBefore - Supplies a pointer to the list entry the section should be
+        inserted after.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ASSERT(Section->AddressSpace == AddressSpace);
+
+    INSERT_AFTER(&(Section->AddressListEntry), EntryBefore);
+    RtlRedBlackTreeInsert(&(AddressSpace->SectionTree),
+                          &(Section->AddressTreeNode));
+
+    return;
+}
+
+VOID
+MmpUnlinkImageSection (
+    PIMAGE_SECTION Section
+    )
+
+/*++
+
+Routine Description:
+
+    This routine takes an image section offline, removing it from its address
+    space's section list and tree and invalidating any thread hints that may
+    point at it. This routine assumes the address space lock is held
+    exclusively.
+
+Arguments:
+
+    Section - Supplies a pointer to the section to remove.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PADDRESS_SPACE AddressSpace;
+
+    AddressSpace = Section->AddressSpace;
+    LIST_REMOVE(&(Section->AddressListEntry));
+    Section->AddressListEntry.Next = NULL;
+    RtlRedBlackTreeRemove(&(AddressSpace->SectionTree),
+                          &(Section->AddressTreeNode));
+
+    AddressSpace->SectionGeneration =
+                               RtlAtomicAdd64(&MmSectionGeneration, 1) + 1;
+
+    return;
+}
+
+PLIST_ENTRY
+MmpFindFirstImageSectionEntry (
+    PADDRESS_SPACE AddressSpace,
+    PVOID Address
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds where a walk of the section list for a region starting
+    at the given address should begin. This routine assumes the address space
+    lock is held.
+
+Arguments:
+
+    AddressSpace - Supplies a pointer to the address space to search.
+
+    Address - Supplies the starting address of the region.
+
+Return Value:
+
+    Returns a pointer to the list entry of the section containing the
+    address, or the first section after the address if none contains it.
+    This may be the list head itself if there are no sections at or after
+    the address.
+
+--*/
+
+{
+
+    PRED_BLACK_TREE_NODE FoundNode;
+    PIMAGE_SECTION Section;
+    IMAGE_SECTION SearchSection;
+
+    SearchSection.VirtualAddress = Address;
+    FoundNode = RtlRedBlackTreeSearchClosest(&(AddressSpace->SectionTree),
+                                             &(SearchSection.AddressTreeNode),
+                                             FALSE);
+
+    //
+    // With nothing starting at or below the address, the first section in
+    // the list is the first one that can overlap.
+    //
+
+    if (FoundNode == NULL) {
+        return AddressSpace->SectionListHead.Next;
+    }
+
+    //
+    // Sections don't overlap, so if the closest one below ends before the
+    // address, the one after it is the first candidate.
+    //
+
+    Section = RED_BLACK_TREE_VALUE(FoundNode, IMAGE_SECTION, AddressTreeNode);
+    if (Section->VirtualAddress + Section->Size <= Address) {
+        return Section->AddressListEntry.Next;
+    }
+
+    return &(Section->AddressListEntry);
+}
+
+COMPARISON_RESULT
+MmpCompareImageSectionNodes (
+    PRED_BLACK_TREE Tree,
+    PRED_BLACK_TREE_NODE FirstNode,
+    PRED_BLACK_TREE_NODE SecondNode
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compares two Red-Black tree nodes contained inside image
+    sections, by starting address.
+
+Arguments:
+
+    Tree - Supplies a pointer to the Red-Black tree that owns both nodes.
+
+    FirstNode - Supplies a pointer to the left side of the comparison.
+
+    SecondNode - Supplies a pointer to the second side of the comparison.
+
+Return Value:
+
+    Same if the two nodes have the same value.
+
+    Ascending if the first node is less than the second node.
+
+    Descending if the second node is less than the first node.
+
+--*/
+
+{
+
+    PIMAGE_SECTION FirstSection;
+    PIMAGE_SECTION SecondSection;
+
+    FirstSection = RED_BLACK_TREE_VALUE(FirstNode,
+                                        IMAGE_SECTION,
+                                        AddressTreeNode);
+
+    SecondSection = RED_BLACK_TREE_VALUE(SecondNode,
+                                         IMAGE_SECTION,
+                                         AddressTreeNode);
+
+    if (FirstSection->VirtualAddress < SecondSection->VirtualAddress) {
+        return ComparisonResultAscending;
+
+    } else if (FirstSection->VirtualAddress > SecondSection->VirtualAddress) {
+        return ComparisonResultDescending;
+    }
+
+    return ComparisonResultSame;
+}
+
@@ -13,7 +13,10 @@ Module Name:
 
 Abstract:
 
-    This module implements the TLB invalidation IPI.
+    This module implements the TLB invalidation IPI. Invalidations of user
+    mode addresses are only sent to the processors currently running in the
+    affected address space, and large ranges are handled with a single full
+    flush.
 
 Author:
 
@@ -59,6 +62,14 @@ volatile PVOID MmInvalidateIpiAddress = NULL;
 volatile ULONG MmInvalidateIpiPageCount = 0;
 volatile ULONG MmInvalidateIpiProcessorsRemaining = 0;
 
+//
+// Store counters of TLB invalidation activity for the memory statistics.
+//
+
+volatile UINTN MmTlbShootdownCount = 0;
+volatile UINTN MmTlbInvalidateIpiCount = 0;
+volatile UINTN MmTlbFullFlushCount = 0;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -86,23 +97,22 @@ Return Value:
 
 {
 
-    PVOID Address;
-    ULONG Index;
+    PVOID AddressSpace;
     RUNLEVEL OldRunLevel;
-    ULONG PageSize;
-    PKPROCESS Process;
+    PPROCESSOR_BLOCK Processor;
 
     OldRunLevel = KeRaiseRunLevel(RunLevelIpi);
-    PageSize = MmPageSize();
-    Process = PsGetCurrentProcess();
+    Processor = KeGetCurrentProcessorBlock();
+    AddressSpace = Processor->AddressSpace;
+    if (AddressSpace == NULL) {
+        AddressSpace = PsGetCurrentProcess()->AddressSpace;
+    }
+
     if ((MmInvalidateIpiAddress >= KERNEL_VA_START) ||
-        (Process->AddressSpace == MmInvalidateIpiAddressSpace)) {
+        (AddressSpace == MmInvalidateIpiAddressSpace)) {
 
-        Address = MmInvalidateIpiAddress;
-        for (Index = 0; Index < MmInvalidateIpiPageCount; Index += 1) {
-            ArInvalidateTlbEntry(Address);
-            Address = (PVOID)((UINTN)Address + PageSize);
-        }
+        MmpInvalidateTlbRange(MmInvalidateIpiAddress,
+                              MmInvalidateIpiPageCount);
     }
 
     RtlAtomicAdd32(&MmInvalidateIpiProcessorsRemaining, -1);
@@ -121,7 +131,12 @@ MmpSendTlbInvalidateIpi (
 
 Routine Description:
 
-    This routine invalidates the given TLB entry on all active processors.
+    This routine invalidates the given TLB entries on all processors that
+    might have them cached. Kernel mode addresses are invalidated everywhere,
+    but user mode addresses are only invalidated on processors currently
+    running in the given address space. Architectures that keep translations
+    for address spaces that are not loaded are responsible for flushing them
+    when the address space is switched back in.
 
 Arguments:
 
@@ -139,10 +154,13 @@ Return Value:
 
 {
 
+    PVOID CurrentSpace;
     RUNLEVEL OldRunLevel;
-    ULONG PageIndex;
-    ULONG PageSize;
+    PPROCESSOR_BLOCK Processor;
+    ULONG ProcessorCount;
+    ULONG ProcessorNumber;
     PROCESSOR_SET ProcessorSet;
+    ULONG Self;
     KSTATUS Status;
 
     //
@@ -150,32 +168,81 @@ Return Value:
     // directly.
     //
 
-    if (KeGetActiveProcessorCount() == 1) {
-        PageSize = MmPageSize();
-        for (PageIndex = 0; PageIndex < PageCount; PageIndex += 1) {
-            ArInvalidateTlbEntry(VirtualAddress);
-            VirtualAddress = (PVOID)((UINTN)VirtualAddress + PageSize);
-        }
-
+    ProcessorCount = KeGetActiveProcessorCount();
+    if (ProcessorCount == 1) {
+        MmpInvalidateTlbRange(VirtualAddress, PageCount);
         return;
     }
 
     OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
     KeAcquireSpinLock(&MmInvalidateIpiLock);
+    RtlAtomicAdd(&MmTlbShootdownCount, 1);
     MmInvalidateIpiAddressSpace = AddressSpace;
     MmInvalidateIpiAddress = VirtualAddress;
     MmInvalidateIpiPageCount = PageCount;
-    MmInvalidateIpiProcessorsRemaining = KeGetActiveProcessorCount();
-    RtlMemoryBarrier();
 
     //
-    // Send out the IPI.
+    // Kernel mode addresses are shared by every address space, so every
+    // processor has to hear about them.
+    //
+
+    if (VirtualAddress >= KERNEL_VA_START) {
+        MmInvalidateIpiProcessorsRemaining = ProcessorCount;
+        RtlMemoryBarrier();
+        ProcessorSet.Target = ProcessorTargetAll;
+        Status = HlSendIpi(IpiTypeTlbFlush, &ProcessorSet);
+        if (!KSUCCESS(Status)) {
+            KeCrashSystem(CRASH_IPI_FAILURE, Status, 0, 0, 0);
+        }
+
+        RtlAtomicAdd(&MmTlbInvalidateIpiCount, ProcessorCount);
+
+    //
+    // User mode addresses only need to be invalidated on processors running
+    // in the address space right now. The caller has already changed the page
+    // tables, and the barrier here pairs with the one made when switching
+    // address spaces, so a processor either shows up here or loads the new
+    // page tables. The count of processors remaining starts at one on behalf
+    // of this processor so that it cannot hit zero while IPIs are still going
+    // out. Processors that have not yet recorded an address space get the IPI
+    // to be safe.
     //
 
-    ProcessorSet.Target = ProcessorTargetAll;
-    Status = HlSendIpi(IpiTypeTlbFlush, &ProcessorSet);
-    if (!KSUCCESS(Status)) {
-        KeCrashSystem(CRASH_IPI_FAILURE, Status, 0, 0, 0);
+    } else {
+        MmInvalidateIpiProcessorsRemaining = 1;
+        RtlMemoryBarrier();
+        Self = KeGetCurrentProcessorNumber();
+        ProcessorSet.Target = ProcessorTargetSingleProcessor;
+        for (ProcessorNumber = 0;
+             ProcessorNumber < ProcessorCount;
+             ProcessorNumber += 1) {
+
+            Processor = KeGetProcessorBlock(ProcessorNumber);
+            if (Processor == NULL) {
+                continue;
+            }
+
+            CurrentSpace = Processor->AddressSpace;
+            if ((CurrentSpace != NULL) && (CurrentSpace != AddressSpace)) {
+                continue;
+            }
+
+            if (ProcessorNumber == Self) {
+                MmpInvalidateTlbRange(VirtualAddress, PageCount);
+                continue;
+            }
+
+            RtlAtomicAdd32(&MmInvalidateIpiProcessorsRemaining, 1);
+            ProcessorSet.U.Number = ProcessorNumber;
+            Status = HlSendIpi(IpiTypeTlbFlush, &ProcessorSet);
+            if (!KSUCCESS(Status)) {
+                KeCrashSystem(CRASH_IPI_FAILURE, Status, 0, 0, 0);
+            }
+
+            RtlAtomicAdd(&MmTlbInvalidateIpiCount, 1);
+        }
+
+        RtlAtomicAdd32(&MmInvalidateIpiProcessorsRemaining, -1);
     }
 
     //
@@ -191,6 +258,88 @@ Return Value:
     return;
 }
 
+VOID
+MmpInvalidateTlbRange (
+    PVOID VirtualAddress,
+    ULONG PageCount
+    )
+
+/*++
+
+Routine Description:
+
+    This routine invalidates a range of TLB entries on the current processor.
+    Large user mode ranges are handled by flushing the entire TLB.
+
+Arguments:
+
+    VirtualAddress - Supplies the first virtual address to invalidate.
+
+    PageCount - Supplies the number of pages to invalidate.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG PageIndex;
+    ULONG PageSize;
+
+    //
+    // Flushing the entire TLB does not get rid of global entries, so only
+    // take the shortcut for user mode ranges.
+    //
+
+    if ((PageCount > MM_TLB_FULL_FLUSH_THRESHOLD) &&
+        (VirtualAddress < KERNEL_VA_START)) {
+
+        ArInvalidateEntireTlb();
+        RtlAtomicAdd(&MmTlbFullFlushCount, 1);
+        return;
+    }
+
+    PageSize = MmPageSize();
+    for (PageIndex = 0; PageIndex < PageCount; PageIndex += 1) {
+        ArInvalidateTlbEntry(VirtualAddress);
+        VirtualAddress = (PVOID)((UINTN)VirtualAddress + PageSize);
+    }
+
+    return;
+}
+
+VOID
+MmpGetTlbStatistics (
+    PMM_STATISTICS Statistics
+    )
+
+/*++
+
+Routine Description:
+
+    This routine fills out the TLB invalidation portion of the given memory
+    statistics structure.
+
+Arguments:
+
+    Statistics - Supplies a pointer to the statistics to fill in.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    Statistics->TlbShootdowns = MmTlbShootdownCount;
+    Statistics->TlbInvalidateIpis = MmTlbInvalidateIpiCount;
+    Statistics->TlbFullFlushes = MmTlbFullFlushCount;
+    return;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
@@ -72,6 +72,13 @@ MmpMapIoBufferFragments (
     BOOL VirtuallyContiguous
     );
 
+BOOL
+MmpDirectMapIoBuffer (
+    PIO_BUFFER IoBuffer,
+    ULONG MapFlags,
+    BOOL VirtuallyContiguous
+    );
+
 VOID
 MmpUnmapIoBuffer (
     PIO_BUFFER IoBuffer
@@ -163,10 +170,12 @@ Return Value:
     UINTN AlignedSize;
     UINTN AllocationSize;
     PVOID CurrentAddress;
+    PIO_BUFFER_FRAGMENT Fragment;
     UINTN FragmentCount;
     UINTN FragmentIndex;
     UINTN FragmentSize;
     PIO_BUFFER IoBuffer;
+    ULONG MapFlags;
     BOOL NonCached;
     UINTN PageCount;
     UINTN PageIndex;
@@ -373,6 +382,45 @@ Return Value:
         ASSERT(IoBuffer->FragmentCount <= PageCount);
     }
 
+    //
+    // The buffer owns its pages for as long as it lives, so make the kernel's
+    // direct map of them match the memory type of the buffer's mapping rather
+    // than leaving the same memory mapped both cached and not. This is done
+    // once per physically contiguous fragment.
+    //
+
+    MapFlags = 0;
+    if (NonCached != FALSE) {
+        MapFlags = MAP_FLAG_CACHE_DISABLE;
+
+    } else if (WriteThrough != FALSE) {
+        MapFlags = MAP_FLAG_WRITE_THROUGH;
+    }
+
+    if (MapFlags != 0) {
+        for (FragmentIndex = 0;
+             FragmentIndex < IoBuffer->FragmentCount;
+             FragmentIndex += 1) {
+
+            Fragment = &(IoBuffer->Fragment[FragmentIndex]);
+            Status = MmpSetDirectMapCacheAttributes(Fragment->PhysicalAddress,
+                                                    Fragment->Size,
+                                                    MapFlags);
+
+            if (!KSUCCESS(Status)) {
+                while (FragmentIndex != 0) {
+                    FragmentIndex -= 1;
+                    Fragment = &(IoBuffer->Fragment[FragmentIndex]);
+                    MmpSetDirectMapCacheAttributes(Fragment->PhysicalAddress,
+                                                   Fragment->Size,
+                                                   0);
+                }
+
+                goto AllocateIoBufferEnd;
+            }
+        }
+    }
+
     IoBuffer->Internal.Flags = IO_BUFFER_INTERNAL_FLAG_NON_PAGED |
                                IO_BUFFER_INTERNAL_FLAG_VA_OWNED |
                                IO_BUFFER_INTERNAL_FLAG_PA_OWNED |
@@ -380,6 +428,10 @@ Return Value:
                                IO_BUFFER_INTERNAL_FLAG_MAPPED |
                                IO_BUFFER_INTERNAL_FLAG_VA_CONTIGUOUS;
 
+    if (MapFlags != 0) {
+        IoBuffer->Internal.Flags |= IO_BUFFER_INTERNAL_FLAG_DIRECT_MAP_CHANGED;
+    }
+
     ASSERT(KSUCCESS(Status));
 
 AllocateIoBufferEnd:
@@ -1286,7 +1338,8 @@ Return Value:
     IoBuffer->Internal.CurrentOffset = 0;
     IoBuffer->Internal.Flags &= ~(IO_BUFFER_INTERNAL_FLAG_VA_OWNED |
                                   IO_BUFFER_INTERNAL_FLAG_MAPPED |
-                                  IO_BUFFER_INTERNAL_FLAG_VA_CONTIGUOUS);
+                                  IO_BUFFER_INTERNAL_FLAG_VA_CONTIGUOUS |
+                                  IO_BUFFER_INTERNAL_FLAG_DIRECT_MAP_CHANGED);
 
     IoBuffer->Internal.MapFlags = 0;
     if (IoBuffer->Internal.PageCacheEntries != NULL) {
@@ -1421,6 +1474,19 @@ Return Value:
             MmpUnmapIoBuffer(IoBuffer);
         }
 
+        //
+        // A physically contiguous buffer may be able to use the direct map,
+        // which is virtually contiguous too and needs no VA.
+        //
+
+        if (MmpDirectMapIoBuffer(IoBuffer, MapFlags, TRUE) != FALSE) {
+            IoBuffer->Internal.Flags |= IO_BUFFER_INTERNAL_FLAG_MAPPED |
+                                        IO_BUFFER_INTERNAL_FLAG_VA_CONTIGUOUS;
+
+            Status = STATUS_SUCCESS;
+            goto MapIoBufferEnd;
+        }
+
         Status = MmpMapIoBufferFragments(IoBuffer,
                                          0,
                                          IoBuffer->FragmentCount,
@@ -1439,6 +1505,18 @@ Return Value:
     //
 
     } else {
+
+        //
+        // Point as many fragments as possible at the direct map first. If
+        // that covers everything, there's nothing left to map.
+        //
+
+        if (MmpDirectMapIoBuffer(IoBuffer, MapFlags, FALSE) != FALSE) {
+            IoBuffer->Internal.Flags |= IO_BUFFER_INTERNAL_FLAG_MAPPED;
+            Status = STATUS_SUCCESS;
+            goto MapIoBufferEnd;
+        }
+
         MapRequired = FALSE;
         MapFragmentStart = 0;
         Status = STATUS_SUCCESS;
@@ -3092,6 +3170,26 @@ Return Value:
         MmpUnmapIoBuffer(IoBuffer);
     }
 
+    //
+    // Put the direct map of owned non-cached or write-through pages back to
+    // cached before the pages go back to the free pool.
+    //
+
+    if ((Flags & IO_BUFFER_INTERNAL_FLAG_DIRECT_MAP_CHANGED) != 0) {
+
+        ASSERT((Flags & IO_BUFFER_INTERNAL_FLAG_PA_OWNED) != 0);
+
+        for (FragmentIndex = 0;
+             FragmentIndex < IoBuffer->FragmentCount;
+             FragmentIndex += 1) {
+
+            Fragment = &(IoBuffer->Fragment[FragmentIndex]);
+            MmpSetDirectMapCacheAttributes(Fragment->PhysicalAddress,
+                                           Fragment->Size,
+                                           0);
+        }
+    }
+
     //
     // Unless the physical memory is owned, locked, or backed by the page
     // cache there is no more clean-up to perform.
@@ -3446,6 +3544,115 @@ Return Value:
     return Status;
 }
 
+BOOL
+MmpDirectMapIoBuffer (
+    PIO_BUFFER IoBuffer,
+    ULONG MapFlags,
+    BOOL VirtuallyContiguous
+    )
+
+/*++
+
+Routine Description:
+
+    This routine attempts to map the given I/O buffer using the kernel's
+    direct map of RAM, which takes no page table updates now and no unmapping
+    later. A virtually contiguous mapping can only come from the direct map if
+    the whole buffer is physically contiguous. Otherwise, each fragment that
+    is not already mapped is pointed at the direct map if it can be.
+
+Arguments:
+
+    IoBuffer - Supplies a pointer to an I/O buffer.
+
+    MapFlags - Supplies the map flags to use when mapping the I/O buffer. See
+        MAP_FLAG_* for definitions.
+
+    VirtuallyContiguous - Supplies a boolean indicating whether or not the
+        VA needs to be virtually contiguous.
+
+Return Value:
+
+    TRUE if every fragment is now mapped as requested.
+
+    FALSE if some or all of the buffer still needs regular mappings.
+
+--*/
+
+{
+
+    PIO_BUFFER_FRAGMENT Fragment;
+    UINTN FragmentIndex;
+    BOOL Mapped;
+    PHYSICAL_ADDRESS PhysicalAddress;
+    UINTN Size;
+    PVOID VirtualAddress;
+
+    //
+    // Only cached mappings come from the direct map. Pages owned by
+    // non-cached or write-through buffers take on that memory type in the
+    // direct map too, but mappings asking for those types get their own.
+    //
+
+    MapFlags |= IoBuffer->Internal.MapFlags;
+    if ((MapFlags & (MAP_FLAG_CACHE_DISABLE | MAP_FLAG_WRITE_THROUGH)) != 0) {
+        return FALSE;
+    }
+
+    if (VirtuallyContiguous != FALSE) {
+        PhysicalAddress = IoBuffer->Fragment[0].PhysicalAddress;
+        Size = 0;
+        for (FragmentIndex = 0;
+             FragmentIndex < IoBuffer->FragmentCount;
+             FragmentIndex += 1) {
+
+            Fragment = &(IoBuffer->Fragment[FragmentIndex]);
+            if (Fragment->PhysicalAddress != (PhysicalAddress + Size)) {
+                return FALSE;
+            }
+
+            Size += Fragment->Size;
+        }
+
+        VirtualAddress = MmGetDirectMapAddress(PhysicalAddress, Size);
+        if (VirtualAddress == NULL) {
+            return FALSE;
+        }
+
+        for (FragmentIndex = 0;
+             FragmentIndex < IoBuffer->FragmentCount;
+             FragmentIndex += 1) {
+
+            Fragment = &(IoBuffer->Fragment[FragmentIndex]);
+            Fragment->VirtualAddress = VirtualAddress;
+            VirtualAddress += Fragment->Size;
+        }
+
+        return TRUE;
+    }
+
+    Mapped = TRUE;
+    for (FragmentIndex = 0;
+         FragmentIndex < IoBuffer->FragmentCount;
+         FragmentIndex += 1) {
+
+        Fragment = &(IoBuffer->Fragment[FragmentIndex]);
+        if (Fragment->VirtualAddress != NULL) {
+            continue;
+        }
+
+        Fragment->VirtualAddress = MmGetDirectMapAddress(
+                                                    Fragment->PhysicalAddress,
+                                                    Fragment->Size);
+
+        if (Fragment->VirtualAddress == NULL) {
+            Mapped = FALSE;
+        }
+    }
+
+    return Mapped;
+}
+
 VOID
 MmpUnmapIoBuffer (
     PIO_BUFFER IoBuffer
@@ -3554,11 +3761,15 @@ Return Value:
 
                 //
                 // Check to see if the current virtual address matches the page
-                // cache entry's virtual address.
+                // cache entry's virtual address. Direct map addresses are
+                // never unmapped, so treat them the same way.
                 //
 
                 CacheMatch = FALSE;
-                if (PageCacheEntry != NULL) {
+                if (MmIsDirectMapAddress(CurrentAddress) != FALSE) {
+                    CacheMatch = TRUE;
+
+                } else if (PageCacheEntry != NULL) {
                     PageCacheAddress = IoGetPageCacheEntryVirtualAddress(
                                                                PageCacheEntry);
 
@@ -3623,6 +3834,20 @@ Return Value:
                 FragmentIndex += 1;
             }
 
+        //
+        // Direct map fragments are never unmapped. End the current run, if
+        // any, and move on.
+        //
+
+        } else if (MmIsDirectMapAddress(Fragment->VirtualAddress) != FALSE) {
+            if (StartAddress != NULL) {
+                UnmapStartAddress = StartAddress;
+                UnmapSize = EndAddress - StartAddress;
+                StartAddress = NULL;
+            }
+
+            FragmentIndex += 1;
+
         //
         // If the buffer is not backed by page cache entries, treat the
         // fragment as a whole to be unmapped. If it's contiguous with the
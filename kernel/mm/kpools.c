@@ -671,6 +671,7 @@ Return Value:
 
     KeReleaseQueuedLock(MmPagedPoolLock);
     MmpGetPhysicalPageStatistics(Statistics);
+    MmpGetTlbStatistics(Statistics);
     return STATUS_SUCCESS;
 }
 
@@ -25,6 +25,25 @@ Module Name:
 // ------------------------------------------------------------------- Includes
 //
 
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// This macro evaluates to non-zero if the given memory descriptor type
+// describes actual RAM.
+//
+
+#define IS_PHYSICAL_MEMORY_TYPE(_Type)                          \
+    (((_Type) == MemoryTypeFree) ||                             \
+     ((_Type) == MemoryTypeAcpiTables) ||                       \
+     ((_Type) == MemoryTypeLoaderTemporary) ||                  \
+     ((_Type) == MemoryTypeLoaderPermanent) ||                  \
+     ((_Type) == MemoryTypeFirmwareTemporary) ||                \
+     ((_Type) == MemoryTypePageTables) ||                       \
+     ((_Type) == MemoryTypeBootPageTables) ||                   \
+     ((_Type) == MemoryTypeMmStructures))
+
 //
 // ---------------------------------------------------------------- Definitions
 //
@@ -58,6 +77,14 @@ Module Name:
 #define UNMAP_FLAG_SEND_INVALIDATE_IPI 0x00000001
 #define UNMAP_FLAG_FREE_PHYSICAL_PAGES 0x00000002
 
+//
+// Define the number of user mode pages beyond which a TLB invalidation
+// flushes the whole TLB rather than invalidating page by page. Reloading the
+// page directory is cheaper than walking a large range one page at a time.
+//
+
+#define MM_TLB_FULL_FLUSH_THRESHOLD 32
+
 //
 // This flag indicates that the underlying physical memory being described was
 // created with this structure. When the structure is destroyed, the memory
@@ -132,6 +159,14 @@ Module Name:
 
 #define IO_BUFFER_INTERNAL_FLAG_LOCK_OWNED 0x00000400
 
+//
+// This flag is set when the I/O buffer owns non-cached or write-through
+// physical pages whose direct map attributes were changed to match, and thus
+// need to be set back to cached before the pages are freed.
+//
+
+#define IO_BUFFER_INTERNAL_FLAG_DIRECT_MAP_CHANGED 0x00000800
+
 //
 // --------------------------------------------------------------------- Macros
 //
@@ -172,6 +207,8 @@ Structure Description:
     AddressListEntry - Stores pointers to the next and previous sections in the
         address space.
 
+    AddressTreeNode - Stores the node in the address space's section tree.
+
     ImageListEntry - Stores pointers to the next and previous sections that
         also inherit page cache pages from the same backing image.
 
@@ -231,6 +268,7 @@ struct _IMAGE_SECTION {
     volatile ULONG ReferenceCount;
     ULONG Flags;
     LIST_ENTRY AddressListEntry;
+    RED_BLACK_TREE_NODE AddressTreeNode;
     LIST_ENTRY ImageListEntry;
     LIST_ENTRY CopyListEntry;
     PIMAGE_SECTION Parent;
@@ -926,6 +964,43 @@ Return Value:
 
 --*/
 
+KSTATUS
+MmpSetDirectMapCacheAttributes (
+    PHYSICAL_ADDRESS PhysicalAddress,
+    UINTN Size,
+    ULONG MapFlags
+    );
+
+/*++
+
+Routine Description:
+
+    This routine sets the memory type the kernel's direct map uses for the
+    given physical pages so that it matches the other mappings of those
+    pages. Mapping the same memory with conflicting memory types is undefined
+    on some architectures. The caller must own the physical pages, and must
+    set them back to cached before freeing them. This routine must be called
+    at low level, except when setting the range back to cached, which can be
+    done at or below dispatch level.
+
+Arguments:
+
+    PhysicalAddress - Supplies the page aligned physical address of the range.
+
+    Size - Supplies the size of the range in bytes, a multiple of the page
+        size.
+
+    MapFlags - Supplies the map flags the pages are otherwise mapped with. Only
+        MAP_FLAG_CACHE_DISABLE and MAP_FLAG_WRITE_THROUGH are looked at.
+        Supply zero to set the range back to normal cached memory, which
+        always succeeds.
+
+Return Value:
+
+    Status code. On failure, the direct map is unchanged.
+
+--*/
+
 PHYSICAL_ADDRESS
 MmpVirtualToPhysical (
     PVOID VirtualAddress,
@@ -2148,7 +2223,12 @@ MmpSendTlbInvalidateIpi (
 
 Routine Description:
 
-    This routine invalidates the given TLB entry on all active processors.
+    This routine invalidates the given TLB entries on all processors that
+    might have them cached. Kernel mode addresses are invalidated everywhere,
+    but user mode addresses are only invalidated on processors currently
+    running in the given address space. Architectures that keep translations
+    for address spaces that are not loaded are responsible for flushing them
+    when the address space is switched back in.
 
 Arguments:
 
@@ -2164,6 +2244,53 @@ Return Value:
 
 --*/
 
+VOID
+MmpInvalidateTlbRange (
+    PVOID VirtualAddress,
+    ULONG PageCount
+    );
+
+/*++
+
+Routine Description:
+
+    This routine invalidates a range of TLB entries on the current processor.
+    Large user mode ranges are handled by flushing the entire TLB.
+
+Arguments:
+
+    VirtualAddress - Supplies the first virtual address to invalidate.
+
+    PageCount - Supplies the number of pages to invalidate.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+MmpGetTlbStatistics (
+    PMM_STATISTICS Statistics
+    );
+
+/*++
+
+Routine Description:
+
+    This routine fills out the TLB invalidation portion of the given memory
+    statistics structure.
+
+Arguments:
+
+    Statistics - Supplies a pointer to the statistics to fill in.
+
+Return Value:
+
+    None.
+
+--*/
+
 KSTATUS
 MmpInitializePaging (
     VOID
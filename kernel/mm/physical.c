@@ -105,16 +105,6 @@ Module Name:
 // --------------------------------------------------------------------- Macros
 //
 
-#define IS_PHYSICAL_MEMORY_TYPE(_Type)                          \
-    (((_Type) == MemoryTypeFree) ||                             \
-     ((_Type) == MemoryTypeAcpiTables) ||                       \
-     ((_Type) == MemoryTypeLoaderTemporary) ||                  \
-     ((_Type) == MemoryTypeLoaderPermanent) ||                  \
-     ((_Type) == MemoryTypeFirmwareTemporary) ||                \
-     ((_Type) == MemoryTypePageTables) ||                       \
-     ((_Type) == MemoryTypeBootPageTables) ||                   \
-     ((_Type) == MemoryTypeMmStructures))
-
 #define IS_BOOT_TEMPORARY_MEMORY_TYPE(_Type)                    \
     (((_Type) == MemoryTypeLoaderTemporary) ||                  \
      ((_Type) == MemoryTypeFirmwareTemporary) ||                \
@@ -572,6 +572,34 @@ Return Value:
     return NULL;
 }
 
+PPROCESSOR_BLOCK
+KeGetProcessorBlock (
+    ULONG ProcessorNumber
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the processor block for the given processor number.
+
+Arguments:
+
+    ProcessorNumber - Supplies the number of the processor.
+
+Return Value:
+
+    Returns the processor block for the given processor.
+
+    NULL if the input was not a valid processor number.
+
+--*/
+
+{
+
+    return NULL;
+}
+
 ULONGLONG
 KeGetRecentTimeCounter (
     VOID
@@ -110,6 +110,52 @@ Module Name:
 #define X64_PTE(_VirtualAddress) \
     ((PPTE)X64_PT(_VirtualAddress) + X64_PT_INDEX(_VirtualAddress))
 
+//
+// Define the base and maximum size of the direct map, a permanent mapping of
+// all RAM in the kernel address space at a fixed offset from its physical
+// address. RAM beyond the maximum size is left out of the direct map.
+//
+
+#define X64_DIRECT_MAP_BASE 0xFFFFA00000000000ULL
+#define X64_DIRECT_MAP_MAX_SIZE 0x0000200000000000ULL
+
+//
+// Define the page size used by the direct map. Only the portions of RAM that
+// cover whole large pages are direct mapped.
+//
+
+#define X64_DIRECT_MAP_PAGE_SIZE _2MB
+
+//
+// Define the PTE bits that select the memory type of a page.
+//
+
+#define X64_PTE_CACHE_MASK (X86_PTE_CACHE_DISABLED | X86_PTE_WRITE_THROUGH)
+
+//
+// Define the cache line size to assume when flushing if the processor does
+// not report one. Flushing with too small a stride is only redundant.
+//
+
+#define X64_DEFAULT_CACHE_LINE_SIZE 32
+
+//
+// Define the maximum number of separate physical ranges the direct map can
+// describe.
+//
+
+#define X64_DIRECT_MAP_RANGE_COUNT 32
+
+//
+// Define the number of process context identifiers each processor hands out
+// to user address spaces. PCID zero is reserved for the kernel address space
+// and is flushed on every switch.
+//
+
+#define X64_PCID_COUNT 16
+
+#define X64_PCID_ALLOCATION_TAG 0x64696350 // 'dicP'
+
 //
 // ----------------------------------------------- Internal Function Prototypes
 //
@@ -145,10 +191,122 @@ MmpCreatePageTable (
     BOOL ZeroTable
     );
 
+KSTATUS
+MmpInitializeDirectMap (
+    PMEMORY_DESCRIPTOR_LIST MemoryMap
+    );
+
+VOID
+MmpDirectMapIterationRoutine (
+    PMEMORY_DESCRIPTOR_LIST DescriptorList,
+    PMEMORY_DESCRIPTOR Descriptor,
+    PVOID Context
+    );
+
+VOID
+MmpAddDirectMapRange (
+    PHYSICAL_ADDRESS StartAddress,
+    PHYSICAL_ADDRESS EndAddress
+    );
+
+KSTATUS
+MmpSplitDirectMapPage (
+    PVOID DirectAddress
+    );
+
+VOID
+MmpInitializePcids (
+    VOID
+    );
+
+VOID
+MmpEnablePcidIpiRoutine (
+    PVOID Context
+    );
+
+ULONGLONG
+MmpGetPcidPageDirectory (
+    ULONG ProcessorNumber,
+    PADDRESS_SPACE_X64 AddressSpace
+    );
+
+VOID
+MmpAdvanceTlbGeneration (
+    PADDRESS_SPACE_X64 AddressSpace
+    );
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure describes a range of physical memory covered by the direct
+    map.
+
+Members:
+
+    StartAddress - Stores the first physical address in the range.
+
+    EndAddress - Stores the physical address immediately after the range.
+
+--*/
+
+typedef struct _X64_DIRECT_MAP_RANGE {
+    PHYSICAL_ADDRESS StartAddress;
+    PHYSICAL_ADDRESS EndAddress;
+} X64_DIRECT_MAP_RANGE, *PX64_DIRECT_MAP_RANGE;
+
+/*++
+
+Structure Description:
+
+    This structure describes one of a processor's process context
+    identifiers.
+
+Members:
+
+    AddressSpaceId - Stores the identifier of the address space whose
+        translations are tagged with this PCID, or zero if the PCID is unused.
+
+    Generation - Stores the TLB generation of the address space as of the last
+        time this PCID's translations were flushed.
+
+--*/
+
+typedef struct _X64_PCID_SLOT {
+    ULONGLONG AddressSpaceId;
+    ULONGLONG Generation;
+} X64_PCID_SLOT, *PX64_PCID_SLOT;
+
+/*++
+
+Structure Description:
+
+    This structure describes the process context identifier assignments for a
+    single processor. It is only ever touched by its own processor.
+
+Members:
+
+    Enabled - Stores a boolean indicating whether or not PCIDs have been
+        turned on for this processor.
+
+    NextVictim - Stores the index of the slot to take over the next time an
+        address space without a PCID is switched to.
+
+    Slots - Stores the PCID assignments. The PCID of a slot is its index plus
+        one.
+
+--*/
+
+typedef struct _X64_PCID_STATE {
+    BOOL Enabled;
+    ULONG NextVictim;
+    X64_PCID_SLOT Slots[X64_PCID_COUNT];
+} X64_PCID_STATE, *PX64_PCID_STATE;
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -165,6 +323,35 @@ volatile PTE *MmKernelPml4;
 
 KSPIN_LOCK MmPageTableLock;
 
+//
+// Stores the physical ranges covered by the direct map, in ascending order.
+// These are set up once during boot and never change after that.
+//
+
+X64_DIRECT_MAP_RANGE MmDirectMapRanges[X64_DIRECT_MAP_RANGE_COUNT];
+ULONG MmDirectMapRangeCount;
+
+//
+// Stores the size of the region reserved for the direct map in kernel VA
+// space.
+//
+
+UINTN MmDirectMapSize;
+
+//
+// Stores the per-processor PCID state, indexed by processor number. This is
+// NULL if the processor does not support PCIDs.
+//
+
+PX64_PCID_STATE MmPcidState;
+ULONG MmPcidStateCount;
+
+//
+// Stores the identifier to hand out to the next address space created.
+//
+
+volatile ULONGLONG MmNextAddressSpaceId = 1;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -276,7 +463,7 @@ Return Value:
         CurrentAddress += PAGE_SIZE;
     }
 
-    *PageDirectory = (PVOID)ArGetCurrentPageDirectory();
+    *PageDirectory = (PVOID)(ArGetCurrentPageDirectory() & ~X64_CR3_PCID_MASK);
     return;
 }
 
@@ -465,10 +652,21 @@ Return Value:
             break;
         }
 
-        if ((*X64_PDE(Current) & X86_PTE_PRESENT) == 0) {
+        Table = X64_PDE(Current);
+        if ((*Table & X86_PTE_PRESENT) == 0) {
             break;
         }
 
+        //
+        // Large pages only show up in the direct map, which is always
+        // writable.
+        //
+
+        if ((*Table & X86_PTE_LARGE) != 0) {
+            Current += PAGE_SIZE;
+            continue;
+        }
+
         Table = X64_PTE(Current);
         if ((*Table & X86_PTE_PRESENT) == 0) {
             break;
@@ -573,13 +771,129 @@ Return Value:
 
 {
 
+    BOOL Enabled;
+    ULONGLONG PageDirectory;
+    PPROCESSOR_BLOCK ProcessorBlock;
     PADDRESS_SPACE_X64 Space;
 
+    ProcessorBlock = Processor;
     Space = (PADDRESS_SPACE_X64)AddressSpace;
-    ArSetCurrentPageDirectory(Space->Pml4Physical);
+
+    //
+    // Keep interrupts off so that a TLB invalidation IPI cannot be handled
+    // after the new address space is advertised but before it's loaded. The
+    // barrier makes sure that anyone changing this address space's page
+    // tables either sees this processor in it or has already advanced the
+    // TLB generation by the time it is read.
+    //
+
+    Enabled = ArDisableInterrupts();
+    ProcessorBlock->AddressSpace = AddressSpace;
+    RtlMemoryBarrier();
+    if ((MmPcidState != NULL) && (Space->Id != 0)) {
+        PageDirectory = MmpGetPcidPageDirectory(ProcessorBlock->ProcessorNumber,
+                                                Space);
+
+    } else {
+        PageDirectory = Space->Pml4Physical;
+    }
+
+    ArSetCurrentPageDirectory(PageDirectory);
+    if (Enabled != FALSE) {
+        ArEnableInterrupts();
+    }
+
     return;
 }
 
+PVOID
+MmGetDirectMapAddress (
+    PHYSICAL_ADDRESS PhysicalAddress,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the address of the given physical memory within the
+    kernel's permanent direct map of RAM. Direct map addresses are mapped
+    cached, except for pages owned by non-cached or write-through I/O
+    buffers, which take on the buffer's memory type for as long as the buffer
+    owns them. They never need to be unmapped, and can be used from any
+    address space.
+
+Arguments:
+
+    PhysicalAddress - Supplies the physical address to look up.
+
+    Size - Supplies the number of bytes that need to be accessible starting at
+        the given physical address.
+
+Return Value:
+
+    Returns the direct map address corresponding to the physical address.
+
+    NULL if the range is not entirely covered by the direct map.
+
+--*/
+
+{
+
+    PHYSICAL_ADDRESS EndAddress;
+    ULONG Index;
+    PX64_DIRECT_MAP_RANGE Range;
+
+    EndAddress = PhysicalAddress + Size;
+    for (Index = 0; Index < MmDirectMapRangeCount; Index += 1) {
+        Range = &(MmDirectMapRanges[Index]);
+        if (PhysicalAddress < Range->StartAddress) {
+            break;
+        }
+
+        if (EndAddress <= Range->EndAddress) {
+            return (PVOID)(UINTN)(X64_DIRECT_MAP_BASE + PhysicalAddress);
+        }
+    }
+
+    return NULL;
+}
+
+BOOL
+MmIsDirectMapAddress (
+    PVOID Address
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether the given virtual address lies within the
+    kernel's direct map of RAM. Such addresses must never be unmapped.
+
+Arguments:
+
+    Address - Supplies the virtual address to check.
+
+Return Value:
+
+    TRUE if the address is a direct map address.
+
+    FALSE if the address is not part of the direct map.
+
+--*/
+
+{
+
+    if (((UINTN)Address >= X64_DIRECT_MAP_BASE) &&
+        (((UINTN)Address - X64_DIRECT_MAP_BASE) < MmDirectMapSize)) {
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
 KSTATUS
 MmpArchInitialize (
     PKERNEL_INITIALIZATION_BLOCK Parameters,
@@ -680,7 +994,16 @@ Return Value:
     //
 
     } else if (Phase == 2) {
-        Status = STATUS_SUCCESS;
+
+        //
+        // Now that page tables can be allocated and kernel VA space is
+        // tracked, map all of RAM.
+        //
+
+        Status = MmpInitializeDirectMap(Parameters->MemoryMap);
+        if (!KSUCCESS(Status)) {
+            goto ArchInitializeEnd;
+        }
 
     //
     // Phase 3 runs once after the scheduler is active.
@@ -801,6 +1124,7 @@ Return Value:
             }
         }
 
+        MmpInitializePcids();
         Status = STATUS_SUCCESS;
 
     } else {
@@ -858,6 +1182,14 @@ Return Value:
         goto ArchCreateAddressSpaceEnd;
     }
 
+    //
+    // The kernel address space keeps identifier zero, which always flushes.
+    //
+
+    if (MmKernelAddressSpace != NULL) {
+        Space->Id = RtlAtomicAdd64(&MmNextAddressSpaceId, 1);
+    }
+
 ArchCreateAddressSpaceEnd:
     if (!KSUCCESS(Status)) {
         if (Space != NULL) {
@@ -1052,13 +1384,21 @@ Return Value:
 
     ASSERT((Flags & MAP_FLAG_LARGE_PAGE) == 0);
 
+    //
+    // Kernel mappings are always made global. Otherwise they would get
+    // tagged with whichever PCID happened to be loaded, and an invalidation
+    // made under one PCID would not reach the copies cached under another.
+    //
+
     if ((Flags & MAP_FLAG_USER_MODE) != 0) {
 
         ASSERT(VirtualAddress < USER_VA_END);
 
         *Pte |= X86_PTE_USER_MODE;
 
-    } else if ((Flags & MAP_FLAG_GLOBAL) != 0) {
+    } else if (((Flags & MAP_FLAG_GLOBAL) != 0) ||
+               (VirtualAddress >= KERNEL_VA_START)) {
+
         *Pte |= X86_PTE_GLOBAL;
     }
 
@@ -1254,6 +1594,16 @@ Return Value:
         CurrentVirtual += PAGE_SIZE;
     }
 
+    //
+    // Processors not running in this address space right now won't get an
+    // IPI, so make sure they flush the old translations when they come back
+    // to it.
+    //
+
+    if ((ChangedSomething != FALSE) && (VirtualAddress < KERNEL_VA_START)) {
+        MmpAdvanceTlbGeneration(AddressSpace);
+    }
+
     //
     // Send the invalidate IPI to get everyone faulting. After this the pages
     // can be taken offline.
@@ -1337,82 +1687,285 @@ Return Value:
     return;
 }
 
-PHYSICAL_ADDRESS
-MmpVirtualToPhysical (
-    PVOID VirtualAddress,
-    PULONG Attributes
+KSTATUS
+MmpSetDirectMapCacheAttributes (
+    PHYSICAL_ADDRESS PhysicalAddress,
+    UINTN Size,
+    ULONG MapFlags
     )
 
 /*++
 
 Routine Description:
 
-    This routine returns the physical address corresponding to the given
-    virtual address.
+    This routine sets the memory type the kernel's direct map uses for the
+    given physical pages so that it matches the other mappings of those
+    pages. Large pages covering the range are split the first time any of
+    their pages needs to be something other than cached, and stay split. The
+    TLB invalidation is done once for the whole range, and only the cache
+    lines of the range are flushed. This routine must be called at low level,
+    except when setting the range back to cached, which can be done at or
+    below dispatch level.
 
 Arguments:
 
-    VirtualAddress - Supplies the address to translate to a physical address.
+    PhysicalAddress - Supplies the page aligned physical address of the range.
 
-    Attributes - Supplies an optional pointer where a bitfield of attributes
-        will be returned. See MAP_FLAG_* definitions.
+    Size - Supplies the size of the range in bytes, a multiple of the page
+        size.
+
+    MapFlags - Supplies the map flags the pages are otherwise mapped with. Only
+        MAP_FLAG_CACHE_DISABLE and MAP_FLAG_WRITE_THROUGH are looked at.
+        Supply zero to set the range back to normal cached memory, which
+        always succeeds.
 
 Return Value:
 
-    Returns the physical address corresponding to the virtual address, or NULL
-    if no mapping could be found.
+    Status code. On failure, the direct map is unchanged.
 
 --*/
 
 {
 
-    PHYSICAL_ADDRESS PhysicalAddress;
-    PPTE Pml4;
-    ULONG Pml4Index;
-    PPTE Pte;
+    PTE CacheBits;
+    PHYSICAL_ADDRESS Current;
+    PVOID DirectAddress;
+    ULONG Eax;
+    ULONG Ebx;
+    ULONG Ecx;
+    ULONG Edx;
+    PHYSICAL_ADDRESS EndAddress;
+    PVOID FirstAddress;
+    PVOID LastAddress;
+    UINTN LineOffset;
+    UINTN LineSize;
+    ULONG PageCount;
+    volatile PTE *Pte;
+    KSTATUS Status;
 
-    if (Attributes != NULL) {
-        *Attributes = 0;
+    ASSERT(((PhysicalAddress | Size) & PAGE_MASK) == 0);
+
+    CacheBits = 0;
+    if ((MapFlags & MAP_FLAG_CACHE_DISABLE) != 0) {
+        CacheBits = X86_PTE_CACHE_DISABLED;
+
+    } else if ((MapFlags & MAP_FLAG_WRITE_THROUGH) != 0) {
+        CacheBits = X86_PTE_WRITE_THROUGH;
     }
 
-    Pml4 = X64_PML4T;
-    Pml4Index = X64_PML4_INDEX(VirtualAddress);
-    if ((Pml4[Pml4Index] & X86_PTE_PRESENT) == 0) {
-        if (VirtualAddress >= KERNEL_VA_START) {
+    //
+    // Split the large pages covering the range up front. This is the only
+    // step that can fail, and splitting alone doesn't change how anything is
+    // mapped. Going back to cached never needs a split, since large pages
+    // are always cached. The direct map ranges are made of whole large
+    // pages, so one check covers every page within a large page.
+    //
 
-            ASSERT(Pml4Index != X64_SELF_MAP_INDEX);
+    EndAddress = PhysicalAddress + Size;
+    if (CacheBits != 0) {
 
-            Pml4[Pml4Index] = MmKernelPml4[Pml4Index];
-        }
+        ASSERT(KeGetRunLevel() == RunLevelLow);
 
-        if ((Pml4[Pml4Index] & X86_PTE_PRESENT) == 0) {
-            return INVALID_PHYSICAL_ADDRESS;
+        Current = PhysicalAddress;
+        while (Current < EndAddress) {
+            DirectAddress = MmGetDirectMapAddress(Current, PAGE_SIZE);
+            if ((DirectAddress != NULL) &&
+                ((*X64_PDE(DirectAddress) & X86_PTE_LARGE) != 0)) {
+
+                Status = MmpSplitDirectMapPage(DirectAddress);
+                if (!KSUCCESS(Status)) {
+                    return Status;
+                }
+            }
+
+            Current = ALIGN_RANGE_DOWN(Current, X64_DIRECT_MAP_PAGE_SIZE) +
+                      X64_DIRECT_MAP_PAGE_SIZE;
         }
     }
 
-    if (((*X64_PDPE(VirtualAddress) & X86_PTE_PRESENT) == 0) ||
-        ((*X64_PDE(VirtualAddress) & X86_PTE_PRESENT) == 0)) {
+    //
+    // Update the memory type of each page, remembering the span that changed
+    // so it can be invalidated all at once.
+    //
 
-        return INVALID_PHYSICAL_ADDRESS;
-    }
+    FirstAddress = NULL;
+    LastAddress = NULL;
+    for (Current = PhysicalAddress;
+         Current < EndAddress;
+         Current += PAGE_SIZE) {
 
-    Pte = X64_PTE(VirtualAddress);
-    PhysicalAddress = X86_PTE_ENTRY(*Pte);
-    if (PhysicalAddress == 0) {
+        DirectAddress = MmGetDirectMapAddress(Current, PAGE_SIZE);
+        if (DirectAddress == NULL) {
+            continue;
+        }
 
-        ASSERT((*Pte & X86_PTE_PRESENT) == 0);
+        if ((*X64_PDE(DirectAddress) & X86_PTE_LARGE) != 0) {
 
-        return INVALID_PHYSICAL_ADDRESS;
-    }
+            ASSERT(CacheBits == 0);
 
-    PhysicalAddress += (UINTN)VirtualAddress & PAGE_MASK;
-    if (Attributes != NULL) {
-        if ((*Pte & X86_PTE_PRESENT) != 0) {
-            *Attributes |= MAP_FLAG_PRESENT;
+            continue;
         }
 
-        if ((*Pte & X86_PTE_WRITABLE) == 0) {
-            *Attributes |= MAP_FLAG_READ_ONLY;
+        Pte = X64_PTE(DirectAddress);
+        if ((*Pte & X64_PTE_CACHE_MASK) == CacheBits) {
+            continue;
+        }
+
+        *Pte = (*Pte & ~X64_PTE_CACHE_MASK) | CacheBits;
+        if (FirstAddress == NULL) {
+            FirstAddress = DirectAddress;
+        }
+
+        LastAddress = DirectAddress;
+    }
+
+    if (FirstAddress == NULL) {
+        return STATUS_SUCCESS;
+    }
+
+    PageCount = (((UINTN)LastAddress - (UINTN)FirstAddress) >> PAGE_SHIFT) + 1;
+    MmpSendTlbInvalidateIpi(MmKernelAddressSpace, FirstAddress, PageCount);
+
+    //
+    // Now that no processor can pull in new cached lines through the direct
+    // map, write back and evict the ones already there so they can't later
+    // be written over what goes in through the uncached mappings.
+    //
+
+    if (CacheBits != 0) {
+        Eax = X86_CPUID_BASIC_INFORMATION;
+        Ebx = 0;
+        Ecx = 0;
+        Edx = 0;
+        ArCpuid(&Eax, &Ebx, &Ecx, &Edx);
+        LineSize = ((Ebx & X86_CPUID_BASIC_EBX_CLFLUSH_SIZE_MASK) >>
+                    X86_CPUID_BASIC_EBX_CLFLUSH_SIZE_SHIFT) * 8;
+
+        if (LineSize == 0) {
+            LineSize = X64_DEFAULT_CACHE_LINE_SIZE;
+        }
+
+        RtlMemoryBarrier();
+        for (Current = PhysicalAddress;
+             Current < EndAddress;
+             Current += PAGE_SIZE) {
+
+            DirectAddress = MmGetDirectMapAddress(Current, PAGE_SIZE);
+            if (DirectAddress == NULL) {
+                continue;
+            }
+
+            for (LineOffset = 0;
+                 LineOffset < PAGE_SIZE;
+                 LineOffset += LineSize) {
+
+                ArCleanInvalidateCacheLine(DirectAddress + LineOffset);
+            }
+        }
+
+        RtlMemoryBarrier();
+    }
+
+    return STATUS_SUCCESS;
+}
+
+PHYSICAL_ADDRESS
+MmpVirtualToPhysical (
+    PVOID VirtualAddress,
+    PULONG Attributes
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the physical address corresponding to the given
+    virtual address.
+
+Arguments:
+
+    VirtualAddress - Supplies the address to translate to a physical address.
+
+    Attributes - Supplies an optional pointer where a bitfield of attributes
+        will be returned. See MAP_FLAG_* definitions.
+
+Return Value:
+
+    Returns the physical address corresponding to the virtual address, or NULL
+    if no mapping could be found.
+
+--*/
+
+{
+
+    PTE Pde;
+    PHYSICAL_ADDRESS PhysicalAddress;
+    PPTE Pml4;
+    ULONG Pml4Index;
+    PPTE Pte;
+
+    if (Attributes != NULL) {
+        *Attributes = 0;
+    }
+
+    Pml4 = X64_PML4T;
+    Pml4Index = X64_PML4_INDEX(VirtualAddress);
+    if ((Pml4[Pml4Index] & X86_PTE_PRESENT) == 0) {
+        if (VirtualAddress >= KERNEL_VA_START) {
+
+            ASSERT(Pml4Index != X64_SELF_MAP_INDEX);
+
+            Pml4[Pml4Index] = MmKernelPml4[Pml4Index];
+        }
+
+        if ((Pml4[Pml4Index] & X86_PTE_PRESENT) == 0) {
+            return INVALID_PHYSICAL_ADDRESS;
+        }
+    }
+
+    if ((*X64_PDPE(VirtualAddress) & X86_PTE_PRESENT) == 0) {
+        return INVALID_PHYSICAL_ADDRESS;
+    }
+
+    Pde = *X64_PDE(VirtualAddress);
+    if ((Pde & X86_PTE_PRESENT) == 0) {
+        return INVALID_PHYSICAL_ADDRESS;
+    }
+
+    //
+    // Large pages only show up in the direct map, which is always present,
+    // writable, and not executable.
+    //
+
+    if ((Pde & X86_PTE_LARGE) != 0) {
+        PhysicalAddress = X86_PTE_ENTRY(Pde) +
+                          ((UINTN)VirtualAddress &
+                           (X64_DIRECT_MAP_PAGE_SIZE - 1));
+
+        if (Attributes != NULL) {
+            *Attributes |= MAP_FLAG_PRESENT;
+        }
+
+        return PhysicalAddress;
+    }
+
+    Pte = X64_PTE(VirtualAddress);
+    PhysicalAddress = X86_PTE_ENTRY(*Pte);
+    if (PhysicalAddress == 0) {
+
+        ASSERT((*Pte & X86_PTE_PRESENT) == 0);
+
+        return INVALID_PHYSICAL_ADDRESS;
+    }
+
+    PhysicalAddress += (UINTN)VirtualAddress & PAGE_MASK;
+    if (Attributes != NULL) {
+        if ((*Pte & X86_PTE_PRESENT) != 0) {
+            *Attributes |= MAP_FLAG_PRESENT;
+        }
+
+        if ((*Pte & X86_PTE_WRITABLE) == 0) {
+            *Attributes |= MAP_FLAG_READ_ONLY;
         }
 
         if ((*Pte & X86_PTE_DIRTY) != 0) {
@@ -1569,6 +2122,7 @@ Return Value:
             *PageWasDirty = TRUE;
         }
 
+        MmpAdvanceTlbGeneration((PADDRESS_SPACE_X64)AddressSpace);
         MmpSendTlbInvalidateIpi(AddressSpace, VirtualAddress, 1);
 
         ASSERT(VirtualAddress < USER_VA_END);
@@ -1710,6 +2264,7 @@ Return Value:
     //
 
     if (SendTlbInvalidateIpi != FALSE) {
+        MmpAdvanceTlbGeneration((PADDRESS_SPACE_X64)AddressSpace);
         MmpSendTlbInvalidateIpi(AddressSpace, VirtualAddress, 1);
     }
 
@@ -1771,10 +2326,15 @@ Return Value:
     PTE PteValue;
     BOOL SendInvalidateIpi;
 
+    ChangedSomething = FALSE;
     InvalidateTlb = TRUE;
     SendInvalidateIpi = TRUE;
     End = VirtualAddress + (PageCount << PAGE_SHIFT);
-    Process = PsGetKernelProcess();
+    Process = PsGetCurrentProcess();
+    if (VirtualAddress >= KERNEL_VA_START) {
+        Process = PsGetKernelProcess();
+    }
+
     AddressSpace = Process->AddressSpace;
     if (End <= USER_VA_END) {
 
@@ -1869,18 +2429,14 @@ Return Value:
 
         if ((*Pte & PteMask) != PteValue) {
             *Pte = (*Pte & ~PteMask) | PteValue;
-            if (SendInvalidateIpi == FALSE) {
-                if (InvalidateTlb != FALSE) {
-                    ArInvalidateTlbEntry(CurrentVirtual);
-                }
-
-            } else {
-                if (ChangedSomething == FALSE) {
-                    ChangedSomething = TRUE;
-                    VirtualAddress = CurrentVirtual;
-                    PageCount = (End - CurrentVirtual) >> PAGE_SHIFT;
-                }
+            if (ChangedSomething == FALSE) {
+                ChangedSomething = TRUE;
+                VirtualAddress = CurrentVirtual;
+                PageCount = (End - CurrentVirtual) >> PAGE_SHIFT;
+            }
 
+            if ((SendInvalidateIpi == FALSE) && (InvalidateTlb != FALSE)) {
+                ArInvalidateTlbEntry(CurrentVirtual);
             }
         }
 
@@ -1888,14 +2444,19 @@ Return Value:
     }
 
     //
-    // Send an invalidate IPI if any mappings were changed.
+    // Send an invalidate IPI if any mappings were changed. Processors that
+    // last ran a user mode address space find out about the change when they
+    // next switch to it.
     //
 
     if (ChangedSomething != FALSE) {
+        if (End <= USER_VA_END) {
+            MmpAdvanceTlbGeneration((PADDRESS_SPACE_X64)AddressSpace);
+        }
 
-        ASSERT(SendInvalidateIpi != FALSE);
-
-        MmpSendTlbInvalidateIpi(AddressSpace, VirtualAddress, PageCount);
+        if (SendInvalidateIpi != FALSE) {
+            MmpSendTlbInvalidateIpi(AddressSpace, VirtualAddress, PageCount);
+        }
     }
 
     return;
@@ -2368,6 +2929,7 @@ Return Value:
     ArInvalidateTlbEntry(Pte);
     KeLowerRunLevel(OldRunLevel);
     if (MappedCount != 0) {
+        MmpAdvanceTlbGeneration((PADDRESS_SPACE_X64)Source);
         MmpUpdateResidentSetCounter(&(DestinationSpace->Common), MappedCount);
     }
 
@@ -2673,6 +3235,13 @@ Return Value:
     }
 
     Space->ActivePageTables -= Total - Inactive;
+
+    //
+    // Other processors may still have the old page tables cached under this
+    // address space's PCID.
+    //
+
+    MmpAdvanceTlbGeneration(Space);
     return;
 }
 
@@ -3180,3 +3749,574 @@ Return Value:
     return STATUS_SUCCESS;
 }
 
+KSTATUS
+MmpInitializeDirectMap (
+    PMEMORY_DESCRIPTOR_LIST MemoryMap
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates the direct map, mapping all RAM described by the
+    memory map into the kernel address space with large pages. Having every
+    page permanently mapped means I/O buffers and page cache entries can
+    usually be touched without creating (and later tearing down) mappings.
+
+Arguments:
+
+    MemoryMap - Supplies a pointer to the system memory map.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PADDRESS_SPACE_X64 AddressSpace;
+    PHYSICAL_ADDRESS Current;
+    ULONG Index;
+    PPTE Pte;
+    PX64_DIRECT_MAP_RANGE Range;
+    X64_DIRECT_MAP_RANGE Run;
+    KSTATUS Status;
+    VM_ALLOCATION_PARAMETERS VaRequest;
+    PVOID VirtualAddress;
+
+    RtlZeroMemory(&Run, sizeof(X64_DIRECT_MAP_RANGE));
+    MmMdIterate(MemoryMap, MmpDirectMapIterationRoutine, &Run);
+    if (Run.EndAddress != 0) {
+        MmpAddDirectMapRange(Run.StartAddress, Run.EndAddress);
+    }
+
+    if (MmDirectMapRangeCount == 0) {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // Carve the region out of kernel VA space so it's never handed out for
+    // anything else. The ranges are sorted, so the last one marks the end.
+    //
+
+    Range = &(MmDirectMapRanges[MmDirectMapRangeCount - 1]);
+    VaRequest.Address = (PVOID)(UINTN)X64_DIRECT_MAP_BASE;
+    VaRequest.Size = ALIGN_RANGE_UP(Range->EndAddress, _1GB);
+    VaRequest.Alignment = PAGE_SIZE;
+    VaRequest.Min = 0;
+    VaRequest.Max = MAX_ADDRESS;
+    VaRequest.MemoryType = MemoryTypeReserved;
+    VaRequest.Strategy = AllocationStrategyFixedAddress;
+    Status = MmpAllocateAddressRange(&MmKernelVirtualSpace, &VaRequest, FALSE);
+    if (!KSUCCESS(Status)) {
+        goto InitializeDirectMapEnd;
+    }
+
+    //
+    // Map each range with large pages, creating the upper level tables along
+    // the way. The top level entries are kernel entries, so new address spaces
+    // pick them up automatically.
+    //
+
+    AddressSpace = (PADDRESS_SPACE_X64)MmKernelAddressSpace;
+    for (Index = 0; Index < MmDirectMapRangeCount; Index += 1) {
+        Range = &(MmDirectMapRanges[Index]);
+        for (Current = Range->StartAddress;
+             Current < Range->EndAddress;
+             Current += X64_DIRECT_MAP_PAGE_SIZE) {
+
+            VirtualAddress = (PVOID)(UINTN)(X64_DIRECT_MAP_BASE + Current);
+            Pte = X64_PML4E(VirtualAddress);
+            if ((*Pte & X86_PTE_PRESENT) == 0) {
+                Status = MmpCreatePageTable(AddressSpace,
+                                            Pte,
+                                            INVALID_PHYSICAL_ADDRESS,
+                                            FALSE);
+
+                if (!KSUCCESS(Status)) {
+                    goto InitializeDirectMapEnd;
+                }
+            }
+
+            Pte = X64_PDPE(VirtualAddress);
+            if ((*Pte & X86_PTE_PRESENT) == 0) {
+                Status = MmpCreatePageTable(AddressSpace,
+                                            Pte,
+                                            INVALID_PHYSICAL_ADDRESS,
+                                            FALSE);
+
+                if (!KSUCCESS(Status)) {
+                    goto InitializeDirectMapEnd;
+                }
+            }
+
+            Pte = X64_PDE(VirtualAddress);
+
+            ASSERT(*Pte == 0);
+
+            *Pte = Current | X86_PTE_PRESENT | X86_PTE_WRITABLE |
+                   X86_PTE_LARGE | X86_PTE_GLOBAL | X86_PTE_NX;
+        }
+    }
+
+    MmDirectMapSize = VaRequest.Size;
+    Status = STATUS_SUCCESS;
+
+InitializeDirectMapEnd:
+    if (!KSUCCESS(Status)) {
+        MmDirectMapRangeCount = 0;
+    }
+
+    return Status;
+}
+
+VOID
+MmpDirectMapIterationRoutine (
+    PMEMORY_DESCRIPTOR_LIST DescriptorList,
+    PMEMORY_DESCRIPTOR Descriptor,
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine is called once for each descriptor in the memory map when
+    setting up the direct map. It coalesces adjacent RAM descriptors into runs,
+    adding each run to the direct map once it ends.
+
+Arguments:
+
+    DescriptorList - Supplies a pointer to the descriptor list being iterated
+        over.
+
+    Descriptor - Supplies a pointer to the current descriptor.
+
+    Context - Supplies a pointer to the current run of RAM.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PX64_DIRECT_MAP_RANGE Run;
+
+    Run = Context;
+    if (!IS_PHYSICAL_MEMORY_TYPE(Descriptor->Type)) {
+        return;
+    }
+
+    if (Run->EndAddress != 0) {
+        if (Descriptor->BaseAddress == Run->EndAddress) {
+            Run->EndAddress += Descriptor->Size;
+            return;
+        }
+
+        MmpAddDirectMapRange(Run->StartAddress, Run->EndAddress);
+    }
+
+    Run->StartAddress = Descriptor->BaseAddress;
+    Run->EndAddress = Descriptor->BaseAddress + Descriptor->Size;
+    return;
+}
+
+VOID
+MmpAddDirectMapRange (
+    PHYSICAL_ADDRESS StartAddress,
+    PHYSICAL_ADDRESS EndAddress
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records a run of RAM to be covered by the direct map. Only
+    the whole large pages within the run are covered; the partial pages at
+    either end are left to regular mappings so that the direct map never
+    spans anything that isn't RAM.
+
+Arguments:
+
+    StartAddress - Supplies the first physical address of the run.
+
+    EndAddress - Supplies the physical address immediately after the run.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PX64_DIRECT_MAP_RANGE Range;
+
+    StartAddress = ALIGN_RANGE_UP(StartAddress, X64_DIRECT_MAP_PAGE_SIZE);
+    EndAddress = ALIGN_RANGE_DOWN(EndAddress, X64_DIRECT_MAP_PAGE_SIZE);
+    if ((MmMaximumPhysicalAddress != 0) &&
+        (EndAddress > MmMaximumPhysicalAddress)) {
+
+        EndAddress = ALIGN_RANGE_DOWN(MmMaximumPhysicalAddress,
+                                      X64_DIRECT_MAP_PAGE_SIZE);
+    }
+
+    if (EndAddress > X64_DIRECT_MAP_MAX_SIZE) {
+        EndAddress = X64_DIRECT_MAP_MAX_SIZE;
+    }
+
+    if ((StartAddress >= EndAddress) ||
+        (MmDirectMapRangeCount == X64_DIRECT_MAP_RANGE_COUNT)) {
+
+        return;
+    }
+
+    Range = &(MmDirectMapRanges[MmDirectMapRangeCount]);
+    Range->StartAddress = StartAddress;
+    Range->EndAddress = EndAddress;
+    MmDirectMapRangeCount += 1;
+    return;
+}
+
+KSTATUS
+MmpSplitDirectMapPage (
+    PVOID DirectAddress
+    )
+
+/*++
+
+Routine Description:
+
+    This routine replaces the large page of the direct map covering the given
+    address with a page table that maps the same memory with small pages and
+    the same attributes, so that the memory type of individual pages can be
+    changed. This routine must be called at low level.
+
+Arguments:
+
+    DirectAddress - Supplies an address within the large page to split.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PHYSICAL_ADDRESS BaseAddress;
+    ULONG Index;
+    RUNLEVEL OldRunLevel;
+    PPTE PageTable;
+    PHYSICAL_ADDRESS PageTablePhysical;
+    volatile PTE *Pde;
+    PPROCESSOR_BLOCK Processor;
+    PVOID SwapPage;
+    PTE SwapPte;
+    volatile PTE *SwapPtePointer;
+
+    ASSERT(KeGetRunLevel() == RunLevelLow);
+
+    PageTablePhysical = MmpAllocatePhysicalPage();
+    if (PageTablePhysical == INVALID_PHYSICAL_ADDRESS) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    BaseAddress = ALIGN_RANGE_DOWN((UINTN)DirectAddress,
+                                   X64_DIRECT_MAP_PAGE_SIZE) -
+                  X64_DIRECT_MAP_BASE;
+
+    Pde = X64_PDE(DirectAddress);
+    OldRunLevel = KeRaiseRunLevel(RunLevelDispatch);
+    Processor = KeGetCurrentProcessorBlock();
+    KeAcquireSpinLock(&MmPageTableLock);
+
+    //
+    // Fill in the new table through the swap page and install it, unless
+    // someone else split this large page in the meantime.
+    //
+
+    if ((*Pde & X86_PTE_LARGE) != 0) {
+        SwapPage = Processor->SwapPage;
+        SwapPtePointer = X64_PTE(SwapPage);
+        SwapPte = *SwapPtePointer;
+        *SwapPtePointer = PageTablePhysical | X86_PTE_PRESENT |
+                          X86_PTE_WRITABLE;
+
+        if (SwapPte != 0) {
+            ArInvalidateTlbEntry(SwapPage);
+        }
+
+        PageTable = SwapPage;
+        for (Index = 0; Index < X64_PTE_COUNT; Index += 1) {
+            PageTable[Index] = (BaseAddress + (Index << PAGE_SHIFT)) |
+                               X86_PTE_PRESENT | X86_PTE_WRITABLE |
+                               X86_PTE_GLOBAL | X86_PTE_NX;
+        }
+
+        *SwapPtePointer = SwapPte;
+        ArInvalidateTlbEntry(SwapPage);
+
+        //
+        // Only the page size changes here, not what any address maps to or
+        // how, so stale large page TLB entries are harmless.
+        //
+
+        *Pde = PageTablePhysical | X86_PTE_PRESENT | X86_PTE_WRITABLE;
+        PageTablePhysical = INVALID_PHYSICAL_ADDRESS;
+    }
+
+    KeReleaseSpinLock(&MmPageTableLock);
+    KeLowerRunLevel(OldRunLevel);
+    if (PageTablePhysical != INVALID_PHYSICAL_ADDRESS) {
+        MmFreePhysicalPage(PageTablePhysical);
+    }
+
+    //
+    // The new table is reached through the self map at the address that used
+    // to resolve to the first page of the large page itself. Flush that
+    // translation, along with the paging structure caches for it, on every
+    // processor before anyone goes through the self map to the new PTEs. This
+    // is done even if another thread did the split, as its flush may not
+    // have finished yet.
+    //
+
+    MmpSendTlbInvalidateIpi(MmKernelAddressSpace, X64_PT(DirectAddress), 1);
+    return STATUS_SUCCESS;
+}
+
+VOID
+MmpInitializePcids (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine turns on process context identifiers on every processor if
+    they are supported. PCIDs let each processor keep the TLB entries of a
+    handful of recently used address spaces across context switches, rather
+    than throwing them all out on every switch.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+    ULONG Eax;
+    ULONG Ebx;
+    ULONG Ecx;
+    ULONG Edx;
+    PROCESSOR_SET ProcessorSet;
+    ULONG ProcessorCount;
+    PX64_PCID_STATE State;
+    KSTATUS Status;
+
+    Eax = X86_CPUID_BASIC_INFORMATION;
+    Ecx = 0;
+    ArCpuid(&Eax, &Ebx, &Ecx, &Edx);
+    if ((Ecx & X86_CPUID_BASIC_ECX_PCID) == 0) {
+        return;
+    }
+
+    ProcessorCount = HlGetMaximumProcessorCount();
+    if (ProcessorCount < KeGetActiveProcessorCount()) {
+        ProcessorCount = KeGetActiveProcessorCount();
+    }
+
+    AllocationSize = ProcessorCount * sizeof(X64_PCID_STATE);
+    State = MmAllocateNonPagedPool(AllocationSize, X64_PCID_ALLOCATION_TAG);
+    if (State == NULL) {
+        return;
+    }
+
+    RtlZeroMemory(State, AllocationSize);
+    ProcessorSet.Target = ProcessorTargetAll;
+    Status = KeSendIpi(MmpEnablePcidIpiRoutine, State, &ProcessorSet);
+    if (!KSUCCESS(Status)) {
+
+        //
+        // Some processors may have already turned PCIDs on. That's fine, as
+        // they'll just keep using PCID zero, which flushes on every switch.
+        //
+
+        MmFreeNonPagedPool(State);
+        return;
+    }
+
+    MmPcidStateCount = ProcessorCount;
+    RtlMemoryBarrier();
+    MmPcidState = State;
+    return;
+}
+
+VOID
+MmpEnablePcidIpiRoutine (
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine runs on each processor to turn on process context
+    identifiers.
+
+Arguments:
+
+    Context - Supplies a pointer to the array of per-processor PCID state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG ProcessorNumber;
+    PX64_PCID_STATE State;
+
+    //
+    // Turning PCIDs on requires that the current PCID bits of CR3 be zero,
+    // which they are since nothing has used them yet.
+    //
+
+    ASSERT((ArGetCurrentPageDirectory() & X64_CR3_PCID_MASK) == 0);
+
+    ProcessorNumber = KeGetCurrentProcessorNumber();
+    State = Context;
+    ArSetControlRegister4(ArGetControlRegister4() | CR4_PCID_ENABLE);
+    State[ProcessorNumber].Enabled = TRUE;
+    return;
+}
+
+ULONGLONG
+MmpGetPcidPageDirectory (
+    ULONG ProcessorNumber,
+    PADDRESS_SPACE_X64 AddressSpace
+    )
+
+/*++
+
+Routine Description:
+
+    This routine picks the process context identifier to use for the given
+    address space on the current processor. This routine must be called with
+    interrupts disabled.
+
+Arguments:
+
+    ProcessorNumber - Supplies the number of the current processor.
+
+    AddressSpace - Supplies a pointer to the address space being switched to.
+
+Return Value:
+
+    Returns the value to load into CR3 to switch to the address space. The
+    no-flush bit is set if the processor's translations for the address space
+    are still good.
+
+--*/
+
+{
+
+    ULONGLONG Generation;
+    ULONG Index;
+    PX64_PCID_SLOT Slot;
+    PX64_PCID_STATE State;
+
+    if (ProcessorNumber >= MmPcidStateCount) {
+        return AddressSpace->Pml4Physical;
+    }
+
+    State = &(MmPcidState[ProcessorNumber]);
+    if (State->Enabled == FALSE) {
+        return AddressSpace->Pml4Physical;
+    }
+
+    //
+    // The generation is read before the switch. If it changes afterwards,
+    // the change comes with an IPI to this processor.
+    //
+
+    Generation = AddressSpace->TlbGeneration;
+    for (Index = 0; Index < X64_PCID_COUNT; Index += 1) {
+        Slot = &(State->Slots[Index]);
+        if (Slot->AddressSpaceId != AddressSpace->Id) {
+            continue;
+        }
+
+        //
+        // If nothing in the address space was invalidated since the last
+        // flush of this PCID, the cached translations can be kept.
+        //
+
+        if (Slot->Generation == Generation) {
+            return AddressSpace->Pml4Physical | (Index + 1) | X64_CR3_NO_FLUSH;
+        }
+
+        Slot->Generation = Generation;
+        return AddressSpace->Pml4Physical | (Index + 1);
+    }
+
+    //
+    // Take over a PCID from some other address space. Loading CR3 without the
+    // no-flush bit throws out the previous owner's translations.
+    //
+
+    Index = State->NextVictim;
+    State->NextVictim = (Index + 1) % X64_PCID_COUNT;
+    Slot = &(State->Slots[Index]);
+    Slot->AddressSpaceId = AddressSpace->Id;
+    Slot->Generation = Generation;
+    return AddressSpace->Pml4Physical | (Index + 1);
+}
+
+VOID
+MmpAdvanceTlbGeneration (
+    PADDRESS_SPACE_X64 AddressSpace
+    )
+
+/*++
+
+Routine Description:
+
+    This routine notes that user mode translations in the given address space
+    were invalidated. Processors that are not running in the address space
+    right now do not get invalidation IPIs, so this forces them to flush the
+    address space's PCID the next time they switch to it. This must be called
+    after the page tables are changed and before any IPI is sent.
+
+Arguments:
+
+    AddressSpace - Supplies a pointer to the address space.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (AddressSpace == NULL) {
+        return;
+    }
+
+    RtlAtomicAdd64(&(AddressSpace->TlbGeneration), 1);
+    return;
+}
+
@@ -36,6 +36,7 @@ function build() {
 
     sources = [
         "aes.c",
+        "chacha.c",
         "fortuna.c",
         "hmac.c",
         "md5.c",
@@ -0,0 +1,340 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    chacha.c
+
+Abstract:
+
+    This module implements the ChaCha20 stream cipher, as described in
+    RFC 7539.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Any
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "cryptop.h"
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+#define CHACHA20_ROTATE_LEFT(_Value, _Count) \
+    (((_Value) << (_Count)) | ((_Value) >> (32 - (_Count))))
+
+//
+// This macro performs a single ChaCha quarter round on four state words.
+//
+
+#define CHACHA20_QUARTER_ROUND(_State, _A, _B, _C, _D)                      \
+    (_State)[_A] += (_State)[_B];                                           \
+    (_State)[_D] = CHACHA20_ROTATE_LEFT((_State)[_D] ^ (_State)[_A], 16);   \
+    (_State)[_C] += (_State)[_D];                                           \
+    (_State)[_B] = CHACHA20_ROTATE_LEFT((_State)[_B] ^ (_State)[_C], 12);   \
+    (_State)[_A] += (_State)[_B];                                           \
+    (_State)[_D] = CHACHA20_ROTATE_LEFT((_State)[_D] ^ (_State)[_A], 8);    \
+    (_State)[_C] += (_State)[_D];                                           \
+    (_State)[_B] = CHACHA20_ROTATE_LEFT((_State)[_B] ^ (_State)[_C], 7);
+
+//
+// These macros read and write a 32-bit little endian value from a byte
+// array, regardless of the array's alignment.
+//
+
+#define CHACHA20_READ32(_Bytes)          \
+    (((ULONG)((_Bytes)[0])) |            \
+     (((ULONG)((_Bytes)[1])) << 8) |     \
+     (((ULONG)((_Bytes)[2])) << 16) |    \
+     (((ULONG)((_Bytes)[3])) << 24))
+
+#define CHACHA20_WRITE32(_Bytes, _Value)             \
+    (_Bytes)[0] = (UCHAR)(_Value);                   \
+    (_Bytes)[1] = (UCHAR)((_Value) >> 8);            \
+    (_Bytes)[2] = (UCHAR)((_Value) >> 16);           \
+    (_Bytes)[3] = (UCHAR)((_Value) >> 24);
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+#define CHACHA20_DOUBLE_ROUNDS 10
+
+//
+// Define the indices of the block counter and nonce within the state.
+//
+
+#define CHACHA20_COUNTER_INDEX 12
+#define CHACHA20_NONCE_INDEX 13
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+VOID
+CypChaCha20Block (
+    PCHACHA20_CONTEXT Context,
+    PUCHAR Output
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store the constant "expand 32-byte k" that begins every state.
+//
+
+const ULONG CyChaCha20Constants[4] = {
+    0x61707865,
+    0x3320646E,
+    0x79622D32,
+    0x6B206574
+};
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+CRYPTO_API
+VOID
+CyChaCha20Initialize (
+    PCHACHA20_CONTEXT Context,
+    UCHAR Key[CHACHA20_KEY_SIZE],
+    UCHAR Nonce[CHACHA20_NONCE_SIZE],
+    ULONG Counter
+    )
+
+/*++
+
+Routine Description:
+
+    This routine initializes a ChaCha20 context with a key, nonce, and
+    starting block counter.
+
+Arguments:
+
+    Context - Supplies a pointer to the context to initialize.
+
+    Key - Supplies the 256-bit key.
+
+    Nonce - Supplies the 96-bit nonce.
+
+    Counter - Supplies the block number to start the key stream at.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Index;
+
+    for (Index = 0; Index < 4; Index += 1) {
+        Context->State[Index] = CyChaCha20Constants[Index];
+    }
+
+    for (Index = 0; Index < CHACHA20_KEY_SIZE / sizeof(ULONG); Index += 1) {
+        Context->State[Index + 4] = CHACHA20_READ32(&(Key[Index * 4]));
+    }
+
+    Context->State[CHACHA20_COUNTER_INDEX] = Counter;
+    for (Index = 0; Index < CHACHA20_NONCE_SIZE / sizeof(ULONG); Index += 1) {
+        Context->State[CHACHA20_NONCE_INDEX + Index] =
+                                          CHACHA20_READ32(&(Nonce[Index * 4]));
+    }
+
+    Context->KeyStreamOffset = CHACHA20_BLOCK_SIZE;
+    return;
+}
+
+CRYPTO_API
+VOID
+CyChaCha20Encrypt (
+    PCHACHA20_CONTEXT Context,
+    PCVOID Input,
+    PVOID Output,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine encrypts or decrypts data with ChaCha20. Since this is a
+    stream cipher the two operations are the same. Successive calls continue
+    where the previous call left off in the key stream.
+
+Arguments:
+
+    Context - Supplies a pointer to the initialized context.
+
+    Input - Supplies an optional pointer to the data to encrypt. If NULL, the
+        raw key stream is written to the output.
+
+    Output - Supplies a pointer where the encrypted data will be returned.
+        This may be the same as the input buffer.
+
+    Size - Supplies the number of bytes to process.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    UINTN Count;
+    const UCHAR *InputBytes;
+    PUCHAR OutputBytes;
+    PUCHAR Stream;
+
+    InputBytes = Input;
+    OutputBytes = Output;
+    while (Size != 0) {
+
+        //
+        // Handle whole blocks a block at a time when lined up on a block
+        // boundary. Raw key stream is generated straight into the output.
+        //
+
+        if ((Context->KeyStreamOffset == CHACHA20_BLOCK_SIZE) &&
+            (Size >= CHACHA20_BLOCK_SIZE)) {
+
+            if (InputBytes != NULL) {
+                CypChaCha20Block(Context, Context->KeyStream);
+                Stream = Context->KeyStream;
+                for (Count = 0; Count < CHACHA20_BLOCK_SIZE; Count += 1) {
+                    OutputBytes[Count] = InputBytes[Count] ^ Stream[Count];
+                }
+
+                InputBytes += CHACHA20_BLOCK_SIZE;
+
+            } else {
+                CypChaCha20Block(Context, OutputBytes);
+            }
+
+            OutputBytes += CHACHA20_BLOCK_SIZE;
+            Size -= CHACHA20_BLOCK_SIZE;
+            continue;
+        }
+
+        if (Context->KeyStreamOffset == CHACHA20_BLOCK_SIZE) {
+            CypChaCha20Block(Context, Context->KeyStream);
+            Context->KeyStreamOffset = 0;
+        }
+
+        Stream = &(Context->KeyStream[Context->KeyStreamOffset]);
+        Count = CHACHA20_BLOCK_SIZE - Context->KeyStreamOffset;
+        if (Count > Size) {
+            Count = Size;
+        }
+
+        Context->KeyStreamOffset += Count;
+        Size -= Count;
+        while (Count != 0) {
+            if (InputBytes != NULL) {
+                *OutputBytes = *InputBytes ^ *Stream;
+                InputBytes += 1;
+
+            } else {
+                *OutputBytes = *Stream;
+            }
+
+            OutputBytes += 1;
+            Stream += 1;
+            Count -= 1;
+        }
+    }
+
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+VOID
+CypChaCha20Block (
+    PCHACHA20_CONTEXT Context,
+    PUCHAR Output
+    )
+
+/*++
+
+Routine Description:
+
+    This routine generates the next block of key stream and advances the
+    block counter.
+
+Arguments:
+
+    Context - Supplies a pointer to the context.
+
+    Output - Supplies a pointer where the CHACHA20_BLOCK_SIZE bytes of key
+        stream will be returned.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Index;
+    ULONG Working[CHACHA20_STATE_SIZE];
+
+    for (Index = 0; Index < CHACHA20_STATE_SIZE; Index += 1) {
+        Working[Index] = Context->State[Index];
+    }
+
+    for (Index = 0; Index < CHACHA20_DOUBLE_ROUNDS; Index += 1) {
+
+        //
+        // Perform a column round followed by a diagonal round.
+        //
+
+        CHACHA20_QUARTER_ROUND(Working, 0, 4, 8, 12);
+        CHACHA20_QUARTER_ROUND(Working, 1, 5, 9, 13);
+        CHACHA20_QUARTER_ROUND(Working, 2, 6, 10, 14);
+        CHACHA20_QUARTER_ROUND(Working, 3, 7, 11, 15);
+        CHACHA20_QUARTER_ROUND(Working, 0, 5, 10, 15);
+        CHACHA20_QUARTER_ROUND(Working, 1, 6, 11, 12);
+        CHACHA20_QUARTER_ROUND(Working, 2, 7, 8, 13);
+        CHACHA20_QUARTER_ROUND(Working, 3, 4, 9, 14);
+    }
+
+    for (Index = 0; Index < CHACHA20_STATE_SIZE; Index += 1) {
+        Working[Index] += Context->State[Index];
+        CHACHA20_WRITE32(&(Output[Index * 4]), Working[Index]);
+    }
+
+    Context->State[CHACHA20_COUNTER_INDEX] += 1;
+    RtlZeroMemory(Working, sizeof(Working));
+    return;
+}
+
@@ -80,6 +80,11 @@ TestRsa (
     VOID
     );
 
+ULONG
+TestChaCha20 (
+    VOID
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -371,6 +376,41 @@ PSTR TestCrypRsaPrivateKey =
 
 PSTR TestCrypRsaPrivateKeyPassword = "1234";
 
+//
+// Define the ChaCha20 test vector from section 2.4.2 of RFC 7539. The key is
+// the bytes 0 through 31.
+//
+
+UCHAR TestCrypChaCha20Nonce[CHACHA20_NONCE_SIZE] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4A, 0x00, 0x00, 0x00, 0x00
+};
+
+PCHAR TestCrypChaCha20PlainText =
+    "Ladies and Gentlemen of the class of '99: If I could offer you only one "
+    "tip for the future, sunscreen would be it.";
+
+UCHAR TestCrypChaCha20CipherText[] = {
+    0x6E, 0x2E, 0x35, 0x9A, 0x25, 0x68, 0xF9, 0x80, 0x41, 0xBA,
+    0x07, 0x28, 0xDD, 0x0D, 0x69, 0x81, 0xE9, 0x7E, 0x7A, 0xEC,
+    0x1D, 0x43, 0x60, 0xC2, 0x0A, 0x27, 0xAF, 0xCC, 0xFD, 0x9F,
+    0xAE, 0x0B, 0xF9, 0x1B, 0x65, 0xC5, 0x52, 0x47, 0x33, 0xAB,
+    0x8F, 0x59, 0x3D, 0xAB, 0xCD, 0x62, 0xB3, 0x57, 0x16, 0x39,
+    0xD6, 0x24, 0xE6, 0x51, 0x52, 0xAB, 0x8F, 0x53, 0x0C, 0x35,
+    0x9F, 0x08, 0x61, 0xD8, 0x07, 0xCA, 0x0D, 0xBF, 0x50, 0x0D,
+    0x6A, 0x61, 0x56, 0xA3, 0x8E, 0x08, 0x8A, 0x22, 0xB6, 0x5E,
+    0x52, 0xBC, 0x51, 0x4D, 0x16, 0xCC, 0xF8, 0x06, 0x81, 0x8C,
+    0xE9, 0x1A, 0xB7, 0x79, 0x37, 0x36, 0x5A, 0xF9, 0x0B, 0xBF,
+    0x74, 0xA3, 0x5B, 0xE6, 0xB4, 0x0B, 0x8E, 0xED, 0xF2, 0x78,
+    0x5E, 0x42, 0x87, 0x4D
+};
+
+//
+// Define the sizes the ChaCha20 plaintext is split into, to exercise both the
+// whole block and partial block paths.
+//
+
+ULONG TestCrypChaCha20Pieces[] = {1, 63, 64, 7, 100};
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -413,6 +453,7 @@ Return Value:
     TestsFailed += TestSha512();
     TestsFailed += TestMd5();
     TestsFailed += TestRsa();
+    TestsFailed += TestChaCha20();
     if (TestsFailed != 0) {
         printf("\n*** %d failures in Crypto test. ***\n", TestsFailed);
         return 1;
@@ -792,3 +833,86 @@ Return Value:
     return Failures;
 }
 
+ULONG
+TestChaCha20 (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine tests the ChaCha20 stream cipher against a known answer,
+    encrypting in uneven pieces and then decrypting all at once.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the number of test failures.
+
+--*/
+
+{
+
+    UCHAR Buffer[sizeof(TestCrypChaCha20CipherText)];
+    CHACHA20_CONTEXT Context;
+    ULONG Failures;
+    UINTN Index;
+    UCHAR Key[CHACHA20_KEY_SIZE];
+    UINTN Offset;
+    UINTN PieceCount;
+    UINTN Size;
+
+    Failures = 0;
+    for (Index = 0; Index < CHACHA20_KEY_SIZE; Index += 1) {
+        Key[Index] = Index;
+    }
+
+    CyChaCha20Initialize(&Context, Key, TestCrypChaCha20Nonce, 1);
+    PieceCount = sizeof(TestCrypChaCha20Pieces) /
+                 sizeof(TestCrypChaCha20Pieces[0]);
+
+    Offset = 0;
+    for (Index = 0; Index < PieceCount; Index += 1) {
+        Size = TestCrypChaCha20Pieces[Index];
+        if (Offset + Size > sizeof(Buffer)) {
+            Size = sizeof(Buffer) - Offset;
+        }
+
+        CyChaCha20Encrypt(&Context,
+                          TestCrypChaCha20PlainText + Offset,
+                          Buffer + Offset,
+                          Size);
+
+        Offset += Size;
+    }
+
+    for (Index = 0; Index < sizeof(Buffer); Index += 1) {
+        if (Buffer[Index] != TestCrypChaCha20CipherText[Index]) {
+            printf("ChaCha20: Encrypt mismatch at offset %lu: %02X vs %02X\n",
+                   Index,
+                   Buffer[Index],
+                   TestCrypChaCha20CipherText[Index]);
+
+            Failures += 1;
+            break;
+        }
+    }
+
+    CyChaCha20Initialize(&Context, Key, TestCrypChaCha20Nonce, 1);
+    CyChaCha20Encrypt(&Context, Buffer, Buffer, sizeof(Buffer));
+    if (memcmp(Buffer, TestCrypChaCha20PlainText, sizeof(Buffer)) != 0) {
+        printf("ChaCha20: Decrypt mismatch.\n");
+        Failures += 1;
+    }
+
+    if (Failures != 0) {
+        printf("%d failures in ChaCha20 test.\n", Failures);
+    }
+
+    return Failures;
+}
+
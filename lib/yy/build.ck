@@ -37,6 +37,7 @@ function build() {
 
     sources = [
         "lex.c",
+        "lexdfa.c",
         "parse.c",
         "parser.c"
     ];
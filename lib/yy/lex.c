@@ -50,6 +50,15 @@ Module Name:
 // ----------------------------------------------- Internal Function Prototypes
 //
 
+BOOL
+YypMatchTable (
+    PLEXER Lexer,
+    PYY_LEX_DFA Dfa,
+    PSTR *Expressions,
+    PULONG Position,
+    PULONG ExpressionIndex
+    );
+
 BOOL
 YypMatchExpression (
     PLEXER Lexer,
@@ -208,10 +217,19 @@ Return Value:
         //
 
         if (Match == FALSE) {
-            Match = YypMatchExpression(Lexer,
-                                       Lexer->Expressions,
-                                       &Position,
-                                       &TokenValue);
+            if (Lexer->Table != NULL) {
+                Match = YypMatchTable(Lexer,
+                                      &(Lexer->Table->Expressions),
+                                      Lexer->Expressions,
+                                      &Position,
+                                      &TokenValue);
+
+            } else {
+                Match = YypMatchExpression(Lexer,
+                                           Lexer->Expressions,
+                                           &Position,
+                                           &TokenValue);
+            }
 
             if (Match != FALSE) {
                 TokenValue += Lexer->TokenBase;
@@ -223,10 +241,19 @@ Return Value:
         //
 
         if (Match == FALSE) {
-            Match = YypMatchExpression(Lexer,
-                                       Lexer->IgnoreExpressions,
-                                       &Position,
-                                       &TokenValue);
+            if (Lexer->Table != NULL) {
+                Match = YypMatchTable(Lexer,
+                                      &(Lexer->Table->IgnoreExpressions),
+                                      Lexer->IgnoreExpressions,
+                                      &Position,
+                                      &TokenValue);
+
+            } else {
+                Match = YypMatchExpression(Lexer,
+                                           Lexer->IgnoreExpressions,
+                                           &Position,
+                                           &TokenValue);
+            }
 
             Ignore = Match;
         }
@@ -301,10 +328,243 @@ Return Value:
     return STATUS_SUCCESS;
 }
 
+BOOL
+YypMatchCharacterClass (
+    PSTR *ExpressionPointer,
+    CHAR Input
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether or not the given input character is in the
+    character class (like [a-z]) at the given expression.
+
+Arguments:
+
+    ExpressionPointer - Supplies a pointer to a pointer to the opening square
+        bracket of the class. This will be advanced past the class.
+
+    Input - Supplies the input character to test.
+
+Return Value:
+
+    TRUE if the character is in the class.
+
+    FALSE if the character is not in the class.
+
+--*/
+
+{
+
+    PSTR Expression;
+    BOOL Match;
+    BOOL Not;
+    CHAR Previous;
+
+    Expression = *ExpressionPointer;
+
+    assert(*Expression == '[');
+
+    Match = FALSE;
+    Not = FALSE;
+    Expression += 1;
+    if (*Expression == '^') {
+        Not = TRUE;
+        Expression += 1;
+    }
+
+    //
+    // Allow a close bracket in the character set if it's the first
+    // character.
+    //
+
+    Previous = 0;
+    while (((*Expression != ']') || (Previous == 0)) &&
+           (*Expression != '\0')) {
+
+        //
+        // Check a range.
+        //
+
+        if ((Previous != 0) && (*Expression == '-') &&
+            (*(Expression + 1) != ']')) {
+
+            Expression += 1;
+            if ((Input >= Previous) && (Input <= *Expression)) {
+                Match = TRUE;
+            }
+
+            if (*Expression == '\0') {
+                break;
+            }
+
+        //
+        // Check one of these characters in the set.
+        //
+
+        } else {
+            if (Input == *Expression) {
+                Match = TRUE;
+            }
+        }
+
+        Previous = *Expression;
+        Expression += 1;
+    }
+
+    if (Not != FALSE) {
+        Match = !Match;
+    }
+
+    if (*Expression == ']') {
+        Expression += 1;
+    }
+
+    *ExpressionPointer = Expression;
+    return Match;
+}
+
 //
 // --------------------------------------------------------- Internal Functions
 //
 
+BOOL
+YypMatchTable (
+    PLEXER Lexer,
+    PYY_LEX_DFA Dfa,
+    PSTR *Expressions,
+    PULONG Position,
+    PULONG ExpressionIndex
+    )
+
+/*++
+
+Routine Description:
+
+    This routine attempts to match the current input to one of the lexer
+    constructs using a compiled state machine. The results are identical to
+    those of the interpreter.
+
+Arguments:
+
+    Lexer - Supplies a pointer to the lexer.
+
+    Dfa - Supplies a pointer to the compiled state machine for the expressions.
+
+    Expressions - Supplies a pointer to the array of expressions the state
+        machine was compiled from. Expressions that could not be compiled are
+        matched from here.
+
+    Position - Supplies a pointer where the updated position will be returned
+        on success. The input position is grabbed from the lexer itself.
+
+    ExpressionIndex - Supplies a pointer where the matching expression index
+        will be returned on success.
+
+Return Value:
+
+    TRUE if an expression matched.
+
+    FALSE if no expression matched.
+
+--*/
+
+{
+
+    PUCHAR Classes;
+    ULONG ClassCount;
+    ULONG Current;
+    PSTR Expression;
+    ULONG Index;
+    PCSTR Input;
+    BOOL Match;
+    ULONG NextPosition;
+    ULONG NextState;
+    ULONG Size;
+    ULONG State;
+    PUSHORT Transitions;
+    ULONG Winner;
+    ULONG WinnerPosition;
+
+    Classes = Lexer->Table->Classes;
+    ClassCount = Lexer->Table->ClassCount;
+    Transitions = Dfa->Transitions;
+    Input = Lexer->Input;
+    Size = Lexer->InputSize;
+    Current = Lexer->Position;
+    State = YY_LEX_STATE_START;
+    Winner = -1;
+    WinnerPosition = 0;
+
+    //
+    // Run the machine as far as it goes, remembering the last accepting
+    // state seen for the longest match.
+    //
+
+    while (Current < Size) {
+        NextState = Transitions[(State * ClassCount) +
+                                Classes[(UCHAR)(Input[Current])]];
+
+        if (NextState == YY_LEX_STATE_DEAD) {
+            break;
+
+        } else if (NextState == YY_LEX_STATE_FALLBACK) {
+            return YypMatchExpression(Lexer,
+                                      Expressions,
+                                      Position,
+                                      ExpressionIndex);
+        }
+
+        State = NextState;
+        Current += 1;
+        if (Dfa->Accept[State] != 0) {
+            Winner = Dfa->Accept[State] - 1;
+            WinnerPosition = Current;
+        }
+    }
+
+    //
+    // The interpreter considers any expression still in progress at the end
+    // of the input to be a match.
+    //
+
+    if ((Current == Size) && (Dfa->EndAccept[State] != 0)) {
+
+        Winner = Dfa->EndAccept[State] - 1;
+        WinnerPosition = Current;
+    }
+
+    //
+    // Try the expressions the state machine couldn't handle, keeping the
+    // longest match, or the first expression in the case of a tie.
+    //
+
+    for (Index = 0; Index < Dfa->FallbackCount; Index += 1) {
+        NextPosition = Lexer->Position;
+        Expression = Expressions[Dfa->Fallback[Index]];
+        Match = YypMatchSubexpression(Lexer, &NextPosition, &Expression);
+        if (Match != FALSE) {
+            if ((NextPosition > WinnerPosition) ||
+                ((NextPosition == WinnerPosition) &&
+                 (Dfa->Fallback[Index] < Winner))) {
+
+                Winner = Dfa->Fallback[Index];
+                WinnerPosition = NextPosition;
+            }
+        }
+    }
+
+    if (WinnerPosition == 0) {
+        return FALSE;
+    }
+
+    *Position = WinnerPosition;
+    *ExpressionIndex = Winner;
+    return TRUE;
+}
+
 BOOL
 YypMatchExpression (
     PLEXER Lexer,
@@ -634,8 +894,6 @@ Return Value:
     PSTR Expression;
     CHAR Input;
     BOOL Match;
-    BOOL Not;
-    CHAR Previous;
 
     Match = FALSE;
     Expression = *ExpressionPointer;
@@ -646,60 +904,7 @@ Return Value:
     //
 
     if (*Expression == '[') {
-        Not = FALSE;
-        Expression += 1;
-        if (*Expression == '^') {
-            Not = TRUE;
-            Expression += 1;
-        }
-
-        //
-        // Allow a close bracket in the character set if it's the first
-        // character.
-        //
-
-        Previous = 0;
-        while (((*Expression != ']') || (Previous == 0)) &&
-               (*Expression != '\0')) {
-
-            //
-            // Check a range.
-            //
-
-            if ((Previous != 0) && (*Expression == '-') &&
-                (*(Expression + 1) != ']')) {
-
-                Expression += 1;
-                if ((Input >= Previous) && (Input <= *Expression)) {
-                    Match = TRUE;
-                }
-
-                if (*Expression == '\0') {
-                    break;
-                }
-
-            //
-            // Check one of these characters in the set.
-            //
-
-            } else {
-                if (Input == *Expression) {
-                    Match = TRUE;
-                }
-            }
-
-            Previous = *Expression;
-            Expression += 1;
-        }
-
-        if (Not != FALSE) {
-            Match = !Match;
-        }
-
-        if (*Expression == ']') {
-            Expression += 1;
-        }
-
+        Match = YypMatchCharacterClass(&Expression, Input);
         if (Match != FALSE) {
             *Position += 1;
         }
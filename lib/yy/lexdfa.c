@@ -0,0 +1,2541 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    lexdfa.c
+
+Abstract:
+
+    This module compiles lexer expressions into deterministic state machines.
+    Each expression is parsed into a tree, turned into a position automaton,
+    and all the expressions of a set are combined and converted into a single
+    DFA, which is then minimized. The interpreter never backtracks, so only
+    expressions whose choices can all be made by looking at the next
+    character are compiled; for those the interpreter and the regular
+    expression agree. Everything else is left to the interpreter.
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Any
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include <assert.h>
+#include <string.h>
+#include "yyp.h"
+
+//
+// --------------------------------------------------------------------- Macros
+//
+
+#define YypLexReallocate(_Compiler, _Memory, _NewSize) \
+    (_Compiler)->Reallocate((_Compiler)->Context, (_Memory), (_NewSize))
+
+//
+// These macros manipulate bitmaps stored as arrays of ULONGs.
+//
+
+#define YY_LEX_BITMAP_WORDS(_Bits) (((_Bits) + 31) / 32)
+#define YY_LEX_TEST_BIT(_Bitmap, _Bit) \
+    (((_Bitmap)[(_Bit) / 32] & (1UL << ((_Bit) % 32))) != 0)
+
+#define YY_LEX_SET_BIT(_Bitmap, _Bit) \
+    ((_Bitmap)[(_Bit) / 32] |= (1UL << ((_Bit) % 32)))
+
+#define YY_LEX_CLEAR_BIT(_Bitmap, _Bit) \
+    ((_Bitmap)[(_Bit) / 32] &= ~(1UL << ((_Bit) % 32)))
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the number of words in a bitmap of input characters.
+//
+
+#define YY_LEX_CHARACTER_WORDS YY_LEX_BITMAP_WORDS(256)
+
+#define YY_LEX_INVALID_NODE ((ULONG)-1)
+#define YY_LEX_HASH_BUCKETS 4096
+
+//
+// Define node flags.
+//
+
+#define YY_LEX_NODE_NULLABLE 0x00000001
+#define YY_LEX_NODE_NON_GREEDY 0x00000002
+
+//
+// Define expression flags.
+//
+
+#define YY_LEX_EXPRESSION_SUPPORTED 0x00000001
+#define YY_LEX_EXPRESSION_SHORTEST 0x00000002
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+typedef enum _YY_LEX_NODE_TYPE {
+    YyLexNodeInvalid,
+    YyLexNodeLeaf,
+    YyLexNodeConcatenate,
+    YyLexNodeAlternate,
+    YyLexNodeStar,
+    YyLexNodePlus,
+    YyLexNodeOptional
+} YY_LEX_NODE_TYPE, *PYY_LEX_NODE_TYPE;
+
+/*++
+
+Structure Description:
+
+    This structure stores a node in the parsed tree of an expression.
+
+Members:
+
+    Type - Stores the node type.
+
+    Flags - Stores a bitfield of flags. See YY_LEX_NODE_* definitions.
+
+    Left - Stores the index of the left or only child node. For leaves, this
+        is the position number of the leaf within the expression.
+
+    Right - Stores the index of the right child node.
+
+    First - Stores the set of characters that can start a match of this node.
+        For leaves, this is the set of characters the leaf matches.
+
+--*/
+
+typedef struct _YY_LEX_NODE {
+    YY_LEX_NODE_TYPE Type;
+    ULONG Flags;
+    ULONG Left;
+    ULONG Right;
+    ULONG First[YY_LEX_CHARACTER_WORDS];
+} YY_LEX_NODE, *PYY_LEX_NODE;
+
+/*++
+
+Structure Description:
+
+    This structure stores information about a single expression being
+    compiled.
+
+Members:
+
+    Flags - Stores a bitfield of flags. See YY_LEX_EXPRESSION_* definitions.
+
+    Base - Stores the first position number belonging to the expression.
+
+    LeafCount - Stores the number of leaf positions in the expression. The
+        position after the leaves is the end marker for the expression.
+
+--*/
+
+typedef struct _YY_LEX_EXPRESSION {
+    ULONG Flags;
+    ULONG Base;
+    ULONG LeafCount;
+} YY_LEX_EXPRESSION, *PYY_LEX_EXPRESSION;
+
+/*++
+
+Structure Description:
+
+    This structure stores the working state of the lexer compiler.
+
+Members:
+
+    Reallocate - Stores a pointer to the memory allocation routine.
+
+    Context - Stores the context passed to the reallocate routine.
+
+    Status - Stores the first allocation failure encountered while parsing.
+
+    Nodes - Stores the array of nodes for the expression being parsed.
+
+    NodeCount - Stores the number of valid nodes.
+
+    NodeCapacity - Stores the number of allocated nodes.
+
+    LeafCount - Stores the number of leaves in the current expression.
+
+    Depth - Stores the current parentheses nesting depth while parsing.
+
+    NonGreedyCount - Stores the number of non-greedy repeats that are not at
+        the end of their subexpression.
+
+    Alternates - Stores a boolean indicating whether or not the top level
+        of the expression contains alternates.
+
+    Unsupported - Stores a boolean indicating that the current expression
+        uses something that cannot be compiled.
+
+    PositionCount - Stores the total number of positions across all
+        expressions.
+
+    PositionWords - Stores the number of words in a bitmap of positions.
+
+    CharacterSets - Stores the character bitmap of each position.
+
+    Follow - Stores the bitmap of positions that can follow each position.
+
+    FirstPositions - Stores temporary first position bitmaps for each node
+        of the current expression.
+
+    LastPositions - Stores temporary last position bitmaps for each node of
+        the current expression.
+
+    ClassCount - Stores the number of input character classes.
+
+    Classes - Stores the class of each input character.
+
+    Representatives - Stores a character belonging to each class.
+
+--*/
+
+typedef struct _YY_LEX_COMPILER {
+    PYY_REALLOCATE Reallocate;
+    PVOID Context;
+    KSTATUS Status;
+    PYY_LEX_NODE Nodes;
+    ULONG NodeCount;
+    ULONG NodeCapacity;
+    ULONG LeafCount;
+    ULONG Depth;
+    ULONG NonGreedyCount;
+    BOOL Alternates;
+    BOOL Unsupported;
+    ULONG PositionCount;
+    ULONG PositionWords;
+    PULONG CharacterSets;
+    PULONG Follow;
+    PULONG FirstPositions;
+    PULONG LastPositions;
+    ULONG ClassCount;
+    UCHAR Classes[256];
+    UCHAR Representatives[256];
+} YY_LEX_COMPILER, *PYY_LEX_COMPILER;
+
+/*++
+
+Structure Description:
+
+    This structure stores an uncompressed state machine while it is being
+    built.
+
+Members:
+
+    Expressions - Stores the array of expression information.
+
+    ExpressionCount - Stores the number of expressions in the set.
+
+    StateCount - Stores the number of states.
+
+    StateCapacity - Stores the number of states allocated.
+
+    Sets - Stores the position bitmap of each state.
+
+    Transitions - Stores the transition table.
+
+    Accept - Stores the accepting expression plus one of each state.
+
+    EndAccept - Stores the expression plus one matched at end of input for
+        each state.
+
+    Buckets - Stores the heads of the hash chains used to find states.
+
+    Next - Stores the next state in each hash chain.
+
+--*/
+
+typedef struct _YY_LEX_BUILD {
+    PYY_LEX_EXPRESSION Expressions;
+    ULONG ExpressionCount;
+    ULONG StateCount;
+    ULONG StateCapacity;
+    PULONG Sets;
+    PUSHORT Transitions;
+    PUSHORT Accept;
+    PUSHORT EndAccept;
+    PULONG Buckets;
+    PULONG Next;
+} YY_LEX_BUILD, *PYY_LEX_BUILD;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+KSTATUS
+YypLexAnalyzeExpressions (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *Expressions,
+    PYY_LEX_BUILD Build
+    );
+
+KSTATUS
+YypLexBuildPositions (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *Expressions,
+    PYY_LEX_BUILD Build
+    );
+
+VOID
+YypLexComputeClasses (
+    PYY_LEX_COMPILER Compiler
+    );
+
+KSTATUS
+YypLexBuildDfa (
+    PYY_LEX_COMPILER Compiler,
+    PYY_LEX_BUILD Build
+    );
+
+KSTATUS
+YypLexMinimizeDfa (
+    PYY_LEX_COMPILER Compiler,
+    PYY_LEX_BUILD Build
+    );
+
+ULONG
+YypLexPartition (
+    PYY_LEX_COMPILER Compiler,
+    PULONG Signatures,
+    ULONG Width,
+    ULONG Count,
+    PULONG Blocks
+    );
+
+KSTATUS
+YypLexAddState (
+    PYY_LEX_COMPILER Compiler,
+    PYY_LEX_BUILD Build,
+    PULONG Set,
+    PULONG State
+    );
+
+VOID
+YypLexFinishSet (
+    PYY_LEX_BUILD Build,
+    PULONG Set,
+    PUSHORT Accept,
+    PUSHORT EndAccept
+    );
+
+ULONG
+YypLexParseExpression (
+    PYY_LEX_COMPILER Compiler,
+    PSTR Expression
+    );
+
+ULONG
+YypLexParseSubexpression (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *ExpressionPointer
+    );
+
+ULONG
+YypLexParseBranch (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *ExpressionPointer
+    );
+
+ULONG
+YypLexParseComponent (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *ExpressionPointer
+    );
+
+ULONG
+YypLexCreateNode (
+    PYY_LEX_COMPILER Compiler,
+    YY_LEX_NODE_TYPE Type,
+    ULONG Left,
+    ULONG Right
+    );
+
+BOOL
+YypLexCheckNode (
+    PYY_LEX_COMPILER Compiler,
+    ULONG NodeIndex,
+    PULONG Follow
+    );
+
+VOID
+YypLexComputePositions (
+    PYY_LEX_COMPILER Compiler,
+    ULONG NodeIndex,
+    ULONG Base
+    );
+
+VOID
+YypLexFreeBuild (
+    PYY_LEX_COMPILER Compiler,
+    PYY_LEX_BUILD Build
+    );
+
+BOOL
+YypLexIntersects (
+    PULONG Left,
+    PULONG Right,
+    ULONG Words
+    );
+
+ULONG
+YypLexHash (
+    PULONG Words,
+    ULONG Count
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+YY_API
+KSTATUS
+YyLexCompile (
+    PLEXER Lexer,
+    PYY_REALLOCATE Reallocate,
+    PVOID Context,
+    PYY_LEX_TABLE *Table
+    )
+
+/*++
+
+Routine Description:
+
+    This routine compiles the expressions and ignore expressions of the given
+    lexer into a single deterministic state machine for each set, so that
+    tokens can be matched in one pass over the input rather than by trying
+    every expression in turn. Expressions using constructs that the state
+    machine cannot represent exactly are left to the expression interpreter.
+    The resulting table can be shared by any number of lexers using the same
+    expressions, and is attached by setting the table member of the lexer.
+
+Arguments:
+
+    Lexer - Supplies a pointer to a lexer whose expressions and ignore
+        expressions are filled in.
+
+    Reallocate - Supplies a pointer to the function used to allocate and free
+        memory.
+
+    Context - Supplies the context pointer to pass to the reallocate function.
+
+    Table - Supplies a pointer where a pointer to the compiled table will be
+        returned on success.
+
+Return Value:
+
+    STATUS_SUCCESS on success.
+
+    STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+
+    STATUS_NOT_SUPPORTED if the state machine grew too large. The lexer works
+    correctly without a table in this case.
+
+--*/
+
+{
+
+    UINTN AllocationSize;
+    PYY_LEX_BUILD Build;
+    YY_LEX_BUILD Builds[2];
+    YY_LEX_COMPILER Compiler;
+    PYY_LEX_DFA Dfa;
+    PYY_LEX_DFA Dfas[2];
+    PSTR *ExpressionSets[2];
+    ULONG FallbackCount;
+    ULONG Index;
+    PUCHAR Memory;
+    PYY_LEX_TABLE NewTable;
+    ULONG Set;
+    UINTN Size;
+    KSTATUS Status;
+
+    memset(&Compiler, 0, sizeof(YY_LEX_COMPILER));
+    memset(Builds, 0, sizeof(Builds));
+    Compiler.Reallocate = Reallocate;
+    Compiler.Context = Context;
+    ExpressionSets[0] = Lexer->Expressions;
+    ExpressionSets[1] = Lexer->IgnoreExpressions;
+    NewTable = NULL;
+
+    //
+    // Figure out which expressions can be compiled, and how many positions
+    // each one needs.
+    //
+
+    for (Set = 0; Set < 2; Set += 1) {
+        Status = YypLexAnalyzeExpressions(&Compiler,
+                                          ExpressionSets[Set],
+                                          &(Builds[Set]));
+
+        if (!KSUCCESS(Status)) {
+            goto LexCompileEnd;
+        }
+    }
+
+    //
+    // Allocate one extra position so nothing is zero sized.
+    //
+
+    Compiler.PositionWords = YY_LEX_BITMAP_WORDS(Compiler.PositionCount + 1);
+    Size = (Compiler.PositionCount + 1) * YY_LEX_CHARACTER_WORDS *
+           sizeof(ULONG);
+
+    Compiler.CharacterSets = YypLexReallocate(&Compiler, NULL, Size);
+    Size = (Compiler.PositionCount + 1) * Compiler.PositionWords *
+           sizeof(ULONG);
+
+    Compiler.Follow = YypLexReallocate(&Compiler, NULL, Size);
+    if ((Compiler.CharacterSets == NULL) || (Compiler.Follow == NULL)) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto LexCompileEnd;
+    }
+
+    memset(Compiler.Follow, 0, Size);
+    for (Set = 0; Set < 2; Set += 1) {
+        Status = YypLexBuildPositions(&Compiler,
+                                      ExpressionSets[Set],
+                                      &(Builds[Set]));
+
+        if (!KSUCCESS(Status)) {
+            goto LexCompileEnd;
+        }
+    }
+
+    YypLexComputeClasses(&Compiler);
+    for (Set = 0; Set < 2; Set += 1) {
+        Status = YypLexBuildDfa(&Compiler, &(Builds[Set]));
+        if (!KSUCCESS(Status)) {
+            goto LexCompileEnd;
+        }
+
+        Status = YypLexMinimizeDfa(&Compiler, &(Builds[Set]));
+        if (!KSUCCESS(Status)) {
+            goto LexCompileEnd;
+        }
+    }
+
+    //
+    // Pack everything into a single allocation. The ULONG arrays go first to
+    // keep them aligned.
+    //
+
+    AllocationSize = ALIGN_RANGE_UP(sizeof(YY_LEX_TABLE), sizeof(ULONG));
+    for (Set = 0; Set < 2; Set += 1) {
+        Build = &(Builds[Set]);
+        FallbackCount = 0;
+        for (Index = 0; Index < Build->ExpressionCount; Index += 1) {
+            if ((Build->Expressions[Index].Flags &
+                 YY_LEX_EXPRESSION_SUPPORTED) == 0) {
+
+                FallbackCount += 1;
+            }
+        }
+
+        AllocationSize += FallbackCount * sizeof(ULONG);
+    }
+
+    for (Set = 0; Set < 2; Set += 1) {
+        Build = &(Builds[Set]);
+        AllocationSize += Build->StateCount * Compiler.ClassCount *
+                          sizeof(USHORT);
+
+        AllocationSize += Build->StateCount * 2 * sizeof(USHORT);
+    }
+
+    NewTable = YypLexReallocate(&Compiler, NULL, AllocationSize);
+    if (NewTable == NULL) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto LexCompileEnd;
+    }
+
+    memset(NewTable, 0, sizeof(YY_LEX_TABLE));
+    NewTable->ClassCount = Compiler.ClassCount;
+    memcpy(NewTable->Classes, Compiler.Classes, sizeof(Compiler.Classes));
+    Dfas[0] = &(NewTable->Expressions);
+    Dfas[1] = &(NewTable->IgnoreExpressions);
+    Memory = (PUCHAR)NewTable +
+             ALIGN_RANGE_UP(sizeof(YY_LEX_TABLE), sizeof(ULONG));
+
+    for (Set = 0; Set < 2; Set += 1) {
+        Build = &(Builds[Set]);
+        Dfa = Dfas[Set];
+        Dfa->Fallback = (PULONG)Memory;
+        for (Index = 0; Index < Build->ExpressionCount; Index += 1) {
+            if ((Build->Expressions[Index].Flags &
+                 YY_LEX_EXPRESSION_SUPPORTED) == 0) {
+
+                Dfa->Fallback[Dfa->FallbackCount] = Index;
+                Dfa->FallbackCount += 1;
+            }
+        }
+
+        Memory += Dfa->FallbackCount * sizeof(ULONG);
+    }
+
+    for (Set = 0; Set < 2; Set += 1) {
+        Build = &(Builds[Set]);
+        Dfa = Dfas[Set];
+        Dfa->StateCount = Build->StateCount;
+        Size = Build->StateCount * Compiler.ClassCount * sizeof(USHORT);
+        Dfa->Transitions = (PUSHORT)Memory;
+        memcpy(Dfa->Transitions, Build->Transitions, Size);
+        Memory += Size;
+        Size = Build->StateCount * sizeof(USHORT);
+        Dfa->Accept = (PUSHORT)Memory;
+        memcpy(Dfa->Accept, Build->Accept, Size);
+        Memory += Size;
+        Dfa->EndAccept = (PUSHORT)Memory;
+        memcpy(Dfa->EndAccept, Build->EndAccept, Size);
+        Memory += Size;
+    }
+
+    assert(Memory == (PUCHAR)NewTable + AllocationSize);
+
+    Status = STATUS_SUCCESS;
+
+LexCompileEnd:
+    for (Set = 0; Set < 2; Set += 1) {
+        YypLexFreeBuild(&Compiler, &(Builds[Set]));
+    }
+
+    if (Compiler.Nodes != NULL) {
+        YypLexReallocate(&Compiler, Compiler.Nodes, 0);
+    }
+
+    if (Compiler.CharacterSets != NULL) {
+        YypLexReallocate(&Compiler, Compiler.CharacterSets, 0);
+    }
+
+    if (Compiler.Follow != NULL) {
+        YypLexReallocate(&Compiler, Compiler.Follow, 0);
+    }
+
+    if (Compiler.FirstPositions != NULL) {
+        YypLexReallocate(&Compiler, Compiler.FirstPositions, 0);
+    }
+
+    if (Compiler.LastPositions != NULL) {
+        YypLexReallocate(&Compiler, Compiler.LastPositions, 0);
+    }
+
+    *Table = NewTable;
+    return Status;
+}
+
+YY_API
+VOID
+YyLexDestroyTable (
+    PYY_LEX_TABLE Table,
+    PYY_REALLOCATE Reallocate,
+    PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    This routine destroys a compiled lexer table.
+
+Arguments:
+
+    Table - Supplies a pointer to the table to destroy.
+
+    Reallocate - Supplies a pointer to the function used to allocate and free
+        memory.
+
+    Context - Supplies the context pointer to pass to the reallocate function.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    Reallocate(Context, Table, 0);
+    return;
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+KSTATUS
+YypLexAnalyzeExpressions (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *Expressions,
+    PYY_LEX_BUILD Build
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses each expression in a set to determine whether or not
+    it can be compiled, and assigns positions to those that can.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    Expressions - Supplies the null terminated array of expressions.
+
+    Build - Supplies a pointer to the build state for the set.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONG Count;
+    PYY_LEX_EXPRESSION Information;
+    ULONG Root;
+
+    Count = 0;
+    if (Expressions != NULL) {
+        while (Expressions[Count] != NULL) {
+            Count += 1;
+        }
+    }
+
+    //
+    // The accept arrays store the expression index plus one in a USHORT.
+    //
+
+    if (Count >= MAX_USHORT) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    Build->ExpressionCount = Count;
+    Build->Expressions = YypLexReallocate(Compiler,
+                                          NULL,
+                                          (Count + 1) *
+                                          sizeof(YY_LEX_EXPRESSION));
+
+    if (Build->Expressions == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    memset(Build->Expressions, 0, (Count + 1) * sizeof(YY_LEX_EXPRESSION));
+    for (Count = 0; Count < Build->ExpressionCount; Count += 1) {
+        Information = &(Build->Expressions[Count]);
+        Root = YypLexParseExpression(Compiler, Expressions[Count]);
+        if (!KSUCCESS(Compiler->Status)) {
+            return Compiler->Status;
+        }
+
+        if (Root == YY_LEX_INVALID_NODE) {
+            continue;
+        }
+
+        Information->Flags = YY_LEX_EXPRESSION_SUPPORTED;
+        if (Compiler->NonGreedyCount != 0) {
+            Information->Flags |= YY_LEX_EXPRESSION_SHORTEST;
+        }
+
+        Information->Base = Compiler->PositionCount;
+        Information->LeafCount = Compiler->LeafCount;
+        Compiler->PositionCount += Compiler->LeafCount + 1;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+KSTATUS
+YypLexBuildPositions (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *Expressions,
+    PYY_LEX_BUILD Build
+    )
+
+/*++
+
+Routine Description:
+
+    This routine fills in the character sets and follow sets of every position
+    in the compiled expressions of a set.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    Expressions - Supplies the null terminated array of expressions.
+
+    Build - Supplies a pointer to the build state for the set.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONG Base;
+    ULONG Index;
+    PYY_LEX_EXPRESSION Information;
+    PULONG Follow;
+    ULONG Leaf;
+    ULONG Marker;
+    PYY_LEX_NODE Node;
+    ULONG NodeIndex;
+    PULONG Positions;
+    ULONG Root;
+    UINTN Size;
+    ULONG Words;
+
+    for (Index = 0; Index < Build->ExpressionCount; Index += 1) {
+        Information = &(Build->Expressions[Index]);
+        if ((Information->Flags & YY_LEX_EXPRESSION_SUPPORTED) == 0) {
+            continue;
+        }
+
+        Root = YypLexParseExpression(Compiler, Expressions[Index]);
+
+        assert((Root != YY_LEX_INVALID_NODE) &&
+               (Compiler->LeafCount == Information->LeafCount));
+
+        //
+        // Allocate the temporary first and last position bitmaps, which are
+        // indexed by position within the expression.
+        //
+
+        Base = Information->Base;
+        Words = YY_LEX_BITMAP_WORDS(Information->LeafCount);
+        Size = Compiler->NodeCount * Words * sizeof(ULONG);
+        if (Compiler->FirstPositions != NULL) {
+            YypLexReallocate(Compiler, Compiler->FirstPositions, 0);
+            YypLexReallocate(Compiler, Compiler->LastPositions, 0);
+            Compiler->LastPositions = NULL;
+        }
+
+        Compiler->FirstPositions = YypLexReallocate(Compiler, NULL, Size);
+        if (Compiler->FirstPositions == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        Compiler->LastPositions = YypLexReallocate(Compiler, NULL, Size);
+        if (Compiler->LastPositions == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        memset(Compiler->FirstPositions, 0, Size);
+        memset(Compiler->LastPositions, 0, Size);
+        for (NodeIndex = 0; NodeIndex < Compiler->NodeCount; NodeIndex += 1) {
+            Node = &(Compiler->Nodes[NodeIndex]);
+            if (Node->Type == YyLexNodeLeaf) {
+                memcpy(&(Compiler->CharacterSets[(Base + Node->Left) *
+                                                 YY_LEX_CHARACTER_WORDS]),
+                       Node->First,
+                       sizeof(Node->First));
+            }
+        }
+
+        YypLexComputePositions(Compiler, Root, Base);
+
+        //
+        // The end marker follows every position that can end the expression.
+        //
+
+        Marker = Base + Information->LeafCount;
+        memset(&(Compiler->CharacterSets[Marker * YY_LEX_CHARACTER_WORDS]),
+               0,
+               YY_LEX_CHARACTER_WORDS * sizeof(ULONG));
+
+        Positions = &(Compiler->LastPositions[Root * Words]);
+        for (Leaf = 0; Leaf < Information->LeafCount; Leaf += 1) {
+            if (YY_LEX_TEST_BIT(Positions, Leaf)) {
+                Follow = &(Compiler->Follow[(Base + Leaf) *
+                                            Compiler->PositionWords]);
+
+                YY_LEX_SET_BIT(Follow, Marker);
+            }
+        }
+
+        //
+        // Stash the first positions of the expression in the marker's follow
+        // set, which is otherwise unused. The start state is built from these.
+        //
+
+        Follow = &(Compiler->Follow[Marker * Compiler->PositionWords]);
+        Positions = &(Compiler->FirstPositions[Root * Words]);
+        for (Leaf = 0; Leaf < Information->LeafCount; Leaf += 1) {
+            if (YY_LEX_TEST_BIT(Positions, Leaf)) {
+                YY_LEX_SET_BIT(Follow, Base + Leaf);
+            }
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+YypLexComputeClasses (
+    PYY_LEX_COMPILER Compiler
+    )
+
+/*++
+
+Routine Description:
+
+    This routine divides the input characters into classes of characters that
+    every position treats identically. The null character always gets a class
+    of its own, since it always sends the token back to the interpreter.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Character;
+    UCHAR Classes[256];
+    ULONG ClassCount;
+    USHORT Map[256][2];
+    ULONG Member;
+    ULONG Position;
+    PULONG Set;
+
+    Classes[0] = 0;
+    for (Character = 1; Character < 256; Character += 1) {
+        Classes[Character] = 1;
+    }
+
+    ClassCount = 2;
+
+    //
+    // Split classes by each position's character set in turn.
+    //
+
+    for (Position = 0; Position < Compiler->PositionCount; Position += 1) {
+        Set = &(Compiler->CharacterSets[Position * YY_LEX_CHARACTER_WORDS]);
+        memset(Map, 0xFF, sizeof(Map));
+        ClassCount = 0;
+        for (Character = 0; Character < 256; Character += 1) {
+            Member = 0;
+            if (YY_LEX_TEST_BIT(Set, Character)) {
+                Member = 1;
+            }
+
+            if (Map[Classes[Character]][Member] == MAX_USHORT) {
+                Map[Classes[Character]][Member] = ClassCount;
+                ClassCount += 1;
+            }
+
+            Classes[Character] = Map[Classes[Character]][Member];
+        }
+    }
+
+    Compiler->ClassCount = ClassCount;
+    for (Character = 256; Character != 0; Character -= 1) {
+        Compiler->Representatives[Classes[Character - 1]] = Character - 1;
+    }
+
+    memcpy(Compiler->Classes, Classes, sizeof(Classes));
+
+    assert((Classes[0] == 0) && (Compiler->Representatives[0] == 0));
+
+    return;
+}
+
+KSTATUS
+YypLexBuildDfa (
+    PYY_LEX_COMPILER Compiler,
+    PYY_LEX_BUILD Build
+    )
+
+/*++
+
+Routine Description:
+
+    This routine runs the subset construction over the positions of a set of
+    expressions.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    Build - Supplies a pointer to the build state for the set.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONG Bit;
+    ULONG Class;
+    PULONG Follow;
+    ULONG Index;
+    PYY_LEX_EXPRESSION Information;
+    ULONG Marker;
+    ULONG NextState;
+    PULONG Set;
+    PULONG CharacterSet;
+    ULONG State;
+    KSTATUS Status;
+    PULONG Targets;
+    ULONG Word;
+    ULONG Words;
+
+    Words = Compiler->PositionWords;
+    Targets = YypLexReallocate(Compiler,
+                               NULL,
+                               (Compiler->ClassCount + 1) * (Words + 1) *
+                               sizeof(ULONG));
+
+    Build->Buckets = YypLexReallocate(Compiler,
+                                      NULL,
+                                      YY_LEX_HASH_BUCKETS * sizeof(ULONG));
+
+    if ((Targets == NULL) || (Build->Buckets == NULL)) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto LexBuildDfaEnd;
+    }
+
+    memset(Build->Buckets, 0xFF, YY_LEX_HASH_BUCKETS * sizeof(ULONG));
+
+    //
+    // Create the dead and fallback states, which have special meanings, and
+    // then the start state from the first positions of every expression. The
+    // extra word after each set keeps the special states from being found
+    // by a lookup.
+    //
+
+    memset(Targets, 0, (Words + 1) * sizeof(ULONG));
+    for (Index = 0; Index < YY_LEX_STATE_START; Index += 1) {
+        Targets[Words] = Index;
+        Status = YypLexAddState(Compiler, Build, Targets, &State);
+        if (!KSUCCESS(Status)) {
+            goto LexBuildDfaEnd;
+        }
+    }
+
+    Targets[Words] = YY_LEX_STATE_START;
+
+    for (Index = 0; Index < Build->ExpressionCount; Index += 1) {
+        Information = &(Build->Expressions[Index]);
+        if ((Information->Flags & YY_LEX_EXPRESSION_SUPPORTED) != 0) {
+            Marker = Information->Base + Information->LeafCount;
+            Follow = &(Compiler->Follow[Marker * Words]);
+            for (Word = 0; Word < Words; Word += 1) {
+                Targets[Word] |= Follow[Word];
+            }
+        }
+    }
+
+    Status = YypLexAddState(Compiler, Build, Targets, &State);
+    if (!KSUCCESS(Status)) {
+        goto LexBuildDfaEnd;
+    }
+
+    assert(State == YY_LEX_STATE_START);
+
+    //
+    // Process states until no new ones are discovered.
+    //
+
+    for (State = YY_LEX_STATE_START; State < Build->StateCount; State += 1) {
+        memset(Targets,
+               0,
+               Compiler->ClassCount * (Words + 1) * sizeof(ULONG));
+
+        Set = &(Build->Sets[State * (Words + 1)]);
+        for (Bit = 0; Bit < Compiler->PositionCount; Bit += 1) {
+            if ((Set[Bit / 32] == 0) && ((Bit % 32) == 0)) {
+                Bit += 31;
+                continue;
+            }
+
+            if (!YY_LEX_TEST_BIT(Set, Bit)) {
+                continue;
+            }
+
+            CharacterSet = &(Compiler->CharacterSets[Bit *
+                                                     YY_LEX_CHARACTER_WORDS]);
+
+            Follow = &(Compiler->Follow[Bit * Words]);
+            for (Class = 1; Class < Compiler->ClassCount; Class += 1) {
+                if (YY_LEX_TEST_BIT(CharacterSet,
+                                    Compiler->Representatives[Class])) {
+
+                    for (Word = 0; Word < Words; Word += 1) {
+                        Targets[(Class * (Words + 1)) + Word] |= Follow[Word];
+                    }
+                }
+            }
+        }
+
+        for (Class = 0; Class < Compiler->ClassCount; Class += 1) {
+            if (Class == 0) {
+                NextState = YY_LEX_STATE_FALLBACK;
+
+            } else {
+
+                //
+                // Once a shortest match expression reaches its end marker, it
+                // stops trying to match anything longer.
+                //
+
+                Set = &(Targets[Class * (Words + 1)]);
+                for (Index = 0; Index < Build->ExpressionCount; Index += 1) {
+                    Information = &(Build->Expressions[Index]);
+                    if ((Information->Flags &
+                         YY_LEX_EXPRESSION_SHORTEST) == 0) {
+
+                        continue;
+                    }
+
+                    Marker = Information->Base + Information->LeafCount;
+                    if (YY_LEX_TEST_BIT(Set, Marker)) {
+                        for (Bit = Information->Base; Bit < Marker; Bit += 1) {
+                            YY_LEX_CLEAR_BIT(Set, Bit);
+                        }
+                    }
+                }
+
+                Status = YypLexAddState(Compiler, Build, Set, &NextState);
+                if (!KSUCCESS(Status)) {
+                    goto LexBuildDfaEnd;
+                }
+            }
+
+            Build->Transitions[(State * Compiler->ClassCount) + Class] =
+                                                                     NextState;
+        }
+    }
+
+    //
+    // Neither of the special states go anywhere.
+    //
+
+    for (Class = 0; Class < Compiler->ClassCount; Class += 1) {
+        Build->Transitions[(YY_LEX_STATE_DEAD * Compiler->ClassCount) +
+                           Class] = YY_LEX_STATE_DEAD;
+
+        Build->Transitions[(YY_LEX_STATE_FALLBACK * Compiler->ClassCount) +
+                           Class] = YY_LEX_STATE_FALLBACK;
+    }
+
+    Status = STATUS_SUCCESS;
+
+LexBuildDfaEnd:
+    if (Targets != NULL) {
+        YypLexReallocate(Compiler, Targets, 0);
+    }
+
+    return Status;
+}
+
+KSTATUS
+YypLexMinimizeDfa (
+    PYY_LEX_COMPILER Compiler,
+    PYY_LEX_BUILD Build
+    )
+
+/*++
+
+Routine Description:
+
+    This routine minimizes a state machine by repeatedly splitting groups of
+    states that behave differently until every group is uniform, and then
+    merging each group into a single state.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    Build - Supplies a pointer to the build state for the set.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    PULONG Blocks;
+    ULONG BlockCount;
+    ULONG Class;
+    ULONG ClassCount;
+    PULONG NewBlocks;
+    ULONG NewCount;
+    PULONG Numbers;
+    PULONG Signature;
+    PULONG Signatures;
+    ULONG State;
+    ULONG StateCount;
+    KSTATUS Status;
+    PUSHORT Transitions;
+    ULONG Width;
+
+    ClassCount = Compiler->ClassCount;
+    StateCount = Build->StateCount;
+    Width = ClassCount + 1;
+    Blocks = YypLexReallocate(Compiler, NULL, StateCount * sizeof(ULONG));
+    NewBlocks = YypLexReallocate(Compiler, NULL, StateCount * sizeof(ULONG));
+    Numbers = YypLexReallocate(Compiler, NULL, StateCount * sizeof(ULONG));
+    Signatures = YypLexReallocate(Compiler,
+                                  NULL,
+                                  StateCount * Width * sizeof(ULONG));
+
+    if ((Blocks == NULL) || (NewBlocks == NULL) || (Numbers == NULL) ||
+        (Signatures == NULL)) {
+
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto LexMinimizeDfaEnd;
+    }
+
+    //
+    // Start by grouping states that accept the same thing.
+    //
+
+    for (State = 0; State < StateCount; State += 1) {
+        Signature = &(Signatures[State * 3]);
+        Signature[0] = Build->Accept[State];
+        Signature[1] = Build->EndAccept[State];
+        Signature[2] = (State == YY_LEX_STATE_FALLBACK);
+    }
+
+    BlockCount = YypLexPartition(Compiler, Signatures, 3, StateCount, Blocks);
+    if (BlockCount == 0) {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto LexMinimizeDfaEnd;
+    }
+
+    //
+    // Split groups whose states move to different groups until nothing
+    // changes.
+    //
+
+    while (TRUE) {
+        for (State = 0; State < StateCount; State += 1) {
+            Signature = &(Signatures[State * Width]);
+            Signature[0] = Blocks[State];
+            Transitions = &(Build->Transitions[State * ClassCount]);
+            for (Class = 0; Class < ClassCount; Class += 1) {
+                Signature[Class + 1] = Blocks[Transitions[Class]];
+            }
+        }
+
+        NewCount = YypLexPartition(Compiler,
+                                   Signatures,
+                                   Width,
+                                   StateCount,
+                                   NewBlocks);
+
+        if (NewCount == 0) {
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto LexMinimizeDfaEnd;
+        }
+
+        memcpy(Blocks, NewBlocks, StateCount * sizeof(ULONG));
+        if (NewCount == BlockCount) {
+            break;
+        }
+
+        BlockCount = NewCount;
+    }
+
+    //
+    // Number the groups, keeping the special states in their places. The
+    // special states are alone in their groups since nothing else is dead,
+    // and the start state is never reentered.
+    //
+
+    memset(Numbers, 0xFF, StateCount * sizeof(ULONG));
+    Numbers[Blocks[YY_LEX_STATE_DEAD]] = YY_LEX_STATE_DEAD;
+    Numbers[Blocks[YY_LEX_STATE_FALLBACK]] = YY_LEX_STATE_FALLBACK;
+    Numbers[Blocks[YY_LEX_STATE_START]] = YY_LEX_STATE_START;
+    NewCount = YY_LEX_STATE_START + 1;
+    for (State = 0; State < StateCount; State += 1) {
+        if (Numbers[Blocks[State]] == (ULONG)-1) {
+            Numbers[Blocks[State]] = NewCount;
+            NewCount += 1;
+        }
+    }
+
+    assert(NewCount == BlockCount);
+
+    //
+    // Compact the tables in place. Each state lands at or before its old
+    // index, since groups are numbered in order of their first state.
+    //
+
+    for (State = 0; State < StateCount; State += 1) {
+        NewBlocks[State] = Numbers[Blocks[State]];
+    }
+
+    for (State = 0; State < StateCount; State += 1) {
+        if (Numbers[Blocks[State]] == (ULONG)-1) {
+            continue;
+        }
+
+        Numbers[Blocks[State]] = (ULONG)-1;
+
+        assert(NewBlocks[State] <= State);
+
+        Transitions = &(Build->Transitions[State * ClassCount]);
+        for (Class = 0; Class < ClassCount; Class += 1) {
+            Build->Transitions[(NewBlocks[State] * ClassCount) + Class] =
+                                                 NewBlocks[Transitions[Class]];
+        }
+
+        Build->Accept[NewBlocks[State]] = Build->Accept[State];
+        Build->EndAccept[NewBlocks[State]] = Build->EndAccept[State];
+    }
+
+    Build->StateCount = BlockCount;
+    Status = STATUS_SUCCESS;
+
+LexMinimizeDfaEnd:
+    if (Blocks != NULL) {
+        YypLexReallocate(Compiler, Blocks, 0);
+    }
+
+    if (NewBlocks != NULL) {
+        YypLexReallocate(Compiler, NewBlocks, 0);
+    }
+
+    if (Numbers != NULL) {
+        YypLexReallocate(Compiler, Numbers, 0);
+    }
+
+    if (Signatures != NULL) {
+        YypLexReallocate(Compiler, Signatures, 0);
+    }
+
+    return Status;
+}
+
+ULONG
+YypLexPartition (
+    PYY_LEX_COMPILER Compiler,
+    PULONG Signatures,
+    ULONG Width,
+    ULONG Count,
+    PULONG Blocks
+    )
+
+/*++
+
+Routine Description:
+
+    This routine groups states with identical signatures.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    Signatures - Supplies the array of signatures, one for each state.
+
+    Width - Supplies the number of words in each signature.
+
+    Count - Supplies the number of states.
+
+    Blocks - Supplies an array where the group number of each state will be
+        returned. Groups are numbered in order of their first state.
+
+Return Value:
+
+    Returns the number of groups.
+
+    0 on allocation failure.
+
+--*/
+
+{
+
+    ULONG Block;
+    ULONG BlockCount;
+    PULONG Buckets;
+    ULONG Hash;
+    PULONG Next;
+    PULONG Representatives;
+    ULONG State;
+
+    BlockCount = 0;
+    Buckets = YypLexReallocate(Compiler,
+                               NULL,
+                               YY_LEX_HASH_BUCKETS * sizeof(ULONG));
+
+    Next = YypLexReallocate(Compiler, NULL, Count * sizeof(ULONG));
+    Representatives = YypLexReallocate(Compiler, NULL, Count * sizeof(ULONG));
+    if ((Buckets == NULL) || (Next == NULL) || (Representatives == NULL)) {
+        goto LexPartitionEnd;
+    }
+
+    memset(Buckets, 0xFF, YY_LEX_HASH_BUCKETS * sizeof(ULONG));
+    for (State = 0; State < Count; State += 1) {
+        Hash = YypLexHash(&(Signatures[State * Width]), Width) %
+               YY_LEX_HASH_BUCKETS;
+
+        Block = Buckets[Hash];
+        while (Block != (ULONG)-1) {
+            if (memcmp(&(Signatures[State * Width]),
+                       &(Signatures[Representatives[Block] * Width]),
+                       Width * sizeof(ULONG)) == 0) {
+
+                break;
+            }
+
+            Block = Next[Block];
+        }
+
+        if (Block == (ULONG)-1) {
+            Block = BlockCount;
+            BlockCount += 1;
+            Representatives[Block] = State;
+            Next[Block] = Buckets[Hash];
+            Buckets[Hash] = Block;
+        }
+
+        Blocks[State] = Block;
+    }
+
+LexPartitionEnd:
+    if (Buckets != NULL) {
+        YypLexReallocate(Compiler, Buckets, 0);
+    }
+
+    if (Next != NULL) {
+        YypLexReallocate(Compiler, Next, 0);
+    }
+
+    if (Representatives != NULL) {
+        YypLexReallocate(Compiler, Representatives, 0);
+    }
+
+    return BlockCount;
+}
+
+KSTATUS
+YypLexAddState (
+    PYY_LEX_COMPILER Compiler,
+    PYY_LEX_BUILD Build,
+    PULONG Set,
+    PULONG State
+    )
+
+/*++
+
+Routine Description:
+
+    This routine finds or creates the state for the given set of positions.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    Build - Supplies a pointer to the build state.
+
+    Set - Supplies the bitmap of positions, followed by one extra word which
+        is zero for everything but the special states.
+
+    State - Supplies a pointer where the state number will be returned.
+
+Return Value:
+
+    Status code.
+
+--*/
+
+{
+
+    ULONG Capacity;
+    ULONG Hash;
+    PVOID NewBuffer;
+    ULONG Search;
+    ULONG Words;
+
+    Words = Compiler->PositionWords + 1;
+    Hash = YypLexHash(Set, Words) % YY_LEX_HASH_BUCKETS;
+    Search = Build->Buckets[Hash];
+    while (Search != (ULONG)-1) {
+        if (memcmp(Set,
+                   &(Build->Sets[Search * Words]),
+                   Words * sizeof(ULONG)) == 0) {
+
+            *State = Search;
+            return STATUS_SUCCESS;
+        }
+
+        Search = Build->Next[Search];
+    }
+
+    if (Build->StateCount >= YY_LEX_MAX_STATES) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    //
+    // Expand the arrays if needed.
+    //
+
+    if (Build->StateCount == Build->StateCapacity) {
+        Capacity = Build->StateCapacity * 2;
+        if (Capacity == 0) {
+            Capacity = 64;
+        }
+
+        NewBuffer = YypLexReallocate(Compiler,
+                                     Build->Sets,
+                                     Capacity * Words * sizeof(ULONG));
+
+        if (NewBuffer == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        Build->Sets = NewBuffer;
+        NewBuffer = YypLexReallocate(Compiler,
+                                     Build->Next,
+                                     Capacity * sizeof(ULONG));
+
+        if (NewBuffer == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        Build->Next = NewBuffer;
+        NewBuffer = YypLexReallocate(Compiler,
+                                     Build->Transitions,
+                                     Capacity * Compiler->ClassCount *
+                                     sizeof(USHORT));
+
+        if (NewBuffer == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        Build->Transitions = NewBuffer;
+        NewBuffer = YypLexReallocate(Compiler,
+                                     Build->Accept,
+                                     Capacity * sizeof(USHORT));
+
+        if (NewBuffer == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        Build->Accept = NewBuffer;
+        NewBuffer = YypLexReallocate(Compiler,
+                                     Build->EndAccept,
+                                     Capacity * sizeof(USHORT));
+
+        if (NewBuffer == NULL) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        Build->EndAccept = NewBuffer;
+        Build->StateCapacity = Capacity;
+    }
+
+    *State = Build->StateCount;
+    Build->StateCount += 1;
+    memcpy(&(Build->Sets[*State * Words]), Set, Words * sizeof(ULONG));
+    Build->Next[*State] = Build->Buckets[Hash];
+    Build->Buckets[Hash] = *State;
+    YypLexFinishSet(Build,
+                    Set,
+                    &(Build->Accept[*State]),
+                    &(Build->EndAccept[*State]));
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+YypLexFinishSet (
+    PYY_LEX_BUILD Build,
+    PULONG Set,
+    PUSHORT Accept,
+    PUSHORT EndAccept
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines which expressions a state accepts.
+
+Arguments:
+
+    Build - Supplies a pointer to the build state.
+
+    Set - Supplies the bitmap of positions in the state.
+
+    Accept - Supplies a pointer where one plus the index of the first
+        expression whose end marker is in the state will be returned, or zero
+        if there is none.
+
+    EndAccept - Supplies a pointer where one plus the index of the first
+        expression with any position in the state will be returned, or zero if
+        there is none.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG Bit;
+    ULONG Index;
+    PYY_LEX_EXPRESSION Information;
+    ULONG Marker;
+
+    *Accept = 0;
+    *EndAccept = 0;
+    for (Index = 0; Index < Build->ExpressionCount; Index += 1) {
+        Information = &(Build->Expressions[Index]);
+        if ((Information->Flags & YY_LEX_EXPRESSION_SUPPORTED) == 0) {
+            continue;
+        }
+
+        Marker = Information->Base + Information->LeafCount;
+        if ((*Accept == 0) && (YY_LEX_TEST_BIT(Set, Marker))) {
+            *Accept = Index + 1;
+        }
+
+        if (*EndAccept == 0) {
+            for (Bit = Information->Base; Bit <= Marker; Bit += 1) {
+                if (YY_LEX_TEST_BIT(Set, Bit)) {
+                    *EndAccept = Index + 1;
+                    break;
+                }
+            }
+        }
+
+        if ((*Accept != 0) && (*EndAccept != 0)) {
+            break;
+        }
+    }
+
+    return;
+}
+
+ULONG
+YypLexParseExpression (
+    PYY_LEX_COMPILER Compiler,
+    PSTR Expression
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses an expression into a tree, and determines whether or
+    not it can be compiled.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    Expression - Supplies a pointer to the expression string.
+
+Return Value:
+
+    Returns the index of the root node on success.
+
+    YY_LEX_INVALID_NODE if the expression cannot be compiled or on allocation
+    failure.
+
+--*/
+
+{
+
+    ULONG Follow[YY_LEX_CHARACTER_WORDS];
+    ULONG Root;
+
+    Compiler->NodeCount = 0;
+    Compiler->LeafCount = 0;
+    Compiler->Depth = 0;
+    Compiler->NonGreedyCount = 0;
+    Compiler->Alternates = FALSE;
+    Compiler->Unsupported = FALSE;
+    Root = YypLexParseSubexpression(Compiler, &Expression);
+    if ((Root == YY_LEX_INVALID_NODE) || (*Expression != '\0') ||
+        (Compiler->Unsupported != FALSE)) {
+
+        return YY_LEX_INVALID_NODE;
+    }
+
+    //
+    // Non-greedy repeats in the middle of an expression make the whole
+    // expression end at the first opportunity. This only works if the end of
+    // the expression is not part of an alternate.
+    //
+
+    if ((Compiler->NonGreedyCount > 1) ||
+        ((Compiler->NonGreedyCount != 0) && (Compiler->Alternates != FALSE))) {
+
+        return YY_LEX_INVALID_NODE;
+    }
+
+    //
+    // The interpreter has quirks around empty matches, so leave those to it.
+    //
+
+    if ((Compiler->Nodes[Root].Flags & YY_LEX_NODE_NULLABLE) != 0) {
+        return YY_LEX_INVALID_NODE;
+    }
+
+    memset(Follow, 0, sizeof(Follow));
+    if (YypLexCheckNode(Compiler, Root, Follow) == FALSE) {
+        return YY_LEX_INVALID_NODE;
+    }
+
+    return Root;
+}
+
+ULONG
+YypLexParseSubexpression (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *ExpressionPointer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses a set of alternate branches, stopping at the end of
+    the expression or a close parentheses.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    ExpressionPointer - Supplies a pointer to a pointer to the expression,
+        which is advanced.
+
+Return Value:
+
+    Returns the index of the root node on success.
+
+    YY_LEX_INVALID_NODE if the expression cannot be compiled or on allocation
+    failure.
+
+--*/
+
+{
+
+    ULONG Branch;
+    ULONG Root;
+
+    Root = YypLexParseBranch(Compiler, ExpressionPointer);
+    while ((Root != YY_LEX_INVALID_NODE) && (**ExpressionPointer == '|')) {
+        if (Compiler->Depth == 0) {
+            Compiler->Alternates = TRUE;
+        }
+
+        *ExpressionPointer += 1;
+        Branch = YypLexParseBranch(Compiler, ExpressionPointer);
+        if (Branch == YY_LEX_INVALID_NODE) {
+            return YY_LEX_INVALID_NODE;
+        }
+
+        Root = YypLexCreateNode(Compiler, YyLexNodeAlternate, Root, Branch);
+    }
+
+    return Root;
+}
+
+ULONG
+YypLexParseBranch (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *ExpressionPointer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses a sequence of components and their repeaters.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    ExpressionPointer - Supplies a pointer to a pointer to the expression,
+        which is advanced.
+
+Return Value:
+
+    Returns the index of the root node on success.
+
+    YY_LEX_INVALID_NODE if the expression cannot be compiled or on allocation
+    failure.
+
+--*/
+
+{
+
+    ULONG Component;
+    PSTR Expression;
+    BOOL FixedTail;
+    ULONG NonGreedy;
+    BOOL Repeated;
+    ULONG Root;
+    YY_LEX_NODE_TYPE Type;
+
+    Root = YY_LEX_INVALID_NODE;
+    NonGreedy = YY_LEX_INVALID_NODE;
+    FixedTail = FALSE;
+    Expression = *ExpressionPointer;
+    while ((*Expression != '\0') && (*Expression != ')') &&
+           (*Expression != '|')) {
+
+        Component = YypLexParseComponent(Compiler, &Expression);
+        if (Component == YY_LEX_INVALID_NODE) {
+            return YY_LEX_INVALID_NODE;
+        }
+
+        //
+        // A non-greedy repeat followed by more stuff tries the rest of the
+        // expression before each iteration. This is only supported with a
+        // single character repeated, followed by single characters through the
+        // end of the top level expression.
+        //
+
+        if (NonGreedy != YY_LEX_INVALID_NODE) {
+            if ((Compiler->Depth != 0) ||
+                (Compiler->Nodes[Compiler->Nodes[NonGreedy].Left].Type !=
+                 YyLexNodeLeaf)) {
+
+                Compiler->Unsupported = TRUE;
+            }
+
+            Compiler->NonGreedyCount += 1;
+            NonGreedy = YY_LEX_INVALID_NODE;
+            FixedTail = TRUE;
+        }
+
+        if ((FixedTail != FALSE) &&
+            (Compiler->Nodes[Component].Type != YyLexNodeLeaf)) {
+
+            Compiler->Unsupported = TRUE;
+        }
+
+        Repeated = TRUE;
+        Type = YyLexNodeInvalid;
+        if (*Expression == '?') {
+            Type = YyLexNodeOptional;
+
+        } else if (*Expression == '*') {
+            Type = YyLexNodeStar;
+
+        } else if (*Expression == '+') {
+            Type = YyLexNodePlus;
+
+        } else {
+            Repeated = FALSE;
+        }
+
+        if (Repeated != FALSE) {
+            if (FixedTail != FALSE) {
+                Compiler->Unsupported = TRUE;
+            }
+
+            Expression += 1;
+            Component = YypLexCreateNode(Compiler,
+                                         Type,
+                                         Component,
+                                         YY_LEX_INVALID_NODE);
+
+            if (Component == YY_LEX_INVALID_NODE) {
+                return YY_LEX_INVALID_NODE;
+            }
+
+            if ((Type != YyLexNodeOptional) && (*Expression == '?')) {
+                Expression += 1;
+                Compiler->Nodes[Component].Flags |= YY_LEX_NODE_NON_GREEDY;
+                NonGreedy = Component;
+            }
+
+            //
+            // The interpreter treats an alternate directly after a repeat as
+            // a literal, but skips over it as an alternate.
+            //
+
+            if (*Expression == '|') {
+                Compiler->Unsupported = TRUE;
+            }
+        }
+
+        if (Root == YY_LEX_INVALID_NODE) {
+            Root = Component;
+
+        } else {
+            Root = YypLexCreateNode(Compiler,
+                                    YyLexNodeConcatenate,
+                                    Root,
+                                    Component);
+
+            if (Root == YY_LEX_INVALID_NODE) {
+                return YY_LEX_INVALID_NODE;
+            }
+        }
+    }
+
+    //
+    // A non-greedy repeat at the end of a subexpression has nothing to try
+    // first, so it acts greedy.
+    //
+
+    if (NonGreedy != YY_LEX_INVALID_NODE) {
+        Compiler->Nodes[NonGreedy].Flags &= ~YY_LEX_NODE_NON_GREEDY;
+    }
+
+    //
+    // Empty branches are left to the interpreter.
+    //
+
+    if (Root == YY_LEX_INVALID_NODE) {
+        Compiler->Unsupported = TRUE;
+    }
+
+    *ExpressionPointer = Expression;
+    return Root;
+}
+
+ULONG
+YypLexParseComponent (
+    PYY_LEX_COMPILER Compiler,
+    PSTR *ExpressionPointer
+    )
+
+/*++
+
+Routine Description:
+
+    This routine parses a single component of an expression: a character
+    class, a parenthesized subexpression, a dot, or a literal character.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    ExpressionPointer - Supplies a pointer to a pointer to the expression,
+        which is advanced.
+
+Return Value:
+
+    Returns the index of the new node on success.
+
+    YY_LEX_INVALID_NODE if the expression cannot be compiled or on allocation
+    failure.
+
+--*/
+
+{
+
+    ULONG Character;
+    PSTR ClassEnd;
+    PSTR Expression;
+    PYY_LEX_NODE Node;
+    ULONG NodeIndex;
+
+    Expression = *ExpressionPointer;
+    if (*Expression == '(') {
+        Expression += 1;
+        Compiler->Depth += 1;
+        NodeIndex = YypLexParseSubexpression(Compiler, &Expression);
+        Compiler->Depth -= 1;
+        if (NodeIndex == YY_LEX_INVALID_NODE) {
+            return YY_LEX_INVALID_NODE;
+        }
+
+        if (*Expression != ')') {
+            Compiler->Unsupported = TRUE;
+            return YY_LEX_INVALID_NODE;
+        }
+
+        *ExpressionPointer = Expression + 1;
+        return NodeIndex;
+    }
+
+    NodeIndex = YypLexCreateNode(Compiler,
+                                 YyLexNodeLeaf,
+                                 Compiler->LeafCount,
+                                 YY_LEX_INVALID_NODE);
+
+    if (NodeIndex == YY_LEX_INVALID_NODE) {
+        return YY_LEX_INVALID_NODE;
+    }
+
+    Compiler->LeafCount += 1;
+    Node = &(Compiler->Nodes[NodeIndex]);
+
+    //
+    // Use the interpreter's own character class matching on every character
+    // so that the results are exactly the same.
+    //
+
+    if (*Expression == '[') {
+        ClassEnd = Expression;
+        for (Character = 1; Character < 256; Character += 1) {
+            ClassEnd = Expression;
+            if (YypMatchCharacterClass(&ClassEnd, (CHAR)Character) != FALSE) {
+                YY_LEX_SET_BIT(Node->First, Character);
+            }
+        }
+
+        Expression = ClassEnd;
+
+    } else if (*Expression == '.') {
+        Expression += 1;
+        for (Character = 1; Character < 256; Character += 1) {
+            YY_LEX_SET_BIT(Node->First, Character);
+        }
+
+    } else {
+        if (*Expression == '\\') {
+            Expression += 1;
+            if (*Expression == '\0') {
+                Compiler->Unsupported = TRUE;
+                return YY_LEX_INVALID_NODE;
+            }
+        }
+
+        YY_LEX_SET_BIT(Node->First, (UCHAR)*Expression);
+        Expression += 1;
+    }
+
+    *ExpressionPointer = Expression;
+    return NodeIndex;
+}
+
+ULONG
+YypLexCreateNode (
+    PYY_LEX_COMPILER Compiler,
+    YY_LEX_NODE_TYPE Type,
+    ULONG Left,
+    ULONG Right
+    )
+
+/*++
+
+Routine Description:
+
+    This routine creates a new tree node, computing whether it can match
+    nothing and what characters it can start with.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    Type - Supplies the node type.
+
+    Left - Supplies the left or only child, or the position for a leaf.
+
+    Right - Supplies the right child.
+
+Return Value:
+
+    Returns the index of the new node on success.
+
+    YY_LEX_INVALID_NODE on allocation failure.
+
+--*/
+
+{
+
+    ULONG Capacity;
+    PYY_LEX_NODE LeftNode;
+    PVOID NewBuffer;
+    PYY_LEX_NODE Node;
+    ULONG NodeIndex;
+    PYY_LEX_NODE RightNode;
+    ULONG Word;
+
+    if (Compiler->NodeCount == Compiler->NodeCapacity) {
+        Capacity = Compiler->NodeCapacity * 2;
+        if (Capacity == 0) {
+            Capacity = 64;
+        }
+
+        NewBuffer = YypLexReallocate(Compiler,
+                                     Compiler->Nodes,
+                                     Capacity * sizeof(YY_LEX_NODE));
+
+        if (NewBuffer == NULL) {
+            Compiler->Status = STATUS_INSUFFICIENT_RESOURCES;
+            return YY_LEX_INVALID_NODE;
+        }
+
+        Compiler->Nodes = NewBuffer;
+        Compiler->NodeCapacity = Capacity;
+    }
+
+    NodeIndex = Compiler->NodeCount;
+    Compiler->NodeCount += 1;
+    Node = &(Compiler->Nodes[NodeIndex]);
+    memset(Node, 0, sizeof(YY_LEX_NODE));
+    Node->Type = Type;
+    Node->Left = Left;
+    Node->Right = Right;
+    if (Type == YyLexNodeLeaf) {
+        return NodeIndex;
+    }
+
+    LeftNode = &(Compiler->Nodes[Left]);
+    memcpy(Node->First, LeftNode->First, sizeof(Node->First));
+    Node->Flags = LeftNode->Flags & YY_LEX_NODE_NULLABLE;
+    switch (Type) {
+    case YyLexNodeConcatenate:
+        RightNode = &(Compiler->Nodes[Right]);
+        if ((LeftNode->Flags & YY_LEX_NODE_NULLABLE) != 0) {
+            for (Word = 0; Word < YY_LEX_CHARACTER_WORDS; Word += 1) {
+                Node->First[Word] |= RightNode->First[Word];
+            }
+
+            Node->Flags = RightNode->Flags & YY_LEX_NODE_NULLABLE;
+        }
+
+        break;
+
+    case YyLexNodeAlternate:
+        RightNode = &(Compiler->Nodes[Right]);
+        for (Word = 0; Word < YY_LEX_CHARACTER_WORDS; Word += 1) {
+            Node->First[Word] |= RightNode->First[Word];
+        }
+
+        Node->Flags |= RightNode->Flags & YY_LEX_NODE_NULLABLE;
+        break;
+
+    case YyLexNodeStar:
+    case YyLexNodeOptional:
+        Node->Flags |= YY_LEX_NODE_NULLABLE;
+        break;
+
+    case YyLexNodePlus:
+        break;
+
+    default:
+
+        assert(FALSE);
+
+        break;
+    }
+
+    return NodeIndex;
+}
+
+BOOL
+YypLexCheckNode (
+    PYY_LEX_COMPILER Compiler,
+    ULONG NodeIndex,
+    PULONG Follow
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether every choice within the given node can be
+    decided by the next input character, which is what makes the interpreter
+    (which never backtracks) agree with the regular expression.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    NodeIndex - Supplies the index of the node to check.
+
+    Follow - Supplies the set of characters that can come after the node.
+
+Return Value:
+
+    TRUE if the node is deterministic.
+
+    FALSE if the node needs to be left to the interpreter.
+
+--*/
+
+{
+
+    ULONG Inner[YY_LEX_CHARACTER_WORDS];
+    PYY_LEX_NODE Left;
+    PYY_LEX_NODE Node;
+    PYY_LEX_NODE Right;
+    ULONG Word;
+
+    Node = &(Compiler->Nodes[NodeIndex]);
+    if (Node->Type == YyLexNodeLeaf) {
+        return TRUE;
+    }
+
+    Left = &(Compiler->Nodes[Node->Left]);
+    switch (Node->Type) {
+    case YyLexNodeConcatenate:
+        Right = &(Compiler->Nodes[Node->Right]);
+        if (YypLexCheckNode(Compiler, Node->Right, Follow) == FALSE) {
+            return FALSE;
+        }
+
+        for (Word = 0; Word < YY_LEX_CHARACTER_WORDS; Word += 1) {
+            Inner[Word] = Right->First[Word];
+            if ((Right->Flags & YY_LEX_NODE_NULLABLE) != 0) {
+                Inner[Word] |= Follow[Word];
+            }
+        }
+
+        return YypLexCheckNode(Compiler, Node->Left, Inner);
+
+    //
+    // Alternates are tried in order, and the first to match the next
+    // character wins, so they must start differently and not be empty.
+    //
+
+    case YyLexNodeAlternate:
+        Right = &(Compiler->Nodes[Node->Right]);
+        if ((((Left->Flags | Right->Flags) & YY_LEX_NODE_NULLABLE) != 0) ||
+            (YypLexIntersects(Left->First,
+                              Right->First,
+                              YY_LEX_CHARACTER_WORDS) != FALSE)) {
+
+            return FALSE;
+        }
+
+        if (YypLexCheckNode(Compiler, Node->Left, Follow) == FALSE) {
+            return FALSE;
+        }
+
+        return YypLexCheckNode(Compiler, Node->Right, Follow);
+
+    //
+    // Repeats are greedy, so whatever comes next must not look like another
+    // iteration. Non-greedy repeats were already vetted during parsing.
+    //
+
+    case YyLexNodeStar:
+    case YyLexNodePlus:
+    case YyLexNodeOptional:
+        if ((Left->Flags & YY_LEX_NODE_NULLABLE) != 0) {
+            return FALSE;
+        }
+
+        if (((Node->Flags & YY_LEX_NODE_NON_GREEDY) == 0) &&
+            (YypLexIntersects(Left->First,
+                              Follow,
+                              YY_LEX_CHARACTER_WORDS) != FALSE)) {
+
+            return FALSE;
+        }
+
+        for (Word = 0; Word < YY_LEX_CHARACTER_WORDS; Word += 1) {
+            Inner[Word] = Follow[Word];
+            if (Node->Type != YyLexNodeOptional) {
+                Inner[Word] |= Left->First[Word];
+            }
+        }
+
+        return YypLexCheckNode(Compiler, Node->Left, Inner);
+
+    default:
+        break;
+    }
+
+    assert(FALSE);
+
+    return FALSE;
+}
+
+VOID
+YypLexComputePositions (
+    PYY_LEX_COMPILER Compiler,
+    ULONG NodeIndex,
+    ULONG Base
+    )
+
+/*++
+
+Routine Description:
+
+    This routine computes the first and last positions of a node and its
+    children, and adds to the follow sets of the positions within it.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    NodeIndex - Supplies the index of the node.
+
+    Base - Supplies the global position number of the first leaf in the
+        expression.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PULONG First;
+    PULONG Follow;
+    PULONG Last;
+    ULONG Leaf;
+    PULONG LeftFirst;
+    PULONG LeftLast;
+    ULONG LeftNullable;
+    PYY_LEX_NODE Node;
+    PULONG RightFirst;
+    PULONG RightLast;
+    ULONG RightNullable;
+    ULONG Target;
+    PULONG Targets;
+    ULONG Word;
+    ULONG Words;
+
+    Words = YY_LEX_BITMAP_WORDS(Compiler->LeafCount);
+    Node = &(Compiler->Nodes[NodeIndex]);
+    First = &(Compiler->FirstPositions[NodeIndex * Words]);
+    Last = &(Compiler->LastPositions[NodeIndex * Words]);
+    if (Node->Type == YyLexNodeLeaf) {
+        YY_LEX_SET_BIT(First, Node->Left);
+        YY_LEX_SET_BIT(Last, Node->Left);
+        return;
+    }
+
+    YypLexComputePositions(Compiler, Node->Left, Base);
+    LeftFirst = &(Compiler->FirstPositions[Node->Left * Words]);
+    LeftLast = &(Compiler->LastPositions[Node->Left * Words]);
+    LeftNullable = Compiler->Nodes[Node->Left].Flags & YY_LEX_NODE_NULLABLE;
+    RightFirst = NULL;
+    RightLast = NULL;
+    RightNullable = 0;
+    if ((Node->Type == YyLexNodeConcatenate) ||
+        (Node->Type == YyLexNodeAlternate)) {
+
+        YypLexComputePositions(Compiler, Node->Right, Base);
+        RightFirst = &(Compiler->FirstPositions[Node->Right * Words]);
+        RightLast = &(Compiler->LastPositions[Node->Right * Words]);
+        RightNullable = Compiler->Nodes[Node->Right].Flags &
+                        YY_LEX_NODE_NULLABLE;
+    }
+
+    for (Word = 0; Word < Words; Word += 1) {
+        First[Word] = LeftFirst[Word];
+        Last[Word] = LeftLast[Word];
+        if (Node->Type == YyLexNodeAlternate) {
+            First[Word] |= RightFirst[Word];
+            Last[Word] |= RightLast[Word];
+
+        } else if (Node->Type == YyLexNodeConcatenate) {
+            if (LeftNullable != 0) {
+                First[Word] |= RightFirst[Word];
+            }
+
+            Last[Word] = RightLast[Word];
+            if (RightNullable != 0) {
+                Last[Word] |= LeftLast[Word];
+            }
+        }
+    }
+
+    //
+    // Concatenation links the end of the left side to the start of the right.
+    // Repeats link their end back to their start.
+    //
+
+    Targets = NULL;
+    if (Node->Type == YyLexNodeConcatenate) {
+        Targets = RightFirst;
+
+    } else if ((Node->Type == YyLexNodeStar) ||
+               (Node->Type == YyLexNodePlus)) {
+
+        Targets = LeftFirst;
+    }
+
+    if (Targets == NULL) {
+        return;
+    }
+
+    for (Leaf = 0; Leaf < Compiler->LeafCount; Leaf += 1) {
+        if (!YY_LEX_TEST_BIT(LeftLast, Leaf)) {
+            continue;
+        }
+
+        Follow = &(Compiler->Follow[(Base + Leaf) * Compiler->PositionWords]);
+        for (Target = 0; Target < Compiler->LeafCount; Target += 1) {
+            if (YY_LEX_TEST_BIT(Targets, Target)) {
+                YY_LEX_SET_BIT(Follow, Base + Target);
+            }
+        }
+    }
+
+    return;
+}
+
+VOID
+YypLexFreeBuild (
+    PYY_LEX_COMPILER Compiler,
+    PYY_LEX_BUILD Build
+    )
+
+/*++
+
+Routine Description:
+
+    This routine frees the memory associated with a state machine build.
+
+Arguments:
+
+    Compiler - Supplies a pointer to the compiler.
+
+    Build - Supplies a pointer to the build state.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    if (Build->Expressions != NULL) {
+        YypLexReallocate(Compiler, Build->Expressions, 0);
+    }
+
+    if (Build->Sets != NULL) {
+        YypLexReallocate(Compiler, Build->Sets, 0);
+    }
+
+    if (Build->Transitions != NULL) {
+        YypLexReallocate(Compiler, Build->Transitions, 0);
+    }
+
+    if (Build->Accept != NULL) {
+        YypLexReallocate(Compiler, Build->Accept, 0);
+    }
+
+    if (Build->EndAccept != NULL) {
+        YypLexReallocate(Compiler, Build->EndAccept, 0);
+    }
+
+    if (Build->Buckets != NULL) {
+        YypLexReallocate(Compiler, Build->Buckets, 0);
+    }
+
+    if (Build->Next != NULL) {
+        YypLexReallocate(Compiler, Build->Next, 0);
+    }
+
+    return;
+}
+
+BOOL
+YypLexIntersects (
+    PULONG Left,
+    PULONG Right,
+    ULONG Words
+    )
+
+/*++
+
+Routine Description:
+
+    This routine determines whether two bitmaps have any bits in common.
+
+Arguments:
+
+    Left - Supplies the first bitmap.
+
+    Right - Supplies the second bitmap.
+
+    Words - Supplies the number of words in each bitmap.
+
+Return Value:
+
+    TRUE if the bitmaps intersect.
+
+    FALSE if they have nothing in common.
+
+--*/
+
+{
+
+    ULONG Word;
+
+    for (Word = 0; Word < Words; Word += 1) {
+        if ((Left[Word] & Right[Word]) != 0) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+ULONG
+YypLexHash (
+    PULONG Words,
+    ULONG Count
+    )
+
+/*++
+
+Routine Description:
+
+    This routine hashes an array of words.
+
+Arguments:
+
+    Words - Supplies the array to hash.
+
+    Count - Supplies the number of words.
+
+Return Value:
+
+    Returns the hash value.
+
+--*/
+
+{
+
+    ULONG Hash;
+    ULONG Index;
+
+    Hash = 2166136261UL;
+    for (Index = 0; Index < Count; Index += 1) {
+        Hash = (Hash ^ Words[Index]) * 16777619UL;
+    }
+
+    return Hash;
+}
+
@@ -36,10 +36,90 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the reserved states of a compiled lexer state machine. The dead state
+// means no expression can match any further. The fallback state means the
+// token contains something the state machine doesn't handle (a null
+// character), and the whole token should be matched by the interpreter.
+//
+
+#define YY_LEX_STATE_DEAD 0
+#define YY_LEX_STATE_FALLBACK 1
+#define YY_LEX_STATE_START 2
+
+//
+// Define the maximum number of states in a compiled lexer state machine.
+//
+
+#define YY_LEX_MAX_STATES 0xFFFF
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure stores the compiled state machine for one set of lexer
+    expressions.
+
+Members:
+
+    StateCount - Stores the number of states in the machine.
+
+    Transitions - Stores the next state for each state and character class,
+        indexed by the state times the class count plus the class.
+
+    Accept - Stores one plus the index of the expression accepted upon
+        entering each state, or zero if the state is not accepting.
+
+    EndAccept - Stores one plus the index of the expression that matches if
+        the input ends in each state. Like the interpreter, this accepts
+        expressions that are only partially matched when the input runs out.
+
+    Fallback - Stores an array of indices of expressions that could not be
+        compiled, which are still matched by the interpreter.
+
+    FallbackCount - Stores the number of elements in the fallback array.
+
+--*/
+
+typedef struct _YY_LEX_DFA {
+    ULONG StateCount;
+    PUSHORT Transitions;
+    PUSHORT Accept;
+    PUSHORT EndAccept;
+    PULONG Fallback;
+    ULONG FallbackCount;
+} YY_LEX_DFA, *PYY_LEX_DFA;
+
+/*++
+
+Structure Description:
+
+    This structure stores a compiled lexer table. It is allocated as a single
+    block of memory.
+
+Members:
+
+    ClassCount - Stores the number of input character classes.
+
+    Classes - Stores the character class of each input byte.
+
+    Expressions - Stores the state machine for the token expressions.
+
+    IgnoreExpressions - Stores the state machine for the ignore expressions.
+
+--*/
+
+struct _YY_LEX_TABLE {
+    ULONG ClassCount;
+    UCHAR Classes[256];
+    YY_LEX_DFA Expressions;
+    YY_LEX_DFA IgnoreExpressions;
+};
+
 //
 // -------------------------------------------------------------------- Globals
 //
@@ -47,3 +127,31 @@ Module Name:
 //
 // -------------------------------------------------------- Function Prototypes
 //
+
+BOOL
+YypMatchCharacterClass (
+    PSTR *ExpressionPointer,
+    CHAR Input
+    );
+
+/*++
+
+Routine Description:
+
+    This routine determines whether or not the given input character is in the
+    character class (like [a-z]) at the given expression.
+
+Arguments:
+
+    ExpressionPointer - Supplies a pointer to a pointer to the opening square
+        bracket of the class. This will be advanced past the class.
+
+    Input - Supplies the input character to test.
+
+Return Value:
+
+    TRUE if the character is in the class.
+
+    FALSE if the character is not in the class.
+
+--*/
@@ -50,6 +50,12 @@ Module Name:
 
 #define YY_TOKEN_BASE 512
 
+//
+// Define the number of times the benchmark lexes each file.
+//
+
+#define YY_TEST_BENCHMARK_ITERATIONS 50
+
 #define YY_DIGITS "[0-9]"
 #define YY_OCTAL_DIGITS "[0-7]"
 #define YY_NAME0 "[a-zA-Z_]"
@@ -308,6 +314,27 @@ YyTestLex (
     PLEXER Lexer
     );
 
+ULONG
+YyTestCompareLexers (
+    PSTR Path,
+    PLEXER Lexer,
+    PYY_LEX_TABLE Table
+    );
+
+VOID
+YyTestBenchmarkLexer (
+    PSTR Path,
+    PLEXER Lexer,
+    PYY_LEX_TABLE Table
+    );
+
+PVOID
+YyTestReallocate (
+    PVOID Context,
+    PVOID Allocation,
+    UINTN Size
+    );
+
 INT
 YyTestReadFile (
     PSTR Path,
@@ -1208,6 +1235,7 @@ PARSER_GRAMMAR_ELEMENT YyTestCGrammar[] = {
 LIST_ENTRY YyTestTypeList;
 
 BOOL YyTestVerbose = FALSE;
+BOOL YyTestBenchmark = FALSE;
 
 //
 // ------------------------------------------------------------------ Functions
@@ -1247,17 +1275,30 @@ Return Value:
     ULONG TestsFailed;
 
     INITIALIZE_LIST_HEAD(&YyTestTypeList);
-    if (ArgumentCount < 2) {
-        fprintf(stderr, "Error: Specify path of files to parse.\n");
+    ArgumentIndex = 1;
+    if ((ArgumentCount > 1) &&
+        ((strcmp(Arguments[1], "-b") == 0) ||
+         (strcmp(Arguments[1], "--benchmark") == 0))) {
+
+        YyTestBenchmark = TRUE;
+        ArgumentIndex += 1;
+    }
+
+    if (ArgumentIndex >= ArgumentCount) {
+        fprintf(stderr,
+                "Error: Specify path of files to parse. Use -b to "
+                "benchmark the lexer.\n");
+
         return 1;
     }
 
     srand(time(NULL));
     TestsFailed = 0;
-    for (ArgumentIndex = 1; ArgumentIndex < ArgumentCount; ArgumentIndex += 1) {
+    while (ArgumentIndex < ArgumentCount) {
         Argument = Arguments[ArgumentIndex];
         TestsFailed += YyTestParse(Argument);
         YyTestClearTypes();
+        ArgumentIndex += 1;
     }
 
     if (TestsFailed != 0) {
@@ -1302,10 +1343,12 @@ Return Value:
     PARSER Parser;
     ULONG Size;
     INT Status;
+    PYY_LEX_TABLE Table;
     PPARSER_NODE TranslationUnit;
 
     Failures = 0;
     Input = NULL;
+    Table = NULL;
     TranslationUnit = NULL;
     memset(&Lexer, 0, sizeof(LEXER));
     memset(&Parser, 0, sizeof(PARSER));
@@ -1328,6 +1371,25 @@ Return Value:
     }
 
     Failures += YyTestLex(Path, &Lexer);
+
+    //
+    // Compile the lexer, make sure it comes up with exactly the same tokens,
+    // and then use it for the parse.
+    //
+
+    KStatus = YyLexCompile(&Lexer, YyTestReallocate, NULL, &Table);
+    if (!KSUCCESS(KStatus)) {
+        fprintf(stderr, "Failed to compile lexer: %d\n", KStatus);
+        Failures += 1;
+        goto TestParseEnd;
+    }
+
+    Failures += YyTestCompareLexers(Path, &Lexer, Table);
+    if (YyTestBenchmark != FALSE) {
+        YyTestBenchmarkLexer(Path, &Lexer, Table);
+    }
+
+    Lexer.Table = Table;
     Status = YyLexInitialize(&Lexer);
     if (!KSUCCESS(Status)) {
         Failures += 1;
@@ -1377,6 +1439,10 @@ Return Value:
     }
 
     YyParserDestroy(&Parser);
+    if (Table != NULL) {
+        YyLexDestroyTable(Table, YyTestReallocate, NULL);
+    }
+
     if (Input != NULL) {
         free(Input);
     }
@@ -1837,6 +1903,202 @@ Return Value:
     return Failures;
 }
 
+ULONG
+YyTestCompareLexers (
+    PSTR Path,
+    PLEXER Lexer,
+    PYY_LEX_TABLE Table
+    )
+
+/*++
+
+Routine Description:
+
+    This routine lexes the input with and without the compiled lexer table,
+    and makes sure the tokens are identical.
+
+Arguments:
+
+    Path - Supplies a pointer to the file path.
+
+    Lexer - Supplies a pointer to the initialized lexer.
+
+    Table - Supplies a pointer to the compiled lexer table.
+
+Return Value:
+
+    Returns the number of test failures.
+
+--*/
+
+{
+
+    LEXER Compiled;
+    LEXER_TOKEN CompiledToken;
+    KSTATUS CompiledStatus;
+    LEXER Interpreted;
+    LEXER_TOKEN InterpretedToken;
+    KSTATUS InterpretedStatus;
+
+    memcpy(&Interpreted, Lexer, sizeof(LEXER));
+    memcpy(&Compiled, Lexer, sizeof(LEXER));
+    Interpreted.Table = NULL;
+    Compiled.Table = Table;
+    YyLexInitialize(&Interpreted);
+    YyLexInitialize(&Compiled);
+    while (TRUE) {
+        InterpretedStatus = YyLexGetToken(&Interpreted, &InterpretedToken);
+        CompiledStatus = YyLexGetToken(&Compiled, &CompiledToken);
+        if ((InterpretedStatus != CompiledStatus) ||
+            ((KSUCCESS(InterpretedStatus)) &&
+             ((InterpretedToken.Value != CompiledToken.Value) ||
+              (InterpretedToken.Position != CompiledToken.Position) ||
+              (InterpretedToken.Size != CompiledToken.Size)))) {
+
+            fprintf(stderr,
+                    "Compiled lexer mismatch at %s:%d:%d: Status %d/%d, "
+                    "Token %d/%d, Size %d/%d\n",
+                    Path,
+                    Interpreted.Line,
+                    Interpreted.Column,
+                    InterpretedStatus,
+                    CompiledStatus,
+                    InterpretedToken.Value,
+                    CompiledToken.Value,
+                    InterpretedToken.Size,
+                    CompiledToken.Size);
+
+            return 1;
+        }
+
+        if (!KSUCCESS(InterpretedStatus)) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+VOID
+YyTestBenchmarkLexer (
+    PSTR Path,
+    PLEXER Lexer,
+    PYY_LEX_TABLE Table
+    )
+
+/*++
+
+Routine Description:
+
+    This routine times lexing the input with and without the compiled lexer
+    table.
+
+Arguments:
+
+    Path - Supplies a pointer to the file path.
+
+    Lexer - Supplies a pointer to the initialized lexer.
+
+    Table - Supplies a pointer to the compiled lexer table.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    clock_t End;
+    ULONG Iteration;
+    LEXER Local;
+    ULONG Pass;
+    double Rate[2];
+    double Seconds;
+    clock_t Start;
+    KSTATUS Status;
+    LEXER_TOKEN Token;
+
+    for (Pass = 0; Pass < 2; Pass += 1) {
+        memcpy(&Local, Lexer, sizeof(LEXER));
+        Local.Table = NULL;
+        if (Pass != 0) {
+            Local.Table = Table;
+        }
+
+        Start = clock();
+        for (Iteration = 0;
+             Iteration < YY_TEST_BENCHMARK_ITERATIONS;
+             Iteration += 1) {
+
+            YyLexInitialize(&Local);
+            do {
+                Status = YyLexGetToken(&Local, &Token);
+
+            } while (KSUCCESS(Status));
+        }
+
+        End = clock();
+        Seconds = (double)(End - Start) / CLOCKS_PER_SEC;
+        if (Seconds <= 0) {
+            Seconds = 1.0 / CLOCKS_PER_SEC;
+        }
+
+        Rate[Pass] = (double)Local.TokenCount *
+                     YY_TEST_BENCHMARK_ITERATIONS / Seconds;
+    }
+
+    printf("%s: %d tokens, interpreted %.0f tokens/s, compiled %.0f "
+           "tokens/s (%.1fx)\n",
+           Path,
+           Local.TokenCount,
+           Rate[0],
+           Rate[1],
+           Rate[1] / Rate[0]);
+
+    return;
+}
+
+PVOID
+YyTestReallocate (
+    PVOID Context,
+    PVOID Allocation,
+    UINTN Size
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates, reallocates, or frees memory for the lexer.
+
+Arguments:
+
+    Context - Supplies an unused context pointer.
+
+    Allocation - Supplies an optional pointer to an existing allocation to
+        resize or free.
+
+    Size - Supplies the new size of the allocation, or 0 to free it.
+
+Return Value:
+
+    Returns a pointer to the allocated memory on success.
+
+    NULL on allocation failure or free.
+
+--*/
+
+{
+
+    if (Size == 0) {
+        free(Allocation);
+        return NULL;
+    }
+
+    return realloc(Allocation, Size);
+}
+
 INT
 YyTestReadFile (
     PSTR Path,
@@ -641,6 +641,12 @@ Return Value:
         "CPFLAGS": "-p",
     };
 
+    //
+    // Build files branch on the Minoca configuration, so mingen must not reuse
+    // cached build file results if any of it changes.
+    //
+
+    config.cache_key = mconfig;
     if (config.verbose) {
         Core.print("Minoca Build Configuration:");
         for (key in mconfig) {
@@ -226,6 +226,7 @@ Return Value:
             return EFI_UNSUPPORTED;
         }
 
+        EfiCoreRecordBootPhase(EfiBootPhaseOsLoaderLoadImage);
         Status = EfiLoadImage(TRUE,
                               EfiFirmwareImageHandle,
                               DevicePath,
@@ -289,6 +290,7 @@ Return Value:
     //
 
     EfiSetWatchdogTimer(EFI_DEFAULT_WATCHDOG_DURATION, 0, 0, NULL);
+    EfiCoreRecordBootPhase(EfiBootPhaseOsLoaderStartImage);
     Status = EfiStartImage(ImageHandle, ExitDataSize, ExitData);
     RtlDebugPrint("EFI Image Returned: 0x%x\r\n", Status);
 
@@ -0,0 +1,393 @@
+/*++
+
+Copyright (c) 2026 Minoca Corp.
+
+    This file is licensed under the terms of the GNU General Public License
+    version 3. Alternative licensing terms are available. Contact
+    info@minocacorp.com for details. See the LICENSE file at the root of this
+    project for complete licensing information.
+
+Module Name:
+
+    bootperf.c
+
+Abstract:
+
+    This module implements the firmware boot performance table. Timestamps
+    for the fixed boot phases and for the start and end of every image are
+    recorded into a table in reserved memory, which is published to the
+    operating system through a Firmware Performance Data Table (FPDT).
+
+Author:
+
+    Minoca Corp. 18-Oct-2026
+
+Environment:
+
+    Firmware
+
+--*/
+
+//
+// ------------------------------------------------------------------- Includes
+//
+
+#include "ueficore.h"
+#include <minoca/fw/acpitabs.h>
+
+//
+// ---------------------------------------------------------------- Definitions
+//
+
+//
+// Define the number of GUID event records the boot performance table has
+// room for. Records beyond this are dropped.
+//
+
+#define EFI_BOOT_PERFORMANCE_RECORD_COUNT 256
+
+#define EFI_BOOT_PERFORMANCE_TABLE_SIZE             \
+    (sizeof(EFI_BOOT_PERFORMANCE_TABLE) +           \
+     (EFI_BOOT_PERFORMANCE_RECORD_COUNT * sizeof(FPDT_GUID_EVENT_RECORD)))
+
+#define EFI_BOOT_PERFORMANCE_OEM_ID "Minoca"
+
+#define NANOSECONDS_PER_SECOND 1000000000ULL
+
+//
+// ------------------------------------------------------ Data Type Definitions
+//
+
+/*++
+
+Structure Description:
+
+    This structure defines the fixed portion of the boot performance table.
+    GUID event records follow it directly in memory.
+
+Members:
+
+    Header - Stores the boot performance table header.
+
+    BasicBoot - Stores the basic boot performance record.
+
+--*/
+
+typedef struct _EFI_BOOT_PERFORMANCE_TABLE {
+    FBPT Header;
+    FPDT_BASIC_BOOT_RECORD BasicBoot;
+} PACKED EFI_BOOT_PERFORMANCE_TABLE, *PEFI_BOOT_PERFORMANCE_TABLE;
+
+//
+// ----------------------------------------------- Internal Function Prototypes
+//
+
+UINT64
+EfipCoreGetBootPerformanceTimestamp (
+    VOID
+    );
+
+//
+// -------------------------------------------------------------------- Globals
+//
+
+//
+// Store a pointer to the boot performance table, which is NULL if it could
+// not be allocated.
+//
+
+PEFI_BOOT_PERFORMANCE_TABLE EfiBootPerformanceTable;
+
+//
+// Store the number of GUID event records in the table.
+//
+
+UINTN EfiBootPerformanceRecordCount;
+
+//
+// ------------------------------------------------------------------ Functions
+//
+
+VOID
+EfiCoreInitializeBootPerformance (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates the firmware boot performance table and records
+    the time the firmware began executing. If the table cannot be allocated,
+    boot performance records are silently dropped.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    EFI_PHYSICAL_ADDRESS Address;
+    UINTN Pages;
+    EFI_STATUS Status;
+    PEFI_BOOT_PERFORMANCE_TABLE Table;
+
+    //
+    // The table is handed to the operating system, so it goes in memory that
+    // is not reclaimed when boot services exit.
+    //
+
+    Pages = EFI_SIZE_TO_PAGES(EFI_BOOT_PERFORMANCE_TABLE_SIZE);
+    Status = EfiCoreAllocatePages(AllocateAnyPages,
+                                  EfiReservedMemoryType,
+                                  Pages,
+                                  &Address);
+
+    if (EFI_ERROR(Status)) {
+        return;
+    }
+
+    Table = (PEFI_BOOT_PERFORMANCE_TABLE)(UINTN)Address;
+    EfiCoreSetMemory(Table, EFI_BOOT_PERFORMANCE_TABLE_SIZE, 0);
+    Table->Header.Signature = FBPT_SIGNATURE;
+    Table->Header.Length = sizeof(EFI_BOOT_PERFORMANCE_TABLE);
+    Table->BasicBoot.Header.Type = FPDT_RECORD_BASIC_BOOT_PERFORMANCE;
+    Table->BasicBoot.Header.Length = sizeof(FPDT_BASIC_BOOT_RECORD);
+    Table->BasicBoot.Header.Revision =
+                                   FPDT_RECORD_BASIC_BOOT_PERFORMANCE_REVISION;
+
+    EfiBootPerformanceRecordCount = 0;
+    EfiBootPerformanceTable = Table;
+    EfiCoreRecordBootPhase(EfiBootPhaseResetEnd);
+    return;
+}
+
+VOID
+EfiCoreRecordBootPhase (
+    EFI_BOOT_PHASE Phase
+    )
+
+/*++
+
+Routine Description:
+
+    This routine records the current time against one of the fixed boot
+    phases in the basic boot performance record.
+
+Arguments:
+
+    Phase - Supplies the phase that was just reached.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PFPDT_BASIC_BOOT_RECORD Record;
+    UINT64 Timestamp;
+
+    if (EfiBootPerformanceTable == NULL) {
+        return;
+    }
+
+    Record = &(EfiBootPerformanceTable->BasicBoot);
+    Timestamp = EfipCoreGetBootPerformanceTimestamp();
+    switch (Phase) {
+    case EfiBootPhaseResetEnd:
+        Record->ResetEnd = Timestamp;
+        break;
+
+    case EfiBootPhaseOsLoaderLoadImage:
+        Record->OsLoaderLoadImageStart = Timestamp;
+        break;
+
+    case EfiBootPhaseOsLoaderStartImage:
+        Record->OsLoaderStartImageStart = Timestamp;
+        break;
+
+    case EfiBootPhaseExitBootServicesEntry:
+        Record->ExitBootServicesEntry = Timestamp;
+        break;
+
+    case EfiBootPhaseExitBootServicesExit:
+        Record->ExitBootServicesExit = Timestamp;
+        break;
+
+    default:
+
+        ASSERT(FALSE);
+
+        break;
+    }
+
+    return;
+}
+
+VOID
+EfiCoreRecordBootEvent (
+    UINT16 ProgressId,
+    CONST EFI_GUID *Guid
+    )
+
+/*++
+
+Routine Description:
+
+    This routine appends a GUID event record stamped with the current time to
+    the boot performance table.
+
+Arguments:
+
+    ProgressId - Supplies the kind of event. See FPDT_PROGRESS_* definitions.
+
+    Guid - Supplies an optional pointer to the GUID of the module or phase
+        the event belongs to. Supply NULL to record a zero GUID.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PFPDT_GUID_EVENT_RECORD Record;
+
+    if ((EfiBootPerformanceTable == NULL) ||
+        (EfiBootPerformanceRecordCount >= EFI_BOOT_PERFORMANCE_RECORD_COUNT)) {
+
+        return;
+    }
+
+    Record = (PFPDT_GUID_EVENT_RECORD)(EfiBootPerformanceTable + 1);
+    Record += EfiBootPerformanceRecordCount;
+    Record->Header.Type = FPDT_RECORD_GUID_EVENT;
+    Record->Header.Length = sizeof(FPDT_GUID_EVENT_RECORD);
+    Record->Header.Revision = FPDT_RECORD_REVISION;
+    Record->ProgressId = ProgressId;
+    Record->ApicId = 0;
+    Record->Timestamp = EfipCoreGetBootPerformanceTimestamp();
+    if (Guid != NULL) {
+        EfiCoreCopyMemory(Record->Guid, (VOID *)Guid, sizeof(Record->Guid));
+
+    } else {
+        EfiCoreSetMemory(Record->Guid, sizeof(Record->Guid), 0);
+    }
+
+    EfiBootPerformanceRecordCount += 1;
+    EfiBootPerformanceTable->Header.Length += sizeof(FPDT_GUID_EVENT_RECORD);
+    return;
+}
+
+EFI_STATUS
+EfiCorePublishBootPerformanceTable (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine installs a Firmware Performance Data Table pointing at the
+    boot performance table, so the operating system can find it.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    EFI status code.
+
+--*/
+
+{
+
+    FPDT Table;
+    UINTN TableKey;
+
+    if (EfiBootPerformanceTable == NULL) {
+        return EFI_NOT_READY;
+    }
+
+    EfiCoreSetMemory(&Table, sizeof(FPDT), 0);
+    Table.Header.Signature = FPDT_SIGNATURE;
+    Table.Header.Length = sizeof(FPDT);
+    Table.Header.Revision = 1;
+    EfiCoreCopyMemory(&(Table.Header.OemId),
+                      (VOID *)EFI_BOOT_PERFORMANCE_OEM_ID,
+                      sizeof(Table.Header.OemId));
+
+    Table.BootPointer.Type = FPDT_RECORD_BASIC_BOOT_POINTER;
+    Table.BootPointer.Length = sizeof(FPDT) - sizeof(DESCRIPTION_HEADER);
+    Table.BootPointer.Revision = FPDT_RECORD_REVISION;
+    Table.BootTableAddress = (UINTN)EfiBootPerformanceTable;
+    EfiAcpiChecksumTable(&Table,
+                         sizeof(FPDT),
+                         OFFSET_OF(DESCRIPTION_HEADER, Checksum));
+
+    TableKey = 0;
+    return EfiAcpiInstallTable(&Table, sizeof(FPDT), &TableKey);
+}
+
+//
+// --------------------------------------------------------- Internal Functions
+//
+
+UINT64
+EfipCoreGetBootPerformanceTimestamp (
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    This routine returns the current time counter value converted to
+    nanoseconds.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    Returns the current time in nanoseconds.
+
+    0 if the time counter is not implemented.
+
+--*/
+
+{
+
+    UINT64 Counter;
+    UINT64 Frequency;
+    UINT64 Nanoseconds;
+
+    Frequency = EfiCoreGetTimeCounterFrequency();
+    if (Frequency == 0) {
+        return 0;
+    }
+
+    //
+    // Split the conversion into whole seconds and the remainder so that the
+    // multiplication can't overflow for any realistic counter value.
+    //
+
+    Counter = EfiCoreReadTimeCounter();
+    Nanoseconds = (Counter / Frequency) * NANOSECONDS_PER_SECOND;
+    Nanoseconds += ((Counter % Frequency) * NANOSECONDS_PER_SECOND) /
+                   Frequency;
+
+    return Nanoseconds;
+}
+
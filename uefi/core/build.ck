@@ -52,6 +52,7 @@ function build() {
         "bdscon.c",
         "bdsentry.c",
         "bdsutil.c",
+        "bootperf.c",
         "cfgtable.c",
         "crc32.c",
         "dbgser.c",
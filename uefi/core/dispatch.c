@@ -31,6 +31,7 @@ Module Name:
 
 #include "ueficore.h"
 #include "fwvolp.h"
+#include <minoca/fw/acpitabs.h>
 
 //
 // ---------------------------------------------------------------- Definitions
@@ -225,6 +226,7 @@ Return Value:
     }
 
     EfiDispatcherRunning = TRUE;
+    EfiCoreRecordBootEvent(FPDT_PROGRESS_DISPATCHER_START, NULL);
     ReturnStatus = EFI_NOT_FOUND;
     do {
 
@@ -322,6 +324,7 @@ Return Value:
 
     } while (ReadyToRun != FALSE);
 
+    EfiCoreRecordBootEvent(FPDT_PROGRESS_DISPATCHER_END, NULL);
     EfiDispatcherRunning = FALSE;
     return ReturnStatus;
 }
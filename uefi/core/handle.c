@@ -31,6 +31,19 @@ Module Name:
 
 #include "ueficore.h"
 
+//
+// --------------------------------------------------------------------- Macros
+//
+
+//
+// This macro returns the GUID index bucket for the given protocol GUID. The
+// first word of a GUID is the most random part, so that carries most of it.
+//
+
+#define EFI_PROTOCOL_HASH(_Guid)                                    \
+    (((_Guid)->Data1 ^ (_Guid)->Data2 ^ (_Guid)->Data4[7]) %        \
+     EFI_PROTOCOL_HASH_BUCKET_COUNT)
+
 //
 // ---------------------------------------------------------------- Definitions
 //
@@ -88,6 +101,21 @@ LIST_ENTRY EfiHandleList;
 LIST_ENTRY EfiProtocolDatabase;
 UINTN EfiHandleDatabaseKey;
 
+//
+// Store the protocol database GUID index. Every protocol entry is on both the
+// global list and one of these buckets.
+//
+
+LIST_ENTRY EfiProtocolHashTable[EFI_PROTOCOL_HASH_BUCKET_COUNT];
+
+//
+// Store a counter that changes whenever any protocol interface is installed
+// or removed, so that lookups derived from the database know when to go
+// stale. Zero is never a valid generation.
+//
+
+UINTN EfiProtocolDatabaseGeneration;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -1036,6 +1064,7 @@ Return Value:
     INSERT_BEFORE(&(ProtocolInterface->ProtocolListEntry),
                   &(ProtocolEntry->ProtocolList));
 
+    EfiProtocolDatabaseGeneration += 1;
     EfiHandleDatabaseKey += 1;
     HandleData->Key = EfiHandleDatabaseKey;
 
@@ -1347,10 +1376,17 @@ Return Value:
 
 {
 
+    UINTN Index;
+
     EfiCoreInitializeLock(&EfiProtocolDatabaseLock, TPL_NOTIFY);
     INITIALIZE_LIST_HEAD(&EfiProtocolDatabase);
     INITIALIZE_LIST_HEAD(&EfiHandleList);
+    for (Index = 0; Index < EFI_PROTOCOL_HASH_BUCKET_COUNT; Index += 1) {
+        INITIALIZE_LIST_HEAD(&(EfiProtocolHashTable[Index]));
+    }
+
     EfiHandleDatabaseKey = 0;
+    EfiProtocolDatabaseGeneration = 1;
     return;
 }
 
@@ -1490,6 +1526,8 @@ Return Value:
     INSERT_BEFORE(&(ProtocolInterface->ProtocolListEntry),
                   &(ProtocolEntry->ProtocolList));
 
+    EfiProtocolDatabaseGeneration += 1;
+
     //
     // Notify anybody listening for this protocol.
     //
@@ -1578,6 +1616,7 @@ Return Value:
 
 {
 
+    PLIST_ENTRY Bucket;
     PLIST_ENTRY CurrentEntry;
     PEFI_PROTOCOL_ENTRY Item;
     PEFI_PROTOCOL_ENTRY ProtocolEntry;
@@ -1585,13 +1624,14 @@ Return Value:
     ASSERT(EfiCoreIsLockHeld(&EfiProtocolDatabaseLock) != FALSE);
 
     //
-    // Search the database for the matching GUID.
+    // Search the GUID index bucket for the matching GUID.
     //
 
     ProtocolEntry = NULL;
-    CurrentEntry = EfiProtocolDatabase.Next;
-    while (CurrentEntry != &EfiProtocolDatabase) {
-        Item = LIST_VALUE(CurrentEntry, EFI_PROTOCOL_ENTRY, ListEntry);
+    Bucket = &(EfiProtocolHashTable[EFI_PROTOCOL_HASH(Protocol)]);
+    CurrentEntry = Bucket->Next;
+    while (CurrentEntry != Bucket) {
+        Item = LIST_VALUE(CurrentEntry, EFI_PROTOCOL_ENTRY, HashListEntry);
         CurrentEntry = CurrentEntry->Next;
 
         ASSERT(Item->Magic == EFI_PROTOCOL_ENTRY_MAGIC);
@@ -1613,6 +1653,7 @@ Return Value:
             INITIALIZE_LIST_HEAD(&(ProtocolEntry->ProtocolList));
             INITIALIZE_LIST_HEAD(&(ProtocolEntry->NotifyList));
             INSERT_BEFORE(&(ProtocolEntry->ListEntry), &EfiProtocolDatabase);
+            INSERT_AFTER(&(ProtocolEntry->HashListEntry), Bucket);
         }
     }
 
@@ -2030,6 +2071,7 @@ Return Value:
         }
 
         LIST_REMOVE(&(ProtocolInterface->ProtocolListEntry));
+        EfiProtocolDatabaseGeneration += 1;
     }
 
     return ProtocolInterface;
@@ -2071,11 +2113,24 @@ Return Value:
     PEFI_PROTOCOL_ENTRY ProtocolEntry;
     EFI_STATUS Status;
 
+    ASSERT(EfiCoreIsLockHeld(&EfiProtocolDatabaseLock) != FALSE);
+
     Status = EfipCoreValidateHandle(EfiHandle);
     if (EFI_ERROR(Status)) {
         return NULL;
     }
 
+    //
+    // Look the GUID up once in the index, after which the handle's interfaces
+    // can be matched by pointer. A protocol that has never been installed
+    // anywhere can't be on this handle either.
+    //
+
+    ProtocolEntry = EfipCoreFindProtocolEntry(Protocol, FALSE);
+    if (ProtocolEntry == NULL) {
+        return NULL;
+    }
+
     Handle = EfiHandle;
     CurrentEntry = Handle->ProtocolList.Next;
     while (CurrentEntry != &(Handle->ProtocolList)) {
@@ -2083,10 +2138,7 @@ Return Value:
 
         ASSERT(Interface->Magic == EFI_PROTOCOL_INTERFACE_MAGIC);
 
-        ProtocolEntry = Interface->Protocol;
-        if (EfiCoreCompareGuids(&(ProtocolEntry->ProtocolId), Protocol) !=
-            FALSE) {
-
+        if (Interface->Protocol == ProtocolEntry) {
             return Interface;
         }
 
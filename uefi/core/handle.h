@@ -39,6 +39,12 @@ Module Name:
 #define EFI_OPEN_PROTOCOL_MAGIC 0x6E65704F // 'nepO'
 #define EFI_PROTOCOL_NOTIFY_MAGIC 0x69746F4E // 'itoN'
 
+//
+// Define the number of buckets in the protocol database GUID index.
+//
+
+#define EFI_PROTOCOL_HASH_BUCKET_COUNT 64
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
@@ -89,6 +95,9 @@ Structure Description:
     ListEntry - Stores pointers to the next and previous protocols in the
         global protocol database.
 
+    HashListEntry - Stores pointers to the next and previous protocols in the
+        same bucket of the protocol database GUID index.
+
     ProtocolList - Stores the head of the list of protocol interfaces for this
         protocol ID.
 
@@ -101,6 +110,7 @@ Structure Description:
 typedef struct _EFI_PROTOCOL_ENTRY {
     UINTN Magic;
     LIST_ENTRY ListEntry;
+    LIST_ENTRY HashListEntry;
     LIST_ENTRY ProtocolList;
     LIST_ENTRY NotifyList;
     EFI_GUID ProtocolId;
@@ -219,6 +229,7 @@ extern EFI_LOCK EfiProtocolDatabaseLock;
 extern LIST_ENTRY EfiHandleList;
 extern LIST_ENTRY EfiProtocolDatabase;
 extern UINTN EfiHandleDatabaseKey;
+extern UINTN EfiProtocolDatabaseGeneration;
 
 //
 // -------------------------------------------------------- Function Prototypes
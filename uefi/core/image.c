@@ -35,6 +35,7 @@ Module Name:
 #include "imagep.h"
 #include "efiimg.h"
 #include "fv2.h"
+#include <minoca/fw/acpitabs.h>
 #include <minoca/uefi/protocol/loadfil.h>
 #include <minoca/uefi/protocol/loadfil2.h>
 #include <minoca/uefi/protocol/sfilesys.h>
@@ -360,9 +361,11 @@ Return Value:
 
 {
 
+    MEDIA_FW_VOL_FILEPATH_DEVICE_PATH *FilePath;
     UINT64 HandleDatabaseKey;
     PEFI_IMAGE_DATA Image;
     PEFI_IMAGE_DATA LastImage;
+    EFI_GUID *ModuleGuid;
     UINTN SetJumpFlag;
     EFI_STATUS Status;
 
@@ -405,6 +408,19 @@ Return Value:
     Image->JumpContext = ALIGN_POINTER(Image->JumpBuffer,
                                        EFI_JUMP_BUFFER_ALIGNMENT);
 
+    //
+    // Images loaded out of a firmware volume are identified in the boot
+    // performance table by their file name GUID.
+    //
+
+    ModuleGuid = NULL;
+    FilePath = (MEDIA_FW_VOL_FILEPATH_DEVICE_PATH *)Image->Information.FilePath;
+    if (FilePath != NULL) {
+        ModuleGuid =
+                  EfiCoreGetNameGuidFromFirmwareVolumeDevicePathNode(FilePath);
+    }
+
+    EfiCoreRecordBootEvent(FPDT_PROGRESS_MODULE_START, ModuleGuid);
     SetJumpFlag = EfipArchSetJump(Image->JumpContext);
 
     //
@@ -431,6 +447,7 @@ Return Value:
 
     ASSERT(Image->Tpl == EfiCurrentTpl);
 
+    EfiCoreRecordBootEvent(FPDT_PROGRESS_MODULE_END, ModuleGuid);
     EfiCoreRestoreTpl(Image->Tpl);
     EfiCoreFreePool(Image->JumpBuffer);
     EfiCurrentImage = LastImage;
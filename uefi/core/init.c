@@ -429,6 +429,8 @@ Return Value:
         goto InitializeEnd;
     }
 
+    EfiCoreInitializeBootPerformance();
+
     //
     // Create the runtime services table.
     //
@@ -569,6 +571,13 @@ Return Value:
         goto InitializeEnd;
     }
 
+    //
+    // Point the OS at the boot performance table. Failure here only costs
+    // the boot timing data, so it is not fatal.
+    //
+
+    EfiCorePublishBootPerformanceTable();
+
     Step += 1;
     EfiStatus = EfiSmbiosDriverEntry(NULL, EfiSystemTable);
     if (EFI_ERROR(EfiStatus)) {
@@ -666,6 +675,7 @@ Return Value:
 
     EFI_STATUS Status;
 
+    EfiCoreRecordBootPhase(EfiBootPhaseExitBootServicesEntry);
     Status = EfiCoreTerminateMemoryServices(MapKey);
     if (EFI_ERROR(Status)) {
         return Status;
@@ -692,6 +702,13 @@ Return Value:
     EfiSetMem(EfiBootServices, sizeof(EFI_BOOT_SERVICES), 0);
     EfiBootServices = NULL;
     EfiRuntimeProtocol->AtRuntime = TRUE;
+
+    //
+    // The time counter is free running, so it can still be read even though
+    // the timer interrupt has been torn down.
+    //
+
+    EfiCoreRecordBootPhase(EfiBootPhaseExitBootServicesExit);
     return Status;
 }
 
@@ -35,10 +35,52 @@ Module Name:
 // ---------------------------------------------------------------- Definitions
 //
 
+//
+// Define the number of recent device path lookups to remember, and the
+// longest source device path that will be remembered.
+//
+
+#define EFI_DEVICE_PATH_CACHE_SIZE 8
+#define EFI_DEVICE_PATH_CACHE_MAX_PATH 128
+
 //
 // ------------------------------------------------------ Data Type Definitions
 //
 
+/*++
+
+Structure Description:
+
+    This structure stores the result of a recent device path lookup.
+
+Members:
+
+    Generation - Stores the protocol database generation the result was
+        computed under. The entry is stale once the generation moves on. Zero
+        indicates an unused entry.
+
+    ProtocolEntry - Stores the protocol that was searched for.
+
+    PathSize - Stores the size of the source device path, not including the
+        end node.
+
+    Device - Stores the handle that best matched.
+
+    MatchSize - Stores the size of the part of the source path that matched.
+
+    Path - Stores a copy of the source device path.
+
+--*/
+
+typedef struct _EFI_DEVICE_PATH_CACHE_ENTRY {
+    UINTN Generation;
+    PEFI_PROTOCOL_ENTRY ProtocolEntry;
+    UINTN PathSize;
+    EFI_HANDLE Device;
+    INTN MatchSize;
+    UINT8 Path[EFI_DEVICE_PATH_CACHE_MAX_PATH];
+} EFI_DEVICE_PATH_CACHE_ENTRY, *PEFI_DEVICE_PATH_CACHE_ENTRY;
+
 typedef struct _EFI_LOCATE_POSITION {
     EFI_GUID *Protocol;
     VOID *SearchKey;
@@ -99,12 +141,36 @@ EfipCoreGetNextHandleByProtocol (
     VOID **Interface
     );
 
+PEFI_DEVICE_PATH_CACHE_ENTRY
+EfipCoreLookupDevicePathCache (
+    PEFI_PROTOCOL_ENTRY ProtocolEntry,
+    EFI_DEVICE_PATH_PROTOCOL *SourcePath,
+    UINTN SourceSize
+    );
+
+VOID
+EfipCoreInsertDevicePathCache (
+    PEFI_PROTOCOL_ENTRY ProtocolEntry,
+    EFI_DEVICE_PATH_PROTOCOL *SourcePath,
+    UINTN SourceSize,
+    EFI_HANDLE Device,
+    INTN MatchSize
+    );
+
 //
 // -------------------------------------------------------------------- Globals
 //
 
 UINTN EfiLocateHandleRequest;
 
+//
+// Store the cache of recent device path lookups, protected by the protocol
+// database lock.
+//
+
+EFI_DEVICE_PATH_CACHE_ENTRY EfiDevicePathCache[EFI_DEVICE_PATH_CACHE_SIZE];
+UINTN EfiDevicePathCacheNext;
+
 //
 // ------------------------------------------------------------------ Functions
 //
@@ -150,15 +216,17 @@ Return Value:
 
     EFI_HANDLE BestDevice;
     INTN BestMatch;
-    EFI_HANDLE Handle;
-    UINTN HandleCount;
-    EFI_HANDLE *Handles;
-    UINTN Index;
+    PEFI_DEVICE_PATH_CACHE_ENTRY CacheEntry;
+    PLIST_ENTRY CurrentEntry;
+    PEFI_PROTOCOL_ENTRY DevicePathEntry;
+    PEFI_PROTOCOL_INTERFACE DevicePathInterface;
+    PLIST_ENTRY HandleEntry;
+    PEFI_PROTOCOL_ENTRY ProtocolEntry;
+    PEFI_PROTOCOL_INTERFACE ProtocolInterface;
     EFI_DEVICE_PATH_PROTOCOL *SearchPath;
     INTN Size;
     EFI_DEVICE_PATH_PROTOCOL *SourcePath;
     INTN SourceSize;
-    EFI_STATUS Status;
 
     if ((Protocol == NULL) || (DevicePath == NULL) || (*DevicePath == NULL)) {
         return EFI_INVALID_PARAMETER;
@@ -184,27 +252,63 @@ Return Value:
     SourceSize = (UINTN)SearchPath - (UINTN)SourcePath;
 
     //
-    // Get a list of all handles that support the given protocol.
+    // Walk the handles that support the given protocol directly out of the
+    // protocol database rather than building a handle buffer, and check the
+    // cache of recent answers first.
     //
 
-    Status = EfiCoreLocateHandleBuffer(ByProtocol,
-                                       Protocol,
-                                       NULL,
-                                       &HandleCount,
-                                       &Handles);
+    BestMatch = -1;
+    EfiCoreAcquireLock(&EfiProtocolDatabaseLock);
+    ProtocolEntry = EfipCoreFindProtocolEntry(Protocol, FALSE);
+    DevicePathEntry = EfipCoreFindProtocolEntry(&EfiDevicePathProtocolGuid,
+                                                FALSE);
 
-    if ((EFI_ERROR(Status)) || (HandleCount == 0)) {
-        return EFI_NOT_FOUND;
+    if ((ProtocolEntry == NULL) || (DevicePathEntry == NULL)) {
+        goto CoreLocateDevicePathEnd;
     }
 
-    BestMatch = -1;
-    for (Index = 0; Index < HandleCount; Index += 1) {
-        Handle = Handles[Index];
-        Status = EfiCoreHandleProtocol(Handle,
-                                       &EfiDevicePathProtocolGuid,
-                                       (VOID **)&SearchPath);
+    CacheEntry = EfipCoreLookupDevicePathCache(ProtocolEntry,
+                                               SourcePath,
+                                               SourceSize);
+
+    if (CacheEntry != NULL) {
+        BestMatch = CacheEntry->MatchSize;
+        BestDevice = CacheEntry->Device;
+        goto CoreLocateDevicePathEnd;
+    }
+
+    CurrentEntry = ProtocolEntry->ProtocolList.Next;
+    while (CurrentEntry != &(ProtocolEntry->ProtocolList)) {
+        ProtocolInterface = LIST_VALUE(CurrentEntry,
+                                       EFI_PROTOCOL_INTERFACE,
+                                       ProtocolListEntry);
+
+        CurrentEntry = CurrentEntry->Next;
+
+        ASSERT(ProtocolInterface->Magic == EFI_PROTOCOL_INTERFACE_MAGIC);
+
+        //
+        // Find the device path installed on the handle.
+        //
+
+        DevicePathInterface = NULL;
+        HandleEntry = ProtocolInterface->Handle->ProtocolList.Next;
+        while (HandleEntry != &(ProtocolInterface->Handle->ProtocolList)) {
+            DevicePathInterface = LIST_VALUE(HandleEntry,
+                                             EFI_PROTOCOL_INTERFACE,
+                                             ListEntry);
+
+            if (DevicePathInterface->Protocol == DevicePathEntry) {
+                break;
+            }
+
+            DevicePathInterface = NULL;
+            HandleEntry = HandleEntry->Next;
+        }
+
+        if ((DevicePathInterface == NULL) ||
+            (DevicePathInterface->Interface == NULL)) {
 
-        if (EFI_ERROR(Status)) {
             continue;
         }
 
@@ -212,6 +316,7 @@ Return Value:
         // Check if the device path is the first part of the source path.
         //
 
+        SearchPath = DevicePathInterface->Interface;
         Size = EfiCoreGetDevicePathSize(SearchPath) -
                sizeof(EFI_DEVICE_PATH_PROTOCOL);
 
@@ -229,12 +334,21 @@ Return Value:
 
             if (Size > BestMatch) {
                 BestMatch = Size;
-                BestDevice = Handle;
+                BestDevice = ProtocolInterface->Handle;
             }
         }
     }
 
-    EfiCoreFreePool(Handles);
+    if (BestMatch != -1) {
+        EfipCoreInsertDevicePathCache(ProtocolEntry,
+                                      SourcePath,
+                                      SourceSize,
+                                      BestDevice,
+                                      BestMatch);
+    }
+
+CoreLocateDevicePathEnd:
+    EfiCoreReleaseLock(&EfiProtocolDatabaseLock);
 
     //
     // If there wasn't any match, then no parts of the device path where found.
@@ -808,3 +922,115 @@ Return Value:
     return Handle;
 }
 
+PEFI_DEVICE_PATH_CACHE_ENTRY
+EfipCoreLookupDevicePathCache (
+    PEFI_PROTOCOL_ENTRY ProtocolEntry,
+    EFI_DEVICE_PATH_PROTOCOL *SourcePath,
+    UINTN SourceSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine looks for a still valid answer to a device path lookup. This
+    routine assumes the protocol database lock is held.
+
+Arguments:
+
+    ProtocolEntry - Supplies the protocol being searched for.
+
+    SourcePath - Supplies the device path being searched for.
+
+    SourceSize - Supplies the size of the first instance of the source path,
+        not including the end node.
+
+Return Value:
+
+    Returns a pointer to the matching cache entry on success.
+
+    NULL if there is no valid answer cached.
+
+--*/
+
+{
+
+    PEFI_DEVICE_PATH_CACHE_ENTRY Entry;
+    UINTN Index;
+
+    ASSERT(EfiCoreIsLockHeld(&EfiProtocolDatabaseLock) != FALSE);
+
+    for (Index = 0; Index < EFI_DEVICE_PATH_CACHE_SIZE; Index += 1) {
+        Entry = &(EfiDevicePathCache[Index]);
+        if ((Entry->Generation == EfiProtocolDatabaseGeneration) &&
+            (Entry->ProtocolEntry == ProtocolEntry) &&
+            (Entry->PathSize == SourceSize) &&
+            (EfiCoreCompareMemory(Entry->Path, SourcePath, SourceSize) == 0)) {
+
+            return Entry;
+        }
+    }
+
+    return NULL;
+}
+
+VOID
+EfipCoreInsertDevicePathCache (
+    PEFI_PROTOCOL_ENTRY ProtocolEntry,
+    EFI_DEVICE_PATH_PROTOCOL *SourcePath,
+    UINTN SourceSize,
+    EFI_HANDLE Device,
+    INTN MatchSize
+    )
+
+/*++
+
+Routine Description:
+
+    This routine remembers the answer to a device path lookup, replacing the
+    oldest entry. This routine assumes the protocol database lock is held.
+
+Arguments:
+
+    ProtocolEntry - Supplies the protocol that was searched for.
+
+    SourcePath - Supplies the device path that was searched for.
+
+    SourceSize - Supplies the size of the first instance of the source path,
+        not including the end node.
+
+    Device - Supplies the handle that best matched.
+
+    MatchSize - Supplies the size of the part of the source path that matched.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    PEFI_DEVICE_PATH_CACHE_ENTRY Entry;
+
+    ASSERT(EfiCoreIsLockHeld(&EfiProtocolDatabaseLock) != FALSE);
+
+    if (SourceSize > EFI_DEVICE_PATH_CACHE_MAX_PATH) {
+        return;
+    }
+
+    Entry = &(EfiDevicePathCache[EfiDevicePathCacheNext]);
+    EfiDevicePathCacheNext += 1;
+    if (EfiDevicePathCacheNext == EFI_DEVICE_PATH_CACHE_SIZE) {
+        EfiDevicePathCacheNext = 0;
+    }
+
+    Entry->Generation = EfiProtocolDatabaseGeneration;
+    Entry->ProtocolEntry = ProtocolEntry;
+    Entry->PathSize = SourceSize;
+    Entry->Device = Device;
+    Entry->MatchSize = MatchSize;
+    EfiCoreCopyMemory(Entry->Path, SourcePath, SourceSize);
+    return;
+}
+
@@ -63,6 +63,14 @@ Module Name:
 // ------------------------------------------------------ Data Type Definitions
 //
 
+typedef enum _EFI_BOOT_PHASE {
+    EfiBootPhaseResetEnd,
+    EfiBootPhaseOsLoaderLoadImage,
+    EfiBootPhaseOsLoaderStartImage,
+    EfiBootPhaseExitBootServicesEntry,
+    EfiBootPhaseExitBootServicesExit
+} EFI_BOOT_PHASE, *PEFI_BOOT_PHASE;
+
 #if defined(EFI_X86)
 
 typedef struct _EFI_JUMP_BUFFER {
@@ -1397,3 +1405,96 @@ Return Value:
     EFI status code.
 
 --*/
+
+VOID
+EfiCoreInitializeBootPerformance (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine allocates the firmware boot performance table and records
+    the time the firmware began executing. If the table cannot be allocated,
+    boot performance records are silently dropped.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+EfiCoreRecordBootPhase (
+    EFI_BOOT_PHASE Phase
+    );
+
+/*++
+
+Routine Description:
+
+    This routine records the current time against one of the fixed boot
+    phases in the basic boot performance record.
+
+Arguments:
+
+    Phase - Supplies the phase that was just reached.
+
+Return Value:
+
+    None.
+
+--*/
+
+VOID
+EfiCoreRecordBootEvent (
+    UINT16 ProgressId,
+    CONST EFI_GUID *Guid
+    );
+
+/*++
+
+Routine Description:
+
+    This routine appends a GUID event record stamped with the current time to
+    the boot performance table.
+
+Arguments:
+
+    ProgressId - Supplies the kind of event. See FPDT_PROGRESS_* definitions.
+
+    Guid - Supplies an optional pointer to the GUID of the module or phase
+        the event belongs to. Supply NULL to record a zero GUID.
+
+Return Value:
+
+    None.
+
+--*/
+
+EFI_STATUS
+EfiCorePublishBootPerformanceTable (
+    VOID
+    );
+
+/*++
+
+Routine Description:
+
+    This routine installs a Firmware Performance Data Table pointing at the
+    boot performance table, so the operating system can find it.
+
+Arguments:
+
+    None.
+
+Return Value:
+
+    EFI status code.
+
+--*/